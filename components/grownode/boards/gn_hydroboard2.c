@@ -28,6 +28,7 @@
 #include "gn_bme280.h"
 #include "synapses/gn_hydroboard2_watering_control.h"
 #include "gn_leaf_status_led.h"
+#include "gn_leaf_scheduler.h"
 
 #include "gn_hydroboard2.h"
 
@@ -158,5 +159,9 @@ void gn_configure_hydroboard2(gn_node_handle_t node) {
 			gn_leaf_status_led_config, 4096, GN_LEAF_TASK_PRIORITY);
 	gn_leaf_param_init_double(led, GN_LEAF_STATUS_LED_PARAM_GPIO, 32);
 
+	//time-of-day actions, eg. "0 7 * * * lig_1.status=true; 0 21 * * * lig_1.status=false"
+	gn_leaf_create(node, "sched", gn_leaf_scheduler_config, 4096,
+			GN_LEAF_TASK_PRIORITY);
+
 }
 
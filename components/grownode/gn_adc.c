@@ -0,0 +1,346 @@
+// Copyright 2021 Nicola Muratori (nicola.muratori@gmail.com)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+
+#include "driver/adc.h"
+
+#include "gn_adc.h"
+
+#ifdef CONFIG_GROWNODE_ADC_SAMPLING
+
+#define TAG "gn_adc"
+
+#define GN_ADC_WINDOW CONFIG_GROWNODE_ADC_WINDOW
+#define GN_ADC_FRAME_CONVERSIONS 128
+#define GN_ADC_FRAME_SIZE (GN_ADC_FRAME_CONVERSIONS * sizeof(adc_digi_output_data_t))
+#define GN_ADC_POOL_SIZE (GN_ADC_FRAME_SIZE * 4) /*!< DMA buffers, filled while the task is not reading */
+#define GN_ADC_READ_TIMEOUT_MS 100
+#define GN_ADC_RETRY_MS 1000
+#define GN_ADC_TASK_STACK 3072
+#define GN_ADC_TASK_PRIORITY 5
+
+#if CONFIG_IDF_TARGET_ESP32
+#define GN_ADC_OUTPUT_FORMAT ADC_DIGI_OUTPUT_FORMAT_TYPE1
+#define _GN_ADC_CHANNEL(p) ((p)->type1.channel)
+#define _GN_ADC_DATA(p) ((p)->type1.data)
+#else
+#define GN_ADC_OUTPUT_FORMAT ADC_DIGI_OUTPUT_FORMAT_TYPE2
+#define _GN_ADC_CHANNEL(p) ((p)->type2.channel)
+#define _GN_ADC_DATA(p) ((p)->type2.data)
+#endif
+//the controller pattern takes the number of bits, ADC_WIDTH_BIT_9 is 0
+#define _GN_ADC_BITS(width) (9 + (width))
+
+typedef struct {
+	bool used;
+	gn_adc_channel_config_t config;
+	uint16_t window[GN_ADC_WINDOW]; /*!< last frame averages, oldest overwritten first */
+	size_t head;
+	size_t count;
+	uint16_t last;
+	double ema;
+} gn_adc_channel_t;
+
+static gn_adc_channel_t _gn_adc_channels[ADC1_CHANNEL_MAX];
+static gn_adc_stats_t _gn_adc_stats;
+static uint32_t _gn_adc_requested_mask = 0; /*!< channels added by the leaves */
+static bool _gn_adc_reconfigure = false; /*!< attenuation or width of a sampled channel changed */
+static bool _gn_adc_started = false;
+static portMUX_TYPE _gn_adc_mux = portMUX_INITIALIZER_UNLOCKED;
+
+//owned by the sampling task
+static uint32_t _gn_adc_mask = 0; /*!< channels configured in the controller */
+static uint8_t _gn_adc_frame[GN_ADC_FRAME_SIZE];
+
+/**
+ * @brief	(re)starts continuous conversions on the channels of the mask
+ */
+static esp_err_t _gn_adc_configure(uint32_t mask) {
+
+	esp_err_t ret;
+
+	if (_gn_adc_mask) {
+		adc_digi_stop();
+		adc_digi_deinitialize();
+		_gn_adc_mask = 0;
+	}
+
+	adc_digi_init_config_t init = { .max_store_buf_size = GN_ADC_POOL_SIZE,
+			.conv_num_each_intr = GN_ADC_FRAME_SIZE, .adc1_chan_mask = mask,
+			.adc2_chan_mask = 0 };
+	ret = adc_digi_initialize(&init);
+	if (ret != ESP_OK)
+		return ret;
+
+	adc_digi_pattern_config_t pattern[ADC1_CHANNEL_MAX] = { 0 };
+	uint32_t pattern_num = 0;
+	portENTER_CRITICAL(&_gn_adc_mux);
+	for (int ch = 0; ch < ADC1_CHANNEL_MAX; ch++) {
+		if (!(mask & BIT(ch)))
+			continue;
+		pattern[pattern_num].atten = _gn_adc_channels[ch].config.atten;
+		pattern[pattern_num].channel = ch;
+		pattern[pattern_num].unit = 0; //ADC1
+		pattern[pattern_num].bit_width = _GN_ADC_BITS(
+				_gn_adc_channels[ch].config.width);
+		pattern_num++;
+	}
+	portEXIT_CRITICAL(&_gn_adc_mux);
+
+	adc_digi_configuration_t config = { .conv_limit_en = true,
+			.conv_limit_num = 250, .pattern_num = pattern_num, .adc_pattern =
+					pattern, .sample_freq_hz =
+			CONFIG_GROWNODE_ADC_SAMPLE_FREQ_HZ, .conv_mode =
+					ADC_CONV_SINGLE_UNIT_1, .format = GN_ADC_OUTPUT_FORMAT };
+	ret = adc_digi_controller_configure(&config);
+	if (ret == ESP_OK)
+		ret = adc_digi_start();
+	if (ret != ESP_OK) {
+		adc_digi_deinitialize();
+		return ret;
+	}
+
+	_gn_adc_mask = mask;
+	ESP_LOGD(TAG, "sampling %d channels at %d Hz", (int) pattern_num,
+			CONFIG_GROWNODE_ADC_SAMPLE_FREQ_HZ);
+	return ESP_OK;
+
+}
+
+/**
+ * @brief	averages a DMA frame per channel and pushes the averages to the channel windows
+ */
+static void _gn_adc_process(const uint8_t *frame, uint32_t len) {
+
+	uint32_t sum[ADC1_CHANNEL_MAX] = { 0 };
+	uint32_t n[ADC1_CHANNEL_MAX] = { 0 };
+	uint32_t conversions = len / sizeof(adc_digi_output_data_t);
+	uint32_t invalid = 0;
+
+	for (uint32_t i = 0; i < conversions; i++) {
+		const adc_digi_output_data_t *p =
+				&((const adc_digi_output_data_t*) frame)[i];
+		uint32_t ch = _GN_ADC_CHANNEL(p);
+		if (ch >= ADC1_CHANNEL_MAX || !(_gn_adc_mask & BIT(ch))) {
+			invalid++;
+			continue;
+		}
+		sum[ch] += _GN_ADC_DATA(p);
+		n[ch]++;
+	}
+
+	portENTER_CRITICAL(&_gn_adc_mux);
+	for (int ch = 0; ch < ADC1_CHANNEL_MAX; ch++) {
+		if (n[ch] == 0)
+			continue;
+		gn_adc_channel_t *c = &_gn_adc_channels[ch];
+		uint16_t avg = (sum[ch] + n[ch] / 2) / n[ch];
+		c->last = avg;
+		c->window[c->head] = avg;
+		c->head = (c->head + 1) % GN_ADC_WINDOW;
+		if (c->count == 0)
+			c->ema = avg;
+		else
+			c->ema += c->config.ema_alpha * (avg - c->ema);
+		if (c->count < GN_ADC_WINDOW)
+			c->count++;
+	}
+	_gn_adc_stats.frames++;
+	_gn_adc_stats.conversions += conversions;
+	_gn_adc_stats.invalid += invalid;
+	portEXIT_CRITICAL(&_gn_adc_mux);
+
+}
+
+static void _gn_adc_task(void *arg) {
+
+	while (true) {
+
+		portENTER_CRITICAL(&_gn_adc_mux);
+		uint32_t mask = _gn_adc_requested_mask;
+		bool reconfigure = _gn_adc_reconfigure;
+		_gn_adc_reconfigure = false;
+		portEXIT_CRITICAL(&_gn_adc_mux);
+
+		//a leaf added a channel or changed its conversion
+		if (mask != _gn_adc_mask || reconfigure) {
+			esp_err_t ret = _gn_adc_configure(mask);
+			if (ret != ESP_OK) {
+				ESP_LOGE(TAG, "cannot start sampling: %s",
+						esp_err_to_name(ret));
+				vTaskDelay(pdMS_TO_TICKS(GN_ADC_RETRY_MS));
+				continue;
+			}
+		}
+
+		uint32_t len = 0;
+		esp_err_t ret = adc_digi_read_bytes(_gn_adc_frame, GN_ADC_FRAME_SIZE,
+				&len, GN_ADC_READ_TIMEOUT_MS);
+
+		//data is still valid, older conversions were lost
+		if (ret == ESP_ERR_INVALID_STATE) {
+			portENTER_CRITICAL(&_gn_adc_mux);
+			_gn_adc_stats.overruns++;
+			portEXIT_CRITICAL(&_gn_adc_mux);
+		} else if (ret != ESP_OK) {
+			continue;
+		}
+
+		_gn_adc_process(_gn_adc_frame, len);
+
+	}
+
+}
+
+/**
+ * @brief	adds an ADC1 channel to the sampling, or changes the configuration of a channel already sampled.
+ * sampling starts in background at the first channel
+ *
+ * @param	channel	ADC1 channel
+ * @param	config	attenuation and width of the conversions, filter applied by gn_adc_read
+ *
+ * @return	GN_RET_OK if the channel is sampled
+ * @return	GN_RET_ERR_INVALID_ARG on a wrong channel, attenuation, width or filter
+ * @return	GN_RET_ERR if the sampling task cannot be started
+ */
+gn_err_t gn_adc_channel_add(int channel, const gn_adc_channel_config_t *config) {
+
+	if (channel < 0 || channel >= ADC1_CHANNEL_MAX || !config) {
+		ESP_LOGE(TAG, "gn_adc_channel_add - invalid channel %d", channel);
+		return GN_RET_ERR_INVALID_ARG;
+	}
+
+	if (config->filter == GN_ADC_FILTER_EMA
+			&& !(config->ema_alpha > 0 && config->ema_alpha <= 1)) {
+		ESP_LOGE(TAG, "gn_adc_channel_add - EMA alpha must be in (0, 1]");
+		return GN_RET_ERR_INVALID_ARG;
+	}
+
+	if ((unsigned) config->atten >= ADC_ATTEN_MAX
+			|| (unsigned) config->width >= ADC_WIDTH_MAX) {
+		ESP_LOGE(TAG, "gn_adc_channel_add - invalid attenuation or width");
+		return GN_RET_ERR_INVALID_ARG;
+	}
+
+	portENTER_CRITICAL(&_gn_adc_mux);
+	gn_adc_channel_t *c = &_gn_adc_channels[channel];
+	if (c->used
+			&& (c->config.atten != config->atten
+					|| c->config.width != config->width))
+		_gn_adc_reconfigure = true;
+	c->config = *config;
+	if (!c->used) {
+		c->used = true;
+		c->head = 0;
+		c->count = 0;
+	}
+	_gn_adc_requested_mask |= BIT(channel);
+	bool start = !_gn_adc_started;
+	_gn_adc_started = true;
+	portEXIT_CRITICAL(&_gn_adc_mux);
+
+	if (start
+			&& xTaskCreate(_gn_adc_task, "gn_adc_task", GN_ADC_TASK_STACK,
+					NULL, GN_ADC_TASK_PRIORITY, NULL) != pdPASS) {
+		ESP_LOGE(TAG, "gn_adc_channel_add - cannot create sampling task");
+		portENTER_CRITICAL(&_gn_adc_mux);
+		_gn_adc_started = false;
+		portEXIT_CRITICAL(&_gn_adc_mux);
+		return GN_RET_ERR;
+	}
+
+	return GN_RET_OK;
+
+}
+
+/**
+ * @brief	filtered value of a channel, does not wait for conversions
+ *
+ * @param	raw	the value in raw counts, up to GN_ADC_RAW_MAX at 12 bits width
+ *
+ * @return	GN_RET_OK if a value is available
+ * @return	GN_RET_ERR if the channel is not sampled or no frame has been processed yet
+ */
+gn_err_t gn_adc_read(int channel, double *raw) {
+
+	if (channel < 0 || channel >= ADC1_CHANNEL_MAX || !raw)
+		return GN_RET_ERR_INVALID_ARG;
+
+	uint16_t window[GN_ADC_WINDOW];
+	size_t count;
+	gn_adc_filter_t filter;
+
+	portENTER_CRITICAL(&_gn_adc_mux);
+	gn_adc_channel_t *c = &_gn_adc_channels[channel];
+	count = c->used ? c->count : 0;
+	filter = c->config.filter;
+	if (count > 0) {
+		if (filter == GN_ADC_FILTER_MEDIAN)
+			memcpy(window, c->window, count * sizeof(uint16_t));
+		else if (filter == GN_ADC_FILTER_EMA)
+			*raw = c->ema;
+		else
+			*raw = c->last;
+	}
+	portEXIT_CRITICAL(&_gn_adc_mux);
+
+	if (count == 0)
+		return GN_RET_ERR;
+
+	if (filter == GN_ADC_FILTER_MEDIAN) {
+		//insertion sort, the window is small
+		for (size_t i = 1; i < count; i++) {
+			uint16_t v = window[i];
+			size_t j = i;
+			while (j > 0 && window[j - 1] > v) {
+				window[j] = window[j - 1];
+				j--;
+			}
+			window[j] = v;
+		}
+		*raw = count % 2 ?
+				window[count / 2] :
+				(window[count / 2 - 1] + window[count / 2]) / 2.0;
+	}
+
+	return GN_RET_OK;
+
+}
+
+gn_err_t gn_adc_get_stats(gn_adc_stats_t *stats) {
+
+	if (!stats)
+		return GN_RET_ERR_INVALID_ARG;
+
+	portENTER_CRITICAL(&_gn_adc_mux);
+	*stats = _gn_adc_stats;
+	portEXIT_CRITICAL(&_gn_adc_mux);
+	return GN_RET_OK;
+
+}
+
+#endif /* CONFIG_GROWNODE_ADC_SAMPLING */
+
+#ifdef __cplusplus
+}
+#endif //__cplusplus
@@ -0,0 +1,72 @@
+// Copyright 2021 Nicola Muratori (nicola.muratori@gmail.com)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GN_ADC_H_
+#define GN_ADC_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+#include "sdkconfig.h"
+#include "driver/adc.h"
+#include "gn_commons.h"
+
+/*
+ * ADC1 sampling service: the channels added by the leaves are converted continuously by the
+ * digital controller into DMA buffers, a background task averages every DMA frame per channel
+ * and keeps the last CONFIG_GROWNODE_ADC_WINDOW averages in a ring buffer per channel.
+ * leaves get the filtered raw value whenever they need it, without blocking on conversions.
+ * compiled only with CONFIG_GROWNODE_ADC_SAMPLING
+ */
+
+#ifdef CONFIG_GROWNODE_ADC_SAMPLING
+
+#define GN_ADC_RAW_MAX 4095
+
+typedef enum {
+	GN_ADC_FILTER_NONE = 0, /*!< average of the last DMA frame */
+	GN_ADC_FILTER_MEDIAN, /*!< median of the frame averages in the window, rejects spikes */
+	GN_ADC_FILTER_EMA /*!< exponential moving average of the frame averages */
+} gn_adc_filter_t;
+
+typedef struct {
+	gn_adc_filter_t filter;
+	float ema_alpha; /*!< weight of a new frame average, (0, 1]. GN_ADC_FILTER_EMA only */
+	adc_atten_t atten; /*!< input attenuation, sets the measurable voltage range */
+	adc_bits_width_t width; /*!< conversion width, raw values go up to 2^bits - 1 */
+} gn_adc_channel_config_t;
+
+typedef struct {
+	uint32_t frames; /*!< DMA frames processed */
+	uint64_t conversions; /*!< conversions read from the DMA buffers */
+	uint32_t overruns; /*!< times the DMA pool filled up before being read */
+	uint32_t invalid; /*!< conversions discarded, not from a configured channel */
+} gn_adc_stats_t;
+
+gn_err_t gn_adc_channel_add(int channel, const gn_adc_channel_config_t *config);
+
+gn_err_t gn_adc_read(int channel, double *raw);
+
+gn_err_t gn_adc_get_stats(gn_adc_stats_t *stats);
+
+#endif /* CONFIG_GROWNODE_ADC_SAMPLING */
+
+#ifdef __cplusplus
+}
+#endif //__cplusplus
+
+#endif /* GN_ADC_H_ */
@@ -0,0 +1,190 @@
+// Copyright 2021 Nicola Muratori (nicola.muratori@gmail.com)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include <string.h>
+
+#include "esp_timer.h"
+#include "driver/gpio.h"
+
+#include "gn_boot.h"
+
+#ifdef CONFIG_GROWNODE_BOOT_PROFILE
+
+static const char *_gn_boot_phase_names[GN_BOOT_PHASE_MAX] = { "init", "flash",
+		"spiffs", "event_loop", "display", "wifi", "time_sync", "leaf_create",
+		"param_load", "node_start", "mqtt_start", "leaf_start" };
+
+//phases are marked by the task running gn_init and gn_node_start, the table is frozen once the node is started
+static gn_boot_phase_stats_t _gn_boot_phases[GN_BOOT_PHASE_MAX];
+static int64_t _gn_boot_open_us[GN_BOOT_PHASE_MAX];
+static uint8_t _gn_boot_depth[GN_BOOT_PHASE_MAX];
+//phases currently open, innermost last
+static gn_boot_phase_t _gn_boot_open[GN_BOOT_PHASE_MAX];
+static int _gn_boot_open_count = 0;
+static int64_t _gn_boot_complete_us = 0;
+
+#if CONFIG_GROWNODE_BOOT_PROFILE_GPIO >= 0
+static bool _gn_boot_gpio_init = false;
+static uint32_t _gn_boot_gpio_level = 0;
+
+//flips the pin at every marker, so an oscilloscope sees one edge per phase begin and end
+static void _gn_boot_gpio_toggle() {
+
+	if (!_gn_boot_gpio_init) {
+		gpio_reset_pin(CONFIG_GROWNODE_BOOT_PROFILE_GPIO);
+		gpio_set_direction(CONFIG_GROWNODE_BOOT_PROFILE_GPIO, GPIO_MODE_OUTPUT);
+		_gn_boot_gpio_init = true;
+	}
+	_gn_boot_gpio_level ^= 1;
+	gpio_set_level(CONFIG_GROWNODE_BOOT_PROFILE_GPIO, _gn_boot_gpio_level);
+
+}
+#else
+#define _gn_boot_gpio_toggle() do { } while (0)
+#endif
+
+/**
+ * @brief	marks the begin of a phase. nested begins of the same phase are counted once
+ */
+void gn_boot_phase_begin(gn_boot_phase_t phase) {
+
+	if (phase >= GN_BOOT_PHASE_MAX || _gn_boot_complete_us != 0)
+		return;
+
+	if (_gn_boot_depth[phase]++ > 0)
+		return;
+
+	int64_t now = esp_timer_get_time();
+	_gn_boot_open_us[phase] = now;
+	if (_gn_boot_phases[phase].count == 0) {
+		_gn_boot_phases[phase].start_us = now;
+		_gn_boot_phases[phase].parent =
+				_gn_boot_open_count > 0 ?
+						_gn_boot_open[_gn_boot_open_count - 1] :
+						GN_BOOT_PHASE_MAX;
+	}
+	_gn_boot_open[_gn_boot_open_count++] = phase;
+	_gn_boot_gpio_toggle();
+
+}
+
+/**
+ * @brief	marks the end of a phase and adds the time spent to its total
+ */
+void gn_boot_phase_end(gn_boot_phase_t phase) {
+
+	if (phase >= GN_BOOT_PHASE_MAX || _gn_boot_complete_us != 0
+			|| _gn_boot_depth[phase] == 0)
+		return;
+
+	if (--_gn_boot_depth[phase] > 0)
+		return;
+
+	int64_t now = esp_timer_get_time();
+	gn_boot_phase_stats_t *p = &_gn_boot_phases[phase];
+	p->end_us = now;
+	p->total_us += now - _gn_boot_open_us[phase];
+	p->count++;
+	//phases are normally closed innermost first, but any open one can end
+	for (int i = _gn_boot_open_count - 1; i >= 0; i--) {
+		if (_gn_boot_open[i] == phase) {
+			memmove(&_gn_boot_open[i], &_gn_boot_open[i + 1],
+					(_gn_boot_open_count - i - 1) * sizeof(gn_boot_phase_t));
+			_gn_boot_open_count--;
+			break;
+		}
+	}
+	_gn_boot_gpio_toggle();
+
+}
+
+/**
+ * @brief	closes the boot profile. markers after this call are ignored
+ */
+void gn_boot_complete() {
+
+	if (_gn_boot_complete_us != 0)
+		return;
+
+	_gn_boot_complete_us = esp_timer_get_time();
+#if CONFIG_GROWNODE_BOOT_PROFILE_GPIO >= 0
+	if (_gn_boot_gpio_init)
+		gpio_set_level(CONFIG_GROWNODE_BOOT_PROFILE_GPIO, 0);
+#endif
+
+}
+
+bool gn_boot_is_complete() {
+	return _gn_boot_complete_us != 0;
+}
+
+const char* gn_boot_phase_name(gn_boot_phase_t phase) {
+	return phase < GN_BOOT_PHASE_MAX ? _gn_boot_phase_names[phase] : NULL;
+}
+
+/**
+ * @return	the timings of the phase, count is 0 if the phase was never completed
+ */
+const gn_boot_phase_stats_t* gn_boot_phase_stats(gn_boot_phase_t phase) {
+	return phase < GN_BOOT_PHASE_MAX ? &_gn_boot_phases[phase] : NULL;
+}
+
+/**
+ * @brief	builds the boot report: the completion time and, for each phase reached,
+ * 			an array of name, first begin, last end, total time and count, all in microseconds,
+ * 			and the name of the phase it is nested in, empty if none
+ *
+ * @return	the json object, to be deleted by the caller
+ */
+cJSON* gn_boot_report_to_json() {
+
+	cJSON *root = cJSON_CreateObject();
+	if (!root)
+		return NULL;
+
+	cJSON_AddNumberToObject(root, "us",
+			_gn_boot_complete_us ? _gn_boot_complete_us : esp_timer_get_time());
+
+	cJSON *phases = cJSON_CreateArray();
+	if (!phases || !cJSON_AddItemToObject(root, "phases", phases)) {
+		cJSON_Delete(phases);
+		cJSON_Delete(root);
+		return NULL;
+	}
+
+	for (int i = 0; i < GN_BOOT_PHASE_MAX; i++) {
+		const gn_boot_phase_stats_t *p = &_gn_boot_phases[i];
+		if (p->count == 0)
+			continue;
+		cJSON *phase = cJSON_CreateArray();
+		if (!phase)
+			break;
+		cJSON_AddItemToArray(phase, cJSON_CreateString(_gn_boot_phase_names[i]));
+		cJSON_AddItemToArray(phase, cJSON_CreateNumber(p->start_us));
+		cJSON_AddItemToArray(phase, cJSON_CreateNumber(p->end_us));
+		cJSON_AddItemToArray(phase, cJSON_CreateNumber(p->total_us));
+		cJSON_AddItemToArray(phase, cJSON_CreateNumber(p->count));
+		cJSON_AddItemToArray(phase,
+				cJSON_CreateString(
+						p->parent < GN_BOOT_PHASE_MAX ?
+								_gn_boot_phase_names[p->parent] : ""));
+		cJSON_AddItemToArray(phases, phase);
+	}
+
+	return root;
+
+}
+
+#endif /* CONFIG_GROWNODE_BOOT_PROFILE */
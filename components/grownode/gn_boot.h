@@ -0,0 +1,83 @@
+// Copyright 2021 Nicola Muratori (nicola.muratori@gmail.com)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef GN_BOOT_H_
+#define GN_BOOT_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "sdkconfig.h"
+
+/*
+ * boot profiler: gn_init and gn_node_start mark the begin and the end of each phase with microsecond
+ * timestamps in a static table, published once as a boot report when the node is started.
+ * everything is compiled only with CONFIG_GROWNODE_BOOT_PROFILE, otherwise the markers are empty
+ */
+
+typedef enum {
+	GN_BOOT_PHASE_INIT = 0, /*!< gn_init, from the call to the node configuration ready */
+	GN_BOOT_PHASE_FLASH, /*!< NVS flash init */
+	GN_BOOT_PHASE_SPIFFS, /*!< SPIFFS mount */
+	GN_BOOT_PHASE_EVENT_LOOP, /*!< grownode event loop creation and handlers */
+	GN_BOOT_PHASE_DISPLAY, /*!< display driver and GUI task */
+	GN_BOOT_PHASE_WIFI, /*!< wifi start, provisioning and connection */
+	GN_BOOT_PHASE_TIME_SYNC, /*!< SNTP synchronization */
+	GN_BOOT_PHASE_LEAF_CREATE, /*!< gn_leaf_create, leaf configuration callbacks included */
+	GN_BOOT_PHASE_PARAM_LOAD, /*!< parameter values read from NVS */
+	GN_BOOT_PHASE_NODE_START, /*!< gn_node_start, until the leaves are running */
+	GN_BOOT_PHASE_MQTT_START, /*!< MQTT connection and subscriptions */
+	GN_BOOT_PHASE_LEAF_START, /*!< leaf tasks creation */
+	GN_BOOT_PHASE_MAX
+} gn_boot_phase_t;
+
+#ifdef CONFIG_GROWNODE_BOOT_PROFILE
+
+#include "cJSON.h"
+
+/**
+ * @brief	time spent in a phase. a phase entered more than once spans from the first begin to the last end
+ */
+typedef struct {
+	int64_t start_us; /*!< first begin, microseconds since boot */
+	int64_t end_us; /*!< last end, microseconds since boot */
+	int64_t total_us; /*!< sum of the time spent in the phase */
+	uint32_t count; /*!< times the phase was completed */
+	gn_boot_phase_t parent; /*!< phase open at the first begin, GN_BOOT_PHASE_MAX if none */
+} gn_boot_phase_stats_t;
+
+void gn_boot_phase_begin(gn_boot_phase_t phase);
+
+void gn_boot_phase_end(gn_boot_phase_t phase);
+
+void gn_boot_complete();
+
+bool gn_boot_is_complete();
+
+const char* gn_boot_phase_name(gn_boot_phase_t phase);
+
+const gn_boot_phase_stats_t* gn_boot_phase_stats(gn_boot_phase_t phase);
+
+cJSON* gn_boot_report_to_json();
+
+#else
+
+#define gn_boot_phase_begin(phase) do { } while (0)
+#define gn_boot_phase_end(phase) do { } while (0)
+#define gn_boot_complete() do { } while (0)
+
+#endif /* CONFIG_GROWNODE_BOOT_PROFILE */
+
+#endif /* GN_BOOT_H_ */
@@ -0,0 +1,550 @@
+// Copyright 2021 Nicola Muratori (nicola.muratori@gmail.com)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_log.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+#include "grownode.h"
+#include "gn_calibration.h"
+
+#define TAG "gn_calibration"
+
+//blob layout: header (magic, version, little endian length of what follows), table count,
+//then per table name length, name, point count, points
+#define GN_CALIBRATION_BLOB_MAGIC 0xCA
+#define GN_CALIBRATION_BLOB_VERSION 2
+#define GN_CALIBRATION_BLOB_HEADER_SIZE 4
+#define GN_CALIBRATION_BLOB_SIZE (GN_CALIBRATION_BLOB_HEADER_SIZE + 1 + GN_CALIBRATION_MAX_TABLES * (2 + GN_LEAF_PARAM_NAME_SIZE + GN_CALIBRATION_MAX_POINTS * sizeof(gn_calibration_point_t)))
+
+typedef struct {
+	char param_name[GN_LEAF_PARAM_NAME_SIZE];
+	char cal_name[GN_LEAF_PARAM_NAME_SIZE];
+	gn_leaf_param_handle_t cal_param; /*!< NULL for tables loaded but not added by the leaf */
+	size_t count;
+	gn_calibration_point_t points[GN_CALIBRATION_MAX_POINTS]; /*!< strictly increasing raw */
+	double last_raw; /*!< used by the capture */
+	bool has_raw;
+} gn_calibration_table_t;
+
+struct gn_calibration {
+	gn_leaf_handle_t leaf_config;
+	SemaphoreHandle_t lock; /*!< tables are applied by the sampler and changed by the leaf task */
+	size_t count;
+	gn_calibration_table_t tables[GN_CALIBRATION_MAX_TABLES];
+	char key[GN_LEAF_NAME_SIZE + sizeof(GN_CALIBRATION_STORAGE_SUFFIX)];
+};
+
+static gn_calibration_table_t* _gn_calibration_find(gn_calibration_handle_t cal,
+		const char *param_name) {
+
+	for (size_t i = 0; i < cal->count; i++) {
+		if (strcmp(cal->tables[i].param_name, param_name) == 0)
+			return &cal->tables[i];
+	}
+	return NULL;
+
+}
+
+/**
+ * @brief	sorts the points by raw reading, refusing non finite values and duplicated readings
+ */
+static bool _gn_calibration_sort(gn_calibration_point_t *points, size_t count) {
+
+	for (size_t i = 0; i < count; i++) {
+		if (!isfinite(points[i].raw) || !isfinite(points[i].value))
+			return false;
+		gn_calibration_point_t p = points[i];
+		size_t j = i;
+		for (; j > 0 && points[j - 1].raw > p.raw; j--)
+			points[j] = points[j - 1];
+		points[j] = p;
+	}
+
+	for (size_t i = 1; i < count; i++) {
+		if (points[i].raw == points[i - 1].raw)
+			return false;
+	}
+	return true;
+
+}
+
+static double _gn_calibration_interpolate(const gn_calibration_table_t *table,
+		double raw) {
+
+	const gn_calibration_point_t *p = table->points;
+
+	if (table->count == 1)
+		return raw + (p[0].value - p[0].raw);
+
+	//segment containing the reading, the first or the last one outside of the table
+	size_t lo = 0, hi = table->count - 1;
+	while (hi - lo > 1) {
+		size_t mid = (lo + hi) / 2;
+		if (raw < p[mid].raw)
+			hi = mid;
+		else
+			lo = mid;
+	}
+
+	return p[lo].value
+			+ (raw - p[lo].raw) * (p[hi].value - p[lo].value)
+					/ (p[hi].raw - p[lo].raw);
+
+}
+
+static void _gn_calibration_to_text(const gn_calibration_table_t *table,
+		char *text, size_t size) {
+
+	size_t len = 0;
+	text[0] = '\0';
+	for (size_t i = 0; i < table->count && len < size; i++) {
+		int n = snprintf(text + len, size - len, "%s%.6g:%.6g", i ? "," : "",
+				table->points[i].raw, table->points[i].value);
+		if (n < 0)
+			break;
+		len += n;
+	}
+
+}
+
+/**
+ * @brief	parses "raw:value,raw:value,..."
+ *
+ * @return	the number of points, -1 if the text is not a table
+ */
+static int _gn_calibration_parse(const char *text,
+		gn_calibration_point_t *points) {
+
+	int count = 0;
+	const char *s = text;
+	while (*s) {
+		if (count == GN_CALIBRATION_MAX_POINTS)
+			return -1;
+		char *end;
+		double raw = strtod(s, &end);
+		if (end == s || *end != ':')
+			return -1;
+		s = end + 1;
+		double value = strtod(s, &end);
+		if (end == s || (*end != ',' && *end != '\0'))
+			return -1;
+		points[count].raw = raw;
+		points[count].value = value;
+		count++;
+		s = *end ? end + 1 : end;
+	}
+	return count;
+
+}
+
+static size_t _gn_calibration_to_blob(gn_calibration_handle_t cal,
+		uint8_t *blob) {
+
+	size_t len = GN_CALIBRATION_BLOB_HEADER_SIZE;
+	blob[len++] = cal->count;
+	for (size_t i = 0; i < cal->count; i++) {
+		const gn_calibration_table_t *t = &cal->tables[i];
+		size_t name_len = strlen(t->param_name);
+		blob[len++] = name_len;
+		memcpy(blob + len, t->param_name, name_len);
+		len += name_len;
+		blob[len++] = t->count;
+		memcpy(blob + len, t->points, t->count * sizeof(gn_calibration_point_t));
+		len += t->count * sizeof(gn_calibration_point_t);
+	}
+
+	size_t payload = len - GN_CALIBRATION_BLOB_HEADER_SIZE;
+	blob[0] = GN_CALIBRATION_BLOB_MAGIC;
+	blob[1] = GN_CALIBRATION_BLOB_VERSION;
+	blob[2] = payload & 0xff;
+	blob[3] = payload >> 8;
+	return len;
+
+}
+
+/**
+ * @brief	loads the tables of a stored blob. the header is checked before anything else is read,
+ * and no field is read past the length it declares, which must have been stored
+ *
+ * @param	blob	as returned by gn_storage_get_blob
+ * @param	size	the bytes stored
+ */
+static void _gn_calibration_from_blob(gn_calibration_handle_t cal,
+		const uint8_t *blob, size_t size) {
+
+	if (size < GN_CALIBRATION_BLOB_HEADER_SIZE) {
+		ESP_LOGW(TAG, "[%s] unknown calibration blob, ignored", cal->key);
+		return;
+	}
+
+	size_t payload = blob[2] | (blob[3] << 8);
+	if (blob[0] != GN_CALIBRATION_BLOB_MAGIC
+			|| blob[1] != GN_CALIBRATION_BLOB_VERSION || payload < 1
+			|| payload > GN_CALIBRATION_BLOB_SIZE - GN_CALIBRATION_BLOB_HEADER_SIZE
+			|| payload > size - GN_CALIBRATION_BLOB_HEADER_SIZE) {
+		ESP_LOGW(TAG, "[%s] unknown calibration blob, ignored", cal->key);
+		return;
+	}
+
+	const uint8_t *p = blob + GN_CALIBRATION_BLOB_HEADER_SIZE;
+	const uint8_t *end = p + payload;
+
+	size_t count = *p++;
+	if (count > GN_CALIBRATION_MAX_TABLES)
+		goto fail;
+
+	for (size_t i = 0; i < count; i++) {
+		gn_calibration_table_t *t = &cal->tables[i];
+		if (p >= end)
+			goto fail;
+		size_t name_len = *p++;
+		if (name_len == 0 || name_len >= GN_LEAF_PARAM_NAME_SIZE
+				|| (size_t) (end - p) < name_len + 1)
+			goto fail;
+		memcpy(t->param_name, p, name_len);
+		t->param_name[name_len] = '\0';
+		p += name_len;
+		t->count = *p++;
+		size_t points_len = t->count * sizeof(gn_calibration_point_t);
+		if (t->count > GN_CALIBRATION_MAX_POINTS
+				|| (size_t) (end - p) < points_len)
+			goto fail;
+		memcpy(t->points, p, points_len);
+		p += points_len;
+		if (!_gn_calibration_sort(t->points, t->count))
+			goto fail;
+	}
+
+	//trailing bytes mean a different layout
+	if (p != end)
+		goto fail;
+
+	cal->count = count;
+	return;
+
+	fail: ESP_LOGW(TAG, "[%s] corrupted calibration blob, ignored", cal->key);
+	memset(cal->tables, 0, sizeof(cal->tables));
+
+}
+
+/**
+ * @brief	replaces the points of a table, persists the leaf tables and publishes the new table
+ */
+static gn_err_t _gn_calibration_store(gn_calibration_handle_t cal,
+		gn_calibration_table_t *table, gn_calibration_point_t *points,
+		size_t count) {
+
+	if (count > GN_CALIBRATION_MAX_POINTS || !_gn_calibration_sort(points, count))
+		return GN_RET_ERR_INVALID_ARG;
+
+	uint8_t *blob = gn_mem_malloc(gn_leaf_get_mem_tag(cal->leaf_config),
+			GN_CALIBRATION_BLOB_SIZE);
+	char *text = gn_mem_malloc(gn_leaf_get_mem_tag(cal->leaf_config),
+			GN_CALIBRATION_TEXT_SIZE);
+
+	xSemaphoreTake(cal->lock, portMAX_DELAY);
+	memcpy(table->points, points, count * sizeof(gn_calibration_point_t));
+	table->count = count;
+	size_t len = _gn_calibration_to_blob(cal, blob);
+	_gn_calibration_to_text(table, text, GN_CALIBRATION_TEXT_SIZE);
+	xSemaphoreGive(cal->lock);
+
+	gn_err_t ret = gn_storage_set(cal->key, blob, len);
+	if (ret != GN_RET_OK)
+		ESP_LOGW(TAG, "[%s] not possible to store the calibration", cal->key);
+
+	ESP_LOGI(TAG, "[%s] %s calibration: %s", cal->key, table->param_name, text);
+	if (table->cal_param)
+		gn_leaf_param_force_string(cal->leaf_config, table->cal_name, text);
+
+	gn_mem_free(text);
+	gn_mem_free(blob);
+	return ret;
+
+}
+
+/**
+ * @brief	creates the calibration of a leaf, loading its stored tables.
+ * to be called in the leaf configuration callback
+ *
+ * @param	leaf_config	the leaf
+ *
+ * @return	the calibration, NULL in case of errors
+ */
+gn_calibration_handle_t gn_calibration_create(gn_leaf_handle_t leaf_config) {
+
+	if (!leaf_config)
+		return NULL;
+
+	gn_calibration_handle_t cal = gn_mem_calloc(
+			gn_leaf_get_mem_tag(leaf_config), 1, sizeof(struct gn_calibration));
+	if (!cal)
+		return NULL;
+
+	cal->lock = xSemaphoreCreateMutex();
+	if (!cal->lock) {
+		gn_mem_free(cal);
+		return NULL;
+	}
+
+	cal->leaf_config = leaf_config;
+	gn_leaf_get_name(leaf_config, cal->key);
+	strcat(cal->key, GN_CALIBRATION_STORAGE_SUFFIX);
+
+	uint8_t *blob = NULL;
+	size_t size = 0;
+	if (gn_storage_get_blob(cal->key, (void**) &blob, &size)
+			== GN_RET_NVS_PARAMETER_FOUND) {
+		_gn_calibration_from_blob(cal, blob, size);
+		free(blob);
+	}
+
+	return cal;
+
+}
+
+/**
+ * @brief	calibrates a parameter of the leaf, creating its command parameter
+ *
+ * @param	cal			the calibration of the leaf
+ * @param	param_name	the calibrated parameter
+ *
+ * @return	GN_RET_ERR_INVALID_ARG if the name is too long or there are too many tables
+ */
+gn_err_t gn_calibration_param_add(gn_calibration_handle_t cal,
+		const char *param_name) {
+
+	if (!cal || !param_name
+			|| strlen(param_name) + strlen(GN_CALIBRATION_PARAM_SUFFIX)
+					>= GN_LEAF_PARAM_NAME_SIZE)
+		return GN_RET_ERR_INVALID_ARG;
+
+	gn_calibration_table_t *table = _gn_calibration_find(cal, param_name);
+	if (!table) {
+		if (cal->count == GN_CALIBRATION_MAX_TABLES)
+			return GN_RET_ERR_INVALID_ARG;
+		table = &cal->tables[cal->count++];
+		strcpy(table->param_name, param_name);
+	} else if (table->cal_param)
+		return GN_RET_ERR_INVALID_ARG;
+
+	strcpy(table->cal_name, param_name);
+	strcat(table->cal_name, GN_CALIBRATION_PARAM_SUFFIX);
+
+	char text[GN_CALIBRATION_TEXT_SIZE];
+	_gn_calibration_to_text(table, text, sizeof(text));
+
+	table->cal_param = gn_leaf_param_create(cal->leaf_config, table->cal_name,
+			GN_VAL_TYPE_STRING, (gn_val_t ) { .s = text },
+			GN_LEAF_PARAM_ACCESS_ALL, GN_LEAF_PARAM_STORAGE_VOLATILE, NULL);
+	if (!table->cal_param)
+		return GN_RET_ERR;
+
+	return gn_leaf_param_add_to_leaf(cal->leaf_config, table->cal_param);
+
+}
+
+/**
+ * @brief	converts a raw reading, remembering it for the capture
+ *
+ * @param	cal			the calibration of the leaf
+ * @param	param_name	the calibrated parameter
+ * @param	raw			the reading
+ * @param	value		the calibrated value, untouched if the parameter is not calibrated
+ *
+ * @return	false if the table has no points, the leaf applies its own conversion
+ */
+bool gn_calibration_apply(gn_calibration_handle_t cal, const char *param_name,
+		double raw, double *value) {
+
+	if (!cal || !param_name || !value)
+		return false;
+
+	bool ret = false;
+	xSemaphoreTake(cal->lock, portMAX_DELAY);
+	gn_calibration_table_t *table = _gn_calibration_find(cal, param_name);
+	if (table) {
+		table->last_raw = raw;
+		table->has_raw = true;
+		if (table->count > 0) {
+			*value = _gn_calibration_interpolate(table, raw);
+			ret = true;
+		}
+	}
+	xSemaphoreGive(cal->lock);
+	return ret;
+
+}
+
+/**
+ * @brief	replaces the table of a parameter, a count of 0 clears it
+ *
+ * @return	GN_RET_ERR_INVALID_ARG if the points are too many, not finite or with duplicated raw readings
+ */
+gn_err_t gn_calibration_set_points(gn_calibration_handle_t cal,
+		const char *param_name, const gn_calibration_point_t *points,
+		size_t count) {
+
+	if (!cal || !param_name || (count > 0 && !points)
+			|| count > GN_CALIBRATION_MAX_POINTS)
+		return GN_RET_ERR_INVALID_ARG;
+
+	gn_calibration_table_t *table = _gn_calibration_find(cal, param_name);
+	if (!table)
+		return GN_RET_ERR_INVALID_ARG;
+
+	gn_calibration_point_t sorted[GN_CALIBRATION_MAX_POINTS];
+	memcpy(sorted, points, count * sizeof(gn_calibration_point_t));
+	return _gn_calibration_store(cal, table, sorted, count);
+
+}
+
+/**
+ * @brief	pairs a reference value with the last raw reading of the parameter, replacing the
+ * point with the same reading if any
+ *
+ * @return	GN_RET_ERR_INVALID_ARG if no reading was applied yet or the table is full
+ */
+gn_err_t gn_calibration_capture(gn_calibration_handle_t cal,
+		const char *param_name, double reference) {
+
+	if (!cal || !param_name || !isfinite(reference))
+		return GN_RET_ERR_INVALID_ARG;
+
+	gn_calibration_table_t *table = _gn_calibration_find(cal, param_name);
+	if (!table)
+		return GN_RET_ERR_INVALID_ARG;
+
+	gn_calibration_point_t points[GN_CALIBRATION_MAX_POINTS];
+	xSemaphoreTake(cal->lock, portMAX_DELAY);
+	bool has_raw = table->has_raw;
+	gn_calibration_point_t point = { .raw = table->last_raw, .value =
+			reference };
+	size_t count = table->count;
+	memcpy(points, table->points, count * sizeof(gn_calibration_point_t));
+	xSemaphoreGive(cal->lock);
+
+	if (!has_raw) {
+		ESP_LOGW(TAG, "[%s] no %s reading to capture", cal->key, param_name);
+		return GN_RET_ERR_INVALID_ARG;
+	}
+
+	size_t i = 0;
+	while (i < count && points[i].raw != point.raw)
+		i++;
+	if (i == GN_CALIBRATION_MAX_POINTS) {
+		ESP_LOGW(TAG, "[%s] %s calibration full", cal->key, param_name);
+		return GN_RET_ERR_INVALID_ARG;
+	}
+	points[i] = point;
+
+	return _gn_calibration_store(cal, table, points, i == count ? count + 1 : count);
+
+}
+
+/**
+ * @brief	copies the table of a parameter
+ *
+ * @return	the number of points copied
+ */
+size_t gn_calibration_get_points(gn_calibration_handle_t cal,
+		const char *param_name, gn_calibration_point_t *points, size_t size) {
+
+	if (!cal || !param_name || !points)
+		return 0;
+
+	size_t count = 0;
+	xSemaphoreTake(cal->lock, portMAX_DELAY);
+	gn_calibration_table_t *table = _gn_calibration_find(cal, param_name);
+	if (table) {
+		count = table->count < size ? table->count : size;
+		memcpy(points, table->points, count * sizeof(gn_calibration_point_t));
+	}
+	xSemaphoreGive(cal->lock);
+	return count;
+
+}
+
+/**
+ * @brief	executes a command sent to a calibration parameter from the network
+ *
+ * @return	true if the event was addressed to a calibration parameter of the leaf
+ */
+bool gn_calibration_param_event(gn_calibration_handle_t cal,
+		gn_leaf_parameter_event_handle_t evt) {
+
+	if (!cal || !evt)
+		return false;
+
+	gn_calibration_table_t *table = NULL;
+	for (size_t i = 0; i < cal->count && !table; i++) {
+		if (cal->tables[i].cal_param
+				&& gn_leaf_event_mask_param(evt, cal->tables[i].cal_param) == 0)
+			table = &cal->tables[i];
+	}
+	if (!table)
+		return false;
+
+	char text[GN_CALIBRATION_TEXT_SIZE] = { 0 };
+	gn_event_payload_to_string(*evt, text, sizeof(text) - 1);
+
+	gn_err_t ret;
+	if (strcmp(text, "clear") == 0) {
+		ret = gn_calibration_set_points(cal, table->param_name, NULL, 0);
+	} else if (strchr(text, ':')) {
+		gn_calibration_point_t points[GN_CALIBRATION_MAX_POINTS];
+		int count = _gn_calibration_parse(text, points);
+		ret = count < 0 ?
+				GN_RET_ERR_INVALID_ARG :
+				gn_calibration_set_points(cal, table->param_name, points,
+						count);
+	} else {
+		char *end;
+		double reference = strtod(text, &end);
+		ret = end == text || *end != '\0' ?
+				GN_RET_ERR_INVALID_ARG :
+				gn_calibration_capture(cal, table->param_name, reference);
+	}
+
+	if (ret != GN_RET_OK)
+		ESP_LOGW(TAG, "[%s] refused %s command '%s'", cal->key,
+				table->cal_name, text);
+
+	return true;
+
+}
+
+void gn_calibration_delete(gn_calibration_handle_t cal) {
+
+	if (!cal)
+		return;
+	vSemaphoreDelete(cal->lock);
+	gn_mem_free(cal);
+
+}
+
+#ifdef __cplusplus
+}
+#endif //__cplusplus
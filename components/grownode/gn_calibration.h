@@ -0,0 +1,85 @@
+// Copyright 2021 Nicola Muratori (nicola.muratori@gmail.com)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef GN_CALIBRATION_H_
+#define GN_CALIBRATION_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "gn_commons.h"
+
+/*
+ * piecewise linear calibration of sensor parameters. every calibrated parameter has a table of
+ * (raw, value) points sorted by raw reading, looked up with a binary search and interpolated
+ * between the two closest points, extrapolated along the first and last segment outside of them.
+ * a single point is an offset.
+ *
+ * the tables of a leaf are persisted together in one NVS blob. each parameter gets a string
+ * parameter named after it with GN_CALIBRATION_PARAM_SUFFIX showing the table as "raw:value,..."
+ * and accepting the commands:
+ *
+ *   <value>              pairs the reference value with the last raw reading (capture mode)
+ *   <raw>:<value>,...    replaces the table
+ *   clear                removes all points, the leaf falls back to its own conversion
+ */
+
+#define GN_CALIBRATION_MAX_TABLES 4
+#define GN_CALIBRATION_MAX_POINTS 12
+#define GN_CALIBRATION_TEXT_SIZE 384
+//suffix of the command parameter created for the calibrated parameter
+#define GN_CALIBRATION_PARAM_SUFFIX "_cal"
+//suffix of the storage key of the leaf tables
+#define GN_CALIBRATION_STORAGE_SUFFIX "_cal"
+
+typedef struct {
+	float raw;
+	float value;
+} gn_calibration_point_t;
+
+typedef struct gn_calibration *gn_calibration_handle_t;
+
+gn_calibration_handle_t gn_calibration_create(gn_leaf_handle_t leaf_config);
+
+gn_err_t gn_calibration_param_add(gn_calibration_handle_t cal,
+		const char *param_name);
+
+bool gn_calibration_apply(gn_calibration_handle_t cal, const char *param_name,
+		double raw, double *value);
+
+gn_err_t gn_calibration_set_points(gn_calibration_handle_t cal,
+		const char *param_name, const gn_calibration_point_t *points,
+		size_t count);
+
+gn_err_t gn_calibration_capture(gn_calibration_handle_t cal,
+		const char *param_name, double reference);
+
+size_t gn_calibration_get_points(gn_calibration_handle_t cal,
+		const char *param_name, gn_calibration_point_t *points, size_t size);
+
+bool gn_calibration_param_event(gn_calibration_handle_t cal,
+		gn_leaf_parameter_event_handle_t evt);
+
+void gn_calibration_delete(gn_calibration_handle_t cal);
+
+#ifdef __cplusplus
+}
+#endif //__cplusplus
+
+#endif /* GN_CALIBRATION_H_ */
@@ -182,7 +182,11 @@ gn_err_t gn_double_to_event_payload(double val, gn_leaf_parameter_event_handle_t
  */
 gn_err_t gn_string_to_event_payload(char *val, int val_len, gn_leaf_parameter_event_handle_t evt) {
 
+	if (val_len >= GN_LEAF_DATA_SIZE)
+		val_len = GN_LEAF_DATA_SIZE - 1;
 	strncpy(evt->data, val, val_len);
+	evt->data[val_len] = '\0';
+	evt->data_len = val_len;
 	return GN_RET_OK;
 }
 
@@ -37,11 +37,15 @@ extern "C" {
 #define GN_LEAF_DESC_TYPE_SIZE 32
 
 #define GN_NODE_LEAF_MAX_SIZE 64
+#define GN_NODE_TOPIC_INDEX_SIZE 32 /*!< initial size of the command topic index, grows as needed */
+#define GN_LEAF_CONTEXT_SIZE 4
 
 #include "esp_log.h"
 #include "esp_system.h"
 #include "esp_event.h"
 #include "gn_event_source.h"
+#include "gn_trace.h"
+#include "gn_mem.h"
 
 /**
     @brief maximum time between two keepalive messages
@@ -142,7 +146,7 @@ typedef struct {
 	char firmware_url[255];
 	char sntp_url[255];
 	uint64_t wakeup_time_millisec; /*! if sleep mode is GN_SLEEP_MODE_LIGHT or GN_SLEEP_MODE_DEEP, sets for how long the board must stay on (counted from boot) !*/
-	uint64_t sleep_time_millisec; /*! if sleep mode is GN_SLEEP_MODE_LIGHT or GN_SLEEP_MODE_DEEP, sets for how long the board must sleep !*/
+	uint64_t sleep_time_millisec; /*! if sleep mode is GN_SLEEP_MODE_LIGHT or GN_SLEEP_MODE_DEEP, sets for how long the board must sleep at most, it wakes up earlier for a scheduled job. 0 to sleep until the next job !*/
 	uint64_t sleep_delay_millisec; /*! if sleep mode is GN_SLEEP_MODE_LIGHT or GN_SLEEP_MODE_DEEP, sets for how long the board must stay on waiting for leaves to complete its job before sleeping!*/
 	gn_sleep_mode_t sleep_mode; /*! define if and how the board must sleep !*/
 	char timezone[32]; /*! defines the timezone in POSIX time (TZ env variable) !*/
@@ -163,6 +167,9 @@ typedef struct {
 	char param_name[GN_LEAF_PARAM_NAME_SIZE];
 	char data[GN_LEAF_DATA_SIZE]; /*!< Data associated with this event */
 	int data_len; /*!< Length of the data for this event */
+#ifdef CONFIG_GROWNODE_LATENCY_TRACE
+	gn_trace_t trace; /*!< hops of the network command that caused this event */
+#endif
 } gn_leaf_parameter_event_t;
 
 typedef gn_leaf_parameter_event_t *gn_leaf_parameter_event_handle_t;
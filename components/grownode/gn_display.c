@@ -41,6 +41,7 @@ extern "C" {
 #include "esp_heap_caps.h"
 
 #include "gn_display.h"
+#include "gn_display_binding.h"
 #include "gn_commons.h"
 #include "grownode_intl.h"
 #include "gn_event_source.h"
@@ -716,7 +717,10 @@ BaseType_t gn_display_leaf_refresh_start() {
  */
 BaseType_t gn_display_leaf_refresh_end() {
 	ESP_LOGD(TAG, "gn_display_leaf_refresh_end");
-	return xSemaphoreGive(_gn_xGuiSemaphore);
+	BaseType_t ret = xSemaphoreGive(_gn_xGuiSemaphore);
+	//widgets changed outside the bindings are rendered at once
+	gn_display_binding_wake();
+	return ret;
 }
 
 /*
@@ -912,6 +916,9 @@ BaseType_t gn_display_leaf_refresh_end() {
  * this has to be called into the display refresh task
  * @see gn_display_leaf_refresh_start()
  *
+ * widgets showing a parameter should be bound to it with gn_display_bind() instead of being
+ * updated by the leaf task, so they are refreshed only on changes and once per frame
+ *
  * @return a pointer to lv_obj_t (to be casted)
  */
 gn_display_container_t gn_display_setup_leaf(
@@ -957,6 +964,24 @@ gn_display_container_t gn_display_setup_leaf(
  }
  */
 
+/**
+ * @brief renders a bound widget, called from the GUI task with the GUI semaphore taken
+ */
+static void _gn_display_binding_apply(const gn_display_binding_update_t *update) {
+
+	lv_obj_t *widget = (lv_obj_t*) update->widget;
+
+	switch (update->kind) {
+	case GN_DISPLAY_BINDING_LABEL:
+		lv_label_set_text(widget, update->text);
+		break;
+	case GN_DISPLAY_BINDING_BAR:
+		lv_bar_set_value(widget, update->value, LV_ANIM_OFF);
+		break;
+	}
+
+}
+
 void _gn_display_gui_task(void *pvParameter) {
 
 	(void) pvParameter;
@@ -969,11 +994,11 @@ void _gn_display_gui_task(void *pvParameter) {
 	/* ToDo Initialize used display driver passing registered lv_disp_drv_t as parameter */
 
 	size_t display_buffer_size = lvgl_get_display_buffer_size();
-	lv_color_t *buf1 = heap_caps_malloc(
+	lv_color_t *buf1 = gn_mem_caps_malloc(GN_MEM_TAG_DISPLAY,
 			display_buffer_size * sizeof(lv_color_t), MALLOC_CAP_DMA);
 	assert(buf1 != NULL);
 
-	lv_color_t *buf2 = heap_caps_malloc(
+	lv_color_t *buf2 = gn_mem_caps_malloc(GN_MEM_TAG_DISPLAY,
 			display_buffer_size * sizeof(lv_color_t), MALLOC_CAP_DMA);
 	assert(buf2 != NULL);
 
@@ -997,13 +1022,16 @@ void _gn_display_gui_task(void *pvParameter) {
 	indev_drv.type = LV_INDEV_TYPE_POINTER;
 	lv_indev_drv_register(&indev_drv);
 
+#ifndef CONFIG_LV_TICK_CUSTOM
 	/* Create and start a periodic timer interrupt to call lv_tick_inc */
+	//not needed when LVGL reads the time from esp_timer_get_time(), saving a wakeup per millisecond
 	const esp_timer_create_args_t periodic_timer_args = { .callback =
 			&_gn_display_lv_tick_task, .name = "_gn_display_lv_tick_task" };
 	esp_timer_handle_t periodic_timer;
 	ESP_ERROR_CHECK(esp_timer_create(&periodic_timer_args, &periodic_timer));
 	ESP_ERROR_CHECK(
 			esp_timer_start_periodic(periodic_timer, LV_TICK_PERIOD_MS * 1000));
+#endif
 
 	//if (pdTRUE == gn_display_leaf_refresh_start()) {
 	//_gn_display_create_gui();
@@ -1055,21 +1083,27 @@ void _gn_display_gui_task(void *pvParameter) {
 	xEventGroupSetBits(_gn_gui_event_group, GN_EVT_GROUP_GUI_COMPLETED_EVENT);
 
 	while (1) {
-		/* Delay 1 tick (assumes FreeRTOS tick is 10ms */
-		vTaskDelay(pdMS_TO_TICKS(10));
+
+		uint32_t next_ms = LV_NO_TIMER_READY;
 
 		/* Try to take the semaphore, call lvgl related function on success */
 		if (pdTRUE == xSemaphoreTake(_gn_xGuiSemaphore, portMAX_DELAY)) {
+			//bound parameters changed since the last frame, each widget once with the latest value
+			gn_display_binding_flush(_gn_display_binding_apply);
 			//gn_log(TAG, GN_LOG_ERROR, "LVGL handle");
-			lv_task_handler();
+			next_ms = lv_task_handler();
 			xSemaphoreGive(_gn_xGuiSemaphore);
 		}
+
+		//sleeps until the next LVGL timer is due or a bound parameter changes
+		gn_display_binding_wait(next_ms);
+
 	}
 
 	/* A task should NEVER return */
-	free(buf1);
+	gn_mem_free(buf1);
 #ifndef CONFIG_LV_TFT_DISPLAY_MONOCHROME
-	free(buf2);
+	gn_mem_free(buf2);
 #endif
 	vTaskDelete(NULL);
 
@@ -0,0 +1,359 @@
+// Copyright 2021 Nicola Muratori (nicola.muratori@gmail.com)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "esp_event.h"
+
+#include "gn_event_source.h"
+#include "grownode.h"
+#include "gn_mem.h"
+
+#include "gn_display_binding.h"
+
+#define TAG "gn_display_binding"
+
+typedef struct {
+	bool used;
+	bool dirty; /*!< the parameter changed since the last frame */
+	gn_leaf_handle_t leaf_config;
+	char leaf_name[GN_LEAF_NAME_SIZE];
+	char param_name[GN_LEAF_PARAM_NAME_SIZE];
+	gn_display_binding_config_t config;
+} gn_display_binding_t;
+
+//allocated at the first binding, under the mutex, so nodes without display pay nothing
+static gn_display_binding_t *_gn_display_bindings = NULL;
+static esp_event_loop_handle_t _gn_display_binding_loop = NULL;
+static SemaphoreHandle_t _gn_display_binding_mutex = NULL;
+static SemaphoreHandle_t _gn_display_binding_wake = NULL; /*!< some widget is dirty */
+
+/**
+ * @brief	creates the binding lock. called once by gn_init, before the GUI task and the leaves start
+ *
+ * @return	GN_RET_ERR if the lock cannot be created, widgets cannot be bound afterwards
+ */
+gn_err_t gn_display_binding_init() {
+
+	if (_gn_display_binding_mutex)
+		return GN_RET_OK;
+
+	_gn_display_binding_mutex = xSemaphoreCreateMutex();
+	_gn_display_binding_wake = xSemaphoreCreateBinary();
+	if (!_gn_display_binding_mutex || !_gn_display_binding_wake) {
+		ESP_LOGE(TAG, "cannot create the display bindings");
+		if (_gn_display_binding_mutex)
+			vSemaphoreDelete(_gn_display_binding_mutex);
+		if (_gn_display_binding_wake)
+			vSemaphoreDelete(_gn_display_binding_wake);
+		_gn_display_binding_mutex = NULL;
+		_gn_display_binding_wake = NULL;
+		return GN_RET_ERR;
+	}
+
+	return GN_RET_OK;
+
+}
+
+static void _gn_display_binding_evt_handler(void *handler_args,
+		esp_event_base_t base, int32_t id, void *event_data) {
+
+	gn_leaf_parameter_event_handle_t evt =
+			(gn_leaf_parameter_event_handle_t) event_data;
+	if (!evt)
+		return;
+
+	bool wake = false;
+
+	xSemaphoreTake(_gn_display_binding_mutex, portMAX_DELAY);
+	for (size_t i = 0; i < GN_DISPLAY_BINDING_MAX; i++) {
+		gn_display_binding_t *b = &_gn_display_bindings[i];
+		if (b->used && !b->dirty && strcmp(b->param_name, evt->param_name) == 0
+				&& strcmp(b->leaf_name, evt->leaf_name) == 0) {
+			b->dirty = true;
+			wake = true;
+		}
+	}
+	xSemaphoreGive(_gn_display_binding_mutex);
+
+	if (wake)
+		xSemaphoreGive(_gn_display_binding_wake);
+
+}
+
+/**
+ * @brief	binds a widget to a leaf parameter
+ *
+ * the widget is rendered at the next frame and then at every change of the parameter.
+ * binding a widget again replaces its previous binding.
+ *
+ * @param	leaf_config	the leaf
+ * @param	param_name	the parameter to show
+ * @param	config		the widget and how to render the value
+ *
+ * @return	GN_RET_ERR_INVALID_ARG if the parameter is not found or the config is not valid
+ * @return	GN_RET_ERR if there is no room for the binding
+ */
+gn_err_t gn_display_bind(gn_leaf_handle_t leaf_config, const char *param_name,
+		const gn_display_binding_config_t *config) {
+
+	if (!leaf_config || !param_name || !config || !config->widget
+			|| strlen(param_name) >= GN_LEAF_PARAM_NAME_SIZE
+			|| (config->kind != GN_DISPLAY_BINDING_LABEL
+					&& config->kind != GN_DISPLAY_BINDING_BAR)
+			|| (config->kind == GN_DISPLAY_BINDING_BAR
+					&& config->max == config->min))
+		return GN_RET_ERR_INVALID_ARG;
+
+	if (!gn_leaf_param_get_param_handle(leaf_config, param_name))
+		return GN_RET_ERR_INVALID_ARG;
+
+	if (!_gn_display_binding_mutex)
+		return GN_RET_ERR;
+
+	esp_event_loop_handle_t loop = gn_leaf_get_event_loop(leaf_config);
+
+	xSemaphoreTake(_gn_display_binding_mutex, portMAX_DELAY);
+
+	if (!_gn_display_bindings) {
+		_gn_display_bindings = gn_mem_calloc(GN_MEM_TAG_DISPLAY,
+				GN_DISPLAY_BINDING_MAX, sizeof(gn_display_binding_t));
+		if (!_gn_display_bindings) {
+			xSemaphoreGive(_gn_display_binding_mutex);
+			ESP_LOGE(TAG, "cannot create the display bindings");
+			return GN_RET_ERR;
+		}
+	}
+
+	if (!_gn_display_binding_loop) {
+		if (esp_event_handler_instance_register_with(loop, GN_BASE_EVENT,
+				GN_LEAF_PARAM_CHANGED_EVENT, _gn_display_binding_evt_handler,
+				NULL, NULL) != ESP_OK) {
+			xSemaphoreGive(_gn_display_binding_mutex);
+			ESP_LOGE(TAG, "unable to subscribe to parameter changes");
+			return GN_RET_ERR;
+		}
+		_gn_display_binding_loop = loop;
+	}
+
+	gn_display_binding_t *b = NULL;
+	for (size_t i = 0; i < GN_DISPLAY_BINDING_MAX; i++) {
+		gn_display_binding_t *c = &_gn_display_bindings[i];
+		if (c->used && c->config.widget == config->widget) {
+			b = c;
+			break;
+		}
+		if (!c->used && !b)
+			b = c;
+	}
+
+	if (!b) {
+		xSemaphoreGive(_gn_display_binding_mutex);
+		ESP_LOGE(TAG, "too many display bindings");
+		return GN_RET_ERR;
+	}
+
+	b->leaf_config = leaf_config;
+	gn_leaf_get_name(leaf_config, b->leaf_name);
+	strcpy(b->param_name, param_name);
+	b->config = *config;
+	b->used = true;
+	b->dirty = true;
+
+	xSemaphoreGive(_gn_display_binding_mutex);
+
+	ESP_LOGD(TAG, "%s.%s bound", b->leaf_name, param_name);
+	xSemaphoreGive(_gn_display_binding_wake);
+
+	return GN_RET_OK;
+
+}
+
+/**
+ * @brief	stops updating a widget, to be called before deleting it
+ */
+gn_err_t gn_display_unbind(void *widget) {
+
+	if (!widget)
+		return GN_RET_ERR_INVALID_ARG;
+
+	if (!_gn_display_binding_mutex)
+		return GN_RET_ERR;
+
+	gn_err_t ret = GN_RET_ERR_INVALID_ARG;
+
+	xSemaphoreTake(_gn_display_binding_mutex, portMAX_DELAY);
+	for (size_t i = 0; _gn_display_bindings && i < GN_DISPLAY_BINDING_MAX;
+			i++) {
+		gn_display_binding_t *b = &_gn_display_bindings[i];
+		if (b->used && b->config.widget == widget) {
+			b->used = false;
+			ret = GN_RET_OK;
+		}
+	}
+	xSemaphoreGive(_gn_display_binding_mutex);
+
+	return ret;
+
+}
+
+static int32_t _gn_display_binding_percent(
+		const gn_display_binding_config_t *config, double value) {
+
+	double p = (value - config->min) * 100 / (config->max - config->min);
+	if (!(p > 0))
+		return 0;
+	if (p > 100)
+		return 100;
+	return (int32_t) (p + 0.5);
+
+}
+
+/**
+ * @brief	renders the value of a binding
+ */
+static bool _gn_display_binding_render(const gn_display_binding_t *b,
+		gn_display_binding_apply_t apply) {
+
+	gn_val_type_t type;
+	if (gn_leaf_param_get_type(
+			gn_leaf_param_get_param_handle(b->leaf_config, b->param_name),
+			&type) != GN_RET_OK)
+		return false;
+
+	char text[GN_DISPLAY_BINDING_TEXT_SIZE] = { 0 };
+	gn_display_binding_update_t update = { .kind = b->config.kind, .widget =
+			b->config.widget, .text = text, .value = 0 };
+	const char *format = b->config.format;
+
+	switch (type) {
+	case GN_VAL_TYPE_DOUBLE: {
+		double d = 0;
+		if (gn_leaf_param_get_double(b->leaf_config, b->param_name, &d)
+				!= GN_RET_OK)
+			return false;
+		snprintf(text, sizeof(text), format ? format : "%.2f", d);
+		update.value = _gn_display_binding_percent(&b->config, d);
+	}
+		break;
+	case GN_VAL_TYPE_BOOLEAN: {
+		bool v = false;
+		if (gn_leaf_param_get_bool(b->leaf_config, b->param_name, &v)
+				!= GN_RET_OK)
+			return false;
+		snprintf(text, sizeof(text), format ? format : "%s", v ? "on" : "off");
+		update.value = v ? 100 : 0;
+	}
+		break;
+	default: {
+		char s[GN_LEAF_DATA_SIZE] = { 0 };
+		if (gn_leaf_param_get_string(b->leaf_config, b->param_name, s,
+				sizeof(s) - 1) != GN_RET_OK)
+			return false;
+		snprintf(text, sizeof(text), format ? format : "%s", s);
+		update.value = _gn_display_binding_percent(&b->config, atof(s));
+	}
+		break;
+	}
+
+	apply(&update);
+	return true;
+
+}
+
+/**
+ * @brief	applies the widgets whose parameter changed since the last call
+ *
+ * to be called by the GUI task once per frame, with the GUI semaphore taken.
+ * each dirty widget is applied once, with the current value of its parameter.
+ *
+ * @return	the number of widgets applied
+ */
+size_t gn_display_binding_flush(gn_display_binding_apply_t apply) {
+
+	if (!apply || !_gn_display_binding_mutex)
+		return 0;
+
+	size_t applied = 0;
+	gn_display_binding_t b;
+
+	for (size_t i = 0; i < GN_DISPLAY_BINDING_MAX; i++) {
+
+		xSemaphoreTake(_gn_display_binding_mutex, portMAX_DELAY);
+		bool dirty = _gn_display_bindings && _gn_display_bindings[i].used
+				&& _gn_display_bindings[i].dirty;
+		if (dirty) {
+			_gn_display_bindings[i].dirty = false;
+			b = _gn_display_bindings[i];
+		}
+		xSemaphoreGive(_gn_display_binding_mutex);
+
+		//the parameters are read without the lock, a change meanwhile marks the widget again
+		if (dirty && _gn_display_binding_render(&b, apply))
+			applied++;
+
+	}
+
+	return applied;
+
+}
+
+/**
+ * @brief	sleeps until a bound parameter changes or the timeout elapses
+ *
+ * @param	max_millisec	the timeout, eg. the next LVGL timer deadline. UINT32_MAX waits forever
+ *
+ * @return	true if woken by a change
+ */
+bool gn_display_binding_wait(uint32_t max_millisec) {
+
+	if (!_gn_display_binding_wake) {
+		vTaskDelay(pdMS_TO_TICKS(10));
+		return false;
+	}
+
+	uint64_t ticks = (uint64_t) max_millisec * configTICK_RATE_HZ / 1000;
+	if (ticks == 0 && max_millisec > 0)
+		ticks = 1;
+
+	return xSemaphoreTake(_gn_display_binding_wake,
+			ticks >= portMAX_DELAY ? portMAX_DELAY : (TickType_t) ticks)
+			== pdTRUE;
+
+}
+
+/**
+ * @brief	wakes the GUI task, eg. after widgets changed outside the bindings
+ */
+void gn_display_binding_wake() {
+
+	if (_gn_display_binding_wake)
+		xSemaphoreGive(_gn_display_binding_wake);
+
+}
+
+#ifdef __cplusplus
+}
+#endif //__cplusplus
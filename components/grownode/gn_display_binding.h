@@ -0,0 +1,81 @@
+// Copyright 2021 Nicola Muratori (nicola.muratori@gmail.com)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef GN_DISPLAY_BINDING_H_
+#define GN_DISPLAY_BINDING_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "sdkconfig.h"
+#include "gn_commons.h"
+
+/*
+ * widgets bound to leaf parameters: a GN_LEAF_PARAM_CHANGED_EVENT of a bound parameter marks its
+ * widgets dirty and wakes the GUI task, that applies all the dirty widgets once per frame with the
+ * latest value of their parameter. changes received between two frames are coalesced.
+ *
+ * this layer does not depend on LVGL: widgets are opaque pointers, rendered by the apply callback
+ * given to gn_display_binding_flush() from the GUI task, with the GUI semaphore taken.
+ */
+
+#define GN_DISPLAY_BINDING_MAX 24
+#define GN_DISPLAY_BINDING_TEXT_SIZE 32
+
+typedef enum {
+	GN_DISPLAY_BINDING_LABEL = 0, /*!< text of the value */
+	GN_DISPLAY_BINDING_BAR = 1 /*!< value between min and max mapped to 0..100 */
+} gn_display_binding_kind_t;
+
+typedef struct {
+	gn_display_binding_kind_t kind;
+	void *widget; /*!< the widget to update, eg. a lv_obj_t */
+	const char *format; /*!< label text, printf format of a double for double parameters and of a string otherwise. NULL for "%.2f" and "%s" */
+	double min; /*!< bar value at 0 */
+	double max; /*!< bar value at 100 */
+} gn_display_binding_config_t;
+
+typedef struct {
+	gn_display_binding_kind_t kind;
+	void *widget;
+	const char *text; /*!< label text */
+	int32_t value; /*!< bar value, 0..100 */
+} gn_display_binding_update_t;
+
+typedef void (*gn_display_binding_apply_t)(
+		const gn_display_binding_update_t *update);
+
+gn_err_t gn_display_binding_init();
+
+gn_err_t gn_display_bind(gn_leaf_handle_t leaf_config, const char *param_name,
+		const gn_display_binding_config_t *config);
+
+gn_err_t gn_display_unbind(void *widget);
+
+size_t gn_display_binding_flush(gn_display_binding_apply_t apply);
+
+bool gn_display_binding_wait(uint32_t max_millisec);
+
+void gn_display_binding_wake();
+
+#ifdef __cplusplus
+}
+#endif //__cplusplus
+
+#endif /* GN_DISPLAY_BINDING_H_ */
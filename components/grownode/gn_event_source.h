@@ -67,6 +67,7 @@ typedef enum {
 	GN_SRV_CONNECTED_EVENT = 0x501,
 	GN_SRV_DISCONNECTED_EVENT = 0x502,
 	GN_SRV_KEEPALIVE_TRIGGERED_EVENT = 0x503,
+	GN_SRV_STATS_TRIGGERED_EVENT = 0x504,
 
 	//node events
 	GN_NODE_STARTED_EVENT = 0x601,
@@ -0,0 +1,522 @@
+// Copyright 2021 Nicola Muratori (nicola.muratori@gmail.com)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "grownode.h"
+#include "gn_filter.h"
+
+#define TAG "gn_filter"
+
+typedef enum {
+	GN_FILTER_STAGE_MEDIAN,
+	GN_FILTER_STAGE_AVG,
+	GN_FILTER_STAGE_EMA,
+	GN_FILTER_STAGE_RATE,
+	GN_FILTER_STAGE_KALMAN,
+	GN_FILTER_STAGE_DELTA
+} gn_filter_stage_type_t;
+
+typedef struct {
+	gn_filter_stage_type_t type;
+	size_t n; /*!< window of median and avg */
+	double a; /*!< ema weight, rate, kalman process noise, delta */
+	double b; /*!< kalman measurement noise */
+} gn_filter_stage_config_t;
+
+typedef struct {
+	gn_filter_stage_config_t config;
+	bool primed; /*!< at least one sample seen */
+	union {
+		struct {
+			double window[GN_FILTER_MEDIAN_MAX]; /*!< arrival order */
+			double sorted[GN_FILTER_MEDIAN_MAX];
+			size_t count;
+			size_t next;
+		} median;
+		struct {
+			double window[GN_FILTER_AVG_MAX];
+			double sum;
+			size_t count;
+			size_t next;
+		} avg;
+		struct {
+			double y;
+			int64_t ts_us;
+		} smooth; /*!< ema, rate and delta */
+		struct {
+			double x;
+			double p;
+		} kalman;
+	} s;
+} gn_filter_stage_t;
+
+struct gn_filter {
+	size_t count;
+	gn_filter_stage_t stages[GN_FILTER_MAX_STAGES];
+	char spec[GN_FILTER_SPEC_SIZE];
+	double out; /*!< last output, held on samples that are not numbers */
+	//parameter binding
+	gn_leaf_handle_t leaf_config;
+	gn_leaf_param_handle_t spec_param;
+	char param_name[GN_LEAF_PARAM_NAME_SIZE];
+	char spec_name[GN_LEAF_PARAM_NAME_SIZE];
+};
+
+static bool _gn_filter_parse_uint(const char *s, size_t *val) {
+
+	char *end;
+	long v = strtol(s, &end, 10);
+	if (end == s || *end != '\0' || v <= 0)
+		return false;
+	*val = v;
+	return true;
+
+}
+
+static bool _gn_filter_parse_double(const char *s, double *val) {
+
+	char *end;
+	*val = strtod(s, &end);
+	return end != s && *end == '\0' && isfinite(*val);
+
+}
+
+/**
+ * @brief	parses the spec into the stage configurations
+ *
+ * @return	the number of stages, -1 if the spec is not valid
+ */
+static int _gn_filter_parse(const char *spec,
+		gn_filter_stage_config_t configs[GN_FILTER_MAX_STAGES]) {
+
+	if (!spec || strlen(spec) >= GN_FILTER_SPEC_SIZE)
+		return -1;
+
+	char buf[GN_FILTER_SPEC_SIZE];
+	strcpy(buf, spec);
+
+	int count = 0;
+	char *save_stage;
+	for (char *stage = strtok_r(buf, ",", &save_stage); stage; stage =
+			strtok_r(NULL, ",", &save_stage)) {
+
+		if (count == GN_FILTER_MAX_STAGES)
+			return -1;
+
+		char *args[3] = { 0 };
+		int argc = 0;
+		char *save_arg;
+		for (char *arg = strtok_r(stage, ":", &save_arg); arg; arg =
+				strtok_r(NULL, ":", &save_arg)) {
+			if (argc == 3)
+				return -1;
+			args[argc++] = arg;
+		}
+
+		gn_filter_stage_config_t *c = &configs[count];
+		memset(c, 0, sizeof(gn_filter_stage_config_t));
+
+		if (argc == 2 && strcmp(args[0], "median") == 0) {
+			c->type = GN_FILTER_STAGE_MEDIAN;
+			if (!_gn_filter_parse_uint(args[1], &c->n) || c->n % 2 == 0
+					|| c->n > GN_FILTER_MEDIAN_MAX)
+				return -1;
+		} else if (argc == 2 && strcmp(args[0], "avg") == 0) {
+			c->type = GN_FILTER_STAGE_AVG;
+			if (!_gn_filter_parse_uint(args[1], &c->n)
+					|| c->n > GN_FILTER_AVG_MAX)
+				return -1;
+		} else if (argc == 2 && strcmp(args[0], "ema") == 0) {
+			c->type = GN_FILTER_STAGE_EMA;
+			if (!_gn_filter_parse_double(args[1], &c->a) || c->a <= 0
+					|| c->a > 1)
+				return -1;
+		} else if (argc == 2 && strcmp(args[0], "rate") == 0) {
+			c->type = GN_FILTER_STAGE_RATE;
+			if (!_gn_filter_parse_double(args[1], &c->a) || c->a <= 0)
+				return -1;
+		} else if (argc == 3 && strcmp(args[0], "kalman") == 0) {
+			c->type = GN_FILTER_STAGE_KALMAN;
+			if (!_gn_filter_parse_double(args[1], &c->a) || c->a <= 0
+					|| !_gn_filter_parse_double(args[2], &c->b) || c->b <= 0)
+				return -1;
+		} else if (argc == 2 && strcmp(args[0], "delta") == 0) {
+			c->type = GN_FILTER_STAGE_DELTA;
+			if (!_gn_filter_parse_double(args[1], &c->a) || c->a < 0)
+				return -1;
+		} else
+			return -1;
+
+		count++;
+
+	}
+
+	return count;
+
+}
+
+static double _gn_filter_median(gn_filter_stage_t *st, double x) {
+
+	//the sorted copy is kept by removing the evicted sample and inserting the new one,
+	//at most GN_FILTER_MEDIAN_MAX moves
+	double *sorted = st->s.median.sorted;
+	size_t n = st->s.median.count;
+
+	if (n == st->config.n) {
+		double old = st->s.median.window[st->s.median.next];
+		size_t i = 0;
+		while (sorted[i] != old)
+			i++;
+		memmove(&sorted[i], &sorted[i + 1], (n - i - 1) * sizeof(double));
+		n--;
+	} else
+		st->s.median.count++;
+
+	size_t i = n;
+	while (i > 0 && sorted[i - 1] > x) {
+		sorted[i] = sorted[i - 1];
+		i--;
+	}
+	sorted[i] = x;
+
+	st->s.median.window[st->s.median.next] = x;
+	st->s.median.next = (st->s.median.next + 1) % st->config.n;
+
+	n = st->s.median.count;
+	return n % 2 ? sorted[n / 2] : (sorted[n / 2 - 1] + sorted[n / 2]) / 2;
+
+}
+
+static double _gn_filter_avg(gn_filter_stage_t *st, double x) {
+
+	size_t next = st->s.avg.next;
+
+	if (st->s.avg.count == st->config.n)
+		st->s.avg.sum -= st->s.avg.window[next];
+	else
+		st->s.avg.count++;
+
+	st->s.avg.window[next] = x;
+	st->s.avg.sum += x;
+	st->s.avg.next = (next + 1) % st->config.n;
+
+	//the running sum is rebuilt once per window so that rounding errors do not pile up
+	if (st->s.avg.next == 0) {
+		st->s.avg.sum = 0;
+		for (size_t i = 0; i < st->s.avg.count; i++)
+			st->s.avg.sum += st->s.avg.window[i];
+	}
+
+	return st->s.avg.sum / st->s.avg.count;
+
+}
+
+/**
+ * @brief	runs a stage
+ *
+ * @return	false if the stage holds its previous output
+ */
+static bool _gn_filter_stage(gn_filter_stage_t *st, double *x, int64_t ts_us) {
+
+	bool primed = st->primed;
+	st->primed = true;
+
+	switch (st->config.type) {
+
+	case GN_FILTER_STAGE_MEDIAN:
+		*x = _gn_filter_median(st, *x);
+		break;
+
+	case GN_FILTER_STAGE_AVG:
+		*x = _gn_filter_avg(st, *x);
+		break;
+
+	case GN_FILTER_STAGE_EMA:
+		if (primed)
+			*x = st->s.smooth.y + st->config.a * (*x - st->s.smooth.y);
+		st->s.smooth.y = *x;
+		break;
+
+	case GN_FILTER_STAGE_RATE:
+		if (primed) {
+			double max_step = st->config.a * (ts_us - st->s.smooth.ts_us)
+					/ 1000000.0;
+			if (*x > st->s.smooth.y + max_step)
+				*x = st->s.smooth.y + max_step;
+			else if (*x < st->s.smooth.y - max_step)
+				*x = st->s.smooth.y - max_step;
+		}
+		st->s.smooth.y = *x;
+		st->s.smooth.ts_us = ts_us;
+		break;
+
+	case GN_FILTER_STAGE_KALMAN:
+		if (!primed) {
+			st->s.kalman.x = *x;
+			st->s.kalman.p = st->config.b;
+		} else {
+			double p = st->s.kalman.p + st->config.a;
+			double k = p / (p + st->config.b);
+			st->s.kalman.x += k * (*x - st->s.kalman.x);
+			st->s.kalman.p = (1 - k) * p;
+		}
+		*x = st->s.kalman.x;
+		break;
+
+	case GN_FILTER_STAGE_DELTA:
+		if (primed && fabs(*x - st->s.smooth.y) < st->config.a) {
+			*x = st->s.smooth.y;
+			return false;
+		}
+		st->s.smooth.y = *x;
+		break;
+
+	}
+
+	return true;
+
+}
+
+/**
+ * @brief	creates a filter. state is allocated here and never resized
+ *
+ * @param	tag		memory accounting tag
+ * @param	spec	stages of the filter, NULL or empty to pass the samples through
+ *
+ * @return	the filter, NULL if the spec is not valid or out of memory
+ */
+gn_filter_handle_t gn_filter_create(gn_mem_tag_t tag, const char *spec) {
+
+	gn_filter_handle_t filter = gn_mem_calloc(tag, 1, sizeof(struct gn_filter));
+	if (!filter)
+		return NULL;
+
+	if (gn_filter_configure(filter, spec ? spec : "") != GN_RET_OK) {
+		gn_mem_free(filter);
+		return NULL;
+	}
+
+	return filter;
+
+}
+
+/**
+ * @brief	replaces the stages of the filter and resets its state
+ *
+ * @return	GN_RET_OK if the filter is configured
+ * @return	GN_RET_ERR_INVALID_ARG if the spec is not valid, the filter is left unchanged
+ */
+gn_err_t gn_filter_configure(gn_filter_handle_t filter, const char *spec) {
+
+	gn_filter_stage_config_t configs[GN_FILTER_MAX_STAGES];
+	int count = _gn_filter_parse(spec, configs);
+
+	if (!filter || count < 0) {
+		ESP_LOGW(TAG, "invalid filter spec '%s'", spec ? spec : "");
+		return GN_RET_ERR_INVALID_ARG;
+	}
+
+	memset(filter->stages, 0, sizeof(filter->stages));
+	for (int i = 0; i < count; i++)
+		filter->stages[i].config = configs[i];
+	filter->count = count;
+	strcpy(filter->spec, spec);
+
+	ESP_LOGD(TAG, "filter configured: '%s', %d stages", spec, count);
+	return GN_RET_OK;
+
+}
+
+/**
+ * @brief	runs a sample through the stages
+ *
+ * @param	filter	the filter
+ * @param	in		the sample
+ * @param	ts_us	time of the sample, used by the rate stage
+ * @param	out		the filtered value
+ *
+ * @return	false if a delta stage holds the previous output, the value does not need to be published
+ * @return	false if the sample is NaN or infinite, it is dropped before reaching the stages
+ */
+bool gn_filter_update(gn_filter_handle_t filter, double in, int64_t ts_us,
+		double *out) {
+
+	//a failed reading would never leave the median window
+	if (!isfinite(in)) {
+		*out = filter->out;
+		return false;
+	}
+
+	bool changed = true;
+	for (size_t i = 0; i < filter->count && changed; i++)
+		changed = _gn_filter_stage(&filter->stages[i], &in, ts_us);
+
+	filter->out = in;
+	*out = in;
+	return changed;
+
+}
+
+/**
+ * @brief	drops the history of all the stages
+ */
+void gn_filter_reset(gn_filter_handle_t filter) {
+
+	for (size_t i = 0; i < filter->count; i++) {
+		gn_filter_stage_config_t config = filter->stages[i].config;
+		memset(&filter->stages[i], 0, sizeof(gn_filter_stage_t));
+		filter->stages[i].config = config;
+	}
+
+}
+
+void gn_filter_delete(gn_filter_handle_t filter) {
+	gn_mem_free(filter);
+}
+
+/**
+ * @brief	validator of the spec parameters, refuses specs that do not parse
+ */
+gn_leaf_param_validator_result_t gn_filter_validator(
+		gn_leaf_param_handle_t param, void **param_value) {
+
+	gn_filter_stage_config_t configs[GN_FILTER_MAX_STAGES];
+	const char *spec = *(char**) param_value;
+
+	if (_gn_filter_parse(spec, configs) < 0)
+		return GN_LEAF_PARAM_VALIDATOR_ERROR_NOT_ALLOWED;
+
+	return GN_LEAF_PARAM_VALIDATOR_PASSED;
+
+}
+
+/**
+ * @brief	creates a filter for a double parameter of the leaf, configured by a persisted string
+ * parameter named after it with GN_FILTER_PARAM_SUFFIX. to be called in the leaf configuration
+ * callback, the stored spec takes precedence over the one given
+ *
+ * @param	leaf_config	the leaf
+ * @param	param_name	the filtered parameter
+ * @param	spec		default spec
+ *
+ * @return	the filter, NULL in case of errors
+ */
+gn_filter_handle_t gn_filter_param_create(gn_leaf_handle_t leaf_config,
+		const char *param_name, const char *spec) {
+
+	if (!leaf_config || !param_name
+			|| strlen(param_name) + strlen(GN_FILTER_PARAM_SUFFIX)
+					>= GN_LEAF_PARAM_NAME_SIZE)
+		return NULL;
+
+	gn_filter_handle_t filter = gn_filter_create(
+			gn_leaf_get_mem_tag(leaf_config), spec);
+	if (!filter)
+		return NULL;
+
+	filter->leaf_config = leaf_config;
+	strcpy(filter->param_name, param_name);
+	strcpy(filter->spec_name, param_name);
+	strcat(filter->spec_name, GN_FILTER_PARAM_SUFFIX);
+
+	filter->spec_param = gn_leaf_param_create(leaf_config, filter->spec_name,
+			GN_VAL_TYPE_STRING, (gn_val_t ) { .s = (char*) filter->spec },
+			GN_LEAF_PARAM_ACCESS_ALL, GN_LEAF_PARAM_STORAGE_PERSISTED,
+			gn_filter_validator);
+	if (!filter->spec_param
+			|| gn_leaf_param_add_to_leaf(leaf_config, filter->spec_param)
+					!= GN_RET_OK) {
+		gn_filter_delete(filter);
+		return NULL;
+	}
+
+	return filter;
+
+}
+
+/**
+ * @brief	filters a reading and forces the parameter with the result, unless held by a delta stage.
+ * a change of the spec parameter is applied here, resetting the filter
+ *
+ * @param	filter	a filter created by gn_filter_param_create
+ * @param	raw		the reading
+ * @param	value	the filtered value, can be NULL
+ *
+ * @return	GN_RET_OK if the value is published or held
+ * @return	the error of gn_leaf_param_force_double otherwise
+ */
+gn_err_t gn_filter_param_update(gn_filter_handle_t filter, double raw,
+		double *value) {
+
+	if (!filter || !filter->spec_param)
+		return GN_RET_ERR_INVALID_ARG;
+
+	char spec[GN_FILTER_SPEC_SIZE];
+	if (gn_leaf_param_get_string(filter->leaf_config, filter->spec_name, spec,
+			sizeof(spec)) == GN_RET_OK) {
+		spec[sizeof(spec) - 1] = '\0';
+		if (strcmp(spec, filter->spec) != 0)
+			gn_filter_configure(filter, spec);
+	}
+
+	double out;
+	bool changed = gn_filter_update(filter, raw, esp_timer_get_time(), &out);
+	if (value)
+		*value = out;
+
+	if (!changed)
+		return GN_RET_OK;
+
+	return gn_leaf_param_force_double(filter->leaf_config, filter->param_name,
+			out);
+
+}
+
+/**
+ * @brief	applies a change request of the spec parameter coming from the network
+ *
+ * @return	true if the event was addressed to the spec parameter of the filter
+ */
+bool gn_filter_param_event(gn_filter_handle_t filter,
+		gn_leaf_parameter_event_handle_t evt) {
+
+	if (!filter || !filter->spec_param || !evt
+			|| gn_leaf_event_mask_param(evt, filter->spec_param) != 0)
+		return false;
+
+	char spec[GN_FILTER_SPEC_SIZE] = { 0 };
+	if (gn_event_payload_to_string(*evt, spec, sizeof(spec) - 1) == GN_RET_OK
+			&& gn_leaf_param_force_string(filter->leaf_config,
+					filter->spec_name, spec) != GN_RET_OK)
+		ESP_LOGW(TAG, "refused filter spec '%s' for %s", spec,
+				filter->param_name);
+
+	return true;
+
+}
+
+#ifdef __cplusplus
+}
+#endif //__cplusplus
@@ -0,0 +1,81 @@
+// Copyright 2021 Nicola Muratori (nicola.muratori@gmail.com)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef GN_FILTER_H_
+#define GN_FILTER_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "gn_commons.h"
+
+/*
+ * signal processing pipeline for double sensor parameters. a filter is a chain of stages
+ * configured by a spec string, stages separated by commas and arguments by colons:
+ *
+ *   median:N      median of the last N samples, N odd up to GN_FILTER_MEDIAN_MAX
+ *   avg:N         moving average of the last N samples, up to GN_FILTER_AVG_MAX
+ *   ema:A         exponential moving average, 0 < A <= 1 weight of the new sample
+ *   rate:R        output changes at most R units per second
+ *   kalman:Q:R    1-D kalman filter, Q process and R measurement noise variance
+ *   delta:D       holds the output until it moves by at least D, held values are not published
+ *
+ * eg. "median:5,ema:0.2,delta:0.5". an empty spec passes the samples through.
+ * state is allocated once with the filter, every sample costs constant time
+ */
+
+#define GN_FILTER_MAX_STAGES 4
+#define GN_FILTER_MEDIAN_MAX 9
+#define GN_FILTER_AVG_MAX 16
+#define GN_FILTER_SPEC_SIZE 64
+//suffix of the spec parameter created for the filtered parameter
+#define GN_FILTER_PARAM_SUFFIX "_filter"
+
+typedef struct gn_filter *gn_filter_handle_t;
+
+gn_filter_handle_t gn_filter_create(gn_mem_tag_t tag, const char *spec);
+
+gn_err_t gn_filter_configure(gn_filter_handle_t filter, const char *spec);
+
+bool gn_filter_update(gn_filter_handle_t filter, double in, int64_t ts_us,
+		double *out);
+
+void gn_filter_reset(gn_filter_handle_t filter);
+
+void gn_filter_delete(gn_filter_handle_t filter);
+
+gn_leaf_param_validator_result_t gn_filter_validator(
+		gn_leaf_param_handle_t param, void **param_value);
+
+//leaf parameters
+
+gn_filter_handle_t gn_filter_param_create(gn_leaf_handle_t leaf_config,
+		const char *param_name, const char *spec);
+
+gn_err_t gn_filter_param_update(gn_filter_handle_t filter, double raw,
+		double *value);
+
+bool gn_filter_param_event(gn_filter_handle_t filter,
+		gn_leaf_parameter_event_handle_t evt);
+
+#ifdef __cplusplus
+}
+#endif //__cplusplus
+
+#endif /* GN_FILTER_H_ */
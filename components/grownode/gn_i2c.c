@@ -0,0 +1,528 @@
+// Copyright 2021 Nicola Muratori (nicola.muratori@gmail.com)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdio.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "gn_i2c.h"
+
+#define TAG "gn_i2c"
+
+#define GN_I2C_TASK_STACK CONFIG_GROWNODE_I2C_STACK_SIZE
+//above the sampler, so that the batches submitted by the sensor jobs are served as soon as queued
+#define GN_I2C_TASK_PRIORITY 6
+
+typedef struct {
+	gn_i2c_op_t ops[GN_I2C_BATCH_MAX_OPS];
+	size_t count;
+	gn_i2c_batch_cb_t callback;
+	void *arg;
+	int64_t submitted_us;
+} gn_i2c_batch_t;
+
+struct gn_i2c_bus {
+	bool used;
+	i2c_port_t port;
+	int sda;
+	int scl;
+	SemaphoreHandle_t lock; /*!< held by the owner of the bus */
+	QueueHandle_t queue;
+	gn_i2c_batch_t pending[GN_I2C_QUEUE_SIZE]; /*!< batches of the current acquisition */
+	gn_i2c_bus_stats_t stats;
+};
+
+struct gn_i2c_device {
+	bool used;
+	struct gn_i2c_bus *bus;
+	i2c_dev_t *dev;
+	char name[GN_I2C_DEVICE_NAME_SIZE];
+	gn_i2c_device_stats_t stats;
+};
+
+static struct gn_i2c_bus _gn_i2c_buses[GN_I2C_MAX_BUSES];
+static struct gn_i2c_device _gn_i2c_devices[GN_I2C_MAX_DEVICES];
+
+static SemaphoreHandle_t _gn_i2c_mutex = NULL; /*!< registry and statistics */
+
+/**
+ * @brief	initializes the i2cdev library and the bus registry. called once by gn_init,
+ * 			before any leaf can get a bus
+ *
+ * @return	GN_RET_ERR if i2cdev cannot be initialized, buses cannot be used afterwards
+ */
+gn_err_t gn_i2c_init() {
+
+	if (_gn_i2c_mutex)
+		return GN_RET_OK;
+
+	if (i2cdev_init() != ESP_OK) {
+		ESP_LOGE(TAG, "i2cdev_init failed");
+		return GN_RET_ERR;
+	}
+
+	_gn_i2c_mutex = xSemaphoreCreateMutex();
+	return _gn_i2c_mutex ? GN_RET_OK : GN_RET_ERR;
+
+}
+
+static gn_err_t _gn_i2c_ops_check(struct gn_i2c_bus *bus,
+		const gn_i2c_op_t *ops, size_t count) {
+
+	if (!bus || !bus->used || !ops || count == 0
+			|| count > GN_I2C_BATCH_MAX_OPS)
+		return GN_RET_ERR_INVALID_ARG;
+
+	for (size_t i = 0; i < count; i++) {
+		const gn_i2c_op_t *op = &ops[i];
+		if (!op->device || !op->device->used || op->device->bus != bus)
+			return GN_RET_ERR_INVALID_ARG;
+		if (op->type == GN_I2C_OP_CALL ?
+				!op->call : (!op->buf || op->size == 0))
+			return GN_RET_ERR_INVALID_ARG;
+	}
+
+	return GN_RET_OK;
+
+}
+
+/**
+ * @brief	runs the operations in order, the bus must be owned by the caller
+ *
+ * @return	true if all the operations succeeded
+ */
+static bool _gn_i2c_ops_run(gn_i2c_op_t *ops, size_t count) {
+
+	bool ok = true;
+
+	for (size_t i = 0; i < count; i++) {
+
+		gn_i2c_op_t *op = &ops[i];
+		i2c_dev_t *dev = op->device->dev;
+		uint32_t retries = 0;
+		int64_t start = esp_timer_get_time();
+
+		if (op->type == GN_I2C_OP_CALL) {
+			//the driver takes the device mutex by itself
+			op->result = op->call(op->arg);
+		} else {
+			i2c_dev_take_mutex(dev);
+			while (true) {
+				op->result =
+						op->type == GN_I2C_OP_READ_REG ?
+								i2c_dev_read_reg(dev, op->reg, op->buf,
+										op->size) :
+								i2c_dev_write_reg(dev, op->reg, op->buf,
+										op->size);
+				if (op->result == ESP_OK || retries == GN_I2C_RETRIES)
+					break;
+				retries++;
+			}
+			i2c_dev_give_mutex(dev);
+		}
+
+		int64_t busy = esp_timer_get_time() - start;
+
+		xSemaphoreTake(_gn_i2c_mutex, portMAX_DELAY);
+		gn_i2c_device_stats_t *s = &op->device->stats;
+		s->transactions += 1 + retries;
+		s->retries += retries;
+		s->busy_us += busy;
+		if (op->result != ESP_OK)
+			s->errors++;
+		else if (op->type != GN_I2C_OP_CALL)
+			s->bytes += op->size;
+		xSemaphoreGive(_gn_i2c_mutex);
+
+		if (op->result != ESP_OK) {
+			ESP_LOGD(TAG, "%s - operation %d failed: %s", op->device->name,
+					op->type, esp_err_to_name(op->result));
+			ok = false;
+		}
+
+	}
+
+	return ok;
+
+}
+
+static void _gn_i2c_bus_task(void *arg) {
+
+	struct gn_i2c_bus *bus = (struct gn_i2c_bus*) arg;
+
+	while (true) {
+
+		if (xQueueReceive(bus->queue, &bus->pending[0], portMAX_DELAY)
+				!= pdTRUE)
+			continue;
+
+		xSemaphoreTake(bus->lock, portMAX_DELAY);
+		int64_t start = esp_timer_get_time();
+		int64_t wait_max = 0;
+
+		//batches queued meanwhile join the acquisition, up to a full queue
+		size_t n = 1;
+		for (size_t i = 0; i < n; i++) {
+			int64_t wait = esp_timer_get_time() - bus->pending[i].submitted_us;
+			if (wait > wait_max)
+				wait_max = wait;
+			_gn_i2c_ops_run(bus->pending[i].ops, bus->pending[i].count);
+			if (n < GN_I2C_QUEUE_SIZE
+					&& xQueueReceive(bus->queue, &bus->pending[n], 0) == pdTRUE)
+				n++;
+		}
+
+		int64_t busy = esp_timer_get_time() - start;
+		xSemaphoreGive(bus->lock);
+
+		xSemaphoreTake(_gn_i2c_mutex, portMAX_DELAY);
+		bus->stats.acquisitions++;
+		bus->stats.batches += n;
+		bus->stats.busy_us += busy;
+		if (wait_max > bus->stats.wait_max_us)
+			bus->stats.wait_max_us = wait_max;
+		xSemaphoreGive(_gn_i2c_mutex);
+
+		for (size_t i = 0; i < n; i++)
+			if (bus->pending[i].callback)
+				bus->pending[i].callback(bus->pending[i].ops,
+						bus->pending[i].count, bus->pending[i].arg);
+
+	}
+
+}
+
+/**
+ * @brief	returns the manager of the bus, creating it and its worker task on first use
+ *
+ * @param	port	i2c port
+ * @param	sda		sda gpio
+ * @param	scl		scl gpio
+ * @param	bus		the handle of the manager
+ *
+ * @return	GN_RET_OK if the manager is found or created
+ * @return	GN_RET_ERR_INVALID_ARG if the port or a pin is already used by a bus with different pins
+ * @return	GN_RET_ERR if GN_I2C_MAX_BUSES are already in use, i2c is not initialized or the worker cannot start
+ */
+gn_err_t gn_i2c_bus_get(i2c_port_t port, int sda, int scl,
+		gn_i2c_bus_handle_t *bus) {
+
+	if (!bus || sda < 0 || scl < 0 || sda == scl)
+		return GN_RET_ERR_INVALID_ARG;
+
+	if (!_gn_i2c_mutex)
+		return GN_RET_ERR;
+
+	gn_err_t ret = GN_RET_OK;
+	struct gn_i2c_bus *b = NULL;
+
+	xSemaphoreTake(_gn_i2c_mutex, portMAX_DELAY);
+
+	for (size_t i = 0; i < GN_I2C_MAX_BUSES; i++) {
+		struct gn_i2c_bus *e = &_gn_i2c_buses[i];
+		if (!e->used) {
+			if (!b)
+				b = e;
+			continue;
+		}
+		if (e->port == port && e->sda == sda && e->scl == scl) {
+			xSemaphoreGive(_gn_i2c_mutex);
+			*bus = e;
+			return GN_RET_OK;
+		}
+		if (e->port == port || e->sda == sda || e->sda == scl || e->scl == sda
+				|| e->scl == scl) {
+			ESP_LOGE(TAG,
+					"bus %d (sda %d, scl %d) conflicts with bus %d (sda %d, scl %d)",
+					port, sda, scl, e->port, e->sda, e->scl);
+			ret = GN_RET_ERR_INVALID_ARG;
+		}
+	}
+
+	if (ret == GN_RET_OK && b) {
+		memset(b, 0, sizeof(struct gn_i2c_bus));
+		b->port = port;
+		b->sda = sda;
+		b->scl = scl;
+		b->lock = xSemaphoreCreateMutex();
+		b->queue = xQueueCreate(GN_I2C_QUEUE_SIZE, sizeof(gn_i2c_batch_t));
+		b->stats.since_us = esp_timer_get_time();
+		char name[16];
+		snprintf(name, sizeof(name), "gn_i2c_%d", port);
+		if (b->lock && b->queue
+				&& xTaskCreate(_gn_i2c_bus_task, name, GN_I2C_TASK_STACK, b,
+						GN_I2C_TASK_PRIORITY, NULL) == pdPASS)
+			b->used = true;
+		else {
+			ESP_LOGE(TAG, "cannot start the worker of bus %d", port);
+			if (b->lock)
+				vSemaphoreDelete(b->lock);
+			if (b->queue)
+				vQueueDelete(b->queue);
+			ret = GN_RET_ERR;
+		}
+	} else if (ret == GN_RET_OK) {
+		ESP_LOGE(TAG, "gn_i2c_bus_get - no free buses");
+		ret = GN_RET_ERR;
+	}
+
+	xSemaphoreGive(_gn_i2c_mutex);
+
+	if (ret == GN_RET_OK) {
+		ESP_LOGD(TAG, "bus %d created, sda %d, scl %d", port, sda, scl);
+		*bus = b;
+	}
+	return ret;
+
+}
+
+/**
+ * @brief	registers a device descriptor initialized by its driver. the descriptor must stay valid
+ * and be on the port and pins of the bus. a device mutex is created if missing
+ *
+ * @param	bus		the bus of the device
+ * @param	dev		the driver descriptor
+ * @param	name	statistics key, usually the leaf name. it is copied
+ * @param	device	the handle to use in the operations
+ *
+ * @return	GN_RET_OK if the device is registered
+ * @return	GN_RET_ERR_INVALID_ARG if the descriptor is not on the bus
+ * @return	GN_RET_ERR if GN_I2C_MAX_DEVICES are already in use
+ */
+gn_err_t gn_i2c_device_add(gn_i2c_bus_handle_t bus, i2c_dev_t *dev,
+		const char *name, gn_i2c_device_handle_t *device) {
+
+	if (!bus || !bus->used || !dev || !device || dev->port != bus->port
+			|| dev->cfg.sda_io_num != bus->sda
+			|| dev->cfg.scl_io_num != bus->scl)
+		return GN_RET_ERR_INVALID_ARG;
+
+	if (!dev->mutex && i2c_dev_create_mutex(dev) != ESP_OK)
+		return GN_RET_ERR;
+
+	struct gn_i2c_device *d = NULL;
+
+	xSemaphoreTake(_gn_i2c_mutex, portMAX_DELAY);
+	for (size_t i = 0; i < GN_I2C_MAX_DEVICES; i++) {
+		if (!_gn_i2c_devices[i].used) {
+			d = &_gn_i2c_devices[i];
+			memset(d, 0, sizeof(struct gn_i2c_device));
+			d->used = true;
+			d->bus = bus;
+			d->dev = dev;
+			strncpy(d->name, name ? name : "device",
+					GN_I2C_DEVICE_NAME_SIZE - 1);
+			break;
+		}
+	}
+	xSemaphoreGive(_gn_i2c_mutex);
+
+	if (!d) {
+		ESP_LOGE(TAG, "gn_i2c_device_add - no free devices");
+		return GN_RET_ERR;
+	}
+
+	ESP_LOGD(TAG, "device %s added to bus %d, address 0x%02x", d->name,
+			bus->port, dev->addr);
+	*device = d;
+	return GN_RET_OK;
+
+}
+
+/**
+ * @brief	queues a batch behind the ones already submitted to the bus. the operations are copied,
+ * their buffers are used when the batch runs. call operations must not use the manager of the same bus
+ *
+ * @param	bus			the bus of the devices in ops
+ * @param	ops			operations, run in order
+ * @param	count		number of operations, up to GN_I2C_BATCH_MAX_OPS
+ * @param	callback	called with the results after the bus is released, can be NULL
+ * @param	arg			callback argument
+ *
+ * @return	GN_RET_OK if the batch is queued
+ * @return	GN_RET_ERR_INVALID_ARG if an operation is malformed or on another bus
+ * @return	GN_RET_ERR if GN_I2C_QUEUE_SIZE batches are already waiting
+ */
+gn_err_t gn_i2c_batch_submit(gn_i2c_bus_handle_t bus, const gn_i2c_op_t *ops,
+		size_t count, gn_i2c_batch_cb_t callback, void *arg) {
+
+	gn_err_t ret = _gn_i2c_ops_check(bus, ops, count);
+	if (ret != GN_RET_OK)
+		return ret;
+
+	gn_i2c_batch_t batch;
+	memcpy(batch.ops, ops, count * sizeof(gn_i2c_op_t));
+	batch.count = count;
+	batch.callback = callback;
+	batch.arg = arg;
+	batch.submitted_us = esp_timer_get_time();
+
+	if (xQueueSend(bus->queue, &batch, 0) != pdTRUE) {
+		xSemaphoreTake(_gn_i2c_mutex, portMAX_DELAY);
+		bus->stats.rejected++;
+		xSemaphoreGive(_gn_i2c_mutex);
+		return GN_RET_ERR;
+	}
+
+	return GN_RET_OK;
+
+}
+
+/**
+ * @brief	runs a batch in the calling task, acquiring the bus as the worker does. meant for
+ * high rate readers that cannot wait for the queue. results are stored in ops
+ *
+ * @return	GN_RET_OK if all the operations succeeded
+ * @return	GN_RET_ERR_INVALID_ARG if an operation is malformed or on another bus
+ * @return	GN_RET_ERR if an operation failed
+ */
+gn_err_t gn_i2c_batch_run(gn_i2c_bus_handle_t bus, gn_i2c_op_t *ops,
+		size_t count) {
+
+	gn_err_t ret = _gn_i2c_ops_check(bus, ops, count);
+	if (ret != GN_RET_OK)
+		return ret;
+
+	xSemaphoreTake(bus->lock, portMAX_DELAY);
+	int64_t start = esp_timer_get_time();
+	bool ok = _gn_i2c_ops_run(ops, count);
+	int64_t busy = esp_timer_get_time() - start;
+	xSemaphoreGive(bus->lock);
+
+	xSemaphoreTake(_gn_i2c_mutex, portMAX_DELAY);
+	bus->stats.acquisitions++;
+	bus->stats.batches++;
+	bus->stats.busy_us += busy;
+	xSemaphoreGive(_gn_i2c_mutex);
+
+	return ok ? GN_RET_OK : GN_RET_ERR;
+
+}
+
+gn_err_t gn_i2c_device_get_stats(gn_i2c_device_handle_t device,
+		gn_i2c_device_stats_t *stats) {
+
+	if (!device || !device->used || !stats)
+		return GN_RET_ERR_INVALID_ARG;
+
+	xSemaphoreTake(_gn_i2c_mutex, portMAX_DELAY);
+	*stats = device->stats;
+	xSemaphoreGive(_gn_i2c_mutex);
+
+	return GN_RET_OK;
+
+}
+
+gn_err_t gn_i2c_bus_get_stats(gn_i2c_bus_handle_t bus,
+		gn_i2c_bus_stats_t *stats) {
+
+	if (!bus || !bus->used || !stats)
+		return GN_RET_ERR_INVALID_ARG;
+
+	xSemaphoreTake(_gn_i2c_mutex, portMAX_DELAY);
+	*stats = bus->stats;
+	xSemaphoreGive(_gn_i2c_mutex);
+
+	return GN_RET_OK;
+
+}
+
+/**
+ * @brief	statistics of the buses and of their devices
+ *
+ * @return	a json object with an entry per bus, keyed by port, to be deleted by the caller
+ */
+cJSON* gn_i2c_stats_to_json() {
+
+	cJSON *root = cJSON_CreateObject();
+	if (!root || !_gn_i2c_mutex)
+		return root;
+
+	int64_t now = esp_timer_get_time();
+
+	xSemaphoreTake(_gn_i2c_mutex, portMAX_DELAY);
+
+	for (size_t i = 0; i < GN_I2C_MAX_BUSES; i++) {
+
+		struct gn_i2c_bus *b = &_gn_i2c_buses[i];
+		if (!b->used)
+			continue;
+
+		cJSON *bus = cJSON_CreateObject();
+		if (!bus)
+			break;
+		char key[8];
+		snprintf(key, sizeof(key), "%d", b->port);
+		cJSON_AddItemToObject(root, key, bus);
+
+		gn_i2c_bus_stats_t s = b->stats;
+		int64_t elapsed = now - s.since_us;
+		cJSON_AddNumberToObject(bus, "sda", b->sda);
+		cJSON_AddNumberToObject(bus, "scl", b->scl);
+		cJSON_AddNumberToObject(bus, "acquisitions", s.acquisitions);
+		cJSON_AddNumberToObject(bus, "batches", s.batches);
+		cJSON_AddNumberToObject(bus, "rejected", s.rejected);
+		cJSON_AddNumberToObject(bus, "busy_us", s.busy_us);
+		cJSON_AddNumberToObject(bus, "utilization",
+				elapsed > 0 ? 100.0 * s.busy_us / elapsed : 0);
+		cJSON_AddNumberToObject(bus, "wait_max_us", s.wait_max_us);
+
+		cJSON *devices = cJSON_CreateObject();
+		if (!devices)
+			break;
+		cJSON_AddItemToObject(bus, "devices", devices);
+
+		for (size_t j = 0; j < GN_I2C_MAX_DEVICES; j++) {
+
+			struct gn_i2c_device *d = &_gn_i2c_devices[j];
+			if (!d->used || d->bus != b)
+				continue;
+
+			cJSON *device = cJSON_CreateObject();
+			if (!device)
+				break;
+			cJSON_AddItemToObject(devices, d->name, device);
+
+			cJSON_AddNumberToObject(device, "address", d->dev->addr);
+			cJSON_AddNumberToObject(device, "transactions",
+					d->stats.transactions);
+			cJSON_AddNumberToObject(device, "bytes", d->stats.bytes);
+			cJSON_AddNumberToObject(device, "retries", d->stats.retries);
+			cJSON_AddNumberToObject(device, "errors", d->stats.errors);
+			cJSON_AddNumberToObject(device, "busy_us", d->stats.busy_us);
+
+		}
+
+	}
+
+	xSemaphoreGive(_gn_i2c_mutex);
+
+	return root;
+
+}
+
+#ifdef __cplusplus
+}
+#endif //__cplusplus
@@ -0,0 +1,119 @@
+// Copyright 2021 Nicola Muratori (nicola.muratori@gmail.com)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef GN_I2C_H_
+#define GN_I2C_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "sdkconfig.h"
+#include "cJSON.h"
+#include "i2cdev.h"
+#include "gn_commons.h"
+
+/*
+ * i2c bus manager: one manager per bus, keyed by port and pins, owns the bus on behalf of the
+ * leaves. leaves submit batches of register transactions or driver calls, queued in arrival order
+ * and run by the worker task of the bus. all the batches waiting when the worker acquires the bus
+ * are run back to back in the same acquisition, and their completion callbacks are called once
+ * the bus is released. every device keeps transaction, retry, error and bus time statistics
+ */
+
+#define GN_I2C_MAX_BUSES 2
+#define GN_I2C_MAX_DEVICES 16
+#define GN_I2C_DEVICE_NAME_SIZE 32
+#define GN_I2C_BATCH_MAX_OPS 6
+#define GN_I2C_QUEUE_SIZE 8
+//attempts after the first for a failed register transaction
+#define GN_I2C_RETRIES 2
+
+typedef struct gn_i2c_bus *gn_i2c_bus_handle_t;
+
+typedef struct gn_i2c_device *gn_i2c_device_handle_t;
+
+typedef enum {
+	GN_I2C_OP_READ_REG, /*!< reads size bytes from reg into buf */
+	GN_I2C_OP_WRITE_REG, /*!< writes size bytes from buf into reg */
+	GN_I2C_OP_CALL, /*!< calls a driver function owning the bus. never retried */
+} gn_i2c_op_type_t;
+
+typedef esp_err_t (*gn_i2c_call_t)(void *arg);
+
+typedef struct {
+	gn_i2c_op_type_t type;
+	gn_i2c_device_handle_t device;
+	uint8_t reg;
+	void *buf; /*!< must stay valid until the batch completes */
+	size_t size;
+	gn_i2c_call_t call;
+	void *arg;
+	esp_err_t result; /*!< set when the batch completes */
+} gn_i2c_op_t;
+
+/**
+ * @brief	called by the bus worker after the bus is released, with the results in ops
+ */
+typedef void (*gn_i2c_batch_cb_t)(const gn_i2c_op_t *ops, size_t count,
+		void *arg);
+
+typedef struct {
+	uint32_t transactions; /*!< attempts of the operations, a call counts as one */
+	uint64_t bytes;
+	uint32_t retries;
+	uint32_t errors; /*!< operations failed after the retries */
+	int64_t busy_us; /*!< bus time spent by the operations of the device */
+} gn_i2c_device_stats_t;
+
+typedef struct {
+	uint32_t acquisitions;
+	uint32_t batches;
+	uint32_t rejected; /*!< batches submitted with the queue full */
+	int64_t busy_us; /*!< time the bus has been owned */
+	int64_t wait_max_us; /*!< longest time a batch waited in the queue */
+	int64_t since_us; /*!< creation time of the manager */
+} gn_i2c_bus_stats_t;
+
+gn_err_t gn_i2c_init();
+
+gn_err_t gn_i2c_bus_get(i2c_port_t port, int sda, int scl,
+		gn_i2c_bus_handle_t *bus);
+
+gn_err_t gn_i2c_device_add(gn_i2c_bus_handle_t bus, i2c_dev_t *dev,
+		const char *name, gn_i2c_device_handle_t *device);
+
+gn_err_t gn_i2c_batch_submit(gn_i2c_bus_handle_t bus, const gn_i2c_op_t *ops,
+		size_t count, gn_i2c_batch_cb_t callback, void *arg);
+
+gn_err_t gn_i2c_batch_run(gn_i2c_bus_handle_t bus, gn_i2c_op_t *ops,
+		size_t count);
+
+gn_err_t gn_i2c_device_get_stats(gn_i2c_device_handle_t device,
+		gn_i2c_device_stats_t *stats);
+
+gn_err_t gn_i2c_bus_get_stats(gn_i2c_bus_handle_t bus,
+		gn_i2c_bus_stats_t *stats);
+
+cJSON* gn_i2c_stats_to_json();
+
+#ifdef __cplusplus
+}
+#endif //__cplusplus
+
+#endif /* GN_I2C_H_ */
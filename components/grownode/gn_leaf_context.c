@@ -16,15 +16,6 @@
 extern "C" {
 #endif
 
-/*
- #include <stddef.h>
- #include <stdio.h>
- #include <stdlib.h>
- #include <string.h>
- #include <limits.h>
- */
-
-#include <stdarg.h>
 #include <stddef.h>
 #include <stdlib.h>
 #include <stdint.h>
@@ -32,107 +23,275 @@ extern "C" {
 #include <string.h>
 
 #include "gn_leaf_context.h"
+#include "gn_mem.h"
 #include "esp_log.h"
 
-//#include "hasht.h"
-#include "cc_hashtable.h"
-
 #define TAG "gn_leaf_context"
 
-typedef struct CC_HashTable *gn_leaf_context_handle_int_t;
+//entries are indexed by 16 bit slots, 0 marks an empty slot
+#define GN_LEAF_CONTEXT_MAX_CAPACITY 0x7fff
 
+/*
+ * entries are kept in insertion order in a single array, so that the index of an entry is
+ * its position. lookups go through an open addressing table of entry positions with linear
+ * probing, sized at least twice the capacity. a delete compacts the entries and rebuilds
+ * the slots, contexts are written at startup and then mostly read.
+ */
 
-gn_leaf_context_handle_t gn_leaf_context_create() {
+typedef struct {
+	uint32_t hash;
+	uint32_t len;
+	void *value;
+	union {
+		char s[GN_LEAF_CONTEXT_KEY_SIZE]; /*!< keys shorter than GN_LEAF_CONTEXT_KEY_SIZE */
+		const char *p; /*!< longer keys, owned by the caller */
+	} key;
+} gn_leaf_context_entry_t;
+
+typedef struct {
+	size_t size;
+	size_t capacity;
+	size_t mask; /*!< number of slots - 1 */
+	gn_leaf_context_entry_t *entries; /*!< followed by the slots in the same block */
+	uint16_t *slots; /*!< position + 1 of the entry, 0 if empty */
+} gn_leaf_context_t;
+
+typedef gn_leaf_context_t *gn_leaf_context_handle_int_t;
+
+//FNV-1a
+static inline uint32_t _gn_leaf_context_hash(const char *key, size_t *len) {
+
+	uint32_t hash = 2166136261u;
+	const char *c = key;
+	while (*c) {
+		hash ^= (uint8_t) *c++;
+		hash *= 16777619u;
+	}
+	*len = c - key;
+	return hash;
 
-	CC_HashTable * string_table;
-	CC_HashTableConf config;
-	cc_hashtable_conf_init(&config);
-	config.key_length = KEY_LENGTH_VARIABLE;
-	config.hash = STRING_HASH;
-	config.key_compare = CC_CMP_STRING;
-	enum cc_stat status = cc_hashtable_new_conf(&config, &string_table);
-	if (status != CC_OK)
+}
+
+static inline const char* _gn_leaf_context_key(
+		const gn_leaf_context_entry_t *entry) {
+	return entry->len < GN_LEAF_CONTEXT_KEY_SIZE ? entry->key.s : entry->key.p;
+}
+
+/**
+ * @brief	looks for a key
+ *
+ * @param	slot	set to the slot of the entry, or to the free slot where it would go
+ *
+ * @return	the position of the entry, -1 if not found
+ */
+static long _gn_leaf_context_find(gn_leaf_context_handle_int_t ctx,
+		const char *key, uint32_t hash, size_t len, size_t *slot) {
+
+	size_t i = hash & ctx->mask;
+	while (ctx->slots[i] != 0) {
+		gn_leaf_context_entry_t *entry = &ctx->entries[ctx->slots[i] - 1];
+		if (entry->hash == hash && entry->len == len
+				&& memcmp(_gn_leaf_context_key(entry), key, len) == 0) {
+			*slot = i;
+			return ctx->slots[i] - 1;
+		}
+		i = (i + 1) & ctx->mask;
+	}
+	*slot = i;
+	return -1;
+
+}
+
+static void _gn_leaf_context_reindex(gn_leaf_context_handle_int_t ctx) {
+
+	memset(ctx->slots, 0, (ctx->mask + 1) * sizeof(uint16_t));
+	for (size_t pos = 0; pos < ctx->size; pos++) {
+		size_t i = ctx->entries[pos].hash & ctx->mask;
+		while (ctx->slots[i] != 0)
+			i = (i + 1) & ctx->mask;
+		ctx->slots[i] = pos + 1;
+	}
+
+}
+
+/**
+ * @brief	allocates entries and slots for a capacity, moving the current entries
+ */
+static bool _gn_leaf_context_alloc(gn_leaf_context_handle_int_t ctx,
+		size_t capacity) {
+
+	if (capacity > GN_LEAF_CONTEXT_MAX_CAPACITY)
+		return false;
+
+	size_t slots = 1;
+	while (slots < capacity * 2)
+		slots <<= 1;
+
+	gn_leaf_context_entry_t *entries = gn_mem_malloc(GN_MEM_TAG_CORE,
+			capacity * sizeof(gn_leaf_context_entry_t)
+					+ slots * sizeof(uint16_t));
+	if (!entries)
+		return false;
+
+	if (ctx->entries) {
+		memcpy(entries, ctx->entries,
+				ctx->size * sizeof(gn_leaf_context_entry_t));
+		gn_mem_free(ctx->entries);
+	}
+
+	ctx->entries = entries;
+	ctx->slots = (uint16_t*) (entries + capacity);
+	ctx->capacity = capacity;
+	ctx->mask = slots - 1;
+	_gn_leaf_context_reindex(ctx);
+	return true;
+
+}
+
+/**
+ * @brief	creates a context
+ *
+ * @param	capacity	entries expected. the context doubles its capacity when full
+ *
+ * @return	the context, NULL if out of memory
+ */
+gn_leaf_context_handle_t gn_leaf_context_create(size_t capacity) {
+
+	gn_leaf_context_handle_int_t ctx = gn_mem_calloc(GN_MEM_TAG_CORE, 1,
+			sizeof(gn_leaf_context_t));
+	if (!ctx)
 		return NULL;
-	return (gn_leaf_context_handle_int_t)string_table;
+
+	if (!_gn_leaf_context_alloc(ctx, capacity > 0 ? capacity : 1)) {
+		gn_mem_free(ctx);
+		return NULL;
+	}
+	return ctx;
 
 }
 
 size_t gn_leaf_context_size(gn_leaf_context_handle_t context) {
-	return cc_hashtable_size(context);
+	return ((gn_leaf_context_handle_int_t) context)->size;
 }
 
 void gn_leaf_context_destroy(gn_leaf_context_handle_t context) {
-    cc_hashtable_remove_all(context);
-	cc_hashtable_destroy(context);
+
+	gn_leaf_context_handle_int_t ctx = context;
+	if (!ctx)
+		return;
+	gn_mem_free(ctx->entries);
+	gn_mem_free(ctx);
+
 }
 
 void gn_leaf_context_print(gn_leaf_context_handle_t context) {
 
-    /* Define and initialize the iterator. */
-    CC_HashTableIter iterator;
-    cc_hashtable_iter_init(&iterator, context);
+	gn_leaf_context_handle_int_t ctx = context;
 
-    /* Define pair entry output. */
-    TableEntry *next_entry;
 	ESP_LOGI(TAG, "----- HASHTABLE START ------");
-    while (cc_hashtable_iter_next(&iterator, &next_entry) != CC_ITER_END) {
-        ESP_LOGI(TAG, "K: %s, V: %s", (char*) next_entry->key, (char*) next_entry->value);
-    }
+	for (size_t pos = 0; pos < ctx->size; pos++) {
+		ESP_LOGI(TAG, "K: %s, V: %p",
+				_gn_leaf_context_key(&ctx->entries[pos]),
+				ctx->entries[pos].value);
+	}
 	ESP_LOGI(TAG, "------ HASHTABLE END -------");
+
 }
 
+/**
+ * @brief	key of the entry at a position, in insertion order
+ */
 char* gn_leaf_context_get_key_at(gn_leaf_context_handle_t context,
 		size_t index) {
 
-	size_t size = cc_hashtable_size(context);
-	if (index >= size)
+	gn_leaf_context_handle_int_t ctx = context;
+	if (index >= ctx->size)
 		return NULL;
-
-    /* Define and initialize the iterator. */
-    CC_HashTableIter iterator;
-    cc_hashtable_iter_init(&iterator, context);
-
-    int i = 0;
-    /* Define pair entry output. */
-    TableEntry *next_entry;
-    while (cc_hashtable_iter_next(&iterator, &next_entry) != CC_ITER_END) {
-    	if (i == index)
-    		return (char*) next_entry->key;
-    }
-    return NULL;
+	return (char*) _gn_leaf_context_key(&ctx->entries[index]);
 
 }
 
-
 void* gn_leaf_context_get(gn_leaf_context_handle_t context, char *key) {
 
-	void* out = NULL;
-	enum cc_stat ret = cc_hashtable_get(context, key, &out);
-	if (ret == CC_OK)
-		return out;
-	return NULL;
+	gn_leaf_context_handle_int_t ctx = context;
+	if (!key)
+		return NULL;
+
+	size_t len, slot;
+	uint32_t hash = _gn_leaf_context_hash(key, &len);
+	long pos = _gn_leaf_context_find(ctx, key, hash, len, &slot);
+	return pos < 0 ? NULL : ctx->entries[pos].value;
+
 }
 
+/**
+ * @brief	adds an entry or replaces the value of an existing one
+ *
+ * @return	the stored key, NULL if the context cannot grow
+ */
 void* gn_leaf_context_set(gn_leaf_context_handle_t context, char *key,
 		void *value) {
 
-	enum cc_stat stat = cc_hashtable_add(context,  (void*) key,  (void*) value);
-	if (stat == CC_OK)
-		return key;
-	else
+	gn_leaf_context_handle_int_t ctx = context;
+	if (!key)
 		return NULL;
 
+	size_t len, slot;
+	uint32_t hash = _gn_leaf_context_hash(key, &len);
+	long pos = _gn_leaf_context_find(ctx, key, hash, len, &slot);
+
+	if (pos < 0) {
+		if (ctx->size == ctx->capacity) {
+			if (!_gn_leaf_context_alloc(ctx, ctx->capacity * 2)) {
+				ESP_LOGE(TAG, "cannot grow context to %d entries",
+						(int) ctx->capacity * 2);
+				return NULL;
+			}
+			_gn_leaf_context_find(ctx, key, hash, len, &slot);
+		}
+		pos = ctx->size++;
+		ctx->slots[slot] = pos + 1;
+		ctx->entries[pos].hash = hash;
+		ctx->entries[pos].len = len;
+	}
+
+	gn_leaf_context_entry_t *entry = &ctx->entries[pos];
+	if (len < GN_LEAF_CONTEXT_KEY_SIZE)
+		memcpy(entry->key.s, key, len + 1);
+	else
+		entry->key.p = key;
+	entry->value = value;
+
+	return (void*) _gn_leaf_context_key(entry);
+
 }
 
+/**
+ * @brief	removes an entry. later entries move one position down
+ *
+ * @return	the value of the entry, NULL if not found
+ */
 void* gn_leaf_context_delete(gn_leaf_context_handle_t context, char *key) {
-	void* oldv = NULL;
-	enum cc_stat ret = cc_hashtable_remove(context,  (void*) key, &oldv);
-	if (ret == CC_OK)
-		return oldv;
-	return NULL;
-}
 
+	gn_leaf_context_handle_int_t ctx = context;
+	if (!key)
+		return NULL;
+
+	size_t len, slot;
+	uint32_t hash = _gn_leaf_context_hash(key, &len);
+	long pos = _gn_leaf_context_find(ctx, key, hash, len, &slot);
+	if (pos < 0)
+		return NULL;
 
+	void *value = ctx->entries[pos].value;
+	memmove(&ctx->entries[pos], &ctx->entries[pos + 1],
+			(ctx->size - pos - 1) * sizeof(gn_leaf_context_entry_t));
+	ctx->size--;
+	_gn_leaf_context_reindex(ctx);
+
+	return value;
+
+}
 
 #ifdef __cplusplus
 }
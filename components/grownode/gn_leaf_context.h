@@ -18,9 +18,17 @@
 #include <stddef.h>
 #include <stdbool.h>
 
+/*
+ * string keyed map with insertion ordered entries. keys shorter than
+ * GN_LEAF_CONTEXT_KEY_SIZE are copied, longer keys are referenced and must
+ * outlive the entry. values are never copied
+ */
+
+#define GN_LEAF_CONTEXT_KEY_SIZE 24
+
 typedef void *gn_leaf_context_handle_t;
 
-gn_leaf_context_handle_t gn_leaf_context_create();
+gn_leaf_context_handle_t gn_leaf_context_create(size_t capacity);
 
 size_t gn_leaf_context_size(gn_leaf_context_handle_t context);
 
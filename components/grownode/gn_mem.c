@@ -0,0 +1,397 @@
+// Copyright 2021 Nicola Muratori (nicola.muratori@gmail.com)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "freertos/FreeRTOS.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "gn_mem.h"
+
+#ifdef CONFIG_GROWNODE_MEM_ACCOUNTING
+
+#define TAG "gn_mem"
+
+#define _GN_MEM_MAGIC 0x676e
+
+//in front of each allocation. 16 bytes, so the malloc alignment is kept
+typedef struct {
+	uint32_t size;
+	uint16_t magic;
+	gn_mem_tag_t tag;
+	uint8_t reserved;
+	int64_t at; /*!< allocation time, us since boot */
+} _gn_mem_hdr_t;
+
+static portMUX_TYPE _gn_mem_mux = portMUX_INITIALIZER_UNLOCKED;
+
+static gn_mem_stats_t _gn_mem_stats[GN_MEM_TAG_MAX] = {
+		[GN_MEM_TAG_CORE] = { .name = "core" }, [GN_MEM_TAG_PARAMS] = {
+				.name = "params" }, [GN_MEM_TAG_MQTT] = { .name = "mqtt" },
+		[GN_MEM_TAG_HOMIE] = { .name = "homie" }, [GN_MEM_TAG_DISPLAY] = {
+				.name = "display" }, [GN_MEM_TAG_LEAF] = { .name = "leaf" } };
+
+static size_t _gn_mem_tags = GN_MEM_TAG_BUILTIN_MAX;
+
+static int64_t _gn_mem_reset_us = 0;
+
+static size_t _gn_mem_lifetime_bucket(int64_t us) {
+
+	int64_t ms = us / 1000;
+	size_t bucket = 0;
+	while (ms > 0 && bucket < GN_MEM_LIFETIME_BUCKETS - 1) {
+		ms >>= 2;
+		bucket++;
+	}
+	return bucket;
+
+}
+
+static inline gn_mem_tag_t _gn_mem_tag_check(gn_mem_tag_t tag) {
+	return tag < _gn_mem_tags ? tag : GN_MEM_TAG_LEAF;
+}
+
+/**
+ * @brief	moves the live bytes of a tag from a size to another, checking the budget when growing
+ *
+ * @param	count	1 for a new allocation, -1 to roll one back, 0 for a resize
+ *
+ * @return	false if the budget does not allow it
+ */
+static bool _gn_mem_account(gn_mem_tag_t tag, size_t from, size_t to,
+		int count) {
+
+	bool ret = true;
+
+	portENTER_CRITICAL(&_gn_mem_mux);
+	gn_mem_stats_t *s = &_gn_mem_stats[tag];
+	if (to > from && s->budget && s->live_bytes + (to - from) > s->budget) {
+		s->denied++;
+		ret = false;
+	} else {
+		s->live_bytes = s->live_bytes - from + to;
+		s->live_count += count;
+		if (count > 0)
+			s->allocs++;
+		else if (count < 0)
+			s->allocs--;
+		if (s->live_bytes > s->peak_bytes)
+			s->peak_bytes = s->live_bytes;
+	}
+	portEXIT_CRITICAL(&_gn_mem_mux);
+
+	return ret;
+
+}
+
+static void* _gn_mem_track(_gn_mem_hdr_t *hdr, gn_mem_tag_t tag, size_t size) {
+
+	if (!hdr) {
+		_gn_mem_account(tag, size, 0, -1);
+		return NULL;
+	}
+
+	hdr->size = size;
+	hdr->magic = _GN_MEM_MAGIC;
+	hdr->tag = tag;
+	hdr->at = esp_timer_get_time();
+	return hdr + 1;
+
+}
+
+static _gn_mem_hdr_t* _gn_mem_hdr(void *ptr) {
+
+	_gn_mem_hdr_t *hdr = (_gn_mem_hdr_t*) ptr - 1;
+	if (hdr->magic != _GN_MEM_MAGIC) {
+		ESP_LOGE(TAG, "%p not allocated by gn_mem or already released", ptr);
+		return NULL;
+	}
+	return hdr;
+
+}
+
+/**
+ * @brief	gets the tag of a subsystem, creating it if not existing
+ *
+ * @param	name	the subsystem name, eg. leaf:<leaf name>
+ *
+ * @return	the tag, GN_MEM_TAG_LEAF if there is no room for new tags
+ */
+gn_mem_tag_t gn_mem_tag_register(const char *name) {
+
+	gn_mem_tag_t ret = GN_MEM_TAG_LEAF;
+	bool found = false;
+
+	portENTER_CRITICAL(&_gn_mem_mux);
+	for (size_t i = 0; i < _gn_mem_tags && !found; i++) {
+		if (strncmp(_gn_mem_stats[i].name, name, GN_MEM_TAG_NAME_SIZE - 1)
+				== 0) {
+			ret = i;
+			found = true;
+		}
+	}
+	if (!found && _gn_mem_tags < GN_MEM_TAG_MAX) {
+		strncpy(_gn_mem_stats[_gn_mem_tags].name, name,
+				GN_MEM_TAG_NAME_SIZE - 1);
+		ret = _gn_mem_tags++;
+		found = true;
+	}
+	portEXIT_CRITICAL(&_gn_mem_mux);
+
+	if (!found)
+		ESP_LOGW(TAG, "no room for tag %s, accounted as %s", name,
+				_gn_mem_stats[GN_MEM_TAG_LEAF].name);
+
+	return ret;
+
+}
+
+/**
+ * @brief	limits the live bytes of a tag. allocations beyond the budget fail as out of memory
+ *
+ * @param	tag		the tag to limit
+ * @param	budget	bytes, 0 to remove the limit
+ */
+void gn_mem_set_budget(gn_mem_tag_t tag, size_t budget) {
+
+	tag = _gn_mem_tag_check(tag);
+	portENTER_CRITICAL(&_gn_mem_mux);
+	_gn_mem_stats[tag].budget = budget;
+	portEXIT_CRITICAL(&_gn_mem_mux);
+
+}
+
+void* gn_mem_malloc(gn_mem_tag_t tag, size_t size) {
+
+	tag = _gn_mem_tag_check(tag);
+	if (!_gn_mem_account(tag, 0, size, 1))
+		return NULL;
+	return _gn_mem_track(malloc(sizeof(_gn_mem_hdr_t) + size), tag, size);
+
+}
+
+void* gn_mem_caps_malloc(gn_mem_tag_t tag, size_t size, uint32_t caps) {
+
+	tag = _gn_mem_tag_check(tag);
+	if (!_gn_mem_account(tag, 0, size, 1))
+		return NULL;
+	return _gn_mem_track(heap_caps_malloc(sizeof(_gn_mem_hdr_t) + size, caps),
+			tag, size);
+
+}
+
+void* gn_mem_calloc(gn_mem_tag_t tag, size_t n, size_t size) {
+
+	if (size && n > SIZE_MAX / size)
+		return NULL;
+
+	tag = _gn_mem_tag_check(tag);
+	if (!_gn_mem_account(tag, 0, n * size, 1))
+		return NULL;
+	return _gn_mem_track(calloc(1, sizeof(_gn_mem_hdr_t) + n * size), tag,
+			n * size);
+
+}
+
+/**
+ * @brief	resizes an allocation. the memory stays accounted to the tag it was allocated with
+ */
+void* gn_mem_realloc(gn_mem_tag_t tag, void *ptr, size_t size) {
+
+	if (!ptr)
+		return gn_mem_malloc(tag, size);
+
+	if (size == 0) {
+		gn_mem_free(ptr);
+		return NULL;
+	}
+
+	_gn_mem_hdr_t *hdr = _gn_mem_hdr(ptr);
+	if (!hdr)
+		return NULL;
+
+	gn_mem_tag_t owner = hdr->tag;
+	size_t old_size = hdr->size;
+	if (!_gn_mem_account(owner, old_size, size, 0))
+		return NULL;
+
+	_gn_mem_hdr_t *resized = realloc(hdr, sizeof(_gn_mem_hdr_t) + size);
+	if (!resized) {
+		_gn_mem_account(owner, size, old_size, 0);
+		return NULL;
+	}
+
+	resized->size = size;
+	return resized + 1;
+
+}
+
+char* gn_mem_strdup(gn_mem_tag_t tag, const char *s) {
+
+	size_t len = strlen(s) + 1;
+	char *ret = gn_mem_malloc(tag, len);
+	if (ret)
+		memcpy(ret, s, len);
+	return ret;
+
+}
+
+void gn_mem_free(void *ptr) {
+
+	if (!ptr)
+		return;
+
+	_gn_mem_hdr_t *hdr = _gn_mem_hdr(ptr);
+	if (!hdr)
+		return;
+
+	hdr->magic = 0;
+	size_t bucket = _gn_mem_lifetime_bucket(esp_timer_get_time() - hdr->at);
+
+	portENTER_CRITICAL(&_gn_mem_mux);
+	gn_mem_stats_t *s = &_gn_mem_stats[hdr->tag];
+	s->live_bytes -= hdr->size;
+	s->live_count--;
+	s->frees++;
+	s->lifetime[bucket]++;
+	portEXIT_CRITICAL(&_gn_mem_mux);
+
+	free(hdr);
+
+}
+
+/**
+ * @brief	copies the statistics of a tag
+ */
+void gn_mem_get_stats(gn_mem_tag_t tag, gn_mem_stats_t *stats) {
+
+	if (!stats)
+		return;
+
+	tag = _gn_mem_tag_check(tag);
+	portENTER_CRITICAL(&_gn_mem_mux);
+	*stats = _gn_mem_stats[tag];
+	portEXIT_CRITICAL(&_gn_mem_mux);
+
+}
+
+static double _gn_mem_rate(const gn_mem_stats_t *s) {
+
+	int64_t elapsed_us = esp_timer_get_time() - _gn_mem_reset_us;
+	return elapsed_us > 0 ? s->allocs * 1000000.0 / elapsed_us : 0;
+
+}
+
+/**
+ * @brief	statistics of the tags that have been used
+ *
+ * @return	a json object with an entry per tag, to be deleted by the caller
+ */
+cJSON* gn_mem_stats_to_json() {
+
+	cJSON *root = cJSON_CreateObject();
+	if (!root)
+		return NULL;
+
+	for (size_t i = 0; i < _gn_mem_tags; i++) {
+
+		gn_mem_stats_t s;
+		gn_mem_get_stats(i, &s);
+		if (s.allocs == 0 && s.live_count == 0)
+			continue;
+
+		cJSON *tag = cJSON_CreateObject();
+		if (!tag)
+			break;
+		cJSON_AddItemToObject(root, s.name, tag);
+
+		cJSON_AddNumberToObject(tag, "live", s.live_bytes);
+		cJSON_AddNumberToObject(tag, "peak", s.peak_bytes);
+		cJSON_AddNumberToObject(tag, "blocks", s.live_count);
+		cJSON_AddNumberToObject(tag, "allocs", s.allocs);
+		cJSON_AddNumberToObject(tag, "frees", s.frees);
+		cJSON_AddNumberToObject(tag, "rate", _gn_mem_rate(&s));
+		if (s.budget) {
+			cJSON_AddNumberToObject(tag, "budget", s.budget);
+			cJSON_AddNumberToObject(tag, "denied", s.denied);
+		}
+
+		cJSON *lifetime = cJSON_CreateArray();
+		if (!lifetime)
+			continue;
+		for (size_t b = 0; b < GN_MEM_LIFETIME_BUCKETS; b++)
+			cJSON_AddItemToArray(lifetime, cJSON_CreateNumber(s.lifetime[b]));
+		cJSON_AddItemToObject(tag, "lifetime", lifetime);
+
+	}
+
+	return root;
+
+}
+
+/**
+ * @brief	logs the statistics of the tags that have been used
+ */
+void gn_mem_dump() {
+
+	for (size_t i = 0; i < _gn_mem_tags; i++) {
+
+		gn_mem_stats_t s;
+		gn_mem_get_stats(i, &s);
+		if (s.allocs == 0 && s.live_count == 0)
+			continue;
+
+		char lifetime[GN_MEM_LIFETIME_BUCKETS * 11] = "";
+		size_t len = 0;
+		for (size_t b = 0; b < GN_MEM_LIFETIME_BUCKETS; b++)
+			len += snprintf(lifetime + len, sizeof(lifetime) - len,
+					b ? "/%u" : "%u", s.lifetime[b]);
+
+		ESP_LOGI(TAG,
+				"mem %s: live %u bytes in %u blocks, peak %u, %u allocs (%.1f/s), %u frees, %u denied - lifetime %s",
+				s.name, (unsigned ) s.live_bytes, s.live_count,
+				(unsigned ) s.peak_bytes, s.allocs, _gn_mem_rate(&s), s.frees,
+				s.denied, lifetime);
+
+	}
+
+}
+
+/**
+ * @brief	clears counters and histograms. live bytes are kept and become the peak
+ */
+void gn_mem_reset() {
+
+	int64_t now = esp_timer_get_time();
+
+	portENTER_CRITICAL(&_gn_mem_mux);
+	for (size_t i = 0; i < _gn_mem_tags; i++) {
+		gn_mem_stats_t *s = &_gn_mem_stats[i];
+		s->peak_bytes = s->live_bytes;
+		s->allocs = 0;
+		s->frees = 0;
+		s->denied = 0;
+		memset(s->lifetime, 0, sizeof(s->lifetime));
+	}
+	_gn_mem_reset_us = now;
+	portEXIT_CRITICAL(&_gn_mem_mux);
+
+}
+
+#endif /* CONFIG_GROWNODE_MEM_ACCOUNTING */
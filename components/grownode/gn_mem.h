@@ -0,0 +1,107 @@
+// Copyright 2021 Nicola Muratori (nicola.muratori@gmail.com)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef GN_MEM_H_
+#define GN_MEM_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sdkconfig.h"
+
+/*
+ * heap accounting by subsystem: allocations made through these wrappers are tagged and counted.
+ * memory from gn_mem_* must be released with gn_mem_free, and only that memory.
+ * without CONFIG_GROWNODE_MEM_ACCOUNTING the wrappers are the plain libc calls
+ */
+
+#define GN_MEM_TAG_NAME_SIZE 24
+
+//allocation lifetimes, in powers of 4 ms: <1 ms, <4 ms, <16 ms ... <17 min, longer
+#define GN_MEM_LIFETIME_BUCKETS 12
+
+typedef uint8_t gn_mem_tag_t;
+
+/**
+ * @brief	subsystems known at build time. leaves get their own tag when created
+ */
+enum {
+	GN_MEM_TAG_CORE = 0, /*!< node, leaves and events */
+	GN_MEM_TAG_PARAMS, /*!< leaf parameters, values and their buffers */
+	GN_MEM_TAG_MQTT, /*!< legacy MQTT protocol */
+	GN_MEM_TAG_HOMIE, /*!< homie MQTT protocol */
+	GN_MEM_TAG_DISPLAY, /*!< display buffers */
+	GN_MEM_TAG_LEAF, /*!< leaves without a tag of their own */
+	GN_MEM_TAG_BUILTIN_MAX
+};
+
+#ifdef CONFIG_GROWNODE_MEM_ACCOUNTING
+
+#include "cJSON.h"
+
+#define GN_MEM_TAG_MAX CONFIG_GROWNODE_MEM_ACCOUNTING_TAGS
+
+typedef struct {
+	char name[GN_MEM_TAG_NAME_SIZE];
+	size_t live_bytes; /*!< requested bytes not released yet */
+	size_t peak_bytes;
+	size_t budget; /*!< live bytes allowed, 0 for no limit */
+	uint32_t live_count;
+	uint32_t allocs; /*!< since the last reset */
+	uint32_t frees;
+	uint32_t denied; /*!< allocations refused by the budget */
+	uint32_t lifetime[GN_MEM_LIFETIME_BUCKETS]; /*!< lifetime of released allocations */
+} gn_mem_stats_t;
+
+gn_mem_tag_t gn_mem_tag_register(const char *name);
+
+void gn_mem_set_budget(gn_mem_tag_t tag, size_t budget);
+
+void* gn_mem_malloc(gn_mem_tag_t tag, size_t size);
+
+void* gn_mem_caps_malloc(gn_mem_tag_t tag, size_t size, uint32_t caps);
+
+void* gn_mem_calloc(gn_mem_tag_t tag, size_t n, size_t size);
+
+void* gn_mem_realloc(gn_mem_tag_t tag, void *ptr, size_t size);
+
+char* gn_mem_strdup(gn_mem_tag_t tag, const char *s);
+
+void gn_mem_free(void *ptr);
+
+void gn_mem_get_stats(gn_mem_tag_t tag, gn_mem_stats_t *stats);
+
+cJSON* gn_mem_stats_to_json();
+
+void gn_mem_dump();
+
+void gn_mem_reset();
+
+#else
+
+#define gn_mem_tag_register(name) ((gn_mem_tag_t) GN_MEM_TAG_LEAF)
+#define gn_mem_set_budget(tag, budget)
+#define gn_mem_malloc(tag, size) malloc(size)
+#define gn_mem_caps_malloc(tag, size, caps) heap_caps_malloc(size, caps)
+#define gn_mem_calloc(tag, n, size) calloc(n, size)
+#define gn_mem_realloc(tag, ptr, size) realloc(ptr, size)
+#define gn_mem_strdup(tag, s) strdup(s)
+#define gn_mem_free(ptr) free(ptr)
+
+#endif /* CONFIG_GROWNODE_MEM_ACCOUNTING */
+
+#endif /* GN_MEM_H_ */
@@ -17,6 +17,7 @@ extern "C" {
 #endif
 
 #include <stdio.h>
+#include <errno.h>
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
@@ -27,11 +28,14 @@ extern "C" {
 #include "esp_event.h"
 #include "esp_check.h"
 #include "esp_system.h"
+#include "esp_attr.h"
+#include "esp_timer.h"
 
 #include "grownode_intl.h"
 #include "gn_commons.h"
 #include "gn_mqtt_protocol.h"
 #include "gn_network.h"
+#include "gn_boot.h"
 
 #ifdef CONFIG_GROWNODE_MQTT_HOMIE_PROTOCOL
 
@@ -60,8 +64,33 @@ EventGroupHandle_t _gn_event_group_mqtt;
 
 const int _GN_MQTT_CONNECTED_EVENT_BIT = BIT0;
 const int _GN_MQTT_DISCONNECT_EVENT_BIT = BIT1;
+const int _GN_MQTT_SUBSCRIBED_EVENT_BIT = BIT2;
+const int _GN_MQTT_SUBSCRIBE_FAILED_EVENT_BIT = BIT3;
 
 const int _GN_MQTT_DEBUG_WAIT_MS = 500;
+const int _GN_MQTT_SUBSCRIBE_TIMEOUT_MS = 5000;
+
+//true when parameter commands are received through the node wildcard subscription. kept across deep sleeps to trust a session kept by the broker
+RTC_DATA_ATTR static bool _gn_mqtt_wildcard_active = false;
+static int _gn_mqtt_wildcard_msg_id = -1;
+
+//start of the current server connection, to measure transport, TLS and MQTT handshakes.
+//TLS sessions are not resumed: esp-mqtt does not expose the esp-tls session, every connection is a full handshake
+static int64_t _gn_mqtt_connect_start_us = 0;
+static int32_t _gn_mqtt_handshake_ms = 0;
+//true when the broker kept the MQTT session, and its subscriptions, from before the deep sleep
+static bool _gn_mqtt_session_present = false;
+#ifdef CONFIG_GROWNODE_MQTT_PERSISTENT_SESSION
+static char _gn_mqtt_client_id[GN_MQTT_CLIENT_ID_SIZE];
+#endif
+
+#ifdef CONFIG_GROWNODE_MQTT_HOMIE_INCREMENTAL_ANNOUNCE
+//fingerprints of the last description acknowledged by the broker: slot 0 is the device, slot i+1 the leaf i. kept across sleeps, cleared on power on
+RTC_DATA_ATTR static uint64_t _gn_homie_announced[GN_NODE_LEAF_MAX_SIZE + 1];
+//fingerprints of the announcement in progress, committed when $state ready is acknowledged
+static uint64_t _gn_homie_announcing[GN_NODE_LEAF_MAX_SIZE + 1];
+static int _gn_homie_announce_msg_id = -1;
+#endif
 
 /*
  void _gn_homie_topic_node(char *topic, const gn_node_handle_t node) {
@@ -104,6 +133,83 @@ void _gn_homie_mk_topic_param_attribute(char *topic,
 
 }
 
+//the property value topic, where the parameter status is published
+void _gn_homie_mk_topic_param(char *topic,
+		const gn_leaf_param_handle_intl_t param) {
+
+	gn_leaf_handle_intl_t _leaf = (gn_leaf_handle_intl_t) param->leaf;
+	snprintf(topic, _GN_MQTT_MAX_TOPIC_LENGTH, "homie/%s/%s/%s",
+			_leaf->node->name, _leaf->name, param->name);
+
+}
+
+/**
+ * @brief	computes the leaf topics and stores them in the node topic arena
+ *
+ * Homie leaves do not have own command or status topics, nothing to build.
+ *
+ * @param	leaf_config		the leaf
+ *
+ * @return	GN_RET_OK
+ */
+gn_err_t gn_mqtt_build_leaf_topics(gn_leaf_handle_t leaf_config) {
+
+	if (!leaf_config)
+		return GN_RET_ERR_INVALID_ARG;
+
+	gn_leaf_handle_intl_t leaf = (gn_leaf_handle_intl_t) leaf_config;
+	leaf->topic_cmd = NULL;
+	leaf->topic_sts = NULL;
+
+	return GN_RET_OK;
+
+}
+
+/**
+ * @brief	computes the parameter value and set topics once, storing them in the node topic arena
+ *
+ * @param	_param		the parameter, already bound to its leaf
+ *
+ * @return	GN_RET_ERR_INVALID_ARG	if the parameter is not bound to a leaf
+ * @return	GN_RET_ERR				if topics cannot be stored
+ * @return	GN_RET_OK				upon success
+ */
+gn_err_t gn_mqtt_build_leaf_param_topics(gn_leaf_param_handle_t _param) {
+
+#ifdef CONFIG_GROWNODE_WIFI_ENABLED
+
+	gn_leaf_param_handle_intl_t param = (gn_leaf_param_handle_intl_t) _param;
+
+	if (!param || !param->leaf)
+		return GN_RET_ERR_INVALID_ARG;
+
+	gn_leaf_handle_intl_t leaf = (gn_leaf_handle_intl_t) param->leaf;
+	char buf[_GN_MQTT_MAX_TOPIC_LENGTH];
+
+	_gn_homie_mk_topic_param(buf, param);
+	param->topic_sts = gn_string_arena_add(leaf->node->topics, buf);
+	_gn_homie_mk_topic_param_attribute(buf, param, "set");
+	param->topic_cmd = gn_string_arena_add(leaf->node->topics, buf);
+
+	if (!param->topic_sts || !param->topic_cmd) {
+		ESP_LOGE(TAG, "cannot store topics of param %s", param->name);
+		return GN_RET_ERR;
+	}
+
+	if (!gn_leaf_context_set(leaf->node->topic_index, (char*) param->topic_cmd,
+			param)) {
+		ESP_LOGE(TAG, "cannot index topic of param %s", param->name);
+		return GN_RET_ERR;
+	}
+
+	return GN_RET_OK;
+
+#else
+	return GN_RET_OK;
+#endif /* CONFIG_GROWNODE_WIFI_ENABLED */
+
+}
+
 inline gn_err_t _gn_homie_publish(gn_node_handle_intl_t node, const char *topic,
 		int qos, int retain, const char *payload, int len) {
 
@@ -181,38 +287,21 @@ gn_err_t _gn_homie_on_disconnected(gn_config_handle_t config) {
 gn_leaf_param_handle_intl_t _gn_homie_param_from_set_topic(
 		gn_node_handle_intl_t node, char *topic, int topic_len) {
 
-	char param_topic[_GN_MQTT_MAX_TOPIC_LENGTH];
-	//per each leaf
-	for (int i = 0; i < node->leaves.last; i++) {
-		gn_leaf_handle_intl_t leaf = (gn_leaf_handle_intl_t) node->leaves.at[i];
-
-		//per each parameter
-		gn_leaf_param_handle_intl_t _param_enum = leaf->params;
-		while (_param_enum) {
-
-			//check if topic matches the mask and return it
-			_gn_homie_mk_topic_param_attribute(param_topic, _param_enum, "set");
-
-			ESP_LOGD(TAG,
-					"_gn_homie_param_from_set_topic: comparing topic '%.*s' with param '%s'..",
-					topic_len, topic, param_topic);
-
-			if (strncmp(param_topic, topic, topic_len) == 0) {
-				ESP_LOGD(TAG, "..found");
-				return _param_enum;
-			}
+	//topics from the broker are not null terminated
+	char key[_GN_MQTT_MAX_TOPIC_LENGTH];
+	if (topic_len <= 0 || topic_len >= _GN_MQTT_MAX_TOPIC_LENGTH)
+		return NULL;
 
-			if (_param_enum->next) {
-				_param_enum = _param_enum->next;
-			} else {
-				break;
-			}
+	memcpy(key, topic, topic_len);
+	key[topic_len] = '\0';
 
-		}
+	gn_leaf_param_handle_intl_t param = gn_leaf_context_get(node->topic_index,
+			key);
 
-	}
+	ESP_LOGD(TAG, "_gn_homie_param_from_set_topic: topic '%s' %s", key,
+			param ? "found" : "not found");
 
-	return NULL;
+	return param;
 }
 
 void log_error_if_nonzero(const char *message, int error_code) {
@@ -251,7 +340,7 @@ gn_err_t _gn_mqtt_homie_payload_to_double(double *_ret,
 			"_gn_mqtt_homie_payload_to_double: mqtt_payload='%.*s', len = %d",
 			evt->data_len, evt->data, evt->data_len);
 
-	char *payload = calloc(evt->data_len, sizeof(char));
+	char *payload = gn_mem_calloc(GN_MEM_TAG_HOMIE, evt->data_len, sizeof(char));
 	strncpy(payload, evt->data, evt->data_len);
 
 	char *eptr;
@@ -261,13 +350,13 @@ gn_err_t _gn_mqtt_homie_payload_to_double(double *_ret,
 		//If the value provided was out of range, display a warning message
 		if (errno == ERANGE) {
 			ESP_LOGW(TAG, "_gn_mqtt_homie_payload_to_double: invalid payload");
-			free(payload);
+			gn_mem_free(payload);
 			return GN_RET_ERR_INVALID_ARG;
 		}
 	}
 
 	//memcpy(_ret, evt->data, sizeof(double));
-	free(payload);
+	gn_mem_free(payload);
 	return GN_RET_OK;
 
 }
@@ -296,8 +385,23 @@ void _gn_homie_event_handler(void *handler_args, esp_event_base_t base,
 
 	switch ((esp_mqtt_event_id_t) event_id) {
 
+	case MQTT_EVENT_BEFORE_CONNECT:
+		ESP_LOGD(TAG, "MQTT_EVENT_BEFORE_CONNECT");
+		_gn_mqtt_connect_start_us = esp_timer_get_time();
+		break;
+
 	case MQTT_EVENT_CONNECTED:
 		ESP_LOGD(TAG, "MQTT_EVENT_CONNECTED");
+		_gn_mqtt_handshake_ms = (esp_timer_get_time()
+				- _gn_mqtt_connect_start_us) / 1000;
+		ESP_LOGI(TAG, "server connected in %d ms, broker session %s",
+				_gn_mqtt_handshake_ms,
+				mqtt_event->session_present ? "present" : "new");
+#ifdef CONFIG_GROWNODE_MQTT_PERSISTENT_SESSION
+		//subscriptions are trusted only on deep sleep wake up, a power on may run a different firmware
+		_gn_mqtt_session_present = mqtt_event->session_present
+				&& esp_reset_reason() == ESP_RST_DEEPSLEEP;
+#endif
 		xEventGroupSetBits(_gn_event_group_mqtt, _GN_MQTT_CONNECTED_EVENT_BIT);
 		break;
 
@@ -321,8 +425,37 @@ void _gn_homie_event_handler(void *handler_args, esp_event_base_t base,
 	}
 		break;
 
+	case MQTT_EVENT_SUBSCRIBED:
+		if (mqtt_event->msg_id == _gn_mqtt_wildcard_msg_id) {
+			//SUBACK return code 0x80 means the broker refused the topic filter
+			if (mqtt_event->data_len > 0
+					&& (uint8_t) mqtt_event->data[0] == 0x80) {
+				xEventGroupSetBits(_gn_event_group_mqtt,
+						_GN_MQTT_SUBSCRIBE_FAILED_EVENT_BIT);
+			} else {
+				xEventGroupSetBits(_gn_event_group_mqtt,
+						_GN_MQTT_SUBSCRIBED_EVENT_BIT);
+			}
+		}
+		break;
+
+#ifdef CONFIG_GROWNODE_MQTT_HOMIE_INCREMENTAL_ANNOUNCE
+	case MQTT_EVENT_PUBLISHED:
+		if (_gn_homie_announce_msg_id != -1
+				&& mqtt_event->msg_id == _gn_homie_announce_msg_id) {
+			ESP_LOGD(TAG, "announcement acknowledged, storing fingerprints");
+			memcpy(_gn_homie_announced, _gn_homie_announcing,
+					sizeof(_gn_homie_announced));
+			_gn_homie_announce_msg_id = -1;
+		}
+		break;
+#endif
+
 	case MQTT_EVENT_DATA:
 
+#ifdef CONFIG_GROWNODE_LATENCY_TRACE
+		gn_trace_begin();
+#endif
 		ESP_LOGD(TAG, "MQTT_EVENT_DATA");
 		//parameter set
 		gn_leaf_param_handle_intl_t param = _gn_homie_param_from_set_topic(
@@ -374,17 +507,18 @@ void _gn_homie_event_handler(void *handler_args, esp_event_base_t base,
 				break;
 			case GN_VAL_TYPE_STRING: {
 
-				char *ret = calloc(_GN_MQTT_MAX_PAYLOAD_LENGTH, sizeof(char));
+				char *ret = gn_mem_calloc(GN_MEM_TAG_HOMIE,
+						_GN_MQTT_MAX_PAYLOAD_LENGTH, sizeof(char));
 				if (_gn_mqtt_homie_payload_to_string(ret, mqtt_event->data_len,
 						mqtt_event) != GN_RET_OK) {
 					ESP_LOGW(TAG,
 							"_gn_homie_event_handler - string payload not allowed");
-					free(ret);
+					gn_mem_free(ret);
 					break;
 				}
-				gn_string_to_event_payload(ret, &leaf_event,
-						leaf_event.data_len);
-				free(ret);
+				gn_string_to_event_payload(ret, mqtt_event->data_len,
+						&leaf_event);
+				gn_mem_free(ret);
 			}
 				break;
 			default:
@@ -468,94 +602,129 @@ static int _clamp(int n, int lower, int upper) {
 
 //gn_err_t gn_mqtt_publish_node(gn_config_handle_t config) { }
 
-gn_err_t _gn_homie_on_connected(gn_config_handle_intl_t _config,
-		char *_topic_buf) {
+#ifdef CONFIG_GROWNODE_MQTT_WILDCARD_SUBSCRIPTION
+/**
+ * @brief	subscribes the node wildcard topic and waits for the broker acknowledge
+ *
+ * @return	true if the broker accepted the subscription
+ */
+static bool _gn_homie_subscribe_wildcard(gn_config_handle_intl_t _config) {
 
-	ESP_LOGD(TAG, "_gn_homie_on_connected");
+	char topic[_GN_MQTT_MAX_TOPIC_LENGTH];
+	snprintf(topic, _GN_MQTT_MAX_TOPIC_LENGTH, "homie/%s/+/+/set",
+			_config->node_handle->name);
 
-//presentation messages
-	int ret;
+	xEventGroupClearBits(_gn_event_group_mqtt,
+			_GN_MQTT_SUBSCRIBED_EVENT_BIT | _GN_MQTT_SUBSCRIBE_FAILED_EVENT_BIT);
+
+	_gn_mqtt_wildcard_msg_id = esp_mqtt_client_subscribe(_config->mqtt_client,
+			topic, _GN_MQTT_SUBSCRIBE_QOS);
+	if (_gn_mqtt_wildcard_msg_id == -1) {
+		ESP_LOGW(TAG, "cannot subscribe %s", topic);
+		return false;
+	}
+
+	EventBits_t uxBits = xEventGroupWaitBits(_gn_event_group_mqtt,
+			_GN_MQTT_SUBSCRIBED_EVENT_BIT | _GN_MQTT_SUBSCRIBE_FAILED_EVENT_BIT,
+			pdTRUE, pdFALSE,
+			_GN_MQTT_SUBSCRIBE_TIMEOUT_MS / portTICK_PERIOD_MS);
+	_gn_mqtt_wildcard_msg_id = -1;
+
+	if ((uxBits & _GN_MQTT_SUBSCRIBED_EVENT_BIT) == 0) {
+		ESP_LOGW(TAG, "subscription to %s %s", topic,
+				(uxBits & _GN_MQTT_SUBSCRIBE_FAILED_EVENT_BIT) ?
+						"refused by the broker" : "not acknowledged");
+		return false;
+	}
+
+	return true;
+
+}
+#endif /* CONFIG_GROWNODE_MQTT_WILDCARD_SUBSCRIPTION */
+
+typedef struct {
+	gn_node_handle_intl_t node;
+	bool publish; /*!< if false, attributes are only folded into the fingerprint */
+	uint64_t fingerprint;
+	int msg_id; /*!< id of the last enqueued message */
+} _gn_homie_announce_t;
+
+static void _gn_homie_fingerprint_add(uint64_t *fingerprint, const char *str) {
+
+	*fingerprint ^= gn_hash(str) + 0x9e3779b97f4a7c15ull + (*fingerprint << 6)
+			+ (*fingerprint >> 2);
+
+}
+
+/**
+ * @brief	publishes a retained description attribute
+ *
+ * Messages are put in the client outbox and sent by the MQTT task, so the
+ * announcement does not wait for every PUBACK. When the context is not in
+ * publish mode, the attribute is only added to the fingerprint.
+ */
+static gn_err_t _gn_homie_announce_attr(_gn_homie_announce_t *ann,
+		const char *topic, const char *payload) {
+
+	if (!ann->publish) {
+		_gn_homie_fingerprint_add(&ann->fingerprint, topic);
+		_gn_homie_fingerprint_add(&ann->fingerprint, payload);
+		return GN_RET_OK;
+	}
+
+	ESP_LOGD(TAG, "enqueuing: '%s' -> '%s', qos=1, retained=1", topic,
+			payload);
+
+	int msg_id = esp_mqtt_client_enqueue(ann->node->config->mqtt_client, topic,
+			payload, strlen(payload), 1, 1, true);
+	if (msg_id < 0)
+		return GN_RET_ERR_MQTT_ERROR;
+
+	ann->msg_id = msg_id;
+	return GN_RET_OK;
+
+}
+
+static gn_err_t _gn_homie_announce_device(_gn_homie_announce_t *ann,
+		char *_topic_buf) {
+
+	gn_node_handle_intl_t node = ann->node;
+	gn_err_t ret;
 
 //homie version
-	_gn_homie_mk_topic_node_attribute(_topic_buf, _config->node_handle,
-			"$homie");
-	ret = _gn_homie_publish_str(_config->node_handle, _topic_buf, 1, 1,
-			(char*) _GN_HOMIE_VERSION);
+	_gn_homie_mk_topic_node_attribute(_topic_buf, node, "$homie");
+	ret = _gn_homie_announce_attr(ann, _topic_buf, _GN_HOMIE_VERSION);
 	if (ret != GN_RET_OK)
 		return ret;
 
 //name
-	_gn_homie_mk_topic_node_attribute(_topic_buf, _config->node_handle,
-			"$name");
-	ret = _gn_homie_publish_str(_config->node_handle, _topic_buf, 1, 1,
-			_config->node_handle->name);
-	if (ret != GN_RET_OK)
-		return ret;
-
-//state
-	_gn_homie_mk_topic_node_attribute(_topic_buf, _config->node_handle,
-			"$state");
-	ret = _gn_homie_publish_str(_config->node_handle, _topic_buf, 1, 1,
-			(char*) _GN_HOMIE_INIT);
+	_gn_homie_mk_topic_node_attribute(_topic_buf, node, "$name");
+	ret = _gn_homie_announce_attr(ann, _topic_buf, node->name);
 	if (ret != GN_RET_OK)
 		return ret;
 
-
-//firmware
-	esp_app_desc_t* app_desc = esp_app_get_description();
-
-
-
 //nodes
-	char *msg_buf = calloc(
-			(_config->node_handle->leaves.last + 1) * GN_LEAF_NAME_SIZE,
-			sizeof(char));
+	char *msg_buf = gn_mem_calloc(GN_MEM_TAG_HOMIE,
+			(node->leaves.last + 1) * GN_LEAF_NAME_SIZE, sizeof(char));
 
-	for (int i = 0; i < _config->node_handle->leaves.last; i++) {
-		gn_leaf_handle_intl_t leaf =
-				(gn_leaf_handle_intl_t) _config->node_handle->leaves.at[i];
+	for (int i = 0; i < node->leaves.last; i++) {
+		gn_leaf_handle_intl_t leaf = (gn_leaf_handle_intl_t) node->leaves.at[i];
 
 		strcat(msg_buf, leaf->name);
 		strcat(msg_buf, ",");
 
 	}
 
-	_gn_homie_mk_topic_node_attribute(_topic_buf, _config->node_handle,
-			"$nodes");
-	ret = _gn_homie_publish_str(_config->node_handle, _topic_buf, 1, 1,
-			msg_buf);
-	free(msg_buf);
+	_gn_homie_mk_topic_node_attribute(_topic_buf, node, "$nodes");
+	ret = _gn_homie_announce_attr(ann, _topic_buf, msg_buf);
+	gn_mem_free(msg_buf);
 	if (ret != GN_RET_OK)
 		return ret;
 
-//online
-//	_gn_homie_mk_topic_node_attribute(_topic_buf, _config->node_handle,
-//			"$online");
-//	ret = _gn_homie_publish_str(_config->node_handle, _topic_buf, 1, 1, "true");
-//	if (ret != GN_RET_OK)
-//		return ret;
-
-//implementation
-//	_gn_homie_mk_topic_node_attribute(_topic_buf, _config->node_handle,
-//			"$implementation");
-//	ret = _gn_homie_publish_str(_config->node_handle, _topic_buf, 1, 1,
-//			"esp32-idf");
-//	if (ret != GN_RET_OK)
-//		return ret;
-
-//implementation
-//	_gn_homie_mk_topic_node_attribute(_topic_buf, _config->node_handle,
-//			"$implementation/version");
-//	ret = _gn_homie_publish_str(_config->node_handle, _topic_buf, 1, 1,
-//			esp_get_idf_version());
-//	if (ret != GN_RET_OK)
-//		return ret;
-
 //extensions
-	_gn_homie_mk_topic_node_attribute(_topic_buf, _config->node_handle,
-			"$extensions");
+	_gn_homie_mk_topic_node_attribute(_topic_buf, node, "$extensions");
 	ret =
-			_gn_homie_publish_str(_config->node_handle, _topic_buf, 1, 1,
+			_gn_homie_announce_attr(ann, _topic_buf,
 					"org.homie.legacy-firmware:0.1.1:[4.x],org.homie.legacy-stats:0.1.1:[4.x]");
 	if (ret != GN_RET_OK)
 		return ret;
@@ -569,161 +738,239 @@ gn_err_t _gn_homie_on_connected(gn_config_handle_intl_t _config,
 
 //TODO logging
 
-//	char mac_address[18];
-//	char ip_address[16];
-//	gn_wifi_get_mac(mac_address);
-//	gn_wifi_get_ip(ip_address);
+//TODO $localip, $mac
 
-//	_gn_homie_mk_topic_node_attribute(_topic_buf, _config->node_handle,
-//			"$localip");
-//	ret = _gn_homie_publish_str(_config->node_handle, _topic_buf, 1, 1,
-//			ip_address);
-//	if (ret != GN_RET_OK)
-//		return ret;
+	return GN_RET_OK;
 
-//	_gn_homie_mk_topic_node_attribute(_topic_buf, _config->node_handle, "$mac");
-//	ret = _gn_homie_publish_str(_config->node_handle, _topic_buf, 1, 1,
-//			mac_address);
-//	if (ret != GN_RET_OK)
-//		return ret;
+}
 
-//node attributes
-	for (int i = 0; i < _config->node_handle->leaves.last; i++) {
-		gn_leaf_handle_intl_t leaf =
-				(gn_leaf_handle_intl_t) _config->node_handle->leaves.at[i];
-
-		//name
-		_gn_homie_mk_topic_leaf_attribute(_topic_buf, leaf, "$name");
-		ret = _gn_homie_publish_str(_config->node_handle, _topic_buf, 1, 1,
-				leaf->name);
-		if (ret != GN_RET_OK)
-			return ret;
+static gn_err_t _gn_homie_announce_leaf(_gn_homie_announce_t *ann,
+		gn_leaf_handle_intl_t leaf, char *_topic_buf) {
 
-		//type
-		_gn_homie_mk_topic_leaf_attribute(_topic_buf, leaf, "$type");
-		ret = _gn_homie_publish_str(_config->node_handle, _topic_buf, 1, 1,
-				leaf->leaf_descriptor->type);
-		if (ret != GN_RET_OK)
-			return ret;
+	gn_err_t ret;
 
-		//properties
+	//name
+	_gn_homie_mk_topic_leaf_attribute(_topic_buf, leaf, "$name");
+	ret = _gn_homie_announce_attr(ann, _topic_buf, leaf->name);
+	if (ret != GN_RET_OK)
+		return ret;
 
-		char *p_msg_buf = calloc(_GN_MQTT_MAX_PAYLOAD_LENGTH, sizeof(char));
+	//type
+	_gn_homie_mk_topic_leaf_attribute(_topic_buf, leaf, "$type");
+	ret = _gn_homie_announce_attr(ann, _topic_buf, leaf->leaf_descriptor->type);
+	if (ret != GN_RET_OK)
+		return ret;
 
-		gn_leaf_param_handle_intl_t _param_enum = leaf->params;
-		while (_param_enum) {
+	//properties
+	char *p_msg_buf = gn_mem_calloc(GN_MEM_TAG_HOMIE,
+			_GN_MQTT_MAX_PAYLOAD_LENGTH, sizeof(char));
 
-			strcat(p_msg_buf, _param_enum->name);
-			strcat(p_msg_buf, ",");
+	gn_leaf_param_handle_intl_t _param_enum = leaf->params;
+	while (_param_enum) {
 
-			if (_param_enum->next) {
-				_param_enum = _param_enum->next;
-			} else {
-				break;
-			}
+		strcat(p_msg_buf, _param_enum->name);
+		strcat(p_msg_buf, ",");
 
+		if (_param_enum->next) {
+			_param_enum = _param_enum->next;
+		} else {
+			break;
 		}
 
-		_gn_homie_mk_topic_leaf_attribute(_topic_buf, leaf, "$properties");
-		ret = _gn_homie_publish_str(_config->node_handle, _topic_buf, 1, 1,
-				p_msg_buf);
-		free(p_msg_buf);
+	}
 
-		if (ret != GN_RET_OK)
-			return ret;
+	_gn_homie_mk_topic_leaf_attribute(_topic_buf, leaf, "$properties");
+	ret = _gn_homie_announce_attr(ann, _topic_buf, p_msg_buf);
+	gn_mem_free(p_msg_buf);
 
-		gn_leaf_param_handle_intl_t _param = leaf->params;
-		while (_param) {
+	if (ret != GN_RET_OK)
+		return ret;
 
-			if (_param->access != GN_LEAF_PARAM_ACCESS_NODE_INTERNAL) {
+	gn_leaf_param_handle_intl_t _param = leaf->params;
+	while (_param) {
 
-				//name
-				_gn_homie_mk_topic_param_attribute(_topic_buf, _param, "$name");
-				ret = _gn_homie_publish_str(_config->node_handle, _topic_buf, 1,
-						1, _param->name);
-				if (ret != GN_RET_OK)
-					return ret;
+		if (_param->access != GN_LEAF_PARAM_ACCESS_NODE_INTERNAL) {
 
-				//datatype
-				_gn_homie_mk_topic_param_attribute(_topic_buf, _param,
-						"$datatype");
+			//name
+			_gn_homie_mk_topic_param_attribute(_topic_buf, _param, "$name");
+			ret = _gn_homie_announce_attr(ann, _topic_buf, _param->name);
+			if (ret != GN_RET_OK)
+				return ret;
 
-				switch (_param->param_val->t) {
-				case GN_VAL_TYPE_BOOLEAN:
-					ret = _gn_homie_publish_str(_config->node_handle,
-							_topic_buf, 1, 1, _GN_HOMIE_DATATYPE_BOOLEAN);
-					break;
-				case GN_VAL_TYPE_DOUBLE:
-					ret = _gn_homie_publish_str(_config->node_handle,
-							_topic_buf, 1, 1, _GN_HOMIE_DATATYPE_FLOAT);
-					break;
-				case GN_VAL_TYPE_STRING:
-					ret = _gn_homie_publish_str(_config->node_handle,
-							_topic_buf, 1, 1, _GN_HOMIE_DATATYPE_STRING);
-					break;
-				default:
-					ret = GN_RET_ERR;
-					break;
-				}
-				if (ret != GN_RET_OK)
-					return ret;
-
-				//format
-				_gn_homie_mk_topic_param_attribute(_topic_buf, _param,
-						"$format");
-				ret = _gn_homie_publish_str(_config->node_handle, _topic_buf, 1,
-						1, _param->format);
-				if (ret != GN_RET_OK)
-					return ret;
-
-				//unit
-				_gn_homie_mk_topic_param_attribute(_topic_buf, _param, "$unit");
-				ret = _gn_homie_publish_str(_config->node_handle, _topic_buf, 1,
-						1, _param->unit);
-				if (ret != GN_RET_OK)
-					return ret;
-
-				//settable
-				_gn_homie_mk_topic_param_attribute(_topic_buf, _param,
-						"$settable");
-				if (_param->access == GN_LEAF_PARAM_ACCESS_ALL) {
-					ret = _gn_homie_publish_str(_config->node_handle,
-							_topic_buf, 1, 1, _GN_HOMIE_TRUE);
-				} else {
-					ret = _gn_homie_publish_str(_config->node_handle,
-							_topic_buf, 1, 1, _GN_HOMIE_FALSE);
-				}
-				if (ret != GN_RET_OK)
-					return ret;
-
-				//retained
-				_gn_homie_mk_topic_param_attribute(_topic_buf, _param,
-						"$retained");
-				if (_param->storage == GN_LEAF_PARAM_STORAGE_PERSISTED) {
-					ret = _gn_homie_publish_str(_config->node_handle,
-							_topic_buf, 1, 1, _GN_HOMIE_TRUE);
-				} else {
-					ret = _gn_homie_publish_str(_config->node_handle,
-							_topic_buf, 1, 1, _GN_HOMIE_FALSE);
-				}
-				if (ret != GN_RET_OK)
-					return ret;
-			}
+			//datatype
+			_gn_homie_mk_topic_param_attribute(_topic_buf, _param, "$datatype");
 
-			if (_param->next) {
-				_param = _param->next;
-			} else {
+			switch (_param->param_val->t) {
+			case GN_VAL_TYPE_BOOLEAN:
+				ret = _gn_homie_announce_attr(ann, _topic_buf,
+						_GN_HOMIE_DATATYPE_BOOLEAN);
+				break;
+			case GN_VAL_TYPE_DOUBLE:
+				ret = _gn_homie_announce_attr(ann, _topic_buf,
+						_GN_HOMIE_DATATYPE_FLOAT);
+				break;
+			case GN_VAL_TYPE_STRING:
+				ret = _gn_homie_announce_attr(ann, _topic_buf,
+						_GN_HOMIE_DATATYPE_STRING);
+				break;
+			default:
+				ret = GN_RET_ERR;
 				break;
 			}
+			if (ret != GN_RET_OK)
+				return ret;
+
+			//format
+			_gn_homie_mk_topic_param_attribute(_topic_buf, _param, "$format");
+			ret = _gn_homie_announce_attr(ann, _topic_buf, _param->format);
+			if (ret != GN_RET_OK)
+				return ret;
+
+			//unit
+			_gn_homie_mk_topic_param_attribute(_topic_buf, _param, "$unit");
+			ret = _gn_homie_announce_attr(ann, _topic_buf, _param->unit);
+			if (ret != GN_RET_OK)
+				return ret;
+
+			//settable
+			_gn_homie_mk_topic_param_attribute(_topic_buf, _param, "$settable");
+			ret = _gn_homie_announce_attr(ann, _topic_buf,
+					_param->access == GN_LEAF_PARAM_ACCESS_ALL ?
+							_GN_HOMIE_TRUE : _GN_HOMIE_FALSE);
+			if (ret != GN_RET_OK)
+				return ret;
+
+			//retained
+			_gn_homie_mk_topic_param_attribute(_topic_buf, _param, "$retained");
+			ret = _gn_homie_announce_attr(ann, _topic_buf,
+					_param->storage == GN_LEAF_PARAM_STORAGE_PERSISTED ?
+							_GN_HOMIE_TRUE : _GN_HOMIE_FALSE);
+			if (ret != GN_RET_OK)
+				return ret;
 		}
 
+		if (_param->next) {
+			_param = _param->next;
+		} else {
+			break;
+		}
+	}
+
+	return GN_RET_OK;
+
+}
+
+/**
+ * @brief	announces the device (leaf NULL) or a leaf description
+ *
+ * With CONFIG_GROWNODE_MQTT_HOMIE_INCREMENTAL_ANNOUNCE the block is first
+ * fingerprinted and published only if different from the last announcement
+ * acknowledged by the broker.
+ */
+static gn_err_t _gn_homie_announce_block(_gn_homie_announce_t *ann,
+		size_t slot, gn_leaf_handle_intl_t leaf, char *_topic_buf) {
+
+	gn_err_t ret;
+
+#ifdef CONFIG_GROWNODE_MQTT_HOMIE_INCREMENTAL_ANNOUNCE
+	ann->publish = false;
+	ann->fingerprint = 0;
+	ret = leaf ?
+			_gn_homie_announce_leaf(ann, leaf, _topic_buf) :
+			_gn_homie_announce_device(ann, _topic_buf);
+	if (ret != GN_RET_OK)
+		return ret;
+
+	_gn_homie_announcing[slot] = ann->fingerprint;
+	if (_gn_homie_announced[slot] == ann->fingerprint) {
+		ESP_LOGD(TAG, "%s description unchanged, skipping",
+				leaf ? leaf->name : ann->node->name);
+		return GN_RET_OK;
+	}
+#endif
+
+	ann->publish = true;
+	ret = leaf ?
+			_gn_homie_announce_leaf(ann, leaf, _topic_buf) :
+			_gn_homie_announce_device(ann, _topic_buf);
+
+	return ret;
+
+}
+
+gn_err_t _gn_homie_on_connected(gn_config_handle_intl_t _config,
+		char *_topic_buf) {
+
+	ESP_LOGD(TAG, "_gn_homie_on_connected");
+
+	gn_node_handle_intl_t node = _config->node_handle;
+	_gn_homie_announce_t ann = { .node = node, .publish = true, .fingerprint =
+			0, .msg_id = -1 };
+	gn_err_t ret;
+
+#ifdef CONFIG_GROWNODE_MQTT_HOMIE_INCREMENTAL_ANNOUNCE
+	_gn_homie_announce_msg_id = -1;
+	memset(_gn_homie_announcing, 0, sizeof(_gn_homie_announcing));
+#endif
+
+//state init, always sent as controllers expect the init -> ready transition
+	_gn_homie_mk_topic_node_attribute(_topic_buf, node, "$state");
+	ret = _gn_homie_announce_attr(&ann, _topic_buf, _GN_HOMIE_INIT);
+	if (ret != GN_RET_OK)
+		return ret;
+
+//device attributes
+	ret = _gn_homie_announce_block(&ann, 0, NULL, _topic_buf);
+	if (ret != GN_RET_OK)
+		return ret;
+
+//node attributes
+	for (int i = 0; i < node->leaves.last; i++) {
+		ret = _gn_homie_announce_block(&ann, i + 1,
+				(gn_leaf_handle_intl_t) node->leaves.at[i], _topic_buf);
+		if (ret != GN_RET_OK)
+			return ret;
 	}
 
+#ifdef CONFIG_GROWNODE_MQTT_WILDCARD_SUBSCRIPTION
+//commands subscription, unless the broker kept the subscriptions in the mode they were made:
+//a wildcard on top of kept per parameter topics would deliver commands twice
+	if (!_gn_mqtt_session_present)
+		_gn_mqtt_wildcard_active = _gn_homie_subscribe_wildcard(_config);
+	ESP_LOGI(TAG, "subscription mode: %s",
+			_gn_mqtt_wildcard_active ? "wildcard" : "per parameter");
+
+	//leaves already started (wake up from sleep) need their topics again on fallback
+	if (!_gn_mqtt_wildcard_active
+			&& _config->status == GN_NODE_STATUS_SLEEPING) {
+		for (int i = 0; i < node->leaves.last; i++) {
+			ret = gn_mqtt_subscribe_leaf(node->leaves.at[i]);
+			if (ret != GN_RET_OK)
+				return ret;
+		}
+	}
+#endif
+
+//connection timings
+	gn_wifi_timings_t timings;
+	gn_wifi_get_timings(&timings);
+	_gn_homie_mk_topic_node_attribute(_topic_buf, node, "$stats/wifiassociate");
+	_gn_homie_publish_int(node, _topic_buf, 0, 0, timings.associate_ms);
+	_gn_homie_mk_topic_node_attribute(_topic_buf, node, "$stats/wifiaddress");
+	_gn_homie_publish_int(node, _topic_buf, 0, 0, timings.ip_ms);
+	_gn_homie_mk_topic_node_attribute(_topic_buf, node, "$stats/mqttconnect");
+	_gn_homie_publish_int(node, _topic_buf, 0, 0, _gn_mqtt_handshake_ms);
+
 //state ready
-	_gn_homie_mk_topic_node_attribute(_topic_buf, _config->node_handle,
-			"$state");
-	ret = _gn_homie_publish_str(_config->node_handle, _topic_buf, 1, 1,
-			(char*) _GN_HOMIE_READY);
+	ann.publish = true;
+	_gn_homie_mk_topic_node_attribute(_topic_buf, node, "$state");
+	ret = _gn_homie_announce_attr(&ann, _topic_buf, _GN_HOMIE_READY);
+
+#ifdef CONFIG_GROWNODE_MQTT_HOMIE_INCREMENTAL_ANNOUNCE
+	//fingerprints are stored once the broker acknowledges the ready state
+	if (ret == GN_RET_OK)
+		_gn_homie_announce_msg_id = ann.msg_id;
+#endif
 
 	if (ESP_OK
 			!= esp_event_post_to(_config->event_loop, GN_BASE_EVENT,
@@ -773,6 +1020,10 @@ gn_err_t gn_mqtt_subscribe_leaf(gn_leaf_handle_t _leaf) {
 
 	gn_leaf_handle_intl_t leaf = (gn_leaf_handle_intl_t) _leaf;
 
+	//already covered by the node wildcard or kept by the broker
+	if (_gn_mqtt_wildcard_active || _gn_mqtt_session_present)
+		return GN_RET_OK;
+
 //subscribe each parameter
 	gn_leaf_param_handle_intl_t _param_enum = leaf->params;
 	while (_param_enum) {
@@ -812,17 +1063,19 @@ esp_err_t gn_mqtt_subscribe_leaf_param(gn_leaf_param_handle_t _param) {
 	if (!leaf)
 		return GN_RET_ERR;
 
-	char _topic_buf[_GN_MQTT_MAX_TOPIC_LENGTH];
+	if (!param->topic_cmd)
+		return GN_RET_ERR;
 
-	_gn_homie_mk_topic_param_attribute(_topic_buf, _param, "set");
+	if (_gn_mqtt_session_present)
+		return GN_RET_OK;
 
 	int msg_id = esp_mqtt_client_subscribe(leaf->node->config->mqtt_client,
-			_topic_buf, 0);
+			param->topic_cmd, _GN_MQTT_SUBSCRIBE_QOS);
 
 	if (esp_log_level_get(TAG) == ESP_LOG_DEBUG) {
 		ESP_LOGD(TAG,
 				"gn_mqtt_subscribe_leaf_param, topic = %s, msg_id=%d. now waiting %d ms",
-				_topic_buf, msg_id, _GN_MQTT_DEBUG_WAIT_MS);
+				param->topic_cmd, msg_id, _GN_MQTT_DEBUG_WAIT_MS);
 		vTaskDelay(_GN_MQTT_DEBUG_WAIT_MS / portTICK_PERIOD_MS);
 	}
 
@@ -852,6 +1105,17 @@ gn_err_t gn_mqtt_start(gn_config_handle_t config) {
 			.lwt_msg = "lost", .lwt_qos = 1, .lwt_retain = 1, .buffer_size =
 			CONFIG_GROWNODE_MQTT_BUFFER_SIZE, .user_context = _config };
 
+#ifdef CONFIG_GROWNODE_MQTT_PERSISTENT_SESSION
+	//stable client id, so the broker can bind the node to its previous session
+	snprintf(_gn_mqtt_client_id, GN_MQTT_CLIENT_ID_SIZE,
+			"gn%02X%02X%02X%02X%02X%02X", _config->macAddress[0],
+			_config->macAddress[1], _config->macAddress[2],
+			_config->macAddress[3], _config->macAddress[4],
+			_config->macAddress[5]);
+	mqtt_cfg.client_id = _gn_mqtt_client_id;
+	mqtt_cfg.disable_clean_session = true;
+#endif
+
 	esp_mqtt_client_handle_t client = esp_mqtt_client_init(&mqtt_cfg);
 
 	if (client == NULL) {
@@ -1032,6 +1296,18 @@ gn_err_t gn_mqtt_send_keepalive(gn_node_handle_t _node) {
 	_gn_homie_mk_topic_node_attribute(_topic_buf, node, "$stats/freeheap");
 	_gn_homie_publish_int(node, _topic_buf, 0, 0, esp_get_free_heap_size());
 
+#ifdef CONFIG_GROWNODE_LATENCY_TRACE
+	cJSON *latency = gn_node_latency_to_json(node);
+	char *latency_buf = latency ? cJSON_PrintUnformatted(latency) : NULL;
+	if (latency_buf) {
+		_gn_homie_mk_topic_node_attribute(_topic_buf, node, "$stats/latency");
+		_gn_homie_publish(node, _topic_buf, 0, 0, latency_buf,
+				strlen(latency_buf));
+	}
+	free(latency_buf);
+	cJSON_Delete(latency);
+#endif
+
 	return GN_RET_OK;
 
 #else
@@ -1039,6 +1315,81 @@ gn_err_t gn_mqtt_send_keepalive(gn_node_handle_t _node) {
 #endif /* CONFIG_GROWNODE_WIFI_ENABLED */
 }
 
+#ifdef CONFIG_GROWNODE_RUNTIME_STATS
+/**
+ * @brief	publishes the runtime statistics of the node as one JSON message in $stats/runtime
+ *
+ * @param	_node	the node to inspect
+ *
+ * @return	GN_RET_ERR_MQTT_ERROR if the message cannot be published
+ */
+gn_err_t gn_mqtt_send_stats(gn_node_handle_t _node) {
+
+#ifdef CONFIG_GROWNODE_WIFI_ENABLED
+
+	if (!_node)
+		return GN_RET_ERR_INVALID_ARG;
+
+	gn_node_handle_intl_t node = (gn_node_handle_intl_t) _node;
+
+	if (node->config->status != GN_NODE_STATUS_STARTED)
+		return GN_RET_OK;
+
+	cJSON *stats = gn_node_stats_to_json(node);
+	char *buf = stats ? cJSON_PrintUnformatted(stats) : NULL;
+	cJSON_Delete(stats);
+	if (!buf)
+		return GN_RET_ERR_MQTT_ERROR;
+
+	char _topic_buf[_GN_MQTT_MAX_TOPIC_LENGTH];
+	_gn_homie_mk_topic_node_attribute(_topic_buf, node, "$stats/runtime");
+	gn_err_t ret = _gn_homie_publish(node, _topic_buf, 0, 0, buf, strlen(buf));
+	free(buf);
+
+	return ret == GN_RET_OK ? GN_RET_OK : GN_RET_ERR_MQTT_ERROR;
+
+#else
+	return GN_RET_OK;
+#endif /* CONFIG_GROWNODE_WIFI_ENABLED */
+}
+#endif /* CONFIG_GROWNODE_RUNTIME_STATS */
+
+#ifdef CONFIG_GROWNODE_BOOT_PROFILE
+/**
+ * @brief	publishes the boot phases timings as one retained JSON message in $stats/boot
+ *
+ * @param	_node	the started node
+ *
+ * @return	GN_RET_ERR_MQTT_ERROR if the message cannot be published
+ */
+gn_err_t gn_mqtt_send_boot_report(gn_node_handle_t _node) {
+
+#ifdef CONFIG_GROWNODE_WIFI_ENABLED
+
+	if (!_node)
+		return GN_RET_ERR_INVALID_ARG;
+
+	gn_node_handle_intl_t node = (gn_node_handle_intl_t) _node;
+
+	cJSON *report = gn_boot_report_to_json();
+	char *buf = report ? cJSON_PrintUnformatted(report) : NULL;
+	cJSON_Delete(report);
+	if (!buf)
+		return GN_RET_ERR_MQTT_ERROR;
+
+	char _topic_buf[_GN_MQTT_MAX_TOPIC_LENGTH];
+	_gn_homie_mk_topic_node_attribute(_topic_buf, node, "$stats/boot");
+	gn_err_t ret = _gn_homie_publish(node, _topic_buf, 1, 1, buf, strlen(buf));
+	free(buf);
+
+	return ret == GN_RET_OK ? GN_RET_OK : GN_RET_ERR_MQTT_ERROR;
+
+#else
+	return GN_RET_OK;
+#endif /* CONFIG_GROWNODE_WIFI_ENABLED */
+}
+#endif /* CONFIG_GROWNODE_BOOT_PROFILE */
+
 gn_err_t gn_mqtt_send_leaf_message(gn_leaf_handle_t leaf, const char *msg) {
 	return GN_RET_ERR;
 }
@@ -1061,10 +1412,9 @@ gn_err_t gn_mqtt_send_leaf_param(gn_leaf_param_handle_t _param) {
 
 	int ret = GN_RET_OK;
 
-	char _topic[_GN_MQTT_MAX_TOPIC_LENGTH];
-	char *buf = (char*) calloc(_GN_MQTT_MAX_PAYLOAD_LENGTH, sizeof(char));
-
-	_gn_homie_mk_topic_leaf_attribute(_topic, leaf, param->name);
+	const char *_topic = param->topic_sts;
+	if (!_topic)
+		return GN_RET_ERR;
 
 	switch (param->param_val->t) {
 	case GN_VAL_TYPE_BOOLEAN:
@@ -1095,7 +1445,6 @@ gn_err_t gn_mqtt_send_leaf_param(gn_leaf_param_handle_t _param) {
 	}
 
 	fail: {
-		free(buf);
 		return ret;
 	}
 
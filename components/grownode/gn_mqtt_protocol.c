@@ -19,6 +19,9 @@ extern "C" {
 #include "esp_log.h"
 #include "esp_event.h"
 #include "esp_check.h"
+#include "esp_system.h"
+#include "esp_attr.h"
+#include "esp_timer.h"
 #include "cJSON.h"
 
 #include "freertos/FreeRTOS.h"
@@ -28,6 +31,8 @@ extern "C" {
 
 #include "grownode_intl.h"
 #include "gn_mqtt_protocol.h"
+#include "gn_network.h"
+#include "gn_boot.h"
 
 #ifdef CONFIG_GROWNODE_MQTT_LEGACY_PROTOCOL
 
@@ -36,8 +41,25 @@ extern "C" {
 EventGroupHandle_t _gn_event_group_mqtt;
 const int _GN_MQTT_CONNECTED_EVENT_BIT = BIT0;
 const int _GN_MQTT_DISCONNECT_EVENT_BIT = BIT1;
+const int _GN_MQTT_SUBSCRIBED_EVENT_BIT = BIT2;
+const int _GN_MQTT_SUBSCRIBE_FAILED_EVENT_BIT = BIT3;
 
 const int _GN_MQTT_DEBUG_WAIT_MS = 500;
+const int _GN_MQTT_SUBSCRIBE_TIMEOUT_MS = 5000;
+
+//true when leaf and parameter commands are received through the node wildcard subscriptions. kept across deep sleeps to trust a session kept by the broker
+RTC_DATA_ATTR static bool _gn_mqtt_wildcard_active = false;
+static int _gn_mqtt_wildcard_msg_id = -1;
+
+//start of the current server connection, to measure transport, TLS and MQTT handshakes.
+//TLS sessions are not resumed: esp-mqtt does not expose the esp-tls session, every connection is a full handshake
+static int64_t _gn_mqtt_connect_start_us = 0;
+static int32_t _gn_mqtt_handshake_ms = 0;
+//true when the broker kept the MQTT session, and its subscriptions, from before the deep sleep
+static bool _gn_mqtt_session_present = false;
+#ifdef CONFIG_GROWNODE_MQTT_PERSISTENT_SESSION
+static char _gn_mqtt_client_id[GN_MQTT_CLIENT_ID_SIZE];
+#endif
 
 //static gn_server_status_t status = GN_SERVER_DISCONNECTED;
 
@@ -227,6 +249,197 @@ void _gn_mqtt_build_command_topic(gn_config_handle_intl_t config, char *buf) {
 
 }
 
+/**
+ * @brief	computes the leaf command and status topics once, storing them in the node topic arena
+ *
+ * @param	_leaf_config	the leaf, already bound to its node
+ *
+ * @return	GN_RET_ERR_INVALID_ARG	if the leaf is not bound to a node
+ * @return	GN_RET_ERR				if topics cannot be stored
+ * @return	GN_RET_OK				upon success
+ */
+gn_err_t gn_mqtt_build_leaf_topics(gn_leaf_handle_t _leaf_config) {
+
+#ifdef CONFIG_GROWNODE_WIFI_ENABLED
+
+	gn_leaf_handle_intl_t leaf_config = (gn_leaf_handle_intl_t) _leaf_config;
+
+	if (!leaf_config || !leaf_config->node)
+		return GN_RET_ERR_INVALID_ARG;
+
+	char buf[_GN_MQTT_MAX_TOPIC_LENGTH];
+
+	_gn_mqtt_build_leaf_command_topic(leaf_config, buf);
+	leaf_config->topic_cmd = gn_string_arena_add(leaf_config->node->topics,
+			buf);
+	_gn_mqtt_build_leaf_status_topic(leaf_config, buf);
+	leaf_config->topic_sts = gn_string_arena_add(leaf_config->node->topics,
+			buf);
+
+	if (!leaf_config->topic_cmd || !leaf_config->topic_sts) {
+		ESP_LOGE(TAG, "cannot store topics of leaf %s", leaf_config->name);
+		return GN_RET_ERR;
+	}
+
+	return GN_RET_OK;
+
+#else
+	return GN_RET_OK;
+#endif /* CONFIG_GROWNODE_WIFI_ENABLED */
+
+}
+
+/**
+ * @brief	computes the parameter command and status topics once, storing them in the node topic arena
+ *
+ * @param	_param		the parameter, already bound to its leaf
+ *
+ * @return	GN_RET_ERR_INVALID_ARG	if the parameter is not bound to a leaf
+ * @return	GN_RET_ERR				if topics cannot be stored
+ * @return	GN_RET_OK				upon success
+ */
+gn_err_t gn_mqtt_build_leaf_param_topics(gn_leaf_param_handle_t _param) {
+
+#ifdef CONFIG_GROWNODE_WIFI_ENABLED
+
+	gn_leaf_param_handle_intl_t param = (gn_leaf_param_handle_intl_t) _param;
+
+	if (!param || !param->leaf)
+		return GN_RET_ERR_INVALID_ARG;
+
+	gn_leaf_handle_intl_t leaf_config = (gn_leaf_handle_intl_t) param->leaf;
+	char buf[_GN_MQTT_MAX_TOPIC_LENGTH];
+
+	_gn_mqtt_build_leaf_parameter_command_topic(leaf_config, param->name, buf);
+	param->topic_cmd = gn_string_arena_add(leaf_config->node->topics, buf);
+	_gn_mqtt_build_leaf_parameter_status_topic(leaf_config, param->name, buf);
+	param->topic_sts = gn_string_arena_add(leaf_config->node->topics, buf);
+
+	if (!param->topic_cmd || !param->topic_sts) {
+		ESP_LOGE(TAG, "cannot store topics of param %s", param->name);
+		return GN_RET_ERR;
+	}
+
+	if (!gn_leaf_context_set(leaf_config->node->topic_index,
+			(char*) param->topic_cmd, param)) {
+		ESP_LOGE(TAG, "cannot index topic of param %s", param->name);
+		return GN_RET_ERR;
+	}
+
+	return GN_RET_OK;
+
+#else
+	return GN_RET_OK;
+#endif /* CONFIG_GROWNODE_WIFI_ENABLED */
+
+}
+
+/**
+ * @brief	finds the parameter whose command topic is the given one
+ *
+ * @param	node		the node to search within
+ * @param	topic		topic as received from the broker, not null terminated
+ * @param	topic_len	topic length
+ *
+ * @return	the parameter, NULL if not found
+ */
+gn_leaf_param_handle_intl_t _gn_mqtt_param_from_topic(gn_node_handle_intl_t node,
+		const char *topic, int topic_len) {
+
+	char key[_GN_MQTT_MAX_TOPIC_LENGTH];
+	if (topic_len <= 0 || topic_len >= _GN_MQTT_MAX_TOPIC_LENGTH)
+		return NULL;
+
+	memcpy(key, topic, topic_len);
+	key[topic_len] = '\0';
+
+	return gn_leaf_context_get(node->topic_index, key);
+
+}
+
+#ifdef CONFIG_GROWNODE_MQTT_WILDCARD_SUBSCRIPTION
+/**
+ * @brief	subscribes a node wildcard topic and waits for the broker acknowledge
+ *
+ * @return	true if the broker accepted the subscription
+ */
+static bool _gn_mqtt_subscribe_wildcard(gn_config_handle_intl_t config,
+		const char *topic) {
+
+	xEventGroupClearBits(_gn_event_group_mqtt,
+			_GN_MQTT_SUBSCRIBED_EVENT_BIT | _GN_MQTT_SUBSCRIBE_FAILED_EVENT_BIT);
+
+	_gn_mqtt_wildcard_msg_id = esp_mqtt_client_subscribe(config->mqtt_client,
+			topic, _GN_MQTT_SUBSCRIBE_QOS);
+	if (_gn_mqtt_wildcard_msg_id == -1) {
+		ESP_LOGW(TAG, "cannot subscribe %s", topic);
+		return false;
+	}
+
+	EventBits_t uxBits = xEventGroupWaitBits(_gn_event_group_mqtt,
+			_GN_MQTT_SUBSCRIBED_EVENT_BIT | _GN_MQTT_SUBSCRIBE_FAILED_EVENT_BIT,
+			pdTRUE, pdFALSE,
+			_GN_MQTT_SUBSCRIBE_TIMEOUT_MS / portTICK_PERIOD_MS);
+	_gn_mqtt_wildcard_msg_id = -1;
+
+	if ((uxBits & _GN_MQTT_SUBSCRIBED_EVENT_BIT) == 0) {
+		ESP_LOGW(TAG, "subscription to %s %s", topic,
+				(uxBits & _GN_MQTT_SUBSCRIBE_FAILED_EVENT_BIT) ?
+						"refused by the broker" : "not acknowledged");
+		return false;
+	}
+
+	return true;
+
+}
+
+/**
+ * @brief	subscribes leaf and parameter commands of the node with two wildcard topics
+ *
+ * @return	true if the broker accepted both subscriptions, false also if the topics do not fit
+ */
+static bool _gn_mqtt_subscribe_node_wildcards(gn_config_handle_intl_t config) {
+
+	char prefix[_GN_MQTT_MAX_TOPIC_LENGTH];
+	char topic[_GN_MQTT_MAX_TOPIC_LENGTH];
+	int len;
+
+	if (config->config_init_params->server_board_id_topic) {
+		len = snprintf(prefix, _GN_MQTT_MAX_TOPIC_LENGTH, "%s/%s/%s",
+				config->config_init_params->server_base_topic,
+				config->node_handle->name, _gn_mqtt_build_node_name(config));
+	} else {
+		len = snprintf(prefix, _GN_MQTT_MAX_TOPIC_LENGTH, "%s/%s",
+				config->config_init_params->server_base_topic,
+				config->node_handle->name);
+	}
+	if (len < 0 || len >= _GN_MQTT_MAX_TOPIC_LENGTH)
+		goto too_long;
+
+	//leaf commands
+	len = snprintf(topic, _GN_MQTT_MAX_TOPIC_LENGTH, "%s/+/%s", prefix,
+			_GN_MQTT_COMMAND_MESS);
+	if (len < 0 || len >= _GN_MQTT_MAX_TOPIC_LENGTH)
+		goto too_long;
+	if (!_gn_mqtt_subscribe_wildcard(config, topic))
+		return false;
+
+	//parameter commands
+	len = snprintf(topic, _GN_MQTT_MAX_TOPIC_LENGTH, "%s/+/+/%s", prefix,
+			_GN_MQTT_COMMAND_MESS);
+	if (len < 0 || len >= _GN_MQTT_MAX_TOPIC_LENGTH)
+		goto too_long;
+	return _gn_mqtt_subscribe_wildcard(config, topic);
+
+	too_long: {
+		ESP_LOGW(TAG, "node wildcard topics longer than %d characters",
+				_GN_MQTT_MAX_TOPIC_LENGTH - 1);
+		return false;
+	}
+
+}
+#endif /* CONFIG_GROWNODE_MQTT_WILDCARD_SUBSCRIPTION */
+
 /*
  * called when a MQTT_EVENT_PUBLISHED is sent.
  * handler_arg is the leaf to be checked against the topic to call his callback
@@ -292,18 +505,26 @@ gn_err_t gn_mqtt_subscribe_leaf(gn_leaf_handle_t _leaf_config) {
 	if (!config)
 		return GN_RET_ERR;
 
-	char topic[_GN_MQTT_MAX_TOPIC_LENGTH];
-	_gn_mqtt_build_leaf_command_topic(leaf_config, topic);
+	const char *topic = leaf_config->topic_cmd;
+	if (!topic)
+		return GN_RET_ERR;
 
-	if (esp_log_level_get(TAG) == ESP_LOG_DEBUG) {
-		ESP_LOGD(TAG, "gn_mqtt_subscribe_leaf - topic = %s. now waiting %d ms",
-				topic, _GN_MQTT_DEBUG_WAIT_MS);
-		vTaskDelay(_GN_MQTT_DEBUG_WAIT_MS / portTICK_PERIOD_MS);
-	}
+	//already covered by the node wildcards or kept by the broker
+	if (!_gn_mqtt_wildcard_active && !_gn_mqtt_session_present) {
+
+		if (esp_log_level_get(TAG) == ESP_LOG_DEBUG) {
+			ESP_LOGD(TAG,
+					"gn_mqtt_subscribe_leaf - topic = %s. now waiting %d ms",
+					topic, _GN_MQTT_DEBUG_WAIT_MS);
+			vTaskDelay(_GN_MQTT_DEBUG_WAIT_MS / portTICK_PERIOD_MS);
+		}
+
+		if (esp_mqtt_client_subscribe(config->mqtt_client, topic,
+				_GN_MQTT_SUBSCRIBE_QOS) == -1) {
+			ESP_LOGE(TAG, "subscribing error");
+			return GN_RET_ERR_MQTT_SUBSCRIBE;
+		}
 
-	if (esp_mqtt_client_subscribe(config->mqtt_client, topic, 0) == -1) {
-		ESP_LOGE(TAG, "subscribing error");
-		return GN_RET_ERR_MQTT_SUBSCRIBE;
 	}
 
 	//notify
@@ -312,8 +533,8 @@ gn_err_t gn_mqtt_subscribe_leaf(gn_leaf_handle_t _leaf_config) {
 		int _d_msg_id = -1;
 
 		char _d_msg_topic[_GN_MQTT_MAX_TOPIC_LENGTH + 1] = { 0 };
-		char *_d_payload = calloc(_GN_MQTT_MAX_PAYLOAD_LENGTH + 1,
-				sizeof(char));
+		char *_d_payload = gn_mem_calloc(GN_MEM_TAG_MQTT,
+				_GN_MQTT_MAX_PAYLOAD_LENGTH + 1, sizeof(char));
 
 		ESP_LOGD(TAG, "gn_mqtt_subscribe_leaf - building node config: %s",
 				_node_config->name);
@@ -346,10 +567,7 @@ gn_err_t gn_mqtt_subscribe_leaf(gn_leaf_handle_t _leaf_config) {
 			cJSON_AddStringToObject(root, "name", d_param_id);
 			cJSON_AddStringToObject(root, "device_class", "motion");
 
-			char _d_sts_topic[_GN_MQTT_MAX_TOPIC_LENGTH];
-			_gn_mqtt_build_leaf_parameter_status_topic(_leaf_config,
-					_param->name, _d_sts_topic);
-			cJSON_AddStringToObject(root, "state_topic", _d_sts_topic);
+			cJSON_AddStringToObject(root, "state_topic", _param->topic_sts);
 
 			//print json payload
 			if (!cJSON_PrintPreallocated(root, _d_payload,
@@ -379,7 +597,7 @@ gn_err_t gn_mqtt_subscribe_leaf(gn_leaf_handle_t _leaf_config) {
 		}
 
 		fail: {
-			free(_d_payload);
+			gn_mem_free(_d_payload);
 			return ((_d_msg_id == -1) ? (GN_RET_ERR_MQTT_ERROR) : (GN_RET_OK));
 		}
 
@@ -406,13 +624,17 @@ gn_err_t gn_mqtt_subscribe_leaf_param(gn_leaf_param_handle_t _param) {
 
 	//ESP_LOGD(TAG, "subscribing param %s on %s", param->name, leaf_config->name);
 
-	char topic[_GN_MQTT_MAX_TOPIC_LENGTH];
-	_gn_mqtt_build_leaf_parameter_command_topic(leaf_config, param->name,
-			topic);
+	const char *topic = param->topic_cmd;
+	if (!topic)
+		return GN_RET_ERR;
 
 	ESP_LOGD(TAG, "gn_mqtt_subscribe_leaf_param. topic: %s", topic);
 
-	int msg_id = esp_mqtt_client_subscribe(config->mqtt_client, topic, 0);
+	if (_gn_mqtt_session_present)
+		return GN_RET_OK;
+
+	int msg_id = esp_mqtt_client_subscribe(config->mqtt_client, topic,
+			_GN_MQTT_SUBSCRIBE_QOS);
 
 	if (esp_log_level_get(TAG) == ESP_LOG_DEBUG) {
 		ESP_LOGD(TAG,
@@ -429,6 +651,34 @@ gn_err_t gn_mqtt_subscribe_leaf_param(gn_leaf_param_handle_t _param) {
 
 }
 
+#ifdef CONFIG_GROWNODE_LATENCY_TRACE
+/**
+ * @brief	publishes the command latency of the leaves in the node status topic
+ */
+static void _gn_mqtt_send_latency(gn_node_handle_intl_t node) {
+
+	cJSON *root = cJSON_CreateObject();
+	if (!root)
+		return;
+
+	cJSON_AddStringToObject(root, "msgtype", "latency");
+	cJSON_AddStringToObject(root, "name", node->name);
+	cJSON *leaves = gn_node_latency_to_json(node);
+	if (leaves)
+		cJSON_AddItemToObject(root, "leaves", leaves);
+
+	char *buf = cJSON_PrintUnformatted(root);
+	if (buf
+			&& esp_mqtt_client_publish(node->config->mqtt_client, _gn_sts_topic,
+					buf, 0, 0, 0) == -1)
+		ESP_LOGW(TAG, "_gn_mqtt_send_latency: publish failed");
+
+	free(buf);
+	cJSON_Delete(root);
+
+}
+#endif
+
 /**
  *
  * @brief send node parameters via JSON message to the server
@@ -459,8 +709,8 @@ gn_err_t gn_mqtt_send_keepalive(gn_node_handle_t _node_config) {
 
 //build
 	gn_mqtt_node_config_message_handle_t msg =
-			(gn_mqtt_node_config_message_handle_t) malloc(
-					sizeof(gn_mqtt_node_config_message_t));
+			(gn_mqtt_node_config_message_handle_t) gn_mem_malloc(
+					GN_MEM_TAG_MQTT, sizeof(gn_mqtt_node_config_message_t));
 
 	msg->config = _node_config;
 	strncpy(msg->topic, _gn_sts_topic, _GN_MQTT_MAX_TOPIC_LENGTH);
@@ -471,7 +721,8 @@ gn_err_t gn_mqtt_send_keepalive(gn_node_handle_t _node_config) {
 
 //payload
 	int msg_id = -1;
-	char *buf = (char*) calloc(_GN_MQTT_MAX_PAYLOAD_LENGTH, sizeof(char));
+	char *buf = (char*) gn_mem_calloc(GN_MEM_TAG_MQTT,
+			_GN_MQTT_MAX_PAYLOAD_LENGTH, sizeof(char));
 
 	cJSON *root, *leaves, *leaf, *leaf_name, *leaf_params, *leaf_param;
 	root = cJSON_CreateObject();
@@ -557,10 +808,14 @@ gn_err_t gn_mqtt_send_keepalive(gn_node_handle_t _node_config) {
 	ESP_LOGD(TAG, "sent publish successful, msg_id=%d, topic=%s, payload=%s",
 			msg_id, msg->topic, buf);
 
+#ifdef CONFIG_GROWNODE_LATENCY_TRACE
+	_gn_mqtt_send_latency(node_config);
+#endif
+
 	fail: {
 		cJSON_Delete(root);
-		free(buf);
-		free(msg);
+		gn_mem_free(buf);
+		gn_mem_free(msg);
 		return ((msg_id == -1) ? (GN_RET_ERR_MQTT_ERROR) : (GN_RET_OK));
 	}
 
@@ -572,6 +827,109 @@ gn_err_t gn_mqtt_send_keepalive(gn_node_handle_t _node_config) {
 
 }
 
+#ifdef CONFIG_GROWNODE_RUNTIME_STATS
+/**
+ * @brief	publishes the runtime statistics of the node as one message in the node status topic
+ *
+ * @param	_node	the node to inspect
+ *
+ * @return	GN_RET_ERR_MQTT_ERROR if the message cannot be published
+ */
+gn_err_t gn_mqtt_send_stats(gn_node_handle_t _node) {
+
+#ifdef CONFIG_GROWNODE_WIFI_ENABLED
+
+	if (!_node)
+		return GN_RET_ERR_INVALID_ARG;
+
+	gn_node_handle_intl_t node = (gn_node_handle_intl_t) _node;
+
+	if (node->config->status != GN_NODE_STATUS_STARTED)
+		return GN_RET_OK;
+
+	gn_err_t ret = GN_RET_ERR_MQTT_ERROR;
+	char *buf = NULL;
+
+	cJSON *root = gn_node_stats_to_json(node);
+	if (!root)
+		goto fail;
+
+	cJSON_AddStringToObject(root, "msgtype", "stats");
+	cJSON_AddStringToObject(root, "name", node->name);
+
+	buf = cJSON_PrintUnformatted(root);
+	if (!buf)
+		goto fail;
+
+	if (esp_mqtt_client_publish(node->config->mqtt_client, _gn_sts_topic, buf,
+			0, 0, 0) == -1)
+		goto fail;
+
+	ret = GN_RET_OK;
+
+	fail: {
+		free(buf);
+		cJSON_Delete(root);
+		return ret;
+	}
+
+#else
+	return GN_RET_OK;
+#endif /* CONFIG_GROWNODE_WIFI_ENABLED */
+
+}
+#endif /* CONFIG_GROWNODE_RUNTIME_STATS */
+
+#ifdef CONFIG_GROWNODE_BOOT_PROFILE
+/**
+ * @brief	publishes the boot phases timings as a "boot" message in the node status topic
+ *
+ * @param	_node	the started node
+ *
+ * @return	GN_RET_ERR_MQTT_ERROR if the message cannot be published
+ */
+gn_err_t gn_mqtt_send_boot_report(gn_node_handle_t _node) {
+
+#ifdef CONFIG_GROWNODE_WIFI_ENABLED
+
+	if (!_node)
+		return GN_RET_ERR_INVALID_ARG;
+
+	gn_node_handle_intl_t node = (gn_node_handle_intl_t) _node;
+
+	gn_err_t ret = GN_RET_ERR_MQTT_ERROR;
+	char *buf = NULL;
+
+	cJSON *root = gn_boot_report_to_json();
+	if (!root)
+		goto fail;
+
+	cJSON_AddStringToObject(root, "msgtype", "boot");
+	cJSON_AddStringToObject(root, "name", node->name);
+
+	buf = cJSON_PrintUnformatted(root);
+	if (!buf)
+		goto fail;
+
+	if (esp_mqtt_client_publish(node->config->mqtt_client, _gn_sts_topic, buf,
+			0, 1, 0) == -1)
+		goto fail;
+
+	ret = GN_RET_OK;
+
+	fail: {
+		free(buf);
+		cJSON_Delete(root);
+		return ret;
+	}
+
+#else
+	return GN_RET_OK;
+#endif /* CONFIG_GROWNODE_WIFI_ENABLED */
+
+}
+#endif /* CONFIG_GROWNODE_BOOT_PROFILE */
+
 gn_err_t gn_mqtt_send_leaf_param(gn_leaf_param_handle_t _param) {
 
 #ifdef CONFIG_GROWNODE_WIFI_ENABLED
@@ -593,12 +951,13 @@ gn_err_t gn_mqtt_send_leaf_param(gn_leaf_param_handle_t _param) {
 	int ret = GN_RET_OK;
 
 	int msg_id = -1;
-	char _topic[_GN_MQTT_MAX_TOPIC_LENGTH];
-	char *buf = (char*) calloc(_GN_MQTT_MAX_PAYLOAD_LENGTH, sizeof(char));
-//char dbuf[30]; //TODO get max double length
+	const char *_topic = param->topic_sts;
+	if (!_topic)
+		return GN_RET_ERR;
 
-	_gn_mqtt_build_leaf_parameter_status_topic(param->leaf, param->name,
-			_topic);
+	char *buf = (char*) gn_mem_calloc(GN_MEM_TAG_MQTT,
+			_GN_MQTT_MAX_PAYLOAD_LENGTH, sizeof(char));
+//char dbuf[30]; //TODO get max double length
 
 	switch (param->param_val->t) {
 	case GN_VAL_TYPE_BOOLEAN:
@@ -642,7 +1001,7 @@ gn_err_t gn_mqtt_send_leaf_param(gn_leaf_param_handle_t _param) {
 	}
 
 	fail: {
-		free(buf);
+		gn_mem_free(buf);
 		return ((msg_id == -1) ? (GN_RET_ERR_MQTT_ERROR) : (GN_RET_OK));
 	}
 
@@ -713,7 +1072,8 @@ gn_err_t gn_mqtt_send_log_message(gn_config_handle_t _config, char *log_tag,
 
 	if ((int) esp_log_level_get(log_tag) >= (int) level) {
 
-		char *buf = (char*) calloc(_GN_MQTT_MAX_PAYLOAD_LENGTH, sizeof(char));
+		char *buf = (char*) gn_mem_calloc(GN_MEM_TAG_MQTT,
+			_GN_MQTT_MAX_PAYLOAD_LENGTH, sizeof(char));
 
 		cJSON *root = cJSON_CreateObject();
 		cJSON_AddStringToObject(root, "msgtype", "log");
@@ -726,23 +1086,23 @@ gn_err_t gn_mqtt_send_log_message(gn_config_handle_t _config, char *log_tag,
 			ESP_LOGE(TAG,
 					"gn_mqtt_send_node_config: cannot print json message");
 			cJSON_Delete(root);
+			gn_mem_free(buf);
 			return GN_RET_ERR;
 		}
+		cJSON_Delete(root);
 
 		int msg_id = esp_mqtt_client_publish(config->mqtt_client, _gn_log_topic,
 				buf, 0, 0, 0);
 
-		if (msg_id == -1) {
-			cJSON_Delete(root);
+		if (msg_id == -1)
 			goto fail;
-		}
 
 		ESP_LOGD(TAG,
 				"sent publish successful, msg_id=%d, topic=%s, payload=%s",
 				msg_id, _gn_log_topic, buf);
 
 		fail: {
-			free(buf);
+			gn_mem_free(buf);
 			return ((msg_id == -1) ? (GN_RET_ERR_MQTT_ERROR) : (GN_RET_OK));
 		}
 
@@ -780,19 +1140,32 @@ gn_err_t gn_mqtt_send_startup_message(gn_config_handle_t _config) {
 
 //build
 	gn_mqtt_startup_message_handle_t msg =
-			(gn_mqtt_startup_message_handle_t) malloc(
-					sizeof(gn_mqtt_startup_message_t));
+			(gn_mqtt_startup_message_handle_t) gn_mem_malloc(
+					GN_MEM_TAG_MQTT, sizeof(gn_mqtt_startup_message_t));
 
 	msg->config = config;
 	strncpy(msg->topic, _gn_sts_topic, _GN_MQTT_MAX_TOPIC_LENGTH);
 
 //payload
 	int msg_id = -1;
-	char *buf = (char*) calloc(_GN_MQTT_MAX_PAYLOAD_LENGTH, sizeof(char));
+	char *buf = (char*) gn_mem_calloc(GN_MEM_TAG_MQTT,
+			_GN_MQTT_MAX_PAYLOAD_LENGTH, sizeof(char));
+
+	gn_wifi_timings_t timings;
+	gn_wifi_get_timings(&timings);
 
 	cJSON *root;
 	root = cJSON_CreateObject();
 	cJSON_AddStringToObject(root, "msgtype", "online");
+
+	//connection timings
+	cJSON *timings_json = cJSON_AddObjectToObject(root, "timings");
+	cJSON_AddNumberToObject(timings_json, "wifi_associate_ms",
+			timings.associate_ms);
+	cJSON_AddNumberToObject(timings_json, "wifi_address_ms", timings.ip_ms);
+	cJSON_AddBoolToObject(timings_json, "wifi_cached", timings.fast);
+	cJSON_AddNumberToObject(timings_json, "mqtt_connect_ms",
+			_gn_mqtt_handshake_ms);
 	if (!cJSON_PrintPreallocated(root, buf, _GN_MQTT_MAX_PAYLOAD_LENGTH,
 	false)) {
 		ESP_LOGE(TAG, "cannot print json message");
@@ -819,8 +1192,8 @@ gn_err_t gn_mqtt_send_startup_message(gn_config_handle_t _config) {
 			msg_id, msg->topic, buf);
 
 	fail: {
-		free(buf);
-		free(msg);
+		gn_mem_free(buf);
+		gn_mem_free(msg);
 		return ((msg_id == -1) ? (GN_RET_ERR_MQTT_ERROR) : (GN_RET_OK));
 	}
 
@@ -855,15 +1228,16 @@ gn_err_t gn_mqtt_send_reboot_message(gn_config_handle_t _config) {
 
 //build
 	gn_mqtt_startup_message_handle_t msg =
-			(gn_mqtt_startup_message_handle_t) malloc(
-					sizeof(gn_mqtt_startup_message_t));
+			(gn_mqtt_startup_message_handle_t) gn_mem_malloc(
+					GN_MEM_TAG_MQTT, sizeof(gn_mqtt_startup_message_t));
 
 	msg->config = config;
 	strncpy(msg->topic, _gn_sts_topic, _GN_MQTT_MAX_TOPIC_LENGTH);
 
 //payload
 	int msg_id = -1;
-	char *buf = (char*) calloc(_GN_MQTT_MAX_PAYLOAD_LENGTH, sizeof(char));
+	char *buf = (char*) gn_mem_calloc(GN_MEM_TAG_MQTT,
+			_GN_MQTT_MAX_PAYLOAD_LENGTH, sizeof(char));
 
 	cJSON *root;
 	root = cJSON_CreateObject();
@@ -887,8 +1261,8 @@ gn_err_t gn_mqtt_send_reboot_message(gn_config_handle_t _config) {
 			msg_id, msg->topic, buf);
 
 	fail: {
-		free(buf);
-		free(msg);
+		gn_mem_free(buf);
+		gn_mem_free(msg);
 		return ((msg_id == -1) ? (GN_RET_ERR_MQTT_ERROR) : (GN_RET_OK));
 	}
 
@@ -926,15 +1300,16 @@ gn_err_t gn_mqtt_send_reset_message(gn_config_handle_t _config) {
 
 //build
 	gn_mqtt_startup_message_handle_t msg =
-			(gn_mqtt_startup_message_handle_t) malloc(
-					sizeof(gn_mqtt_startup_message_t));
+			(gn_mqtt_startup_message_handle_t) gn_mem_malloc(
+					GN_MEM_TAG_MQTT, sizeof(gn_mqtt_startup_message_t));
 
 	msg->config = config;
 	strncpy(msg->topic, _gn_sts_topic, _GN_MQTT_MAX_TOPIC_LENGTH);
 
 //payload
 	int msg_id = -1;
-	char *buf = (char*) calloc(_GN_MQTT_MAX_PAYLOAD_LENGTH, sizeof(char));
+	char *buf = (char*) gn_mem_calloc(GN_MEM_TAG_MQTT,
+			_GN_MQTT_MAX_PAYLOAD_LENGTH, sizeof(char));
 
 	cJSON *root;
 	root = cJSON_CreateObject();
@@ -958,8 +1333,8 @@ gn_err_t gn_mqtt_send_reset_message(gn_config_handle_t _config) {
 			msg_id, msg->topic, buf);
 
 	fail: {
-		free(buf);
-		free(msg);
+		gn_mem_free(buf);
+		gn_mem_free(msg);
 		return ((msg_id == -1) ? (GN_RET_ERR_MQTT_ERROR) : (GN_RET_OK));
 	}
 
@@ -994,15 +1369,16 @@ gn_err_t gn_mqtt_send_ota_message(gn_config_handle_t _config) {
 
 //build
 	gn_mqtt_startup_message_handle_t msg =
-			(gn_mqtt_startup_message_handle_t) malloc(
-					sizeof(gn_mqtt_startup_message_t));
+			(gn_mqtt_startup_message_handle_t) gn_mem_malloc(
+					GN_MEM_TAG_MQTT, sizeof(gn_mqtt_startup_message_t));
 
 	msg->config = config;
 	strncpy(msg->topic, _gn_sts_topic, _GN_MQTT_MAX_TOPIC_LENGTH);
 
 //payload
 	int msg_id = -1;
-	char *buf = (char*) calloc(_GN_MQTT_MAX_PAYLOAD_LENGTH, sizeof(char));
+	char *buf = (char*) gn_mem_calloc(GN_MEM_TAG_MQTT,
+			_GN_MQTT_MAX_PAYLOAD_LENGTH, sizeof(char));
 
 	cJSON *root;
 	root = cJSON_CreateObject();
@@ -1026,8 +1402,8 @@ gn_err_t gn_mqtt_send_ota_message(gn_config_handle_t _config) {
 			msg_id, msg->topic, buf);
 
 	fail: {
-		free(buf);
-		free(msg);
+		gn_mem_free(buf);
+		gn_mem_free(msg);
 		return ((msg_id == -1) ? (GN_RET_ERR_MQTT_ERROR) : (GN_RET_OK));
 	}
 
@@ -1098,16 +1474,38 @@ esp_err_t _gn_mqtt_on_connected(gn_config_handle_t config) {
 
 	gn_config_handle_intl_t _config = (gn_config_handle_intl_t) config;
 
-	int msg_id = esp_mqtt_client_subscribe(_config->mqtt_client, _gn_cmd_topic,
-	_GN_MQTT_DEFAULT_QOS);
+	if (!_gn_mqtt_session_present) {
+
+		int msg_id = esp_mqtt_client_subscribe(_config->mqtt_client,
+				_gn_cmd_topic, _GN_MQTT_SUBSCRIBE_QOS);
 
-	if (msg_id == -1) {
-		ESP_LOGE(TAG, "error subscribing default topic %s, msg_id=%d",
+		if (msg_id == -1) {
+			ESP_LOGE(TAG, "error subscribing default topic %s, msg_id=%d",
+					_gn_cmd_topic, msg_id);
+			goto fail;
+		}
+		ESP_LOGD(TAG, "subscribing default topic %s, msg_id=%d",
 				_gn_cmd_topic, msg_id);
-		goto fail;
+
+	}
+
+#ifdef CONFIG_GROWNODE_MQTT_WILDCARD_SUBSCRIPTION
+	//unless the broker kept the subscriptions, in the mode they were made: wildcards on top of kept per leaf topics would deliver commands twice
+	if (!_gn_mqtt_session_present)
+		_gn_mqtt_wildcard_active = _gn_mqtt_subscribe_node_wildcards(_config);
+	ESP_LOGI(TAG, "subscription mode: %s",
+			_gn_mqtt_wildcard_active ? "wildcard" : "per leaf");
+
+	//leaves already started (wake up from sleep) need their topics again on fallback
+	if (!_gn_mqtt_wildcard_active
+			&& _config->status == GN_NODE_STATUS_SLEEPING) {
+		for (int i = 0; i < _config->node_handle->leaves.last; i++) {
+			if (gn_mqtt_subscribe_leaf(_config->node_handle->leaves.at[i])
+					!= GN_RET_OK)
+				goto fail;
+		}
 	}
-	ESP_LOGD(TAG, "subscribing default topic %s, msg_id=%d", _gn_cmd_topic,
-			msg_id);
+#endif
 
 //send hello message
 	if (ESP_OK != gn_mqtt_send_startup_message(_config)) {
@@ -1184,8 +1582,23 @@ void _gn_mqtt_event_handler(void *handler_args, esp_event_base_t base,
 
 //int msg_id;
 	switch ((esp_mqtt_event_id_t) event_id) {
+	case MQTT_EVENT_BEFORE_CONNECT:
+		ESP_LOGD(TAG, "MQTT_EVENT_BEFORE_CONNECT");
+		_gn_mqtt_connect_start_us = esp_timer_get_time();
+		break;
+
 	case MQTT_EVENT_CONNECTED:
 		ESP_LOGD(TAG, "MQTT_EVENT_CONNECTED");
+		_gn_mqtt_handshake_ms = (esp_timer_get_time()
+				- _gn_mqtt_connect_start_us) / 1000;
+		ESP_LOGI(TAG, "server connected in %d ms, broker session %s",
+				_gn_mqtt_handshake_ms,
+				event->session_present ? "present" : "new");
+#ifdef CONFIG_GROWNODE_MQTT_PERSISTENT_SESSION
+		//subscriptions are trusted only on deep sleep wake up, a power on may run a different firmware
+		_gn_mqtt_session_present = event->session_present
+				&& esp_reset_reason() == ESP_RST_DEEPSLEEP;
+#endif
 		xEventGroupSetBits(_gn_event_group_mqtt, _GN_MQTT_CONNECTED_EVENT_BIT);
 
 		/*
@@ -1210,10 +1623,20 @@ void _gn_mqtt_event_handler(void *handler_args, esp_event_base_t base,
 
 		break;
 
+	case MQTT_EVENT_SUBSCRIBED:
+		ESP_LOGD(TAG, "MQTT_EVENT_SUBSCRIBED, msg_id=%d", event->msg_id);
+		if (event->msg_id == _gn_mqtt_wildcard_msg_id) {
+			//SUBACK return code 0x80 means the broker refused the topic filter
+			if (event->data_len > 0 && (uint8_t) event->data[0] == 0x80) {
+				xEventGroupSetBits(_gn_event_group_mqtt,
+						_GN_MQTT_SUBSCRIBE_FAILED_EVENT_BIT);
+			} else {
+				xEventGroupSetBits(_gn_event_group_mqtt,
+						_GN_MQTT_SUBSCRIBED_EVENT_BIT);
+			}
+		}
+		break;
 		/*
-		 case MQTT_EVENT_SUBSCRIBED:
-		 ESP_LOGD(TAG, "MQTT_EVENT_SUBSCRIBED, msg_id=%d", event->msg_id);
-		 break;
 		 case MQTT_EVENT_UNSUBSCRIBED:
 		 ESP_LOGD(TAG, "MQTT_EVENT_UNSUBSCRIBED, msg_id=%d", event->msg_id);
 		 break;
@@ -1223,6 +1646,9 @@ void _gn_mqtt_event_handler(void *handler_args, esp_event_base_t base,
 		 */
 	case MQTT_EVENT_DATA:
 		//TODO here the code to forward the call to appropriate node/leaf or system handler. start from remote OTA and RST
+#ifdef CONFIG_GROWNODE_LATENCY_TRACE
+		gn_trace_begin();
+#endif
 		ESP_LOGD(TAG, "MQTT_EVENT_DATA");
 		ESP_LOGD(TAG, "TOPIC=%.*s\r\n", event->topic_len, event->topic);
 		ESP_LOGD(TAG, "DATA=%.*s\r\n", event->data_len, event->data);
@@ -1273,16 +1699,34 @@ void _gn_mqtt_event_handler(void *handler_args, esp_event_base_t base,
 
 		} else {
 			//forward message to the appropriate leaf
-			char leaf_topic[_GN_MQTT_MAX_TOPIC_LENGTH];
-			char param_topic[_GN_MQTT_MAX_TOPIC_LENGTH];
 			gn_leaf_parameter_event_t evt;
 
+			//message is for a parameter
+			gn_leaf_param_handle_intl_t _param = _gn_mqtt_param_from_topic(
+					config->node_handle, event->topic, event->topic_len);
+			if (_param) {
+
+				gn_leaf_handle_intl_t _leaf =
+						(gn_leaf_handle_intl_t) _param->leaf;
+				if (GN_RET_OK
+						!= _gn_leaf_parameter_update(_leaf, _param->name,
+								event->data, event->data_len)) {
+					ESP_LOGE(TAG,
+							"error in updating parameter %s with value %s to leaf %s",
+							_param->name, event->data, _leaf->name);
+				}
+				break;
+
+			}
+
 			for (int i = 0; i < config->node_handle->leaves.last; i++) {
 
 				//message is for this leaf
-				_gn_mqtt_build_leaf_command_topic(
-						config->node_handle->leaves.at[i], leaf_topic);
-				if (strncmp(leaf_topic, event->topic, event->topic_len) == 0) {
+				const char *leaf_topic =
+						config->node_handle->leaves.at[i]->topic_cmd;
+				if (leaf_topic
+						&& strncmp(leaf_topic, event->topic, event->topic_len)
+								== 0) {
 
 					evt.id = GN_LEAF_MESSAGE_RECEIVED_EVENT;
 					strncpy(evt.leaf_name,
@@ -1309,52 +1753,6 @@ void _gn_mqtt_event_handler(void *handler_args, esp_event_base_t base,
 					break;
 				}
 
-				gn_leaf_param_handle_intl_t _param =
-						(gn_leaf_param_handle_intl_t) config->node_handle->leaves.at[i]->params;
-				while (_param) {
-					//message is for a parameter of this leaf
-					_gn_mqtt_build_leaf_parameter_command_topic(
-							config->node_handle->leaves.at[i], _param->name,
-							param_topic);
-					if (strncmp(param_topic, event->topic, event->topic_len)
-							== 0) {
-
-						if (GN_RET_OK
-								!= _gn_leaf_parameter_update(
-										config->node_handle->leaves.at[i],
-										_param->name, event->data,
-										event->data_len)) {
-							ESP_LOGE(TAG,
-									"error in updating parameter %s with value %s to leaf %s",
-									_param->name, event->data,
-									config->node_handle->leaves.at[i]->name);
-							break;
-						}
-
-						/*
-						 evt.id = GN_LEAF_PARAM_MESSAGE_RECEIVED_EVENT;
-						 strncpy(evt.leaf_name,
-						 _config->node->leaves.at[i]->name,
-						 GN_LEAF_NAME_SIZE);
-						 strncpy(evt.param_name, _param->name,
-						 GN_LEAF_PARAM_NAME_SIZE);
-						 evt.data = event->data;
-						 evt.data_size = event->data_len;
-
-						 //send event to the whole node
-						 if (esp_event_post_to(_config->event_loop,
-						 GN_BASE_EVENT, evt.id, &evt, sizeof(evt),
-						 0) != ESP_OK) {
-						 ESP_LOGE(TAG,
-						 "not possible to send param message to event loop");
-						 }
-						 */
-
-						break;
-					}
-					_param = _param->next;
-				}
-
 			}
 
 			break;
@@ -1414,6 +1812,17 @@ gn_err_t gn_mqtt_start(gn_config_handle_t config) {
 					1, .buffer_size = CONFIG_GROWNODE_MQTT_BUFFER_SIZE,
 			.user_context = _config };
 
+#ifdef CONFIG_GROWNODE_MQTT_PERSISTENT_SESSION
+	//stable client id, so the broker can bind the node to its previous session
+	snprintf(_gn_mqtt_client_id, GN_MQTT_CLIENT_ID_SIZE,
+			"gn%02X%02X%02X%02X%02X%02X", _config->macAddress[0],
+			_config->macAddress[1], _config->macAddress[2],
+			_config->macAddress[3], _config->macAddress[4],
+			_config->macAddress[5]);
+	mqtt_cfg.client_id = _gn_mqtt_client_id;
+	mqtt_cfg.disable_clean_session = true;
+#endif
+
 	esp_mqtt_client_handle_t client = esp_mqtt_client_init(&mqtt_cfg);
 
 	if (client == NULL) {
@@ -37,6 +37,19 @@ extern "C" {
 
 #define _GN_MQTT_DEFAULT_QOS 0
 
+#ifdef CONFIG_GROWNODE_MQTT_PERSISTENT_SESSION
+//commands shall be queued by the broker while the node sleeps
+#define _GN_MQTT_SUBSCRIBE_QOS 1
+#else
+#define _GN_MQTT_SUBSCRIBE_QOS _GN_MQTT_DEFAULT_QOS
+#endif
+
+#define GN_MQTT_CLIENT_ID_SIZE 16
+
+gn_err_t gn_mqtt_build_leaf_topics(gn_leaf_handle_t leaf_config);
+
+gn_err_t gn_mqtt_build_leaf_param_topics(gn_leaf_param_handle_t param);
+
 gn_err_t gn_mqtt_subscribe_leaf(gn_leaf_handle_t leaf_config);
 
 esp_err_t gn_mqtt_subscribe_leaf_param(gn_leaf_param_handle_t param);
@@ -53,6 +66,14 @@ gn_err_t gn_mqtt_reconnect(gn_config_handle_t config);
 
 gn_err_t gn_mqtt_send_keepalive(gn_node_handle_t conf);
 
+#ifdef CONFIG_GROWNODE_RUNTIME_STATS
+gn_err_t gn_mqtt_send_stats(gn_node_handle_t node);
+#endif
+
+#ifdef CONFIG_GROWNODE_BOOT_PROFILE
+gn_err_t gn_mqtt_send_boot_report(gn_node_handle_t node);
+#endif
+
 gn_err_t gn_mqtt_send_leaf_message(gn_leaf_handle_t leaf,
 		const char *msg);
 
@@ -29,12 +29,13 @@ extern "C" {
 #include "esp_err.h"
 #include "esp_spiffs.h"
 #include "esp_vfs.h"
+#include "esp_attr.h"
+#include "esp_timer.h"
 
 #ifdef CONFIG_GROWNODE_WIFI_ENABLED
 #include "esp_wifi.h"
 #include "esp_ota_ops.h"
 #include "esp_http_client.h"
-#include "esp_https_ota.h"
 //#include "esp_smartconfig.h"
 
 #include "wifi_provisioning/manager.h"
@@ -50,6 +51,9 @@ extern "C" {
 #include "esp_sntp.h"
 
 #include "grownode_intl.h"
+#include "gn_network.h"
+#include "gn_scheduler.h"
+#include "gn_ota.h"
 
 #define TAG "gn_network"
 
@@ -65,6 +69,160 @@ int s_retry_num = 0;
 
 gn_config_handle_intl_t _conf;
 
+#ifdef CONFIG_GROWNODE_WIFI_ENABLED
+
+static esp_netif_t *_gn_wifi_sta_netif = NULL;
+
+//connection phases of the last connection
+static int64_t _gn_wifi_start_us = 0;
+static int64_t _gn_wifi_associated_us = 0;
+static gn_wifi_timings_t _gn_wifi_timings = { 0 };
+
+#ifdef CONFIG_GROWNODE_WIFI_FAST_RECONNECT
+
+//last access point and address the node connected to, kept across deep sleeps
+typedef struct {
+	bool valid;
+	uint8_t bssid[6];
+	uint8_t channel;
+	esp_netif_ip_info_t ip_info;
+	esp_netif_dns_info_t dns;
+	uint8_t ip_reuse_count;
+} gn_wifi_cache_t;
+
+RTC_DATA_ATTR static gn_wifi_cache_t _gn_wifi_cache;
+
+//true while connecting to the cached access point
+static bool _gn_wifi_fast_attempt = false;
+//true when the cached address is configured instead of DHCP
+static bool _gn_wifi_static_ip = false;
+
+/**
+ * @brief	configures the station to connect directly to the cached access point, and with the cached address
+ */
+static void _gn_wifi_cache_apply(void) {
+
+	_gn_wifi_fast_attempt = false;
+
+	if (!_gn_wifi_cache.valid)
+		return;
+
+	wifi_config_t wifi_config;
+
+	//the directed connection shall not be stored in flash, a power on always scans
+	esp_wifi_set_storage(WIFI_STORAGE_RAM);
+
+	if (esp_wifi_get_config(WIFI_IF_STA, &wifi_config) != ESP_OK)
+		return;
+
+	memcpy(wifi_config.sta.bssid, _gn_wifi_cache.bssid, 6);
+	wifi_config.sta.bssid_set = true;
+	wifi_config.sta.channel = _gn_wifi_cache.channel;
+
+	if (esp_wifi_set_config(WIFI_IF_STA, &wifi_config) != ESP_OK)
+		return;
+
+	_gn_wifi_fast_attempt = true;
+
+#ifdef CONFIG_GROWNODE_WIFI_FAST_RECONNECT_REUSE_IP
+	if (_gn_wifi_cache.ip_reuse_count
+			>= CONFIG_GROWNODE_WIFI_FAST_RECONNECT_IP_REUSE_MAX) {
+
+		//lease too old, ask DHCP again
+		if (_gn_wifi_static_ip) {
+			esp_netif_dhcpc_start(_gn_wifi_sta_netif);
+			_gn_wifi_static_ip = false;
+		}
+
+	} else if (!_gn_wifi_static_ip) {
+
+		esp_err_t ret = esp_netif_dhcpc_stop(_gn_wifi_sta_netif);
+		if ((ret == ESP_OK || ret == ESP_ERR_ESP_NETIF_DHCP_ALREADY_STOPPED)
+				&& esp_netif_set_ip_info(_gn_wifi_sta_netif,
+						&_gn_wifi_cache.ip_info) == ESP_OK) {
+			esp_netif_set_dns_info(_gn_wifi_sta_netif, ESP_NETIF_DNS_MAIN,
+					&_gn_wifi_cache.dns);
+			_gn_wifi_static_ip = true;
+		} else {
+			esp_netif_dhcpc_start(_gn_wifi_sta_netif);
+		}
+
+	}
+
+	if (_gn_wifi_static_ip)
+		_gn_wifi_cache.ip_reuse_count++;
+#endif
+
+	ESP_LOGD(TAG, "connecting to cached access point on channel %d%s",
+			_gn_wifi_cache.channel,
+			_gn_wifi_static_ip ? " with cached address" : "");
+
+}
+
+/**
+ * @brief	discards the cache and restores scan and DHCP
+ */
+static void _gn_wifi_cache_discard(void) {
+
+	wifi_config_t wifi_config;
+
+	_gn_wifi_cache.valid = false;
+	_gn_wifi_fast_attempt = false;
+
+	if (esp_wifi_get_config(WIFI_IF_STA, &wifi_config) == ESP_OK) {
+		wifi_config.sta.bssid_set = false;
+		wifi_config.sta.channel = 0;
+		esp_wifi_set_config(WIFI_IF_STA, &wifi_config);
+	}
+
+	if (_gn_wifi_static_ip) {
+		esp_netif_dhcpc_start(_gn_wifi_sta_netif);
+		_gn_wifi_static_ip = false;
+	}
+
+}
+
+/**
+ * @brief	stores the access point and the address of the current connection
+ */
+static void _gn_wifi_cache_store(const esp_netif_ip_info_t *ip_info) {
+
+	wifi_ap_record_t ap_info;
+	if (esp_wifi_sta_get_ap_info(&ap_info) != ESP_OK)
+		return;
+
+	memcpy(_gn_wifi_cache.bssid, ap_info.bssid, 6);
+	_gn_wifi_cache.channel = ap_info.primary;
+
+	//a new lease
+	if (!_gn_wifi_static_ip) {
+		_gn_wifi_cache.ip_info = *ip_info;
+		esp_netif_get_dns_info(_gn_wifi_sta_netif, ESP_NETIF_DNS_MAIN,
+				&_gn_wifi_cache.dns);
+		_gn_wifi_cache.ip_reuse_count = 0;
+	}
+
+	_gn_wifi_cache.valid = true;
+
+}
+
+#endif /* CONFIG_GROWNODE_WIFI_FAST_RECONNECT */
+
+#endif /* CONFIG_GROWNODE_WIFI_ENABLED */
+
+/**
+ * @brief	gets the duration of the phases of the last WiFi connection
+ */
+void gn_wifi_get_timings(gn_wifi_timings_t *timings) {
+
+#ifdef CONFIG_GROWNODE_WIFI_ENABLED
+	*timings = _gn_wifi_timings;
+#else
+	memset(timings, 0, sizeof(gn_wifi_timings_t));
+#endif
+
+}
+
 int8_t gn_wifi_get_rssi() {
 	wifi_ap_record_t info;
 	if (!esp_wifi_sta_get_ap_info(&info)) {
@@ -145,12 +303,32 @@ void _gn_wifi_event_handler(void *arg, esp_event_base_t event_base,
 
 		ESP_LOGD(TAG, "WIFI_EVENT_STA_START");
 		esp_wifi_connect();
+	} else if (event_base == WIFI_EVENT
+			&& event_id == WIFI_EVENT_STA_CONNECTED) {
+
+		ESP_LOGD(TAG, "WIFI_EVENT_STA_CONNECTED");
+		_gn_wifi_associated_us = esp_timer_get_time();
+
 	} else if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP) {
 
 		ESP_LOGD(TAG, "IP_EVENT_STA_GOT_IP");
 		s_retry_num = 0;
 		ip_event_got_ip_t *event = (ip_event_got_ip_t*) event_data;
 
+		_gn_wifi_timings.associate_ms = (_gn_wifi_associated_us
+				- _gn_wifi_start_us) / 1000;
+		_gn_wifi_timings.ip_ms = (esp_timer_get_time() - _gn_wifi_associated_us)
+				/ 1000;
+#ifdef CONFIG_GROWNODE_WIFI_FAST_RECONNECT
+		_gn_wifi_timings.fast = _gn_wifi_fast_attempt;
+		_gn_wifi_fast_attempt = false;
+		_gn_wifi_cache_store(&event->ip_info);
+#endif
+		ESP_LOGI(TAG,
+				"wifi connected: scan and association %d ms, address %d ms%s",
+				_gn_wifi_timings.associate_ms, _gn_wifi_timings.ip_ms,
+				_gn_wifi_timings.fast ? " (cached access point)" : "");
+
 		char log[42];
 		uint8_t eth_mac[6];
 		char ssid_prefix[10];
@@ -194,6 +372,15 @@ void _gn_wifi_event_handler(void *arg, esp_event_base_t event_base,
 		//WIFI_REASON_ASSOC_LEAVE means that is a voluntary disconnect, do not retry to reconnect
 		if (disconnected->reason != WIFI_REASON_ASSOC_LEAVE) {
 
+#ifdef CONFIG_GROWNODE_WIFI_FAST_RECONNECT
+			if (_gn_wifi_fast_attempt) {
+				//does not count as a retry
+				ESP_LOGI(TAG,
+						"cached access point not available, falling back to scan");
+				_gn_wifi_cache_discard();
+				esp_wifi_connect();
+			} else
+#endif
 			if (_conf->config_init_params->wifi_retries_before_reset_provisioning
 					== -1) {
 				esp_wifi_connect();
@@ -229,6 +416,13 @@ gn_err_t _gn_wifi_init_sta(void) {
 
 	/* Start Wi-Fi in station mode */
 	ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_STA));
+
+#ifdef CONFIG_GROWNODE_WIFI_FAST_RECONNECT
+	_gn_wifi_cache_apply();
+#endif
+
+	_gn_wifi_start_us = esp_timer_get_time();
+	_gn_wifi_associated_us = _gn_wifi_start_us;
 	ESP_ERROR_CHECK(esp_wifi_start());
 
 	EventBits_t bits = xEventGroupWaitBits(_gn_event_group_wifi,
@@ -298,10 +492,11 @@ esp_err_t _gn_wifi_custom_prov_data_handler(uint32_t session_id,
 	return ESP_OK;
 }
 
-esp_err_t gn_wifi_init(gn_config_handle_intl_t conf) {
+esp_err_t gn_wifi_init(gn_config_handle_t config_handle) {
 
 #ifdef CONFIG_GROWNODE_WIFI_ENABLED
 
+	gn_config_handle_intl_t conf = (gn_config_handle_intl_t) config_handle;
 	_conf = conf;
 
 	esp_err_t ret = ESP_OK;
@@ -322,7 +517,7 @@ esp_err_t gn_wifi_init(gn_config_handle_intl_t conf) {
 			esp_event_handler_register(IP_EVENT, IP_EVENT_STA_GOT_IP, &_gn_wifi_event_handler, NULL),
 			fail, TAG, "");
 
-	esp_netif_create_default_wifi_sta();
+	_gn_wifi_sta_netif = esp_netif_create_default_wifi_sta();
 
 #ifdef CONFIG_GROWNODE_PROV_TRANSPORT_SOFTAP
 	esp_netif_create_default_wifi_ap();
@@ -490,6 +685,7 @@ static bool time_sync_init_done = false;
 
 void time_sync_notification_cb(struct timeval *tv) {
 	ESP_LOGD(TAG, "Notification of a time synchronization event");
+	gn_scheduler_time_changed();
 }
 
 esp_err_t gn_wifi_time_sync_init(gn_config_handle_t conf) {
@@ -536,6 +732,9 @@ esp_err_t gn_wifi_time_sync_init(gn_config_handle_t conf) {
 	strftime(strftime_buf, sizeof(strftime_buf), "%c", &timeinfo);
 	ESP_LOGD(TAG, "The current date/time is: %s", strftime_buf);
 
+	//calendar jobs follow the clock and the timezone
+	gn_scheduler_time_changed();
+
 	time_sync_init_done = true;
 	return ESP_OK;
 
@@ -559,13 +758,10 @@ void gn_ota_task(void *pvParameter) {
 
 	esp_wifi_set_ps(WIFI_PS_NONE);
 
-	esp_http_client_config_t config = { };
-	config.url = _conf->config_init_params->firmware_url;
-	//config.event_handler = _http_event_handler;
-	config.cert_pem = (char*) server_cert_pem_start;
-
-	esp_err_t ret = esp_https_ota(&config);
-	if (ret == ESP_OK) {
+	//plain images, compressed and delta containers, see gn_ota.h
+	gn_err_t ret = gn_ota_update(_conf->config_init_params->firmware_url,
+			(const char*) server_cert_pem_start);
+	if (ret == GN_RET_OK) {
 
 		gn_log(TAG, GN_LOG_INFO, "Firmware updated. Rebooting..");
 		//vTaskDelay(5000 / portTICK_PERIOD_MS);
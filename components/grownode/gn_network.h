@@ -19,6 +19,15 @@
 extern "C" {
 #endif
 
+/**
+ * @brief	duration of the phases of a WiFi connection
+ */
+typedef struct {
+	int32_t associate_ms; /*!< from station start to association, scan and authentication included */
+	int32_t ip_ms; /*!< from association to IP address, DHCP or cached address */
+	bool fast; /*!< true if the cached access point was used */
+} gn_wifi_timings_t;
+
 esp_err_t gn_wifi_init(gn_config_handle_t conf);
 void gn_ota_task(void *pvParameter);
 esp_err_t gn_wifi_time_sync_init(gn_config_handle_t conf);
@@ -29,6 +38,7 @@ gn_err_t gn_wifi_start(gn_config_handle_t conf);
 int8_t gn_wifi_get_rssi();
 void gn_wifi_get_mac(char *mac_string);
 void gn_wifi_get_ip(char *ip_string);
+void gn_wifi_get_timings(gn_wifi_timings_t *timings);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,1092 @@
+// Copyright 2021 Nicola Muratori (nicola.muratori@gmail.com)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_partition.h"
+#include "esp_ota_ops.h"
+#include "esp_http_client.h"
+#include "mbedtls/sha256.h"
+
+#include "grownode.h"
+#include "gn_mem.h"
+
+#include "gn_ota.h"
+
+#define TAG "gn_ota"
+
+#define GN_OTA_LZ_STAGE_SIZE 64
+#define GN_OTA_HTTP_TIMEOUT_MS 10000
+
+struct gn_ota_patcher {
+	gn_ota_patcher_config_t config;
+	gn_ota_patcher_info_t info;
+	bool failed;
+
+	uint8_t header[GN_OTA_HEADER_SIZE];
+	size_t header_len;
+	uint8_t target_sha256[GN_OTA_SHA256_SIZE];
+
+	//compressed block being decoded
+	bool in_block;
+	bool block_stored;
+	uint8_t block_header[4];
+	size_t block_header_len;
+	size_t block_plain; /*!< plain bytes still to produce */
+	size_t block_packed; /*!< packed bytes still to consume */
+	uint8_t lz_flags;
+	uint8_t lz_bits; /*!< flags still to use */
+	bool lz_has_match0;
+	uint8_t lz_match0;
+	uint8_t *window;
+	size_t window_pos; /*!< plain bytes produced in the block */
+	uint8_t stage[GN_OTA_LZ_STAGE_SIZE];
+	size_t stage_len;
+
+	//delta operation being parsed
+	uint8_t op;
+	uint8_t op_args[8];
+	size_t op_args_len;
+	uint32_t op_left;
+
+	uint8_t *out;
+	size_t out_len;
+	mbedtls_sha256_context sha;
+
+	gn_ota_checkpoint_t mark; /*!< last state a checkpoint can restart from */
+};
+
+static uint32_t _gn_ota_u32(const uint8_t *b) {
+	return (uint32_t) b[0] | ((uint32_t) b[1] << 8) | ((uint32_t) b[2] << 16)
+			| ((uint32_t) b[3] << 24);
+}
+
+/**
+ * @brief	remembers the current state as resumable, pending bytes of the current feed excluded
+ */
+static void _gn_ota_mark(gn_ota_patcher_handle_t p, size_t pending) {
+
+	gn_ota_checkpoint_t *m = &p->mark;
+	m->consumed = p->info.consumed - pending;
+	m->written = p->info.written;
+	m->type = p->info.type;
+	m->op = p->op;
+	m->op_args_len = p->op_args_len;
+	m->op_left = p->op_left;
+	memcpy(m->op_args, p->op_args, sizeof(m->op_args));
+	memcpy(m->header, p->header, sizeof(m->header));
+
+}
+
+static gn_err_t _gn_ota_fail(gn_ota_patcher_handle_t p, const char *reason) {
+	if (!p->failed)
+		ESP_LOGE(TAG, "%s at byte %u", reason, (unsigned) p->info.consumed);
+	p->failed = true;
+	return GN_RET_ERR_INVALID_ARG;
+}
+
+static gn_err_t _gn_ota_flush(gn_ota_patcher_handle_t p) {
+
+	if (p->out_len == 0)
+		return GN_RET_OK;
+
+	gn_err_t ret = p->config.write(p->config.arg, p->out, p->out_len);
+	p->out_len = 0;
+	if (ret != GN_RET_OK) {
+		ESP_LOGE(TAG, "write failed at %u", (unsigned) p->info.written);
+		p->failed = true;
+	}
+	return ret;
+
+}
+
+static gn_err_t _gn_ota_reserve(gn_ota_patcher_handle_t p, size_t len) {
+	if (p->info.target_size && p->info.written + len > p->info.target_size)
+		return _gn_ota_fail(p, "image larger than declared");
+	return GN_RET_OK;
+}
+
+/**
+ * @brief	appends bytes to the resulting image
+ */
+static gn_err_t _gn_ota_emit(gn_ota_patcher_handle_t p, const uint8_t *data,
+		size_t len) {
+
+	if (_gn_ota_reserve(p, len) != GN_RET_OK)
+		return GN_RET_ERR_INVALID_ARG;
+
+	mbedtls_sha256_update_ret(&p->sha, data, len);
+	p->info.written += len;
+
+	while (len > 0) {
+		size_t n = GN_OTA_WRITE_SIZE - p->out_len;
+		if (n > len)
+			n = len;
+		memcpy(p->out + p->out_len, data, n);
+		p->out_len += n;
+		data += n;
+		len -= n;
+		if (p->out_len == GN_OTA_WRITE_SIZE && _gn_ota_flush(p) != GN_RET_OK)
+			return GN_RET_ERR;
+	}
+
+	return GN_RET_OK;
+
+}
+
+/**
+ * @brief	appends bytes of the source image, read straight into the output buffer
+ */
+static gn_err_t _gn_ota_copy(gn_ota_patcher_handle_t p, uint32_t offset,
+		uint32_t len) {
+
+	if ((uint64_t) offset + len > p->config.source_size)
+		return _gn_ota_fail(p, "copy out of the source image");
+	if (_gn_ota_reserve(p, len) != GN_RET_OK)
+		return GN_RET_ERR_INVALID_ARG;
+
+	while (len > 0) {
+		size_t n = GN_OTA_WRITE_SIZE - p->out_len;
+		if (n > len)
+			n = len;
+		if (p->config.read_source(p->config.arg, offset, p->out + p->out_len,
+				n) != GN_RET_OK) {
+			ESP_LOGE(TAG, "source read failed at %u", (unsigned) offset);
+			p->failed = true;
+			return GN_RET_ERR;
+		}
+		mbedtls_sha256_update_ret(&p->sha, p->out + p->out_len, n);
+		p->out_len += n;
+		p->info.written += n;
+		offset += n;
+		len -= n;
+		if (p->out_len == GN_OTA_WRITE_SIZE && _gn_ota_flush(p) != GN_RET_OK)
+			return GN_RET_ERR;
+	}
+
+	return GN_RET_OK;
+
+}
+
+/**
+ * @brief	consumes the uncompressed payload: the image or the delta operations
+ */
+static gn_err_t _gn_ota_plain(gn_ota_patcher_handle_t p, const uint8_t *data,
+		size_t len) {
+
+	if (p->info.type != GN_OTA_IMAGE_DELTA)
+		return _gn_ota_emit(p, data, len);
+
+	while (len > 0 && !p->failed) {
+
+		if (p->op == 0) {
+			p->op = *data++;
+			len--;
+			p->op_args_len = 0;
+			if (p->op != GN_OTA_OP_COPY && p->op != GN_OTA_OP_INSERT)
+				return _gn_ota_fail(p, "unknown delta operation");
+			continue;
+		}
+
+		size_t args = p->op == GN_OTA_OP_COPY ? 8 : 4;
+		if (p->op_args_len < args) {
+			size_t n = args - p->op_args_len;
+			if (n > len)
+				n = len;
+			memcpy(p->op_args + p->op_args_len, data, n);
+			p->op_args_len += n;
+			data += n;
+			len -= n;
+			if (p->op_args_len < args)
+				break;
+			if (p->op == GN_OTA_OP_COPY) {
+				p->op = 0;
+				if (_gn_ota_copy(p, _gn_ota_u32(p->op_args),
+						_gn_ota_u32(p->op_args + 4)) != GN_RET_OK)
+					return GN_RET_ERR;
+			} else {
+				p->op_left = _gn_ota_u32(p->op_args);
+				if (p->op_left == 0)
+					p->op = 0;
+			}
+			continue;
+		}
+
+		//insert
+		size_t n = p->op_left < len ? p->op_left : len;
+		if (_gn_ota_emit(p, data, n) != GN_RET_OK)
+			return GN_RET_ERR;
+		data += n;
+		len -= n;
+		p->op_left -= n;
+		if (p->op_left == 0)
+			p->op = 0;
+
+	}
+
+	return p->failed ? GN_RET_ERR : GN_RET_OK;
+
+}
+
+static gn_err_t _gn_ota_lz_put(gn_ota_patcher_handle_t p, uint8_t c) {
+
+	if (p->block_plain == 0)
+		return _gn_ota_fail(p, "block larger than declared");
+
+	p->window[p->window_pos++ % GN_OTA_LZ_WINDOW_SIZE] = c;
+	p->block_plain--;
+	p->stage[p->stage_len++] = c;
+	if (p->stage_len == GN_OTA_LZ_STAGE_SIZE) {
+		p->stage_len = 0;
+		return _gn_ota_plain(p, p->stage, GN_OTA_LZ_STAGE_SIZE);
+	}
+	return GN_RET_OK;
+
+}
+
+static gn_err_t _gn_ota_lz_flush(gn_ota_patcher_handle_t p) {
+	size_t n = p->stage_len;
+	p->stage_len = 0;
+	return n ? _gn_ota_plain(p, p->stage, n) : GN_RET_OK;
+}
+
+/**
+ * @brief	decodes one packed byte of a block
+ */
+static gn_err_t _gn_ota_lz_decode(gn_ota_patcher_handle_t p, uint8_t b) {
+
+	if (p->lz_bits == 0) {
+		p->lz_flags = b;
+		p->lz_bits = 8;
+		return GN_RET_OK;
+	}
+
+	if (p->lz_flags & 1) {
+		p->lz_flags >>= 1;
+		p->lz_bits--;
+		return _gn_ota_lz_put(p, b);
+	}
+
+	if (!p->lz_has_match0) {
+		p->lz_match0 = b;
+		p->lz_has_match0 = true;
+		return GN_RET_OK;
+	}
+
+	size_t offset = (p->lz_match0 | ((size_t) (b >> 4) << 8)) + 1;
+	size_t length = (b & 0x0F) + GN_OTA_LZ_MIN_MATCH;
+	p->lz_has_match0 = false;
+	p->lz_flags >>= 1;
+	p->lz_bits--;
+
+	if (offset > p->window_pos)
+		return _gn_ota_fail(p, "match before the block start");
+
+	for (size_t i = 0; i < length; i++) {
+		uint8_t c = p->window[(p->window_pos - offset) % GN_OTA_LZ_WINDOW_SIZE];
+		if (_gn_ota_lz_put(p, c) != GN_RET_OK)
+			return GN_RET_ERR;
+	}
+
+	return GN_RET_OK;
+
+}
+
+/**
+ * @brief	consumes the compressed payload, block by block
+ */
+static gn_err_t _gn_ota_blocks(gn_ota_patcher_handle_t p, const uint8_t *data,
+		size_t len) {
+
+	while (len > 0 && !p->failed) {
+
+		if (!p->in_block) {
+			size_t n = sizeof(p->block_header) - p->block_header_len;
+			if (n > len)
+				n = len;
+			memcpy(p->block_header + p->block_header_len, data, n);
+			p->block_header_len += n;
+			data += n;
+			len -= n;
+			if (p->block_header_len < sizeof(p->block_header))
+				break;
+
+			p->block_header_len = 0;
+			p->block_plain = p->block_header[0] | (p->block_header[1] << 8);
+			p->block_packed = p->block_header[2] | (p->block_header[3] << 8);
+			if (p->block_plain == 0 || p->block_plain > GN_OTA_BLOCK_SIZE)
+				return _gn_ota_fail(p, "invalid block");
+			p->block_stored = p->block_packed == 0;
+			if (p->block_stored)
+				p->block_packed = p->block_plain;
+			p->lz_bits = 0;
+			p->lz_has_match0 = false;
+			p->window_pos = 0;
+			p->in_block = true;
+			continue;
+		}
+
+		if (p->block_stored) {
+			size_t n = p->block_packed < len ? p->block_packed : len;
+			if (_gn_ota_plain(p, data, n) != GN_RET_OK)
+				return GN_RET_ERR;
+			data += n;
+			len -= n;
+			p->block_packed -= n;
+			p->block_plain -= n;
+		} else {
+			while (len > 0 && p->block_packed > 0) {
+				p->block_packed--;
+				len--;
+				if (_gn_ota_lz_decode(p, *data++) != GN_RET_OK)
+					return GN_RET_ERR;
+			}
+			if (_gn_ota_lz_flush(p) != GN_RET_OK)
+				return GN_RET_ERR;
+		}
+
+		if (p->block_packed == 0) {
+			if (p->block_plain != 0)
+				return _gn_ota_fail(p, "block shorter than declared");
+			p->in_block = false;
+			_gn_ota_mark(p, len);
+		}
+
+	}
+
+	return p->failed ? GN_RET_ERR : GN_RET_OK;
+
+}
+
+static gn_err_t _gn_ota_payload(gn_ota_patcher_handle_t p,
+		const uint8_t *data, size_t len) {
+	if (p->info.compression == GN_OTA_COMPRESSION_LZSS)
+		return _gn_ota_blocks(p, data, len);
+	return _gn_ota_plain(p, data, len);
+}
+
+static gn_err_t _gn_ota_parse_header(gn_ota_patcher_handle_t p) {
+
+	const uint8_t *h = p->header;
+
+	if (h[4] != GN_OTA_VERSION)
+		return _gn_ota_fail(p, "unsupported container version");
+	if (h[5] != GN_OTA_IMAGE_FULL && h[5] != GN_OTA_IMAGE_DELTA)
+		return _gn_ota_fail(p, "unknown image type");
+	if (h[6] != GN_OTA_COMPRESSION_NONE && h[6] != GN_OTA_COMPRESSION_LZSS)
+		return _gn_ota_fail(p, "unknown compression");
+
+	p->info.type = (gn_ota_image_type_t) h[5];
+	p->info.compression = (gn_ota_compression_t) h[6];
+	p->info.target_size = _gn_ota_u32(h + 8);
+	memcpy(p->target_sha256, h + 12, GN_OTA_SHA256_SIZE);
+
+	if (p->info.target_size == 0)
+		return _gn_ota_fail(p, "empty image");
+
+	//a delta is only applied to the image it was built from
+	if (p->info.type == GN_OTA_IMAGE_DELTA
+			&& (!p->config.read_source
+					|| memcmp(h + 12 + GN_OTA_SHA256_SIZE,
+							p->config.source_sha256, GN_OTA_SHA256_SIZE)
+							!= 0))
+		return _gn_ota_fail(p, "delta built for another firmware");
+
+	p->info.header_done = true;
+	ESP_LOGI(TAG, "%s%s image of %u bytes",
+			p->info.type == GN_OTA_IMAGE_DELTA ? "delta" : "full",
+			p->info.compression == GN_OTA_COMPRESSION_LZSS ? " compressed" : "",
+			(unsigned) p->info.target_size);
+
+	return GN_RET_OK;
+
+}
+
+/**
+ * @brief	creates a patcher, rebuilding an image from what is fed
+ *
+ * @return	NULL if the config is not valid or there is no memory
+ */
+gn_ota_patcher_handle_t gn_ota_patcher_create(
+		const gn_ota_patcher_config_t *config) {
+
+	if (!config || !config->write)
+		return NULL;
+
+	gn_ota_patcher_handle_t p = gn_mem_calloc(GN_MEM_TAG_CORE, 1,
+			sizeof(struct gn_ota_patcher));
+	if (!p)
+		return NULL;
+
+	p->window = gn_mem_malloc(GN_MEM_TAG_CORE, GN_OTA_LZ_WINDOW_SIZE);
+	p->out = gn_mem_malloc(GN_MEM_TAG_CORE, GN_OTA_WRITE_SIZE);
+	if (!p->window || !p->out) {
+		gn_mem_free(p->window);
+		gn_mem_free(p->out);
+		gn_mem_free(p);
+		return NULL;
+	}
+
+	p->config = *config;
+	p->info.type = GN_OTA_IMAGE_PLAIN;
+	mbedtls_sha256_init(&p->sha);
+	mbedtls_sha256_starts_ret(&p->sha, 0);
+
+	return p;
+
+}
+
+/**
+ * @brief	feeds the next downloaded bytes
+ *
+ * @return	GN_RET_ERR_INVALID_ARG if the stream is not valid or not applicable to the running image
+ * @return	GN_RET_ERR if writing or reading the source failed
+ */
+gn_err_t gn_ota_patcher_feed(gn_ota_patcher_handle_t p, const uint8_t *data,
+		size_t len) {
+
+	if (!p || (!data && len))
+		return GN_RET_ERR_INVALID_ARG;
+	if (p->failed)
+		return GN_RET_ERR;
+
+	p->info.consumed += len;
+
+	if (!p->info.header_done) {
+
+		size_t n = GN_OTA_HEADER_SIZE - p->header_len;
+		if (n > len)
+			n = len;
+		memcpy(p->header + p->header_len, data, n);
+		p->header_len += n;
+		data += n;
+		len -= n;
+
+		size_t magic = strlen(GN_OTA_MAGIC);
+		if (p->header_len >= magic
+				&& memcmp(p->header, GN_OTA_MAGIC, magic) != 0) {
+			//not a container, the bytes are the image
+			p->info.header_done = true;
+			if (_gn_ota_emit(p, p->header, p->header_len) != GN_RET_OK)
+				return GN_RET_ERR;
+		} else if (p->header_len < GN_OTA_HEADER_SIZE
+				|| _gn_ota_parse_header(p) != GN_RET_OK) {
+			return p->failed ? GN_RET_ERR_INVALID_ARG : GN_RET_OK;
+		}
+		_gn_ota_mark(p, len);
+
+	}
+
+	return len ? _gn_ota_payload(p, data, len) : GN_RET_OK;
+
+}
+
+/**
+ * @brief	writes the last bytes and verifies the resulting image
+ *
+ * @return	GN_RET_ERR_INVALID_ARG if the image is incomplete or does not match its SHA-256
+ */
+gn_err_t gn_ota_patcher_finish(gn_ota_patcher_handle_t p) {
+
+	if (!p)
+		return GN_RET_ERR_INVALID_ARG;
+	if (p->failed)
+		return GN_RET_ERR;
+
+	if (!p->info.header_done) {
+		if (p->header_len == 0)
+			return _gn_ota_fail(p, "empty image");
+		//shorter than the magic
+		p->info.header_done = true;
+		if (_gn_ota_emit(p, p->header, p->header_len) != GN_RET_OK)
+			return GN_RET_ERR;
+	}
+
+	if (_gn_ota_flush(p) != GN_RET_OK)
+		return GN_RET_ERR;
+
+	if (p->info.type == GN_OTA_IMAGE_PLAIN)
+		return GN_RET_OK;
+
+	if (p->in_block || p->op != 0 || p->info.written != p->info.target_size)
+		return _gn_ota_fail(p, "image truncated");
+
+	uint8_t sha[GN_OTA_SHA256_SIZE];
+	mbedtls_sha256_finish_ret(&p->sha, sha);
+	if (memcmp(sha, p->target_sha256, GN_OTA_SHA256_SIZE) != 0)
+		return _gn_ota_fail(p, "image SHA-256 mismatch");
+
+	return GN_RET_OK;
+
+}
+
+gn_err_t gn_ota_patcher_get_info(gn_ota_patcher_handle_t p,
+		gn_ota_patcher_info_t *info) {
+
+	if (!p || !info)
+		return GN_RET_ERR_INVALID_ARG;
+	*info = p->info;
+	info->resumable = p->mark.consumed;
+	//uncompressed payloads can restart from any byte
+	if (p->info.header_done && p->info.compression == GN_OTA_COMPRESSION_NONE)
+		info->resumable = p->info.consumed;
+	return GN_RET_OK;
+
+}
+
+/**
+ * @brief	writes the buffered bytes and returns the last state the patcher can be resumed from
+ *
+ * @return	GN_RET_ERR if the image type is not known yet, the patcher failed or the write failed
+ */
+gn_err_t gn_ota_patcher_checkpoint(gn_ota_patcher_handle_t p,
+		gn_ota_checkpoint_t *checkpoint) {
+
+	if (!p || !checkpoint)
+		return GN_RET_ERR_INVALID_ARG;
+	if (p->failed || !p->info.header_done)
+		return GN_RET_ERR;
+
+	if (p->info.compression == GN_OTA_COMPRESSION_NONE
+			|| (!p->in_block && p->block_header_len == 0))
+		_gn_ota_mark(p, 0);
+
+	if (_gn_ota_flush(p) != GN_RET_OK)
+		return GN_RET_ERR;
+
+	*checkpoint = p->mark;
+	return GN_RET_OK;
+
+}
+
+/**
+ * @brief	restores a checkpoint on a new patcher. the SHA-256 of the bytes already written is
+ * computed reading them back
+ *
+ * @return	GN_RET_ERR_INVALID_ARG if the checkpoint is not valid for this patcher
+ * @return	GN_RET_ERR if the image cannot be read back
+ */
+gn_err_t gn_ota_patcher_resume(gn_ota_patcher_handle_t p,
+		const gn_ota_checkpoint_t *checkpoint) {
+
+	if (!p || !checkpoint || !p->config.read_target || p->info.consumed
+			|| checkpoint->op_args_len > sizeof(p->op_args))
+		return GN_RET_ERR_INVALID_ARG;
+
+	if (checkpoint->type == GN_OTA_IMAGE_PLAIN) {
+		if (checkpoint->op || checkpoint->written != checkpoint->consumed)
+			return _gn_ota_fail(p, "invalid checkpoint");
+		p->info.header_done = true;
+	} else {
+		memcpy(p->header, checkpoint->header, GN_OTA_HEADER_SIZE);
+		p->header_len = GN_OTA_HEADER_SIZE;
+		if (memcmp(p->header, GN_OTA_MAGIC, strlen(GN_OTA_MAGIC)) != 0
+				|| _gn_ota_parse_header(p) != GN_RET_OK
+				|| p->info.type != checkpoint->type
+				|| checkpoint->written > p->info.target_size
+				|| (checkpoint->op != 0 && checkpoint->op != GN_OTA_OP_COPY
+						&& checkpoint->op != GN_OTA_OP_INSERT))
+			return _gn_ota_fail(p, "invalid checkpoint");
+	}
+
+	for (size_t offset = 0; offset < checkpoint->written;
+			offset += GN_OTA_WRITE_SIZE) {
+		size_t n = checkpoint->written - offset;
+		if (n > GN_OTA_WRITE_SIZE)
+			n = GN_OTA_WRITE_SIZE;
+		if (p->config.read_target(p->config.arg, offset, p->out, n)
+				!= GN_RET_OK) {
+			ESP_LOGE(TAG, "cannot read back the image at %u", (unsigned) offset);
+			p->failed = true;
+			return GN_RET_ERR;
+		}
+		mbedtls_sha256_update_ret(&p->sha, p->out, n);
+	}
+
+	p->info.consumed = checkpoint->consumed;
+	p->info.written = checkpoint->written;
+	p->op = checkpoint->op;
+	p->op_args_len = checkpoint->op_args_len;
+	p->op_left = checkpoint->op_left;
+	memcpy(p->op_args, checkpoint->op_args, sizeof(p->op_args));
+	p->mark = *checkpoint;
+
+	return GN_RET_OK;
+
+}
+
+void gn_ota_patcher_delete(gn_ota_patcher_handle_t p) {
+
+	if (!p)
+		return;
+	mbedtls_sha256_free(&p->sha);
+	gn_mem_free(p->window);
+	gn_mem_free(p->out);
+	gn_mem_free(p);
+
+}
+
+#define GN_OTA_CHECKPOINT_KEY "gn_ota_checkpoint"
+//changed with the layout, checkpoints of older firmwares are ignored
+#define GN_OTA_CHECKPOINT_MAGIC 0x434F4E48
+#define GN_OTA_SECTOR_SIZE 4096
+#define GN_OTA_VALIDATOR_SIZE 64
+
+typedef struct {
+	uint32_t magic; /*!< 0 once the update is over */
+	uint64_t url_hash;
+	gn_ota_checkpoint_t checkpoint;
+	char validator[GN_OTA_VALIDATOR_SIZE]; /*!< of the download, see gn_ota_update_t */
+} gn_ota_saved_checkpoint_t;
+
+typedef struct {
+	const esp_partition_t *running;
+	const esp_partition_t *update;
+	esp_ota_handle_t ota;
+	const char *url;
+	const char *cert_pem;
+	size_t offset; /*!< next byte to write */
+	size_t erased; /*!< end of the erased sectors */
+	size_t saved; /*!< download offset of the checkpoint in NVS */
+	size_t total; /*!< download size, 0 if unknown */
+	size_t session_start; /*!< bytes fed before this call */
+	int64_t start;
+	int logged;
+	char validator[GN_OTA_VALIDATOR_SIZE]; /*!< ETag or Last-Modified of the first byte, sent as If-Range. empty if the server sends none */
+	char etag[GN_OTA_VALIDATOR_SIZE]; /*!< of the last response */
+	char modified[GN_OTA_VALIDATOR_SIZE]; /*!< of the last response */
+	bool changed; /*!< the url serves another file than the bytes already written */
+} gn_ota_update_t;
+
+static gn_err_t _gn_ota_partition_write(void *arg, const uint8_t *data,
+		size_t len) {
+
+	gn_ota_update_t *u = (gn_ota_update_t*) arg;
+
+	//sectors are erased once, a resumed update rewrites the same bytes in the last one
+	size_t end = u->offset + len;
+	if (end > u->erased) {
+		size_t to = (end + GN_OTA_SECTOR_SIZE - 1) & ~(GN_OTA_SECTOR_SIZE - 1);
+		if (esp_partition_erase_range(u->update, u->erased, to - u->erased)
+				!= ESP_OK)
+			return GN_RET_ERR;
+		u->erased = to;
+	}
+
+	if (esp_ota_write_with_offset(u->ota, data, len, u->offset) != ESP_OK)
+		return GN_RET_ERR;
+	u->offset = end;
+	return GN_RET_OK;
+
+}
+
+static gn_err_t _gn_ota_partition_read(void *arg, size_t offset,
+		uint8_t *data, size_t len) {
+	gn_ota_update_t *u = (gn_ota_update_t*) arg;
+	return esp_partition_read(u->running, offset, data, len) == ESP_OK ?
+			GN_RET_OK : GN_RET_ERR;
+}
+
+static gn_err_t _gn_ota_partition_read_back(void *arg, size_t offset,
+		uint8_t *data, size_t len) {
+	gn_ota_update_t *u = (gn_ota_update_t*) arg;
+	return esp_partition_read(u->update, offset, data, len) == ESP_OK ?
+			GN_RET_OK : GN_RET_ERR;
+}
+
+static void _gn_ota_checkpoint_save(gn_ota_update_t *u,
+		gn_ota_patcher_handle_t p) {
+
+	//without a validator the next call could not tell if the file changed
+	if (!u->validator[0])
+		return;
+
+	gn_ota_saved_checkpoint_t saved = { .magic = GN_OTA_CHECKPOINT_MAGIC,
+			.url_hash = gn_hash(u->url) };
+	strcpy(saved.validator, u->validator);
+	if (gn_ota_patcher_checkpoint(p, &saved.checkpoint) != GN_RET_OK
+			|| saved.checkpoint.consumed <= u->saved)
+		return;
+
+	if (gn_storage_set(GN_OTA_CHECKPOINT_KEY, &saved, sizeof(saved))
+			== GN_RET_OK) {
+		u->saved = saved.checkpoint.consumed;
+		ESP_LOGD(TAG, "checkpoint at %u bytes", (unsigned) u->saved);
+	}
+
+}
+
+static void _gn_ota_checkpoint_clear() {
+	gn_ota_saved_checkpoint_t saved = { 0 };
+	gn_storage_set(GN_OTA_CHECKPOINT_KEY, &saved, sizeof(saved));
+}
+
+/**
+ * @brief	restarts the patcher from the checkpoint of a previous download of the same url.
+ * 			the server is asked the rest of the same file with If-Range, see _gn_ota_download
+ */
+static void _gn_ota_checkpoint_resume(gn_ota_update_t *u,
+		gn_ota_patcher_handle_t *p, const gn_ota_patcher_config_t *config) {
+
+	gn_ota_saved_checkpoint_t *saved = NULL;
+	size_t size = 0;
+	if (gn_storage_get_blob(GN_OTA_CHECKPOINT_KEY, (void**) &saved, &size)
+			!= GN_RET_NVS_PARAMETER_FOUND)
+		return;
+
+	//a checkpoint of another layout is not even read
+	if (size == sizeof(gn_ota_saved_checkpoint_t)
+			&& saved->magic == GN_OTA_CHECKPOINT_MAGIC
+			&& saved->url_hash == gn_hash(u->url)
+			&& memchr(saved->validator, '\0', GN_OTA_VALIDATOR_SIZE)
+			&& saved->validator[0]) {
+
+		gn_err_t ret = gn_ota_patcher_resume(*p, &saved->checkpoint);
+		if (ret == GN_RET_OK) {
+			u->offset = saved->checkpoint.written;
+			u->erased = (u->offset + GN_OTA_SECTOR_SIZE - 1)
+					& ~(GN_OTA_SECTOR_SIZE - 1);
+			u->saved = saved->checkpoint.consumed;
+			strcpy(u->validator, saved->validator);
+			gn_log(TAG, GN_LOG_INFO, "firmware update - resuming at %u bytes",
+					(unsigned) u->saved);
+		} else {
+			//start over with a clean patcher
+			gn_ota_patcher_delete(*p);
+			*p = gn_ota_patcher_create(config);
+		}
+
+	}
+
+	free(saved);
+
+}
+
+/**
+ * @brief	drops the bytes written and the checkpoint, to download the url from the start
+ *
+ * @return	the new patcher, NULL if it cannot be created
+ */
+static gn_ota_patcher_handle_t _gn_ota_restart(gn_ota_update_t *u,
+		gn_ota_patcher_handle_t p, const gn_ota_patcher_config_t *config) {
+
+	gn_ota_patcher_delete(p);
+	_gn_ota_checkpoint_clear();
+	u->offset = 0;
+	u->erased = 0;
+	u->saved = 0;
+	u->total = 0;
+	u->session_start = 0;
+	u->logged = 0;
+	u->validator[0] = '\0';
+	u->changed = false;
+	return gn_ota_patcher_create(config);
+
+}
+
+//keeps the validators of the response, weak ETags cannot be used in If-Range
+static esp_err_t _gn_ota_http_event(esp_http_client_event_t *evt) {
+
+	gn_ota_update_t *u = (gn_ota_update_t*) evt->user_data;
+	if (evt->event_id != HTTP_EVENT_ON_HEADER || !evt->header_key
+			|| !evt->header_value
+			|| strlen(evt->header_value) >= GN_OTA_VALIDATOR_SIZE)
+		return ESP_OK;
+
+	if (strcasecmp(evt->header_key, "ETag") == 0
+			&& strncmp(evt->header_value, "W/", 2) != 0)
+		strcpy(u->etag, evt->header_value);
+	else if (strcasecmp(evt->header_key, "Last-Modified") == 0)
+		strcpy(u->modified, evt->header_value);
+	return ESP_OK;
+
+}
+
+static void _gn_ota_progress(gn_ota_update_t *u, gn_ota_patcher_handle_t p) {
+
+	gn_ota_patcher_info_t info;
+	gn_ota_patcher_get_info(p, &info);
+
+	int percent = -1;
+	if (u->total)
+		percent = (int) ((uint64_t) info.consumed * 100 / u->total);
+	else if (info.target_size)
+		percent = (int) ((uint64_t) info.written * 100 / info.target_size);
+
+	if (percent < 0 || percent < u->logged + GN_OTA_PROGRESS_STEP)
+		return;
+	u->logged = percent - percent % GN_OTA_PROGRESS_STEP;
+
+	//throughput of this call, resumed bytes excluded
+	int64_t elapsed_ms = (esp_timer_get_time() - u->start) / 1000;
+	size_t downloaded = info.consumed - u->session_start;
+	unsigned bps = elapsed_ms > 0 ? downloaded * 1000 / elapsed_ms : 0;
+	unsigned eta = bps && u->total > info.consumed ?
+			(u->total - info.consumed) / bps : 0;
+
+	gn_log(TAG, GN_LOG_INFO,
+			"firmware update %d%% - %u bytes downloaded, %u B/s, %u s left",
+			u->logged, (unsigned) info.consumed, bps, eta);
+
+}
+
+/**
+ * @brief	downloads from the byte reached by the patcher to the end
+ *
+ * @param	retry	set to false if retrying cannot help
+ */
+static gn_err_t _gn_ota_download(gn_ota_update_t *u,
+		gn_ota_patcher_handle_t p, uint8_t *buf, bool *retry) {
+
+	gn_ota_patcher_info_t info;
+	gn_ota_patcher_get_info(p, &info);
+	size_t offset = info.consumed;
+	size_t skip = 0;
+	gn_err_t ret = GN_RET_ERR;
+	*retry = true;
+
+	esp_http_client_config_t http = { .url = u->url, .cert_pem = u->cert_pem,
+			.timeout_ms = GN_OTA_HTTP_TIMEOUT_MS, .keep_alive_enable = true,
+			.event_handler = _gn_ota_http_event, .user_data = u };
+	esp_http_client_handle_t client = esp_http_client_init(&http);
+	if (!client) {
+		*retry = false;
+		return GN_RET_ERR;
+	}
+
+	u->etag[0] = '\0';
+	u->modified[0] = '\0';
+	if (offset > 0) {
+		char range[32];
+		snprintf(range, sizeof(range), "bytes=%u-", (unsigned) offset);
+		esp_http_client_set_header(client, "Range", range);
+		//a server with another file answers the whole of it
+		if (u->validator[0])
+			esp_http_client_set_header(client, "If-Range", u->validator);
+	}
+
+	if (esp_http_client_open(client, 0) != ESP_OK) {
+		gn_log(TAG, GN_LOG_ERROR, "firmware update - cannot connect to %s",
+				u->url);
+		goto end;
+	}
+
+	int content_length = esp_http_client_fetch_headers(client);
+	int status = esp_http_client_get_status_code(client);
+	const char *validator = u->etag[0] ? u->etag : u->modified;
+	if (offset == 0) {
+		strcpy(u->validator, validator);
+	} else if (u->validator[0] && (status == 200 || status == 206)
+			&& strcmp(u->validator, validator) != 0) {
+		gn_log(TAG, GN_LOG_WARNING,
+				"firmware update - %s changed, starting over", u->url);
+		u->changed = true;
+		goto end;
+	}
+
+	if (status == 206 && offset > 0) {
+		u->total = content_length > 0 ? offset + content_length : 0;
+	} else if (status == 200) {
+		if (offset > 0)
+			ESP_LOGW(TAG, "no range support, skipping %u bytes",
+					(unsigned) offset);
+		skip = offset;
+		u->total = content_length > 0 ? content_length : 0;
+	} else {
+		gn_log(TAG, GN_LOG_ERROR, "firmware update - HTTP status %d", status);
+		*retry = status >= 500;
+		goto end;
+	}
+
+	while (true) {
+
+		int n = esp_http_client_read(client, (char*) buf, GN_OTA_READ_SIZE);
+		if (n < 0)
+			goto end;
+		if (n == 0) {
+			if (esp_http_client_is_complete_data_received(client) && !skip)
+				ret = GN_RET_OK;
+			goto end;
+		}
+
+		const uint8_t *data = buf;
+		if (skip) {
+			size_t s = skip < (size_t) n ? skip : (size_t) n;
+			skip -= s;
+			data += s;
+			n -= s;
+		}
+
+		ret = gn_ota_patcher_feed(p, data, n);
+		if (ret != GN_RET_OK) {
+			*retry = false;
+			goto end;
+		}
+		ret = GN_RET_ERR;
+
+		_gn_ota_progress(u, p);
+		gn_ota_patcher_get_info(p, &info);
+		if (info.resumable >= u->saved
+				+ CONFIG_GROWNODE_OTA_CHECKPOINT_KB * 1024)
+			_gn_ota_checkpoint_save(u, p);
+
+	}
+
+	end: esp_http_client_close(client);
+	esp_http_client_cleanup(client);
+	return ret;
+
+}
+
+/**
+ * @brief	downloads the firmware into the next OTA partition and makes it the boot one
+ *
+ * the url serves a plain image or a GrowNode OTA container, see gn_ota.h. interrupted downloads
+ * are resumed with range requests up to CONFIG_GROWNODE_OTA_RETRIES times. if they still fail, the
+ * next call for the same url resumes from the last checkpoint, also after a reboot, as long as the
+ * server still serves the same file: its ETag or Last-Modified is sent as If-Range, a server without
+ * them is downloaded again from the start.
+ * the progress, throughput and time left are logged through gn_log, and so published over MQTT.
+ * the node is not restarted.
+ *
+ * @return	GN_RET_ERR_INVALID_ARG if the image is not valid or not applicable to the running image
+ * @return	GN_RET_ERR in case of network or flash errors
+ */
+gn_err_t gn_ota_update(const char *url, const char *cert_pem) {
+
+	if (!url)
+		return GN_RET_ERR_INVALID_ARG;
+
+	gn_ota_update_t u = { .running = esp_ota_get_running_partition(),
+			.update = esp_ota_get_next_update_partition(NULL), .url = url,
+			.cert_pem = cert_pem };
+	if (!u.running || !u.update) {
+		gn_log(TAG, GN_LOG_ERROR, "no OTA partition to update");
+		return GN_RET_ERR;
+	}
+
+	gn_ota_patcher_config_t config = { .write = _gn_ota_partition_write,
+			.read_source = _gn_ota_partition_read, .read_target =
+					_gn_ota_partition_read_back, .arg = &u, .source_size =
+					u.running->size };
+	//without the app hash deltas cannot be checked, only full images are accepted
+	if (esp_partition_get_sha256(u.running, config.source_sha256) != ESP_OK)
+		config.read_source = NULL;
+
+	gn_err_t ret = GN_RET_ERR;
+	bool ota_begun = false;
+	bool retry = true;
+
+	uint8_t *buf = gn_mem_malloc(GN_MEM_TAG_CORE, GN_OTA_READ_SIZE);
+	gn_ota_patcher_handle_t p = gn_ota_patcher_create(&config);
+	if (p)
+		_gn_ota_checkpoint_resume(&u, &p, &config);
+	if (!buf || !p) {
+		ESP_LOGE(TAG, "cannot start the update");
+		goto end;
+	}
+
+	if (esp_ota_begin(u.update, OTA_WITH_SEQUENTIAL_WRITES, &u.ota) != ESP_OK) {
+		gn_log(TAG, GN_LOG_ERROR, "firmware update - cannot write %s",
+				u.update->label);
+		goto end;
+	}
+	ota_begun = true;
+
+	gn_ota_patcher_info_t info;
+	gn_ota_patcher_get_info(p, &info);
+	u.session_start = info.consumed;
+	u.start = esp_timer_get_time();
+
+	for (int attempt = 0;; attempt++) {
+		ret = _gn_ota_download(&u, p, buf, &retry);
+		//the bytes written belong to another file, a restart is not a retry
+		if (u.changed) {
+			p = _gn_ota_restart(&u, p, &config);
+			if (!p) {
+				ret = GN_RET_ERR;
+				retry = false;
+				break;
+			}
+			attempt--;
+			continue;
+		}
+		if (ret == GN_RET_OK || !retry || attempt >= CONFIG_GROWNODE_OTA_RETRIES)
+			break;
+		gn_ota_patcher_get_info(p, &info);
+		gn_log(TAG, GN_LOG_WARNING,
+				"firmware update - interrupted at %u bytes, retry %d of %d",
+				(unsigned) info.consumed, attempt + 1,
+				CONFIG_GROWNODE_OTA_RETRIES);
+		vTaskDelay(CONFIG_GROWNODE_OTA_RETRY_DELAY_MS / portTICK_PERIOD_MS);
+	}
+
+	if (ret != GN_RET_OK) {
+		//the next update resumes from here
+		if (retry)
+			_gn_ota_checkpoint_save(&u, p);
+		else
+			_gn_ota_checkpoint_clear();
+		gn_log(TAG, GN_LOG_ERROR, "firmware update - %s",
+				ret == GN_RET_ERR_INVALID_ARG ?
+						"image refused" : "download failed");
+		goto end;
+	}
+
+	ret = gn_ota_patcher_finish(p);
+	_gn_ota_checkpoint_clear();
+	if (ret != GN_RET_OK) {
+		gn_log(TAG, GN_LOG_ERROR, "firmware update - verification failed");
+		goto end;
+	}
+
+	ret = GN_RET_ERR;
+	ota_begun = false;
+	if (esp_ota_end(u.ota) != ESP_OK
+			|| esp_ota_set_boot_partition(u.update) != ESP_OK) {
+		gn_log(TAG, GN_LOG_ERROR, "firmware update - image not valid");
+		goto end;
+	}
+
+	gn_ota_patcher_get_info(p, &info);
+	gn_log(TAG, GN_LOG_INFO,
+			"firmware update done - %u bytes downloaded, %u written in %d s",
+			(unsigned) (info.consumed - u.session_start),
+			(unsigned) info.written,
+			(int) ((esp_timer_get_time() - u.start) / 1000000));
+	ret = GN_RET_OK;
+
+	end: if (ota_begun)
+		esp_ota_abort(u.ota);
+	gn_ota_patcher_delete(p);
+	gn_mem_free(buf);
+	return ret;
+
+}
+
+#ifdef __cplusplus
+}
+#endif //__cplusplus
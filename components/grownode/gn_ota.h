@@ -0,0 +1,159 @@
+// Copyright 2021 Nicola Muratori (nicola.muratori@gmail.com)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef GN_OTA_H_
+#define GN_OTA_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "sdkconfig.h"
+#include "gn_commons.h"
+
+/*
+ * firmware updates streamed into the OTA partition with bounded RAM. the firmware url serves either
+ * a plain application image, written as is, or a GrowNode OTA container:
+ *
+ *  header, little endian:
+ *   "GNOT" magic, u8 version (1), u8 type, u8 compression, u8 reserved,
+ *   u32 size of the resulting image, 32 bytes SHA-256 of the resulting image,
+ *   32 bytes SHA-256 of the source image (delta only, the app hash of the running partition)
+ *  payload:
+ *   - type full: the image
+ *   - type delta: operations rebuilding the image from the running one.
+ *     0x01 u32 offset u32 length copies from the running image, 0x02 u32 length <bytes> inserts bytes
+ *  compression lzss: the payload is split in blocks of at most GN_OTA_BLOCK_SIZE bytes, each one
+ *   u16 plain length, u16 packed length (0 if stored) and the packed bytes. blocks are LZSS coded
+ *   with a GN_OTA_LZ_WINDOW_SIZE window reset at each block: a flag byte, lsb first, tells a literal
+ *   (1) from a match (0) of 2 bytes, offset - 1 in 12 bits and length - 3 in 4 bits
+ *
+ * a delta against another source is refused before writing. the SHA-256 of the resulting image is
+ * checked before the boot partition is switched.
+ *
+ * downloads are resumed with HTTP range requests: after a disconnection from the byte reached,
+ * after a reboot from the last checkpoint saved in NVS. checkpoints are taken anywhere in
+ * uncompressed payloads and at block boundaries in compressed ones.
+ * containers are built on the host by host_test/gn_ota_pack.
+ */
+
+#define GN_OTA_MAGIC "GNOT"
+#define GN_OTA_VERSION 1
+#define GN_OTA_HEADER_SIZE 76
+#define GN_OTA_SHA256_SIZE 32
+
+#define GN_OTA_BLOCK_SIZE 16384
+#define GN_OTA_LZ_WINDOW_SIZE 4096
+#define GN_OTA_LZ_MIN_MATCH 3
+#define GN_OTA_LZ_MAX_MATCH 18
+
+#define GN_OTA_OP_COPY 0x01
+#define GN_OTA_OP_INSERT 0x02
+
+//output buffered before each write, a flash sector
+#define GN_OTA_WRITE_SIZE 4096
+//download buffer
+#define GN_OTA_READ_SIZE 1024
+//progress is logged every GN_OTA_PROGRESS_STEP percent
+#define GN_OTA_PROGRESS_STEP 10
+
+typedef enum {
+	GN_OTA_IMAGE_PLAIN = -1, /*!< no container, written as is */
+	GN_OTA_IMAGE_FULL = 0,
+	GN_OTA_IMAGE_DELTA = 1
+} gn_ota_image_type_t;
+
+typedef enum {
+	GN_OTA_COMPRESSION_NONE = 0, GN_OTA_COMPRESSION_LZSS = 1
+} gn_ota_compression_t;
+
+/**
+ * @brief	writes the next bytes of the resulting image
+ */
+typedef gn_err_t (*gn_ota_write_cb_t)(void *arg, const uint8_t *data,
+		size_t len);
+
+/**
+ * @brief	reads the source image of a delta, or back the resulting image
+ */
+typedef gn_err_t (*gn_ota_read_cb_t)(void *arg, size_t offset, uint8_t *data,
+		size_t len);
+
+typedef struct {
+	gn_ota_write_cb_t write;
+	gn_ota_read_cb_t read_source; /*!< NULL if deltas are not accepted */
+	gn_ota_read_cb_t read_target; /*!< NULL if the patcher cannot be resumed */
+	void *arg;
+	uint8_t source_sha256[GN_OTA_SHA256_SIZE]; /*!< app hash of the source image */
+	size_t source_size;
+} gn_ota_patcher_config_t;
+
+typedef struct {
+	bool header_done; /*!< the image type is known */
+	gn_ota_image_type_t type;
+	gn_ota_compression_t compression;
+	size_t target_size; /*!< 0 if unknown (plain image) */
+	size_t consumed; /*!< bytes fed */
+	size_t written; /*!< bytes of the resulting image */
+	size_t resumable; /*!< bytes fed up to the last point a checkpoint can restart from */
+} gn_ota_patcher_info_t;
+
+/**
+ * @brief	state of a patcher, enough to resume it: the resulting image is read back up to written
+ */
+typedef struct {
+	uint32_t consumed; /*!< offset of the download to restart from */
+	uint32_t written;
+	int8_t type;
+	uint8_t op;
+	uint8_t op_args_len;
+	uint8_t reserved;
+	uint32_t op_left;
+	uint8_t op_args[8];
+	uint8_t header[GN_OTA_HEADER_SIZE];
+} gn_ota_checkpoint_t;
+
+typedef struct gn_ota_patcher *gn_ota_patcher_handle_t;
+
+gn_ota_patcher_handle_t gn_ota_patcher_create(
+		const gn_ota_patcher_config_t *config);
+
+gn_err_t gn_ota_patcher_feed(gn_ota_patcher_handle_t patcher,
+		const uint8_t *data, size_t len);
+
+gn_err_t gn_ota_patcher_finish(gn_ota_patcher_handle_t patcher);
+
+gn_err_t gn_ota_patcher_get_info(gn_ota_patcher_handle_t patcher,
+		gn_ota_patcher_info_t *info);
+
+gn_err_t gn_ota_patcher_checkpoint(gn_ota_patcher_handle_t patcher,
+		gn_ota_checkpoint_t *checkpoint);
+
+gn_err_t gn_ota_patcher_resume(gn_ota_patcher_handle_t patcher,
+		const gn_ota_checkpoint_t *checkpoint);
+
+void gn_ota_patcher_delete(gn_ota_patcher_handle_t patcher);
+
+gn_err_t gn_ota_update(const char *url, const char *cert_pem);
+
+#ifdef __cplusplus
+}
+#endif //__cplusplus
+
+#endif /* GN_OTA_H_ */
@@ -0,0 +1,857 @@
+// Copyright 2021 Nicola Muratori (nicola.muratori@gmail.com)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <ctype.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "grownode.h"
+#include "gn_rules.h"
+
+#define TAG "gn_rules"
+
+//opcodes, the ones up to GN_RULES_OP_JZ take a one byte operand
+typedef enum {
+	GN_RULES_OP_END = 0,
+	GN_RULES_OP_CONST, /*!< push constant */
+	GN_RULES_OP_LOAD, /*!< push parameter */
+	GN_RULES_OP_STORE, /*!< pop into parameter */
+	GN_RULES_OP_JZ, /*!< pop, jump to the rule offset if zero */
+	GN_RULES_OP_ADD,
+	GN_RULES_OP_SUB,
+	GN_RULES_OP_MUL,
+	GN_RULES_OP_DIV,
+	GN_RULES_OP_EQ,
+	GN_RULES_OP_NE,
+	GN_RULES_OP_LT,
+	GN_RULES_OP_LE,
+	GN_RULES_OP_GT,
+	GN_RULES_OP_GE,
+	GN_RULES_OP_AND,
+	GN_RULES_OP_OR,
+	GN_RULES_OP_NOT,
+	GN_RULES_OP_NEG
+} gn_rules_op_t;
+
+typedef enum {
+	GN_RULES_TOK_END,
+	GN_RULES_TOK_SEP,
+	GN_RULES_TOK_COMMA,
+	GN_RULES_TOK_NUM,
+	GN_RULES_TOK_ID,
+	GN_RULES_TOK_WHEN,
+	GN_RULES_TOK_THEN,
+	GN_RULES_TOK_LPAR,
+	GN_RULES_TOK_RPAR,
+	GN_RULES_TOK_ASSIGN,
+	GN_RULES_TOK_OP, /*!< operator, opcode in op */
+	GN_RULES_TOK_ERROR
+} gn_rules_tok_t;
+
+typedef struct {
+	char leaf_name[GN_LEAF_NAME_SIZE];
+	char param_name[GN_LEAF_PARAM_NAME_SIZE];
+	uint32_t hash;
+	uint32_t readers; /*!< mask of the rules reading the parameter */
+	gn_leaf_handle_t leaf; /*!< resolved on first use, leaves can be created after the rules */
+	gn_leaf_param_handle_t param;
+	gn_val_type_t type;
+} gn_rules_ref_t;
+
+typedef struct {
+	size_t rule_count;
+	size_t ref_count;
+	size_t const_count;
+	size_t code_len;
+	uint16_t rules[GN_RULES_MAX_RULES]; /*!< bytecode offset of each rule */
+	gn_rules_ref_t refs[GN_RULES_MAX_REFS];
+	uint8_t index[GN_RULES_MAX_REFS]; /*!< refs sorted by hash */
+	double consts[GN_RULES_MAX_CONSTS];
+	uint8_t code[GN_RULES_CODE_SIZE];
+} gn_rules_program_t;
+
+struct gn_rules {
+	gn_leaf_handle_t leaf_config;
+	char leaf_name[GN_LEAF_NAME_SIZE];
+	gn_leaf_param_handle_t param;
+	gn_rules_program_t *program;
+	gn_rules_stats_t stats;
+};
+
+typedef struct {
+	gn_rules_program_t *p;
+	const char *host; /*!< leaf of the unqualified parameters */
+	const char *s;
+	gn_rules_tok_t tok;
+	gn_rules_op_t op;
+	double num;
+	char id[GN_LEAF_NAME_SIZE + GN_LEAF_PARAM_NAME_SIZE];
+	size_t rule;
+	int depth;
+	const char *error;
+} gn_rules_compiler_t;
+
+static uint32_t _gn_rules_hash(const char *leaf_name, const char *param_name) {
+
+	//FNV-1a over leaf.param
+	uint32_t h = 2166136261u;
+	for (const char *c = leaf_name; *c; c++)
+		h = (h ^ (uint8_t) *c) * 16777619u;
+	h = (h ^ '.') * 16777619u;
+	for (const char *c = param_name; *c; c++)
+		h = (h ^ (uint8_t) *c) * 16777619u;
+	return h;
+
+}
+
+//compiler
+
+static void _gn_rules_next(gn_rules_compiler_t *c) {
+
+	while (*c->s == ' ' || *c->s == '\t' || *c->s == '\r')
+		c->s++;
+
+	const char *s = c->s;
+	if (*s == '\0') {
+		c->tok = GN_RULES_TOK_END;
+		return;
+	}
+
+	if (isdigit((unsigned char) *s)
+			|| (*s == '.' && isdigit((unsigned char) s[1]))) {
+		char *end;
+		c->num = strtod(s, &end);
+		c->s = end;
+		c->tok = GN_RULES_TOK_NUM;
+		return;
+	}
+
+	if (isalpha((unsigned char) *s) || *s == '_') {
+		size_t len = 0;
+		while (isalnum((unsigned char) s[len]) || s[len] == '_' || s[len] == '.')
+			len++;
+		c->s += len;
+		if (len >= sizeof(c->id)) {
+			c->tok = GN_RULES_TOK_ERROR;
+			return;
+		}
+		memcpy(c->id, s, len);
+		c->id[len] = '\0';
+
+		c->tok = GN_RULES_TOK_OP;
+		if (strcmp(c->id, "when") == 0)
+			c->tok = GN_RULES_TOK_WHEN;
+		else if (strcmp(c->id, "then") == 0)
+			c->tok = GN_RULES_TOK_THEN;
+		else if (strcmp(c->id, "true") == 0 || strcmp(c->id, "false") == 0) {
+			c->tok = GN_RULES_TOK_NUM;
+			c->num = c->id[0] == 't';
+		} else if (strcmp(c->id, "and") == 0)
+			c->op = GN_RULES_OP_AND;
+		else if (strcmp(c->id, "or") == 0)
+			c->op = GN_RULES_OP_OR;
+		else if (strcmp(c->id, "not") == 0)
+			c->op = GN_RULES_OP_NOT;
+		else
+			c->tok = GN_RULES_TOK_ID;
+		return;
+	}
+
+	//two characters operators first
+	static const struct {
+		const char *text;
+		gn_rules_op_t op;
+	} ops[] = { { "==", GN_RULES_OP_EQ }, { "!=", GN_RULES_OP_NE }, { "<=",
+			GN_RULES_OP_LE }, { ">=", GN_RULES_OP_GE }, { "&&", GN_RULES_OP_AND },
+			{ "||", GN_RULES_OP_OR }, { "<", GN_RULES_OP_LT }, { ">",
+					GN_RULES_OP_GT }, { "!", GN_RULES_OP_NOT }, { "+",
+					GN_RULES_OP_ADD }, { "-", GN_RULES_OP_SUB }, { "*",
+					GN_RULES_OP_MUL }, { "/", GN_RULES_OP_DIV } };
+	for (size_t i = 0; i < sizeof(ops) / sizeof(ops[0]); i++) {
+		size_t len = strlen(ops[i].text);
+		if (strncmp(s, ops[i].text, len) == 0) {
+			c->s += len;
+			c->tok = GN_RULES_TOK_OP;
+			c->op = ops[i].op;
+			return;
+		}
+	}
+
+	c->s++;
+	switch (*s) {
+	case ';':
+	case '\n':
+		c->tok = GN_RULES_TOK_SEP;
+		break;
+	case ',':
+		c->tok = GN_RULES_TOK_COMMA;
+		break;
+	case '(':
+		c->tok = GN_RULES_TOK_LPAR;
+		break;
+	case ')':
+		c->tok = GN_RULES_TOK_RPAR;
+		break;
+	case '=':
+		c->tok = GN_RULES_TOK_ASSIGN;
+		break;
+	default:
+		c->tok = GN_RULES_TOK_ERROR;
+		break;
+	}
+
+}
+
+static bool _gn_rules_fail(gn_rules_compiler_t *c, const char *error) {
+	if (!c->error)
+		c->error = error;
+	return false;
+}
+
+static bool _gn_rules_emit(gn_rules_compiler_t *c, gn_rules_op_t op,
+		int operand) {
+
+	static const int8_t stack_effect[] = { [GN_RULES_OP_END] = 0,
+			[GN_RULES_OP_CONST] = 1, [GN_RULES_OP_LOAD] = 1,
+			[GN_RULES_OP_STORE] = -1, [GN_RULES_OP_JZ] = -1, [GN_RULES_OP_NOT
+					] = 0, [GN_RULES_OP_NEG] = 0 };
+
+	gn_rules_program_t *p = c->p;
+	size_t size = op <= GN_RULES_OP_JZ ? 2 : 1;
+	if (p->code_len + size > GN_RULES_CODE_SIZE
+			|| p->code_len + size - p->rules[c->rule] > GN_RULES_RULE_CODE_MAX)
+		return _gn_rules_fail(c, "program too long");
+
+	p->code[p->code_len++] = op;
+	if (size == 2)
+		p->code[p->code_len++] = operand;
+
+	//binary operators pop two and push one
+	c->depth += op >= GN_RULES_OP_ADD && op <= GN_RULES_OP_OR ?
+			-1 : stack_effect[op];
+	if (c->depth > GN_RULES_STACK_SIZE)
+		return _gn_rules_fail(c, "expression too deep");
+
+	return true;
+
+}
+
+static int _gn_rules_ref(gn_rules_compiler_t *c, bool read) {
+
+	gn_rules_program_t *p = c->p;
+	const char *leaf_name = c->host;
+	const char *param_name = c->id;
+
+	char *dot = strchr(c->id, '.');
+	if (dot) {
+		*dot = '\0';
+		leaf_name = c->id;
+		param_name = dot + 1;
+	}
+
+	if (strlen(leaf_name) >= GN_LEAF_NAME_SIZE || strlen(param_name) == 0
+			|| strlen(param_name) >= GN_LEAF_PARAM_NAME_SIZE
+			|| strchr(param_name, '.')) {
+		_gn_rules_fail(c, "invalid parameter name");
+		return -1;
+	}
+
+	size_t i = 0;
+	while (i < p->ref_count
+			&& (strcmp(p->refs[i].leaf_name, leaf_name) != 0
+					|| strcmp(p->refs[i].param_name, param_name) != 0))
+		i++;
+
+	if (i == p->ref_count) {
+		if (p->ref_count == GN_RULES_MAX_REFS) {
+			_gn_rules_fail(c, "too many parameters");
+			return -1;
+		}
+		strcpy(p->refs[i].leaf_name, leaf_name);
+		strcpy(p->refs[i].param_name, param_name);
+		p->refs[i].hash = _gn_rules_hash(leaf_name, param_name);
+		p->ref_count++;
+	}
+
+	if (read)
+		p->refs[i].readers |= 1u << c->rule;
+	return i;
+
+}
+
+static int _gn_rules_const(gn_rules_compiler_t *c, double val) {
+
+	gn_rules_program_t *p = c->p;
+	size_t i = 0;
+	while (i < p->const_count && p->consts[i] != val)
+		i++;
+	if (i == p->const_count) {
+		if (p->const_count == GN_RULES_MAX_CONSTS) {
+			_gn_rules_fail(c, "too many constants");
+			return -1;
+		}
+		p->consts[p->const_count++] = val;
+	}
+	return i;
+
+}
+
+static bool _gn_rules_expr(gn_rules_compiler_t *c);
+
+static bool _gn_rules_unary(gn_rules_compiler_t *c) {
+
+	if (c->tok == GN_RULES_TOK_OP
+			&& (c->op == GN_RULES_OP_NOT || c->op == GN_RULES_OP_SUB)) {
+		gn_rules_op_t op =
+				c->op == GN_RULES_OP_NOT ? GN_RULES_OP_NOT : GN_RULES_OP_NEG;
+		_gn_rules_next(c);
+		return _gn_rules_unary(c) && _gn_rules_emit(c, op, 0);
+	}
+
+	int operand;
+	switch (c->tok) {
+	case GN_RULES_TOK_NUM:
+		operand = _gn_rules_const(c, c->num);
+		_gn_rules_next(c);
+		return operand >= 0 && _gn_rules_emit(c, GN_RULES_OP_CONST, operand);
+	case GN_RULES_TOK_ID:
+		operand = _gn_rules_ref(c, true);
+		_gn_rules_next(c);
+		return operand >= 0 && _gn_rules_emit(c, GN_RULES_OP_LOAD, operand);
+	case GN_RULES_TOK_LPAR:
+		_gn_rules_next(c);
+		if (!_gn_rules_expr(c))
+			return false;
+		if (c->tok != GN_RULES_TOK_RPAR)
+			return _gn_rules_fail(c, "missing )");
+		_gn_rules_next(c);
+		return true;
+	default:
+		return _gn_rules_fail(c, "value expected");
+	}
+
+}
+
+//precedence climbing, from the loosest binding level
+static bool _gn_rules_binary(gn_rules_compiler_t *c, int level) {
+
+	static const gn_rules_op_t levels[][6] = { { GN_RULES_OP_OR }, {
+			GN_RULES_OP_AND }, { GN_RULES_OP_EQ, GN_RULES_OP_NE, GN_RULES_OP_LT,
+			GN_RULES_OP_LE, GN_RULES_OP_GT, GN_RULES_OP_GE }, { GN_RULES_OP_ADD,
+			GN_RULES_OP_SUB }, { GN_RULES_OP_MUL, GN_RULES_OP_DIV } };
+	const int count = sizeof(levels) / sizeof(levels[0]);
+
+	if (level == count)
+		return _gn_rules_unary(c);
+
+	if (!_gn_rules_binary(c, level + 1))
+		return false;
+
+	while (c->tok == GN_RULES_TOK_OP) {
+		gn_rules_op_t op = c->op;
+		bool found = false;
+		for (int i = 0; i < 6 && levels[level][i] != GN_RULES_OP_END; i++)
+			found |= levels[level][i] == op;
+		if (!found)
+			break;
+		_gn_rules_next(c);
+		if (!_gn_rules_binary(c, level + 1) || !_gn_rules_emit(c, op, 0))
+			return false;
+	}
+	return true;
+
+}
+
+static bool _gn_rules_expr(gn_rules_compiler_t *c) {
+	return _gn_rules_binary(c, 0);
+}
+
+static bool _gn_rules_rule(gn_rules_compiler_t *c) {
+
+	gn_rules_program_t *p = c->p;
+
+	if (p->rule_count == GN_RULES_MAX_RULES)
+		return _gn_rules_fail(c, "too many rules");
+	c->rule = p->rule_count++;
+	p->rules[c->rule] = p->code_len;
+	c->depth = 0;
+
+	if (c->tok != GN_RULES_TOK_WHEN)
+		return _gn_rules_fail(c, "'when' expected");
+	_gn_rules_next(c);
+
+	if (!_gn_rules_expr(c))
+		return false;
+	if (c->tok != GN_RULES_TOK_THEN)
+		return _gn_rules_fail(c, "'then' expected");
+
+	size_t jz = p->code_len + 1;
+	if (!_gn_rules_emit(c, GN_RULES_OP_JZ, 0))
+		return false;
+
+	do {
+		_gn_rules_next(c);
+		if (c->tok != GN_RULES_TOK_ID)
+			return _gn_rules_fail(c, "parameter expected");
+		int target = _gn_rules_ref(c, false);
+		if (target < 0)
+			return false;
+		_gn_rules_next(c);
+		if (c->tok != GN_RULES_TOK_ASSIGN)
+			return _gn_rules_fail(c, "'=' expected");
+		_gn_rules_next(c);
+		if (!_gn_rules_expr(c)
+				|| !_gn_rules_emit(c, GN_RULES_OP_STORE, target))
+			return false;
+	} while (c->tok == GN_RULES_TOK_COMMA);
+
+	if (!_gn_rules_emit(c, GN_RULES_OP_END, 0))
+		return false;
+	p->code[jz] = p->code_len - 1 - p->rules[c->rule];
+
+	return true;
+
+}
+
+/**
+ * @brief	compiles the rules text into the program
+ *
+ * @return	NULL if successful, the error otherwise
+ */
+static const char* _gn_rules_compile(gn_rules_program_t *p, const char *host,
+		const char *text) {
+
+	memset(p, 0, sizeof(gn_rules_program_t));
+	gn_rules_compiler_t c = { .p = p, .host = host, .s = text };
+
+	_gn_rules_next(&c);
+	while (c.tok != GN_RULES_TOK_END) {
+		if (c.tok == GN_RULES_TOK_SEP) {
+			_gn_rules_next(&c);
+			continue;
+		}
+		if (!_gn_rules_rule(&c))
+			return c.error;
+		if (c.tok != GN_RULES_TOK_SEP && c.tok != GN_RULES_TOK_END)
+			return "end of rule expected";
+	}
+
+	//dependency index
+	for (size_t i = 0; i < p->ref_count; i++) {
+		size_t j = i;
+		for (; j > 0 && p->refs[p->index[j - 1]].hash > p->refs[i].hash; j--)
+			p->index[j] = p->index[j - 1];
+		p->index[j] = i;
+	}
+
+	return NULL;
+
+}
+
+//evaluation
+
+static bool _gn_rules_resolve(gn_rules_handle_t rules, gn_rules_ref_t *ref) {
+
+	if (ref->param)
+		return true;
+
+	ref->leaf = gn_leaf_get_config_handle(gn_leaf_get_node(rules->leaf_config),
+			ref->leaf_name);
+	if (!ref->leaf)
+		return false;
+
+	gn_leaf_param_handle_t param = gn_leaf_param_get_param_handle(ref->leaf,
+			ref->param_name);
+	if (!param || gn_leaf_param_get_type(param, &ref->type) != GN_RET_OK
+			|| ref->type == GN_VAL_TYPE_STRING)
+		return false;
+
+	ref->param = param;
+	return true;
+
+}
+
+static bool _gn_rules_read(gn_rules_handle_t rules, gn_rules_ref_t *ref,
+		double *val) {
+
+	if (!_gn_rules_resolve(rules, ref))
+		return false;
+
+	if (ref->type == GN_VAL_TYPE_BOOLEAN) {
+		bool b = false;
+		gn_leaf_param_get_value(ref->param, &b);
+		*val = b;
+	} else
+		gn_leaf_param_get_value(ref->param, val);
+	return true;
+
+}
+
+static bool _gn_rules_write(gn_rules_handle_t rules, gn_rules_ref_t *ref,
+		double val) {
+
+	double current;
+	if (!_gn_rules_read(rules, ref, &current))
+		return false;
+
+	if (ref->type == GN_VAL_TYPE_BOOLEAN) {
+		if ((val != 0) == (current != 0))
+			return true;
+		gn_leaf_param_set_bool(ref->leaf, ref->param_name, val != 0);
+	} else {
+		if (!isfinite(val) || val == current)
+			return true;
+		gn_leaf_param_set_double(ref->leaf, ref->param_name, val);
+	}
+
+	rules->stats.actions++;
+	return true;
+
+}
+
+//runs a rule, the stack depth is checked by the compiler
+static void _gn_rules_run(gn_rules_handle_t rules, size_t rule) {
+
+	gn_rules_program_t *p = rules->program;
+	const uint8_t *code = p->code + p->rules[rule];
+	double stack[GN_RULES_STACK_SIZE];
+	int sp = 0;
+	size_t pc = 0;
+
+	rules->stats.evaluations++;
+
+	while (true) {
+		gn_rules_op_t op = code[pc++];
+		switch (op) {
+		case GN_RULES_OP_END:
+			return;
+		case GN_RULES_OP_CONST:
+			stack[sp++] = p->consts[code[pc++]];
+			break;
+		case GN_RULES_OP_LOAD:
+			if (!_gn_rules_read(rules, &p->refs[code[pc++]], &stack[sp++])) {
+				rules->stats.unresolved++;
+				return;
+			}
+			break;
+		case GN_RULES_OP_STORE:
+			if (!_gn_rules_write(rules, &p->refs[code[pc++]], stack[--sp]))
+				rules->stats.unresolved++;
+			break;
+		case GN_RULES_OP_JZ:
+			if (stack[--sp] == 0)
+				pc = code[pc];
+			else {
+				pc++;
+				rules->stats.fired++;
+			}
+			break;
+		case GN_RULES_OP_NOT:
+			stack[sp - 1] = stack[sp - 1] == 0;
+			break;
+		case GN_RULES_OP_NEG:
+			stack[sp - 1] = -stack[sp - 1];
+			break;
+		default: {
+			double b = stack[--sp];
+			double *a = &stack[sp - 1];
+			switch (op) {
+			case GN_RULES_OP_ADD:
+				*a += b;
+				break;
+			case GN_RULES_OP_SUB:
+				*a -= b;
+				break;
+			case GN_RULES_OP_MUL:
+				*a *= b;
+				break;
+			case GN_RULES_OP_DIV:
+				*a /= b;
+				break;
+			case GN_RULES_OP_EQ:
+				*a = *a == b;
+				break;
+			case GN_RULES_OP_NE:
+				*a = *a != b;
+				break;
+			case GN_RULES_OP_LT:
+				*a = *a < b;
+				break;
+			case GN_RULES_OP_LE:
+				*a = *a <= b;
+				break;
+			case GN_RULES_OP_GT:
+				*a = *a > b;
+				break;
+			case GN_RULES_OP_GE:
+				*a = *a >= b;
+				break;
+			case GN_RULES_OP_AND:
+				*a = *a != 0 && b != 0;
+				break;
+			case GN_RULES_OP_OR:
+				*a = *a != 0 || b != 0;
+				break;
+			default:
+				return;
+			}
+		}
+		}
+	}
+
+}
+
+static void _gn_rules_evaluate(gn_rules_handle_t rules, uint32_t mask) {
+
+	int64_t start = esp_timer_get_time();
+	int64_t elapsed = 0;
+
+	for (size_t i = 0; i < rules->program->rule_count; i++) {
+		if (!(mask & (1u << i)))
+			continue;
+		if (elapsed > GN_RULES_BUDGET_US) {
+			rules->stats.overruns++;
+			ESP_LOGW(TAG, "[%s] evaluation budget exceeded at rule %d",
+					rules->leaf_name, (int ) i);
+			break;
+		}
+		_gn_rules_run(rules, i);
+		elapsed = esp_timer_get_time() - start;
+	}
+
+	rules->stats.busy_us += elapsed;
+	if (elapsed > rules->stats.max_us)
+		rules->stats.max_us = elapsed;
+
+}
+
+/**
+ * @brief	creates the rules of a leaf, with the persisted GN_RULES_PARAM parameter holding them.
+ * to be called in the leaf configuration callback, the stored rules take precedence over the
+ * ones given. the leaf has to subscribe to GN_LEAF_PARAM_CHANGED_EVENT and pass the events to
+ * gn_rules_on_change, rules are not thread safe and live in the leaf task
+ *
+ * @param	leaf_config	the hosting leaf
+ * @param	rules		default rules
+ *
+ * @return	the rules, NULL in case of errors
+ */
+gn_rules_handle_t gn_rules_create(gn_leaf_handle_t leaf_config,
+		const char *rules) {
+
+	if (!leaf_config)
+		return NULL;
+
+	gn_rules_handle_t ret = gn_mem_calloc(gn_leaf_get_mem_tag(leaf_config), 1,
+			sizeof(struct gn_rules));
+	if (!ret)
+		return NULL;
+
+	ret->leaf_config = leaf_config;
+	gn_leaf_get_name(leaf_config, ret->leaf_name);
+
+	ret->param = gn_leaf_param_create(leaf_config, GN_RULES_PARAM,
+			GN_VAL_TYPE_STRING, (gn_val_t ) { .s = (char*) (rules ? rules : "") },
+			GN_LEAF_PARAM_ACCESS_ALL, GN_LEAF_PARAM_STORAGE_PERSISTED,
+			gn_rules_validator);
+	if (!ret->param
+			|| gn_leaf_param_add_to_leaf(leaf_config, ret->param)
+					!= GN_RET_OK) {
+		gn_mem_free(ret);
+		return NULL;
+	}
+
+	char *text = gn_mem_malloc(gn_leaf_get_mem_tag(leaf_config),
+			GN_RULES_TEXT_SIZE);
+	if (text
+			&& gn_leaf_param_get_string(leaf_config, GN_RULES_PARAM, text,
+					GN_RULES_TEXT_SIZE) == GN_RET_OK) {
+		text[GN_RULES_TEXT_SIZE - 1] = '\0';
+		gn_rules_load(ret, text);
+	}
+	gn_mem_free(text);
+
+	return ret;
+
+}
+
+/**
+ * @brief	compiles and replaces the rules. the parameters are resolved when first used
+ *
+ * @return	GN_RET_ERR_INVALID_ARG if the text does not compile, the current rules are kept
+ */
+gn_err_t gn_rules_load(gn_rules_handle_t rules, const char *text) {
+
+	if (!rules || !text)
+		return GN_RET_ERR_INVALID_ARG;
+
+	gn_rules_program_t *p = gn_mem_malloc(
+			gn_leaf_get_mem_tag(rules->leaf_config),
+			sizeof(gn_rules_program_t));
+	if (!p)
+		return GN_RET_ERR;
+
+	const char *error = _gn_rules_compile(p, rules->leaf_name, text);
+	if (error) {
+		ESP_LOGW(TAG, "[%s] rules refused: %s", rules->leaf_name, error);
+		gn_mem_free(p);
+		return GN_RET_ERR_INVALID_ARG;
+	}
+
+	gn_mem_free(rules->program);
+	rules->program = p;
+
+	rules->stats.rules = p->rule_count;
+	rules->stats.refs = p->ref_count;
+	rules->stats.code_bytes = p->code_len;
+
+	ESP_LOGI(TAG, "[%s] %d rules, %d parameters, %d bytes", rules->leaf_name,
+			(int ) p->rule_count, (int ) p->ref_count, (int ) p->code_len);
+	return GN_RET_OK;
+
+}
+
+/**
+ * @brief	validator of the rules parameter, refuses texts that do not compile
+ */
+gn_leaf_param_validator_result_t gn_rules_validator(
+		gn_leaf_param_handle_t param, void **param_value) {
+
+	gn_rules_program_t *p = gn_mem_malloc(GN_MEM_TAG_PARAMS,
+			sizeof(gn_rules_program_t));
+	if (!p)
+		return GN_LEAF_PARAM_VALIDATOR_ERROR_GENERIC;
+
+	const char *error = _gn_rules_compile(p, "", *(char**) param_value);
+	gn_mem_free(p);
+
+	return error ?
+			GN_LEAF_PARAM_VALIDATOR_ERROR_NOT_ALLOWED :
+			GN_LEAF_PARAM_VALIDATOR_PASSED;
+
+}
+
+/**
+ * @brief	applies new rules coming from the network, evaluating all of them
+ *
+ * @return	true if the event was addressed to the rules parameter
+ */
+bool gn_rules_param_event(gn_rules_handle_t rules,
+		gn_leaf_parameter_event_handle_t evt) {
+
+	if (!rules || !evt || gn_leaf_event_mask_param(evt, rules->param) != 0)
+		return false;
+
+	char *text = gn_mem_calloc(gn_leaf_get_mem_tag(rules->leaf_config),
+			GN_RULES_TEXT_SIZE, sizeof(char));
+	if (!text)
+		return true;
+
+	gn_event_payload_to_string(*evt, text, GN_RULES_TEXT_SIZE - 1);
+	if (gn_leaf_param_force_string(rules->leaf_config, GN_RULES_PARAM, text)
+			== GN_RET_OK && gn_rules_load(rules, text) == GN_RET_OK)
+		gn_rules_evaluate_all(rules);
+	else
+		ESP_LOGW(TAG, "[%s] refused rules '%s'", rules->leaf_name, text);
+
+	gn_mem_free(text);
+	return true;
+
+}
+
+/**
+ * @brief	evaluates the rules reading the changed parameter
+ *
+ * @param	rules	the rules
+ * @param	evt		a GN_LEAF_PARAM_CHANGED_EVENT
+ *
+ * @return	true if some rules were evaluated
+ */
+bool gn_rules_on_change(gn_rules_handle_t rules,
+		gn_leaf_parameter_event_handle_t evt) {
+
+	if (!rules || !rules->program || !evt
+			|| evt->id != GN_LEAF_PARAM_CHANGED_EVENT)
+		return false;
+
+	gn_rules_program_t *p = rules->program;
+	uint32_t hash = _gn_rules_hash(evt->leaf_name, evt->param_name);
+
+	//first ref with the hash
+	size_t lo = 0, hi = p->ref_count;
+	while (lo < hi) {
+		size_t mid = (lo + hi) / 2;
+		if (p->refs[p->index[mid]].hash < hash)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	uint32_t mask = 0;
+	for (; lo < p->ref_count && p->refs[p->index[lo]].hash == hash; lo++) {
+		gn_rules_ref_t *ref = &p->refs[p->index[lo]];
+		if (strcmp(ref->leaf_name, evt->leaf_name) == 0
+				&& strcmp(ref->param_name, evt->param_name) == 0)
+			mask |= ref->readers;
+	}
+
+	if (!mask)
+		return false;
+
+	_gn_rules_evaluate(rules, mask);
+	return true;
+
+}
+
+/**
+ * @brief	evaluates all the rules, eg. to apply them to the current state
+ */
+void gn_rules_evaluate_all(gn_rules_handle_t rules) {
+
+	if (!rules || !rules->program || rules->program->rule_count == 0)
+		return;
+	_gn_rules_evaluate(rules,
+			(uint32_t) ((1ull << rules->program->rule_count) - 1));
+
+}
+
+void gn_rules_get_stats(gn_rules_handle_t rules, gn_rules_stats_t *stats) {
+
+	if (!rules || !stats)
+		return;
+	*stats = rules->stats;
+
+}
+
+void gn_rules_delete(gn_rules_handle_t rules) {
+
+	if (!rules)
+		return;
+	gn_mem_free(rules->program);
+	gn_mem_free(rules);
+
+}
+
+#ifdef __cplusplus
+}
+#endif //__cplusplus
@@ -0,0 +1,95 @@
+// Copyright 2021 Nicola Muratori (nicola.muratori@gmail.com)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef GN_RULES_H_
+#define GN_RULES_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "gn_commons.h"
+
+/*
+ * declarative rules hosted by a leaf, compiled once into a compact stack bytecode and evaluated
+ * only when one of the parameters they read changes. rules are separated by ';' or new lines,
+ * actions by ',':
+ *
+ *   when wat_lev.trg_low == true then plt_pump.toggle = false
+ *   when temps.temp1 > wat_t_temp + 1 then plt_b.toggle = true, plt_a.toggle = false
+ *
+ * a parameter is referenced as leaf.param, or just param for the hosting leaf. expressions
+ * support numbers, true/false, + - * /, comparisons, && || ! (or and/or/not) and parentheses,
+ * booleans count as 1 and 0. an action sends a change request to the target parameter, as if
+ * it came from the network, only if the value differs from the current one.
+ *
+ * the host persists the rules in its GN_RULES_PARAM string parameter, updatable over the network.
+ * program size and stack depth are bounded at compile time, the evaluations triggered by one
+ * change stop after GN_RULES_BUDGET_US
+ */
+
+#define GN_RULES_MAX_RULES 16
+#define GN_RULES_MAX_REFS 24
+#define GN_RULES_MAX_CONSTS 32
+#define GN_RULES_CODE_SIZE 512
+#define GN_RULES_RULE_CODE_MAX 128 /*!< bytes of bytecode for a single rule */
+#define GN_RULES_STACK_SIZE 8
+#define GN_RULES_BUDGET_US 2000
+#define GN_RULES_TEXT_SIZE GN_LEAF_DATA_SIZE
+#define GN_RULES_PARAM "rules"
+
+typedef struct gn_rules *gn_rules_handle_t;
+
+typedef struct {
+	uint32_t rules; /*!< rules compiled */
+	uint32_t refs; /*!< distinct parameters referenced */
+	uint32_t code_bytes; /*!< bytecode size */
+	uint32_t evaluations; /*!< rules evaluated */
+	uint32_t fired; /*!< evaluations with a true condition */
+	uint32_t actions; /*!< change requests sent */
+	uint32_t unresolved; /*!< evaluations skipped for a missing or string parameter */
+	uint32_t overruns; /*!< changes whose rules did not fit in the budget */
+	uint64_t busy_us; /*!< time spent evaluating */
+	uint32_t max_us; /*!< longest evaluation of a change */
+} gn_rules_stats_t;
+
+gn_rules_handle_t gn_rules_create(gn_leaf_handle_t leaf_config,
+		const char *rules);
+
+gn_err_t gn_rules_load(gn_rules_handle_t rules, const char *text);
+
+gn_leaf_param_validator_result_t gn_rules_validator(
+		gn_leaf_param_handle_t param, void **param_value);
+
+bool gn_rules_param_event(gn_rules_handle_t rules,
+		gn_leaf_parameter_event_handle_t evt);
+
+bool gn_rules_on_change(gn_rules_handle_t rules,
+		gn_leaf_parameter_event_handle_t evt);
+
+void gn_rules_evaluate_all(gn_rules_handle_t rules);
+
+void gn_rules_get_stats(gn_rules_handle_t rules, gn_rules_stats_t *stats);
+
+void gn_rules_delete(gn_rules_handle_t rules);
+
+#ifdef __cplusplus
+}
+#endif //__cplusplus
+
+#endif /* GN_RULES_H_ */
@@ -0,0 +1,401 @@
+// Copyright 2021 Nicola Muratori (nicola.muratori@gmail.com)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "gn_sampler.h"
+
+#define TAG "gn_sampler"
+
+#define GN_SAMPLER_TASK_STACK CONFIG_GROWNODE_SAMPLER_STACK_SIZE
+#define GN_SAMPLER_TASK_PRIORITY 5
+
+struct gn_sampler_job {
+	bool used;
+	gn_sampler_job_config_t config;
+	char name[GN_SAMPLER_JOB_NAME_SIZE];
+	int64_t phase_us; /*!< offset from the period grid, set by the bus slot */
+	int64_t deadline_us;
+	int heap_index; /*!< position in the deadline heap, -1 when stopped */
+	gn_sampler_job_stats_t stats;
+};
+
+static struct gn_sampler_job _gn_sampler_jobs[GN_SAMPLER_MAX_JOBS];
+
+//min-heap of the started jobs, earliest deadline first
+static struct gn_sampler_job *_gn_sampler_heap[GN_SAMPLER_MAX_JOBS];
+static size_t _gn_sampler_heap_size = 0;
+
+static SemaphoreHandle_t _gn_sampler_mutex = NULL;
+static SemaphoreHandle_t _gn_sampler_wake = NULL; /*!< the earliest deadline changed */
+
+static void _gn_sampler_heap_swap(size_t a, size_t b) {
+
+	struct gn_sampler_job *t = _gn_sampler_heap[a];
+	_gn_sampler_heap[a] = _gn_sampler_heap[b];
+	_gn_sampler_heap[b] = t;
+	_gn_sampler_heap[a]->heap_index = a;
+	_gn_sampler_heap[b]->heap_index = b;
+
+}
+
+static void _gn_sampler_heap_up(size_t i) {
+
+	while (i > 0) {
+		size_t parent = (i - 1) / 2;
+		if (_gn_sampler_heap[parent]->deadline_us
+				<= _gn_sampler_heap[i]->deadline_us)
+			break;
+		_gn_sampler_heap_swap(i, parent);
+		i = parent;
+	}
+
+}
+
+static void _gn_sampler_heap_down(size_t i) {
+
+	while (true) {
+		size_t min = i;
+		size_t l = 2 * i + 1, r = 2 * i + 2;
+		if (l < _gn_sampler_heap_size
+				&& _gn_sampler_heap[l]->deadline_us
+						< _gn_sampler_heap[min]->deadline_us)
+			min = l;
+		if (r < _gn_sampler_heap_size
+				&& _gn_sampler_heap[r]->deadline_us
+						< _gn_sampler_heap[min]->deadline_us)
+			min = r;
+		if (min == i)
+			break;
+		_gn_sampler_heap_swap(i, min);
+		i = min;
+	}
+
+}
+
+static void _gn_sampler_heap_push(struct gn_sampler_job *job) {
+
+	job->heap_index = _gn_sampler_heap_size;
+	_gn_sampler_heap[_gn_sampler_heap_size++] = job;
+	_gn_sampler_heap_up(job->heap_index);
+
+}
+
+static void _gn_sampler_heap_remove(struct gn_sampler_job *job) {
+
+	size_t i = job->heap_index;
+	job->heap_index = -1;
+	_gn_sampler_heap_size--;
+	if (i == _gn_sampler_heap_size)
+		return;
+	_gn_sampler_heap[i] = _gn_sampler_heap[_gn_sampler_heap_size];
+	_gn_sampler_heap[i]->heap_index = i;
+	_gn_sampler_heap_up(i);
+	_gn_sampler_heap_down(_gn_sampler_heap[i]->heap_index);
+
+}
+
+/**
+ * @brief	first deadline on the grid of the job after the time given
+ */
+static int64_t _gn_sampler_next_deadline(const struct gn_sampler_job *job,
+		int64_t after_us) {
+
+	int64_t period = job->stats.period_us;
+	//a phase longer than the period just moves the job to another slot of the grid
+	int64_t phase = job->phase_us % period;
+	int64_t k = (after_us - phase) / period + 1;
+	return k * period + phase;
+
+}
+
+static void _gn_sampler_task(void *arg) {
+
+	xSemaphoreTake(_gn_sampler_mutex, portMAX_DELAY);
+
+	while (true) {
+
+		TickType_t wait = portMAX_DELAY;
+		int64_t now = esp_timer_get_time();
+
+		if (_gn_sampler_heap_size > 0
+				&& _gn_sampler_heap[0]->deadline_us <= now) {
+
+			struct gn_sampler_job *job = _gn_sampler_heap[0];
+			int64_t deadline = job->deadline_us;
+
+			//missed deadlines are skipped, the job stays on its grid
+			int64_t next = _gn_sampler_next_deadline(job, now);
+			job->stats.skipped += (next - deadline) / job->stats.period_us - 1;
+			job->deadline_us = next;
+			_gn_sampler_heap_down(0);
+
+			gn_sampler_cb_t callback = job->config.callback;
+			void *cb_arg = job->config.arg;
+
+			xSemaphoreGive(_gn_sampler_mutex);
+			callback(cb_arg);
+			int64_t end = esp_timer_get_time();
+			xSemaphoreTake(_gn_sampler_mutex, portMAX_DELAY);
+
+			int64_t jitter = now - deadline;
+			int64_t duration = end - now;
+			job->stats.runs++;
+			job->stats.jitter_sum_us += jitter;
+			if (jitter > job->stats.jitter_max_us)
+				job->stats.jitter_max_us = jitter;
+			job->stats.duration_sum_us += duration;
+			if (duration > job->stats.duration_max_us)
+				job->stats.duration_max_us = duration;
+			if (end > next)
+				job->stats.overruns++;
+			continue;
+
+		}
+
+		if (_gn_sampler_heap_size > 0) {
+			int64_t wait_ms = (_gn_sampler_heap[0]->deadline_us - now + 999)
+					/ 1000;
+			wait = (wait_ms + portTICK_PERIOD_MS - 1) / portTICK_PERIOD_MS;
+		}
+
+		xSemaphoreGive(_gn_sampler_mutex);
+		xSemaphoreTake(_gn_sampler_wake, wait);
+		xSemaphoreTake(_gn_sampler_mutex, portMAX_DELAY);
+
+	}
+
+}
+
+/**
+ * @brief	starts the sampler task. called once by gn_init, before any leaf can create a job
+ *
+ * @return	GN_RET_ERR if the task cannot be started, jobs cannot be created afterwards
+ */
+gn_err_t gn_sampler_init() {
+
+	if (_gn_sampler_mutex)
+		return GN_RET_OK;
+
+	_gn_sampler_mutex = xSemaphoreCreateMutex();
+	_gn_sampler_wake = xSemaphoreCreateBinary();
+	if (!_gn_sampler_mutex || !_gn_sampler_wake
+			|| xTaskCreate(_gn_sampler_task, "gn_sampler",
+					GN_SAMPLER_TASK_STACK, NULL, GN_SAMPLER_TASK_PRIORITY,
+					NULL) != pdPASS) {
+		ESP_LOGE(TAG, "cannot start the sampler task");
+		if (_gn_sampler_mutex)
+			vSemaphoreDelete(_gn_sampler_mutex);
+		if (_gn_sampler_wake)
+			vSemaphoreDelete(_gn_sampler_wake);
+		_gn_sampler_mutex = NULL;
+		_gn_sampler_wake = NULL;
+		return GN_RET_ERR;
+	}
+
+	return GN_RET_OK;
+
+}
+
+/**
+ * @brief	creates a stopped job. the worker task starts with the first job
+ *
+ * @param	config	callback and bus of the job. the name is copied
+ * @param	job		the handle of the new job
+ *
+ * @return	GN_RET_OK if the job is created
+ * @return	GN_RET_ERR_INVALID_ARG without a callback
+ * @return	GN_RET_ERR if GN_SAMPLER_MAX_JOBS are already in use or the sampler task is not running
+ */
+gn_err_t gn_sampler_job_create(const gn_sampler_job_config_t *config,
+		gn_sampler_job_handle_t *job) {
+
+	if (!config || !config->callback || !job)
+		return GN_RET_ERR_INVALID_ARG;
+
+	if (!_gn_sampler_mutex)
+		return GN_RET_ERR;
+
+	xSemaphoreTake(_gn_sampler_mutex, portMAX_DELAY);
+
+	struct gn_sampler_job *j = NULL;
+	size_t slot = 0;
+	for (size_t i = 0; i < GN_SAMPLER_MAX_JOBS; i++) {
+		if (!_gn_sampler_jobs[i].used) {
+			if (!j)
+				j = &_gn_sampler_jobs[i];
+		} else if (config->bus != GN_SAMPLER_BUS_NONE
+				&& _gn_sampler_jobs[i].config.bus == config->bus)
+			slot++;
+	}
+
+	if (j) {
+		memset(j, 0, sizeof(struct gn_sampler_job));
+		j->used = true;
+		j->config = *config;
+		strncpy(j->name, config->name ? config->name : "job",
+				GN_SAMPLER_JOB_NAME_SIZE - 1);
+		j->config.name = j->name;
+		j->phase_us = slot * GN_SAMPLER_BUS_STAGGER_MS * 1000LL;
+		j->heap_index = -1;
+	}
+
+	xSemaphoreGive(_gn_sampler_mutex);
+
+	if (!j) {
+		ESP_LOGE(TAG, "gn_sampler_job_create - no free jobs");
+		return GN_RET_ERR;
+	}
+
+	ESP_LOGD(TAG, "job %s created, bus %d, phase %lld ms", j->name,
+			config->bus, (long long ) (j->phase_us / 1000));
+	*job = j;
+	return GN_RET_OK;
+
+}
+
+/**
+ * @brief	runs the job every period, from the next instant of its grid at least half a period
+ * from now. a started job is restarted with the new period and its statistics reset
+ */
+gn_err_t gn_sampler_job_start(gn_sampler_job_handle_t job, uint64_t period_us) {
+
+	if (!job || !job->used || period_us == 0)
+		return GN_RET_ERR_INVALID_ARG;
+
+	xSemaphoreTake(_gn_sampler_mutex, portMAX_DELAY);
+
+	if (job->heap_index >= 0)
+		_gn_sampler_heap_remove(job);
+
+	memset(&job->stats, 0, sizeof(gn_sampler_job_stats_t));
+	job->stats.period_us = period_us;
+	job->deadline_us = _gn_sampler_next_deadline(job,
+			esp_timer_get_time() + period_us / 2 - 1);
+	_gn_sampler_heap_push(job);
+
+	xSemaphoreGive(_gn_sampler_mutex);
+	xSemaphoreGive(_gn_sampler_wake);
+
+	return GN_RET_OK;
+
+}
+
+/**
+ * @brief	stops the job. a run in progress is completed
+ */
+gn_err_t gn_sampler_job_stop(gn_sampler_job_handle_t job) {
+
+	if (!job || !job->used)
+		return GN_RET_ERR_INVALID_ARG;
+
+	xSemaphoreTake(_gn_sampler_mutex, portMAX_DELAY);
+	if (job->heap_index >= 0)
+		_gn_sampler_heap_remove(job);
+	xSemaphoreGive(_gn_sampler_mutex);
+
+	return GN_RET_OK;
+
+}
+
+gn_err_t gn_sampler_job_delete(gn_sampler_job_handle_t job) {
+
+	if (!job || !job->used)
+		return GN_RET_ERR_INVALID_ARG;
+
+	xSemaphoreTake(_gn_sampler_mutex, portMAX_DELAY);
+	if (job->heap_index >= 0)
+		_gn_sampler_heap_remove(job);
+	job->used = false;
+	xSemaphoreGive(_gn_sampler_mutex);
+
+	return GN_RET_OK;
+
+}
+
+gn_err_t gn_sampler_job_get_stats(gn_sampler_job_handle_t job,
+		gn_sampler_job_stats_t *stats) {
+
+	if (!job || !job->used || !stats)
+		return GN_RET_ERR_INVALID_ARG;
+
+	xSemaphoreTake(_gn_sampler_mutex, portMAX_DELAY);
+	*stats = job->stats;
+	xSemaphoreGive(_gn_sampler_mutex);
+
+	return GN_RET_OK;
+
+}
+
+/**
+ * @brief	statistics of the started jobs
+ *
+ * @return	a json object with an entry per job, to be deleted by the caller
+ */
+cJSON* gn_sampler_stats_to_json() {
+
+	cJSON *root = cJSON_CreateObject();
+	if (!root || !_gn_sampler_mutex)
+		return root;
+
+	for (size_t i = 0; i < GN_SAMPLER_MAX_JOBS; i++) {
+
+		xSemaphoreTake(_gn_sampler_mutex, portMAX_DELAY);
+		bool started = _gn_sampler_jobs[i].used
+				&& _gn_sampler_jobs[i].heap_index >= 0;
+		gn_sampler_job_stats_t s = _gn_sampler_jobs[i].stats;
+		char name[GN_SAMPLER_JOB_NAME_SIZE];
+		strcpy(name, _gn_sampler_jobs[i].name);
+		int64_t phase_us = _gn_sampler_jobs[i].phase_us;
+		xSemaphoreGive(_gn_sampler_mutex);
+
+		if (!started)
+			continue;
+
+		cJSON *job = cJSON_CreateObject();
+		if (!job)
+			break;
+		cJSON_AddItemToObject(root, name, job);
+
+		cJSON_AddNumberToObject(job, "period_ms", s.period_us / 1000);
+		cJSON_AddNumberToObject(job, "phase_ms", phase_us / 1000);
+		cJSON_AddNumberToObject(job, "runs", s.runs);
+		cJSON_AddNumberToObject(job, "skipped", s.skipped);
+		cJSON_AddNumberToObject(job, "overruns", s.overruns);
+		cJSON_AddNumberToObject(job, "jitter_avg_us",
+				s.runs ? s.jitter_sum_us / s.runs : 0);
+		cJSON_AddNumberToObject(job, "jitter_max_us", s.jitter_max_us);
+		cJSON_AddNumberToObject(job, "duration_avg_us",
+				s.runs ? s.duration_sum_us / s.runs : 0);
+		cJSON_AddNumberToObject(job, "duration_max_us", s.duration_max_us);
+
+	}
+
+	return root;
+
+}
+
+#ifdef __cplusplus
+}
+#endif //__cplusplus
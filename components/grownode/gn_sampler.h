@@ -0,0 +1,88 @@
+// Copyright 2021 Nicola Muratori (nicola.muratori@gmail.com)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GN_SAMPLER_H_
+#define GN_SAMPLER_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+#include "sdkconfig.h"
+#include "cJSON.h"
+#include "gn_commons.h"
+
+/*
+ * sensor polling scheduler: periodic sensor jobs of the leaves run on a single worker task,
+ * ordered by deadline, instead of the esp_timer task. job deadlines are aligned on a grid of
+ * their period, so jobs with the same (or a multiple) period run together and their publishes
+ * are grouped, while jobs on the same bus are shifted by GN_SAMPLER_BUS_STAGGER_MS each.
+ * every job keeps jitter, duration and overrun statistics
+ */
+
+#define GN_SAMPLER_MAX_JOBS 32
+#define GN_SAMPLER_JOB_NAME_SIZE 32
+#define GN_SAMPLER_BUS_STAGGER_MS 25
+
+//buses shared by the jobs
+#define GN_SAMPLER_BUS_NONE (-1)
+#define GN_SAMPLER_BUS_I2C(port) (0x100 + (port))
+#define GN_SAMPLER_BUS_ADC1 0x200
+#define GN_SAMPLER_BUS_TOUCH 0x300
+
+typedef struct gn_sampler_job *gn_sampler_job_handle_t;
+
+typedef void (*gn_sampler_cb_t)(void *arg);
+
+typedef struct {
+	gn_sampler_cb_t callback; /*!< runs on the worker task, must not block longer than needed by the I/O */
+	void *arg;
+	const char *name; /*!< statistics key, usually the leaf name */
+	int bus; /*!< jobs on the same bus never start together. GN_SAMPLER_BUS_NONE if not relevant */
+} gn_sampler_job_config_t;
+
+typedef struct {
+	uint64_t period_us;
+	uint32_t runs;
+	uint32_t skipped; /*!< deadlines not served because the worker was late by more than a period */
+	uint32_t overruns; /*!< runs ended after the next deadline of the job */
+	int64_t jitter_sum_us; /*!< start delays from the deadline */
+	int64_t jitter_max_us;
+	int64_t duration_sum_us;
+	int64_t duration_max_us;
+} gn_sampler_job_stats_t;
+
+gn_err_t gn_sampler_init();
+
+gn_err_t gn_sampler_job_create(const gn_sampler_job_config_t *config,
+		gn_sampler_job_handle_t *job);
+
+gn_err_t gn_sampler_job_start(gn_sampler_job_handle_t job, uint64_t period_us);
+
+gn_err_t gn_sampler_job_stop(gn_sampler_job_handle_t job);
+
+gn_err_t gn_sampler_job_delete(gn_sampler_job_handle_t job);
+
+gn_err_t gn_sampler_job_get_stats(gn_sampler_job_handle_t job,
+		gn_sampler_job_stats_t *stats);
+
+cJSON* gn_sampler_stats_to_json();
+
+#ifdef __cplusplus
+}
+#endif //__cplusplus
+
+#endif /* GN_SAMPLER_H_ */
@@ -0,0 +1,840 @@
+// Copyright 2021 Nicola Muratori (nicola.muratori@gmail.com)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <string.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include <sys/time.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_sleep.h"
+
+#include "gn_scheduler.h"
+
+#define TAG "gn_scheduler"
+
+#define GN_SCHEDULER_TASK_STACK CONFIG_GROWNODE_SCHEDULER_STACK_SIZE
+#define GN_SCHEDULER_TASK_PRIORITY 5
+//longest single wait of the task, a far job is waited in steps so the tick count cannot overflow
+#define GN_SCHEDULER_WAIT_MAX_MS 3600000LL
+
+//wall times before are considered as a clock not set yet (2021-01-01)
+#define GN_SCHEDULER_CLOCK_VALID_SEC 1609459200LL
+//bound of the calendar search, enough for a yearly job on february 29th
+#define GN_SCHEDULER_SEARCH_STEPS 4000
+
+typedef enum {
+	GN_SCHEDULER_CRON, GN_SCHEDULER_EVERY, GN_SCHEDULER_AFTER
+} gn_scheduler_kind_t;
+
+typedef struct {
+	gn_scheduler_kind_t kind;
+	uint64_t minutes; /*!< bit 0..59 */
+	uint32_t hours; /*!< bit 0..23 */
+	uint32_t days; /*!< bit 1..31 */
+	uint16_t months; /*!< bit 1..12 */
+	uint8_t weekdays; /*!< bit 0..6, 0 is sunday */
+	bool days_any;
+	bool weekdays_any;
+	int64_t period_us; /*!< for intervals and one shot jobs */
+} gn_scheduler_spec_t;
+
+struct gn_scheduler_job {
+	bool used;
+	gn_scheduler_job_config_t config;
+	char name[GN_SCHEDULER_JOB_NAME_SIZE];
+	gn_scheduler_spec_t spec;
+	bool started;
+	bool waiting_clock;
+	int64_t due_us;
+	int64_t wall_us; /*!< wall time of the next run, 0 if the clock is not set */
+	int heap_index; /*!< position in the due heap, -1 if not queued */
+	uint32_t runs;
+	int64_t late_max_us;
+};
+
+static const char *_gn_scheduler_macros[][2] = { { "@hourly", "0 * * * *" }, {
+		"@daily", "0 0 * * *" }, { "@midnight", "0 0 * * *" }, { "@weekly",
+		"0 0 * * 0" }, { "@monthly", "0 0 1 * *" }, { "@yearly", "0 0 1 1 *" },
+		{ "@annually", "0 0 1 1 *" } };
+
+static struct gn_scheduler_job _gn_scheduler_jobs[GN_SCHEDULER_MAX_JOBS];
+
+//min-heap of the queued jobs, earliest due time first
+static struct gn_scheduler_job *_gn_scheduler_heap[GN_SCHEDULER_MAX_JOBS];
+static size_t _gn_scheduler_heap_size = 0;
+
+static SemaphoreHandle_t _gn_scheduler_mutex = NULL;
+static SemaphoreHandle_t _gn_scheduler_wake = NULL;
+static bool _gn_scheduler_timer_wakeup = false;
+
+static void _gn_scheduler_heap_swap(size_t a, size_t b) {
+
+	struct gn_scheduler_job *t = _gn_scheduler_heap[a];
+	_gn_scheduler_heap[a] = _gn_scheduler_heap[b];
+	_gn_scheduler_heap[b] = t;
+	_gn_scheduler_heap[a]->heap_index = a;
+	_gn_scheduler_heap[b]->heap_index = b;
+
+}
+
+static void _gn_scheduler_heap_up(size_t i) {
+
+	while (i > 0) {
+		size_t parent = (i - 1) / 2;
+		if (_gn_scheduler_heap[parent]->due_us <= _gn_scheduler_heap[i]->due_us)
+			break;
+		_gn_scheduler_heap_swap(i, parent);
+		i = parent;
+	}
+
+}
+
+static void _gn_scheduler_heap_down(size_t i) {
+
+	while (true) {
+		size_t min = i;
+		size_t l = 2 * i + 1, r = 2 * i + 2;
+		if (l < _gn_scheduler_heap_size
+				&& _gn_scheduler_heap[l]->due_us
+						< _gn_scheduler_heap[min]->due_us)
+			min = l;
+		if (r < _gn_scheduler_heap_size
+				&& _gn_scheduler_heap[r]->due_us
+						< _gn_scheduler_heap[min]->due_us)
+			min = r;
+		if (min == i)
+			break;
+		_gn_scheduler_heap_swap(i, min);
+		i = min;
+	}
+
+}
+
+static void _gn_scheduler_heap_push(struct gn_scheduler_job *job) {
+
+	job->heap_index = _gn_scheduler_heap_size;
+	_gn_scheduler_heap[_gn_scheduler_heap_size++] = job;
+	_gn_scheduler_heap_up(job->heap_index);
+
+}
+
+static void _gn_scheduler_heap_remove(struct gn_scheduler_job *job) {
+
+	size_t i = job->heap_index;
+	job->heap_index = -1;
+	_gn_scheduler_heap_size--;
+	if (i == _gn_scheduler_heap_size)
+		return;
+	_gn_scheduler_heap[i] = _gn_scheduler_heap[_gn_scheduler_heap_size];
+	_gn_scheduler_heap[i]->heap_index = i;
+	_gn_scheduler_heap_up(i);
+	_gn_scheduler_heap_down(_gn_scheduler_heap[i]->heap_index);
+
+}
+
+/**
+ * @brief	parses a cron field in the range given, eg. "*", "1,15", "9-17", "* /10", "5-59/15"
+ */
+static bool _gn_scheduler_parse_field(const char *field, int min, int max,
+		uint64_t *mask, bool *any) {
+
+	*mask = 0;
+	*any = strcmp(field, "*") == 0;
+
+	const char *s = field;
+	while (true) {
+
+		long lo, hi, step = 1;
+		char *end;
+
+		if (*s == '*') {
+			lo = min;
+			hi = max;
+			s++;
+		} else {
+			if (!isdigit((unsigned char ) *s))
+				return false;
+			lo = strtol(s, &end, 10);
+			s = end;
+			hi = lo;
+			if (*s == '-') {
+				s++;
+				if (!isdigit((unsigned char ) *s))
+					return false;
+				hi = strtol(s, &end, 10);
+				s = end;
+			}
+		}
+
+		if (*s == '/') {
+			s++;
+			if (!isdigit((unsigned char ) *s))
+				return false;
+			step = strtol(s, &end, 10);
+			s = end;
+			//"n/step" runs from n to the end of the range
+			if (hi == lo && field[0] != '*')
+				hi = max;
+		}
+
+		if (lo < min || hi > max || lo > hi || step <= 0)
+			return false;
+
+		for (long v = lo; v <= hi; v += step)
+			*mask |= 1ULL << v;
+
+		if (*s == '\0')
+			return true;
+		if (*s++ != ',')
+			return false;
+
+	}
+
+}
+
+/**
+ * @brief	parses a duration as a sequence of <number><unit>, eg. "90s", "1h30m", "250ms"
+ */
+static bool _gn_scheduler_parse_duration(const char *s, int64_t *us) {
+
+	int64_t total = 0;
+
+	if (*s == '\0')
+		return false;
+
+	while (*s) {
+
+		if (!isdigit((unsigned char ) *s))
+			return false;
+		char *end;
+		long long n = strtoll(s, &end, 10);
+		s = end;
+
+		int64_t unit;
+		if (strncmp(s, "ms", 2) == 0) {
+			unit = 1000LL;
+			s += 2;
+		} else if (*s == 's')
+			unit = 1000000LL;
+		else if (*s == 'm')
+			unit = 60 * 1000000LL;
+		else if (*s == 'h')
+			unit = 3600 * 1000000LL;
+		else if (*s == 'd')
+			unit = 86400 * 1000000LL;
+		else
+			return false;
+		if (unit != 1000LL)
+			s++;
+
+		//a year is far enough
+		if (n > 366LL * 86400 * 1000)
+			return false;
+		total += n * unit;
+
+	}
+
+	*us = total;
+	return total > 0 && total <= 366LL * 86400 * 1000000LL;
+
+}
+
+static bool _gn_scheduler_parse(const char *text,
+		gn_scheduler_spec_t *spec) {
+
+	char buf[GN_SCHEDULER_SPEC_SIZE];
+	char *fields[6];
+	int n = 0;
+	char *save = NULL;
+
+	if (!text || strlen(text) >= sizeof(buf))
+		return false;
+	strcpy(buf, text);
+
+	for (char *tok = strtok_r(buf, " \t", &save); tok;
+			tok = strtok_r(NULL, " \t", &save)) {
+		if (n == 6)
+			return false;
+		fields[n++] = tok;
+	}
+
+	memset(spec, 0, sizeof(gn_scheduler_spec_t));
+
+	if (n > 0 && fields[0][0] == '@') {
+
+		if (n == 1) {
+			for (size_t i = 0;
+					i
+							< sizeof(_gn_scheduler_macros)
+									/ sizeof(_gn_scheduler_macros[0]); i++)
+				if (strcmp(fields[0], _gn_scheduler_macros[i][0]) == 0)
+					return _gn_scheduler_parse(_gn_scheduler_macros[i][1],
+							spec);
+			return false;
+		}
+
+		if (n != 2)
+			return false;
+		if (strcmp(fields[0], "@every") == 0)
+			spec->kind = GN_SCHEDULER_EVERY;
+		else if (strcmp(fields[0], "@after") == 0)
+			spec->kind = GN_SCHEDULER_AFTER;
+		else
+			return false;
+		return _gn_scheduler_parse_duration(fields[1], &spec->period_us);
+
+	}
+
+	if (n != 5)
+		return false;
+
+	uint64_t mask;
+	bool any;
+	spec->kind = GN_SCHEDULER_CRON;
+
+	if (!_gn_scheduler_parse_field(fields[0], 0, 59, &mask, &any))
+		return false;
+	spec->minutes = mask;
+	if (!_gn_scheduler_parse_field(fields[1], 0, 23, &mask, &any))
+		return false;
+	spec->hours = mask;
+	if (!_gn_scheduler_parse_field(fields[2], 1, 31, &mask, &any))
+		return false;
+	spec->days = mask;
+	spec->days_any = any;
+	if (!_gn_scheduler_parse_field(fields[3], 1, 12, &mask, &any))
+		return false;
+	spec->months = mask;
+	if (!_gn_scheduler_parse_field(fields[4], 0, 7, &mask, &any))
+		return false;
+	spec->weekdays = (mask | mask >> 7) & 0x7F;
+	spec->weekdays_any = any;
+
+	return true;
+
+}
+
+static int _gn_scheduler_next_bit(uint64_t mask, int from, int max) {
+
+	for (int i = from; i <= max; i++)
+		if (mask & (1ULL << i))
+			return i;
+	return -1;
+
+}
+
+static bool _gn_scheduler_day_match(const gn_scheduler_spec_t *spec,
+		const struct tm *tm) {
+
+	bool day = spec->days & (1UL << tm->tm_mday);
+	bool weekday = spec->weekdays & (1U << tm->tm_wday);
+	//a restricted day of month or of week matches alone, like cron
+	if (spec->days_any || spec->weekdays_any)
+		return day && weekday;
+	return day || weekday;
+
+}
+
+/**
+ * @brief	first minute after the time given matching the calendar fields, in local time
+ */
+static bool _gn_scheduler_cron_next(const gn_scheduler_spec_t *spec,
+		time_t after, time_t *next) {
+
+	struct tm tm;
+	time_t t = after - after % 60 + 60;
+	localtime_r(&t, &tm);
+
+	for (int i = 0; i < GN_SCHEDULER_SEARCH_STEPS; i++) {
+
+		int v;
+		if (!(spec->months & (1U << (tm.tm_mon + 1)))) {
+			tm.tm_mon++;
+			tm.tm_mday = 1;
+			tm.tm_hour = 0;
+			tm.tm_min = 0;
+		} else if (!_gn_scheduler_day_match(spec, &tm)) {
+			tm.tm_mday++;
+			tm.tm_hour = 0;
+			tm.tm_min = 0;
+		} else if ((v = _gn_scheduler_next_bit(spec->hours, tm.tm_hour, 23))
+				!= tm.tm_hour) {
+			if (v < 0)
+				tm.tm_mday++;
+			tm.tm_hour = v < 0 ? 0 : v;
+			tm.tm_min = 0;
+		} else if ((v = _gn_scheduler_next_bit(spec->minutes, tm.tm_min, 59))
+				!= tm.tm_min) {
+			if (v < 0)
+				tm.tm_hour++;
+			tm.tm_min = v < 0 ? 0 : v;
+		} else if (t > after) {
+			*next = t;
+			return true;
+		} else
+			//a local time repeated by a DST change
+			tm.tm_min++;
+
+		tm.tm_sec = 0;
+		tm.tm_isdst = -1;
+		t = mktime(&tm);
+		if (t == (time_t) -1)
+			return false;
+
+	}
+
+	return false;
+
+}
+
+static bool _gn_scheduler_clock(int64_t *wall_us) {
+
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	*wall_us = tv.tv_sec * 1000000LL + tv.tv_usec;
+	return tv.tv_sec >= GN_SCHEDULER_CLOCK_VALID_SEC;
+
+}
+
+/**
+ * @brief	computes the next run of a started job and queues it. one shot jobs are stopped after
+ * their run, calendar jobs wait for the clock
+ *
+ * @param	first		the job is (re)started, not rescheduled after a run
+ * @param	grace_us	how far in the past a run can be found for a first schedule
+ */
+static void _gn_scheduler_plan(struct gn_scheduler_job *job, bool first,
+		int64_t grace_us) {
+
+	int64_t now = esp_timer_get_time();
+	int64_t wall;
+	bool clock = _gn_scheduler_clock(&wall);
+
+	//never runs the same slot twice, even if the clock is adjusted backwards
+	int64_t from = wall - grace_us;
+	if (!first && job->wall_us > from)
+		from = job->wall_us;
+
+	int64_t period = job->spec.period_us;
+	int64_t next_wall = 0;
+	int64_t due;
+	job->waiting_clock = false;
+
+	switch (job->spec.kind) {
+
+	case GN_SCHEDULER_AFTER:
+		if (!first) {
+			job->started = false;
+			return;
+		}
+		due = now + period;
+		if (clock)
+			next_wall = wall + period;
+		break;
+
+	case GN_SCHEDULER_EVERY:
+		if (clock) {
+			next_wall = (from / period + 1) * period;
+			due = now + next_wall - wall;
+		} else {
+			due = (first ? now : job->due_us) + period;
+			if (due < now)
+				due += ((now - due) / period + 1) * period;
+		}
+		break;
+
+	default: {
+		time_t t;
+		if (!clock) {
+			job->waiting_clock = true;
+			job->wall_us = 0;
+			return;
+		}
+		if (!_gn_scheduler_cron_next(&job->spec, from / 1000000LL, &t)) {
+			ESP_LOGW(TAG, "job %s has no next run, stopped", job->name);
+			job->started = false;
+			return;
+		}
+		next_wall = t * 1000000LL;
+		due = now + next_wall - wall;
+	}
+		break;
+
+	}
+
+	job->due_us = due < now ? now : due;
+	job->wall_us = next_wall;
+	_gn_scheduler_heap_push(job);
+
+}
+
+//arms the timer for the earliest job. called with the mutex taken
+//the earliest job changed, the task computes its wait again
+static void _gn_scheduler_arm() {
+	xSemaphoreGive(_gn_scheduler_wake);
+}
+
+static void _gn_scheduler_task(void *arg) {
+
+	xSemaphoreTake(_gn_scheduler_mutex, portMAX_DELAY);
+
+	while (true) {
+
+		TickType_t wait = portMAX_DELAY;
+		int64_t now = esp_timer_get_time();
+
+		if (_gn_scheduler_heap_size > 0
+				&& _gn_scheduler_heap[0]->due_us <= now) {
+
+			struct gn_scheduler_job *job = _gn_scheduler_heap[0];
+			int64_t late = now - job->due_us;
+			job->runs++;
+			if (late > job->late_max_us)
+				job->late_max_us = late;
+
+			_gn_scheduler_heap_remove(job);
+			_gn_scheduler_plan(job, false, 0);
+
+			gn_scheduler_cb_t callback = job->config.callback;
+			void *cb_arg = job->config.arg;
+
+			//the callback can start and stop jobs
+			xSemaphoreGive(_gn_scheduler_mutex);
+			callback(cb_arg);
+			xSemaphoreTake(_gn_scheduler_mutex, portMAX_DELAY);
+			continue;
+
+		}
+
+		if (_gn_scheduler_heap_size > 0) {
+			int64_t wait_ms = (_gn_scheduler_heap[0]->due_us - now + 999)
+					/ 1000;
+			if (wait_ms > GN_SCHEDULER_WAIT_MAX_MS)
+				wait_ms = GN_SCHEDULER_WAIT_MAX_MS;
+			wait = (wait_ms + portTICK_PERIOD_MS - 1) / portTICK_PERIOD_MS;
+		}
+
+		xSemaphoreGive(_gn_scheduler_mutex);
+		xSemaphoreTake(_gn_scheduler_wake, wait);
+		xSemaphoreTake(_gn_scheduler_mutex, portMAX_DELAY);
+
+	}
+
+}
+
+/**
+ * @brief	starts the scheduler task. called once by gn_init, before any leaf can create a job
+ *
+ * @return	GN_RET_ERR if the task cannot be started, jobs cannot be created afterwards
+ */
+gn_err_t gn_scheduler_init() {
+
+	if (_gn_scheduler_mutex)
+		return GN_RET_OK;
+
+	_gn_scheduler_timer_wakeup = esp_sleep_get_wakeup_cause()
+			== ESP_SLEEP_WAKEUP_TIMER;
+
+	_gn_scheduler_mutex = xSemaphoreCreateMutex();
+	_gn_scheduler_wake = xSemaphoreCreateBinary();
+	if (!_gn_scheduler_mutex || !_gn_scheduler_wake
+			|| xTaskCreate(_gn_scheduler_task, "gn_scheduler",
+					GN_SCHEDULER_TASK_STACK, NULL, GN_SCHEDULER_TASK_PRIORITY,
+					NULL) != pdPASS) {
+		ESP_LOGE(TAG, "cannot start the scheduler task");
+		if (_gn_scheduler_mutex)
+			vSemaphoreDelete(_gn_scheduler_mutex);
+		if (_gn_scheduler_wake)
+			vSemaphoreDelete(_gn_scheduler_wake);
+		_gn_scheduler_mutex = NULL;
+		_gn_scheduler_wake = NULL;
+		return GN_RET_ERR;
+	}
+
+	return GN_RET_OK;
+
+}
+
+/**
+ * @brief	creates a stopped job
+ *
+ * @param	config	callback of the job. the name is copied
+ * @param	job		the handle of the new job
+ *
+ * @return	GN_RET_OK if the job is created
+ * @return	GN_RET_ERR_INVALID_ARG without a callback
+ * @return	GN_RET_ERR if GN_SCHEDULER_MAX_JOBS are already in use or the scheduler timer was not created
+ */
+gn_err_t gn_scheduler_job_create(const gn_scheduler_job_config_t *config,
+		gn_scheduler_job_handle_t *job) {
+
+	if (!config || !config->callback || !job)
+		return GN_RET_ERR_INVALID_ARG;
+
+	if (!_gn_scheduler_mutex)
+		return GN_RET_ERR;
+
+	xSemaphoreTake(_gn_scheduler_mutex, portMAX_DELAY);
+
+	struct gn_scheduler_job *j = NULL;
+	for (size_t i = 0; i < GN_SCHEDULER_MAX_JOBS && !j; i++)
+		if (!_gn_scheduler_jobs[i].used)
+			j = &_gn_scheduler_jobs[i];
+
+	if (j) {
+		memset(j, 0, sizeof(struct gn_scheduler_job));
+		j->used = true;
+		j->config = *config;
+		strncpy(j->name, config->name ? config->name : "job",
+				GN_SCHEDULER_JOB_NAME_SIZE - 1);
+		j->config.name = j->name;
+		j->heap_index = -1;
+	}
+
+	xSemaphoreGive(_gn_scheduler_mutex);
+
+	if (!j) {
+		ESP_LOGE(TAG, "gn_scheduler_job_create - no free jobs");
+		return GN_RET_ERR;
+	}
+
+	*job = j;
+	return GN_RET_OK;
+
+}
+
+/**
+ * @brief	starts the job with the schedule given. a started job is rescheduled and its
+ * statistics reset
+ *
+ * @return	GN_RET_OK if the job is started
+ * @return	GN_RET_ERR_INVALID_ARG if the job is not valid or the spec cannot be parsed
+ */
+gn_err_t gn_scheduler_job_start(gn_scheduler_job_handle_t job,
+		const char *spec) {
+
+	gn_scheduler_spec_t parsed;
+
+	if (!job || !job->used || !_gn_scheduler_parse(spec, &parsed))
+		return GN_RET_ERR_INVALID_ARG;
+
+	xSemaphoreTake(_gn_scheduler_mutex, portMAX_DELAY);
+
+	if (job->heap_index >= 0)
+		_gn_scheduler_heap_remove(job);
+
+	job->spec = parsed;
+	job->started = true;
+	job->runs = 0;
+	job->late_max_us = 0;
+	job->wall_us = 0;
+
+	//a boot from a timer wakeup can be late on the run that caused it
+	int64_t grace_us = 0;
+	if (_gn_scheduler_timer_wakeup
+			&& esp_timer_get_time() < GN_SCHEDULER_WAKE_GRACE_SEC * 1000000LL)
+		grace_us = GN_SCHEDULER_WAKE_GRACE_SEC * 1000000LL;
+
+	_gn_scheduler_plan(job, true, grace_us);
+	_gn_scheduler_arm();
+
+	ESP_LOGD(TAG, "job %s started '%s', due in %lld ms", job->name, spec,
+			job->heap_index >= 0 ?
+					(long long ) ((job->due_us - esp_timer_get_time()) / 1000) :
+					-1LL);
+
+	xSemaphoreGive(_gn_scheduler_mutex);
+
+	return GN_RET_OK;
+
+}
+
+/**
+ * @brief	stops the job. a run in progress is completed
+ */
+gn_err_t gn_scheduler_job_stop(gn_scheduler_job_handle_t job) {
+
+	if (!job || !job->used)
+		return GN_RET_ERR_INVALID_ARG;
+
+	xSemaphoreTake(_gn_scheduler_mutex, portMAX_DELAY);
+	if (job->heap_index >= 0) {
+		_gn_scheduler_heap_remove(job);
+		_gn_scheduler_arm();
+	}
+	job->started = false;
+	job->waiting_clock = false;
+	xSemaphoreGive(_gn_scheduler_mutex);
+
+	return GN_RET_OK;
+
+}
+
+gn_err_t gn_scheduler_job_delete(gn_scheduler_job_handle_t job) {
+
+	if (gn_scheduler_job_stop(job) != GN_RET_OK)
+		return GN_RET_ERR_INVALID_ARG;
+
+	xSemaphoreTake(_gn_scheduler_mutex, portMAX_DELAY);
+	job->used = false;
+	xSemaphoreGive(_gn_scheduler_mutex);
+
+	return GN_RET_OK;
+
+}
+
+gn_err_t gn_scheduler_job_get_info(gn_scheduler_job_handle_t job,
+		gn_scheduler_job_info_t *info) {
+
+	if (!job || !job->used || !info)
+		return GN_RET_ERR_INVALID_ARG;
+
+	xSemaphoreTake(_gn_scheduler_mutex, portMAX_DELAY);
+	info->started = job->started;
+	info->waiting_clock = job->waiting_clock;
+	info->due_us = job->due_us;
+	info->next = job->started ? job->wall_us / 1000000LL : 0;
+	info->runs = job->runs;
+	info->late_max_us = job->late_max_us;
+	xSemaphoreGive(_gn_scheduler_mutex);
+
+	return GN_RET_OK;
+
+}
+
+/**
+ * @brief	whether the spec can be used to start a job
+ */
+bool gn_scheduler_spec_validate(const char *spec) {
+
+	gn_scheduler_spec_t parsed;
+	return _gn_scheduler_parse(spec, &parsed);
+
+}
+
+/**
+ * @brief	wall time of the first run of the spec after the time given, in the current timezone.
+ * intervals are on the epoch grid, one shot jobs run after their duration
+ *
+ * @return	GN_RET_OK if a run is found
+ * @return	GN_RET_ERR_INVALID_ARG if the spec cannot be parsed or never runs
+ */
+gn_err_t gn_scheduler_next_time(const char *spec, time_t after, time_t *next) {
+
+	gn_scheduler_spec_t parsed;
+
+	if (!next || !_gn_scheduler_parse(spec, &parsed))
+		return GN_RET_ERR_INVALID_ARG;
+
+	switch (parsed.kind) {
+	case GN_SCHEDULER_EVERY:
+		*next = ((after * 1000000LL) / parsed.period_us + 1) * parsed.period_us
+				/ 1000000LL;
+		return GN_RET_OK;
+	case GN_SCHEDULER_AFTER:
+		*next = after + (parsed.period_us + 999999LL) / 1000000LL;
+		return GN_RET_OK;
+	default:
+		return _gn_scheduler_cron_next(&parsed, after, next) ?
+				GN_RET_OK : GN_RET_ERR_INVALID_ARG;
+	}
+
+}
+
+/**
+ * @brief	milliseconds to the earliest queued job
+ *
+ * @return	the time to the job, 0 if already due, -1 without queued jobs
+ */
+int64_t gn_scheduler_next_due_ms() {
+
+	if (!_gn_scheduler_mutex)
+		return -1;
+
+	int64_t due = -1;
+	xSemaphoreTake(_gn_scheduler_mutex, portMAX_DELAY);
+	if (_gn_scheduler_heap_size > 0) {
+		due = (_gn_scheduler_heap[0]->due_us - esp_timer_get_time() + 999)
+				/ 1000;
+		if (due < 0)
+			due = 0;
+	}
+	xSemaphoreGive(_gn_scheduler_mutex);
+
+	return due;
+
+}
+
+/**
+ * @brief	how long a node can sleep to wake up for the earliest job
+ *
+ * @param	max_millisec	the sleep time without jobs, 0 for no limit
+ *
+ * @return	the time to the earliest job, at least 1, capped to max_millisec.
+ * 			0 only without jobs and without limit
+ */
+uint64_t gn_scheduler_sleep_millisec(uint64_t max_millisec) {
+
+	int64_t due = gn_scheduler_next_due_ms();
+	if (due < 0)
+		return max_millisec;
+	//a job already due still needs a timer to wake up for it
+	if (due == 0)
+		due = 1;
+	if (max_millisec == 0 || (uint64_t) due < max_millisec)
+		return due;
+	return max_millisec;
+
+}
+
+/**
+ * @brief	reschedules the jobs after the clock or the timezone is changed.
+ * calendar jobs waiting for the clock are queued
+ */
+void gn_scheduler_time_changed() {
+
+	if (!_gn_scheduler_mutex)
+		return;
+
+	xSemaphoreTake(_gn_scheduler_mutex, portMAX_DELAY);
+
+	for (size_t i = 0; i < GN_SCHEDULER_MAX_JOBS; i++) {
+		struct gn_scheduler_job *job = &_gn_scheduler_jobs[i];
+		if (!job->used || !job->started
+				|| job->spec.kind == GN_SCHEDULER_AFTER)
+			continue;
+		if (job->heap_index >= 0)
+			_gn_scheduler_heap_remove(job);
+		job->wall_us = 0;
+		_gn_scheduler_plan(job, true, 0);
+	}
+
+	_gn_scheduler_arm();
+	xSemaphoreGive(_gn_scheduler_mutex);
+
+}
+
+#ifdef __cplusplus
+}
+#endif //__cplusplus
@@ -0,0 +1,104 @@
+// Copyright 2021 Nicola Muratori (nicola.muratori@gmail.com)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef GN_SCHEDULER_H_
+#define GN_SCHEDULER_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <time.h>
+
+#include "sdkconfig.h"
+#include "gn_commons.h"
+
+/*
+ * wall-clock scheduler: calendar and interval jobs of the node are kept in a min-heap ordered by
+ * due time and served by a single worker task, waiting for the earliest job only. job callbacks
+ * run one at a time on that task, so a long callback delays the jobs due after it.
+ *
+ * a job is started with a schedule spec:
+ *  - "m h dom mon dow" cron fields in local time (TZ, set from gn_config_init_param_t.timezone).
+ *    a field is '*' or a list of values and ranges, with an optional "/step". dow 0 and 7 are sunday,
+ *    when both dom and dow are restricted either of them matches. local times skipped by a DST change
+ *    are skipped
+ *  - "@hourly", "@daily", "@weekly", "@monthly", "@yearly"
+ *  - "@every <duration>" runs on the epoch grid of the duration once the clock is set, so the
+ *    slots are kept across restarts. before the clock is set it runs from the start
+ *  - "@after <duration>" runs once
+ * a duration is a sequence of <number><unit> with unit in ms, s, m, h, d, eg. "1h30m".
+ *
+ * calendar jobs wait for the clock to be set (SNTP), gn_scheduler_time_changed() reschedules them.
+ * after a timer wakeup from deep sleep, the jobs started within GN_SCHEDULER_WAKE_GRACE_SEC from
+ * boot run at once if due in the last GN_SCHEDULER_WAKE_GRACE_SEC, so a wakeup computed with
+ * gn_scheduler_sleep_millisec() is not lost by a late boot
+ */
+
+#define GN_SCHEDULER_MAX_JOBS 32
+#define GN_SCHEDULER_JOB_NAME_SIZE 32
+#define GN_SCHEDULER_SPEC_SIZE 64
+#define GN_SCHEDULER_WAKE_GRACE_SEC 10
+
+typedef struct gn_scheduler_job *gn_scheduler_job_handle_t;
+
+typedef void (*gn_scheduler_cb_t)(void *arg);
+
+typedef struct {
+	gn_scheduler_cb_t callback; /*!< runs on the scheduler task */
+	void *arg;
+	const char *name; /*!< log key, usually the leaf name */
+} gn_scheduler_job_config_t;
+
+typedef struct {
+	bool started;
+	bool waiting_clock; /*!< a calendar job started before the clock is set */
+	int64_t due_us; /*!< esp_timer time of the next run, valid if started and not waiting the clock */
+	time_t next; /*!< wall time of the next run, 0 if the clock is not set */
+	uint32_t runs;
+	int64_t late_max_us; /*!< maximum delay of a run from its due time */
+} gn_scheduler_job_info_t;
+
+gn_err_t gn_scheduler_init();
+
+gn_err_t gn_scheduler_job_create(const gn_scheduler_job_config_t *config,
+		gn_scheduler_job_handle_t *job);
+
+gn_err_t gn_scheduler_job_start(gn_scheduler_job_handle_t job,
+		const char *spec);
+
+gn_err_t gn_scheduler_job_stop(gn_scheduler_job_handle_t job);
+
+gn_err_t gn_scheduler_job_delete(gn_scheduler_job_handle_t job);
+
+gn_err_t gn_scheduler_job_get_info(gn_scheduler_job_handle_t job,
+		gn_scheduler_job_info_t *info);
+
+bool gn_scheduler_spec_validate(const char *spec);
+
+gn_err_t gn_scheduler_next_time(const char *spec, time_t after, time_t *next);
+
+int64_t gn_scheduler_next_due_ms();
+
+uint64_t gn_scheduler_sleep_millisec(uint64_t max_millisec);
+
+void gn_scheduler_time_changed();
+
+#ifdef __cplusplus
+}
+#endif //__cplusplus
+
+#endif /* GN_SCHEDULER_H_ */
@@ -0,0 +1,209 @@
+// Copyright 2021 Nicola Muratori (nicola.muratori@gmail.com)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "gn_string_arena.h"
+#include "gn_mem.h"
+#include "esp_log.h"
+
+#define TAG "gn_string_arena"
+
+/*
+ * append only storage for strings that live as long as the owner (eg. MQTT topics of a node).
+ * strings are packed in chunks that are never moved, so returned pointers stay valid until destroy
+ */
+
+typedef struct gn_string_arena_chunk {
+	struct gn_string_arena_chunk *next;
+	size_t size;
+	size_t used;
+	char data[];
+} gn_string_arena_chunk_t;
+
+typedef struct {
+	gn_string_arena_chunk_t *chunks; /*!< last allocated chunk first */
+	size_t chunk_size;
+	size_t used;
+	size_t footprint;
+} gn_string_arena_t;
+
+typedef gn_string_arena_t *gn_string_arena_handle_intl_t;
+
+static char* _gn_string_arena_alloc(gn_string_arena_handle_intl_t arena,
+		size_t len) {
+
+	gn_string_arena_chunk_t *chunk = arena->chunks;
+
+	if (!chunk || chunk->size - chunk->used < len) {
+
+		size_t size = len > arena->chunk_size ? len : arena->chunk_size;
+		chunk = gn_mem_malloc(GN_MEM_TAG_CORE,
+				sizeof(gn_string_arena_chunk_t) + size);
+		if (!chunk) {
+			ESP_LOGE(TAG, "not enough memory for a chunk of %d bytes",
+					(int ) size);
+			return NULL;
+		}
+
+		chunk->size = size;
+		chunk->used = 0;
+		chunk->next = arena->chunks;
+		arena->chunks = chunk;
+		arena->footprint += sizeof(gn_string_arena_chunk_t) + size;
+
+		ESP_LOGD(TAG, "new chunk of %d bytes, footprint %d bytes", (int ) size,
+				(int ) arena->footprint);
+
+	}
+
+	char *ret = &chunk->data[chunk->used];
+	chunk->used += len;
+	arena->used += len;
+	return ret;
+
+}
+
+/**
+ * @brief	creates an empty arena
+ *
+ * @param	chunk_size	bytes allocated each time the arena grows. 0 for GN_STRING_ARENA_DEFAULT_CHUNK_SIZE
+ *
+ * @return	the arena handle, NULL if no memory is available
+ */
+gn_string_arena_handle_t gn_string_arena_create(size_t chunk_size) {
+
+	gn_string_arena_handle_intl_t arena = gn_mem_malloc(GN_MEM_TAG_CORE,
+			sizeof(gn_string_arena_t));
+	if (!arena)
+		return NULL;
+
+	arena->chunks = NULL;
+	arena->chunk_size =
+			chunk_size > 0 ? chunk_size : GN_STRING_ARENA_DEFAULT_CHUNK_SIZE;
+	arena->used = 0;
+	arena->footprint = sizeof(gn_string_arena_t);
+
+	return arena;
+
+}
+
+/**
+ * @brief	frees the arena and all the strings stored in it
+ */
+void gn_string_arena_destroy(gn_string_arena_handle_t arena) {
+
+	if (!arena)
+		return;
+
+	gn_string_arena_chunk_t *chunk =
+			((gn_string_arena_handle_intl_t) arena)->chunks;
+	while (chunk) {
+		gn_string_arena_chunk_t *next = chunk->next;
+		gn_mem_free(chunk);
+		chunk = next;
+	}
+
+	gn_mem_free(arena);
+
+}
+
+/**
+ * @brief	copies a string into the arena
+ *
+ * @return	the stored string, valid until the arena is destroyed. NULL in case of errors
+ */
+const char* gn_string_arena_add(gn_string_arena_handle_t arena,
+		const char *str) {
+
+	if (!arena || !str)
+		return NULL;
+
+	size_t len = strlen(str) + 1;
+	char *ret = _gn_string_arena_alloc((gn_string_arena_handle_intl_t) arena,
+			len);
+	if (!ret)
+		return NULL;
+
+	memcpy(ret, str, len);
+	return ret;
+
+}
+
+/**
+ * @brief	stores a formatted string into the arena
+ *
+ * @return	the stored string, valid until the arena is destroyed. NULL in case of errors
+ */
+const char* gn_string_arena_printf(gn_string_arena_handle_t arena,
+		const char *format, ...) {
+
+	if (!arena || !format)
+		return NULL;
+
+	va_list args;
+
+	va_start(args, format);
+	int len = vsnprintf(NULL, 0, format, args);
+	va_end(args);
+
+	if (len < 0)
+		return NULL;
+
+	char *ret = _gn_string_arena_alloc((gn_string_arena_handle_intl_t) arena,
+			len + 1);
+	if (!ret)
+		return NULL;
+
+	va_start(args, format);
+	vsnprintf(ret, len + 1, format, args);
+	va_end(args);
+
+	return ret;
+
+}
+
+/**
+ * @brief	bytes taken by the stored strings, terminators included
+ */
+size_t gn_string_arena_used(gn_string_arena_handle_t arena) {
+
+	if (!arena)
+		return 0;
+	return ((gn_string_arena_handle_intl_t) arena)->used;
+
+}
+
+/**
+ * @brief	heap bytes allocated by the arena, bookkeeping included
+ */
+size_t gn_string_arena_footprint(gn_string_arena_handle_t arena) {
+
+	if (!arena)
+		return 0;
+	return ((gn_string_arena_handle_intl_t) arena)->footprint;
+
+}
+
+#ifdef __cplusplus
+}
+#endif //__cplusplus
@@ -0,0 +1,38 @@
+// Copyright 2021 Nicola Muratori (nicola.muratori@gmail.com)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GN_STRING_ARENA_H_
+#define GN_STRING_ARENA_H_
+
+#include <stddef.h>
+
+#define GN_STRING_ARENA_DEFAULT_CHUNK_SIZE 512
+
+typedef void *gn_string_arena_handle_t;
+
+gn_string_arena_handle_t gn_string_arena_create(size_t chunk_size);
+
+void gn_string_arena_destroy(gn_string_arena_handle_t arena);
+
+const char* gn_string_arena_add(gn_string_arena_handle_t arena,
+		const char *str);
+
+const char* gn_string_arena_printf(gn_string_arena_handle_t arena,
+		const char *format, ...) __attribute__ ((format (printf, 2, 3)));
+
+size_t gn_string_arena_used(gn_string_arena_handle_t arena);
+
+size_t gn_string_arena_footprint(gn_string_arena_handle_t arena);
+
+#endif
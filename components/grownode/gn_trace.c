@@ -0,0 +1,180 @@
+// Copyright 2021 Nicola Muratori (nicola.muratori@gmail.com)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_timer.h"
+
+#include "gn_trace.h"
+
+#ifdef CONFIG_GROWNODE_LATENCY_TRACE
+
+static const char *_gn_trace_hop_names[GN_TRACE_HOP_MAX] = { "received",
+		"update", "queued", "dequeued", "applied" };
+
+//receive time of the message being handled by the protocol, per task as handlers run in the MQTT task
+static __thread int64_t _gn_trace_received_us = 0;
+
+static size_t _gn_trace_bucket(uint32_t us) {
+
+	if (us < 8)
+		return us;
+
+	int msb = 31 - __builtin_clz(us);
+	size_t bucket = 8 + (msb - 3) * 4 + ((us >> (msb - 2)) & 3);
+	return bucket < GN_TRACE_BUCKETS ? bucket : GN_TRACE_BUCKETS - 1;
+
+}
+
+static uint32_t _gn_trace_bucket_upper_us(size_t bucket) {
+
+	if (bucket < 8)
+		return bucket;
+
+	int msb = (bucket - 8) / 4 + 3;
+	uint32_t sub = (bucket - 8) % 4;
+	return (1UL << msb) + (sub + 1) * (1UL << (msb - 2)) - 1;
+
+}
+
+/**
+ * @brief	marks the reception of a network message in the calling task
+ *
+ * the next parameter update requested by the same task starts its trace from here
+ */
+void gn_trace_begin() {
+	_gn_trace_received_us = esp_timer_get_time();
+}
+
+/**
+ * @brief	starts the trace of a parameter update request
+ *
+ * only requests following a gn_trace_begin() in the same task are traced, the others are left empty
+ *
+ * @param	trace	the trace to initialize
+ */
+void gn_trace_start(gn_trace_t *trace) {
+
+	memset(trace, 0, sizeof(gn_trace_t));
+
+	if (_gn_trace_received_us == 0)
+		return;
+
+	trace->at[GN_TRACE_HOP_RECEIVED] = _gn_trace_received_us;
+	trace->at[GN_TRACE_HOP_UPDATE] = esp_timer_get_time();
+	_gn_trace_received_us = 0;
+
+}
+
+/**
+ * @brief	stamps the hop, if the trace was started
+ */
+void gn_trace_stamp(gn_trace_t *trace, gn_trace_hop_t hop) {
+
+	if (trace->at[GN_TRACE_HOP_RECEIVED] != 0)
+		trace->at[hop] = esp_timer_get_time();
+
+}
+
+/**
+ * @brief	closes the trace with the applied hop and adds it to the statistics
+ *
+ * @param	stats	statistics of the leaf, allocated on the first trace
+ * @param	trace	the trace to record, emptied afterwards
+ */
+void gn_trace_record(gn_trace_stats_handle_t *stats, gn_trace_t *trace) {
+
+	if (trace->at[GN_TRACE_HOP_RECEIVED] == 0)
+		return;
+
+	if (!*stats) {
+		*stats = calloc(1, sizeof(gn_trace_stats_t));
+		if (!*stats)
+			return;
+	}
+
+	trace->at[GN_TRACE_HOP_APPLIED] = esp_timer_get_time();
+
+	gn_trace_stats_handle_t s = *stats;
+	int64_t prev = trace->at[GN_TRACE_HOP_RECEIVED];
+	for (int hop = GN_TRACE_HOP_UPDATE; hop < GN_TRACE_HOP_MAX; hop++) {
+		//hops not crossed by this leaf are accounted in the next one
+		if (trace->at[hop] == 0)
+			continue;
+		s->hop_us[hop] += trace->at[hop] - prev;
+		prev = trace->at[hop];
+	}
+
+	uint32_t total = trace->at[GN_TRACE_HOP_APPLIED]
+			- trace->at[GN_TRACE_HOP_RECEIVED];
+	s->buckets[_gn_trace_bucket(total)]++;
+	if (total > s->max_us)
+		s->max_us = total;
+	s->count++;
+
+	memset(trace, 0, sizeof(gn_trace_t));
+
+}
+
+/**
+ * @brief	latency below which the given percentage of commands fall
+ *
+ * @return	the upper bound of the histogram bucket, in microseconds. never above the maximum
+ */
+uint32_t gn_trace_percentile(const gn_trace_stats_t *stats, int percentile) {
+
+	if (!stats || stats->count == 0)
+		return 0;
+
+	uint64_t rank = ((uint64_t) stats->count * percentile + 99) / 100;
+	uint64_t seen = 0;
+	for (size_t i = 0; i < GN_TRACE_BUCKETS; i++) {
+		seen += stats->buckets[i];
+		if (seen >= rank) {
+			uint32_t upper = _gn_trace_bucket_upper_us(i);
+			return upper < stats->max_us ? upper : stats->max_us;
+		}
+	}
+	return stats->max_us;
+
+}
+
+/**
+ * @brief	builds count, p50, p99, max and the average time of each hop
+ *
+ * @return	the json object, to be deleted by the caller
+ */
+cJSON* gn_trace_stats_to_json(const gn_trace_stats_t *stats) {
+
+	cJSON *root = cJSON_CreateObject();
+	if (!root)
+		return NULL;
+
+	uint32_t count = stats ? stats->count : 0;
+	cJSON_AddNumberToObject(root, "count", count);
+	cJSON_AddNumberToObject(root, "p50_us", gn_trace_percentile(stats, 50));
+	cJSON_AddNumberToObject(root, "p99_us", gn_trace_percentile(stats, 99));
+	cJSON_AddNumberToObject(root, "max_us", stats ? stats->max_us : 0);
+
+	cJSON *hops = cJSON_AddObjectToObject(root, "hops_avg_us");
+	for (int hop = GN_TRACE_HOP_UPDATE; hops && hop < GN_TRACE_HOP_MAX; hop++)
+		cJSON_AddNumberToObject(hops, _gn_trace_hop_names[hop],
+				count ? (double) stats->hop_us[hop] / count : 0);
+
+	return root;
+
+}
+
+#endif /* CONFIG_GROWNODE_LATENCY_TRACE */
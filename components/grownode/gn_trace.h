@@ -0,0 +1,75 @@
+// Copyright 2021 Nicola Muratori (nicola.muratori@gmail.com)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GN_TRACE_H_
+#define GN_TRACE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "sdkconfig.h"
+
+/*
+ * command latency tracing: a network command is stamped at each hop on its way to the leaf,
+ * and the time to apply it is collected in per leaf histograms.
+ * everything is compiled only with CONFIG_GROWNODE_LATENCY_TRACE
+ */
+
+#ifdef CONFIG_GROWNODE_LATENCY_TRACE
+
+#include "cJSON.h"
+
+typedef enum {
+	GN_TRACE_HOP_RECEIVED = 0, /*!< message received by the protocol handler */
+	GN_TRACE_HOP_UPDATE, /*!< parameter update request built */
+	GN_TRACE_HOP_QUEUED, /*!< event in the leaf queue */
+	GN_TRACE_HOP_DEQUEUED, /*!< event taken by the leaf task */
+	GN_TRACE_HOP_APPLIED, /*!< parameter forced by the leaf, right before driving the actuator */
+	GN_TRACE_HOP_MAX
+} gn_trace_hop_t;
+
+/**
+ * @brief	timestamps of a command, in microseconds since boot. 0 if the hop is not reached
+ */
+typedef struct {
+	int64_t at[GN_TRACE_HOP_MAX];
+} gn_trace_t;
+
+//up to 8 us one bucket per microsecond, then 4 buckets per power of two up to ~4 s
+#define GN_TRACE_BUCKETS (8 + 19 * 4)
+
+typedef struct {
+	uint32_t count;
+	uint32_t max_us;
+	uint64_t hop_us[GN_TRACE_HOP_MAX]; /*!< total time spent reaching each hop from the previous one */
+	uint32_t buckets[GN_TRACE_BUCKETS];
+} gn_trace_stats_t;
+
+typedef gn_trace_stats_t *gn_trace_stats_handle_t;
+
+void gn_trace_begin();
+
+void gn_trace_start(gn_trace_t *trace);
+
+void gn_trace_stamp(gn_trace_t *trace, gn_trace_hop_t hop);
+
+void gn_trace_record(gn_trace_stats_handle_t *stats, gn_trace_t *trace);
+
+uint32_t gn_trace_percentile(const gn_trace_stats_t *stats, int percentile);
+
+cJSON* gn_trace_stats_to_json(const gn_trace_stats_t *stats);
+
+#endif /* CONFIG_GROWNODE_LATENCY_TRACE */
+
+#endif /* GN_TRACE_H_ */
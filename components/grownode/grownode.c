@@ -76,6 +76,11 @@ extern "C" {
 #include "gn_network.h"
 #include "gn_mqtt_protocol.h"
 #include "gn_display.h"
+#include "gn_sampler.h"
+#include "gn_scheduler.h"
+#include "gn_i2c.h"
+#include "gn_display_binding.h"
+#include "gn_boot.h"
 
 #define TAG "grownode"
 #define TAG_EVENT "gn_event"
@@ -250,6 +255,33 @@ void _gn_keepalive_stop(gn_config_handle_intl_t conf) {
 	ESP_LOGI(TAG, "keepalive task paused");
 }
 
+#ifdef CONFIG_GROWNODE_RUNTIME_STATS
+static void _gn_stats_callback(void *arg) {
+	//not waiting on the timer task: a statistics message can be skipped. arg, the config, is not needed
+	esp_event_post_to(gn_event_loop, GN_BASE_EVENT,
+			GN_SRV_STATS_TRIGGERED_EVENT, NULL, 0, 0);
+}
+
+void _gn_stats_start(gn_config_handle_intl_t conf) {
+
+	if (!conf->stats_timer_handler)
+		return;
+	if (!esp_timer_is_active(conf->stats_timer_handler))
+		esp_timer_start_periodic(conf->stats_timer_handler,
+				CONFIG_GROWNODE_RUNTIME_STATS_INTERVAL_SEC * 1000000LL);
+	ESP_LOGI(TAG, "runtime stats started");
+}
+
+void _gn_stats_stop(gn_config_handle_intl_t conf) {
+
+	if (!conf->stats_timer_handler)
+		return;
+	if (esp_timer_is_active(conf->stats_timer_handler))
+		esp_timer_stop(conf->stats_timer_handler);
+	ESP_LOGI(TAG, "runtime stats paused");
+}
+#endif
+
 gn_leaf_handle_intl_t _gn_leaf_get_by_name(gn_config_handle_intl_t conf,
 		char *leaf_name) {
 
@@ -295,12 +327,27 @@ gn_err_t _gn_send_event_to_leaf(gn_leaf_handle_intl_t leaf_config,
 	//make sure data will end with terminating char
 	evt->data[evt->data_len] = '\0';
 
+#ifdef CONFIG_GROWNODE_LATENCY_TRACE
+	if (evt->id == GN_LEAF_PARAM_CHANGE_REQUEST_EVENT)
+		gn_trace_stamp(&evt->trace, GN_TRACE_HOP_QUEUED);
+#endif
+
 	if (xQueueSend(leaf_config->event_queue, evt, pdMS_TO_TICKS(1000)) != pdTRUE) {
+#ifdef CONFIG_GROWNODE_RUNTIME_STATS
+		leaf_config->events_dropped++;
+#endif
 		ESP_LOGE(TAG,
 				"xQueueSend failed - not possible to send message to leaf %s",
 				leaf_config->name);
 		return GN_RET_ERR_EVENT_NOT_SENT;
 	}
+
+#ifdef CONFIG_GROWNODE_RUNTIME_STATS
+	UBaseType_t waiting = uxQueueMessagesWaiting(leaf_config->event_queue);
+	if (waiting > leaf_config->queue_peak)
+		leaf_config->queue_peak = waiting;
+#endif
+
 	ESP_LOGD(TAG_EVENT, "_gn_send_event_to_leaf OK");
 	return GN_RET_OK;
 }
@@ -342,20 +389,30 @@ void _gn_evt_handler(void *handler_data, esp_event_base_t base, int32_t id,
 		if (!conf)
 			break;
 
-		//from unknown status: reboot - to keep consistency
-		if (conf->status != GN_NODE_STATUS_STARTED) {
+		//from unknown status: reboot - to keep consistency.
+		//gn_node_start sets the started status only after the connection, and
+		//the event loop task is not guaranteed to run after it
+		if (conf->status != GN_NODE_STATUS_STARTED
+				&& conf->status != GN_NODE_STATUS_READY_TO_START) {
 			gn_reboot();
 			break;
 		}
 
 		//start keepalive service
 		_gn_keepalive_start(conf);
+#ifdef CONFIG_GROWNODE_RUNTIME_STATS
+		_gn_stats_start(conf);
+#endif
 
 		break;
 	case GN_SRV_DISCONNECTED_EVENT:
 		//stop keepalive service
-		if (conf->status == GN_NODE_STATUS_STARTED)
+		if (conf->status == GN_NODE_STATUS_STARTED) {
 			_gn_keepalive_stop(conf);
+#ifdef CONFIG_GROWNODE_RUNTIME_STATS
+			_gn_stats_stop(conf);
+#endif
+		}
 		break;
 
 		/*
@@ -388,6 +445,18 @@ void _gn_evt_handler(void *handler_data, esp_event_base_t base, int32_t id,
 		}
 		break;
 
+#ifdef CONFIG_GROWNODE_RUNTIME_STATS
+	case GN_SRV_STATS_TRIGGERED_EVENT:
+
+		if (conf->status != GN_NODE_STATUS_STARTED)
+			break;
+
+		if (gn_mqtt_send_stats(conf->node_handle) != GN_RET_OK) {
+			ESP_LOGE(TAG, "Error in sending runtime stats message");
+		}
+		break;
+#endif
+
 	case GN_LEAF_PARAM_CHANGE_REQUEST_EVENT: {
 
 		if (conf->status != GN_NODE_STATUS_STARTED)
@@ -459,6 +528,18 @@ esp_err_t _gn_init_keepalive_timer(gn_config_handle_intl_t conf) {
 			&conf->keepalive_timer_handler);
 }
 
+#ifdef CONFIG_GROWNODE_RUNTIME_STATS
+esp_err_t _gn_init_stats_timer(gn_config_handle_intl_t conf) {
+
+	ESP_LOGD(TAG, "_gn_init_stats_timer");
+
+	const esp_timer_create_args_t stats_timer_args = { .callback =
+			&_gn_stats_callback, .arg = conf, .name = "stats_timer" };
+
+	return esp_timer_create(&stats_timer_args, &conf->stats_timer_handler);
+}
+#endif
+
 /**
  * @brief	initialize config
  *
@@ -468,9 +549,13 @@ gn_config_handle_intl_t _gn_config_create(gn_config_init_param_t *config_init) {
 
 	ESP_LOGD(TAG, "_gn_config_create");
 
-	gn_config_handle_intl_t _conf = (gn_config_handle_intl_t) malloc(
-			sizeof(struct gn_config_t));
+	gn_config_handle_intl_t _conf = (gn_config_handle_intl_t) gn_mem_malloc(
+			GN_MEM_TAG_CORE, sizeof(struct gn_config_t));
 	_conf->status = GN_NODE_STATUS_INITIALIZING;
+#ifdef CONFIG_GROWNODE_RUNTIME_STATS
+	_conf->stats_timer_handler = NULL;
+	_conf->stats_runtime_last = 0;
+#endif
 
 	_conf->config_init_params = config_init;
 
@@ -599,11 +684,13 @@ esp_err_t _gn_init_event_loop(gn_config_handle_intl_t config) {
 
 gn_node_handle_intl_t _gn_node_config_create() {
 
-	gn_node_handle_intl_t _conf = (gn_node_handle_intl_t) malloc(
-			sizeof(struct gn_node_t));
+	gn_node_handle_intl_t _conf = (gn_node_handle_intl_t) gn_mem_malloc(
+			GN_MEM_TAG_CORE, sizeof(struct gn_node_t));
 	_conf->config = NULL;
 	//_conf->event_loop = NULL;
 	strcpy(_conf->name, "");
+	_conf->topics = NULL;
+	_conf->topic_index = NULL;
 	return _conf;
 
 }
@@ -688,9 +775,23 @@ gn_err_t gn_leaf_receive_event(gn_leaf_parameter_event_handle_t evt, gn_leaf_han
 	if (!leaf || !evt) return GN_RET_ERR;
 
 	if (xQueueReceive(gn_leaf_get_event_queue(leaf), evt,
-	portMAX_DELAY) == pdTRUE)
-		return GN_RET_OK;
-	return GN_RET_TIMEOUT;
+	portMAX_DELAY) != pdTRUE)
+		return GN_RET_TIMEOUT;
+
+#ifdef CONFIG_GROWNODE_LATENCY_TRACE
+	//kept until the leaf forces the requested parameter
+	if (evt->id == GN_LEAF_PARAM_CHANGE_REQUEST_EVENT
+			&& evt->trace.at[GN_TRACE_HOP_RECEIVED] != 0) {
+		gn_leaf_handle_intl_t _leaf = (gn_leaf_handle_intl_t) leaf;
+		gn_trace_stamp(&evt->trace, GN_TRACE_HOP_DEQUEUED);
+		_leaf->trace = evt->trace;
+		strncpy(_leaf->trace_param, evt->param_name,
+				GN_LEAF_PARAM_NAME_SIZE - 1);
+		_leaf->trace_param[GN_LEAF_PARAM_NAME_SIZE - 1] = '\0';
+	}
+#endif
+
+	return GN_RET_OK;
 
 }
 
@@ -737,6 +838,19 @@ gn_node_handle_t gn_node_create(gn_config_handle_t config, const char *name) {
 	gn_leaves_list leaves = { .size = GN_NODE_LEAVES_MAX_SIZE, .last = 0 };
 
 	n_c->leaves = leaves;
+
+	//storage for MQTT topics, built once per leaf and parameter
+	n_c->topics = gn_string_arena_create(0);
+	n_c->topic_index = gn_leaf_context_create(GN_NODE_TOPIC_INDEX_SIZE);
+	if (n_c->topics == NULL || n_c->topic_index == NULL) {
+		ESP_LOGE(TAG, "gn_create_node failed. cannot create topic storage");
+		gn_string_arena_destroy(n_c->topics);
+		if (n_c->topic_index)
+			gn_leaf_context_destroy(n_c->topic_index);
+		gn_mem_free(n_c);
+		return NULL;
+	}
+
 	((gn_config_handle_intl_t) config)->node_handle = n_c;
 
 	return n_c;
@@ -757,6 +871,202 @@ size_t gn_node_get_size(gn_node_handle_t node_config) {
 	return ((gn_node_handle_intl_t) node_config)->leaves.last;
 }
 
+#ifdef CONFIG_GROWNODE_LATENCY_TRACE
+
+/**
+ * @brief		command latency of the node leaves
+ *
+ * @param		node	the node to be inspected
+ *
+ * @return		a json object with the latency statistics of each leaf that received commands, to be deleted by the caller
+ */
+cJSON* gn_node_latency_to_json(gn_node_handle_t node) {
+
+	if (!node)
+		return NULL;
+
+	gn_node_handle_intl_t _node = (gn_node_handle_intl_t) node;
+
+	cJSON *root = cJSON_CreateObject();
+	if (!root)
+		return NULL;
+
+	for (int i = 0; i < _node->leaves.last; i++) {
+		gn_leaf_handle_intl_t leaf = _node->leaves.at[i];
+		if (!leaf->trace_stats)
+			continue;
+		cJSON_AddItemToObject(root, leaf->name,
+				gn_trace_stats_to_json(leaf->trace_stats));
+	}
+
+	return root;
+
+}
+
+/**
+ * @brief		logs the command latency of the node leaves
+ *
+ * @param		node	the node to be inspected
+ */
+void gn_node_latency_dump(gn_node_handle_t node) {
+
+	if (!node)
+		return;
+
+	gn_node_handle_intl_t _node = (gn_node_handle_intl_t) node;
+
+	for (int i = 0; i < _node->leaves.last; i++) {
+		gn_leaf_handle_intl_t leaf = _node->leaves.at[i];
+		gn_trace_stats_handle_t s = leaf->trace_stats;
+		if (!s || s->count == 0)
+			continue;
+		ESP_LOGI(TAG,
+				"latency %s: %u commands, p50 %u us, p99 %u us, max %u us - avg update %.1f, queued %.1f, dequeued %.1f, applied %.1f us",
+				leaf->name, s->count, gn_trace_percentile(s, 50),
+				gn_trace_percentile(s, 99), s->max_us,
+				(double) s->hop_us[GN_TRACE_HOP_UPDATE] / s->count,
+				(double) s->hop_us[GN_TRACE_HOP_QUEUED] / s->count,
+				(double) s->hop_us[GN_TRACE_HOP_DEQUEUED] / s->count,
+				(double) s->hop_us[GN_TRACE_HOP_APPLIED] / s->count);
+	}
+
+}
+
+/**
+ * @brief		clears the command latency statistics of the node leaves
+ *
+ * @param		node	the node to be reset
+ */
+void gn_node_latency_reset(gn_node_handle_t node) {
+
+	if (!node)
+		return;
+
+	gn_node_handle_intl_t _node = (gn_node_handle_intl_t) node;
+
+	for (int i = 0; i < _node->leaves.last; i++) {
+		if (_node->leaves.at[i]->trace_stats)
+			memset(_node->leaves.at[i]->trace_stats, 0,
+					sizeof(gn_trace_stats_t));
+	}
+
+}
+
+#endif /* CONFIG_GROWNODE_LATENCY_TRACE */
+
+#ifdef CONFIG_GROWNODE_RUNTIME_STATS
+
+#if defined(CONFIG_FREERTOS_USE_TRACE_FACILITY) && defined(CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS)
+#define _GN_STATS_CPU
+#endif
+
+/**
+ * @brief		runtime statistics of the node: start time, heap, MQTT outbox and, for each leaf, task stack, CPU and event queue
+ *
+ * CPU usage (percentage of one core) and queue peaks refer to the time since the previous call
+ *
+ * @param		node	the node to be inspected
+ *
+ * @return		a json object with the statistics, to be deleted by the caller
+ */
+cJSON* gn_node_stats_to_json(gn_node_handle_t node) {
+
+	if (!node)
+		return NULL;
+
+	gn_node_handle_intl_t _node = (gn_node_handle_intl_t) node;
+
+	cJSON *root = cJSON_CreateObject();
+	if (!root)
+		return NULL;
+
+	cJSON_AddNumberToObject(root, "uptime", esp_timer_get_time() / 1000000);
+	cJSON_AddNumberToObject(root, "ready_ms", _node->ready_ms);
+	cJSON_AddNumberToObject(root, "heap_free",
+			heap_caps_get_free_size(MALLOC_CAP_8BIT));
+	cJSON_AddNumberToObject(root, "heap_largest",
+			heap_caps_get_largest_free_block(MALLOC_CAP_8BIT));
+	cJSON_AddNumberToObject(root, "heap_min",
+			heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT));
+	cJSON_AddNumberToObject(root, "mqtt_outbox",
+			_node->config->mqtt_client ?
+					esp_mqtt_client_get_outbox_size(
+							_node->config->mqtt_client) :
+					0);
+	cJSON_AddNumberToObject(root, "tasks", uxTaskGetNumberOfTasks());
+	//called from the event loop task
+	cJSON_AddNumberToObject(root, "loop_stack_free",
+			uxTaskGetStackHighWaterMark(NULL));
+
+#ifdef _GN_STATS_CPU
+	uint32_t runtime = portGET_RUN_TIME_COUNTER_VALUE();
+	uint32_t elapsed = runtime - _node->config->stats_runtime_last;
+	_node->config->stats_runtime_last = runtime;
+#endif
+
+	cJSON *leaves = cJSON_CreateObject();
+	if (!leaves)
+		return root;
+	cJSON_AddItemToObject(root, "leaves", leaves);
+
+	for (int i = 0; i < _node->leaves.last; i++) {
+
+		gn_leaf_handle_intl_t leaf = _node->leaves.at[i];
+
+		cJSON *stats = cJSON_CreateObject();
+		if (!stats)
+			break;
+		cJSON_AddItemToObject(leaves, leaf->name, stats);
+
+		if (leaf->task_handle) {
+			cJSON_AddNumberToObject(stats, "stack_size", leaf->task_size);
+			cJSON_AddNumberToObject(stats, "stack_free",
+					uxTaskGetStackHighWaterMark(leaf->task_handle));
+#ifdef _GN_STATS_CPU
+			TaskStatus_t status;
+			vTaskGetInfo(leaf->task_handle, &status, pdFALSE, eInvalid);
+			cJSON_AddNumberToObject(stats, "cpu",
+					elapsed ?
+							100.0 * (status.ulRunTimeCounter - leaf->runtime_last)
+									/ elapsed :
+							0);
+			leaf->runtime_last = status.ulRunTimeCounter;
+#endif
+		}
+
+		if (leaf->event_queue) {
+			UBaseType_t waiting = uxQueueMessagesWaiting(leaf->event_queue);
+			cJSON_AddNumberToObject(stats, "queue_size",
+					GN_NODE_LEAF_QUEUE_SIZE);
+			cJSON_AddNumberToObject(stats, "queue", waiting);
+			cJSON_AddNumberToObject(stats, "queue_peak",
+					leaf->queue_peak > waiting ? leaf->queue_peak : waiting);
+			cJSON_AddNumberToObject(stats, "dropped", leaf->events_dropped);
+			leaf->queue_peak = waiting;
+		}
+
+	}
+
+#ifdef CONFIG_GROWNODE_MEM_ACCOUNTING
+	cJSON *mem = gn_mem_stats_to_json();
+	if (mem)
+		cJSON_AddItemToObject(root, "mem", mem);
+#endif
+
+	cJSON *sampler = gn_sampler_stats_to_json();
+	if (sampler)
+		cJSON_AddItemToObject(root, "sampler", sampler);
+
+	cJSON *i2c = gn_i2c_stats_to_json();
+	if (i2c)
+		cJSON_AddItemToObject(root, "i2c", i2c);
+
+	return root;
+
+}
+
+#endif /* CONFIG_GROWNODE_RUNTIME_STATS */
+
 /**
  * @brief		removes the node from the config
  *
@@ -767,7 +1077,9 @@ size_t gn_node_get_size(gn_node_handle_t node_config) {
 gn_err_t gn_node_destroy(gn_node_handle_t node) {
 
 	//free(((gn_node_handle_intl_t) node)->leaves->at); //TODO implement free of leaves
-	free((gn_node_handle_intl_t) node);
+	gn_string_arena_destroy(((gn_node_handle_intl_t) node)->topics);
+	gn_leaf_context_destroy(((gn_node_handle_intl_t) node)->topic_index);
+	gn_mem_free((gn_node_handle_intl_t) node);
 
 	return GN_RET_OK;
 }
@@ -790,15 +1102,23 @@ gn_err_t gn_node_start(gn_node_handle_t node) {
 	ESP_LOGD(TAG, "gn_start_node: %s, leaves: %d", _node->name,
 			_node->leaves.last);
 
+	int64_t start_time = esp_timer_get_time();
+	gn_boot_phase_begin(GN_BOOT_PHASE_NODE_START);
 
+	//heartbeat to check network comm and send periodical system watchdog to the network
+	//created before connecting, as GN_SRV_CONNECTED_EVENT starts it
+	ESP_GOTO_ON_ERROR(_gn_init_keepalive_timer(_node->config), err_srv, TAG,
+			"error on timer init: %s", esp_err_to_name(ret));
+#ifdef CONFIG_GROWNODE_RUNTIME_STATS
+	ESP_GOTO_ON_ERROR(_gn_init_stats_timer(_node->config), err_srv, TAG,
+			"error on stats timer init: %s", esp_err_to_name(ret));
+#endif
 
 	//init mqtt system
+	gn_boot_phase_begin(GN_BOOT_PHASE_MQTT_START);
 	ESP_GOTO_ON_ERROR(gn_mqtt_start(_node->config), err_srv, TAG,
 			"error on server init: %s", esp_err_to_name(ret));
-
-	//heartbeat to check network comm and send periodical system watchdog to the network
-	ESP_GOTO_ON_ERROR(_gn_init_keepalive_timer(_node->config), err_srv, TAG,
-			"error on timer init: %s", esp_err_to_name(ret));
+	gn_boot_phase_end(GN_BOOT_PHASE_MQTT_START);
 
 	_node->config->status = GN_NODE_STATUS_STARTED;
 
@@ -814,7 +1134,12 @@ gn_err_t gn_node_start(gn_node_handle_t node) {
 	//if (gn_mqtt_send_node_config(node) != ESP_OK)
 	//return ESP_FAIL;
 
+	ESP_LOGI(TAG, "topics storage: %d bytes used, %d bytes allocated",
+			(int ) gn_string_arena_used(_node->topics),
+			(int ) gn_string_arena_footprint(_node->topics));
+
 	//run leaves
+	gn_boot_phase_begin(GN_BOOT_PHASE_LEAF_START);
 	for (int i = 0; i < _node->leaves.last; i++) {
 		//ESP_LOGD(TAG, "starting leaf: %d", i);
 		if (_gn_leaf_start(_node->leaves.at[i]) != GN_RET_OK) {
@@ -824,6 +1149,21 @@ gn_err_t gn_node_start(gn_node_handle_t node) {
 			return GN_RET_ERR_NODE_NOT_STARTED;
 		}
 	}
+	gn_boot_phase_end(GN_BOOT_PHASE_LEAF_START);
+	gn_boot_phase_end(GN_BOOT_PHASE_NODE_START);
+
+	_node->ready_ms = (esp_timer_get_time() - start_time) / 1000;
+	ESP_LOGI(TAG, "node %s ready in %d ms (server connection and subscriptions)",
+			_node->name, (int ) _node->ready_ms);
+
+#ifdef CONFIG_GROWNODE_BOOT_PROFILE
+	//one report per boot, the node is connected by now
+	if (!gn_boot_is_complete()) {
+		gn_boot_complete();
+		if (gn_mqtt_send_boot_report(node) != GN_RET_OK)
+			ESP_LOGW(TAG, "failed to publish the boot report");
+	}
+#endif
 
 	//if first boot, send parameter status
 	if (wakeup_reason == GN_SLEEP_MODE_NONE)
@@ -958,9 +1298,9 @@ void _gn_wait_for_blocked_leaves(gn_node_handle_intl_t _node) {
  * @param 		node 			the node to sleep
  * @param		delay_msec		the delay to wait before sleeping
  * @param 		sleep_mode	the type of sleep
- * @param		millisec	for how long
+ * @param		millisec	for how long at most, the node wakes up earlier for the first scheduled job. 0 to sleep until that job
  *
- * @return		GN_RET_ERR_INVALID_ARG in case of node null
+ * @return		GN_RET_ERR_INVALID_ARG in case of node null, or millisec 0 without scheduled jobs
  * @return		GN_RET_OK if sleep cycle is completed successfully (only in light sleep, otherwise board restarts)
  */
 gn_err_t gn_node_sleep(gn_node_handle_t node, gn_sleep_mode_t sleep_mode,
@@ -969,6 +1309,12 @@ gn_err_t gn_node_sleep(gn_node_handle_t node, gn_sleep_mode_t sleep_mode,
 	if (!node)
 		return GN_RET_ERR_INVALID_ARG;
 
+	//a zero timer wakes up the board at once: a deep sleep would loop on reboots
+	if (millisec == 0 && gn_scheduler_next_due_ms() < 0) {
+		ESP_LOGE(TAG, "no sleep time and no scheduled job to wake up for");
+		return GN_RET_ERR_INVALID_ARG;
+	}
+
 	gn_node_handle_intl_t _node = (gn_node_handle_intl_t) node;
 
 	if (sleep_mode == GN_SLEEP_MODE_DEEP) {
@@ -998,12 +1344,22 @@ gn_err_t gn_node_sleep(gn_node_handle_t node, gn_sleep_mode_t sleep_mode,
 		//stop wifi
 		gn_wifi_stop(_node->config);
 
-		ESP_LOGI(TAG, "Entering deep sleep for %"PRIu64" millisec", millisec);
+		//wakes up for the earliest scheduled job
+		millisec = gn_scheduler_sleep_millisec(millisec);
+
+		//the jobs were stopped meanwhile, nothing to wake up for
+		if (millisec == 0) {
+			ESP_LOGW(TAG, "no scheduled job left, deep sleep skipped");
+		} else {
+
+			ESP_LOGI(TAG, "Entering deep sleep for %"PRIu64" millisec",
+					millisec);
 
-		wakeup_reason = GN_SLEEP_MODE_DEEP;
+			wakeup_reason = GN_SLEEP_MODE_DEEP;
 
-		//_gn_wait_for_blocked_leaves(_node);
-		esp_deep_sleep(millisec * 1000LL);
+			//_gn_wait_for_blocked_leaves(_node);
+			esp_deep_sleep(millisec * 1000LL);
+		}
 
 		//start wifi
 		gn_wifi_start(_node->config);
@@ -1040,13 +1396,23 @@ gn_err_t gn_node_sleep(gn_node_handle_t node, gn_sleep_mode_t sleep_mode,
 		//stop wifi
 		gn_wifi_stop(_node->config);
 
-		ESP_LOGI(TAG, "Entering light sleep for %"PRIu64" millisec", millisec);
+		//wakes up for the earliest scheduled job
+		millisec = gn_scheduler_sleep_millisec(millisec);
+
+		//the jobs were stopped meanwhile, nothing to wake up for
+		if (millisec == 0) {
+			ESP_LOGW(TAG, "no scheduled job left, light sleep skipped");
+		} else {
 
-		wakeup_reason = GN_SLEEP_MODE_LIGHT;
+			ESP_LOGI(TAG, "Entering light sleep for %"PRIu64" millisec",
+					millisec);
 
-		_gn_wait_for_blocked_leaves(_node);
-		esp_sleep_enable_timer_wakeup(millisec * 1000LL);
-		esp_light_sleep_start();
+			wakeup_reason = GN_SLEEP_MODE_LIGHT;
+
+			_gn_wait_for_blocked_leaves(_node);
+			esp_sleep_enable_timer_wakeup(millisec * 1000LL);
+			esp_light_sleep_start();
+		}
 
 		//start wifi
 		gn_wifi_start(_node->config);
@@ -1063,13 +1429,29 @@ gn_err_t gn_node_sleep(gn_node_handle_t node, gn_sleep_mode_t sleep_mode,
 
 gn_leaf_handle_intl_t _gn_leaf_config_create() {
 
-	gn_leaf_handle_intl_t _conf = (gn_leaf_handle_intl_t) malloc(
-			sizeof(struct gn_leaf_config_t));
+	gn_leaf_handle_intl_t _conf = (gn_leaf_handle_intl_t) gn_mem_malloc(
+			GN_MEM_TAG_CORE, sizeof(struct gn_leaf_config_t));
+	if (!_conf)
+		return NULL;
 	//_conf->callback = NULL;
 	strcpy(_conf->name, "");
 	_conf->node = NULL;
 	_conf->leaf_descriptor = NULL;
 	_conf->params = NULL;
+	_conf->topic_cmd = NULL;
+	_conf->topic_sts = NULL;
+#ifdef CONFIG_GROWNODE_LATENCY_TRACE
+	memset(&_conf->trace, 0, sizeof(_conf->trace));
+	_conf->trace_stats = NULL;
+#endif
+#ifdef CONFIG_GROWNODE_MEM_ACCOUNTING
+	_conf->mem_tag = GN_MEM_TAG_LEAF;
+#endif
+#ifdef CONFIG_GROWNODE_RUNTIME_STATS
+	_conf->queue_peak = 0;
+	_conf->events_dropped = 0;
+	_conf->runtime_last = 0;
+#endif
 	return _conf;
 
 }
@@ -1094,25 +1476,9 @@ gn_err_t gn_node_get_name(gn_node_handle_t node_config, char *name) {
 
 }
 
-/**
- *	@brief		creates the leaf
- *
- *	initializes the leaf structure. the returned handle is not active and need to be started by the gn_node_start() function
- *  @see gn_node_start()
- *	@param		node_config	the configuration handle to create the leaf to
- *	@param		name		the name of the leaf to be created
- *	@param		callback	the callback to be called to configure the leaf
- *	@param		task		callback function of the leaf task
- *	@param		task_size	the size of the task to be memory allocated (see freertos documentation)
- *	@param		priority	the task priority (see freertos documentation)
- *
- *	@return		an handle to the leaf config
- *	@return		NULL if the handle cannot be created
- *
- */
-gn_leaf_handle_t gn_leaf_create(gn_node_handle_t node_config, const char *name,
-		gn_leaf_config_callback callback, size_t task_size,
-		UBaseType_t priority) { //, gn_leaf_display_task_t display_task) {
+static gn_leaf_handle_t _gn_leaf_create(gn_node_handle_t node_config,
+		const char *name, gn_leaf_config_callback callback, size_t task_size,
+		UBaseType_t priority) {
 
 	gn_node_handle_intl_t node_cfg = (gn_node_handle_intl_t) node_config;
 
@@ -1121,41 +1487,93 @@ gn_leaf_handle_t gn_leaf_create(gn_node_handle_t node_config, const char *name,
 		return NULL;
 	}
 
-	gn_leaf_handle_intl_t l_c = _gn_leaf_config_create();
 	gn_node_handle_intl_t n_c = node_cfg;
 
+	//TODO add leaf to node. implement dynamic array
+	if (n_c->leaves.last >= n_c->leaves.size) {
+		ESP_LOGE(TAG,
+				"gn_leaf_create failed. not possible to add more than %d leaves to a node",
+				n_c->leaves.size);
+		return NULL;
+	}
+
+	gn_leaf_handle_intl_t l_c = _gn_leaf_config_create();
+	if (l_c == NULL) {
+		ESP_LOGE(TAG, "gn_leaf_create failed. not enough memory");
+		return NULL;
+	}
+
 	strncpy(l_c->name, name, GN_LEAF_NAME_SIZE - 1);
+	l_c->name[GN_LEAF_NAME_SIZE - 1] = '\0';
 	l_c->node = node_cfg;
+#ifdef CONFIG_GROWNODE_MEM_ACCOUNTING
+	char mem_tag[GN_MEM_TAG_NAME_SIZE];
+	snprintf(mem_tag, sizeof(mem_tag), "leaf:%s", l_c->name);
+	l_c->mem_tag = gn_mem_tag_register(mem_tag);
+#endif
 	//l_c->task_cb = task;
 	l_c->task_size = task_size;
 	l_c->priority = priority;
-	l_c->leaf_context = gn_leaf_context_create();
+	l_c->leaf_context = gn_leaf_context_create(GN_LEAF_CONTEXT_SIZE);
 	l_c->display_container = NULL;
 	//l_c->display_task = display_task;
 	l_c->event_queue = xQueueCreate(GN_NODE_LEAF_QUEUE_SIZE,
 			sizeof(gn_leaf_parameter_event_t));
-	if (l_c->event_queue == NULL) {
-		return NULL;
+	if (l_c->leaf_context == NULL || l_c->event_queue == NULL) {
+		ESP_LOGE(TAG, "gn_leaf_create failed. not enough memory");
+		goto fail;
 	}
 	//l_c->event_loop = gn_event_loop;
 
+	//topics already stored in the node arena are not reclaimed
+	if (gn_mqtt_build_leaf_topics(l_c) != GN_RET_OK) {
+		ESP_LOGE(TAG, "gn_leaf_create failed. cannot build topics");
+		goto fail;
+	}
+
 	//configures leaf and get descriptor
 	l_c->leaf_descriptor = callback(l_c);
 
-	//TODO add leaf to node. implement dynamic array
-	if (n_c->leaves.last >= n_c->leaves.size - 1) {
-		ESP_LOGE(TAG,
-				"gn_leaf_create failed. not possible to add more than %d leaves to a node",
-				n_c->leaves.size);
-		return NULL;
-	}
-
 	n_c->leaves.at[n_c->leaves.last] = l_c;
 	n_c->leaves.last++;
 
 	ESP_LOGD(TAG, "gn_create_leaf success");
 	return l_c;
 
+	fail: if (l_c->event_queue)
+		vQueueDelete(l_c->event_queue);
+	gn_leaf_context_destroy(l_c->leaf_context);
+	gn_mem_free(l_c);
+	return NULL;
+
+}
+
+/**
+ *	@brief		creates the leaf
+ *
+ *	initializes the leaf structure. the returned handle is not active and need to be started by the gn_node_start() function
+ *  @see gn_node_start()
+ *	@param		node_config	the configuration handle to create the leaf to
+ *	@param		name		the name of the leaf to be created
+ *	@param		callback	the callback to be called to configure the leaf
+ *	@param		task		callback function of the leaf task
+ *	@param		task_size	the size of the task to be memory allocated (see freertos documentation)
+ *	@param		priority	the task priority (see freertos documentation)
+ *
+ *	@return		an handle to the leaf config
+ *	@return		NULL if the handle cannot be created
+ *
+ */
+gn_leaf_handle_t gn_leaf_create(gn_node_handle_t node_config, const char *name,
+		gn_leaf_config_callback callback, size_t task_size,
+		UBaseType_t priority) { //, gn_leaf_display_task_t display_task) {
+
+	gn_boot_phase_begin(GN_BOOT_PHASE_LEAF_CREATE);
+	gn_leaf_handle_t leaf = _gn_leaf_create(node_config, name, callback,
+			task_size, priority);
+	gn_boot_phase_end(GN_BOOT_PHASE_LEAF_CREATE);
+	return leaf;
+
 }
 
 /**
@@ -1165,13 +1583,24 @@ gn_leaf_descriptor_handle_t gn_leaf_get_descriptor(gn_leaf_handle_t leaf_config)
 	return ((gn_leaf_handle_intl_t) leaf_config)->leaf_descriptor;
 }
 
+/**
+ * returns the tag to account the heap allocations of the leaf with gn_mem_*
+ */
+gn_mem_tag_t gn_leaf_get_mem_tag(gn_leaf_handle_t leaf_config) {
+#ifdef CONFIG_GROWNODE_MEM_ACCOUNTING
+	if (leaf_config)
+		return ((gn_leaf_handle_intl_t) leaf_config)->mem_tag;
+#endif
+	return GN_MEM_TAG_LEAF;
+}
+
 gn_err_t _gn_leaf_destroy(gn_leaf_handle_t leaf_config) {
 
 	gn_leaf_handle_intl_t _leaf_config = ((gn_leaf_handle_intl_t) leaf_config);
 	gn_leaf_context_destroy(_leaf_config->leaf_context);
 	vQueueDelete(_leaf_config->event_queue);
 	;
-	free(leaf_config);
+	gn_mem_free(leaf_config);
 	return GN_RET_OK;
 
 }
@@ -1289,8 +1718,8 @@ void _gn_leaf_evt_handler(void *handler_args, esp_event_base_t base, int32_t id,
 	} else {
 
 		gn_leaf_parameter_event_handle_t evt =
-				(gn_leaf_parameter_event_handle_t) malloc(
-						sizeof(gn_leaf_parameter_event_t));
+				(gn_leaf_parameter_event_handle_t) gn_mem_malloc(
+						GN_MEM_TAG_CORE, sizeof(gn_leaf_parameter_event_t));
 
 		evt->id = id;
 		strncpy(evt->leaf_name, leaf_config->name,
@@ -1308,7 +1737,7 @@ void _gn_leaf_evt_handler(void *handler_args, esp_event_base_t base, int32_t id,
 		} else {
 			ESP_LOGE(TAG, "_gn_leaf_evt_handler ERROR");
 		}
-		free(evt);
+		gn_mem_free(evt);
 
 	}
 
@@ -1366,6 +1795,16 @@ gn_err_t gn_leaf_event_unsubscribe(gn_leaf_handle_t leaf_config,
 
 }
 
+//reads the stored value of a parameter, accounted in the boot profile
+static gn_err_t _gn_leaf_param_storage_get(const char *key, void **value) {
+
+	gn_boot_phase_begin(GN_BOOT_PHASE_PARAM_LOAD);
+	gn_err_t ret = gn_storage_get(key, value);
+	gn_boot_phase_end(GN_BOOT_PHASE_PARAM_LOAD);
+	return ret;
+
+}
+
 /**
  * 	@brief	creates a parameter on the leaf
  *
@@ -1393,6 +1832,8 @@ gn_leaf_param_handle_t gn_leaf_param_create(gn_leaf_handle_t leaf_config,
 	}
 
 	gn_leaf_handle_intl_t _leaf_config = (gn_leaf_handle_intl_t) leaf_config;
+	//stored string replacing the default, that belongs to the caller
+	char *stored = NULL;
 
 	ESP_LOGD(TAG, "gn_leaf_param_create %s ", name);
 	//ESP_LOGD(TAG, "building storage tag..");
@@ -1401,7 +1842,8 @@ gn_leaf_param_handle_t gn_leaf_param_create(gn_leaf_handle_t leaf_config,
 //check parameter stored
 		int _len = (strlen(_leaf_config->name) + strlen(name) + 2);
 //ESP_LOGD(TAG, "..len: %i", _len);
-		char *_buf = (char*) calloc(_len, sizeof(char));
+		char *_buf = (char*) gn_mem_calloc(GN_MEM_TAG_PARAMS, _len,
+				sizeof(char));
 
 		memcpy(_buf, _leaf_config->name,
 				strlen(_leaf_config->name) * sizeof(char));
@@ -1418,16 +1860,15 @@ gn_leaf_param_handle_t gn_leaf_param_create(gn_leaf_handle_t leaf_config,
 //check if existing
 		ESP_LOGD(TAG, "check stored value for key %s", _buf);
 
-		if (gn_storage_get(_buf, (void**) &value)
+		if (_gn_leaf_param_storage_get(_buf, (void**) &value)
 				== GN_RET_NVS_PARAMETER_FOUND) {
 			ESP_LOGD(TAG, "found stored value for key %s", _buf);
 
 			switch (type) {
 			case GN_VAL_TYPE_STRING:
-				free(val.s);
-				val.s = strdup(value);
+				stored = value;
+				val.s = stored;
 				ESP_LOGD(TAG, ".. value: %s", val.s);
-				free(value);
 				break;
 			case GN_VAL_TYPE_BOOLEAN:
 				val.b = *((bool*) value);
@@ -1442,7 +1883,7 @@ gn_leaf_param_handle_t gn_leaf_param_create(gn_leaf_handle_t leaf_config,
 			default:
 				ESP_LOGE(TAG, "param type not handled");
 				free(value);
-				free(_buf);
+				gn_mem_free(_buf);
 				return NULL;
 				break;
 			}
@@ -1451,11 +1892,11 @@ gn_leaf_param_handle_t gn_leaf_param_create(gn_leaf_handle_t leaf_config,
 			ESP_LOGD(TAG, "not found stored value for key %s", _buf);
 		}
 
-		free(_buf);
+		gn_mem_free(_buf);
 	}
 
-	gn_leaf_param_handle_intl_t _ret = (gn_leaf_param_handle_intl_t) malloc(
-			sizeof(gn_leaf_param_t));
+	gn_leaf_param_handle_intl_t _ret = (gn_leaf_param_handle_intl_t) gn_mem_malloc(
+			GN_MEM_TAG_PARAMS, sizeof(gn_leaf_param_t));
 	_ret->next = NULL;
 
 	//char *_name = strdup(name);
@@ -1465,18 +1906,23 @@ gn_leaf_param_handle_t gn_leaf_param_create(gn_leaf_handle_t leaf_config,
 	strncpy(_ret->name, name, GN_LEAF_PARAM_NAME_SIZE);
 	strncpy(_ret->unit, "", GN_LEAF_PARAM_UNIT_SIZE);
 	strncpy(_ret->format, "", GN_LEAF_PARAM_FORMAT_SIZE);
+	_ret->topic_cmd = NULL;
+	_ret->topic_sts = NULL;
 
-	gn_param_val_handle_t _param_val = (gn_param_val_handle_t) malloc(
-			sizeof(gn_param_val_t));
+	gn_param_val_handle_t _param_val = (gn_param_val_handle_t) gn_mem_malloc(
+			GN_MEM_TAG_PARAMS, sizeof(gn_param_val_t));
 	gn_val_t _val;
 
 	switch (type) {
 	case GN_VAL_TYPE_STRING:
-		if (!val.s) {
+		_val.s = val.s ? gn_mem_strdup(GN_MEM_TAG_PARAMS, val.s) : NULL;
+		free(stored);
+		if (!_val.s) {
 			ESP_LOGE(TAG, "gn_leaf_param_create incorrect string parameter");
+			gn_mem_free(_param_val);
+			gn_mem_free(_ret);
 			return NULL;
 		}
-		_val.s = strdup(val.s);
 		break;
 	case GN_VAL_TYPE_BOOLEAN:
 		_val.b = val.b;
@@ -1533,7 +1979,8 @@ gn_err_t gn_leaf_param_init_string(const gn_leaf_handle_t leaf_config,
 	gn_leaf_handle_intl_t _leaf_config = (gn_leaf_handle_intl_t) leaf_config;
 
 	int _len = (strlen(_leaf_config->name) + strlen(name) + 2);
-	char *_buf = (char*) calloc(_len, sizeof(char));
+	char *_buf = (char*) gn_mem_calloc(GN_MEM_TAG_PARAMS, _len,
+				sizeof(char));
 
 	memcpy(_buf, _leaf_config->name, strlen(_leaf_config->name) * sizeof(char));
 	memcpy(_buf + strlen(_leaf_config->name) * sizeof(char), "_",
@@ -1545,8 +1992,11 @@ gn_err_t gn_leaf_param_init_string(const gn_leaf_handle_t leaf_config,
 
 	if (_param->storage == GN_LEAF_PARAM_STORAGE_PERSISTED) {
 		//if already set keep old value
-		if (gn_storage_get(_buf, (void**) &val) == GN_RET_NVS_PARAMETER_FOUND) {
+		if (_gn_leaf_param_storage_get(_buf, (void**) &val)
+				== GN_RET_NVS_PARAMETER_FOUND) {
 			ESP_LOGD(TAG, ".. value already found: (%s) - skipping", val);
+			free((char*) val);
+			gn_mem_free(_buf);
 			return GN_RET_OK;
 		}
 	}
@@ -1560,13 +2010,19 @@ gn_err_t gn_leaf_param_init_string(const gn_leaf_handle_t leaf_config,
 				validate);
 		if (val_ret != GN_LEAF_PARAM_VALIDATOR_ERROR_GENERIC
 				&& val_ret != GN_LEAF_PARAM_VALIDATOR_ERROR_NOT_ALLOWED) {
+			_val->v.s = (char*) gn_mem_realloc(GN_MEM_TAG_PARAMS, _val->v.s,
+					sizeof(char) * (strlen(*validate) + 1));
 			strcpy(_val->v.s, *validate);
 			ESP_LOGD(TAG, "processing validator - result: %d", (int ) val_ret);
 		} else {
+			_val->v.s = (char*) gn_mem_realloc(GN_MEM_TAG_PARAMS, _val->v.s,
+					sizeof(char) * (strlen(val) + 1));
 			strcpy(_val->v.s, val);
 		}
 	} else {
-		strcpy(_param->param_val->v.s, val);
+		_val->v.s = (char*) gn_mem_realloc(GN_MEM_TAG_PARAMS, _val->v.s,
+				sizeof(char) * (strlen(val) + 1));
+		strcpy(_val->v.s, val);
 	}
 
 	if (_param->storage == GN_LEAF_PARAM_STORAGE_PERSISTED) {
@@ -1575,7 +2031,7 @@ gn_err_t gn_leaf_param_init_string(const gn_leaf_handle_t leaf_config,
 			ESP_LOGW(TAG,
 					"not possible to store leaf parameter value - key %s value %s",
 					_buf, val);
-			free(_buf);
+			gn_mem_free(_buf);
 			return GN_RET_ERR;
 		}
 	}
@@ -1587,6 +2043,8 @@ gn_err_t gn_leaf_param_init_string(const gn_leaf_handle_t leaf_config,
 	evt.id = GN_LEAF_PARAM_INITIALIZED_EVENT;
 	//evt.data = calloc((strlen(_param->param_val->v.s) + 1) * sizeof(char));
 	strncpy(evt.data, _param->param_val->v.s, GN_LEAF_DATA_SIZE - 1);
+	evt.data[GN_LEAF_DATA_SIZE - 1] = '\0';
+	evt.data_len = strlen(evt.data);
 
 	esp_err_t ret = esp_event_post_to(_leaf_config->node->config->event_loop,
 			GN_BASE_EVENT, evt.id, &evt, sizeof(evt), portMAX_DELAY);
@@ -1597,12 +2055,29 @@ gn_err_t gn_leaf_param_init_string(const gn_leaf_handle_t leaf_config,
 		return GN_RET_ERR;
 	}
 
-	free(_buf);
+	gn_mem_free(_buf);
 
 	return GN_RET_OK;
 
 }
 
+/**
+ * @brief	closes the latency trace of the command that requested the forced parameter, then publishes it
+ */
+static gn_err_t _gn_leaf_param_notify_server(gn_leaf_handle_intl_t leaf_config,
+		gn_leaf_param_handle_intl_t param) {
+
+#ifdef CONFIG_GROWNODE_LATENCY_TRACE
+	//applied once forced, the publish is not part of the command latency
+	if (leaf_config->trace.at[GN_TRACE_HOP_RECEIVED] != 0
+			&& strcmp(leaf_config->trace_param, param->name) == 0)
+		gn_trace_record(&leaf_config->trace_stats, &leaf_config->trace);
+#endif
+
+	return gn_mqtt_send_leaf_param(param);
+
+}
+
 /**
  * 	@brief	updates the parameter with new value
  *
@@ -1642,8 +2117,8 @@ gn_err_t gn_leaf_param_force_string(const gn_leaf_handle_t leaf_config,
 				(void**) validate);
 		if (ret != GN_LEAF_PARAM_VALIDATOR_ERROR_GENERIC
 				&& ret != GN_LEAF_PARAM_VALIDATOR_ERROR_NOT_ALLOWED) {
-			_param->param_val->v.s = (char*) realloc(_param->param_val->v.s,
-					sizeof(char) * (strlen(*validate) + 1));
+			_param->param_val->v.s = (char*) gn_mem_realloc(GN_MEM_TAG_PARAMS,
+					_param->param_val->v.s, sizeof(char) * (strlen(*validate) + 1));
 			memset(_param->param_val->v.s, 0,
 					sizeof(char) * (strlen(*validate) + 1));
 			strcpy(_param->param_val->v.s, *validate);
@@ -1655,16 +2130,16 @@ gn_err_t gn_leaf_param_force_string(const gn_leaf_handle_t leaf_config,
 		}
 //ESP_LOGD(TAG, "processing validator - result: %d", (int )ret);
 	} else {
-		_param->param_val->v.s = (char*) realloc(_param->param_val->v.s,
-				sizeof(char) * (strlen(val) + 1));
-		memset(_param->param_val->v.s, 0, sizeof(char) * (strlen(val) + 1));
-		strncpy(_param->param_val->v.s, val, GN_LEAF_PARAM_VAL_SIZE - 1);
+		_param->param_val->v.s = (char*) gn_mem_realloc(GN_MEM_TAG_PARAMS,
+				_param->param_val->v.s, sizeof(char) * (strlen(val) + 1));
+		strcpy(_param->param_val->v.s, val);
 	}
 
 	if (_param->storage == GN_LEAF_PARAM_STORAGE_PERSISTED) {
 
 		int _len = (strlen(_leaf_config->name) + strlen(name) + 2);
-		char *_buf = (char*) calloc(_len, sizeof(char));
+		char *_buf = (char*) gn_mem_calloc(GN_MEM_TAG_PARAMS, _len,
+				sizeof(char));
 
 		memcpy(_buf, _leaf_config->name,
 				strlen(_leaf_config->name) * sizeof(char));
@@ -1673,17 +2148,17 @@ gn_err_t gn_leaf_param_force_string(const gn_leaf_handle_t leaf_config,
 		memcpy(_buf + (strlen(_leaf_config->name) + 1) * sizeof(char), name,
 				strlen(name) * sizeof(char));
 
-		_buf[_len] = '\0';
+		_buf[_len - 1] = '\0';
 
 		if (gn_storage_set(_buf, (void*) val, strlen(val)) != ESP_OK) {
 			ESP_LOGW(TAG,
 					"not possible to store leaf parameter value - key %s value %s",
 					_buf, val);
-			free(_buf);
+			gn_mem_free(_buf);
 			return GN_RET_ERR;
 		}
 
-		free(_buf);
+		gn_mem_free(_buf);
 
 	}
 
@@ -1697,6 +2172,8 @@ gn_err_t gn_leaf_param_force_string(const gn_leaf_handle_t leaf_config,
 	evt.id = GN_LEAF_PARAM_CHANGED_EVENT;
 	//evt.data = calloc((strlen(_param->param_val->v.s) + 1) * sizeof(char));
 	strncpy(evt.data, _param->param_val->v.s, GN_LEAF_DATA_SIZE - 1);
+	evt.data[GN_LEAF_DATA_SIZE - 1] = '\0';
+	evt.data_len = strlen(evt.data);
 
 	esp_err_t ret = esp_event_post_to(_leaf_config->node->config->event_loop,
 			GN_BASE_EVENT, evt.id, &evt, sizeof(evt), portMAX_DELAY);
@@ -1707,7 +2184,7 @@ gn_err_t gn_leaf_param_force_string(const gn_leaf_handle_t leaf_config,
 		return GN_RET_ERR;
 	}
 
-	return gn_mqtt_send_leaf_param(_param);
+	return _gn_leaf_param_notify_server(_leaf_config, _param);
 
 }
 
@@ -1778,7 +2255,8 @@ gn_err_t gn_leaf_param_init_bool(const gn_leaf_handle_t leaf_config,
 	gn_leaf_handle_intl_t _leaf_config = (gn_leaf_handle_intl_t) leaf_config;
 
 	int _len = (strlen(_leaf_config->name) + strlen(name) + 2);
-	char *_buf = (char*) calloc(_len, sizeof(char));
+	char *_buf = (char*) gn_mem_calloc(GN_MEM_TAG_PARAMS, _len,
+				sizeof(char));
 
 	memcpy(_buf, _leaf_config->name, strlen(_leaf_config->name) * sizeof(char));
 	memcpy(_buf + strlen(_leaf_config->name) * sizeof(char), "_",
@@ -1790,7 +2268,8 @@ gn_err_t gn_leaf_param_init_bool(const gn_leaf_handle_t leaf_config,
 
 	if (_param->storage == GN_LEAF_PARAM_STORAGE_PERSISTED) {
 		//if already set keep old value
-		if (gn_storage_get(_buf, (void**) &val) == GN_RET_NVS_PARAMETER_FOUND) {
+		if (_gn_leaf_param_storage_get(_buf, (void**) &val)
+				== GN_RET_NVS_PARAMETER_FOUND) {
 			ESP_LOGD(TAG, ".. value already found: (%d) - skipping", val);
 			return GN_RET_OK;
 		}
@@ -1818,7 +2297,7 @@ gn_err_t gn_leaf_param_init_bool(const gn_leaf_handle_t leaf_config,
 			ESP_LOGW(TAG,
 					"not possible to store leaf parameter value - key %s value %d",
 					_buf, val);
-			free(_buf);
+			gn_mem_free(_buf);
 			return GN_RET_ERR;
 		}
 	}
@@ -1847,7 +2326,7 @@ gn_err_t gn_leaf_param_init_bool(const gn_leaf_handle_t leaf_config,
 		return GN_RET_ERR;
 	}
 
-	free(_buf);
+	gn_mem_free(_buf);
 
 	return GN_RET_OK;
 
@@ -1917,7 +2396,8 @@ gn_err_t gn_leaf_param_force_bool(const gn_leaf_handle_t leaf_config,
 	if (_param->storage == GN_LEAF_PARAM_STORAGE_PERSISTED) {
 
 		int _len = (strlen(_leaf_config->name) + strlen(name) + 2);
-		char *_buf = (char*) calloc(_len, sizeof(char));
+		char *_buf = (char*) gn_mem_calloc(GN_MEM_TAG_PARAMS, _len,
+				sizeof(char));
 
 		memcpy(_buf, _leaf_config->name,
 				strlen(_leaf_config->name) * sizeof(char));
@@ -1933,11 +2413,11 @@ gn_err_t gn_leaf_param_force_bool(const gn_leaf_handle_t leaf_config,
 			ESP_LOGW(TAG,
 					"not possible to store leaf parameter value - key %s value %i",
 					_buf, val);
-			free(_buf);
+			gn_mem_free(_buf);
 			return GN_RET_ERR;
 		}
 
-		free(_buf);
+		gn_mem_free(_buf);
 
 	}
 
@@ -1966,7 +2446,7 @@ gn_err_t gn_leaf_param_force_bool(const gn_leaf_handle_t leaf_config,
 		return GN_RET_ERR;
 	}
 
-	return gn_mqtt_send_leaf_param(_param);
+	return _gn_leaf_param_notify_server(_leaf_config, _param);
 
 }
 
@@ -2085,7 +2565,8 @@ gn_err_t gn_leaf_param_init_double(const gn_leaf_handle_t leaf_config,
 	gn_leaf_handle_intl_t _leaf_config = (gn_leaf_handle_intl_t) leaf_config;
 
 	int _len = (strlen(_leaf_config->name) + strlen(name) + 2);
-	char *_buf = (char*) calloc(_len, sizeof(char));
+	char *_buf = (char*) gn_mem_calloc(GN_MEM_TAG_PARAMS, _len,
+				sizeof(char));
 
 	memcpy(_buf, _leaf_config->name, strlen(_leaf_config->name) * sizeof(char));
 	memcpy(_buf + strlen(_leaf_config->name) * sizeof(char), "_",
@@ -2097,7 +2578,8 @@ gn_err_t gn_leaf_param_init_double(const gn_leaf_handle_t leaf_config,
 
 	if (_param->storage == GN_LEAF_PARAM_STORAGE_PERSISTED) {
 		//if already set keep old value
-		if (gn_storage_get(_buf, (void**) &val) == GN_RET_NVS_PARAMETER_FOUND) {
+		if (_gn_leaf_param_storage_get(_buf, (void**) &val)
+				== GN_RET_NVS_PARAMETER_FOUND) {
 			ESP_LOGD(TAG, ".. value already found: (%f) - skipping", val);
 			return GN_RET_OK;
 		}
@@ -2125,7 +2607,7 @@ gn_err_t gn_leaf_param_init_double(const gn_leaf_handle_t leaf_config,
 			ESP_LOGW(TAG,
 					"not possible to store leaf parameter value - key %s value %f",
 					_buf, val);
-			free(_buf);
+			gn_mem_free(_buf);
 			return GN_RET_ERR;
 		}
 	}
@@ -2152,7 +2634,7 @@ gn_err_t gn_leaf_param_init_double(const gn_leaf_handle_t leaf_config,
 		return GN_RET_ERR;
 	}
 
-	free(_buf);
+	gn_mem_free(_buf);
 
 	return GN_RET_OK;
 
@@ -2213,7 +2695,8 @@ gn_err_t gn_leaf_param_force_double(const gn_leaf_handle_t leaf_config,
 	if (_param->storage == GN_LEAF_PARAM_STORAGE_PERSISTED) {
 
 		int _len = (strlen(_leaf_config->name) + strlen(name) + 2);
-		char *_buf = (char*) calloc(_len, sizeof(char));
+		char *_buf = (char*) gn_mem_calloc(GN_MEM_TAG_PARAMS, _len,
+				sizeof(char));
 
 		memcpy(_buf, _leaf_config->name,
 				strlen(_leaf_config->name) * sizeof(char));
@@ -2229,11 +2712,11 @@ gn_err_t gn_leaf_param_force_double(const gn_leaf_handle_t leaf_config,
 			ESP_LOGW(TAG,
 					"not possible to store leaf parameter value - key %s value %f",
 					_buf, val);
-			free(_buf);
+			gn_mem_free(_buf);
 			return GN_RET_ERR;
 		}
 
-		free(_buf);
+		gn_mem_free(_buf);
 
 	}
 
@@ -2257,7 +2740,7 @@ gn_err_t gn_leaf_param_force_double(const gn_leaf_handle_t leaf_config,
 		return GN_RET_ERR;
 	}
 
-	return gn_mqtt_send_leaf_param(_param);
+	return _gn_leaf_param_notify_server(_leaf_config, _param);
 
 }
 
@@ -2284,13 +2767,13 @@ gn_err_t gn_leaf_param_get_value(const gn_leaf_param_handle_t param, void *val)
 	switch (_val->t) {
 
 	case GN_VAL_TYPE_STRING:
-		val = &_val->v.s;
+		*(char**) val = _val->v.s;
 		break;
 	case GN_VAL_TYPE_BOOLEAN:
-		val = &_val->v.b;
+		*(bool*) val = _val->v.b;
 		break;
 	case GN_VAL_TYPE_DOUBLE:
-		val = &_val->v.d;
+		*(double*) val = _val->v.d;
 		break;
 	default:
 		return GN_RET_ERR;
@@ -2301,6 +2784,32 @@ gn_err_t gn_leaf_param_get_value(const gn_leaf_param_handle_t param, void *val)
 
 }
 
+/**
+ * @brief gets the type of the parameter value
+ *
+ * @param 	param 	the parameter handle to look at
+ * @param 	type 	the type returned
+ *
+ * 	@return GN_RET_OK if the parameter is set
+ * 	@return GN_RET_ERR_INVALID_ARG in case of input errors
+ */
+gn_err_t gn_leaf_param_get_type(const gn_leaf_param_handle_t param,
+		gn_val_type_t *type) {
+
+	if (!param || !type)
+		return GN_RET_ERR_INVALID_ARG;
+
+	gn_param_val_handle_int_t _val =
+			((gn_leaf_param_handle_intl_t) param)->param_val;
+	if (!_val) {
+		return GN_RET_ERR;
+	}
+
+	*type = _val->t;
+	return GN_RET_OK;
+
+}
+
 gn_err_t gn_leaf_param_get_double(const gn_leaf_handle_t leaf_config,
 		const char *name, double *val) {
 
@@ -2362,8 +2871,8 @@ gn_err_t _gn_leaf_parameter_update(const gn_leaf_handle_t leaf_config,
 
 			//build event
 			gn_leaf_parameter_event_handle_t evt =
-					(gn_leaf_parameter_event_handle_t) malloc(
-							sizeof(gn_leaf_parameter_event_t));
+					(gn_leaf_parameter_event_handle_t) gn_mem_malloc(
+							GN_MEM_TAG_CORE, sizeof(gn_leaf_parameter_event_t));
 
 			evt->id = GN_LEAF_PARAM_CHANGE_REQUEST_EVENT;
 			strncpy(evt->leaf_name, _leaf_config->name,
@@ -2374,9 +2883,13 @@ gn_err_t _gn_leaf_parameter_update(const gn_leaf_handle_t leaf_config,
 			memcpy(&evt->data[0], data, data_len);
 			evt->data_len = data_len;
 
+#ifdef CONFIG_GROWNODE_LATENCY_TRACE
+			gn_trace_start(&evt->trace);
+#endif
+
 			//send message to the interested leaf
 			gn_err_t ret = _gn_send_event_to_leaf(_leaf_config, evt);
-			free(evt);
+			gn_mem_free(evt);
 			return ret;
 
 		}
@@ -2395,10 +2908,10 @@ gn_err_t _gn_leaf_param_destroy(gn_leaf_param_handle_t param) {
 	if (!new_param)
 		return GN_RET_ERR_INVALID_ARG;
 
-	free(new_param->param_val->v.s);
-	free(new_param->param_val);
-	free(new_param->name);
-	free(new_param);
+	if (new_param->param_val->t == GN_VAL_TYPE_STRING)
+		gn_mem_free(new_param->param_val->v.s);
+	gn_mem_free(new_param->param_val);
+	gn_mem_free(new_param);
 
 	return GN_RET_OK;
 
@@ -2441,6 +2954,13 @@ gn_err_t gn_leaf_param_add_to_leaf(const gn_leaf_handle_t leaf,
 	}
 
 	new_param->leaf = leaf;
+
+	if (gn_mqtt_build_leaf_param_topics(new_param) != GN_RET_OK) {
+		ESP_LOGE(TAG, "gn_leaf_param_add failed to build topics of param %s",
+				new_param->name);
+		return GN_RET_ERR;
+	}
+
 	if (_param) {
 		_param->next = new_param;
 	} else {
@@ -2610,10 +3130,9 @@ gn_err_t gn_leaf_param_set_double(const gn_leaf_handle_t leaf_config,
 	}
 	gn_leaf_handle_intl_t _leaf_config = (gn_leaf_handle_intl_t) leaf_config;
 
-	char val_ptr[32] = "";
-	sprintf(val_ptr, "%f", val);
+	//same raw encoding read by gn_event_payload_to_double
 	gn_err_t ret = gn_send_leaf_param_change_message(_leaf_config->name, name,
-			val_ptr, sizeof(double));
+			&val, sizeof(double));
 	return ret;
 }
 
@@ -2640,11 +3159,8 @@ gn_err_t gn_leaf_param_set_string(const gn_leaf_handle_t leaf_config,
 	}
 	gn_leaf_handle_intl_t _leaf_config = (gn_leaf_handle_intl_t) leaf_config;
 
-	char *val_ptr = (char*) calloc(strlen(val) + 1, sizeof(char));
-	strncpy(val_ptr, val, sizeof(val) + 1);
 	gn_err_t ret = gn_send_leaf_param_change_message(_leaf_config->name, name,
-			val_ptr, sizeof(val) + 1);
-	free(val_ptr);
+			val, strlen(val) + 1);
 	return ret;
 }
 
@@ -2693,7 +3209,7 @@ gn_leaf_param_handle_t gn_leaf_param_get_param_handle(
 //		"gn_leaf_param_get_param_handle - comparing %s (%d) and checking %s (%d)",
 //		param_name, strlen(param_name), param->name,
 //		strlen(param->name));
-		if (strncmp(param->name, param_name, strlen(param_name)) == 0) {
+		if (strncmp(param->name, param_name, GN_LEAF_PARAM_NAME_SIZE) == 0) {
 			//ESP_LOGD(TAG, "found!");
 			return param;
 		}
@@ -2981,6 +3497,8 @@ gn_config_handle_t gn_init(gn_config_init_param_t *config_init) {
 
 	ESP_LOGD(TAG, "gn_init");
 
+	gn_boot_phase_begin(GN_BOOT_PHASE_INIT);
+
 //_gn_xEvtSemaphore = xSemaphoreCreateMutex();
 
 	_gn_default_conf = _gn_config_create(config_init);
@@ -2990,41 +3508,63 @@ gn_config_handle_t gn_init(gn_config_init_param_t *config_init) {
 	}
 
 //init flash
+	gn_boot_phase_begin(GN_BOOT_PHASE_FLASH);
 	ESP_GOTO_ON_ERROR(_gn_init_flash(_gn_default_conf), err, TAG,
 			"error init flash: %s", esp_err_to_name(ret));
+	gn_boot_phase_end(GN_BOOT_PHASE_FLASH);
 
 //init spiffs
+	gn_boot_phase_begin(GN_BOOT_PHASE_SPIFFS);
 	ESP_GOTO_ON_ERROR(_gn_init_spiffs(_gn_default_conf), err, TAG,
 			"error init spiffs: %s", esp_err_to_name(ret));
+	gn_boot_phase_end(GN_BOOT_PHASE_SPIFFS);
 
 //init event loop
+	gn_boot_phase_begin(GN_BOOT_PHASE_EVENT_LOOP);
 	ESP_GOTO_ON_ERROR(_gn_init_event_loop(_gn_default_conf), err, TAG,
 			"error init_event_loop: %s", esp_err_to_name(ret));
 
 //register to events
 	ESP_GOTO_ON_ERROR(_gn_evt_handlers_register(_gn_default_conf), err, TAG,
 			"error _gn_register_event_handlers: %s", esp_err_to_name(ret));
+	gn_boot_phase_end(GN_BOOT_PHASE_EVENT_LOOP);
+
+//init shared services, before the leaves and the GUI task can use them
+	ESP_GOTO_ON_ERROR(gn_sampler_init(), err, TAG, "error on sampler init: %s",
+			esp_err_to_name(ret));
+	ESP_GOTO_ON_ERROR(gn_scheduler_init(), err, TAG,
+			"error on scheduler init: %s", esp_err_to_name(ret));
+	ESP_GOTO_ON_ERROR(gn_i2c_init(), err, TAG, "error on i2c init: %s",
+			esp_err_to_name(ret));
+	ESP_GOTO_ON_ERROR(gn_display_binding_init(), err, TAG,
+			"error on display binding init: %s", esp_err_to_name(ret));
 
 //init display
 #ifdef CONFIG_GROWNODE_DISPLAY_ENABLED
+	gn_boot_phase_begin(GN_BOOT_PHASE_DISPLAY);
 	ESP_GOTO_ON_ERROR(gn_init_display(_gn_default_conf), err, TAG,
 			"error on display init: %s", esp_err_to_name(ret));
+	gn_boot_phase_end(GN_BOOT_PHASE_DISPLAY);
 #endif
 
 #if CONFIG_GROWNODE_WIFI_ENABLED
 
 	//init wifi
+	gn_boot_phase_begin(GN_BOOT_PHASE_WIFI);
 	ESP_GOTO_ON_ERROR(gn_wifi_init(_gn_default_conf), err_net, TAG,
 			"error on wifi init: %s", esp_err_to_name(ret));
+	gn_boot_phase_end(GN_BOOT_PHASE_WIFI);
 
 	//init time sync. note: if bad, continue
+	gn_boot_phase_begin(GN_BOOT_PHASE_TIME_SYNC);
 	ESP_GOTO_ON_ERROR(gn_wifi_time_sync_init(_gn_default_conf), err_timesync,
 			TAG, "error on time sync init: %s", esp_err_to_name(ret));
 
-	err_timesync:
+	err_timesync: gn_boot_phase_end(GN_BOOT_PHASE_TIME_SYNC);
 
 #endif
 
+	gn_boot_phase_end(GN_BOOT_PHASE_INIT);
 	ESP_LOGI(TAG, "grownode startup sequence completed!");
 	_gn_default_conf->status = GN_NODE_STATUS_READY_TO_START;
 	return _gn_default_conf;
@@ -3128,6 +3668,27 @@ gn_err_t gn_storage_set(const char *key, const void *value,
  */
 gn_err_t gn_storage_get(const char *key, void **value) {
 
+	return gn_storage_get_blob(key, value, NULL);
+
+}
+
+/**
+ *	@brief retrieves the key from the NVS flash, with the number of bytes stored
+ *
+ *	the data acquired is zero padded beyond the stored bytes. binary values must not be read
+ *	past 'size', whatever length they declare
+ *
+ *	@param key name (null terminated)
+ *	@param value	pointer where the pointer of the data acquired will be stored
+ *	@param size		where the number of bytes stored is written if found, can be NULL
+ *
+ *	@return GN_RET_ERR_INVALID_ARG if input params are not valid
+ *	@return GN_RET_NVS_PARAMETER_FOUND if key is retrieved successfully
+ *	@return GN_RET_NVS_PARAMETER_NOT_FOUND if key is not retrieved from NVS. in this case 'value' keeps the original value
+ *
+ */
+gn_err_t gn_storage_get_blob(const char *key, void **value, size_t *size) {
+
 	if (!key || !value)
 		return GN_RET_ERR_INVALID_ARG;
 
@@ -3168,6 +3729,8 @@ gn_err_t gn_storage_get(const char *key, void **value) {
 			free(*value);
 			goto fail;
 		}
+		if (size)
+			*size = required_size;
 		ESP_LOGD(TAG_NVS, "gn_storage_get(%s) - %s - OK", key, (char* ) *value);
 	} else
 		goto fail;
@@ -69,6 +69,8 @@ gn_leaf_handle_t gn_leaf_create(gn_node_handle_t node_config,
 gn_leaf_descriptor_handle_t gn_leaf_get_descriptor(
 		gn_leaf_handle_t leaf_config);
 
+gn_mem_tag_t gn_leaf_get_mem_tag(gn_leaf_handle_t leaf_config);
+
 //esp_err_t _gn_start_leaf(gn_leaf_config_handle_t leaf);
 
 QueueHandle_t gn_leaf_get_event_queue(gn_leaf_handle_t leaf_config);
@@ -95,6 +97,9 @@ gn_leaf_param_handle_t gn_leaf_param_get_param_handle(
 
 gn_err_t gn_leaf_param_get_value(const gn_leaf_param_handle_t param, void *val);
 
+gn_err_t gn_leaf_param_get_type(const gn_leaf_param_handle_t param,
+		gn_val_type_t *type);
+
 gn_err_t gn_leaf_param_get_string(const gn_leaf_handle_t leaf_config,
 		const char *name, char *val, size_t max_lenght);
 
@@ -205,6 +210,20 @@ gn_err_t gn_storage_set(const char *key, const void *value,
 
 gn_err_t gn_storage_get(const char *key, void **value);
 
+gn_err_t gn_storage_get_blob(const char *key, void **value, size_t *size);
+
+#ifdef CONFIG_GROWNODE_LATENCY_TRACE
+cJSON* gn_node_latency_to_json(gn_node_handle_t node);
+
+void gn_node_latency_dump(gn_node_handle_t node);
+
+void gn_node_latency_reset(gn_node_handle_t node);
+#endif
+
+#ifdef CONFIG_GROWNODE_RUNTIME_STATS
+cJSON* gn_node_stats_to_json(gn_node_handle_t node);
+#endif
+
 #ifdef __cplusplus
 }
 #endif //__cplusplus
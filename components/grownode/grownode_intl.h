@@ -25,6 +25,7 @@
 
 #include "grownode.h"
 #include "gn_leaf_context.h"
+#include "gn_string_arena.h"
 
 extern const uint8_t server_cert_pem_start[] asm("_binary_ca_cert_pem_start");
 extern const uint8_t server_cert_pem_end[] asm("_binary_ca_cert_pem_end");
@@ -54,6 +55,10 @@ struct gn_config_t {
 	wifi_init_config_t wifi_config;
 	wifi_prov_mgr_config_t prov_config;
 	esp_timer_handle_t keepalive_timer_handler;
+#ifdef CONFIG_GROWNODE_RUNTIME_STATS
+	esp_timer_handle_t stats_timer_handler;
+	uint32_t stats_runtime_last; /*!< run time counter at the last statistics */
+#endif
 	char deviceName[17];
 	uint8_t macAddress[6];
 	gn_node_status_t status;
@@ -66,6 +71,9 @@ struct gn_node_t {
 	//esp_event_loop_handle_t event_loop;
 	gn_config_handle_intl_t config;
 	gn_leaves_list leaves;
+	gn_string_arena_handle_t topics; /*!< MQTT topics of leaves and params */
+	gn_leaf_context_handle_t topic_index; /*!< param command topic -> param, to dispatch incoming messages */
+	uint32_t ready_ms; /*!< time taken by gn_node_start, with server connection and subscriptions */
 };
 
 struct gn_leaf_config_t {
@@ -84,6 +92,21 @@ struct gn_leaf_config_t {
 	//gn_display_handler_t display_handler;
 	gn_leaf_context_handle_t leaf_context;
 	gn_display_container_t display_container;
+	const char *topic_cmd; /*!< interned in node topics, NULL if not used by the protocol */
+	const char *topic_sts;
+#ifdef CONFIG_GROWNODE_LATENCY_TRACE
+	gn_trace_t trace; /*!< command taken by the leaf task and not applied yet */
+	char trace_param[GN_LEAF_PARAM_NAME_SIZE];
+	gn_trace_stats_handle_t trace_stats;
+#endif
+#ifdef CONFIG_GROWNODE_MEM_ACCOUNTING
+	gn_mem_tag_t mem_tag; /*!< heap accounting of the leaf allocations */
+#endif
+#ifdef CONFIG_GROWNODE_RUNTIME_STATS
+	UBaseType_t queue_peak; /*!< most events waiting in the queue since the last statistics */
+	uint32_t events_dropped; /*!< events not sent because the queue was full */
+	uint32_t runtime_last; /*!< task run time counter at the last statistics */
+#endif
 };
 
 typedef struct {
@@ -104,6 +127,8 @@ struct gn_leaf_param {
 	gn_validator_callback_t validator;
 	char unit[GN_LEAF_PARAM_UNIT_SIZE];
 	char format[GN_LEAF_PARAM_FORMAT_SIZE];
+	const char *topic_cmd; /*!< interned in node topics, set when added to the leaf */
+	const char *topic_sts;
 	struct gn_leaf_param *next;
 };
 
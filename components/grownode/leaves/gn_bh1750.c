@@ -29,6 +29,7 @@ extern "C" {
 #include "lvgl/lvgl.h"
 #endif
 #include "lvgl_helpers.h"
+#include "gn_display_binding.h"
 #endif
 
 #include "bh1750.h"
@@ -38,6 +39,9 @@ extern "C" {
 #include "freertos/event_groups.h"
 #include "freertos/semphr.h"
 
+#include "gn_sampler.h"
+#include "gn_i2c.h"
+#include "gn_filter.h"
 #include "gn_bh1750.h"
 
 #define TAG "gn_leaf_bh1750"
@@ -48,7 +52,11 @@ typedef struct {
 	bh1750_mode_t mode;
 	bh1750_resolution_t resolution;
 
-	esp_timer_handle_t bh1750_sensor_timer;
+	gn_sampler_job_handle_t bh1750_sensor_job;
+	gn_i2c_bus_handle_t i2c_bus;
+	gn_i2c_device_handle_t i2c_device;
+	uint16_t lux; //!< written by the bus worker
+	gn_filter_handle_t lux_filter;
 
 	gn_leaf_param_handle_t sda_param;
 	gn_leaf_param_handle_t scl_param;
@@ -119,6 +127,37 @@ gn_leaf_handle_t gn_bh1750_fastcreate(gn_node_handle_t node,
 
 }
 
+static esp_err_t _gn_bh1750_read(void *arg) {
+
+	gn_bh1750_data_t *data = (gn_bh1750_data_t*) arg;
+	return bh1750_read(&data->i2c_dev, &data->lux);
+
+}
+
+static void _gn_bh1750_read_done(const gn_i2c_op_t *ops, size_t count,
+		void *arg) {
+
+	gn_leaf_handle_t leaf_config = (gn_leaf_handle_t) arg;
+	gn_bh1750_data_t *data = (gn_bh1750_data_t*) gn_leaf_get_descriptor(
+			leaf_config)->data;
+
+	char leaf_name[GN_LEAF_NAME_SIZE];
+	gn_leaf_get_name(leaf_config, leaf_name);
+
+	if (ops[0].result != ESP_OK) {
+		gn_log(TAG, GN_LOG_ERROR, "[%s] sensor read error %d (%s)", leaf_name,
+				ops[0].result, esp_err_to_name(ops[0].result));
+		return;
+	}
+
+	ESP_LOGD(TAG, "[%s] Illuminance: %.2f lux\n", leaf_name,
+			(double )data->lux);
+
+	//filter, store parameter and notify network
+	gn_filter_param_update(data->lux_filter, (double) data->lux, NULL);
+
+}
+
 void bh1750_sensor_collect(gn_leaf_handle_t leaf_config) {
 
 	char leaf_name[GN_LEAF_NAME_SIZE];
@@ -134,28 +173,17 @@ void bh1750_sensor_collect(gn_leaf_handle_t leaf_config) {
 
 	if (active == true) {
 
-		esp_err_t res;
-		uint16_t lux;
-
 		ESP_LOGD(TAG, "[%s] reading lux value...", leaf_name);
 
-		// read data from sensor
-		res = bh1750_read(&data->i2c_dev, &lux);
-
-		if (res != ESP_OK) {
-			gn_log(TAG, GN_LOG_ERROR, "[%s] sensor read error %d (%s)",
-					leaf_name, res, esp_err_to_name(res));
-//			goto fail;
-		} else {
-
-			ESP_LOGD(TAG, "[%s] Illuminance: %.2f lux\n", leaf_name,
-					(double )lux);
+		//the read is queued on the bus manager, together with the other sensors of the bus
+		gn_i2c_op_t op = { .type = GN_I2C_OP_CALL, .device = data->i2c_device,
+				.call = &_gn_bh1750_read, .arg = data };
 
-			//store parameter and notify network
-			gn_leaf_param_force_double(leaf_config, GN_BH1750_PARAM_LUX,
-					(double) lux);
+		if (gn_i2c_batch_submit(data->i2c_bus, &op, 1, &_gn_bh1750_read_done,
+				leaf_config) != GN_RET_OK)
+			gn_log(TAG, GN_LOG_ERROR, "[%s] sensor read not queued",
+					leaf_name);
 
-		}
 	}
 
 }
@@ -165,13 +193,15 @@ void gn_bh1750_task(gn_leaf_handle_t leaf_config);
 gn_leaf_descriptor_handle_t gn_bh1750_config(gn_leaf_handle_t leaf_config) {
 
 	gn_leaf_descriptor_handle_t descriptor =
-			(gn_leaf_descriptor_handle_t) malloc(sizeof(gn_leaf_descriptor_t));
+			(gn_leaf_descriptor_handle_t) gn_mem_malloc(
+					gn_leaf_get_mem_tag(leaf_config), sizeof(gn_leaf_descriptor_t));
 	strncpy(descriptor->type, GN_LEAF_BH1750_TYPE, GN_LEAF_DESC_TYPE_SIZE);
 	descriptor->callback = gn_bh1750_task;
 	descriptor->status = GN_LEAF_STATUS_NOT_INITIALIZED;
 	descriptor->data = NULL;
 
-	gn_bh1750_data_t *data = malloc(sizeof(gn_bh1750_data_t));
+	gn_bh1750_data_t *data = gn_mem_malloc(gn_leaf_get_mem_tag(leaf_config),
+			sizeof(gn_bh1750_data_t));
 
 	//parameter definition. if found in flash storage, they will be created with found values instead of default
 
@@ -204,6 +234,9 @@ gn_leaf_descriptor_handle_t gn_bh1750_config(gn_leaf_handle_t leaf_config) {
 			GN_LEAF_PARAM_ACCESS_ALL, GN_LEAF_PARAM_STORAGE_VOLATILE, NULL);
 	gn_leaf_param_add_to_leaf(leaf_config, data->lux_param);
 
+	data->lux_filter = gn_filter_param_create(leaf_config, GN_BH1750_PARAM_LUX,
+			"");
+
 	descriptor->status = GN_LEAF_STATUS_INITIALIZED;
 	descriptor->data = data;
 
@@ -278,20 +311,27 @@ void gn_bh1750_task(gn_leaf_handle_t leaf_config) {
 						data->i2c_dev.cfg.scl_io_num, data->i2c_dev.port);
 				//vTaskDelay(1000 / portTICK_PERIOD_MS);
 
-				ESP_LOGD(TAG, "[%s] creating timer...", leaf_name);
-				//create a timer to update temps
-				esp_timer_create_args_t bh1750_sensor_timer_args = { .callback =
-						&bh1750_sensor_collect, .arg = leaf_config, .name =
-						"leaf_bh1750_sensor_collect" };
-
-				ret = esp_timer_create(&bh1750_sensor_timer_args,
-						&data->bh1750_sensor_timer);
-				if (ret != ESP_OK) {
+				ret = gn_i2c_bus_get(data->i2c_dev.port, (int) sda, (int) scl,
+						&data->i2c_bus);
+				if (ret == GN_RET_OK)
+					ret = gn_i2c_device_add(data->i2c_bus, &data->i2c_dev,
+							leaf_name, &data->i2c_device);
+
+				ESP_LOGD(TAG, "[%s] creating sampler job...", leaf_name);
+				//the bus manager serializes the reads, so the job runs with the other sensors of the bus
+				gn_sampler_job_config_t bh1750_sensor_job_config = {
+						.callback = &bh1750_sensor_collect, .arg = leaf_config,
+						.name = leaf_name, .bus = GN_SAMPLER_BUS_NONE };
+
+				if (ret == GN_RET_OK)
+					ret = gn_sampler_job_create(&bh1750_sensor_job_config,
+							&data->bh1750_sensor_job);
+				if (ret != GN_RET_OK) {
 					gn_leaf_param_force_bool(leaf_config,
 							GN_BH1750_PARAM_ACTIVE,
 							false);
 					gn_log(TAG, GN_LOG_ERROR,
-							"[%s] failed to init bh1750 leaf timer", leaf_name);
+							"[%s] failed to init bh1750 leaf job", leaf_name);
 					descriptor->status = GN_LEAF_STATUS_ERROR;
 					//return descriptor;
 				}
@@ -305,20 +345,20 @@ void gn_bh1750_task(gn_leaf_handle_t leaf_config) {
 	//vTaskDelay(1000 / portTICK_PERIOD_MS);
 
 	//start timer if needed
-	if (ret == ESP_OK && active == true) {
+	if (ret == GN_RET_OK && active == true) {
 
 		//first shot immediate
 		bh1750_sensor_collect(leaf_config);
 
-		ESP_LOGD(TAG, "[%s] starting timer, polling at %f sec", leaf_name,
+		ESP_LOGD(TAG, "[%s] starting job, polling at %f sec", leaf_name,
 				update_time);
 
-		ret = esp_timer_start_periodic(data->bh1750_sensor_timer,
+		ret = gn_sampler_job_start(data->bh1750_sensor_job,
 				update_time * 1000000);
-		if (ret != ESP_OK) {
+		if (ret != GN_RET_OK) {
 			gn_leaf_param_force_bool(leaf_config, GN_BH1750_PARAM_ACTIVE,
 			false);
-			gn_log(TAG, GN_LOG_ERROR, "[%s] failed to start bh1750 leaf timer",
+			gn_log(TAG, GN_LOG_ERROR, "[%s] failed to start bh1750 leaf job",
 					leaf_name);
 			gn_leaf_get_descriptor(leaf_config)->status = GN_LEAF_STATUS_ERROR;
 		}
@@ -374,6 +414,12 @@ void gn_bh1750_task(gn_leaf_handle_t leaf_config) {
 			lv_obj_set_grid_cell(label_lux_value, LV_GRID_ALIGN_STRETCH, 1, 1,
 					LV_GRID_ALIGN_STRETCH, 1, 1);
 
+			//refreshed by the GUI task when the reading changes
+			gn_display_binding_config_t binding = { .kind =
+					GN_DISPLAY_BINDING_LABEL, .widget = label_lux_value,
+					.format = "%.0f" };
+			gn_display_bind(leaf_config, GN_BH1750_PARAM_LUX, &binding);
+
 			ESP_LOGD(TAG, "end");
 
 		}
@@ -423,9 +469,9 @@ void gn_bh1750_task(gn_leaf_handle_t leaf_config) {
 					update_time = updtime;
 
 					if (active == true) {
-						esp_timer_stop(data->bh1750_sensor_timer);
+						gn_sampler_job_stop(data->bh1750_sensor_job);
 
-						esp_timer_start_periodic(data->bh1750_sensor_timer,
+						gn_sampler_job_start(data->bh1750_sensor_job,
 								update_time * 1000000);
 					}
 
@@ -477,12 +523,14 @@ void gn_bh1750_task(gn_leaf_handle_t leaf_config) {
 
 					//stop timer if false
 					if (_active == 0 && prev_active == true) {
-						esp_timer_stop(data->bh1750_sensor_timer);
+						gn_sampler_job_stop(data->bh1750_sensor_job);
 					} else if (_active != 0 && prev_active == false) {
-						esp_timer_start_periodic(data->bh1750_sensor_timer,
+						gn_sampler_job_start(data->bh1750_sensor_job,
 								update_time * 1000000);
 					}
 
+				} else if (gn_filter_param_event(data->lux_filter, &evt)) {
+					//the new spec is applied at the next reading
 				}
 
 				break;
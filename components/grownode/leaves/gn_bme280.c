@@ -28,6 +28,7 @@ extern "C" {
 #include "lvgl/lvgl.h"
 #endif
 #include "lvgl_helpers.h"
+#include "gn_display_binding.h"
 #endif
 
 #include "bmp280.h"
@@ -37,6 +38,9 @@ extern "C" {
 #include "freertos/event_groups.h"
 #include "freertos/semphr.h"
 
+#include "gn_sampler.h"
+#include "gn_i2c.h"
+#include "gn_filter.h"
 #include "gn_bme280.h"
 
 #define TAG "gn_leaf_bme280"
@@ -46,7 +50,18 @@ typedef struct {
 	bmp280_params_t params;
 	bmp280_t dev;
 
-	esp_timer_handle_t bme280_sensor_timer;
+	gn_sampler_job_handle_t bme280_sensor_job;
+	gn_i2c_bus_handle_t i2c_bus;
+	gn_i2c_device_handle_t i2c_device;
+
+	gn_filter_handle_t temp_filter;
+	gn_filter_handle_t press_filter;
+	gn_filter_handle_t hum_filter;
+
+	//written by the bus worker
+	float temperature;
+	float pressure;
+	float humidity;
 
 	gn_leaf_param_handle_t sda_param;
 	gn_leaf_param_handle_t scl_param;
@@ -58,40 +73,51 @@ typedef struct {
 
 } gn_bme280_data_t;
 
-void bme280_sensor_collect(gn_leaf_handle_t leaf_config) {
+static esp_err_t _gn_bme280_read(void *arg) {
 
-	ESP_LOGD(TAG, "bme280_sensor_collect");
+	gn_bme280_data_t *data = (gn_bme280_data_t*) arg;
+	return bmp280_read_float(&data->dev, &data->temperature, &data->pressure,
+			&data->humidity);
+
+}
 
+static void _gn_bme280_read_done(const gn_i2c_op_t *ops, size_t count,
+		void *arg) {
+
+	gn_leaf_handle_t leaf_config = (gn_leaf_handle_t) arg;
 	gn_bme280_data_t *data = (gn_bme280_data_t*) gn_leaf_get_descriptor(
 			leaf_config)->data;
 
-	//struct leaf_data *data = (struct leaf_data*) _data;
+	if (ops[0].result != ESP_OK) {
+		gn_log(TAG, GN_LOG_ERROR, "Sensors read error %d (%s)", ops[0].result,
+				esp_err_to_name(ops[0].result));
+		return;
+	}
 
-	ESP_LOGD(TAG, "bme280_sensor_collect");
+	ESP_LOGD(TAG, "Pressure: %.2f Pa, Temperature: %.2f C, Humidity: %.2f\n",
+			data->pressure, data->temperature, data->humidity);
 
-	//struct leaf_data *data = (struct leaf_data*) arg;
+	//filter, store parameter and notify network
+	gn_filter_param_update(data->temp_filter, data->temperature, NULL);
+	gn_filter_param_update(data->hum_filter, data->humidity, NULL);
+	gn_filter_param_update(data->press_filter, data->pressure, NULL);
 
-	float pressure, temperature, humidity;
+}
 
-	esp_err_t res = bmp280_read_float(&data->dev, &temperature, &pressure,
-			&humidity);
+void bme280_sensor_collect(gn_leaf_handle_t leaf_config) {
 
-	//read data from sensors using GPIO parameter
-	if (res != ESP_OK) {
-		gn_log(TAG, GN_LOG_ERROR, "Sensors read error %d (%s)", res,
-				esp_err_to_name(res));
-		goto fail;
-	}
+	ESP_LOGD(TAG, "bme280_sensor_collect");
 
-	ESP_LOGD(TAG, "Pressure: %.2f Pa, Temperature: %.2f C, Humidity: %.2f\n",
-			pressure, temperature, humidity);
+	gn_bme280_data_t *data = (gn_bme280_data_t*) gn_leaf_get_descriptor(
+			leaf_config)->data;
 
-	//store parameter and notify network
-	gn_leaf_param_force_double(leaf_config, GN_BME280_PARAM_TEMP, temperature);
-	gn_leaf_param_force_double(leaf_config, GN_BME280_PARAM_HUM, humidity);
-	gn_leaf_param_force_double(leaf_config, GN_BME280_PARAM_PRESS, pressure);
+	//the read is queued on the bus manager, together with the other sensors of the bus
+	gn_i2c_op_t op = { .type = GN_I2C_OP_CALL, .device = data->i2c_device,
+			.call = &_gn_bme280_read, .arg = data };
 
-	fail: return;
+	if (gn_i2c_batch_submit(data->i2c_bus, &op, 1, &_gn_bme280_read_done,
+			leaf_config) != GN_RET_OK)
+		gn_log(TAG, GN_LOG_ERROR, "Sensors read not queued");
 
 }
 
@@ -100,13 +126,15 @@ void gn_bme280_task(gn_leaf_handle_t leaf_config);
 gn_leaf_descriptor_handle_t gn_bme280_config(gn_leaf_handle_t leaf_config) {
 
 	gn_leaf_descriptor_handle_t descriptor =
-			(gn_leaf_descriptor_handle_t) malloc(sizeof(gn_leaf_descriptor_t));
+			(gn_leaf_descriptor_handle_t) gn_mem_malloc(
+					gn_leaf_get_mem_tag(leaf_config), sizeof(gn_leaf_descriptor_t));
 	strncpy(descriptor->type, GN_LEAF_BME280_TYPE, GN_LEAF_DESC_TYPE_SIZE);
 	descriptor->callback = gn_bme280_task;
 	descriptor->status = GN_LEAF_STATUS_NOT_INITIALIZED;
 	descriptor->data = NULL;
 
-	gn_bme280_data_t *data = malloc(sizeof(gn_bme280_data_t));
+	gn_bme280_data_t *data = gn_mem_malloc(gn_leaf_get_mem_tag(leaf_config),
+			sizeof(gn_bme280_data_t));
 
 	//parameter definition. if found in flash storage, they will be created with found values instead of default
 
@@ -149,6 +177,13 @@ gn_leaf_descriptor_handle_t gn_bme280_config(gn_leaf_handle_t leaf_config) {
 			GN_LEAF_PARAM_ACCESS_NODE, GN_LEAF_PARAM_STORAGE_VOLATILE, NULL);
 	gn_leaf_param_add_to_leaf(leaf_config, data->press_param);
 
+	data->temp_filter = gn_filter_param_create(leaf_config,
+			GN_BME280_PARAM_TEMP, "");
+	data->hum_filter = gn_filter_param_create(leaf_config, GN_BME280_PARAM_HUM,
+			"");
+	data->press_filter = gn_filter_param_create(leaf_config,
+			GN_BME280_PARAM_PRESS, "");
+
 	descriptor->status = GN_LEAF_STATUS_INITIALIZED;
 	descriptor->data = data;
 	return descriptor;
@@ -243,21 +278,29 @@ void gn_bme280_task(gn_leaf_handle_t leaf_config) {
 							(data->dev.id == BME280_CHIP_ID) ? "BME280" : "BMP280");
 					//vTaskDelay(1000 / portTICK_PERIOD_MS);
 
-					ESP_LOGD(TAG, "creating timer...");
-					//create a timer to update temps
-					esp_timer_create_args_t bme280_sensor_timer_args = {
+					ret = gn_i2c_bus_get(data->dev.i2c_dev.port, (int) sda,
+							(int) scl, &data->i2c_bus);
+					if (ret == GN_RET_OK)
+						ret = gn_i2c_device_add(data->i2c_bus,
+								&data->dev.i2c_dev, leaf_name,
+								&data->i2c_device);
+
+					ESP_LOGD(TAG, "creating sampler job...");
+					//the bus manager serializes the reads, so the job runs with the other sensors of the bus
+					gn_sampler_job_config_t bme280_sensor_job_config = {
 							.callback = &bme280_sensor_collect, .arg =
-									leaf_config, .name =
-									"leaf_bme280_sensor_collect" };
+									leaf_config, .name = leaf_name, .bus =
+									GN_SAMPLER_BUS_NONE };
 
-					ret = esp_timer_create(&bme280_sensor_timer_args,
-							&data->bme280_sensor_timer);
-					if (ret != ESP_OK) {
+					if (ret == GN_RET_OK)
+						ret = gn_sampler_job_create(&bme280_sensor_job_config,
+								&data->bme280_sensor_job);
+					if (ret != GN_RET_OK) {
 						gn_leaf_param_force_bool(leaf_config,
 								GN_BME280_PARAM_ACTIVE,
 								false);
 						gn_log(TAG, GN_LOG_ERROR,
-								"failed to init bme280 leaf timer");
+								"failed to init bme280 leaf job");
 						descriptor->status = GN_LEAF_STATUS_ERROR;
 						//return descriptor;
 					}
@@ -272,16 +315,16 @@ void gn_bme280_task(gn_leaf_handle_t leaf_config) {
 	//vTaskDelay(1000 / portTICK_PERIOD_MS);
 
 	//start timer if needed
-	if (ret == ESP_OK && active == true) {
+	if (ret == GN_RET_OK && active == true) {
 
-		ESP_LOGD(TAG, "starting timer, polling at %f sec", update_time);
+		ESP_LOGD(TAG, "starting job, polling at %f sec", update_time);
 
-		ret = esp_timer_start_periodic(data->bme280_sensor_timer,
+		ret = gn_sampler_job_start(data->bme280_sensor_job,
 				update_time * 1000000);
-		if (ret != ESP_OK) {
+		if (ret != GN_RET_OK) {
 			gn_leaf_param_force_bool(leaf_config, GN_BME280_PARAM_ACTIVE,
 					false);
-			gn_log(TAG, GN_LOG_ERROR, "failed to start bme280 leaf timer");
+			gn_log(TAG, GN_LOG_ERROR, "failed to start bme280 leaf job");
 			gn_leaf_get_descriptor(leaf_config)->status = GN_LEAF_STATUS_ERROR;
 		}
 
@@ -374,6 +417,16 @@ void gn_bme280_task(gn_leaf_handle_t leaf_config) {
 			lv_obj_set_grid_cell(label_press_value, LV_GRID_ALIGN_STRETCH, 1, 1,
 					LV_GRID_ALIGN_STRETCH, 1, 1);
 
+			//refreshed by the GUI task when the readings change
+			gn_display_binding_config_t binding = { .kind =
+					GN_DISPLAY_BINDING_LABEL, .format = "%.1f" };
+			binding.widget = label_temp_value;
+			gn_display_bind(leaf_config, GN_BME280_PARAM_TEMP, &binding);
+			binding.widget = label_hum_value;
+			gn_display_bind(leaf_config, GN_BME280_PARAM_HUM, &binding);
+			binding.widget = label_press_value;
+			gn_display_bind(leaf_config, GN_BME280_PARAM_PRESS, &binding);
+
 			ESP_LOGD(TAG, "end");
 
 		}
@@ -422,9 +475,9 @@ void gn_bme280_task(gn_leaf_handle_t leaf_config) {
 					update_time = updtime;
 
 					if (active == true) {
-						esp_timer_stop(data->bme280_sensor_timer);
+						gn_sampler_job_stop(data->bme280_sensor_job);
 
-						esp_timer_start_periodic(data->bme280_sensor_timer,
+						gn_sampler_job_start(data->bme280_sensor_job,
 								update_time * 1000000);
 					}
 
@@ -473,12 +526,16 @@ void gn_bme280_task(gn_leaf_handle_t leaf_config) {
 
 					//stop timer if false
 					if (_active == false && prev_active == true) {
-						esp_timer_stop(data->bme280_sensor_timer);
+						gn_sampler_job_stop(data->bme280_sensor_job);
 					} else if (_active == true && prev_active == false) {
-						esp_timer_start_periodic(data->bme280_sensor_timer,
+						gn_sampler_job_start(data->bme280_sensor_job,
 								update_time * 1000000);
 					}
 
+				} else if (gn_filter_param_event(data->temp_filter, &evt)
+						|| gn_filter_param_event(data->hum_filter, &evt)
+						|| gn_filter_param_event(data->press_filter, &evt)) {
+					//the new spec is applied at the next reading
 				}
 
 				break;
@@ -37,6 +37,10 @@ extern "C" {
 #include "driver/adc.h"
 #include "esp_adc_cal.h"
 
+#include "gn_adc.h"
+#include "gn_sampler.h"
+#include "gn_filter.h"
+#include "gn_calibration.h"
 #include "gn_capacitive_moisture_sensor.h"
 
 #define TAG "gn_leaf_cms"
@@ -58,7 +62,9 @@ typedef struct {
 	gn_leaf_param_handle_t upd_time_sec_param;
 	esp_adc_cal_characteristics_t *adc_chars;
 
-	esp_timer_handle_t sensor_timer;
+	gn_sampler_job_handle_t sensor_job;
+	gn_filter_handle_t act_level_filter;
+	gn_calibration_handle_t calibration;
 
 } gn_cms_data_t;
 
@@ -125,6 +131,9 @@ void gn_cms_sensor_collect(gn_leaf_handle_t leaf_config) {
 
 	ESP_LOGD(TAG, "[%s] gn_cms_sensor_collect", leaf_name);
 
+	gn_cms_data_t *data =
+			(gn_cms_data_t*) gn_leaf_get_descriptor(leaf_config)->data;
+
 	double adc_channel;
 	gn_leaf_param_get_double(leaf_config, GN_CMS_PARAM_ADC_CHANNEL,
 			&adc_channel);
@@ -142,24 +151,34 @@ void gn_cms_sensor_collect(gn_leaf_handle_t leaf_config) {
 	gn_leaf_param_get_bool(leaf_config, GN_CMS_PARAM_TRG_LOW, &trg_low);
 
 	double result = 0;
+#ifdef CONFIG_GROWNODE_ADC_SAMPLING
+	//sampled and filtered in background
+	if (gn_adc_read((int) adc_channel, &result) != GN_RET_OK) {
+		ESP_LOGD(TAG, "[%s] no samples yet", leaf_name);
+		return;
+	}
+#else
 	//Multisampling
 	for (int i = 0; i < NO_OF_SAMPLES; i++) {
 		result += adc1_get_raw((adc1_channel_t) adc_channel);
 	}
 	result /= NO_OF_SAMPLES;
+#endif
 	//Convert adc_reading to voltage in mV
 	//uint32_t voltage = esp_adc_cal_raw_to_voltage(result, adc_chars);
 	//ESP_LOGD(TAG, "Raw: %d\tVoltage: %dmV\n", result, voltage);
 
 	ESP_LOGD(TAG, "[%s] raw data: %f", leaf_name, result);
 
-	//convert to a percentage (4095 = 12 bit width * 100)
-	result = result / 40.95;
+	//installation calibration if any, otherwise a percentage (4095 = 12 bit width * 100)
+	if (!gn_calibration_apply(data->calibration, GN_CMS_PARAM_ACT_LEVEL, result,
+			&result))
+		result = result / 40.95;
 
 	ESP_LOGD(TAG, "[%s] output data: %f", leaf_name, result);
 
-	//store parameter and notify network
-	gn_leaf_param_force_double(leaf_config, GN_CMS_PARAM_ACT_LEVEL, result);
+	//filter, store parameter and notify network. triggers work on the filtered level
+	gn_filter_param_update(data->act_level_filter, result, &result);
 
 	//if level is above maximum, trigger max
 	if (result >= max_level && trg_high == false) {
@@ -192,12 +211,14 @@ gn_leaf_descriptor_handle_t gn_capacitive_moisture_sensor_config(
 	ESP_LOGD(TAG, "[%s] gn_capacitive_moisture_sensor_config", leaf_name);
 
 	gn_leaf_descriptor_handle_t descriptor =
-			(gn_leaf_descriptor_handle_t) malloc(sizeof(gn_leaf_descriptor_t));
+			(gn_leaf_descriptor_handle_t) gn_mem_malloc(
+					gn_leaf_get_mem_tag(leaf_config), sizeof(gn_leaf_descriptor_t));
 	strncpy(descriptor->type, GN_LEAF_CMS_TYPE, GN_LEAF_DESC_TYPE_SIZE);
 	descriptor->callback = gn_cms_task;
 	descriptor->status = GN_LEAF_STATUS_NOT_INITIALIZED;
 
-	gn_cms_data_t *data = malloc(sizeof(gn_cms_data_t));
+	gn_cms_data_t *data = gn_mem_malloc(gn_leaf_get_mem_tag(leaf_config),
+			sizeof(gn_cms_data_t));
 
 	data->active_param = gn_leaf_param_create(leaf_config, GN_CMS_PARAM_ACTIVE,
 			GN_VAL_TYPE_BOOLEAN, (gn_val_t ) { .b = true },
@@ -247,6 +268,12 @@ gn_leaf_descriptor_handle_t gn_capacitive_moisture_sensor_config(
 	gn_leaf_param_add_to_leaf(leaf_config, data->trg_low_param);
 	gn_leaf_param_add_to_leaf(leaf_config, data->upd_time_sec_param);
 
+	data->calibration = gn_calibration_create(leaf_config);
+	gn_calibration_param_add(data->calibration, GN_CMS_PARAM_ACT_LEVEL);
+
+	data->act_level_filter = gn_filter_param_create(leaf_config,
+			GN_CMS_PARAM_ACT_LEVEL, "");
+
 	descriptor->status = GN_LEAF_STATUS_INITIALIZED;
 	descriptor->data = data;
 	return descriptor;
@@ -297,8 +324,19 @@ void gn_cms_task(gn_leaf_handle_t leaf_config) {
 			leaf_name, unit, width, (int )adc_channel, atten);
 
 	//configure ADC
+#ifdef CONFIG_GROWNODE_ADC_SAMPLING
+	//median of the frame averages, moisture changes slowly and pump or relay spikes are dropped
+	gn_adc_channel_config_t adc_config = { .filter = GN_ADC_FILTER_MEDIAN,
+			.atten = atten, .width = width };
+	if (gn_adc_channel_add((int) adc_channel, &adc_config) != GN_RET_OK) {
+		gn_log(TAG, GN_LOG_ERROR, "[%s] failed to start ADC sampling",
+				leaf_name);
+		descriptor->status = GN_LEAF_STATUS_ERROR;
+	}
+#else
 	adc1_config_width(width);
 	adc1_config_channel_atten((int) adc_channel, atten);
+#endif
 
 	//Characterize ADC
 	data->adc_chars = calloc(1, sizeof(esp_adc_cal_characteristics_t));
@@ -413,32 +451,47 @@ void gn_cms_task(gn_leaf_handle_t leaf_config) {
 
 #endif
 
-	ESP_LOGD(TAG, "[%s] starting timer...", leaf_name);
-	//create a timer to update temps
-	const esp_timer_create_args_t water_sensor_timer_args = { .callback =
-			&gn_cms_sensor_collect, .arg = leaf_config, .name = "cms_timer" };
+	ESP_LOGD(TAG, "[%s] starting sampler job...", leaf_name);
+	//the sampling service reads the ADC in background, single conversions block the ADC
+	const gn_sampler_job_config_t water_sensor_job_config = { .callback =
+			&gn_cms_sensor_collect, .arg = leaf_config, .name = leaf_name,
+#ifdef CONFIG_GROWNODE_ADC_SAMPLING
+			.bus = GN_SAMPLER_BUS_NONE
+#else
+			.bus = GN_SAMPLER_BUS_ADC1
+#endif
+			};
 
-	ret = esp_timer_create(&water_sensor_timer_args, &data->sensor_timer);
-	if (ret != ESP_OK) {
+	ret = gn_sampler_job_create(&water_sensor_job_config, &data->sensor_job);
+	if (ret != GN_RET_OK) {
 		gn_log(TAG, GN_LOG_ERROR,
-				"[%s] failed to init capacitive moisture sensor timer",
+				"[%s] failed to init capacitive moisture sensor job",
 				leaf_name);
 	}
 
-	if (ret == ESP_OK && active == true) {
+	if (ret == GN_RET_OK && active == true) {
+
+#ifdef CONFIG_GROWNODE_ADC_SAMPLING
+		//wait for the first frames of the sampling
+		double raw;
+		for (int i = 0;
+				i < 10 && gn_adc_read((int) adc_channel, &raw) != GN_RET_OK;
+				i++)
+			vTaskDelay(pdMS_TO_TICKS(10));
+#endif
 
 		//first shot immediate
 		gn_cms_sensor_collect(leaf_config);
 
 		//then start the periodic wakeup
-		if (ret == ESP_OK) {
-			ret = esp_timer_start_periodic(data->sensor_timer,
+		if (ret == GN_RET_OK) {
+			ret = gn_sampler_job_start(data->sensor_job,
 					update_time_sec * 1000000);
 		}
 
-		if (ret != ESP_OK) {
+		if (ret != GN_RET_OK) {
 			gn_log(TAG, GN_LOG_ERROR,
-					"[%s] failed to start capacitive moisture sensor timer",
+					"[%s] failed to start capacitive moisture sensor job",
 					leaf_name);
 			gn_leaf_get_descriptor(leaf_config)->status = GN_LEAF_STATUS_ERROR;
 			gn_leaf_param_force_bool(leaf_config, GN_CMS_PARAM_ACTIVE, false);
@@ -482,8 +535,8 @@ void gn_cms_task(gn_leaf_handle_t leaf_config) {
 
 					update_time_sec = updtime;
 
-					esp_timer_stop(data->sensor_timer);
-					ret = esp_timer_start_periodic(data->sensor_timer,
+					gn_sampler_job_stop(data->sensor_job);
+					ret = gn_sampler_job_start(data->sensor_job,
 							update_time_sec * 1000000);
 
 					//execute change
@@ -507,12 +560,18 @@ void gn_cms_task(gn_leaf_handle_t leaf_config) {
 
 					//stop timer if false
 					if (_active == 0 && prev_active == true) {
-						esp_timer_stop(data->sensor_timer);
+						gn_sampler_job_stop(data->sensor_job);
 					} else if (_active != 0 && prev_active == false) {
-						esp_timer_start_periodic(data->sensor_timer,
+						gn_sampler_job_start(data->sensor_job,
 								update_time_sec * 1000000);
 					}
 
+				} else if (gn_filter_param_event(data->act_level_filter,
+						&evt)) {
+					//the new spec is applied at the next reading
+				} else if (gn_calibration_param_event(data->calibration,
+						&evt)) {
+					//the new table is applied at the next reading
 				}
 
 				break;
@@ -37,6 +37,9 @@ extern "C" {
 #include "soc/rtc_periph.h"
 #include "soc/sens_periph.h"
 
+#include "gn_sampler.h"
+#include "gn_filter.h"
+#include "gn_calibration.h"
 #include "gn_capacitive_water_level.h"
 
 #define TAG "gn_leaf_cwl"
@@ -55,7 +58,9 @@ typedef struct {
 	gn_leaf_param_handle_t trg_low_param;
 	gn_leaf_param_handle_t upd_time_sec_param;
 
-	esp_timer_handle_t sensor_timer;
+	gn_sampler_job_handle_t sensor_job;
+	gn_filter_handle_t act_level_filter;
+	gn_calibration_handle_t calibration;
 
 } gn_cwl_data_t;
 
@@ -100,8 +105,8 @@ void gn_cwl_sensor_collect(gn_leaf_handle_t leaf_config) {
 	ESP_LOGD(TAG, "[%s] gn_cwl_sensor_collect", leaf_name);
 
 	//retrieves status descriptor from config
-	//gn_cwl_data_t *data =
-	//		(gn_cwl_data_t*) gn_leaf_get_descriptor(leaf_config)->data;
+	gn_cwl_data_t *data =
+			(gn_cwl_data_t*) gn_leaf_get_descriptor(leaf_config)->data;
 
 	double channel;
 	gn_leaf_param_get_double(leaf_config, GN_CWL_PARAM_TOUCH_CHANNEL, &channel);
@@ -115,8 +120,12 @@ void gn_cwl_sensor_collect(gn_leaf_handle_t leaf_config) {
 
 	ESP_LOGD(TAG, "[%s] result: %f", leaf_name, result);
 
-	//store parameter and notify network
-	gn_leaf_param_force_double(leaf_config, GN_CWL_PARAM_ACT_LEVEL, result);
+	//installation calibration if any, otherwise the raw touch value
+	gn_calibration_apply(data->calibration, GN_CWL_PARAM_ACT_LEVEL, result,
+			&result);
+
+	//filter, store parameter and notify network. triggers work on the filtered level
+	gn_filter_param_update(data->act_level_filter, result, &result);
 
 	double max_level;
 	gn_leaf_param_get_double(leaf_config, GN_CWL_PARAM_MAX_LEVEL, &max_level);
@@ -165,12 +174,14 @@ gn_leaf_descriptor_handle_t gn_capacitive_water_level_config(
 	ESP_LOGD(TAG, "[%s] gn_capacitive_water_level_config", leaf_name);
 
 	gn_leaf_descriptor_handle_t descriptor =
-			(gn_leaf_descriptor_handle_t) malloc(sizeof(gn_leaf_descriptor_t));
+			(gn_leaf_descriptor_handle_t) gn_mem_malloc(
+					gn_leaf_get_mem_tag(leaf_config), sizeof(gn_leaf_descriptor_t));
 	strncpy(descriptor->type, GN_LEAF_CWL_TYPE, GN_LEAF_DESC_TYPE_SIZE);
 	descriptor->callback = gn_capacitive_water_level_task;
 	descriptor->status = GN_LEAF_STATUS_NOT_INITIALIZED;
 
-	gn_cwl_data_t *data = malloc(sizeof(gn_cwl_data_t));
+	gn_cwl_data_t *data = gn_mem_malloc(gn_leaf_get_mem_tag(leaf_config),
+			sizeof(gn_cwl_data_t));
 
 	data->active_param = gn_leaf_param_create(leaf_config, GN_CWL_PARAM_ACTIVE,
 			GN_VAL_TYPE_BOOLEAN, (gn_val_t ) { .b = false },
@@ -218,6 +229,12 @@ gn_leaf_descriptor_handle_t gn_capacitive_water_level_config(
 	gn_leaf_param_add_to_leaf(leaf_config, data->trg_low_param);
 	gn_leaf_param_add_to_leaf(leaf_config, data->upd_time_sec_param);
 
+	data->calibration = gn_calibration_create(leaf_config);
+	gn_calibration_param_add(data->calibration, GN_CWL_PARAM_ACT_LEVEL);
+
+	data->act_level_filter = gn_filter_param_create(leaf_config,
+			GN_CWL_PARAM_ACT_LEVEL, "");
+
 	descriptor->status = GN_LEAF_STATUS_INITIALIZED;
 	descriptor->data = data;
 	return descriptor;
@@ -385,25 +402,26 @@ void gn_capacitive_water_level_task(gn_leaf_handle_t leaf_config) {
 
 #endif
 
-	ESP_LOGD(TAG, "[%s] starting timer...", leaf_name);
-	//create a timer to update temps
-	const esp_timer_create_args_t water_sensor_timer_args = { .callback =
-			&gn_cwl_sensor_collect, .arg = leaf_config, .name = "cwl_timer" };
+	ESP_LOGD(TAG, "[%s] starting sampler job...", leaf_name);
+	//touch pads share the touch sensor controller
+	const gn_sampler_job_config_t water_sensor_job_config = { .callback =
+			&gn_cwl_sensor_collect, .arg = leaf_config, .name = leaf_name,
+			.bus = GN_SAMPLER_BUS_TOUCH };
 
-	ret = esp_timer_create(&water_sensor_timer_args, &data->sensor_timer);
-	if (ret != ESP_OK) {
+	ret = gn_sampler_job_create(&water_sensor_job_config, &data->sensor_job);
+	if (ret != GN_RET_OK) {
 		gn_log(TAG, GN_LOG_ERROR,
-				"[%s] failed to init capacitive water level timer", leaf_name);
+				"[%s] failed to init capacitive water level job", leaf_name);
 	}
 
-	if (ret == ESP_OK && active == true) {
+	if (ret == GN_RET_OK && active == true) {
 
 		//start sensor callback
-		ret = esp_timer_start_periodic(data->sensor_timer,
+		ret = gn_sampler_job_start(data->sensor_job,
 				update_time_sec * 1000000);
-		if (ret != ESP_OK) {
+		if (ret != GN_RET_OK) {
 			gn_log(TAG, GN_LOG_ERROR,
-					"[%s] failed to start capacitive water level timer", leaf_name);
+					"[%s] failed to start capacitive water level job", leaf_name);
 			gn_leaf_get_descriptor(leaf_config)->status = GN_LEAF_STATUS_ERROR;
 			gn_leaf_param_force_bool(leaf_config, GN_CWL_PARAM_ACTIVE,
 			false);
@@ -447,8 +465,8 @@ void gn_capacitive_water_level_task(gn_leaf_handle_t leaf_config) {
 
 					update_time_sec = updtime;
 
-					esp_timer_stop(data->sensor_timer);
-					ret = esp_timer_start_periodic(data->sensor_timer,
+					gn_sampler_job_stop(data->sensor_job);
+					ret = gn_sampler_job_start(data->sensor_job,
 							update_time_sec * 1000000);
 
 					//execute change
@@ -472,12 +490,18 @@ void gn_capacitive_water_level_task(gn_leaf_handle_t leaf_config) {
 
 					//stop timer if false
 					if (_active == 0 && prev_active == true) {
-						esp_timer_stop(data->sensor_timer);
+						gn_sampler_job_stop(data->sensor_job);
 					} else if (_active != 0 && prev_active == false) {
-						esp_timer_start_periodic(data->sensor_timer,
+						gn_sampler_job_start(data->sensor_job,
 								update_time_sec * 1000000);
 					}
 
+				} else if (gn_filter_param_event(data->act_level_filter,
+						&evt)) {
+					//the new spec is applied at the next reading
+				} else if (gn_calibration_param_event(data->calibration,
+						&evt)) {
+					//the new table is applied at the next reading
 				}
 
 				break;
@@ -27,6 +27,7 @@ extern "C" {
 #include "lvgl/lvgl.h"
 #endif
 #include "lvgl_helpers.h"
+#include "gn_display_binding.h"
 #endif
 
 #include "ds18x20.h"
@@ -36,6 +37,7 @@ extern "C" {
 
 const size_t GN_DS18B20_STATE_STOP = 0;
 const size_t GN_DS18B20_STATE_RUNNING = 1;
+const size_t GN_DS18B20_STATE_CONVERTING = 2;
 
 void gn_ds18b20_task(gn_leaf_handle_t leaf_config);
 
@@ -72,13 +74,20 @@ typedef struct {
 	ds18x20_addr_t addrs[GN_DS18B20_MAX_SENSORS];
 	float temp[GN_DS18B20_MAX_SENSORS];
 
-	esp_timer_handle_t sensor_timer;
+	//conversions are scheduled by the leaf task, the timer task is never blocked by the bus
+	size_t state;
+	int64_t next_conversion_us;
+	int64_t conversion_end_us;
+	uint32_t conversion_ms;
+	bool resolution_changed;
+	bool parasitic;
 
 	gn_leaf_param_handle_t temp_param[GN_DS18B20_MAX_SENSORS];
 	gn_leaf_param_handle_t update_time_param;
 	gn_leaf_param_handle_t gpio_param;
 	gn_leaf_param_handle_t active_param;
 	gn_leaf_param_handle_t parasitic_param;
+	gn_leaf_param_handle_t resolution_param;
 
 } gn_ds18b20_data_t;
 
@@ -93,12 +102,10 @@ gn_leaf_param_validator_result_t _gn_upd_time_sec_validator(
 	ESP_LOGD(TAG, "_gn_upd_time_sec_validator - param: %d", (int )_p1);
 
 	if (GN_DS18B20_MIN_UPDATE_TIME_SEC > **(double**) param_value) {
-		memcpy(param_value, &GN_DS18B20_MIN_UPDATE_TIME_SEC,
-				sizeof(GN_DS18B20_MIN_UPDATE_TIME_SEC));
+		**(double**) param_value = GN_DS18B20_MIN_UPDATE_TIME_SEC;
 		return GN_LEAF_PARAM_VALIDATOR_ERROR_BELOW_MIN;
 	} else if (GN_DS18B20_MAX_UPDATE_TIME_SEC < **(double**) param_value) {
-		memcpy(param_value, &GN_DS18B20_MAX_UPDATE_TIME_SEC,
-				sizeof(GN_DS18B20_MAX_UPDATE_TIME_SEC));
+		**(double**) param_value = GN_DS18B20_MAX_UPDATE_TIME_SEC;
 		return GN_LEAF_PARAM_VALIDATOR_ERROR_ABOVE_MAX;
 	}
 
@@ -109,6 +116,25 @@ gn_leaf_param_validator_result_t _gn_upd_time_sec_validator(
 
 }
 
+gn_leaf_param_validator_result_t _gn_resolution_validator(
+		gn_leaf_param_handle_t param, void **param_value) {
+
+	double val = **(double**) param_value;
+
+	if (GN_DS18B20_MIN_RESOLUTION > val) {
+		**(double**) param_value = GN_DS18B20_MIN_RESOLUTION;
+		return GN_LEAF_PARAM_VALIDATOR_ERROR_BELOW_MIN;
+	} else if (GN_DS18B20_MAX_RESOLUTION < val) {
+		**(double**) param_value = GN_DS18B20_MAX_RESOLUTION;
+		return GN_LEAF_PARAM_VALIDATOR_ERROR_ABOVE_MAX;
+	}
+
+	//whole bits only
+	**(double**) param_value = (int) val;
+	return GN_LEAF_PARAM_VALIDATOR_PASSED;
+
+}
+
 gn_leaf_handle_t gn_ds18b20_fastcreate(gn_node_handle_t node,
 		const char *leaf_name, double gpio, double update_time_sec) {
 
@@ -152,69 +178,144 @@ gn_leaf_handle_t gn_ds18b20_fastcreate(gn_node_handle_t node,
 
 }
 
-void gn_ds18b20_temp_sensor_collect(gn_leaf_handle_t leaf_config) {
+void _gn_ds18b20_fail(gn_leaf_handle_t leaf_config, const char *what,
+		esp_err_t res) {
 
 	char leaf_name[GN_LEAF_NAME_SIZE];
 	gn_leaf_get_name(leaf_config, leaf_name);
 
-	ESP_LOGD(TAG, "[%s] gn_ds18b20_temp_sensor_collect", leaf_name);
+	gn_ds18b20_data_t *data = (gn_ds18b20_data_t*) gn_leaf_get_descriptor(
+			leaf_config)->data;
+
+	gn_log(TAG, GN_LOG_ERROR, "[%s] sensors %s error %d (%s)", leaf_name, what,
+			res, esp_err_to_name(res));
+	gn_leaf_get_descriptor(leaf_config)->status = GN_LEAF_STATUS_ERROR;
+	gn_leaf_param_force_bool(leaf_config, GN_DS18B20_PARAM_ACTIVE, false);
+	data->state = GN_DS18B20_STATE_STOP;
+
+}
+
+/**
+ * @brief	writes the resolution in the configuration register of every DS18B20 on the bus.
+ * the register is not copied to the sensor EEPROM, it is written again at each start
+ */
+void _gn_ds18b20_set_resolution(gn_leaf_handle_t leaf_config, int gpio) {
 
-	//struct leaf_data *data = (struct leaf_data*) arg;
+	char leaf_name[GN_LEAF_NAME_SIZE];
+	gn_leaf_get_name(leaf_config, leaf_name);
 
 	gn_ds18b20_data_t *data = (gn_ds18b20_data_t*) gn_leaf_get_descriptor(
 			leaf_config)->data;
 
-	esp_err_t res;
+	double resolution;
+	gn_leaf_param_get_double(leaf_config, GN_DS18B20_PARAM_RESOLUTION,
+			&resolution);
+	int shift = GN_DS18B20_MAX_RESOLUTION - (int) resolution;
 
-	bool active;
-	gn_leaf_param_get_bool(leaf_config, GN_DS18B20_PARAM_ACTIVE, &active);
+	//R1 R0 bits, the others read as one
+	uint8_t config = ((3 - shift) << 5) | 0x1f;
 
-	double gpio;
-	gn_leaf_param_get_double(leaf_config, GN_DS18B20_PARAM_GPIO, &gpio);
+	//93.75 ms at 9 bits, doubling up to 750 ms at 12 bits
+	data->conversion_ms = ((750000 >> shift) + 999) / 1000;
 
-	bool parasitic;
-	gn_leaf_param_get_bool(leaf_config, GN_DS18B20_PARAM_PARASITIC, &parasitic);
+	for (int i = 0; i < data->sensor_count; i++) {
 
-	if (active == true) {
+		//the DS18S20 has a fixed resolution and always takes 750 ms
+		if ((data->addrs[i] & 0xff) != DS18B20_FAMILY_ID) {
+			data->conversion_ms = 750;
+			continue;
+		}
 
-		ESP_LOGD(TAG, "[%s] reading from GPIO %d..", leaf_name, (int )gpio);
+		uint8_t scratchpad[9];
+		esp_err_t res = ds18x20_read_scratchpad(gpio, data->addrs[i],
+				scratchpad);
+		if (res == ESP_OK && scratchpad[4] == config)
+			continue;
+
+		//alarm thresholds are written back unchanged
+		uint8_t regs[3] = { scratchpad[2], scratchpad[3], config };
+		if (res == ESP_OK)
+			res = ds18x20_write_scratchpad(gpio, data->addrs[i], regs);
+		if (res != ESP_OK)
+			gn_log(TAG, GN_LOG_WARNING,
+					"[%s] cannot set resolution of sensor %d: %s", leaf_name,
+					i, esp_err_to_name(res));
 
-		for (int i = 0; i < GN_DS18B20_MAX_SENSORS; i++) {
-			if (data->addrs[i])
-				ds18x20_measure(gpio, data->addrs[i], parasitic);
-		}
-		//read data from sensors using GPIO parameter
-		res = ds18x20_read_temp_multi(gpio, data->addrs, data->sensor_count,
-				data->temp);
-
-		if (res != ESP_OK) {
-			gn_log(TAG, GN_LOG_ERROR, "[%s] sensors read error %d (%s)",
-					leaf_name, res, esp_err_to_name(res));
-			gn_leaf_get_descriptor(leaf_config)->status = GN_LEAF_STATUS_ERROR;
-			gn_leaf_param_force_bool(leaf_config, GN_DS18B20_PARAM_ACTIVE,
-			false);
-			esp_timer_stop(data->sensor_timer);
-			goto fail;
-		}
+	}
 
-		for (int j = 0; j < data->sensor_count; j++) {
-			float temp_c = data->temp[j];
-			float temp_f = (temp_c * 1.8) + 32;
-			ESP_LOGD(TAG,
-					"[%s] sensor %08x%08x (%s) reports %.3f �C (%.3f �F)",
-					leaf_name, (uint32_t )(data->addrs[j] >> 32),
-					(uint32_t )data->addrs[j],
-					(data->addrs[j] & 0xff) == DS18B20_FAMILY_ID ? "DS18B20" : "DS18S20",
-					temp_c, temp_f);
-
-			//store parameter and notify network
-			gn_leaf_param_force_double(leaf_config,
-					GN_DS18B20_PARAM_SENSOR_NAMES[j], temp_c);
-		}
+	ESP_LOGD(TAG, "[%s] resolution %d bits, conversion %d ms", leaf_name,
+			(int ) resolution, data->conversion_ms);
+
+}
+
+/**
+ * @brief	starts the conversion on all sensors of the bus with a single skip ROM command.
+ * the driver holds the strong pull-up needed by parasitic sensors until the conversion is read,
+ * externally powered sensors get the bus released right away
+ */
+void _gn_ds18b20_convert(gn_leaf_handle_t leaf_config, int gpio) {
+
+	gn_ds18b20_data_t *data = (gn_ds18b20_data_t*) gn_leaf_get_descriptor(
+			leaf_config)->data;
 
-		fail: return;
+	if (data->sensor_count == 0)
+		return;
 
+	esp_err_t res = ds18x20_measure(gpio, DS18X20_ANY, false);
+	if (res != ESP_OK) {
+		onewire_depower(gpio);
+		_gn_ds18b20_fail(leaf_config, "conversion", res);
+		return;
 	}
+
+	if (!data->parasitic)
+		onewire_depower(gpio);
+
+	data->conversion_end_us = esp_timer_get_time()
+			+ data->conversion_ms * 1000LL;
+	data->state = GN_DS18B20_STATE_CONVERTING;
+
+}
+
+/**
+ * @brief	reads the scratchpads of all sensors once the conversion is complete
+ */
+void _gn_ds18b20_read(gn_leaf_handle_t leaf_config, int gpio) {
+
+	char leaf_name[GN_LEAF_NAME_SIZE];
+	gn_leaf_get_name(leaf_config, leaf_name);
+
+	gn_ds18b20_data_t *data = (gn_ds18b20_data_t*) gn_leaf_get_descriptor(
+			leaf_config)->data;
+
+	onewire_depower(gpio);
+	data->state = GN_DS18B20_STATE_RUNNING;
+
+	ESP_LOGD(TAG, "[%s] reading from GPIO %d..", leaf_name, gpio);
+
+	esp_err_t res = ds18x20_read_temp_multi(gpio, data->addrs,
+			data->sensor_count, data->temp);
+
+	if (res != ESP_OK) {
+		_gn_ds18b20_fail(leaf_config, "read", res);
+		return;
+	}
+
+	for (int j = 0; j < data->sensor_count; j++) {
+		float temp_c = data->temp[j];
+		float temp_f = (temp_c * 1.8) + 32;
+		ESP_LOGD(TAG,
+				"[%s] sensor %08x%08x (%s) reports %.3f �C (%.3f �F)",
+				leaf_name, (uint32_t )(data->addrs[j] >> 32),
+				(uint32_t )data->addrs[j],
+				(data->addrs[j] & 0xff) == DS18B20_FAMILY_ID ? "DS18B20" : "DS18S20",
+				temp_c, temp_f);
+
+		//store parameter and notify network
+		gn_leaf_param_force_double(leaf_config,
+				GN_DS18B20_PARAM_SENSOR_NAMES[j], temp_c);
+	}
+
 }
 
 gn_leaf_descriptor_handle_t gn_ds18b20_config(gn_leaf_handle_t leaf_config) {
@@ -225,15 +326,20 @@ gn_leaf_descriptor_handle_t gn_ds18b20_config(gn_leaf_handle_t leaf_config) {
 	ESP_LOGD(TAG, "[%s] gn_ds18b20_config", leaf_name);
 
 	gn_leaf_descriptor_handle_t descriptor =
-			(gn_leaf_descriptor_handle_t) malloc(sizeof(gn_leaf_descriptor_t));
+			(gn_leaf_descriptor_handle_t) gn_mem_malloc(
+					gn_leaf_get_mem_tag(leaf_config), sizeof(gn_leaf_descriptor_t));
 	strncpy(descriptor->type, GN_LEAF_DS18B20_TYPE, GN_LEAF_DESC_TYPE_SIZE);
 	descriptor->callback = gn_ds18b20_task;
 	descriptor->status = GN_LEAF_STATUS_NOT_INITIALIZED;
 	descriptor->data = NULL;
 
-	gn_ds18b20_data_t *data = malloc(sizeof(gn_ds18b20_data_t));
+	gn_ds18b20_data_t *data = gn_mem_malloc(gn_leaf_get_mem_tag(leaf_config),
+			sizeof(gn_ds18b20_data_t));
 
 	data->sensor_count = 0;
+	data->state = GN_DS18B20_STATE_STOP;
+	data->resolution_changed = false;
+	data->conversion_ms = 750;
 
 	//parameter definition. if found in flash storage, they will be created with found values instead of default
 
@@ -272,6 +378,13 @@ gn_leaf_descriptor_handle_t gn_ds18b20_config(gn_leaf_handle_t leaf_config) {
 			GN_LEAF_PARAM_STORAGE_PERSISTED, NULL);
 	gn_leaf_param_add_to_leaf(leaf_config, data->parasitic_param);
 
+	//12 bits by default, lower resolutions convert faster
+	data->resolution_param = gn_leaf_param_create(leaf_config,
+			GN_DS18B20_PARAM_RESOLUTION, GN_VAL_TYPE_DOUBLE, (gn_val_t ) { .d =
+					GN_DS18B20_MAX_RESOLUTION }, GN_LEAF_PARAM_ACCESS_ALL,
+			GN_LEAF_PARAM_STORAGE_PERSISTED, _gn_resolution_validator);
+	gn_leaf_param_add_to_leaf(leaf_config, data->resolution_param);
+
 	descriptor->status = GN_LEAF_STATUS_INITIALIZED;
 	descriptor->data = data;
 	return descriptor;
@@ -300,6 +413,9 @@ void gn_ds18b20_task(gn_leaf_handle_t leaf_config) {
 	gn_leaf_param_get_double(leaf_config, GN_DS18B20_PARAM_UPDATE_TIME_SEC,
 			&update_time_sec);
 
+	gn_leaf_param_get_bool(leaf_config, GN_DS18B20_PARAM_PARASITIC,
+			&data->parasitic);
+
 	ESP_LOGD(TAG, "[%s] gn_ds18b20_task", leaf_name);
 
 	//init sensors
@@ -308,39 +424,12 @@ void gn_ds18b20_task(gn_leaf_handle_t leaf_config) {
 	//gpio_set_pull_mode(gpio, GPIO_PULLUP_ONLY);
 
 	_scan_sensors(gpio, &data->sensor_count, &data->addrs[0]);
+	_gn_ds18b20_set_resolution(leaf_config, gpio);
 
-	//create a timer to update temps
-	esp_timer_create_args_t sensor_timer_args = { .callback =
-			&gn_ds18b20_temp_sensor_collect, .arg = leaf_config, .name =
-			"ds18b20_periodic" };
-
-	esp_err_t ret = esp_timer_create(&sensor_timer_args, &data->sensor_timer);
-	if (ret != ESP_OK) {
-		gn_log(TAG, GN_LOG_ERROR, "[%s] failed to init ds18b20 leaf timer",
-				leaf_name);
-		descriptor->status = GN_LEAF_STATUS_ERROR;
-	}
-
-	if (ret == ESP_OK && active == true) {
-
-		//first shot immediate
-		gn_ds18b20_temp_sensor_collect(leaf_config);
-
-		//then start the periodic wakeup
-		if (ret == ESP_OK) {
-			ret = esp_timer_start_periodic(data->sensor_timer,
-					update_time_sec * 1000000);
-		}
-
-		if (ret != ESP_OK) {
-			gn_log(TAG, GN_LOG_ERROR, "[%s] failed to start ds18b20 leaf timer",
-					leaf_name);
-			gn_leaf_get_descriptor(leaf_config)->status = GN_LEAF_STATUS_ERROR;
-			gn_leaf_param_force_bool(data->active_param,
-					GN_DS18B20_PARAM_ACTIVE,
-					false);
-			descriptor->status = GN_LEAF_STATUS_ERROR;
-		}
+	//first shot immediate
+	if (active == true) {
+		data->state = GN_DS18B20_STATE_RUNNING;
+		data->next_conversion_us = esp_timer_get_time();
 	}
 
 	//setup screen, if defined in sdkconfig
@@ -418,6 +507,13 @@ void gn_ds18b20_task(gn_leaf_handle_t leaf_config) {
 				lv_obj_set_grid_cell(label_temp[i], LV_GRID_ALIGN_STRETCH, 1, 1,
 						LV_GRID_ALIGN_STRETCH, i + 1, 1);
 
+				//refreshed by the GUI task when the temperature changes
+				gn_display_binding_config_t binding = { .kind =
+						GN_DISPLAY_BINDING_LABEL, .widget = label_temp[i],
+						.format = "%4.2f" };
+				gn_display_bind(leaf_config, GN_DS18B20_PARAM_SENSOR_NAMES[i],
+						&binding);
+
 				//lv_obj_align_to(label_temp[i], label_temp_names[i],
 				//		LV_ALIGN_RIGHT_MID, 0, 5);
 
@@ -432,9 +528,19 @@ void gn_ds18b20_task(gn_leaf_handle_t leaf_config) {
 	//task cycle
 	while (true) {
 
-		//check for messages and cycle every 100ms
-		if (xQueueReceive(gn_leaf_get_event_queue(leaf_config), &evt,
-				pdMS_TO_TICKS(100)) == pdPASS) {
+		//sleeps until the next event, the end of the conversion or the next one
+		TickType_t wait = portMAX_DELAY;
+		if (data->state != GN_DS18B20_STATE_STOP) {
+			int64_t deadline =
+					data->state == GN_DS18B20_STATE_CONVERTING ?
+							data->conversion_end_us : data->next_conversion_us;
+			int64_t wait_ms = (deadline - esp_timer_get_time() + 999) / 1000;
+			wait = wait_ms > 0 ?
+					(wait_ms + portTICK_PERIOD_MS - 1) / portTICK_PERIOD_MS : 0;
+		}
+
+		if (xQueueReceive(gn_leaf_get_event_queue(leaf_config), &evt, wait)
+				== pdPASS) {
 
 			//event arrived for this node
 			switch (evt.id) {
@@ -502,12 +608,12 @@ void gn_ds18b20_task(gn_leaf_handle_t leaf_config) {
 
 					gn_leaf_param_force_double(leaf_config,
 							GN_DS18B20_PARAM_UPDATE_TIME_SEC, updtime);
+					gn_leaf_param_get_double(leaf_config,
+							GN_DS18B20_PARAM_UPDATE_TIME_SEC, &update_time_sec);
 
-					if (active == true) {
-					esp_timer_stop(data->sensor_timer);
-					esp_timer_start_periodic(data->sensor_timer,
-							update_time_sec * 1000000);
-					}
+					//period restarts from now
+					data->next_conversion_us = esp_timer_get_time()
+							+ update_time_sec * 1000000;
 
 				} else if (gn_leaf_event_mask_param(&evt, data->active_param)
 						== 0) {
@@ -523,14 +629,30 @@ void gn_ds18b20_task(gn_leaf_handle_t leaf_config) {
 							GN_DS18B20_PARAM_ACTIVE, _active);
 					active = _active;
 
-					//stop timer if false
+					//a running conversion is abandoned
 					if (_active == 0 && prev_active == true) {
-						esp_timer_stop(data->sensor_timer);
+						if (data->state == GN_DS18B20_STATE_CONVERTING)
+							onewire_depower(gpio);
+						data->state = GN_DS18B20_STATE_STOP;
 					} else if (_active != 0 && prev_active == false) {
-						esp_timer_start_periodic(data->sensor_timer,
-								update_time_sec * 1000000);
+						data->state = GN_DS18B20_STATE_RUNNING;
+						data->next_conversion_us = esp_timer_get_time();
 					}
 
+				} else if (gn_leaf_event_mask_param(&evt,
+						data->resolution_param) == 0) {
+
+					double resolution;
+					if (gn_event_payload_to_double(evt, &resolution)
+							!= GN_RET_OK) {
+						break;
+					}
+
+					//written to the sensors before the next conversion
+					gn_leaf_param_force_double(leaf_config,
+							GN_DS18B20_PARAM_RESOLUTION, resolution);
+					data->resolution_changed = true;
+
 				}
 
 				break;
@@ -540,23 +662,28 @@ void gn_ds18b20_task(gn_leaf_handle_t leaf_config) {
 
 			}
 
-#ifdef CONFIG_GROWNODE_DISPLAY_ENABLED
-		//update GUI
-		if (pdTRUE == gn_display_leaf_refresh_start()) {
-			for (int i = 0; i < data->sensor_count; i++) {
-				char _p[21];
+		}
 
-				double temp;
-				gn_leaf_param_get_double(leaf_config, GN_DS18B20_PARAM_SENSOR_NAMES[i], &temp);
+		int64_t now = esp_timer_get_time();
 
-				snprintf(_p, 20, "%4.2f", temp);
-				lv_label_set_text(label_temp[i], _p);
-			}
-			gn_display_leaf_refresh_end();
+		if (data->state == GN_DS18B20_STATE_CONVERTING
+				&& now >= data->conversion_end_us) {
+			_gn_ds18b20_read(leaf_config, gpio);
 		}
-#endif
 
-			vTaskDelay(1000 / portTICK_PERIOD_MS);
+		if (data->state == GN_DS18B20_STATE_RUNNING
+				&& now >= data->next_conversion_us) {
+
+			if (data->resolution_changed) {
+				_gn_ds18b20_set_resolution(leaf_config, gpio);
+				data->resolution_changed = false;
+			}
+
+			data->next_conversion_us += update_time_sec * 1000000;
+			if (data->next_conversion_us <= now)
+				data->next_conversion_us = now + update_time_sec * 1000000;
+
+			_gn_ds18b20_convert(leaf_config, gpio);
 
 		}
 
@@ -29,13 +29,17 @@ static const char GN_LEAF_DS18B20_TYPE[] = "ds18b20";
 static const int32_t GN_DS18B20_MIN_UPDATE_TIME_SEC = 3;
 static const int32_t GN_DS18B20_MAX_UPDATE_TIME_SEC = 3600;
 
+static const int32_t GN_DS18B20_MIN_RESOLUTION = 9;
+static const int32_t GN_DS18B20_MAX_RESOLUTION = 12;
+
 //parameters
 static const char GN_DS18B20_PARAM_ACTIVE[] = "active"; /*!< whether the sensor is running*/
 static const char GN_DS18B20_PARAM_UPDATE_TIME_SEC[16] = "upd_time_sec"; /*!< seconds between sensor sampling */
 static const char GN_DS18B20_PARAM_GPIO[5] = "gpio"; /*!< GPIO connected to the temp sensor */
 static const char GN_DS18B20_PARAM_SENSOR_NAMES[GN_DS18B20_MAX_SENSORS][6] = { "temp1", "temp2",
 		"temp3", "temp4" };
-static const char GN_DS18B20_PARAM_PARASITIC[] = "parasitic"; /*!< whether to use the parasitic mode. */
+static const char GN_DS18B20_PARAM_PARASITIC[] = "parasitic"; /*!< whether the sensors are parasitic powered: the strong pull-up is held during the conversion. read at leaf start */
+static const char GN_DS18B20_PARAM_RESOLUTION[] = "resolution"; /*!< conversion bits, 9 (94 ms) to 12 (750 ms). */
 
 gn_leaf_descriptor_handle_t gn_ds18b20_config(gn_leaf_handle_t leaf_config);
 
@@ -104,12 +104,14 @@ gn_leaf_descriptor_handle_t gn_gpio_config(gn_leaf_handle_t leaf_config) {
 	ESP_LOGD(TAG, "[%s] gn_gpio_config", leaf_name);
 
 	gn_leaf_descriptor_handle_t descriptor =
-			(gn_leaf_descriptor_handle_t) malloc(sizeof(gn_leaf_descriptor_t));
+			(gn_leaf_descriptor_handle_t) gn_mem_malloc(
+					gn_leaf_get_mem_tag(leaf_config), sizeof(gn_leaf_descriptor_t));
 	strncpy(descriptor->type, GN_LEAF_GPIO_TYPE, GN_LEAF_DESC_TYPE_SIZE);
 	descriptor->callback = gn_gpio_task;
 	descriptor->status = GN_LEAF_STATUS_NOT_INITIALIZED;
 
-	gn_gpio_data_t *data = malloc(sizeof(gn_gpio_data_t));
+	gn_gpio_data_t *data = gn_mem_malloc(gn_leaf_get_mem_tag(leaf_config),
+			sizeof(gn_gpio_data_t));
 
 	data->gn_gpio_toggle_param = gn_leaf_param_create(leaf_config,
 			GN_GPIO_PARAM_TOGGLE, GN_VAL_TYPE_BOOLEAN,
@@ -0,0 +1,660 @@
+// Copyright 2021 Nicola Muratori (nicola.muratori@gmail.com)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <sys/time.h>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "lwip/sockets.h"
+
+#include "gn_commons.h"
+
+#include "gn_leaf_exporter.h"
+
+#define TAG "gn_leaf_exporter"
+
+#define IP_STRING_SIZE 16
+
+#define GN_LEAF_EXPORTER_FILTER_SIZE 128
+#define GN_LEAF_EXPORTER_SELECTORS 8
+
+//points buffered between the producers and the leaf task
+#define GN_LEAF_EXPORTER_QUEUE_SIZE 128
+//longest value kept for a point, longer strings are truncated
+#define GN_LEAF_EXPORTER_VALUE_SIZE 32
+//pending points that trigger a flush before the interval expires
+#define GN_LEAF_EXPORTER_BATCH_SIZE 16
+
+//UDP payload fitting a 1500 bytes ethernet MTU after IP and UDP headers
+#define GN_LEAF_EXPORTER_DATAGRAM_SIZE 1472
+#define GN_LEAF_EXPORTER_LINE_SIZE 192
+
+#define GN_LEAF_EXPORTER_POLL_MS 20
+#define GN_LEAF_EXPORTER_RETRY_US 5000000
+#define GN_LEAF_EXPORTER_STATS_INTERVAL_US 10000000
+
+typedef enum {
+	GN_LEAF_EXPORTER_FORMAT_INFLUX = 0, GN_LEAF_EXPORTER_FORMAT_GRAPHITE = 1
+} gn_leaf_exporter_format_t;
+
+typedef struct {
+	int64_t ts; /*!< esp_timer time of the change, in usec */
+	char leaf_name[GN_LEAF_NAME_SIZE];
+	char param_name[GN_LEAF_PARAM_NAME_SIZE];
+	char value[GN_LEAF_EXPORTER_VALUE_SIZE]; /*!< event payload, as posted by the param writer */
+} gn_leaf_exporter_point_t;
+
+typedef struct {
+	char leaf_name[GN_LEAF_NAME_SIZE]; /*!< "*" for any leaf */
+	char param_name[GN_LEAF_PARAM_NAME_SIZE]; /*!< "*" for any param */
+} gn_leaf_exporter_selector_t;
+
+typedef struct {
+	gn_leaf_param_handle_t gn_leaf_exporter_active_param;
+	gn_leaf_param_handle_t gn_leaf_exporter_ip_param;
+	gn_leaf_param_handle_t gn_leaf_exporter_port_param;
+	gn_leaf_param_handle_t gn_leaf_exporter_format_param;
+	gn_leaf_param_handle_t gn_leaf_exporter_filter_param;
+	gn_leaf_param_handle_t gn_leaf_exporter_flush_interval_param;
+	gn_leaf_param_handle_t gn_leaf_exporter_sent_param;
+	gn_leaf_param_handle_t gn_leaf_exporter_dropped_param;
+
+	char leaf_name[GN_LEAF_NAME_SIZE];
+
+	//shared with the event handler, protected by lock
+	portMUX_TYPE lock;
+	bool active;
+	gn_leaf_exporter_selector_t selectors[GN_LEAF_EXPORTER_SELECTORS];
+	int selectors_len;
+	gn_leaf_exporter_point_t *queue;
+	uint32_t head;
+	uint32_t tail;
+	uint32_t dropped;
+
+} gn_leaf_exporter_data_t;
+
+void gn_leaf_exporter_task(gn_leaf_handle_t leaf_config);
+
+gn_leaf_descriptor_handle_t gn_leaf_exporter_config(
+		gn_leaf_handle_t leaf_config) {
+
+	ESP_LOGD(TAG, "exporter configuring..");
+
+	gn_leaf_descriptor_handle_t descriptor =
+			(gn_leaf_descriptor_handle_t) gn_mem_malloc(
+					gn_leaf_get_mem_tag(leaf_config), sizeof(gn_leaf_descriptor_t));
+	strncpy(descriptor->type, GN_LEAF_EXPORTER_TYPE, GN_LEAF_DESC_TYPE_SIZE);
+	descriptor->callback = gn_leaf_exporter_task;
+	descriptor->status = GN_LEAF_STATUS_NOT_INITIALIZED;
+
+	gn_leaf_exporter_data_t *data = gn_mem_malloc(
+			gn_leaf_get_mem_tag(leaf_config), sizeof(gn_leaf_exporter_data_t));
+	memset(data, 0, sizeof(gn_leaf_exporter_data_t));
+	portMUX_INITIALIZE(&data->lock);
+	gn_leaf_get_name(leaf_config, data->leaf_name);
+
+	data->gn_leaf_exporter_active_param = gn_leaf_param_create(leaf_config,
+			GN_LEAF_EXPORTER_PARAM_ACTIVE, GN_VAL_TYPE_BOOLEAN, (gn_val_t ) {
+							.b = true }, GN_LEAF_PARAM_ACCESS_ALL,
+			GN_LEAF_PARAM_STORAGE_PERSISTED, gn_validator_boolean);
+
+	data->gn_leaf_exporter_ip_param = gn_leaf_param_create(leaf_config,
+			GN_LEAF_EXPORTER_PARAM_IP, GN_VAL_TYPE_STRING,
+			(gn_val_t ) { .s = "" }, GN_LEAF_PARAM_ACCESS_ALL,
+			GN_LEAF_PARAM_STORAGE_PERSISTED, NULL);
+
+	data->gn_leaf_exporter_port_param = gn_leaf_param_create(leaf_config,
+			GN_LEAF_EXPORTER_PARAM_PORT, GN_VAL_TYPE_DOUBLE, (gn_val_t ) {
+							.d = 8094 }, GN_LEAF_PARAM_ACCESS_ALL,
+			GN_LEAF_PARAM_STORAGE_PERSISTED, gn_validator_double_positive);
+
+	data->gn_leaf_exporter_format_param = gn_leaf_param_create(leaf_config,
+			GN_LEAF_EXPORTER_PARAM_FORMAT, GN_VAL_TYPE_DOUBLE, (gn_val_t ) {
+							.d = GN_LEAF_EXPORTER_FORMAT_INFLUX },
+			GN_LEAF_PARAM_ACCESS_ALL, GN_LEAF_PARAM_STORAGE_PERSISTED,
+			gn_validator_double_positive);
+
+	data->gn_leaf_exporter_filter_param = gn_leaf_param_create(leaf_config,
+			GN_LEAF_EXPORTER_PARAM_FILTER, GN_VAL_TYPE_STRING, (gn_val_t ) {
+							.s = "*" }, GN_LEAF_PARAM_ACCESS_ALL,
+			GN_LEAF_PARAM_STORAGE_PERSISTED, NULL);
+
+	data->gn_leaf_exporter_flush_interval_param = gn_leaf_param_create(
+			leaf_config, GN_LEAF_EXPORTER_PARAM_FLUSH_INTERVAL,
+			GN_VAL_TYPE_DOUBLE, (gn_val_t ) { .d = 1000 },
+			GN_LEAF_PARAM_ACCESS_ALL, GN_LEAF_PARAM_STORAGE_PERSISTED,
+			gn_validator_double_positive);
+
+	data->gn_leaf_exporter_sent_param = gn_leaf_param_create(leaf_config,
+			GN_LEAF_EXPORTER_PARAM_SENT, GN_VAL_TYPE_DOUBLE,
+			(gn_val_t ) { .d = 0 }, GN_LEAF_PARAM_ACCESS_NODE,
+			GN_LEAF_PARAM_STORAGE_VOLATILE, NULL);
+
+	data->gn_leaf_exporter_dropped_param = gn_leaf_param_create(leaf_config,
+			GN_LEAF_EXPORTER_PARAM_DROPPED, GN_VAL_TYPE_DOUBLE,
+			(gn_val_t ) { .d = 0 }, GN_LEAF_PARAM_ACCESS_NODE,
+			GN_LEAF_PARAM_STORAGE_VOLATILE, NULL);
+
+	gn_leaf_param_add_to_leaf(leaf_config, data->gn_leaf_exporter_active_param);
+	gn_leaf_param_add_to_leaf(leaf_config, data->gn_leaf_exporter_ip_param);
+	gn_leaf_param_add_to_leaf(leaf_config, data->gn_leaf_exporter_port_param);
+	gn_leaf_param_add_to_leaf(leaf_config, data->gn_leaf_exporter_format_param);
+	gn_leaf_param_add_to_leaf(leaf_config, data->gn_leaf_exporter_filter_param);
+	gn_leaf_param_add_to_leaf(leaf_config,
+			data->gn_leaf_exporter_flush_interval_param);
+	gn_leaf_param_add_to_leaf(leaf_config, data->gn_leaf_exporter_sent_param);
+	gn_leaf_param_add_to_leaf(leaf_config,
+			data->gn_leaf_exporter_dropped_param);
+
+	descriptor->status = GN_LEAF_STATUS_INITIALIZED;
+	descriptor->data = data;
+	return descriptor;
+
+}
+
+/**
+ * @brief	parses the comma separated leaf.param selectors, a selector without dot selects all the params of the leaf
+ */
+static void _gn_leaf_exporter_set_filter(gn_leaf_exporter_data_t *data,
+		const char *filter) {
+
+	gn_leaf_exporter_selector_t selectors[GN_LEAF_EXPORTER_SELECTORS];
+	int len = 0;
+
+	const char *p = filter;
+	while (*p && len < GN_LEAF_EXPORTER_SELECTORS) {
+
+		while (*p == ' ' || *p == ',')
+			p++;
+		if (!*p)
+			break;
+
+		size_t n = strcspn(p, ",");
+		const char *dot = memchr(p, '.', n);
+		size_t leaf_len = dot ? (size_t) (dot - p) : n;
+		size_t param_len = dot ? n - leaf_len - 1 : 1;
+
+		if (leaf_len > 0 && leaf_len < GN_LEAF_NAME_SIZE && param_len > 0
+				&& param_len < GN_LEAF_PARAM_NAME_SIZE) {
+			memcpy(selectors[len].leaf_name, p, leaf_len);
+			selectors[len].leaf_name[leaf_len] = '\0';
+			if (dot) {
+				memcpy(selectors[len].param_name, dot + 1, param_len);
+				selectors[len].param_name[param_len] = '\0';
+			} else {
+				strcpy(selectors[len].param_name, "*");
+			}
+			len++;
+		} else {
+			ESP_LOGW(TAG, "invalid selector '%.*s'", (int ) n, p);
+		}
+
+		p += n;
+	}
+
+	portENTER_CRITICAL(&data->lock);
+	memcpy(data->selectors, selectors, len * sizeof(gn_leaf_exporter_selector_t));
+	data->selectors_len = len;
+	portEXIT_CRITICAL(&data->lock);
+
+}
+
+static bool _gn_leaf_exporter_selected(gn_leaf_exporter_data_t *data,
+		const char *leaf_name, const char *param_name) {
+
+	for (int i = 0; i < data->selectors_len; i++) {
+		gn_leaf_exporter_selector_t *s = &data->selectors[i];
+		if ((strcmp(s->leaf_name, "*") == 0
+				|| strcmp(s->leaf_name, leaf_name) == 0)
+				&& (strcmp(s->param_name, "*") == 0
+						|| strcmp(s->param_name, param_name) == 0))
+			return true;
+	}
+	return false;
+
+}
+
+/**
+ * @brief	runs in the event loop task for every parameter change of the node
+ *
+ * it only timestamps and copies the selected changes into the queue: when the queue is full the point
+ * is dropped, so the parameter writers are never slowed down by the export
+ */
+static void _gn_leaf_exporter_evt_handler(void *handler_args,
+		esp_event_base_t base, int32_t id, void *event_data) {
+
+	gn_leaf_exporter_data_t *data = (gn_leaf_exporter_data_t*) handler_args;
+	gn_leaf_parameter_event_handle_t evt =
+			(gn_leaf_parameter_event_handle_t) event_data;
+
+	//the exporter statistics are not exported
+	if (!evt || strcmp(evt->leaf_name, data->leaf_name) == 0)
+		return;
+
+	int64_t ts = esp_timer_get_time();
+
+	portENTER_CRITICAL(&data->lock);
+
+	if (data->active
+			&& _gn_leaf_exporter_selected(data, evt->leaf_name,
+					evt->param_name)) {
+
+		if (data->head - data->tail >= GN_LEAF_EXPORTER_QUEUE_SIZE) {
+			data->dropped++;
+		} else {
+			gn_leaf_exporter_point_t *point = &data->queue[data->head
+					% GN_LEAF_EXPORTER_QUEUE_SIZE];
+			point->ts = ts;
+			strncpy(point->leaf_name, evt->leaf_name, GN_LEAF_NAME_SIZE);
+			strncpy(point->param_name, evt->param_name,
+					GN_LEAF_PARAM_NAME_SIZE);
+			memcpy(point->value, evt->data, GN_LEAF_EXPORTER_VALUE_SIZE);
+			data->head++;
+		}
+
+	}
+
+	portEXIT_CRITICAL(&data->lock);
+
+}
+
+/**
+ * @brief	formats the point in the requested protocol
+ *
+ * the payload is interpreted with the type of the parameter: booleans are posted as a raw byte,
+ * doubles as printf text and strings as they are
+ *
+ * @return	the line length, 0 if the point cannot be represented
+ */
+static int _gn_leaf_exporter_format_point(gn_node_handle_t node,
+		const char *node_name, gn_leaf_exporter_format_t format,
+		gn_leaf_exporter_point_t *point, int64_t epoch_offset, char *line) {
+
+	gn_val_type_t type;
+	gn_leaf_param_handle_t param = gn_leaf_param_get_param_handle(
+			gn_leaf_get_config_handle(node, point->leaf_name),
+			point->param_name);
+	if (!param || gn_leaf_param_get_type(param, &type) != GN_RET_OK)
+		return 0;
+
+	char value[GN_LEAF_EXPORTER_VALUE_SIZE * 2 + 3];
+	point->value[GN_LEAF_EXPORTER_VALUE_SIZE - 1] = '\0';
+
+	switch (type) {
+	case GN_VAL_TYPE_BOOLEAN:
+		if (format == GN_LEAF_EXPORTER_FORMAT_INFLUX)
+			strcpy(value, point->value[0] ? "true" : "false");
+		else
+			strcpy(value, point->value[0] ? "1" : "0");
+		break;
+	case GN_VAL_TYPE_DOUBLE:
+		snprintf(value, sizeof(value), "%.10g", strtod(point->value, NULL));
+		break;
+	case GN_VAL_TYPE_STRING: {
+		//graphite carries numbers only
+		if (format != GN_LEAF_EXPORTER_FORMAT_INFLUX)
+			return 0;
+		char *v = value;
+		*v++ = '"';
+		for (const char *s = point->value; *s; s++) {
+			if (*s == '"' || *s == '\\')
+				*v++ = '\\';
+			*v++ = *s;
+		}
+		*v++ = '"';
+		*v = '\0';
+		break;
+	}
+	default:
+		return 0;
+	}
+
+	int64_t ts_us = point->ts + epoch_offset;
+	int len;
+	if (format == GN_LEAF_EXPORTER_FORMAT_INFLUX)
+		len = snprintf(line, GN_LEAF_EXPORTER_LINE_SIZE,
+				"grownode,node=%s,leaf=%s %s=%s %lld000\n", node_name,
+				point->leaf_name, point->param_name, value,
+				(long long) ts_us);
+	else
+		len = snprintf(line, GN_LEAF_EXPORTER_LINE_SIZE,
+				"grownode.%s.%s.%s %s %lld\n", node_name, point->leaf_name,
+				point->param_name, value, (long long) (ts_us / 1000000));
+
+	return len > 0 && len < GN_LEAF_EXPORTER_LINE_SIZE ? len : 0;
+
+}
+
+static int _gn_leaf_exporter_open(const char *ip, double port,
+		struct sockaddr_in *dest_addr) {
+
+	memset(dest_addr, 0, sizeof(*dest_addr));
+	dest_addr->sin_addr.s_addr = inet_addr(ip);
+	dest_addr->sin_family = AF_INET;
+	dest_addr->sin_port = htons((uint16_t )port);
+
+	int sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_IP);
+	if (sock < 0) {
+		ESP_LOGE(TAG, "Unable to create socket: errno %d", errno);
+		return -1;
+	}
+	ESP_LOGD(TAG, "Socket created, sending to %s:%d", ip, (int )port);
+	return sock;
+
+}
+
+/**
+ * @brief	sends the datagram without waiting for the network
+ *
+ * @return	false if the socket is no longer usable
+ */
+static bool _gn_leaf_exporter_send(int sock, struct sockaddr_in *dest_addr,
+		const char *buf, size_t len) {
+
+	if (sendto(sock, buf, len, MSG_DONTWAIT, (struct sockaddr*) dest_addr,
+			sizeof(*dest_addr)) >= 0)
+		return true;
+
+	ESP_LOGD(TAG, "Error occurred during sending: errno %d", errno);
+	//transient shortage of buffers, the socket stays
+	return errno == EAGAIN || errno == EWOULDBLOCK || errno == ENOMEM
+			|| errno == ENOBUFS;
+
+}
+
+void gn_leaf_exporter_task(gn_leaf_handle_t leaf_config) {
+
+	char leaf_name[GN_LEAF_NAME_SIZE];
+	gn_leaf_get_name(leaf_config, leaf_name);
+
+	gn_node_handle_t node = gn_leaf_get_node(leaf_config);
+	char node_name[GN_NODE_NAME_SIZE];
+	gn_node_get_name(node, node_name);
+
+	ESP_LOGD(TAG, "[%s] - Initializing ..", leaf_name);
+
+	gn_leaf_parameter_event_t evt;
+
+	//retrieves status descriptor from config
+	gn_leaf_exporter_data_t *data =
+			(gn_leaf_exporter_data_t*) gn_leaf_get_descriptor(leaf_config)->data;
+
+	bool active = true;
+	gn_leaf_param_get_bool(leaf_config, GN_LEAF_EXPORTER_PARAM_ACTIVE, &active);
+
+	char ip[IP_STRING_SIZE];
+	gn_leaf_param_get_string(leaf_config, GN_LEAF_EXPORTER_PARAM_IP, ip,
+	IP_STRING_SIZE);
+
+	double port = 0;
+	gn_leaf_param_get_double(leaf_config, GN_LEAF_EXPORTER_PARAM_PORT, &port);
+
+	double format = 0;
+	gn_leaf_param_get_double(leaf_config, GN_LEAF_EXPORTER_PARAM_FORMAT,
+			&format);
+
+	char filter[GN_LEAF_EXPORTER_FILTER_SIZE];
+	gn_leaf_param_get_string(leaf_config, GN_LEAF_EXPORTER_PARAM_FILTER, filter,
+	GN_LEAF_EXPORTER_FILTER_SIZE);
+
+	double flush_interval = 0;
+	gn_leaf_param_get_double(leaf_config, GN_LEAF_EXPORTER_PARAM_FLUSH_INTERVAL,
+			&flush_interval);
+
+	data->queue = gn_mem_malloc(gn_leaf_get_mem_tag(leaf_config),
+			GN_LEAF_EXPORTER_QUEUE_SIZE * sizeof(gn_leaf_exporter_point_t));
+	if (!data->queue
+			|| esp_event_handler_instance_register_with(
+					gn_leaf_get_event_loop(leaf_config), GN_BASE_EVENT,
+					GN_LEAF_PARAM_CHANGED_EVENT, _gn_leaf_exporter_evt_handler,
+					data, NULL) != ESP_OK) {
+		ESP_LOGE(TAG, "[%s] - unable to subscribe to parameter changes",
+				leaf_name);
+		gn_leaf_get_descriptor(leaf_config)->status = GN_LEAF_STATUS_ERROR;
+		vTaskDelete(NULL);
+		return;
+	}
+
+	_gn_leaf_exporter_set_filter(data, filter);
+	portENTER_CRITICAL(&data->lock);
+	data->active = active;
+	portEXIT_CRITICAL(&data->lock);
+
+	struct sockaddr_in dest_addr;
+	int sock = _gn_leaf_exporter_open(ip, port, &dest_addr);
+	int64_t retry_ts = 0;
+
+	char datagram[GN_LEAF_EXPORTER_DATAGRAM_SIZE];
+	size_t datagram_len = 0;
+	int datagram_points = 0;
+	char line[GN_LEAF_EXPORTER_LINE_SIZE];
+	gn_leaf_exporter_point_t point;
+
+	uint32_t sent = 0, send_dropped = 0;
+	uint32_t stats_sent = 0, stats_dropped = 0;
+	int64_t flush_ts = esp_timer_get_time();
+	int64_t stats_ts = flush_ts;
+
+//task cycle
+	while (true) {
+
+		//check for messages, the wait paces the flushes
+		if (xQueueReceive(gn_leaf_get_event_queue(leaf_config), &evt,
+				pdMS_TO_TICKS(GN_LEAF_EXPORTER_POLL_MS)) == pdPASS) {
+
+			ESP_LOGD(TAG, "%s - received message: %d", leaf_name, evt.id);
+
+			//event arrived for this node
+			switch (evt.id) {
+
+			//parameter change
+			case GN_LEAF_PARAM_CHANGE_REQUEST_EVENT:
+
+				if (gn_leaf_event_mask_param(&evt,
+						data->gn_leaf_exporter_active_param) == 0) {
+
+					bool _active = false;
+					if (gn_event_payload_to_bool(evt, &_active) != GN_RET_OK) {
+						break;
+					}
+
+					//execute change
+					gn_leaf_param_force_bool(leaf_config,
+							GN_LEAF_EXPORTER_PARAM_ACTIVE, _active);
+
+					portENTER_CRITICAL(&data->lock);
+					data->active = _active;
+					portEXIT_CRITICAL(&data->lock);
+
+				} else if (gn_leaf_event_mask_param(&evt,
+						data->gn_leaf_exporter_ip_param) == 0
+						|| gn_leaf_event_mask_param(&evt,
+								data->gn_leaf_exporter_port_param) == 0) {
+
+					if (gn_leaf_event_mask_param(&evt,
+							data->gn_leaf_exporter_ip_param) == 0) {
+						//execute change
+						gn_leaf_param_force_string(leaf_config,
+								GN_LEAF_EXPORTER_PARAM_IP, evt.data);
+						strncpy(ip, evt.data, IP_STRING_SIZE - 1);
+						ip[IP_STRING_SIZE - 1] = '\0';
+					} else {
+						if (gn_event_payload_to_double(evt, &port)
+								!= GN_RET_OK) {
+							break;
+						}
+						//execute change
+						gn_leaf_param_force_double(leaf_config,
+								GN_LEAF_EXPORTER_PARAM_PORT, port);
+					}
+
+					//restart messaging configuration
+					if (sock >= 0)
+						close(sock);
+					sock = _gn_leaf_exporter_open(ip, port, &dest_addr);
+
+				} else if (gn_leaf_event_mask_param(&evt,
+						data->gn_leaf_exporter_format_param) == 0) {
+
+					if (gn_event_payload_to_double(evt, &format) != GN_RET_OK) {
+						break;
+					}
+					//execute change
+					gn_leaf_param_force_double(leaf_config,
+							GN_LEAF_EXPORTER_PARAM_FORMAT, format);
+
+				} else if (gn_leaf_event_mask_param(&evt,
+						data->gn_leaf_exporter_filter_param) == 0) {
+
+					//execute change
+					gn_leaf_param_force_string(leaf_config,
+							GN_LEAF_EXPORTER_PARAM_FILTER, evt.data);
+					_gn_leaf_exporter_set_filter(data, evt.data);
+
+				} else if (gn_leaf_event_mask_param(&evt,
+						data->gn_leaf_exporter_flush_interval_param) == 0) {
+
+					if (gn_event_payload_to_double(evt, &flush_interval)
+							!= GN_RET_OK) {
+						break;
+					}
+					//execute change
+					gn_leaf_param_force_double(leaf_config,
+							GN_LEAF_EXPORTER_PARAM_FLUSH_INTERVAL,
+							flush_interval);
+
+				}
+
+				break;
+
+			default:
+				break;
+
+			}
+
+		}
+
+		int64_t now = esp_timer_get_time();
+
+		//a broken socket is reopened after a while, meanwhile the points are discarded
+		if (sock < 0 && now >= retry_ts) {
+			sock = _gn_leaf_exporter_open(ip, port, &dest_addr);
+			retry_ts = now + GN_LEAF_EXPORTER_RETRY_US;
+		}
+
+		portENTER_CRITICAL(&data->lock);
+		uint32_t pending = data->head - data->tail;
+		portEXIT_CRITICAL(&data->lock);
+
+		if (pending >= GN_LEAF_EXPORTER_BATCH_SIZE
+				|| (pending > 0
+						&& now - flush_ts >= (int64_t) (flush_interval * 1000))) {
+
+			flush_ts = now;
+
+			//line protocol timestamps are since epoch, point times are converted with the current offset
+			struct timeval tv;
+			gettimeofday(&tv, NULL);
+			int64_t epoch_offset = (int64_t) tv.tv_sec * 1000000L
+					+ (int64_t) tv.tv_usec - esp_timer_get_time();
+
+			while (true) {
+
+				portENTER_CRITICAL(&data->lock);
+				bool empty = data->head == data->tail;
+				if (!empty) {
+					point = data->queue[data->tail % GN_LEAF_EXPORTER_QUEUE_SIZE];
+					data->tail++;
+				}
+				portEXIT_CRITICAL(&data->lock);
+
+				int len =
+						empty ? 0 : _gn_leaf_exporter_format_point(node,
+										node_name,
+										(gn_leaf_exporter_format_t) format,
+										&point, epoch_offset, line);
+
+				//send the datagram when full and at the end of the batch
+				if (datagram_len > 0
+						&& (empty
+								|| datagram_len + len
+										> GN_LEAF_EXPORTER_DATAGRAM_SIZE)) {
+					if (sock >= 0
+							&& _gn_leaf_exporter_send(sock, &dest_addr,
+									datagram, datagram_len)) {
+						sent += datagram_points;
+					} else {
+						send_dropped += datagram_points;
+						if (sock >= 0) {
+							ESP_LOGW(TAG, "[%s] - send failed: errno %d",
+									leaf_name, errno);
+							close(sock);
+							sock = -1;
+							retry_ts = now + GN_LEAF_EXPORTER_RETRY_US;
+						}
+					}
+					datagram_len = 0;
+					datagram_points = 0;
+				}
+
+				if (empty)
+					break;
+
+				if (len > 0) {
+					memcpy(&datagram[datagram_len], line, len);
+					datagram_len += len;
+					datagram_points++;
+				}
+
+			}
+
+		}
+
+		//export statistics
+		if (now - stats_ts >= GN_LEAF_EXPORTER_STATS_INTERVAL_US) {
+
+			stats_ts = now;
+
+			portENTER_CRITICAL(&data->lock);
+			uint32_t dropped = data->dropped + send_dropped;
+			portEXIT_CRITICAL(&data->lock);
+
+			if (sent != stats_sent || dropped != stats_dropped) {
+				ESP_LOGD(TAG, "[%s] - sent %u, dropped %u", leaf_name,
+						(unsigned ) sent, (unsigned ) dropped);
+				gn_leaf_param_force_double(leaf_config,
+						GN_LEAF_EXPORTER_PARAM_SENT, sent);
+				gn_leaf_param_force_double(leaf_config,
+						GN_LEAF_EXPORTER_PARAM_DROPPED, dropped);
+				stats_sent = sent;
+				stats_dropped = dropped;
+			}
+
+		}
+
+	}
+
+}
+
+#ifdef __cplusplus
+}
+#endif //__cplusplus
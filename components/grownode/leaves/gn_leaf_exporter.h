@@ -0,0 +1,43 @@
+// Copyright 2021 Nicola Muratori (nicola.muratori@gmail.com)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MAIN_GN_LEAF_EXPORTER_H_
+#define MAIN_GN_LEAF_EXPORTER_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "grownode.h"
+
+//define type
+static const char GN_LEAF_EXPORTER_TYPE[] = "exporter";
+
+//parameters
+static const char GN_LEAF_EXPORTER_PARAM_ACTIVE[] = "active"; /*!< whether the export shall be enabled */
+static const char GN_LEAF_EXPORTER_PARAM_IP[] = "ip"; /*!< ip address of the metrics server */
+static const char GN_LEAF_EXPORTER_PARAM_PORT[] = "port"; /*!< UDP port of the metrics server */
+static const char GN_LEAF_EXPORTER_PARAM_FORMAT[] = "format"; /*!< 0 = influxdb line protocol, 1 = graphite plaintext */
+static const char GN_LEAF_EXPORTER_PARAM_FILTER[] = "filter"; /*!< comma separated leaf.param selectors, * matches any leaf or param */
+static const char GN_LEAF_EXPORTER_PARAM_FLUSH_INTERVAL[] = "flush_interval"; /*!< msec before a datagram is sent when not full */
+static const char GN_LEAF_EXPORTER_PARAM_SENT[] = "sent"; /*!< points sent since start */
+static const char GN_LEAF_EXPORTER_PARAM_DROPPED[] = "dropped"; /*!< points lost since start, queue full or send failed */
+
+gn_leaf_descriptor_handle_t gn_leaf_exporter_config(gn_leaf_handle_t leaf_config);
+
+#ifdef __cplusplus
+}
+#endif //__cplusplus
+
+#endif /* MAIN_GN_LEAF_EXPORTER_H_ */
@@ -26,7 +26,11 @@ extern "C" {
 #include "lvgl_helpers.h"
 #endif
 
+#include <sys/time.h>
+#include <math.h>
+
 #include "esp_log.h"
+#include "esp_timer.h"
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
@@ -46,6 +50,7 @@ extern "C" {
 #include "ina219.h"
 
 #include "gn_commons.h"
+#include "gn_i2c.h"
 
 #include "gn_leaf_ina219.h"
 
@@ -54,8 +59,39 @@ extern "C" {
 #define I2C_PORT 0
 #define I2C_ADDR INA219_ADDR_GND_GND
 
+//voltage registers, big endian
+#define GN_LEAF_INA219_REG_SHUNT_VOLTAGE 0x01
+#define GN_LEAF_INA219_REG_BUS_VOLTAGE 0x02
+
 #define IP_STRING_SIZE 16
 
+#define GN_LEAF_INA219_SHUNT_OHM 0.1
+#define GN_LEAF_INA219_MAX_CURRENT 5.0
+
+//shortest sampling period, one 12 bit shunt and one 12 bit bus conversion (532 usec each)
+#define GN_LEAF_INA219_MIN_PERIOD_US 1064
+
+//samples buffered between the sampler and the leaf task, power of 2
+#define GN_LEAF_INA219_RING_SIZE 512
+//UDP payload fitting a 1500 bytes ethernet MTU after IP and UDP headers
+#define GN_LEAF_INA219_DATAGRAM_SIZE 1472
+#define GN_LEAF_INA219_LINE_SIZE 192
+
+#define GN_LEAF_INA219_DRAIN_MS 100
+//acquisition statistics are evaluated at this interval and published when they change
+#ifndef GN_LEAF_INA219_STATS_INTERVAL_US
+#define GN_LEAF_INA219_STATS_INTERVAL_US 10000000
+#endif
+
+#define GN_LEAF_INA219_SAMPLER_STACK 2048
+#define GN_LEAF_INA219_SAMPLER_PRIORITY 6
+
+typedef struct {
+	int64_t ts; /*!< esp_timer time of the reading, in usec */
+	float bus_voltage; /*!< in V */
+	float shunt_voltage; /*!< in V */
+} gn_leaf_ina219_sample_t;
+
 typedef struct {
 	gn_leaf_param_handle_t gn_leaf_ina219_active_param;
 	gn_leaf_param_handle_t gn_leaf_ina219_ip_param;
@@ -70,7 +106,25 @@ typedef struct {
 	gn_leaf_param_handle_t gn_leaf_ina219_shunt_voltage_param;
 	gn_leaf_param_handle_t gn_leaf_ina219_bus_voltage_param;
 	gn_leaf_param_handle_t gn_leaf_ina219_current_param;
+	gn_leaf_param_handle_t gn_leaf_ina219_sampling_rate_param;
+	gn_leaf_param_handle_t gn_leaf_ina219_dropped_param;
 	ina219_t dev;
+	gn_i2c_bus_handle_t i2c_bus;
+	gn_i2c_device_handle_t i2c_device;
+
+	//single producer (sampler task) single consumer (leaf task) ring
+	gn_leaf_ina219_sample_t *ring;
+	uint32_t head;
+	uint32_t tail;
+
+	esp_timer_handle_t timer;
+	TaskHandle_t sampler;
+
+	//counters, written by the sampler only
+	volatile uint32_t samples;
+	volatile uint32_t dropped; /*!< readings lost because the ring was full */
+	volatile uint32_t missed; /*!< timer periods elapsed while the sampler was busy */
+	volatile uint32_t errors; /*!< failed I2C readings */
 } gn_leaf_ina219_data_t;
 
 void gn_leaf_ina219_task(gn_leaf_handle_t leaf_config);
@@ -80,12 +134,15 @@ gn_leaf_descriptor_handle_t gn_leaf_ina219_config(gn_leaf_handle_t leaf_config)
 	ESP_LOGD(TAG, "ina219 configuring..");
 
 	gn_leaf_descriptor_handle_t descriptor =
-			(gn_leaf_descriptor_handle_t) malloc(sizeof(gn_leaf_descriptor_t));
+			(gn_leaf_descriptor_handle_t) gn_mem_malloc(
+					gn_leaf_get_mem_tag(leaf_config), sizeof(gn_leaf_descriptor_t));
 	strncpy(descriptor->type, GN_LEAF_INA219_TYPE, GN_LEAF_DESC_TYPE_SIZE);
 	descriptor->callback = gn_leaf_ina219_task;
 	descriptor->status = GN_LEAF_STATUS_NOT_INITIALIZED;
 
-	gn_leaf_ina219_data_t *data = malloc(sizeof(gn_leaf_ina219_data_t));
+	gn_leaf_ina219_data_t *data = gn_mem_malloc(gn_leaf_get_mem_tag(leaf_config),
+			sizeof(gn_leaf_ina219_data_t));
+	memset(data, 0, sizeof(gn_leaf_ina219_data_t));
 
 	data->gn_leaf_ina219_active_param = gn_leaf_param_create(leaf_config,
 			GN_LEAF_INA219_PARAM_ACTIVE, GN_VAL_TYPE_BOOLEAN, (gn_val_t ) { .b =
@@ -154,6 +211,16 @@ gn_leaf_descriptor_handle_t gn_leaf_ina219_config(gn_leaf_handle_t leaf_config)
 							0 }, GN_LEAF_PARAM_ACCESS_ALL,
 			GN_LEAF_PARAM_STORAGE_VOLATILE, NULL);
 
+	data->gn_leaf_ina219_sampling_rate_param = gn_leaf_param_create(
+			leaf_config, GN_LEAF_INA219_PARAM_SAMPLING_RATE,
+			GN_VAL_TYPE_DOUBLE, (gn_val_t ) { .d = 0 },
+			GN_LEAF_PARAM_ACCESS_NODE, GN_LEAF_PARAM_STORAGE_VOLATILE, NULL);
+
+	data->gn_leaf_ina219_dropped_param = gn_leaf_param_create(leaf_config,
+			GN_LEAF_INA219_PARAM_DROPPED, GN_VAL_TYPE_DOUBLE,
+			(gn_val_t ) { .d = 0 }, GN_LEAF_PARAM_ACCESS_NODE,
+			GN_LEAF_PARAM_STORAGE_VOLATILE, NULL);
+
 	gn_leaf_param_add_to_leaf(leaf_config, data->gn_leaf_ina219_active_param);
 	gn_leaf_param_add_to_leaf(leaf_config, data->gn_leaf_ina219_ip_param);
 	gn_leaf_param_add_to_leaf(leaf_config, data->gn_leaf_ina219_port_param);
@@ -171,6 +238,9 @@ gn_leaf_descriptor_handle_t gn_leaf_ina219_config(gn_leaf_handle_t leaf_config)
 	gn_leaf_param_add_to_leaf(leaf_config,
 			data->gn_leaf_ina219_shunt_voltage_param);
 	gn_leaf_param_add_to_leaf(leaf_config, data->gn_leaf_ina219_current_param);
+	gn_leaf_param_add_to_leaf(leaf_config,
+			data->gn_leaf_ina219_sampling_rate_param);
+	gn_leaf_param_add_to_leaf(leaf_config, data->gn_leaf_ina219_dropped_param);
 
 	descriptor->status = GN_LEAF_STATUS_INITIALIZED;
 	descriptor->data = data;
@@ -178,6 +248,96 @@ gn_leaf_descriptor_handle_t gn_leaf_ina219_config(gn_leaf_handle_t leaf_config)
 
 }
 
+/**
+ * @brief	esp_timer callback, wakes up the sampler once per sampling period
+ *
+ * the I2C transactions are not performed here so that the esp_timer task is never blocked on the bus
+ */
+static void _gn_leaf_ina219_timer_callback(void *arg) {
+	gn_leaf_ina219_data_t *data = (gn_leaf_ina219_data_t*) arg;
+	xTaskNotifyGive(data->sampler);
+}
+
+/**
+ * @brief	reads the sensor once per timer period and pushes the timestamped reading into the ring
+ *
+ * the sensor runs in continuous shunt and bus conversion mode, so a reading is just two register reads;
+ * current and power are derived from them by the consumer
+ */
+static void _gn_leaf_ina219_sampler_task(void *arg) {
+
+	gn_leaf_ina219_data_t *data = (gn_leaf_ina219_data_t*) arg;
+	gn_leaf_ina219_sample_t sample;
+	uint8_t shunt[2], bus[2];
+
+	//both registers are read in a single acquisition of the bus
+	gn_i2c_op_t ops[2] = { { .type = GN_I2C_OP_READ_REG, .device =
+			data->i2c_device, .reg = GN_LEAF_INA219_REG_SHUNT_VOLTAGE, .buf =
+			shunt, .size = sizeof(shunt) }, { .type = GN_I2C_OP_READ_REG,
+			.device = data->i2c_device, .reg = GN_LEAF_INA219_REG_BUS_VOLTAGE,
+			.buf = bus, .size = sizeof(bus) } };
+
+	while (true) {
+
+		uint32_t periods = ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+		if (periods > 1)
+			data->missed += periods - 1;
+
+		sample.ts = esp_timer_get_time();
+		if (gn_i2c_batch_run(data->i2c_bus, ops, 2) != GN_RET_OK) {
+			data->errors++;
+			continue;
+		}
+
+		//shunt LSB is 10 uV, bus voltage is in bits 15..3 with a 4 mV LSB
+		sample.shunt_voltage = (int16_t) ((shunt[0] << 8) | shunt[1])
+				/ 100000.0f;
+		sample.bus_voltage = (((bus[0] << 8) | bus[1]) >> 3) * 0.004f;
+
+		uint32_t head = data->head;
+		if (head - __atomic_load_n(&data->tail, __ATOMIC_ACQUIRE)
+				>= GN_LEAF_INA219_RING_SIZE) {
+			data->dropped++;
+			continue;
+		}
+
+		data->ring[head & (GN_LEAF_INA219_RING_SIZE - 1)] = sample;
+		__atomic_store_n(&data->head, head + 1, __ATOMIC_RELEASE);
+		data->samples++;
+
+	}
+
+}
+
+static void _gn_leaf_ina219_start_sampling(gn_leaf_ina219_data_t *data,
+		double sampling_interval) {
+
+	int64_t period = (int64_t) (sampling_interval * 1000);
+	if (period < GN_LEAF_INA219_MIN_PERIOD_US)
+		period = GN_LEAF_INA219_MIN_PERIOD_US;
+
+	esp_timer_stop(data->timer);
+	if (esp_timer_start_periodic(data->timer, period) != ESP_OK) {
+		ESP_LOGE(TAG, "unable to start the sampling timer");
+		return;
+	}
+	ESP_LOGD(TAG, "sampling every %lld usec", (long long) period);
+
+}
+
+static void _gn_leaf_ina219_send(int sock, struct sockaddr_in *dest_addr,
+		const char *buf, size_t len) {
+
+	if (sock < 0 || len == 0)
+		return;
+
+	if (sendto(sock, buf, len, 0, (struct sockaddr*) dest_addr,
+			sizeof(*dest_addr)) < 0) {
+		ESP_LOGE(TAG, "Error occurred during sending: errno %d", errno);
+	}
+
+}
+
 void gn_leaf_ina219_task(gn_leaf_handle_t leaf_config) {
 
 	char leaf_name[GN_LEAF_NAME_SIZE];
@@ -239,10 +399,43 @@ void gn_leaf_ina219_task(gn_leaf_handle_t leaf_config) {
 			INA219_MODE_CONT_SHUNT_BUS);
 	ESP_LOGD(TAG, "ina219_configure: %s", esp_err_to_name(esp_ret));
 
-	esp_ret = ina219_calibrate(&data->dev, 5.0, 0.1); // 5A max current, 0.1 Ohm shunt resistance
+	esp_ret = ina219_calibrate(&data->dev, GN_LEAF_INA219_MAX_CURRENT,
+			GN_LEAF_INA219_SHUNT_OHM);
 
 	ESP_LOGD(TAG, "ina219_calibrate: %s", esp_err_to_name(esp_ret));
 
+	//setup sampler
+	data->ring = gn_mem_malloc(gn_leaf_get_mem_tag(leaf_config),
+			GN_LEAF_INA219_RING_SIZE * sizeof(gn_leaf_ina219_sample_t));
+
+	if (gn_i2c_bus_get(I2C_PORT, (int) sda, (int) scl, &data->i2c_bus)
+			!= GN_RET_OK
+			|| gn_i2c_device_add(data->i2c_bus, &data->dev.i2c_dev, leaf_name,
+					&data->i2c_device) != GN_RET_OK) {
+		ESP_LOGE(TAG, "[%s] - unable to register on the i2c bus", leaf_name);
+		gn_leaf_get_descriptor(leaf_config)->status = GN_LEAF_STATUS_ERROR;
+		vTaskDelete(NULL);
+		return;
+	}
+
+	const esp_timer_create_args_t timer_args = { .callback =
+			&_gn_leaf_ina219_timer_callback, .arg = data, .name =
+			"ina219_sampler" };
+
+	if (!data->ring
+			|| xTaskCreate(_gn_leaf_ina219_sampler_task, "ina219_sampler",
+					GN_LEAF_INA219_SAMPLER_STACK, data,
+					GN_LEAF_INA219_SAMPLER_PRIORITY, &data->sampler) != pdPASS
+			|| esp_timer_create(&timer_args, &data->timer) != ESP_OK) {
+		ESP_LOGE(TAG, "[%s] - unable to start the sampler", leaf_name);
+		gn_leaf_get_descriptor(leaf_config)->status = GN_LEAF_STATUS_ERROR;
+		vTaskDelete(NULL);
+		return;
+	}
+
+	if (active)
+		_gn_leaf_ina219_start_sampling(data, sampling_interval);
+
 	int addr_family = 0;
 	int ip_protocol = 0;
 
@@ -259,20 +452,34 @@ void gn_leaf_ina219_task(gn_leaf_handle_t leaf_config) {
 	}
 	ESP_LOGD(TAG, "Socket created, sending to %s:%d", ip, (int )port);
 
-	float bus_voltage = 0, shunt_voltage = 0, current = 0, power = 0;
-	float bus_voltage_instant = 0, shunt_voltage_instant = 0, current_instant =
-			0, power_instant = 0;
+	//accumulators of the point being averaged
+	float bus_voltage = 0, shunt_voltage = 0;
+	int64_t point_ts = 0;
+	int cycles = 0;
+
+	//last averaged point, in mV, mA, mW
+	float last_bus_voltage = 0, last_shunt_voltage = 0, last_current = 0,
+			last_power = 0;
+	bool last_valid = false;
 
-	char total_msg[255];
+	//lines are batched into MTU sized datagrams
+	char datagram[GN_LEAF_INA219_DATAGRAM_SIZE];
+	size_t datagram_len = 0;
+	char line[GN_LEAF_INA219_LINE_SIZE];
+
+	//last published statistics
+	uint32_t stats_samples = 0, stats_dropped = 0;
+	double stats_rate = 0;
+	int64_t stats_ts = esp_timer_get_time();
 
 //task cycle
 	while (true) {
 
 		//ESP_LOGD(TAG, "task cycle..");
 
-		//check for messages
+		//check for messages, the wait paces the ring draining
 		if (xQueueReceive(gn_leaf_get_event_queue(leaf_config), &evt,
-				0) == pdPASS) {
+				pdMS_TO_TICKS(GN_LEAF_INA219_DRAIN_MS)) == pdPASS) {
 
 			ESP_LOGD(TAG, "%s - received message: %d", leaf_name, evt.id);
 
@@ -296,6 +503,20 @@ void gn_leaf_ina219_task(gn_leaf_handle_t leaf_config) {
 							GN_LEAF_INA219_PARAM_ACTIVE,
 							_active);
 
+					if (_active && !active) {
+						_gn_leaf_ina219_start_sampling(data, sampling_interval);
+						stats_samples = data->samples;
+						stats_ts = esp_timer_get_time();
+					} else if (!_active && active) {
+						esp_timer_stop(data->timer);
+						//the rate drops to zero once, then nothing is published until sampling restarts
+						if (stats_rate != 0) {
+							gn_leaf_param_force_double(leaf_config,
+									GN_LEAF_INA219_PARAM_SAMPLING_RATE, 0);
+							stats_rate = 0;
+						}
+					}
+
 					active = _active;
 
 				} else if (gn_leaf_event_mask_param(&evt,
@@ -370,6 +591,12 @@ void gn_leaf_ina219_task(gn_leaf_handle_t leaf_config) {
 							GN_LEAF_INA219_PARAM_SAMPLING_INTERVAL,
 							sampling_interval);
 
+					if (active) {
+						_gn_leaf_ina219_start_sampling(data, sampling_interval);
+						stats_samples = data->samples;
+						stats_ts = esp_timer_get_time();
+					}
+
 				} else if (gn_leaf_event_mask_param(&evt,
 						data->gn_leaf_ina219_sda_param) == 0) {
 
@@ -411,88 +638,131 @@ void gn_leaf_ina219_task(gn_leaf_handle_t leaf_config) {
 
 		}
 
-		if (active) {
-
-			bus_voltage = 0;
-			shunt_voltage = 0;
-			current = 0;
-			power = 0;
+		bool udp = (working_mode == 0 || working_mode == 2);
 
-			//ESP_LOGD(TAG,"start sampling");
+		//line protocol timestamps are in nsec since epoch, sample times are converted with the current offset
+		struct timeval tv;
+		gettimeofday(&tv, NULL);
+		int64_t epoch_offset = (int64_t) tv.tv_sec * 1000000L
+				+ (int64_t) tv.tv_usec - esp_timer_get_time();
 
-			//retrieve sensor info
-			//sampling configurable
-			for (int i = 0; i < sampling_cycles; i++) {
+		//drain the ring
+		uint32_t head = __atomic_load_n(&data->head, __ATOMIC_ACQUIRE);
+		uint32_t tail = data->tail;
 
-				ESP_ERROR_CHECK(
-						ina219_get_bus_voltage(&data->dev,
-								&bus_voltage_instant));
-				bus_voltage += bus_voltage_instant;
+		for (; tail != head; tail++) {
 
-				ESP_ERROR_CHECK(
-						ina219_get_shunt_voltage(&data->dev,
-								&shunt_voltage_instant));
-				shunt_voltage += shunt_voltage_instant;
+			gn_leaf_ina219_sample_t *sample = &data->ring[tail
+					& (GN_LEAF_INA219_RING_SIZE - 1)];
 
-				ESP_ERROR_CHECK(
-						ina219_get_current(&data->dev, &current_instant));
-				current += current_instant;
+			if (cycles == 0)
+				point_ts = sample->ts;
+			bus_voltage += sample->bus_voltage;
+			shunt_voltage += sample->shunt_voltage;
 
-				ESP_ERROR_CHECK(ina219_get_power(&data->dev, &power_instant));
-				power += power_instant;
+			if (++cycles < sampling_cycles)
+				continue;
 
-				vTaskDelay(pdMS_TO_TICKS(sampling_interval-0.5)); //0.6msec is the time needed to perform a 12bit measure 1 sample
+			//averaging
+			last_bus_voltage = (bus_voltage / (float) cycles) * 1000;
+			last_shunt_voltage = (shunt_voltage / (float) cycles) * 1000;
+			last_current = last_shunt_voltage / GN_LEAF_INA219_SHUNT_OHM;
+			last_power = last_bus_voltage * last_current / 1000;
+			last_valid = true;
 
+			bus_voltage = 0;
+			shunt_voltage = 0;
+			cycles = 0;
+
+			if (!udp)
+				continue;
+
+			int len = snprintf(line, GN_LEAF_INA219_LINE_SIZE,
+					"grownode,node=%s,leaf=%s power=%.4f,current=%.4f,vbus=%.4f,vshunt=%.4f,vload=%.4f %lld000\n",
+					node_name, leaf_name, last_power, last_current,
+					last_bus_voltage, last_shunt_voltage,
+					(last_shunt_voltage + last_bus_voltage),
+					(long long) (point_ts + epoch_offset));
+			if (len <= 0 || len >= GN_LEAF_INA219_LINE_SIZE)
+				continue;
+
+			if (datagram_len + len > GN_LEAF_INA219_DATAGRAM_SIZE) {
+				_gn_leaf_ina219_send(sock, &dest_addr, datagram, datagram_len);
+				datagram_len = 0;
 			}
+			memcpy(&datagram[datagram_len], line, len);
+			datagram_len += len;
 
-			//averaging
-			bus_voltage = (bus_voltage / (float) sampling_cycles)  * 1000;
-			shunt_voltage = (shunt_voltage / (float) sampling_cycles) * 1000;
-			current = (current / (float) sampling_cycles) * 1000;
-			power = (power / (float) sampling_cycles) * 1000;
+		}
+
+		__atomic_store_n(&data->tail, tail, __ATOMIC_RELEASE);
+
+		//what is left is sent at the end of each drain, bounding the export latency
+		_gn_leaf_ina219_send(sock, &dest_addr, datagram, datagram_len);
+		datagram_len = 0;
+
+		if (last_valid && (working_mode == 1 || working_mode == 2)) {
 
 			ESP_LOGD(TAG,
 					"VBUS: %.04f mV, VSHUNT: %.04f mV, IBUS: %.04f mA, PBUS: %.04f mW\n",
-					bus_voltage, shunt_voltage, current,
-					power);
-
-			if (working_mode == 0 || working_mode == 2) {
-				int err;
-
-				snprintf(total_msg, 255,
-						"grownode,node=%s,leaf=%s power=%f,current=%f,vbus=%f,vshunt=%f,vload=%f",
-						node_name, leaf_name, power, current,
-						bus_voltage, shunt_voltage,
-						(shunt_voltage + bus_voltage));
-
-				err = sendto(sock, total_msg, strlen(total_msg), 0,
-						(struct sockaddr*) &dest_addr, sizeof(dest_addr));
-				if (err < 0) {
-					ESP_LOGE(TAG, "Error occurred during sending: errno %d",
-							errno);
-				}
-				ESP_LOGD(TAG, "Message sent: %s to %s:%d", total_msg, ip,
-						(int )port);
-			}
+					last_bus_voltage, last_shunt_voltage, last_current,
+					last_power);
 
-			if (working_mode == 1 || working_mode == 2) {
+			gn_leaf_param_force_double(leaf_config,
+					GN_LEAF_INA219_PARAM_VOLTAGE,
+					(last_shunt_voltage + last_bus_voltage));
 
-				gn_leaf_param_force_double(leaf_config,
-						GN_LEAF_INA219_PARAM_VOLTAGE,
-						(shunt_voltage + bus_voltage));
+			gn_leaf_param_force_double(leaf_config,
+					GN_LEAF_INA219_PARAM_SHUNT_VOLTAGE, last_shunt_voltage);
 
-				gn_leaf_param_force_double(leaf_config,
-						GN_LEAF_INA219_PARAM_SHUNT_VOLTAGE, shunt_voltage);
+			gn_leaf_param_force_double(leaf_config,
+					GN_LEAF_INA219_PARAM_BUS_VOLTAGE, last_bus_voltage);
 
-				gn_leaf_param_force_double(leaf_config,
-						GN_LEAF_INA219_PARAM_BUS_VOLTAGE, bus_voltage);
+			gn_leaf_param_force_double(leaf_config,
+					GN_LEAF_INA219_PARAM_POWER, last_power);
 
-				gn_leaf_param_force_double(leaf_config,
-						GN_LEAF_INA219_PARAM_POWER, power);
+			gn_leaf_param_force_double(leaf_config,
+					GN_LEAF_INA219_PARAM_CURRENT, last_current);
 
+		}
+		last_valid = false;
+
+		//acquisition statistics, only while sampling
+		int64_t now = esp_timer_get_time();
+		if (active && now - stats_ts >= GN_LEAF_INA219_STATS_INTERVAL_US) {
+
+			uint32_t samples = data->samples;
+			uint32_t dropped = data->dropped + data->missed;
+			//whole Hz, so that the timer jitter is not a change
+			double rate = round(
+					(double) (samples - stats_samples) * 1000000
+							/ (double) (now - stats_ts));
+			stats_samples = samples;
+			stats_ts = now;
+
+			ESP_LOGD(TAG,
+					"[%s] - rate %.1f Hz, dropped %u, missed %u, errors %u",
+					leaf_name, rate, (unsigned) data->dropped,
+					(unsigned) data->missed, (unsigned) data->errors);
+
+			if (rate != stats_rate) {
+				gn_leaf_param_force_double(leaf_config,
+						GN_LEAF_INA219_PARAM_SAMPLING_RATE, rate);
+				stats_rate = rate;
+			}
+			if (dropped != stats_dropped) {
 				gn_leaf_param_force_double(leaf_config,
-						GN_LEAF_INA219_PARAM_CURRENT, current);
+						GN_LEAF_INA219_PARAM_DROPPED, dropped);
+				stats_dropped = dropped;
+			}
 
+			if (udp) {
+				int len = snprintf(datagram, GN_LEAF_INA219_DATAGRAM_SIZE,
+						"grownode_ina219,node=%s,leaf=%s rate=%.1f,dropped=%ui,missed=%ui,errors=%ui\n",
+						node_name, leaf_name, rate, (unsigned) data->dropped,
+						(unsigned) data->missed, (unsigned) data->errors);
+				if (len > 0 && len < GN_LEAF_INA219_DATAGRAM_SIZE)
+					_gn_leaf_ina219_send(sock, &dest_addr, datagram, len);
 			}
 
 		}
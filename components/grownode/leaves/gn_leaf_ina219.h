@@ -28,16 +28,18 @@ static const char GN_LEAF_INA219_TYPE[] = "ina219";
 static const char GN_LEAF_INA219_PARAM_ACTIVE[] = "active"; /*!< whether INA219 shall be enabled */
 static const char GN_LEAF_INA219_PARAM_IP[] = "ip"; /*!< ip address of the server */
 static const char GN_LEAF_INA219_PARAM_PORT[] = "port"; /*!< port of the server */
-static const char GN_LEAF_INA219_PARAM_SAMPLING_CYCLES[] = "samp_cycles"; /*!< sampling cycles */
-static const char GN_LEAF_INA219_PARAM_SAMPLING_INTERVAL[] = "samp_interval"; /*!< sampling interval, (approx) in msec */
+static const char GN_LEAF_INA219_PARAM_SAMPLING_CYCLES[] = "samp_cycles"; /*!< samples averaged in each exported point */
+static const char GN_LEAF_INA219_PARAM_SAMPLING_INTERVAL[] = "samp_interval"; /*!< sampling interval in msec, fractions allowed down to the ~1.06 msec conversion time */
 static const char GN_LEAF_INA219_PARAM_SDA[] = "sda"; /*!< SDA PIN */
 static const char GN_LEAF_INA219_PARAM_SCL[] = "scl"; /*!< SCL PIN */
-static const char GN_LEAF_INA219_PARAM_WORKING_MODE[] = "working_mode"; /*!< 0 = through UDP via influxdb protocol, 1 = parameters, 2 both*/
+static const char GN_LEAF_INA219_PARAM_WORKING_MODE[] = "working_mode"; /*!< 0 = through UDP via influxdb protocol (timestamped lines batched per datagram), 1 = parameters, 2 both*/
 static const char GN_LEAF_INA219_PARAM_POWER[] = "power"; /*!< last power measured, in mW*/
 static const char GN_LEAF_INA219_PARAM_VOLTAGE[] = "voltage"; /*!< last voltage measured, in mV */
 static const char GN_LEAF_INA219_PARAM_SHUNT_VOLTAGE[] = "shunt_voltage"; /*!< last shunt voltage measured, in mV */
 static const char GN_LEAF_INA219_PARAM_BUS_VOLTAGE[] = "bus_voltage"; /*!< last bus voltage measured, in mV */
 static const char GN_LEAF_INA219_PARAM_CURRENT[] = "current"; /*!< last current measured, in mA */
+static const char GN_LEAF_INA219_PARAM_SAMPLING_RATE[] = "samp_rate"; /*!< sample rate achieved while sampling, in whole Hz. updated every 10 sec if changed, 0 when stopped */
+static const char GN_LEAF_INA219_PARAM_DROPPED[] = "dropped"; /*!< samples lost since start, ring full or sampling periods missed. updated every 10 sec if changed */
 
 
 
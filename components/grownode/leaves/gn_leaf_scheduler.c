@@ -0,0 +1,368 @@
+// Copyright 2021 Nicola Muratori (nicola.muratori@gmail.com)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <string.h>
+#include <stdlib.h>
+
+#include "esp_log.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
+#include "gn_commons.h"
+#include "gn_scheduler.h"
+
+#include "gn_leaf_scheduler.h"
+
+#define TAG "gn_leaf_scheduler"
+
+#define GN_LEAF_SCHEDULER_TEXT_SIZE GN_LEAF_DATA_SIZE
+#define GN_LEAF_SCHEDULER_VALUE_SIZE 32
+
+/*
+ * time-of-day actions persisted in the jobs parameter, so they survive restarts and can be
+ * edited over the network. every job writes a value to a parameter of a leaf of the node, eg.
+ * "0 7 * * * lig_1.status=true; 0 21 * * * lig_1.status=false". the value is converted to the
+ * type of the target parameter when the job runs
+ */
+
+typedef struct {
+	char spec[GN_SCHEDULER_SPEC_SIZE];
+	char leaf_name[GN_LEAF_NAME_SIZE];
+	char param_name[GN_LEAF_PARAM_NAME_SIZE];
+	char value[GN_LEAF_SCHEDULER_VALUE_SIZE];
+} gn_leaf_scheduler_action_t;
+
+typedef struct gn_leaf_scheduler_data gn_leaf_scheduler_data_t;
+
+typedef struct {
+	gn_leaf_scheduler_data_t *data;
+	gn_scheduler_job_handle_t job;
+	gn_leaf_scheduler_action_t action;
+} gn_leaf_scheduler_slot_t;
+
+struct gn_leaf_scheduler_data {
+	gn_leaf_handle_t leaf_config;
+	char leaf_name[GN_LEAF_NAME_SIZE];
+	gn_leaf_param_handle_t gn_leaf_scheduler_jobs_param;
+	SemaphoreHandle_t lock; /*!< protects the actions against a reload */
+	gn_leaf_scheduler_slot_t slots[GN_LEAF_SCHEDULER_MAX_JOBS];
+};
+
+void gn_leaf_scheduler_task(gn_leaf_handle_t leaf_config);
+
+static bool _gn_leaf_scheduler_copy(char *dst, size_t size, const char *src,
+		size_t len) {
+
+	if (len == 0 || len >= size)
+		return false;
+	memcpy(dst, src, len);
+	dst[len] = '\0';
+	return true;
+
+}
+
+/**
+ * @brief	parses "<spec> <leaf>.<param>=<value>", the action being the last word
+ */
+static bool _gn_leaf_scheduler_parse_job(const char *line, size_t len,
+		gn_leaf_scheduler_action_t *action) {
+
+	size_t action_start = len;
+	while (action_start > 0 && line[action_start - 1] != ' '
+			&& line[action_start - 1] != '\t')
+		action_start--;
+	if (action_start == 0)
+		return false;
+
+	size_t spec_len = action_start;
+	while (spec_len > 0
+			&& (line[spec_len - 1] == ' ' || line[spec_len - 1] == '\t'))
+		spec_len--;
+
+	const char *a = line + action_start;
+	size_t a_len = len - action_start;
+	const char *eq = memchr(a, '=', a_len);
+	const char *dot = eq ? memchr(a, '.', eq - a) : NULL;
+	if (!eq || !dot)
+		return false;
+
+	return _gn_leaf_scheduler_copy(action->spec, GN_SCHEDULER_SPEC_SIZE, line,
+			spec_len)
+			&& gn_scheduler_spec_validate(action->spec)
+			&& _gn_leaf_scheduler_copy(action->leaf_name, GN_LEAF_NAME_SIZE, a,
+					dot - a)
+			&& _gn_leaf_scheduler_copy(action->param_name,
+					GN_LEAF_PARAM_NAME_SIZE, dot + 1, eq - dot - 1)
+			&& _gn_leaf_scheduler_copy(action->value,
+					GN_LEAF_SCHEDULER_VALUE_SIZE, eq + 1,
+					a + a_len - eq - 1);
+
+}
+
+/**
+ * @brief	parses the jobs text
+ *
+ * @return	the number of jobs, -1 if the text is not valid
+ */
+static int _gn_leaf_scheduler_parse(const char *text,
+		gn_leaf_scheduler_action_t *actions) {
+
+	int count = 0;
+	const char *p = text;
+
+	while (*p) {
+
+		size_t len = strcspn(p, ";\n");
+		const char *next = p[len] ? p + len + 1 : p + len;
+
+		while (len > 0 && (*p == ' ' || *p == '\t' || *p == '\r')) {
+			p++;
+			len--;
+		}
+		while (len > 0
+				&& (p[len - 1] == ' ' || p[len - 1] == '\t'
+						|| p[len - 1] == '\r'))
+			len--;
+
+		if (len > 0) {
+			if (count == GN_LEAF_SCHEDULER_MAX_JOBS
+					|| !_gn_leaf_scheduler_parse_job(p, len, &actions[count]))
+				return -1;
+			count++;
+		}
+
+		p = next;
+
+	}
+
+	return count;
+
+}
+
+static gn_leaf_param_validator_result_t _gn_leaf_scheduler_jobs_validator(
+		gn_leaf_param_handle_t param, void **param_value) {
+
+	gn_leaf_scheduler_action_t *actions = gn_mem_malloc(GN_MEM_TAG_PARAMS,
+			sizeof(gn_leaf_scheduler_action_t) * GN_LEAF_SCHEDULER_MAX_JOBS);
+	if (!actions)
+		return GN_LEAF_PARAM_VALIDATOR_ERROR_GENERIC;
+
+	int count = _gn_leaf_scheduler_parse(*(char**) param_value, actions);
+	gn_mem_free(actions);
+
+	return count < 0 ?
+			GN_LEAF_PARAM_VALIDATOR_ERROR_NOT_ALLOWED :
+			GN_LEAF_PARAM_VALIDATOR_PASSED;
+
+}
+
+/*
+ * runs on the scheduler task, the write is a change request to the target leaf
+ */
+static void _gn_leaf_scheduler_run(void *arg) {
+
+	gn_leaf_scheduler_slot_t *slot = (gn_leaf_scheduler_slot_t*) arg;
+	gn_leaf_scheduler_data_t *data = slot->data;
+
+	gn_leaf_scheduler_action_t action;
+	xSemaphoreTake(data->lock, portMAX_DELAY);
+	action = slot->action;
+	xSemaphoreGive(data->lock);
+
+	gn_leaf_handle_t leaf = gn_leaf_get_config_handle(
+			gn_leaf_get_node(data->leaf_config), action.leaf_name);
+	gn_leaf_param_handle_t param =
+			leaf ? gn_leaf_param_get_param_handle(leaf, action.param_name) :
+					NULL;
+	gn_val_type_t type;
+
+	if (!param || gn_leaf_param_get_type(param, &type) != GN_RET_OK) {
+		ESP_LOGW(TAG, "[%s] job '%s': %s.%s not found", data->leaf_name,
+				action.spec, action.leaf_name, action.param_name);
+		return;
+	}
+
+	ESP_LOGD(TAG, "[%s] job '%s': %s.%s = %s", data->leaf_name, action.spec,
+			action.leaf_name, action.param_name, action.value);
+
+	switch (type) {
+	case GN_VAL_TYPE_BOOLEAN:
+		gn_leaf_param_set_bool(leaf, action.param_name,
+				strcmp(action.value, "true") == 0 || atof(action.value) != 0);
+		break;
+	case GN_VAL_TYPE_DOUBLE:
+		gn_leaf_param_set_double(leaf, action.param_name, atof(action.value));
+		break;
+	default:
+		gn_leaf_param_set_string(leaf, action.param_name, action.value);
+		break;
+	}
+
+}
+
+/**
+ * @brief	replaces the running jobs
+ */
+static gn_err_t _gn_leaf_scheduler_load(gn_leaf_scheduler_data_t *data,
+		const char *text) {
+
+	gn_leaf_scheduler_action_t *actions = gn_mem_calloc(
+			gn_leaf_get_mem_tag(data->leaf_config), GN_LEAF_SCHEDULER_MAX_JOBS,
+			sizeof(gn_leaf_scheduler_action_t));
+	if (!actions)
+		return GN_RET_ERR;
+
+	int count = _gn_leaf_scheduler_parse(text, actions);
+	if (count < 0) {
+		gn_mem_free(actions);
+		return GN_RET_ERR_INVALID_ARG;
+	}
+
+	for (int i = 0; i < GN_LEAF_SCHEDULER_MAX_JOBS; i++)
+		gn_scheduler_job_stop(data->slots[i].job);
+
+	xSemaphoreTake(data->lock, portMAX_DELAY);
+	for (int i = 0; i < GN_LEAF_SCHEDULER_MAX_JOBS; i++)
+		data->slots[i].action = actions[i];
+	xSemaphoreGive(data->lock);
+
+	for (int i = 0; i < count; i++)
+		gn_scheduler_job_start(data->slots[i].job, actions[i].spec);
+
+	ESP_LOGI(TAG, "[%s] %d jobs scheduled", data->leaf_name, count);
+
+	gn_mem_free(actions);
+	return GN_RET_OK;
+
+}
+
+gn_leaf_descriptor_handle_t gn_leaf_scheduler_config(
+		gn_leaf_handle_t leaf_config) {
+
+	ESP_LOGD(TAG, "scheduler configuring..");
+
+	gn_leaf_descriptor_handle_t descriptor =
+			(gn_leaf_descriptor_handle_t) gn_mem_malloc(
+					gn_leaf_get_mem_tag(leaf_config), sizeof(gn_leaf_descriptor_t));
+	strncpy(descriptor->type, GN_LEAF_SCHEDULER_TYPE, GN_LEAF_DESC_TYPE_SIZE);
+	descriptor->callback = gn_leaf_scheduler_task;
+	descriptor->status = GN_LEAF_STATUS_NOT_INITIALIZED;
+	descriptor->data = NULL;
+
+	gn_leaf_scheduler_data_t *data = gn_mem_calloc(
+			gn_leaf_get_mem_tag(leaf_config), 1,
+			sizeof(gn_leaf_scheduler_data_t));
+	if (!data)
+		return descriptor;
+
+	data->leaf_config = leaf_config;
+	gn_leaf_get_name(leaf_config, data->leaf_name);
+	data->lock = xSemaphoreCreateMutex();
+
+	for (int i = 0; i < GN_LEAF_SCHEDULER_MAX_JOBS; i++) {
+		gn_scheduler_job_config_t job_config = { .callback =
+				_gn_leaf_scheduler_run, .arg = &data->slots[i], .name =
+				data->leaf_name };
+		data->slots[i].data = data;
+		if (gn_scheduler_job_create(&job_config, &data->slots[i].job)
+				!= GN_RET_OK) {
+			ESP_LOGE(TAG, "[%s] cannot create the jobs", data->leaf_name);
+			descriptor->status = GN_LEAF_STATUS_ERROR;
+			return descriptor;
+		}
+	}
+
+	data->gn_leaf_scheduler_jobs_param = gn_leaf_param_create(leaf_config,
+			GN_LEAF_SCHEDULER_PARAM_JOBS, GN_VAL_TYPE_STRING,
+			(gn_val_t ) { .s = "" }, GN_LEAF_PARAM_ACCESS_ALL,
+			GN_LEAF_PARAM_STORAGE_PERSISTED,
+			_gn_leaf_scheduler_jobs_validator);
+	gn_leaf_param_add_to_leaf(leaf_config, data->gn_leaf_scheduler_jobs_param);
+
+	descriptor->status = GN_LEAF_STATUS_INITIALIZED;
+	descriptor->data = data;
+	return descriptor;
+
+}
+
+void gn_leaf_scheduler_task(gn_leaf_handle_t leaf_config) {
+
+	gn_leaf_parameter_event_t evt;
+
+	gn_leaf_scheduler_data_t *data =
+			(gn_leaf_scheduler_data_t*) gn_leaf_get_descriptor(leaf_config)->data;
+
+	char *text = gn_mem_calloc(gn_leaf_get_mem_tag(leaf_config),
+			GN_LEAF_SCHEDULER_TEXT_SIZE, sizeof(char));
+
+	//the jobs stored start with the node
+	if (data && text
+			&& gn_leaf_param_get_string(leaf_config,
+					GN_LEAF_SCHEDULER_PARAM_JOBS, text,
+					GN_LEAF_SCHEDULER_TEXT_SIZE) == GN_RET_OK) {
+		text[GN_LEAF_SCHEDULER_TEXT_SIZE - 1] = '\0';
+		if (_gn_leaf_scheduler_load(data, text) != GN_RET_OK)
+			ESP_LOGW(TAG, "[%s] stored jobs not valid", data->leaf_name);
+	}
+
+	while (true) {
+
+		if (xQueueReceive(gn_leaf_get_event_queue(leaf_config), &evt,
+				portMAX_DELAY) != pdPASS || !data || !text)
+			continue;
+
+		switch (evt.id) {
+
+		//parameter change
+		case GN_LEAF_PARAM_CHANGE_REQUEST_EVENT:
+
+			if (gn_leaf_event_mask_param(&evt,
+					data->gn_leaf_scheduler_jobs_param) == 0) {
+
+				memset(text, 0, GN_LEAF_SCHEDULER_TEXT_SIZE);
+				gn_event_payload_to_string(evt, text,
+						GN_LEAF_SCHEDULER_TEXT_SIZE - 1);
+
+				//execute change, refused by the validator if not valid.
+				//an empty text clears the jobs even if it cannot be stored
+				if (gn_leaf_param_force_string(leaf_config,
+						GN_LEAF_SCHEDULER_PARAM_JOBS, text) == GN_RET_OK
+						|| text[0] == '\0')
+					_gn_leaf_scheduler_load(data, text);
+				else
+					ESP_LOGW(TAG, "[%s] refused jobs '%s'", data->leaf_name,
+							text);
+
+			}
+			break;
+
+		default:
+			break;
+
+		}
+
+	}
+
+}
+
+#ifdef __cplusplus
+}
+#endif //__cplusplus
@@ -0,0 +1,38 @@
+// Copyright 2021 Nicola Muratori (nicola.muratori@gmail.com)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef MAIN_GN_LEAF_SCHEDULER_H_
+#define MAIN_GN_LEAF_SCHEDULER_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "grownode.h"
+
+static const char GN_LEAF_SCHEDULER_TYPE[] = "scheduler";
+
+static const char GN_LEAF_SCHEDULER_PARAM_JOBS[] = "jobs"; /*!< jobs separated by newline or ';', each "<spec> <leaf>.<param>=<value>". see gn_scheduler.h for the spec */
+
+#define GN_LEAF_SCHEDULER_MAX_JOBS 8
+
+gn_leaf_descriptor_handle_t gn_leaf_scheduler_config(
+		gn_leaf_handle_t leaf_config);
+
+#ifdef __cplusplus
+}
+#endif //__cplusplus
+
+#endif /* MAIN_GN_LEAF_SCHEDULER_H_ */
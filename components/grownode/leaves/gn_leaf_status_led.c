@@ -47,18 +47,22 @@ void gn_leaf_status_led_task(gn_leaf_handle_t leaf_config);
 
 typedef struct {
 	gn_leaf_param_handle_t gn_leaf_status_led_gpio_param;
+	volatile bool blink_requested; /*!< set by the event handler, blinked by the leaf task */
 } gn_leaf_status_led_data_t;
 
 gn_leaf_descriptor_handle_t gn_leaf_status_led_config(
 		gn_leaf_handle_t leaf_config) {
 
 	gn_leaf_descriptor_handle_t descriptor =
-			(gn_leaf_descriptor_handle_t) malloc(sizeof(gn_leaf_descriptor_t));
+			(gn_leaf_descriptor_handle_t) gn_mem_malloc(
+					gn_leaf_get_mem_tag(leaf_config), sizeof(gn_leaf_descriptor_t));
 	strncpy(descriptor->type, GN_LEAF_STATUS_LED_TYPE, GN_LEAF_DESC_TYPE_SIZE);
 	descriptor->callback = gn_leaf_status_led_task;
 	descriptor->status = GN_LEAF_STATUS_NOT_INITIALIZED;
 
-	gn_leaf_status_led_data_t *data = malloc(sizeof(gn_leaf_status_led_data_t));
+	gn_leaf_status_led_data_t *data = gn_mem_malloc(gn_leaf_get_mem_tag(leaf_config),
+			sizeof(gn_leaf_status_led_data_t));
+	data->blink_requested = false;
 
 	data->gn_leaf_status_led_gpio_param = gn_leaf_param_create(leaf_config,
 			GN_LEAF_STATUS_LED_PARAM_GPIO, GN_VAL_TYPE_DOUBLE, (gn_val_t ) {
@@ -94,19 +98,11 @@ void gn_leaf_led_status_event_handler(void *handler_args, esp_event_base_t base,
 
 	gn_leaf_handle_t leaf_config = (gn_leaf_handle_t) handler_args;
 
-	double gpio;
-	gn_leaf_param_get_double(leaf_config, GN_LEAF_STATUS_LED_PARAM_GPIO, &gpio);
-
-	//gn_leaf_config_handle_t leaf_config = (gn_leaf_config_handle_t) handler_args;
-
-	switch (event_id) {
+	gn_leaf_status_led_data_t *data =
+			(gn_leaf_status_led_data_t*) gn_leaf_get_descriptor(leaf_config)->data;
 
-	case GN_LEAF_PARAM_CHANGED_EVENT:
-		blink((int) gpio, 100, 1);
-		break;
-	default:
-		blink((int) gpio, 100, 1);
-	}
+	//this runs in the event loop task, blinking here would hold every other handler
+	data->blink_requested = true;
 
 }
 
@@ -118,6 +114,9 @@ void gn_leaf_status_led_task(gn_leaf_handle_t leaf_config) {
 
 	gn_leaf_parameter_event_t evt;
 
+	gn_leaf_status_led_data_t *data =
+			(gn_leaf_status_led_data_t*) gn_leaf_get_descriptor(leaf_config)->data;
+
 	double gpio;
 	gn_leaf_param_get_double(leaf_config, GN_LEAF_STATUS_LED_PARAM_GPIO, &gpio);
 
@@ -181,7 +180,12 @@ void gn_leaf_status_led_task(gn_leaf_handle_t leaf_config) {
 
 		}
 
-		vTaskDelay(1000 / portTICK_PERIOD_MS);
+		//one blink for any number of events received in the meantime
+		if (data->blink_requested) {
+			data->blink_requested = false;
+			blink((int) gpio, 100, 1);
+		}
+
 	}
 
 }
@@ -63,12 +63,14 @@ void blink_callback(const gn_leaf_handle_t leaf_config) {
 gn_leaf_descriptor_handle_t gn_led_config(gn_leaf_handle_t leaf_config) {
 
 	gn_leaf_descriptor_handle_t descriptor =
-			(gn_leaf_descriptor_handle_t) malloc(sizeof(gn_leaf_descriptor_t));
+			(gn_leaf_descriptor_handle_t) gn_mem_malloc(
+					gn_leaf_get_mem_tag(leaf_config), sizeof(gn_leaf_descriptor_t));
 	strncpy(descriptor->type, GN_LEAF_LED_TYPE, GN_LEAF_DESC_TYPE_SIZE);
 	descriptor->callback = gn_led_task;
 	descriptor->status = GN_LEAF_STATUS_NOT_INITIALIZED;
 
-	gn_led_data_t *data = malloc(sizeof(gn_led_data_t));
+	gn_led_data_t *data = gn_mem_malloc(gn_leaf_get_mem_tag(leaf_config),
+			sizeof(gn_led_data_t));
 
 	data->gn_led_status_param = gn_leaf_param_create(leaf_config,
 			GN_LED_PARAM_TOGGLE, GN_VAL_TYPE_BOOLEAN,
@@ -59,13 +59,15 @@ void gn_pump_task(gn_leaf_handle_t leaf_config);
 gn_leaf_descriptor_handle_t gn_pump_config(gn_leaf_handle_t leaf_config) {
 
 	gn_leaf_descriptor_handle_t descriptor =
-			(gn_leaf_descriptor_handle_t) malloc(sizeof(gn_leaf_descriptor_t));
+			(gn_leaf_descriptor_handle_t) gn_mem_malloc(
+					gn_leaf_get_mem_tag(leaf_config), sizeof(gn_leaf_descriptor_t));
 	strncpy(descriptor->type, GN_LEAF_PUMP_TYPE, GN_LEAF_DESC_TYPE_SIZE);
 	descriptor->callback = gn_pump_task;
 	descriptor->status = GN_LEAF_STATUS_NOT_INITIALIZED;
 	descriptor->data = NULL;
 
-	gn_pump_data_t *data = malloc(sizeof(gn_pump_data_t));
+	gn_pump_data_t *data = gn_mem_malloc(gn_leaf_get_mem_tag(leaf_config),
+			sizeof(gn_pump_data_t));
 
 	//parameter definition. if found in flash storage, they will be created with found values instead of default
 	data->gn_pump_toggle_param = gn_leaf_param_create(leaf_config,
@@ -43,6 +43,8 @@ extern "C" {
 #include "gn_pwm.h"
 #include <gn_gpio.h>
 #include "gn_capacitive_water_level.h"
+#include "gn_rules.h"
+#include "gn_scheduler.h"
 
 #include "gn_hydroboard2_watering_control.h"
 
@@ -72,7 +74,9 @@ typedef enum {
 
 typedef struct {
 
-	//esp_timer_handle_t watering_timer;
+	//starts a watering cycle a watering interval after the previous one
+	gn_scheduler_job_handle_t watering_job;
+	SemaphoreHandle_t watering_due;
 
 	gn_leaf_param_handle_t param_watering_interval;
 	gn_leaf_param_handle_t param_watering_time;
@@ -110,6 +114,9 @@ typedef struct {
 	gn_wat_status wat_cycle;
 	int64_t wat_cycle_cumulative_time_ms;
 
+	//user rules on top of the watering cycle, updatable from the network
+	gn_rules_handle_t rules;
+
 } gn_hb2_watering_control_data_t;
 
 gn_leaf_param_validator_result_t _gn_hb2_watering_interval_validator(
@@ -280,6 +287,24 @@ inline static bool _gn_hb2_watering_control_hcc_temp_ok(double p_wat_temp,
 			&& !_gn_hb2_watering_control_hcc_temp_high(p_wat_temp, p_wat_t_temp));
 }
 
+static void _gn_hb2_watering_job_callback(void *arg) {
+
+	gn_hb2_watering_control_data_t *data = (gn_hb2_watering_control_data_t*) arg;
+	xSemaphoreGive(data->watering_due);
+
+}
+
+static void _gn_hb2_watering_schedule(gn_hb2_watering_control_data_t *data,
+		double interval_sec) {
+
+	char spec[GN_SCHEDULER_SPEC_SIZE];
+	snprintf(spec, sizeof(spec), "@after %llus",
+			(unsigned long long) (interval_sec >= 1 ? interval_sec : 1));
+	if (gn_scheduler_job_start(data->watering_job, spec) != GN_RET_OK)
+		gn_log(TAG, GN_LOG_ERROR, "cannot schedule watering '%s'", spec);
+
+}
+
 void _gn_hb2_watering_callback_intl(gn_leaf_handle_t leaf_config) {
 
 	ESP_LOGD(TAG, "_gn_hb2_watering_callback");
@@ -337,7 +362,10 @@ void _gn_hb2_watering_callback_intl(gn_leaf_handle_t leaf_config) {
 	//infinite loop
 	while (true) {
 
-		vTaskDelay((p_wat_int_sec * 1000L) / portTICK_PERIOD_MS);
+		//waits for the watering job
+		xSemaphoreTake(data->watering_due, 0);
+		_gn_hb2_watering_schedule(data, p_wat_int_sec);
+		xSemaphoreTake(data->watering_due, portMAX_DELAY);
 
 		data->wat_cycle = WAT_OFF;
 
@@ -627,7 +655,8 @@ gn_leaf_descriptor_handle_t gn_hb2_watering_control_config(
 		gn_leaf_handle_t leaf_config) {
 
 	gn_leaf_descriptor_handle_t descriptor =
-			(gn_leaf_descriptor_handle_t) malloc(sizeof(gn_leaf_descriptor_t));
+			(gn_leaf_descriptor_handle_t) gn_mem_malloc(
+					gn_leaf_get_mem_tag(leaf_config), sizeof(gn_leaf_descriptor_t));
 	strncpy(descriptor->type, GN_LEAF_HYDROBOARD2_WATERING_CONTROL_TYPE,
 	GN_LEAF_DESC_TYPE_SIZE);
 	descriptor->callback = gn_hb2_watering_control_task;
@@ -636,8 +665,8 @@ gn_leaf_descriptor_handle_t gn_hb2_watering_control_config(
 
 	//gn_node_config_handle_t node_config = gn_leaf_get_node(leaf_config);
 
-	gn_hb2_watering_control_data_t *data = malloc(
-			sizeof(gn_hb2_watering_control_data_t));
+	gn_hb2_watering_control_data_t *data = gn_mem_malloc(
+			gn_leaf_get_mem_tag(leaf_config), sizeof(gn_hb2_watering_control_data_t));
 
 	data->wat_cycle = WAT_WAIT;
 	data->wat_cycle_cumulative_time_ms = 0;
@@ -749,6 +778,20 @@ gn_leaf_descriptor_handle_t gn_hb2_watering_control_config(
 			NULL);
 	gn_leaf_param_add_to_leaf(leaf_config, data->param_leaf_light_1_name);
 
+	data->rules = gn_rules_create(leaf_config, "");
+
+	data->watering_due = xSemaphoreCreateBinary();
+	const gn_scheduler_job_config_t watering_job = { .callback =
+			_gn_hb2_watering_job_callback, .arg = data, .name = "watering" };
+	if (!data->watering_due
+			|| gn_scheduler_job_create(&watering_job, &data->watering_job)
+					!= GN_RET_OK) {
+		gn_log(TAG, GN_LOG_ERROR, "cannot create the watering job");
+		descriptor->status = GN_LEAF_STATUS_ERROR;
+		descriptor->data = data;
+		return descriptor;
+	}
+
 	descriptor->status = GN_LEAF_STATUS_INITIALIZED;
 
 	descriptor->data = data;
@@ -936,9 +979,9 @@ void gn_hb2_watering_control_task(gn_leaf_handle_t leaf_config) {
 					gn_leaf_param_get_double(leaf_config,
 							GN_HYDROBOARD2_WAT_CTR_PARAM_WATERING_INTERVAL_SEC,
 							&p_wat_int_sec);
-					//esp_timer_stop(data->watering_timer);
-					//esp_timer_start_periodic(data->watering_timer,
-					//		p_wat_int_sec * 1000000);
+					//the wait in progress restarts with the new interval
+					if (data->wat_cycle == WAT_WAIT)
+						_gn_hb2_watering_schedule(data, p_wat_int_sec);
 				} else
 				//parameter is watering time
 				if (gn_leaf_event_mask_param(&evt,
@@ -973,6 +1016,8 @@ void gn_hb2_watering_control_task(gn_leaf_handle_t leaf_config) {
 					//			p_wat_int_sec * 1000000);
 					//}
 
+				} else if (gn_rules_param_event(data->rules, &evt)) {
+					//rules reloaded and applied to the current state
 				}
 				break;
 
@@ -981,6 +1026,8 @@ void gn_hb2_watering_control_task(gn_leaf_handle_t leaf_config) {
 				//ESP_LOGD(TAG, "notified update param %s, leaf %s, data = '%s'",
 				//		evt.param_name, evt.leaf_name, evt.data);
 
+				//only the rules reading the parameter are evaluated
+				gn_rules_on_change(data->rules, &evt);
 				break;
 
 			default:
@@ -990,8 +1037,6 @@ void gn_hb2_watering_control_task(gn_leaf_handle_t leaf_config) {
 
 		}
 
-		vTaskDelay(1000 / portTICK_PERIOD_MS);
-
 	}
 
 	//in case of error, the leaf goes in an infinite loop doing nothing
@@ -24,6 +24,7 @@ extern "C" {
 #include "freertos/semphr.h"
 
 #include "gn_commons.h"
+#include "gn_scheduler.h"
 
 #include "gn_pwm.h"
 
@@ -39,27 +40,29 @@ typedef struct {
 	gn_leaf_param_handle_t gn_syn_nft1_control_watering_enable_param;
 	gn_leaf_param_handle_t gn_syn_nft1_control_pump_leaf_param;
 
-	esp_timer_handle_t watering_cycle_start_timer;
-	esp_timer_handle_t watering_cycle_stop_timer;
+	gn_scheduler_job_handle_t watering_cycle_start_job;
+	gn_scheduler_job_handle_t watering_cycle_stop_job;
 
 } gn_syn_nft1_control_data_t;
 
 /**
- * stops timers and restart with new interval
+ * stops jobs and restart with new interval
  */
 void _gn_syn_nft1_change_interval(gn_syn_nft1_control_data_t *data) {
 
-	//stop timers
-	esp_timer_stop(data->watering_cycle_start_timer);
-	esp_timer_stop(data->watering_cycle_stop_timer);
+	//stop jobs
+	gn_scheduler_job_stop(data->watering_cycle_start_job);
+	gn_scheduler_job_stop(data->watering_cycle_stop_job);
 
 	double interval;
 	gn_leaf_param_get_value(data->gn_syn_nft1_control_watering_interval_param,
 			&interval);
 
-	//restart with new duration
-	esp_timer_start_periodic(data->watering_cycle_start_timer,
-			interval * 1000 * 1000);
+	//restart with new interval, on the wall clock grid once the time is set
+	char spec[GN_SCHEDULER_SPEC_SIZE];
+	snprintf(spec, sizeof(spec), "@every %llus",
+			(unsigned long long) (interval >= 1 ? interval : 1));
+	gn_scheduler_job_start(data->watering_cycle_start_job, spec);
 
 }
 
@@ -141,8 +144,12 @@ void watering_timer_start_callback(void *arg) {
 				(gn_syn_nft1_control_data_t*) desc->data;
 
 		//stops after a while
-		esp_timer_start_once(data->watering_cycle_stop_timer,
-				duration * 1000 * 1000);
+		char spec[GN_SCHEDULER_SPEC_SIZE];
+		snprintf(spec, sizeof(spec), "@after %llums",
+				(unsigned long long) (duration * 1000));
+		if (gn_scheduler_job_start(data->watering_cycle_stop_job, spec)
+				!= GN_RET_OK)
+			watering_timer_stop_callback(leaf);
 	}
 
 }
@@ -156,13 +163,14 @@ gn_leaf_descriptor_handle_t gn_syn_nft1_control_config(
 	ESP_LOGD(TAG, "[%s] gn_syn_nft1_control_config", leaf_name);
 
 	gn_leaf_descriptor_handle_t descriptor =
-			(gn_leaf_descriptor_handle_t) malloc(sizeof(gn_leaf_descriptor_t));
+			(gn_leaf_descriptor_handle_t) gn_mem_malloc(
+					gn_leaf_get_mem_tag(leaf_config), sizeof(gn_leaf_descriptor_t));
 	strncpy(descriptor->type, GN_SYN_NFT1_CONTROL_TYPE, GN_LEAF_DESC_TYPE_SIZE);
 	descriptor->callback = gn_syn_nft1_control_task;
 	descriptor->status = GN_LEAF_STATUS_NOT_INITIALIZED;
 
-	gn_syn_nft1_control_data_t *data = malloc(
-			sizeof(gn_syn_nft1_control_data_t));
+	gn_syn_nft1_control_data_t *data = gn_mem_malloc(
+			gn_leaf_get_mem_tag(leaf_config), sizeof(gn_syn_nft1_control_data_t));
 
 	data->gn_syn_nft1_control_watering_duration_param = gn_leaf_param_create(
 			leaf_config, GN_SYN_NFT1_CONTROL_PARAM_DURATION_SEC,
@@ -196,19 +204,19 @@ gn_leaf_descriptor_handle_t gn_syn_nft1_control_config(
 	gn_leaf_param_add_to_leaf(leaf_config,
 			data->gn_syn_nft1_control_pump_leaf_param);
 
-	const esp_timer_create_args_t watering_timer_start_args = { .callback =
+	const gn_scheduler_job_config_t watering_start_job = { .callback =
 			&watering_timer_start_callback, .name = "watering_start", .arg =
 			leaf_config };
 
-	esp_timer_create(&watering_timer_start_args,
-			&data->watering_cycle_start_timer);
+	gn_scheduler_job_create(&watering_start_job,
+			&data->watering_cycle_start_job);
 
-	const esp_timer_create_args_t watering_timer_stop_args = { .callback =
+	const gn_scheduler_job_config_t watering_stop_job = { .callback =
 			&watering_timer_stop_callback, .name = "watering_stop", .arg =
 			leaf_config };
 
-	esp_timer_create(&watering_timer_stop_args,
-			&data->watering_cycle_stop_timer);
+	gn_scheduler_job_create(&watering_stop_job,
+			&data->watering_cycle_stop_job);
 
 	descriptor->status = GN_LEAF_STATUS_INITIALIZED;
 	descriptor->data = data;
@@ -248,8 +256,7 @@ void gn_syn_nft1_control_task(gn_leaf_handle_t leaf_config) {
 			"configuring - duration %d, interval %d, enable %d, pump leaf '%s'",
 			(int )duration, (int )interval, enable, pump_leaf);
 
-	esp_timer_start_periodic(data->watering_cycle_start_timer,
-			interval * 1000 * 1000);
+	_gn_syn_nft1_change_interval(data);
 
 	//task cycle
 	while (true) {
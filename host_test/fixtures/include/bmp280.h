@@ -0,0 +1,87 @@
+// Copyright 2021 Nicola Muratori (nicola.muratori@gmail.com)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GN_SIM_BMP280_H_
+#define GN_SIM_BMP280_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "esp_err.h"
+#include "i2cdev.h"
+
+/*
+ * simulated BME280 with the esp-idf-lib bmp280 API. readings are set with gn_sim_bmp280_set()
+ */
+
+#define BMP280_I2C_ADDRESS_0 0x76
+#define BMP280_I2C_ADDRESS_1 0x77
+
+#define BMP280_CHIP_ID 0x58
+#define BME280_CHIP_ID 0x60
+
+typedef enum {
+	BMP280_MODE_SLEEP = 0, BMP280_MODE_FORCED = 1, BMP280_MODE_NORMAL = 3
+} BMP280_Mode;
+
+typedef enum {
+	BMP280_FILTER_OFF = 0, BMP280_FILTER_2 = 1, BMP280_FILTER_4 = 2,
+	BMP280_FILTER_8 = 3, BMP280_FILTER_16 = 4
+} BMP280_Filter;
+
+typedef enum {
+	BMP280_SKIPPED = 0, BMP280_ULTRA_LOW_POWER = 1, BMP280_LOW_POWER = 2,
+	BMP280_STANDARD = 3, BMP280_HIGH_RES = 4, BMP280_ULTRA_HIGH_RES = 5
+} BMP280_Oversampling;
+
+typedef enum {
+	BMP280_STANDBY_05 = 0, BMP280_STANDBY_62 = 1, BMP280_STANDBY_125 = 2,
+	BMP280_STANDBY_250 = 3, BMP280_STANDBY_500 = 4, BMP280_STANDBY_1000 = 5,
+	BMP280_STANDBY_2000 = 6, BMP280_STANDBY_4000 = 7,
+} BMP280_StandbyTime;
+
+typedef struct {
+	BMP280_Mode mode;
+	BMP280_Filter filter;
+	BMP280_Oversampling oversampling_pressure;
+	BMP280_Oversampling oversampling_temperature;
+	BMP280_Oversampling oversampling_humidity;
+	BMP280_StandbyTime standby;
+} bmp280_params_t;
+
+typedef struct {
+	uint16_t dig_T1;
+	int16_t dig_T2;
+	int16_t dig_T3;
+	i2c_dev_t i2c_dev;
+	uint8_t id;
+} bmp280_t;
+
+esp_err_t bmp280_init_desc(bmp280_t *dev, uint8_t addr, i2c_port_t port,
+		int sda_gpio, int scl_gpio);
+
+esp_err_t bmp280_free_desc(bmp280_t *dev);
+
+esp_err_t bmp280_init_default_params(bmp280_params_t *params);
+
+esp_err_t bmp280_init(bmp280_t *dev, bmp280_params_t *params);
+
+esp_err_t bmp280_force_measurement(bmp280_t *dev);
+
+esp_err_t bmp280_is_measuring(bmp280_t *dev, bool *busy);
+
+esp_err_t bmp280_read_float(bmp280_t *dev, float *temperature, float *pressure,
+		float *humidity);
+
+#endif /* GN_SIM_BMP280_H_ */
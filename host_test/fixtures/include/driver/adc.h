@@ -0,0 +1,119 @@
+// Copyright 2021 Nicola Muratori (nicola.muratori@gmail.com)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GN_SIM_DRIVER_ADC_H_
+#define GN_SIM_DRIVER_ADC_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "esp_err.h"
+#include "esp_bit_defs.h"
+
+/*
+ * simulated ADC1 of an ESP32, single conversions and the continuous (DMA) mode of ESP-IDF v4.4.
+ * every channel reads the level set with gn_sim_adc_set() plus uniform noise. continuous mode
+ * delivers a frame of conversions each time the sampling frequency would have filled it
+ */
+
+#define SOC_ADC_DIGI_MAX_BITWIDTH 12
+
+typedef enum {
+	ADC_UNIT_1 = 1, ADC_UNIT_2 = 2, ADC_UNIT_BOTH = 3, ADC_UNIT_MAX
+} adc_unit_t;
+
+typedef enum {
+	ADC_ATTEN_DB_0 = 0, ADC_ATTEN_DB_2_5, ADC_ATTEN_DB_6, ADC_ATTEN_DB_11,
+	ADC_ATTEN_MAX
+} adc_atten_t;
+
+typedef enum {
+	ADC_WIDTH_BIT_9 = 0, ADC_WIDTH_BIT_10, ADC_WIDTH_BIT_11, ADC_WIDTH_BIT_12,
+	ADC_WIDTH_MAX
+} adc_bits_width_t;
+
+typedef enum {
+	ADC1_CHANNEL_0 = 0, ADC1_CHANNEL_1, ADC1_CHANNEL_2, ADC1_CHANNEL_3,
+	ADC1_CHANNEL_4, ADC1_CHANNEL_5, ADC1_CHANNEL_6, ADC1_CHANNEL_7,
+	ADC1_CHANNEL_MAX
+} adc1_channel_t;
+
+esp_err_t adc1_config_width(adc_bits_width_t width_bit);
+
+esp_err_t adc1_config_channel_atten(adc1_channel_t channel, adc_atten_t atten);
+
+int adc1_get_raw(adc1_channel_t channel);
+
+//continuous mode
+
+typedef enum {
+	ADC_CONV_SINGLE_UNIT_1 = 1,
+	ADC_CONV_SINGLE_UNIT_2 = 2,
+	ADC_CONV_BOTH_UNIT = 3,
+	ADC_CONV_ALTER_UNIT = 7,
+	ADC_CONV_UNIT_MAX
+} adc_digi_convert_mode_t;
+
+typedef enum {
+	ADC_DIGI_OUTPUT_FORMAT_TYPE1, ADC_DIGI_OUTPUT_FORMAT_TYPE2
+} adc_digi_output_format_t;
+
+typedef struct {
+	uint32_t max_store_buf_size;
+	uint32_t conv_num_each_intr; /*!< bytes of conversions per interrupt */
+	uint32_t adc1_chan_mask;
+	uint32_t adc2_chan_mask;
+} adc_digi_init_config_t;
+
+typedef struct {
+	uint8_t atten;
+	uint8_t channel;
+	uint8_t unit;
+	uint8_t bit_width;
+} adc_digi_pattern_config_t;
+
+typedef struct {
+	bool conv_limit_en;
+	uint32_t conv_limit_num;
+	uint32_t pattern_num;
+	adc_digi_pattern_config_t *adc_pattern;
+	uint32_t sample_freq_hz;
+	adc_digi_convert_mode_t conv_mode;
+	adc_digi_output_format_t format;
+} adc_digi_configuration_t;
+
+typedef struct {
+	union {
+		struct {
+			uint16_t data :12;
+			uint16_t channel :4;
+		} type1;
+		uint16_t val;
+	};
+} adc_digi_output_data_t;
+
+esp_err_t adc_digi_initialize(const adc_digi_init_config_t *init_config);
+
+esp_err_t adc_digi_deinitialize(void);
+
+esp_err_t adc_digi_controller_configure(const adc_digi_configuration_t *config);
+
+esp_err_t adc_digi_start(void);
+
+esp_err_t adc_digi_stop(void);
+
+esp_err_t adc_digi_read_bytes(uint8_t *buf, uint32_t length_max,
+		uint32_t *out_length, uint32_t timeout_ms);
+
+#endif /* GN_SIM_DRIVER_ADC_H_ */
@@ -0,0 +1,129 @@
+// Copyright 2021 Nicola Muratori (nicola.muratori@gmail.com)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GN_SIM_DRIVER_LEDC_H_
+#define GN_SIM_DRIVER_LEDC_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "esp_err.h"
+#include "driver/gpio.h"
+
+/*
+ * simulated led controller: duties are recorded per channel and fades complete immediately,
+ * calling the registered fade end callback from the caller of ledc_fade_start()
+ */
+
+typedef enum {
+	LEDC_HIGH_SPEED_MODE = 0, LEDC_LOW_SPEED_MODE, LEDC_SPEED_MODE_MAX,
+} ledc_mode_t;
+
+typedef enum {
+	LEDC_INTR_DISABLE = 0, LEDC_INTR_FADE_END, LEDC_INTR_MAX,
+} ledc_intr_type_t;
+
+typedef enum {
+	LEDC_TIMER_0 = 0, LEDC_TIMER_1, LEDC_TIMER_2, LEDC_TIMER_3, LEDC_TIMER_MAX,
+} ledc_timer_t;
+
+typedef enum {
+	LEDC_CHANNEL_0 = 0, LEDC_CHANNEL_1, LEDC_CHANNEL_2, LEDC_CHANNEL_3,
+	LEDC_CHANNEL_4, LEDC_CHANNEL_5, LEDC_CHANNEL_6, LEDC_CHANNEL_7,
+	LEDC_CHANNEL_MAX,
+} ledc_channel_t;
+
+typedef enum {
+	LEDC_TIMER_1_BIT = 1, LEDC_TIMER_2_BIT, LEDC_TIMER_3_BIT, LEDC_TIMER_4_BIT,
+	LEDC_TIMER_5_BIT, LEDC_TIMER_6_BIT, LEDC_TIMER_7_BIT, LEDC_TIMER_8_BIT,
+	LEDC_TIMER_9_BIT, LEDC_TIMER_10_BIT, LEDC_TIMER_11_BIT, LEDC_TIMER_12_BIT,
+	LEDC_TIMER_13_BIT, LEDC_TIMER_14_BIT, LEDC_TIMER_15_BIT, LEDC_TIMER_16_BIT,
+	LEDC_TIMER_17_BIT, LEDC_TIMER_18_BIT, LEDC_TIMER_19_BIT, LEDC_TIMER_20_BIT,
+	LEDC_TIMER_BIT_MAX,
+} ledc_timer_bit_t;
+
+typedef enum {
+	LEDC_AUTO_CLK = 0, LEDC_USE_REF_TICK, LEDC_USE_APB_CLK, LEDC_USE_RTC8M_CLK,
+} ledc_clk_cfg_t;
+
+typedef enum {
+	LEDC_FADE_NO_WAIT = 0, LEDC_FADE_WAIT_DONE, LEDC_FADE_MAX,
+} ledc_fade_mode_t;
+
+typedef enum {
+	LEDC_FADE_END_EVT
+} ledc_cb_event_t;
+
+typedef struct {
+	ledc_mode_t speed_mode;
+	ledc_timer_bit_t duty_resolution;
+	ledc_timer_t timer_num;
+	uint32_t freq_hz;
+	ledc_clk_cfg_t clk_cfg;
+} ledc_timer_config_t;
+
+typedef struct {
+	int gpio_num;
+	ledc_mode_t speed_mode;
+	ledc_channel_t channel;
+	ledc_intr_type_t intr_type;
+	ledc_timer_t timer_sel;
+	uint32_t duty;
+	int hpoint;
+	struct {
+		unsigned int output_invert :1;
+	} flags;
+} ledc_channel_config_t;
+
+typedef struct {
+	ledc_cb_event_t event;
+	uint32_t speed_mode;
+	uint32_t channel;
+	uint32_t duty;
+} ledc_cb_param_t;
+
+typedef bool (*ledc_cb_t)(const ledc_cb_param_t *param, void *user_arg);
+
+typedef struct {
+	ledc_cb_t fade_cb;
+} ledc_cbs_t;
+
+esp_err_t ledc_timer_config(const ledc_timer_config_t *timer_conf);
+
+esp_err_t ledc_channel_config(const ledc_channel_config_t *ledc_conf);
+
+esp_err_t ledc_fade_func_install(int intr_alloc_flags);
+
+void ledc_fade_func_uninstall(void);
+
+esp_err_t ledc_cb_register(ledc_mode_t speed_mode, ledc_channel_t channel,
+		ledc_cbs_t *cbs, void *user_arg);
+
+esp_err_t ledc_set_duty(ledc_mode_t speed_mode, ledc_channel_t channel,
+		uint32_t duty);
+
+uint32_t ledc_get_duty(ledc_mode_t speed_mode, ledc_channel_t channel);
+
+esp_err_t ledc_update_duty(ledc_mode_t speed_mode, ledc_channel_t channel);
+
+esp_err_t ledc_set_fade_with_time(ledc_mode_t speed_mode,
+		ledc_channel_t channel, uint32_t target_duty, int max_fade_time_ms);
+
+esp_err_t ledc_fade_start(ledc_mode_t speed_mode, ledc_channel_t channel,
+		ledc_fade_mode_t fade_mode);
+
+esp_err_t ledc_stop(ledc_mode_t speed_mode, ledc_channel_t channel,
+		uint32_t idle_level);
+
+#endif /* GN_SIM_DRIVER_LEDC_H_ */
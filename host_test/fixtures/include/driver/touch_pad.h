@@ -0,0 +1,47 @@
+// Copyright 2021 Nicola Muratori (nicola.muratori@gmail.com)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GN_SIM_DRIVER_TOUCH_PAD_H_
+#define GN_SIM_DRIVER_TOUCH_PAD_H_
+
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "hal/touch_sensor_types.h"
+#include "soc/touch_sensor_channel.h"
+
+/*
+ * simulated touch sensor: raw readings are set with gn_sim_touch_pad_set()
+ */
+
+esp_err_t touch_pad_init(void);
+
+esp_err_t touch_pad_deinit(void);
+
+esp_err_t touch_pad_set_voltage(touch_high_volt_t refh, touch_low_volt_t refl,
+		touch_volt_atten_t atten);
+
+esp_err_t touch_pad_config(touch_pad_t touch_num, uint16_t threshold);
+
+esp_err_t touch_pad_filter_start(uint32_t filter_period_ms);
+
+esp_err_t touch_pad_clear_status(void);
+
+esp_err_t touch_pad_read(touch_pad_t touch_num, uint16_t *touch_value);
+
+esp_err_t touch_pad_read_raw_data(touch_pad_t touch_num, uint16_t *touch_value);
+
+esp_err_t touch_pad_read_filtered(touch_pad_t touch_num, uint16_t *touch_value);
+
+#endif /* GN_SIM_DRIVER_TOUCH_PAD_H_ */
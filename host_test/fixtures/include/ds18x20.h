@@ -0,0 +1,62 @@
+// Copyright 2021 Nicola Muratori (nicola.muratori@gmail.com)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GN_SIM_DS18X20_H_
+#define GN_SIM_DS18X20_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "esp_err.h"
+#include "driver/gpio.h"
+#include "onewire.h"
+
+/*
+ * simulated one wire bus with the esp-idf-lib ds18x20 API. sensors appear on a gpio
+ * when their temperature is set with gn_sim_ds18x20_set(). a conversion takes the time of the
+ * resolution set in the sensor scratchpad
+ */
+
+typedef uint64_t ds18x20_addr_t;
+
+#define DS18X20_ANY ((ds18x20_addr_t) 0xffffffffffffffffLL)
+
+#define DS18B20_FAMILY_ID 0x28
+#define DS18S20_FAMILY_ID 0x10
+
+esp_err_t ds18x20_scan_devices(gpio_num_t pin, ds18x20_addr_t *addr_list,
+		size_t addr_count, size_t *found);
+
+esp_err_t ds18x20_measure(gpio_num_t pin, ds18x20_addr_t addr, bool wait);
+
+esp_err_t ds18x20_read_scratchpad(gpio_num_t pin, ds18x20_addr_t addr,
+		uint8_t *buffer);
+
+esp_err_t ds18x20_write_scratchpad(gpio_num_t pin, ds18x20_addr_t addr,
+		uint8_t *buffer);
+
+esp_err_t ds18x20_read_temperature(gpio_num_t pin, ds18x20_addr_t addr,
+		float *temperature);
+
+esp_err_t ds18x20_measure_and_read(gpio_num_t pin, ds18x20_addr_t addr,
+		float *temperature);
+
+esp_err_t ds18x20_read_temp_multi(gpio_num_t pin, ds18x20_addr_t *addr_list,
+		size_t addr_count, float *result_list);
+
+esp_err_t ds18x20_measure_and_read_multi(gpio_num_t pin,
+		ds18x20_addr_t *addr_list, size_t addr_count, float *result_list);
+
+#endif /* GN_SIM_DS18X20_H_ */
@@ -0,0 +1,50 @@
+// Copyright 2021 Nicola Muratori (nicola.muratori@gmail.com)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GN_SIM_ESP_ADC_CAL_H_
+#define GN_SIM_ESP_ADC_CAL_H_
+
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "driver/adc.h"
+
+/*
+ * ADC characterization with the default reference, the simulated ADC is linear
+ */
+
+typedef enum {
+	ESP_ADC_CAL_VAL_EFUSE_VREF = 0,
+	ESP_ADC_CAL_VAL_EFUSE_TP = 1,
+	ESP_ADC_CAL_VAL_DEFAULT_VREF = 2,
+	ESP_ADC_CAL_VAL_MAX
+} esp_adc_cal_value_t;
+
+typedef struct {
+	adc_unit_t adc_num;
+	adc_atten_t atten;
+	adc_bits_width_t bit_width;
+	uint32_t coeff_a;
+	uint32_t coeff_b;
+	uint32_t vref;
+} esp_adc_cal_characteristics_t;
+
+esp_adc_cal_value_t esp_adc_cal_characterize(adc_unit_t adc_num,
+		adc_atten_t atten, adc_bits_width_t bit_width, uint32_t default_vref,
+		esp_adc_cal_characteristics_t *chars);
+
+uint32_t esp_adc_cal_raw_to_voltage(uint32_t adc_reading,
+		const esp_adc_cal_characteristics_t *chars);
+
+#endif /* GN_SIM_ESP_ADC_CAL_H_ */
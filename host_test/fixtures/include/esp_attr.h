@@ -0,0 +1,35 @@
+// Copyright 2021 Nicola Muratori (nicola.muratori@gmail.com)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GN_SIM_ESP_ATTR_H_
+#define GN_SIM_ESP_ATTR_H_
+
+/*
+ * memory placement attributes have no meaning on the host: RTC memory is plain memory
+ * that survives a simulated light sleep, and is lost when the process ends
+ */
+
+#define IRAM_ATTR
+#define DRAM_ATTR
+#define RTC_DATA_ATTR
+#define RTC_NOINIT_ATTR
+#define RTC_FAST_ATTR
+#define RTC_SLOW_ATTR
+#define RTC_IRAM_ATTR
+#define RTC_RODATA_ATTR
+#define EXT_RAM_ATTR
+#define NOINIT_ATTR
+#define WORD_ALIGNED_ATTR __attribute__((aligned(4)))
+
+#endif /* GN_SIM_ESP_ATTR_H_ */
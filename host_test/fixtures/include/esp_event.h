@@ -0,0 +1,94 @@
+// Copyright 2021 Nicola Muratori (nicola.muratori@gmail.com)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GN_SIM_ESP_EVENT_H_
+#define GN_SIM_ESP_EVENT_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+
+#include "esp_event_base.h"
+
+/*
+ * event loops with a dedicated task copy the posted data and dispatch it from the loop thread,
+ * so handlers run concurrently with the poster as they do on the board
+ */
+
+typedef struct {
+	int32_t queue_size;
+	const char *task_name;
+	UBaseType_t task_priority;
+	uint32_t task_stack_size;
+	BaseType_t task_core_id;
+} esp_event_loop_args_t;
+
+esp_err_t esp_event_loop_create(const esp_event_loop_args_t *event_loop_args,
+		esp_event_loop_handle_t *event_loop);
+
+esp_err_t esp_event_loop_delete(esp_event_loop_handle_t event_loop);
+
+esp_err_t esp_event_loop_create_default(void);
+
+esp_err_t esp_event_loop_delete_default(void);
+
+esp_err_t esp_event_handler_register(esp_event_base_t event_base,
+		int32_t event_id, esp_event_handler_t event_handler,
+		void *event_handler_arg);
+
+esp_err_t esp_event_handler_register_with(esp_event_loop_handle_t event_loop,
+		esp_event_base_t event_base, int32_t event_id,
+		esp_event_handler_t event_handler, void *event_handler_arg);
+
+esp_err_t esp_event_handler_instance_register_with(
+		esp_event_loop_handle_t event_loop, esp_event_base_t event_base,
+		int32_t event_id, esp_event_handler_t event_handler,
+		void *event_handler_arg, esp_event_handler_instance_t *instance);
+
+esp_err_t esp_event_handler_instance_register(esp_event_base_t event_base,
+		int32_t event_id, esp_event_handler_t event_handler,
+		void *event_handler_arg, esp_event_handler_instance_t *instance);
+
+esp_err_t esp_event_handler_unregister(esp_event_base_t event_base,
+		int32_t event_id, esp_event_handler_t event_handler);
+
+esp_err_t esp_event_handler_unregister_with(esp_event_loop_handle_t event_loop,
+		esp_event_base_t event_base, int32_t event_id,
+		esp_event_handler_t event_handler);
+
+esp_err_t esp_event_handler_instance_unregister_with(
+		esp_event_loop_handle_t event_loop, esp_event_base_t event_base,
+		int32_t event_id, esp_event_handler_instance_t instance);
+
+esp_err_t esp_event_handler_instance_unregister(esp_event_base_t event_base,
+		int32_t event_id, esp_event_handler_instance_t instance);
+
+esp_err_t esp_event_post(esp_event_base_t event_base, int32_t event_id,
+		void *event_data, size_t event_data_size, TickType_t ticks_to_wait);
+
+esp_err_t esp_event_post_to(esp_event_loop_handle_t event_loop,
+		esp_event_base_t event_base, int32_t event_id, void *event_data,
+		size_t event_data_size, TickType_t ticks_to_wait);
+
+esp_err_t esp_event_isr_post_to(esp_event_loop_handle_t event_loop,
+		esp_event_base_t event_base, int32_t event_id, void *event_data,
+		size_t event_data_size, BaseType_t *task_unblocked);
+
+#endif /* GN_SIM_ESP_EVENT_H_ */
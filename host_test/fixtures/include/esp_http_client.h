@@ -0,0 +1,94 @@
+// Copyright 2021 Nicola Muratori (nicola.muratori@gmail.com)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GN_SIM_ESP_HTTP_CLIENT_H_
+#define GN_SIM_ESP_HTTP_CLIENT_H_
+
+#include <stdbool.h>
+
+#include "esp_err.h"
+
+typedef struct esp_http_client *esp_http_client_handle_t;
+
+typedef enum {
+	HTTP_EVENT_ERROR = 0,
+	HTTP_EVENT_ON_CONNECTED,
+	HTTP_EVENT_HEADERS_SENT,
+	HTTP_EVENT_ON_HEADER,
+	HTTP_EVENT_ON_DATA,
+	HTTP_EVENT_ON_FINISH,
+	HTTP_EVENT_DISCONNECTED,
+} esp_http_client_event_id_t;
+
+typedef struct esp_http_client_event {
+	esp_http_client_event_id_t event_id;
+	esp_http_client_handle_t client;
+	void *data;
+	int data_len;
+	void *user_data;
+	char *header_key;
+	char *header_value;
+} esp_http_client_event_t;
+
+typedef esp_err_t (*http_event_handle_cb)(esp_http_client_event_t *evt);
+
+typedef struct {
+	const char *url;
+	const char *host;
+	int port;
+	const char *path;
+	const char *cert_pem;
+	int timeout_ms;
+	int buffer_size;
+	bool keep_alive_enable;
+	http_event_handle_cb event_handler;
+	void *user_data;
+} esp_http_client_config_t;
+
+/*
+ * the client reads the resources registered with gn_sim_http_serve(), unknown urls answer 404.
+ * responses carry an ETag computed from the content, the only header passed to the event handler
+ */
+
+esp_http_client_handle_t esp_http_client_init(
+		const esp_http_client_config_t *config);
+
+/**
+ * @brief	only "Range: bytes=<offset>-" is understood, answered with 206, and "If-Range"
+ * with an ETag: when it does not match the range is ignored
+ */
+esp_err_t esp_http_client_set_header(esp_http_client_handle_t client,
+		const char *key, const char *value);
+
+esp_err_t esp_http_client_open(esp_http_client_handle_t client, int write_len);
+
+/**
+ * @brief	content length of the response
+ */
+int esp_http_client_fetch_headers(esp_http_client_handle_t client);
+
+int esp_http_client_get_status_code(esp_http_client_handle_t client);
+
+/**
+ * @brief	bytes of the body copied in the buffer, 0 at the end
+ */
+int esp_http_client_read(esp_http_client_handle_t client, char *buffer, int len);
+
+bool esp_http_client_is_complete_data_received(esp_http_client_handle_t client);
+
+esp_err_t esp_http_client_close(esp_http_client_handle_t client);
+
+esp_err_t esp_http_client_cleanup(esp_http_client_handle_t client);
+
+#endif /* GN_SIM_ESP_HTTP_CLIENT_H_ */
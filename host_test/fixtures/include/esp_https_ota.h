@@ -0,0 +1,26 @@
+// Copyright 2021 Nicola Muratori (nicola.muratori@gmail.com)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GN_SIM_ESP_HTTPS_OTA_H_
+#define GN_SIM_ESP_HTTPS_OTA_H_
+
+#include "esp_err.h"
+#include "esp_http_client.h"
+
+/**
+ * @brief	there is no firmware to flash on the host: always fails with ESP_ERR_NOT_SUPPORTED
+ */
+esp_err_t esp_https_ota(const esp_http_client_config_t *config);
+
+#endif /* GN_SIM_ESP_HTTPS_OTA_H_ */
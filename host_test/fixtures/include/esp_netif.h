@@ -0,0 +1,112 @@
+// Copyright 2021 Nicola Muratori (nicola.muratori@gmail.com)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GN_SIM_ESP_NETIF_H_
+#define GN_SIM_ESP_NETIF_H_
+
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "esp_event_base.h"
+
+typedef struct {
+	uint32_t addr;
+} esp_ip4_addr_t;
+
+typedef struct {
+	uint32_t addr[4];
+	uint8_t zone;
+} esp_ip6_addr_t;
+
+typedef struct {
+	union {
+		esp_ip6_addr_t ip6;
+		esp_ip4_addr_t ip4;
+	} u_addr;
+	uint8_t type;
+} esp_ip_addr_t;
+
+typedef struct {
+	esp_ip4_addr_t ip;
+	esp_ip4_addr_t netmask;
+	esp_ip4_addr_t gw;
+} esp_netif_ip_info_t;
+
+typedef struct {
+	esp_ip_addr_t ip;
+} esp_netif_dns_info_t;
+
+typedef enum {
+	ESP_NETIF_DNS_MAIN, ESP_NETIF_DNS_BACKUP, ESP_NETIF_DNS_FALLBACK, ESP_NETIF_DNS_MAX
+} esp_netif_dns_type_t;
+
+typedef struct esp_netif_obj esp_netif_t;
+
+typedef struct {
+	int if_index;
+	esp_netif_t *esp_netif;
+	esp_netif_ip_info_t ip_info;
+	bool ip_changed;
+} ip_event_got_ip_t;
+
+typedef enum {
+	IP_EVENT_STA_GOT_IP, IP_EVENT_STA_LOST_IP, IP_EVENT_AP_STAIPASSIGNED,
+} ip_event_t;
+
+ESP_EVENT_DECLARE_BASE(IP_EVENT);
+
+#define esp_ip4_addr1(ipaddr) (((const uint8_t*)(&(ipaddr)->addr))[0])
+#define esp_ip4_addr2(ipaddr) (((const uint8_t*)(&(ipaddr)->addr))[1])
+#define esp_ip4_addr3(ipaddr) (((const uint8_t*)(&(ipaddr)->addr))[2])
+#define esp_ip4_addr4(ipaddr) (((const uint8_t*)(&(ipaddr)->addr))[3])
+
+#define IP2STR(ipaddr) esp_ip4_addr1(ipaddr), esp_ip4_addr2(ipaddr), esp_ip4_addr3(ipaddr), esp_ip4_addr4(ipaddr)
+#define IPSTR "%d.%d.%d.%d"
+
+#define ESP_IP4TOADDR(a, b, c, d) ((uint32_t) (d) << 24 | (uint32_t) (c) << 16 | (uint32_t) (b) << 8 | (uint32_t) (a))
+
+esp_err_t esp_netif_init(void);
+
+esp_netif_t* esp_netif_create_default_wifi_sta(void);
+
+esp_netif_t* esp_netif_create_default_wifi_ap(void);
+
+esp_err_t esp_netif_dhcpc_start(esp_netif_t *esp_netif);
+
+esp_err_t esp_netif_dhcpc_stop(esp_netif_t *esp_netif);
+
+esp_err_t esp_netif_set_ip_info(esp_netif_t *esp_netif,
+		const esp_netif_ip_info_t *ip_info);
+
+esp_err_t esp_netif_get_ip_info(esp_netif_t *esp_netif,
+		esp_netif_ip_info_t *ip_info);
+
+esp_err_t esp_netif_set_dns_info(esp_netif_t *esp_netif,
+		esp_netif_dns_type_t type, esp_netif_dns_info_t *dns);
+
+esp_err_t esp_netif_get_dns_info(esp_netif_t *esp_netif,
+		esp_netif_dns_type_t type, esp_netif_dns_info_t *dns);
+
+//legacy adapter API, still used by gn_wifi_get_ip()
+
+typedef esp_netif_ip_info_t tcpip_adapter_ip_info_t;
+
+typedef enum {
+	TCPIP_ADAPTER_IF_STA, TCPIP_ADAPTER_IF_AP, TCPIP_ADAPTER_IF_MAX
+} tcpip_adapter_if_t;
+
+esp_err_t tcpip_adapter_get_ip_info(tcpip_adapter_if_t tcpip_if,
+		tcpip_adapter_ip_info_t *ip_info);
+
+#endif /* GN_SIM_ESP_NETIF_H_ */
@@ -0,0 +1,68 @@
+// Copyright 2021 Nicola Muratori (nicola.muratori@gmail.com)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GN_SIM_ESP_OTA_OPS_H_
+#define GN_SIM_ESP_OTA_OPS_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "esp_err.h"
+#include "esp_partition.h"
+
+#define OTA_SIZE_UNKNOWN 0xffffffff
+#define OTA_WITH_SEQUENTIAL_WRITES 0xfffffffe
+
+typedef uint32_t esp_ota_handle_t;
+
+typedef struct {
+	uint32_t magic_word;
+	uint32_t secure_version;
+	uint32_t reserv1[2];
+	char version[32];
+	char project_name[32];
+	char time[16];
+	char date[16];
+	char idf_ver[32];
+} esp_app_desc_t;
+
+const esp_partition_t* esp_ota_get_running_partition(void);
+
+const esp_app_desc_t* esp_ota_get_app_description(void);
+
+/**
+ * @brief	the OTA partition not running, see gn_sim_ota_get_update()
+ */
+const esp_partition_t* esp_ota_get_next_update_partition(
+		const esp_partition_t *start_from);
+
+esp_err_t esp_ota_begin(const esp_partition_t *partition, size_t image_size,
+		esp_ota_handle_t *out_handle);
+
+esp_err_t esp_ota_write(esp_ota_handle_t handle, const void *data, size_t size);
+
+esp_err_t esp_ota_write_with_offset(esp_ota_handle_t handle, const void *data,
+		size_t size, uint32_t offset);
+
+/**
+ * @brief	fails with ESP_ERR_OTA_VALIDATE_FAILED if nothing was written
+ */
+esp_err_t esp_ota_end(esp_ota_handle_t handle);
+
+esp_err_t esp_ota_abort(esp_ota_handle_t handle);
+
+esp_err_t esp_ota_set_boot_partition(const esp_partition_t *partition);
+
+#endif /* GN_SIM_ESP_OTA_OPS_H_ */
@@ -0,0 +1,47 @@
+// Copyright 2021 Nicola Muratori (nicola.muratori@gmail.com)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef GN_SIM_ESP_PARTITION_H_
+#define GN_SIM_ESP_PARTITION_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "esp_err.h"
+
+typedef struct {
+	int type;
+	int subtype;
+	uint32_t address;
+	uint32_t size;
+	char label[17];
+	bool encrypted;
+} esp_partition_t;
+
+esp_err_t esp_partition_read(const esp_partition_t *partition,
+		size_t src_offset, void *dst, size_t size);
+
+esp_err_t esp_partition_erase_range(const esp_partition_t *partition,
+		size_t offset, size_t size);
+
+/**
+ * @brief	as IDF for app partitions, the SHA-256 appended to the image set by gn_sim_ota_set_running():
+ * 			its last 32 bytes, checked against the rest. ESP_ERR_NOT_FOUND if there is no image
+ */
+esp_err_t esp_partition_get_sha256(const esp_partition_t *partition,
+		uint8_t *sha_256);
+
+#endif /* GN_SIM_ESP_PARTITION_H_ */
@@ -0,0 +1,51 @@
+// Copyright 2021 Nicola Muratori (nicola.muratori@gmail.com)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GN_SIM_ESP_SLEEP_H_
+#define GN_SIM_ESP_SLEEP_H_
+
+#include <stdint.h>
+
+#include "esp_err.h"
+
+typedef enum {
+	ESP_SLEEP_WAKEUP_UNDEFINED,
+	ESP_SLEEP_WAKEUP_ALL,
+	ESP_SLEEP_WAKEUP_EXT0,
+	ESP_SLEEP_WAKEUP_EXT1,
+	ESP_SLEEP_WAKEUP_TIMER,
+	ESP_SLEEP_WAKEUP_TOUCHPAD,
+	ESP_SLEEP_WAKEUP_ULP,
+	ESP_SLEEP_WAKEUP_GPIO,
+} esp_sleep_source_t;
+
+typedef esp_sleep_source_t esp_sleep_wakeup_cause_t;
+
+esp_err_t esp_sleep_enable_timer_wakeup(uint64_t time_in_us);
+
+/**
+ * @brief	blocks the caller for the configured wakeup time. other tasks keep running
+ */
+esp_err_t esp_light_sleep_start(void);
+
+/**
+ * @brief	on the host a deep sleep ends the process
+ */
+void esp_deep_sleep(uint64_t time_in_us) __attribute__ ((noreturn));
+
+void esp_deep_sleep_start(void) __attribute__ ((noreturn));
+
+esp_sleep_wakeup_cause_t esp_sleep_get_wakeup_cause(void);
+
+#endif /* GN_SIM_ESP_SLEEP_H_ */
@@ -0,0 +1,52 @@
+// Copyright 2021 Nicola Muratori (nicola.muratori@gmail.com)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GN_SIM_ESP_SNTP_H_
+#define GN_SIM_ESP_SNTP_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+#include <sys/time.h>
+
+/*
+ * the host clock is already synchronized: sntp reports completion as soon as it is started
+ */
+
+#define SNTP_OPMODE_POLL 0
+#define SNTP_OPMODE_LISTENONLY 1
+
+typedef enum {
+	SNTP_SYNC_STATUS_RESET, SNTP_SYNC_STATUS_COMPLETED, SNTP_SYNC_STATUS_IN_PROGRESS,
+} sntp_sync_status_t;
+
+typedef void (*sntp_sync_time_cb_t)(struct timeval *tv);
+
+void sntp_setoperatingmode(uint8_t operating_mode);
+
+void sntp_setservername(uint8_t idx, const char *server);
+
+void sntp_servermode_dhcp(int set_servers_from_dhcp);
+
+void sntp_set_time_sync_notification_cb(sntp_sync_time_cb_t callback);
+
+void sntp_init(void);
+
+void sntp_stop(void);
+
+bool sntp_enabled(void);
+
+sntp_sync_status_t sntp_get_sync_status(void);
+
+#endif /* GN_SIM_ESP_SNTP_H_ */
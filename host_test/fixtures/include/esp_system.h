@@ -0,0 +1,60 @@
+// Copyright 2021 Nicola Muratori (nicola.muratori@gmail.com)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GN_SIM_ESP_SYSTEM_H_
+#define GN_SIM_ESP_SYSTEM_H_
+
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "esp_attr.h"
+#include "esp_bit_defs.h"
+#include "esp_heap_caps.h"
+
+typedef enum {
+	ESP_RST_UNKNOWN,
+	ESP_RST_POWERON,
+	ESP_RST_EXT,
+	ESP_RST_SW,
+	ESP_RST_PANIC,
+	ESP_RST_INT_WDT,
+	ESP_RST_TASK_WDT,
+	ESP_RST_WDT,
+	ESP_RST_DEEPSLEEP,
+	ESP_RST_BROWNOUT,
+	ESP_RST_SDIO,
+} esp_reset_reason_t;
+
+typedef enum {
+	ESP_MAC_WIFI_STA, ESP_MAC_WIFI_SOFTAP, ESP_MAC_BT, ESP_MAC_ETH,
+} esp_mac_type_t;
+
+/**
+ * @brief	on the host a restart ends the process, see gn_sim.h to intercept it
+ */
+void esp_restart(void) __attribute__ ((noreturn));
+
+esp_reset_reason_t esp_reset_reason(void);
+
+uint32_t esp_get_free_heap_size(void);
+
+uint32_t esp_get_minimum_free_heap_size(void);
+
+esp_err_t esp_efuse_mac_get_default(uint8_t *mac);
+
+esp_err_t esp_read_mac(uint8_t *mac, esp_mac_type_t type);
+
+uint32_t esp_random(void);
+
+#endif /* GN_SIM_ESP_SYSTEM_H_ */
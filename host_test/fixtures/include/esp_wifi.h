@@ -0,0 +1,157 @@
+// Copyright 2021 Nicola Muratori (nicola.muratori@gmail.com)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GN_SIM_ESP_WIFI_H_
+#define GN_SIM_ESP_WIFI_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "esp_err.h"
+#include "esp_event_base.h"
+#include "esp_netif.h"
+
+/*
+ * the simulated station is always provisioned and associates to a single access point.
+ * events are posted to the default event loop as the wifi driver does
+ */
+
+typedef struct {
+	int static_rx_buf_num;
+	int dynamic_rx_buf_num;
+	int tx_buf_type;
+	int magic;
+} wifi_init_config_t;
+
+#define WIFI_INIT_CONFIG_MAGIC 0x1F2F3F4F
+#define WIFI_INIT_CONFIG_DEFAULT() { .static_rx_buf_num = 10, .dynamic_rx_buf_num = 32, .tx_buf_type = 1, .magic = WIFI_INIT_CONFIG_MAGIC }
+
+typedef enum {
+	WIFI_MODE_NULL, WIFI_MODE_STA, WIFI_MODE_AP, WIFI_MODE_APSTA, WIFI_MODE_MAX
+} wifi_mode_t;
+
+typedef enum {
+	WIFI_IF_STA, WIFI_IF_AP,
+} wifi_interface_t;
+
+typedef enum {
+	WIFI_STORAGE_FLASH, WIFI_STORAGE_RAM,
+} wifi_storage_t;
+
+typedef enum {
+	WIFI_PS_NONE, WIFI_PS_MIN_MODEM, WIFI_PS_MAX_MODEM,
+} wifi_ps_type_t;
+
+typedef enum {
+	WIFI_AUTH_OPEN, WIFI_AUTH_WEP, WIFI_AUTH_WPA_PSK, WIFI_AUTH_WPA2_PSK,
+} wifi_auth_mode_t;
+
+typedef struct {
+	uint8_t ssid[32];
+	uint8_t password[64];
+	int scan_method;
+	bool bssid_set;
+	uint8_t bssid[6];
+	uint8_t channel;
+	uint16_t listen_interval;
+	int sort_method;
+} wifi_sta_config_t;
+
+typedef struct {
+	uint8_t ssid[32];
+	uint8_t password[64];
+	uint8_t ssid_len;
+	uint8_t channel;
+	wifi_auth_mode_t authmode;
+	uint8_t max_connection;
+} wifi_ap_config_t;
+
+typedef union {
+	wifi_ap_config_t ap;
+	wifi_sta_config_t sta;
+} wifi_config_t;
+
+typedef struct {
+	uint8_t bssid[6];
+	uint8_t ssid[33];
+	uint8_t primary;
+	int8_t rssi;
+	wifi_auth_mode_t authmode;
+} wifi_ap_record_t;
+
+typedef enum {
+	WIFI_EVENT_WIFI_READY = 0,
+	WIFI_EVENT_SCAN_DONE,
+	WIFI_EVENT_STA_START,
+	WIFI_EVENT_STA_STOP,
+	WIFI_EVENT_STA_CONNECTED,
+	WIFI_EVENT_STA_DISCONNECTED,
+	WIFI_EVENT_STA_AUTHMODE_CHANGE,
+} wifi_event_t;
+
+typedef enum {
+	WIFI_REASON_UNSPECIFIED = 1,
+	WIFI_REASON_AUTH_EXPIRE = 2,
+	WIFI_REASON_AUTH_LEAVE = 3,
+	WIFI_REASON_ASSOC_EXPIRE = 4,
+	WIFI_REASON_ASSOC_LEAVE = 8,
+	WIFI_REASON_BEACON_TIMEOUT = 200,
+	WIFI_REASON_NO_AP_FOUND = 201,
+	WIFI_REASON_AUTH_FAIL = 202,
+} wifi_err_reason_t;
+
+typedef struct {
+	uint8_t ssid[32];
+	uint8_t ssid_len;
+	uint8_t bssid[6];
+	uint8_t channel;
+	wifi_auth_mode_t authmode;
+} wifi_event_sta_connected_t;
+
+typedef struct {
+	uint8_t ssid[32];
+	uint8_t ssid_len;
+	uint8_t bssid[6];
+	uint8_t reason;
+} wifi_event_sta_disconnected_t;
+
+ESP_EVENT_DECLARE_BASE(WIFI_EVENT);
+
+esp_err_t esp_wifi_init(const wifi_init_config_t *config);
+
+esp_err_t esp_wifi_deinit(void);
+
+esp_err_t esp_wifi_set_mode(wifi_mode_t mode);
+
+esp_err_t esp_wifi_set_storage(wifi_storage_t storage);
+
+esp_err_t esp_wifi_set_ps(wifi_ps_type_t type);
+
+esp_err_t esp_wifi_start(void);
+
+esp_err_t esp_wifi_stop(void);
+
+esp_err_t esp_wifi_connect(void);
+
+esp_err_t esp_wifi_disconnect(void);
+
+esp_err_t esp_wifi_get_config(wifi_interface_t interface, wifi_config_t *conf);
+
+esp_err_t esp_wifi_set_config(wifi_interface_t interface, wifi_config_t *conf);
+
+esp_err_t esp_wifi_get_mac(wifi_interface_t ifx, uint8_t mac[6]);
+
+esp_err_t esp_wifi_sta_get_ap_info(wifi_ap_record_t *ap_info);
+
+#endif /* GN_SIM_ESP_WIFI_H_ */
@@ -0,0 +1,72 @@
+// Copyright 2021 Nicola Muratori (nicola.muratori@gmail.com)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * host shim of the FreeRTOS kernel API used by grownode, implemented on top of pthreads.
+ * one tick is one millisecond.
+ */
+
+#ifndef GN_SIM_FREERTOS_H_
+#define GN_SIM_FREERTOS_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <inttypes.h>
+//the esp-idf port headers pull these in, and the sources rely on it
+#include <stdlib.h>
+#include <string.h>
+
+#include "sdkconfig.h"
+#include "esp_err.h"
+//included by the esp-idf port for run time stats
+#include "esp_timer.h"
+
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+typedef uint32_t TickType_t;
+typedef uint32_t StackType_t;
+
+#define portBASE_TYPE long
+#define portMAX_DELAY ((TickType_t) 0xffffffffUL)
+#define portTICK_PERIOD_MS ((TickType_t) 1)
+#define portTICK_RATE_MS portTICK_PERIOD_MS
+#define configTICK_RATE_HZ 1000
+#define configMAX_PRIORITIES 25
+#define configMINIMAL_STACK_SIZE 768
+#define tskIDLE_PRIORITY 0
+#define tskNO_AFFINITY 0x7FFFFFFF
+
+#define pdFALSE ((BaseType_t) 0)
+#define pdTRUE ((BaseType_t) 1)
+#define pdPASS pdTRUE
+#define pdFAIL pdFALSE
+#define errQUEUE_EMPTY ((BaseType_t) 0)
+#define errQUEUE_FULL ((BaseType_t) 0)
+
+#define pdMS_TO_TICKS(xTimeInMs) ((TickType_t) (xTimeInMs))
+#define pdTICKS_TO_MS(xTicks) ((uint32_t) (xTicks))
+
+#define portYIELD_FROM_ISR(x) ((void) (x))
+//there are no interrupts on the host: all critical sections share one recursive lock
+void gn_sim_enter_critical(void);
+void gn_sim_exit_critical(void);
+#define portENTER_CRITICAL(mux) ((void) (mux), gn_sim_enter_critical())
+#define portEXIT_CRITICAL(mux) ((void) (mux), gn_sim_exit_critical())
+#define portMUX_INITIALIZER_UNLOCKED 0
+#define portMUX_INITIALIZE(mux) (*(mux) = portMUX_INITIALIZER_UNLOCKED)
+
+typedef int portMUX_TYPE;
+
+#endif /* GN_SIM_FREERTOS_H_ */
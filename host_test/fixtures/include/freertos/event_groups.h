@@ -0,0 +1,42 @@
+// Copyright 2021 Nicola Muratori (nicola.muratori@gmail.com)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GN_SIM_FREERTOS_EVENT_GROUPS_H_
+#define GN_SIM_FREERTOS_EVENT_GROUPS_H_
+
+#include "freertos/FreeRTOS.h"
+
+typedef struct gn_sim_event_group *EventGroupHandle_t;
+
+typedef TickType_t EventBits_t;
+
+EventGroupHandle_t xEventGroupCreate(void);
+
+void vEventGroupDelete(EventGroupHandle_t xEventGroup);
+
+EventBits_t xEventGroupSetBits(EventGroupHandle_t xEventGroup,
+		const EventBits_t uxBitsToSet);
+
+EventBits_t xEventGroupClearBits(EventGroupHandle_t xEventGroup,
+		const EventBits_t uxBitsToClear);
+
+EventBits_t xEventGroupGetBits(EventGroupHandle_t xEventGroup);
+
+EventBits_t xEventGroupWaitBits(EventGroupHandle_t xEventGroup,
+		const EventBits_t uxBitsToWaitFor, const BaseType_t xClearOnExit,
+		const BaseType_t xWaitForAllBits, TickType_t xTicksToWait);
+
+#define xEventGroupSetBitsFromISR(g, b, w) xEventGroupSetBits(g, b)
+
+#endif /* GN_SIM_FREERTOS_EVENT_GROUPS_H_ */
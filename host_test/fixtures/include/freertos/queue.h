@@ -0,0 +1,49 @@
+// Copyright 2021 Nicola Muratori (nicola.muratori@gmail.com)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GN_SIM_FREERTOS_QUEUE_H_
+#define GN_SIM_FREERTOS_QUEUE_H_
+
+#include "freertos/FreeRTOS.h"
+
+typedef struct gn_sim_queue *QueueHandle_t;
+
+QueueHandle_t xQueueCreate(UBaseType_t uxQueueLength, UBaseType_t uxItemSize);
+
+void vQueueDelete(QueueHandle_t xQueue);
+
+BaseType_t xQueueSend(QueueHandle_t xQueue, const void *pvItemToQueue,
+		TickType_t xTicksToWait);
+
+BaseType_t xQueueSendToFront(QueueHandle_t xQueue, const void *pvItemToQueue,
+		TickType_t xTicksToWait);
+
+BaseType_t xQueueReceive(QueueHandle_t xQueue, void *pvBuffer,
+		TickType_t xTicksToWait);
+
+BaseType_t xQueuePeek(QueueHandle_t xQueue, void *pvBuffer,
+		TickType_t xTicksToWait);
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t xQueue);
+
+UBaseType_t uxQueueSpacesAvailable(QueueHandle_t xQueue);
+
+BaseType_t xQueueReset(QueueHandle_t xQueue);
+
+#define xQueueSendToBack(q, i, t) xQueueSend(q, i, t)
+#define xQueueSendFromISR(q, i, w) xQueueSend(q, i, 0)
+#define xQueueSendToBackFromISR(q, i, w) xQueueSend(q, i, 0)
+#define xQueueReceiveFromISR(q, b, w) xQueueReceive(q, b, 0)
+
+#endif /* GN_SIM_FREERTOS_QUEUE_H_ */
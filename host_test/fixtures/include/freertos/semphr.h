@@ -0,0 +1,41 @@
+// Copyright 2021 Nicola Muratori (nicola.muratori@gmail.com)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GN_SIM_FREERTOS_SEMPHR_H_
+#define GN_SIM_FREERTOS_SEMPHR_H_
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+
+/*
+ * semaphores are queues of zero sized items, as in the FreeRTOS kernel
+ */
+
+typedef QueueHandle_t SemaphoreHandle_t;
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void);
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void);
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t uxMaxCount,
+		UBaseType_t uxInitialCount);
+
+#define xSemaphoreTake(s, t) xQueueReceive((s), NULL, (t))
+#define xSemaphoreGive(s) xQueueSend((s), NULL, 0)
+#define xSemaphoreGiveFromISR(s, w) xQueueSend((s), NULL, 0)
+#define xSemaphoreTakeFromISR(s, w) xQueueReceive((s), NULL, 0)
+#define uxSemaphoreGetCount(s) uxQueueMessagesWaiting(s)
+#define vSemaphoreDelete(s) vQueueDelete(s)
+
+#endif /* GN_SIM_FREERTOS_SEMPHR_H_ */
@@ -0,0 +1,60 @@
+// Copyright 2021 Nicola Muratori (nicola.muratori@gmail.com)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GN_SIM_FREERTOS_TASK_H_
+#define GN_SIM_FREERTOS_TASK_H_
+
+#include "freertos/FreeRTOS.h"
+
+typedef struct gn_sim_task *TaskHandle_t;
+
+typedef void (*TaskFunction_t)(void*);
+
+typedef enum {
+	eRunning = 0, eReady, eBlocked, eSuspended, eDeleted, eInvalid
+} eTaskState;
+
+BaseType_t xTaskCreate(TaskFunction_t pvTaskCode, const char *pcName,
+		uint32_t usStackDepth, void *pvParameters, UBaseType_t uxPriority,
+		TaskHandle_t *pvCreatedTask);
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t pvTaskCode,
+		const char *pcName, uint32_t usStackDepth, void *pvParameters,
+		UBaseType_t uxPriority, TaskHandle_t *pvCreatedTask,
+		BaseType_t xCoreID);
+
+void vTaskDelete(TaskHandle_t xTaskToDelete);
+
+void vTaskDelay(TickType_t xTicksToDelay);
+
+eTaskState eTaskGetState(TaskHandle_t xTask);
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void);
+
+char* pcTaskGetName(TaskHandle_t xTaskToQuery);
+
+TickType_t xTaskGetTickCount(void);
+
+UBaseType_t uxTaskGetNumberOfTasks(void);
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t xTask);
+
+BaseType_t xTaskNotifyGive(TaskHandle_t xTaskToNotify);
+
+uint32_t ulTaskNotifyTake(BaseType_t xClearCountOnExit,
+		TickType_t xTicksToWait);
+
+#define taskYIELD() vTaskDelay(0)
+
+#endif /* GN_SIM_FREERTOS_TASK_H_ */
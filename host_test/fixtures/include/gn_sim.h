@@ -0,0 +1,182 @@
+// Copyright 2021 Nicola Muratori (nicola.muratori@gmail.com)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GN_SIM_H_
+#define GN_SIM_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+ * control interface of the host simulator: sets the values read by simulated sensors,
+ * reads back simulated actuators and drives the loopback MQTT broker as an external client would
+ */
+
+#ifndef GN_SIM_HEAP_SIZE
+#define GN_SIM_HEAP_SIZE (4 * 1024 * 1024)
+#endif
+
+#define GN_SIM_RESTART_EXIT_CODE 3
+
+#define GN_SIM_DS18X20_MAX_SENSORS 8
+#define GN_SIM_I2C_MAX_SLAVES 8
+
+typedef enum {
+	GN_SIM_ACTUATOR_GPIO, GN_SIM_ACTUATOR_LEDC
+} gn_sim_actuator_t;
+
+/**
+ * @brief	called when a simulated output changes. index is the gpio number or the ledc channel
+ */
+typedef void (*gn_sim_actuator_cb_t)(gn_sim_actuator_t type, int index,
+		uint32_t value, void *arg);
+
+/**
+ * @brief	called for each message published to the broker that matches the subscription filter.
+ * runs in the task of the publisher
+ */
+typedef void (*gn_sim_broker_cb_t)(const char *topic, const char *data,
+		int data_len, void *arg);
+
+typedef struct {
+	uint32_t published; /*!< messages received by the broker */
+	uint32_t delivered; /*!< messages delivered to clients and observers */
+	uint32_t subscribed; /*!< subscribe requests granted */
+	uint32_t refused; /*!< subscribe requests refused */
+	uint64_t bytes; /*!< payload bytes received by the broker */
+	uint32_t retained; /*!< retained messages stored */
+	uint32_t clients; /*!< connected clients */
+} gn_sim_broker_stats_t;
+
+//sensors
+
+void gn_sim_ds18x20_set(int gpio, size_t index, float temperature);
+
+void gn_sim_bmp280_set(float temperature, float pressure, float humidity);
+
+/**
+ * @brief	writes the registers of a simulated i2c slave, created on first use. the slave answers
+ * to i2c_dev_read_reg and i2c_dev_write_reg
+ */
+void gn_sim_i2c_set_regs(int port, uint8_t addr, uint8_t reg,
+		const void *data, size_t size);
+
+void gn_sim_i2c_get_regs(int port, uint8_t addr, uint8_t reg, void *data,
+		size_t size);
+
+/**
+ * @brief	the next transactions addressed to the slave fail with ESP_ERR_TIMEOUT
+ */
+void gn_sim_i2c_fail(int port, uint8_t addr, uint32_t transactions);
+
+uint32_t gn_sim_i2c_get_transactions(int port, uint8_t addr);
+
+void gn_sim_touch_pad_set(int channel, uint16_t raw);
+
+/**
+ * @brief	level of an ADC1 channel, each conversion adds a uniform noise in [-noise, noise]
+ */
+void gn_sim_adc_set(int channel, uint16_t raw, uint16_t noise);
+
+//actuators
+
+int gn_sim_gpio_get_level(int gpio);
+
+uint32_t gn_sim_ledc_get_duty(int channel);
+
+void gn_sim_set_actuator_cb(gn_sim_actuator_cb_t cb, void *arg);
+
+//broker
+
+int gn_sim_broker_subscribe(const char *filter, gn_sim_broker_cb_t cb,
+		void *arg);
+
+void gn_sim_broker_unsubscribe(int subscription);
+
+int gn_sim_broker_publish(const char *topic, const char *data, int len,
+		int qos, bool retain);
+
+int gn_sim_broker_get_retained(const char *topic, char *buf, size_t size);
+
+void gn_sim_broker_get_stats(gn_sim_broker_stats_t *stats);
+
+void gn_sim_broker_reset_stats(void);
+
+void gn_sim_broker_set_latency_us(uint32_t latency_us);
+
+void gn_sim_broker_set_deny_wildcards(bool deny);
+
+bool gn_sim_broker_topic_matches(const char *filter, const char *topic);
+
+//ota
+
+/**
+ * @brief	content of the running partition, NULL to clear it. the app SHA-256 is computed on
+ * these bytes; the update partition is erased and the boot partition is reset
+ */
+void gn_sim_ota_set_running(const uint8_t *data, size_t len);
+
+/**
+ * @brief	image written to the update partition by the last successful esp_ota_end()
+ *
+ * @return	NULL if none
+ */
+const uint8_t* gn_sim_ota_get_update(size_t *len);
+
+/**
+ * @brief	true if esp_ota_set_boot_partition() selected the update partition
+ */
+bool gn_sim_ota_boot_set(void);
+
+//http
+
+/**
+ * @brief	serves the data, not copied, at the url. NULL data stops serving it.
+ * resets the served bytes counter
+ */
+void gn_sim_http_serve(const char *url, const uint8_t *data, size_t len);
+
+/**
+ * @brief	body bytes read by the clients since gn_sim_http_serve()
+ */
+size_t gn_sim_http_served(void);
+
+/**
+ * @brief	the next connections are dropped after after bytes of body each: the reads fail
+ */
+void gn_sim_http_drop(size_t after, int connections);
+
+/**
+ * @brief	when false range requests are ignored and answered with the whole body, as some
+ * servers do. true by default
+ */
+void gn_sim_http_set_ranges(bool supported);
+
+//system
+
+size_t gn_sim_heap_used(void);
+
+size_t gn_sim_heap_peak(void);
+
+void gn_sim_heap_reset_peak(void);
+
+void gn_sim_log_set_output(bool enabled);
+
+/**
+ * @brief	reason returned by esp_reset_reason(), an esp_reset_reason_t. ESP_RST_POWERON by default
+ */
+void gn_sim_set_reset_reason(int reason);
+
+#endif /* GN_SIM_H_ */
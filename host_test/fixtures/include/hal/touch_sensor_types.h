@@ -0,0 +1,39 @@
+// Copyright 2021 Nicola Muratori (nicola.muratori@gmail.com)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GN_SIM_HAL_TOUCH_SENSOR_TYPES_H_
+#define GN_SIM_HAL_TOUCH_SENSOR_TYPES_H_
+
+typedef enum {
+	TOUCH_PAD_NUM0 = 0, TOUCH_PAD_NUM1, TOUCH_PAD_NUM2, TOUCH_PAD_NUM3,
+	TOUCH_PAD_NUM4, TOUCH_PAD_NUM5, TOUCH_PAD_NUM6, TOUCH_PAD_NUM7,
+	TOUCH_PAD_NUM8, TOUCH_PAD_NUM9, TOUCH_PAD_MAX,
+} touch_pad_t;
+
+typedef enum {
+	TOUCH_HVOLT_KEEP = -1, TOUCH_HVOLT_2V4 = 0, TOUCH_HVOLT_2V5, TOUCH_HVOLT_2V6,
+	TOUCH_HVOLT_2V7, TOUCH_HVOLT_MAX,
+} touch_high_volt_t;
+
+typedef enum {
+	TOUCH_LVOLT_KEEP = -1, TOUCH_LVOLT_0V5 = 0, TOUCH_LVOLT_0V6, TOUCH_LVOLT_0V7,
+	TOUCH_LVOLT_0V8, TOUCH_LVOLT_MAX,
+} touch_low_volt_t;
+
+typedef enum {
+	TOUCH_HVOLT_ATTEN_KEEP = -1, TOUCH_HVOLT_ATTEN_1V5 = 0, TOUCH_HVOLT_ATTEN_1V,
+	TOUCH_HVOLT_ATTEN_0V5, TOUCH_HVOLT_ATTEN_0V, TOUCH_HVOLT_ATTEN_MAX,
+} touch_volt_atten_t;
+
+#endif /* GN_SIM_HAL_TOUCH_SENSOR_TYPES_H_ */
@@ -0,0 +1,65 @@
+// Copyright 2021 Nicola Muratori (nicola.muratori@gmail.com)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GN_SIM_I2CDEV_H_
+#define GN_SIM_I2CDEV_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "driver/gpio.h"
+
+typedef int i2c_port_t;
+
+typedef struct {
+	int mode;
+	int sda_io_num;
+	int scl_io_num;
+	bool sda_pullup_en;
+	bool scl_pullup_en;
+	struct {
+		uint32_t clk_speed;
+	} master;
+} i2c_config_t;
+
+typedef struct {
+	i2c_port_t port;
+	i2c_config_t cfg;
+	uint8_t addr;
+	SemaphoreHandle_t mutex;
+	uint32_t timeout_ticks;
+} i2c_dev_t;
+
+esp_err_t i2cdev_init(void);
+
+esp_err_t i2cdev_done(void);
+
+esp_err_t i2c_dev_create_mutex(i2c_dev_t *dev);
+
+esp_err_t i2c_dev_delete_mutex(i2c_dev_t *dev);
+
+esp_err_t i2c_dev_take_mutex(i2c_dev_t *dev);
+
+esp_err_t i2c_dev_give_mutex(i2c_dev_t *dev);
+
+esp_err_t i2c_dev_read_reg(const i2c_dev_t *dev, uint8_t reg, void *in_data,
+		size_t in_size);
+
+esp_err_t i2c_dev_write_reg(const i2c_dev_t *dev, uint8_t reg,
+		const void *out_data, size_t out_size);
+
+#endif /* GN_SIM_I2CDEV_H_ */
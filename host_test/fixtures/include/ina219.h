@@ -0,0 +1,74 @@
+// Copyright 2021 Nicola Muratori (nicola.muratori@gmail.com)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GN_SIM_INA219_H_
+#define GN_SIM_INA219_H_
+
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "i2cdev.h"
+
+/*
+ * simulated INA219 with the esp-idf-lib ina219 API. configuration and calibration are written to the
+ * register file of the generic i2c slave at the device address, readings come from its shunt and bus
+ * voltage registers set with gn_sim_i2c_set_regs()
+ */
+
+#define INA219_ADDR_GND_GND 0x40
+#define INA219_ADDR_GND_VS 0x41
+#define INA219_ADDR_GND_SDA 0x42
+#define INA219_ADDR_GND_SCL 0x43
+
+typedef enum {
+	INA219_BUS_RANGE_16V = 0, INA219_BUS_RANGE_32V
+} ina219_bus_voltage_range_t;
+
+typedef enum {
+	INA219_GAIN_1 = 0, INA219_GAIN_0_5, INA219_GAIN_0_25, INA219_GAIN_0_125
+} ina219_gain_t;
+
+typedef enum {
+	INA219_RES_9BIT_1S = 0, INA219_RES_10BIT_1S = 1, INA219_RES_11BIT_1S = 2,
+	INA219_RES_12BIT_1S = 3
+} ina219_resolution_t;
+
+typedef enum {
+	INA219_MODE_POWER_DOWN = 0, INA219_MODE_TRIG_SHUNT = 1,
+	INA219_MODE_TRIG_BUS = 2, INA219_MODE_TRIG_SHUNT_BUS = 3,
+	INA219_MODE_DISABLED = 4, INA219_MODE_CONT_SHUNT = 5,
+	INA219_MODE_CONT_BUS = 6, INA219_MODE_CONT_SHUNT_BUS = 7
+} ina219_mode_t;
+
+typedef struct {
+	i2c_dev_t i2c_dev;
+	uint16_t config;
+	float i_lsb;
+	float p_lsb;
+} ina219_t;
+
+esp_err_t ina219_init_desc(ina219_t *dev, uint8_t addr, i2c_port_t port,
+		int sda_gpio, int scl_gpio);
+
+esp_err_t ina219_free_desc(ina219_t *dev);
+
+esp_err_t ina219_init(ina219_t *dev);
+
+esp_err_t ina219_configure(ina219_t *dev, ina219_bus_voltage_range_t u_range,
+		ina219_gain_t gain, ina219_resolution_t u_res,
+		ina219_resolution_t i_res, ina219_mode_t mode);
+
+esp_err_t ina219_calibrate(ina219_t *dev, float i_expected_max, float r_shunt);
+
+#endif /* GN_SIM_INA219_H_ */
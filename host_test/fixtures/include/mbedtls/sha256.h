@@ -0,0 +1,44 @@
+// Copyright 2021 Nicola Muratori (nicola.muratori@gmail.com)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef GN_SIM_MBEDTLS_SHA256_H_
+#define GN_SIM_MBEDTLS_SHA256_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef struct {
+	uint32_t total[2];
+	uint32_t state[8];
+	unsigned char buffer[64];
+	int is224;
+} mbedtls_sha256_context;
+
+void mbedtls_sha256_init(mbedtls_sha256_context *ctx);
+
+void mbedtls_sha256_free(mbedtls_sha256_context *ctx);
+
+int mbedtls_sha256_starts_ret(mbedtls_sha256_context *ctx, int is224);
+
+int mbedtls_sha256_update_ret(mbedtls_sha256_context *ctx,
+		const unsigned char *input, size_t ilen);
+
+int mbedtls_sha256_finish_ret(mbedtls_sha256_context *ctx,
+		unsigned char output[32]);
+
+int mbedtls_sha256_ret(const unsigned char *input, size_t ilen,
+		unsigned char output[32], int is224);
+
+#endif /* GN_SIM_MBEDTLS_SHA256_H_ */
@@ -0,0 +1,167 @@
+// Copyright 2021 Nicola Muratori (nicola.muratori@gmail.com)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GN_SIM_MQTT_CLIENT_H_
+#define GN_SIM_MQTT_CLIENT_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "esp_err.h"
+#include "esp_event_base.h"
+
+/*
+ * esp-mqtt client API backed by the in process loopback broker of the simulator.
+ * each client owns a task that dispatches its events, as the esp-mqtt task does:
+ * handlers never run in the caller of publish / subscribe
+ */
+
+typedef struct esp_mqtt_client *esp_mqtt_client_handle_t;
+
+typedef enum {
+	MQTT_EVENT_ANY = -1,
+	MQTT_EVENT_ERROR = 0,
+	MQTT_EVENT_CONNECTED,
+	MQTT_EVENT_DISCONNECTED,
+	MQTT_EVENT_SUBSCRIBED,
+	MQTT_EVENT_UNSUBSCRIBED,
+	MQTT_EVENT_PUBLISHED,
+	MQTT_EVENT_DATA,
+	MQTT_EVENT_BEFORE_CONNECT,
+	MQTT_EVENT_DELETED,
+} esp_mqtt_event_id_t;
+
+typedef enum {
+	MQTT_ERROR_TYPE_NONE = 0,
+	MQTT_ERROR_TYPE_TCP_TRANSPORT,
+	MQTT_ERROR_TYPE_CONNECTION_REFUSED,
+} esp_mqtt_error_type_t;
+
+typedef enum {
+	MQTT_CONNECTION_ACCEPTED = 0,
+	MQTT_CONNECTION_REFUSE_PROTOCOL,
+	MQTT_CONNECTION_REFUSE_ID_REJECTED,
+	MQTT_CONNECTION_REFUSE_SERVER_UNAVAILABLE,
+	MQTT_CONNECTION_REFUSE_BAD_USERNAME,
+	MQTT_CONNECTION_REFUSE_NOT_AUTHORIZED
+} esp_mqtt_connect_return_code_t;
+
+typedef enum {
+	MQTT_TRANSPORT_UNKNOWN = 0x0,
+	MQTT_TRANSPORT_OVER_TCP,
+	MQTT_TRANSPORT_OVER_SSL,
+	MQTT_TRANSPORT_OVER_WS,
+	MQTT_TRANSPORT_OVER_WSS
+} esp_mqtt_transport_t;
+
+typedef enum {
+	MQTT_PROTOCOL_UNDEFINED = 0, MQTT_PROTOCOL_V_3_1, MQTT_PROTOCOL_V_3_1_1
+} esp_mqtt_protocol_ver_t;
+
+typedef struct esp_mqtt_error_codes {
+	esp_err_t esp_tls_last_esp_err;
+	int esp_tls_stack_err;
+	int esp_tls_cert_verify_flags;
+	esp_mqtt_error_type_t error_type;
+	esp_mqtt_connect_return_code_t connect_return_code;
+	int esp_transport_sock_errno;
+} esp_mqtt_error_codes_t;
+
+typedef struct esp_mqtt_event_t {
+	esp_mqtt_event_id_t event_id;
+	esp_mqtt_client_handle_t client;
+	void *user_context;
+	char *data;
+	int data_len;
+	int total_data_len;
+	int current_data_offset;
+	char *topic;
+	int topic_len;
+	int msg_id;
+	int session_present;
+	esp_mqtt_error_codes_t *error_handle;
+	bool retain;
+	int qos;
+	bool dup;
+} esp_mqtt_event_t;
+
+typedef esp_mqtt_event_t *esp_mqtt_event_handle_t;
+
+typedef esp_err_t (*mqtt_event_callback_t)(esp_mqtt_event_handle_t event);
+
+typedef struct {
+	mqtt_event_callback_t event_handle;
+	void *event_loop_handle;
+	const char *host;
+	const char *uri;
+	uint32_t port;
+	const char *client_id;
+	const char *username;
+	const char *password;
+	const char *lwt_topic;
+	const char *lwt_msg;
+	int lwt_qos;
+	int lwt_retain;
+	int lwt_msg_len;
+	int disable_clean_session;
+	int keepalive;
+	bool disable_auto_reconnect;
+	void *user_context;
+	int task_prio;
+	int task_stack;
+	int buffer_size;
+	const char *cert_pem;
+	size_t cert_len;
+	esp_mqtt_transport_t transport;
+	int refresh_connection_after_ms;
+	esp_mqtt_protocol_ver_t protocol_ver;
+	int out_buffer_size;
+	int reconnect_timeout_ms;
+	int network_timeout_ms;
+} esp_mqtt_client_config_t;
+
+ESP_EVENT_DECLARE_BASE(MQTT_EVENTS);
+
+esp_mqtt_client_handle_t esp_mqtt_client_init(
+		const esp_mqtt_client_config_t *config);
+
+esp_err_t esp_mqtt_client_register_event(esp_mqtt_client_handle_t client,
+		esp_mqtt_event_id_t event, esp_event_handler_t event_handler,
+		void *event_handler_arg);
+
+esp_err_t esp_mqtt_client_start(esp_mqtt_client_handle_t client);
+
+esp_err_t esp_mqtt_client_reconnect(esp_mqtt_client_handle_t client);
+
+esp_err_t esp_mqtt_client_disconnect(esp_mqtt_client_handle_t client);
+
+esp_err_t esp_mqtt_client_stop(esp_mqtt_client_handle_t client);
+
+esp_err_t esp_mqtt_client_destroy(esp_mqtt_client_handle_t client);
+
+int esp_mqtt_client_subscribe(esp_mqtt_client_handle_t client,
+		const char *topic, int qos);
+
+int esp_mqtt_client_unsubscribe(esp_mqtt_client_handle_t client,
+		const char *topic);
+
+int esp_mqtt_client_publish(esp_mqtt_client_handle_t client, const char *topic,
+		const char *data, int len, int qos, int retain);
+
+int esp_mqtt_client_enqueue(esp_mqtt_client_handle_t client, const char *topic,
+		const char *data, int len, int qos, int retain, bool store);
+
+int esp_mqtt_client_get_outbox_size(esp_mqtt_client_handle_t client);
+
+#endif /* GN_SIM_MQTT_CLIENT_H_ */
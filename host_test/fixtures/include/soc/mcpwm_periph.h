@@ -0,0 +1,22 @@
+// Copyright 2021 Nicola Muratori (nicola.muratori@gmail.com)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GN_SIM_SOC_MCPWM_PERIPH_H_
+#define GN_SIM_SOC_MCPWM_PERIPH_H_
+
+//included by grownode sources, no definition is used on the host
+
+#include "esp_err.h"
+
+#endif /* GN_SIM_SOC_MCPWM_PERIPH_H_ */
@@ -0,0 +1,31 @@
+// Copyright 2021 Nicola Muratori (nicola.muratori@gmail.com)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GN_SIM_SOC_TOUCH_SENSOR_CHANNEL_H_
+#define GN_SIM_SOC_TOUCH_SENSOR_CHANNEL_H_
+
+//touch channel to gpio mapping of the ESP32
+
+#define TOUCH_PAD_GPIO4_CHANNEL 0
+#define TOUCH_PAD_GPIO0_CHANNEL 1
+#define TOUCH_PAD_GPIO2_CHANNEL 2
+#define TOUCH_PAD_GPIO15_CHANNEL 3
+#define TOUCH_PAD_GPIO13_CHANNEL 4
+#define TOUCH_PAD_GPIO12_CHANNEL 5
+#define TOUCH_PAD_GPIO14_CHANNEL 6
+#define TOUCH_PAD_GPIO27_CHANNEL 7
+#define TOUCH_PAD_GPIO33_CHANNEL 8
+#define TOUCH_PAD_GPIO32_CHANNEL 9
+
+#endif /* GN_SIM_SOC_TOUCH_SENSOR_CHANNEL_H_ */
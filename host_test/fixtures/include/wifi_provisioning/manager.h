@@ -0,0 +1,88 @@
+// Copyright 2021 Nicola Muratori (nicola.muratori@gmail.com)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GN_SIM_WIFI_PROVISIONING_MANAGER_H_
+#define GN_SIM_WIFI_PROVISIONING_MANAGER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <sys/types.h>
+
+#include "esp_err.h"
+#include "esp_event_base.h"
+#include "esp_wifi.h"
+
+ESP_EVENT_DECLARE_BASE(WIFI_PROV_EVENT);
+
+typedef enum {
+	WIFI_PROV_INIT,
+	WIFI_PROV_START,
+	WIFI_PROV_CRED_RECV,
+	WIFI_PROV_CRED_FAIL,
+	WIFI_PROV_CRED_SUCCESS,
+	WIFI_PROV_END,
+	WIFI_PROV_DEINIT,
+} wifi_prov_cb_event_t;
+
+typedef enum {
+	WIFI_PROV_STA_AUTH_ERROR, WIFI_PROV_STA_AP_NOT_FOUND
+} wifi_prov_sta_fail_reason_t;
+
+typedef enum {
+	WIFI_PROV_SECURITY_0 = 0, WIFI_PROV_SECURITY_1
+} wifi_prov_security_t;
+
+typedef void (*wifi_prov_cb_func_t)(void *user_data, wifi_prov_cb_event_t event,
+		void *event_data);
+
+typedef struct {
+	wifi_prov_cb_func_t event_cb;
+	void *user_data;
+} wifi_prov_event_handler_t;
+
+#define WIFI_PROV_EVENT_HANDLER_NONE { .event_cb = NULL, .user_data = NULL }
+
+typedef struct {
+	const char *name;
+} wifi_prov_scheme_t;
+
+typedef struct {
+	wifi_prov_scheme_t scheme;
+	wifi_prov_event_handler_t scheme_event_handler;
+	wifi_prov_event_handler_t app_event_handler;
+} wifi_prov_mgr_config_t;
+
+typedef esp_err_t (*protocomm_req_handler_t)(uint32_t session_id,
+		const uint8_t *inbuf, ssize_t inlen, uint8_t **outbuf, ssize_t *outlen,
+		void *priv_data);
+
+esp_err_t wifi_prov_mgr_init(wifi_prov_mgr_config_t config);
+
+void wifi_prov_mgr_deinit(void);
+
+esp_err_t wifi_prov_mgr_is_provisioned(bool *provisioned);
+
+esp_err_t wifi_prov_mgr_reset_provisioning(void);
+
+esp_err_t wifi_prov_mgr_start_provisioning(wifi_prov_security_t security,
+		const char *pop, const char *service_name, const char *service_key);
+
+void wifi_prov_mgr_wait(void);
+
+esp_err_t wifi_prov_mgr_endpoint_create(const char *ep_name);
+
+esp_err_t wifi_prov_mgr_endpoint_register(const char *ep_name,
+		protocomm_req_handler_t handler, void *user_ctx);
+
+#endif /* GN_SIM_WIFI_PROVISIONING_MANAGER_H_ */
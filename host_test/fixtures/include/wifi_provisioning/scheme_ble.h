@@ -0,0 +1,26 @@
+// Copyright 2021 Nicola Muratori (nicola.muratori@gmail.com)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GN_SIM_WIFI_PROVISIONING_SCHEME_BLE_H_
+#define GN_SIM_WIFI_PROVISIONING_SCHEME_BLE_H_
+
+#include "wifi_provisioning/manager.h"
+
+extern const wifi_prov_scheme_t wifi_prov_scheme_ble;
+
+#define WIFI_PROV_SCHEME_BLE_EVENT_HANDLER_FREE_BTDM WIFI_PROV_EVENT_HANDLER_NONE
+
+esp_err_t wifi_prov_scheme_ble_set_service_uuid(uint8_t *uuid128);
+
+#endif /* GN_SIM_WIFI_PROVISIONING_SCHEME_BLE_H_ */
@@ -0,0 +1,1168 @@
+// Copyright 2021 Nicola Muratori (nicola.muratori@gmail.com)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * simulated peripherals used by the bundled leaves: gpio, ledc, touch pad, ADC1, one wire ds18x20
+ * the i2c bme280, ina219 and generic i2c register files. sensors read the values set through gn_sim.h, actuators record their outputs
+ */
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "esp_log.h"
+#include "driver/gpio.h"
+#include "driver/ledc.h"
+#include "driver/touch_pad.h"
+#include "driver/adc.h"
+#include "esp_adc_cal.h"
+#include "ds18x20.h"
+#include "i2cdev.h"
+#include "bmp280.h"
+#include "ina219.h"
+
+#include "gn_sim.h"
+
+#define TAG "gn_sim_drivers"
+
+static pthread_mutex_t _gn_sim_drivers_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static gn_sim_actuator_cb_t _gn_sim_actuator_cb = NULL;
+static void *_gn_sim_actuator_arg = NULL;
+
+static void _gn_sim_actuator_notify(gn_sim_actuator_t type, int index,
+		uint32_t value) {
+
+	pthread_mutex_lock(&_gn_sim_drivers_mutex);
+	gn_sim_actuator_cb_t cb = _gn_sim_actuator_cb;
+	void *arg = _gn_sim_actuator_arg;
+	pthread_mutex_unlock(&_gn_sim_drivers_mutex);
+
+	if (cb)
+		cb(type, index, value, arg);
+
+}
+
+void gn_sim_set_actuator_cb(gn_sim_actuator_cb_t cb, void *arg) {
+
+	pthread_mutex_lock(&_gn_sim_drivers_mutex);
+	_gn_sim_actuator_cb = cb;
+	_gn_sim_actuator_arg = arg;
+	pthread_mutex_unlock(&_gn_sim_drivers_mutex);
+
+}
+
+//gpio
+
+static gpio_mode_t _gn_sim_gpio_mode[GPIO_NUM_MAX];
+static uint32_t _gn_sim_gpio_level[GPIO_NUM_MAX];
+
+static bool _gn_sim_gpio_valid(gpio_num_t gpio_num) {
+	return gpio_num >= 0 && gpio_num < GPIO_NUM_MAX;
+}
+
+esp_err_t gpio_config(const gpio_config_t *pGPIOConfig) {
+
+	if (!pGPIOConfig)
+		return ESP_ERR_INVALID_ARG;
+	for (int i = 0; i < GPIO_NUM_MAX; i++)
+		if (pGPIOConfig->pin_bit_mask & (1ULL << i))
+			gpio_set_direction((gpio_num_t) i, pGPIOConfig->mode);
+	return ESP_OK;
+
+}
+
+esp_err_t gpio_reset_pin(gpio_num_t gpio_num) {
+
+	if (!_gn_sim_gpio_valid(gpio_num))
+		return ESP_ERR_INVALID_ARG;
+	pthread_mutex_lock(&_gn_sim_drivers_mutex);
+	_gn_sim_gpio_mode[gpio_num] = GPIO_MODE_DISABLE;
+	_gn_sim_gpio_level[gpio_num] = 0;
+	pthread_mutex_unlock(&_gn_sim_drivers_mutex);
+	return ESP_OK;
+
+}
+
+esp_err_t gpio_set_direction(gpio_num_t gpio_num, gpio_mode_t mode) {
+
+	if (!_gn_sim_gpio_valid(gpio_num))
+		return ESP_ERR_INVALID_ARG;
+	pthread_mutex_lock(&_gn_sim_drivers_mutex);
+	_gn_sim_gpio_mode[gpio_num] = mode;
+	pthread_mutex_unlock(&_gn_sim_drivers_mutex);
+	return ESP_OK;
+
+}
+
+esp_err_t gpio_set_level(gpio_num_t gpio_num, uint32_t level) {
+
+	if (!_gn_sim_gpio_valid(gpio_num))
+		return ESP_ERR_INVALID_ARG;
+	level = level ? 1 : 0;
+	pthread_mutex_lock(&_gn_sim_drivers_mutex);
+	_gn_sim_gpio_level[gpio_num] = level;
+	pthread_mutex_unlock(&_gn_sim_drivers_mutex);
+	_gn_sim_actuator_notify(GN_SIM_ACTUATOR_GPIO, gpio_num, level);
+	return ESP_OK;
+
+}
+
+int gpio_get_level(gpio_num_t gpio_num) {
+	return gn_sim_gpio_get_level(gpio_num);
+}
+
+esp_err_t gpio_set_pull_mode(gpio_num_t gpio_num, gpio_pull_mode_t pull) {
+	return _gn_sim_gpio_valid(gpio_num) ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+void gpio_pad_select_gpio(uint8_t gpio_num) {
+}
+
+int gn_sim_gpio_get_level(int gpio) {
+
+	if (!_gn_sim_gpio_valid((gpio_num_t) gpio))
+		return -1;
+	pthread_mutex_lock(&_gn_sim_drivers_mutex);
+	int ret = _gn_sim_gpio_level[gpio];
+	pthread_mutex_unlock(&_gn_sim_drivers_mutex);
+	return ret;
+
+}
+
+//ledc
+
+static struct {
+	int gpio_num;
+	uint32_t duty;
+	uint32_t target;
+	ledc_cb_t fade_cb;
+	void *fade_arg;
+} _gn_sim_ledc[LEDC_CHANNEL_MAX];
+
+static bool _gn_sim_ledc_valid(ledc_channel_t channel) {
+	return channel >= 0 && channel < LEDC_CHANNEL_MAX;
+}
+
+esp_err_t ledc_timer_config(const ledc_timer_config_t *timer_conf) {
+	if (!timer_conf || timer_conf->timer_num >= LEDC_TIMER_MAX)
+		return ESP_ERR_INVALID_ARG;
+	return ESP_OK;
+}
+
+esp_err_t ledc_channel_config(const ledc_channel_config_t *ledc_conf) {
+
+	if (!ledc_conf || !_gn_sim_ledc_valid(ledc_conf->channel))
+		return ESP_ERR_INVALID_ARG;
+	pthread_mutex_lock(&_gn_sim_drivers_mutex);
+	_gn_sim_ledc[ledc_conf->channel].gpio_num = ledc_conf->gpio_num;
+	_gn_sim_ledc[ledc_conf->channel].duty = ledc_conf->duty;
+	_gn_sim_ledc[ledc_conf->channel].target = ledc_conf->duty;
+	pthread_mutex_unlock(&_gn_sim_drivers_mutex);
+	return ESP_OK;
+
+}
+
+esp_err_t ledc_fade_func_install(int intr_alloc_flags) {
+	return ESP_OK;
+}
+
+void ledc_fade_func_uninstall(void) {
+}
+
+esp_err_t ledc_cb_register(ledc_mode_t speed_mode, ledc_channel_t channel,
+		ledc_cbs_t *cbs, void *user_arg) {
+
+	if (!_gn_sim_ledc_valid(channel) || !cbs)
+		return ESP_ERR_INVALID_ARG;
+	pthread_mutex_lock(&_gn_sim_drivers_mutex);
+	_gn_sim_ledc[channel].fade_cb = cbs->fade_cb;
+	_gn_sim_ledc[channel].fade_arg = user_arg;
+	pthread_mutex_unlock(&_gn_sim_drivers_mutex);
+	return ESP_OK;
+
+}
+
+esp_err_t ledc_set_duty(ledc_mode_t speed_mode, ledc_channel_t channel,
+		uint32_t duty) {
+
+	if (!_gn_sim_ledc_valid(channel))
+		return ESP_ERR_INVALID_ARG;
+	pthread_mutex_lock(&_gn_sim_drivers_mutex);
+	_gn_sim_ledc[channel].target = duty;
+	pthread_mutex_unlock(&_gn_sim_drivers_mutex);
+	return ESP_OK;
+
+}
+
+uint32_t ledc_get_duty(ledc_mode_t speed_mode, ledc_channel_t channel) {
+	return gn_sim_ledc_get_duty(channel);
+}
+
+esp_err_t ledc_update_duty(ledc_mode_t speed_mode, ledc_channel_t channel) {
+
+	if (!_gn_sim_ledc_valid(channel))
+		return ESP_ERR_INVALID_ARG;
+	pthread_mutex_lock(&_gn_sim_drivers_mutex);
+	uint32_t duty = _gn_sim_ledc[channel].duty = _gn_sim_ledc[channel].target;
+	pthread_mutex_unlock(&_gn_sim_drivers_mutex);
+	_gn_sim_actuator_notify(GN_SIM_ACTUATOR_LEDC, channel, duty);
+	return ESP_OK;
+
+}
+
+esp_err_t ledc_set_fade_with_time(ledc_mode_t speed_mode,
+		ledc_channel_t channel, uint32_t target_duty, int max_fade_time_ms) {
+	return ledc_set_duty(speed_mode, channel, target_duty);
+}
+
+esp_err_t ledc_fade_start(ledc_mode_t speed_mode, ledc_channel_t channel,
+		ledc_fade_mode_t fade_mode) {
+
+	esp_err_t ret = ledc_update_duty(speed_mode, channel);
+	if (ret != ESP_OK)
+		return ret;
+
+	pthread_mutex_lock(&_gn_sim_drivers_mutex);
+	ledc_cb_t cb = _gn_sim_ledc[channel].fade_cb;
+	void *arg = _gn_sim_ledc[channel].fade_arg;
+	ledc_cb_param_t param = { .event = LEDC_FADE_END_EVT, .speed_mode =
+			speed_mode, .channel = channel, .duty = _gn_sim_ledc[channel].duty };
+	pthread_mutex_unlock(&_gn_sim_drivers_mutex);
+
+	if (cb)
+		cb(&param, arg);
+	return ESP_OK;
+
+}
+
+esp_err_t ledc_stop(ledc_mode_t speed_mode, ledc_channel_t channel,
+		uint32_t idle_level) {
+
+	if (!_gn_sim_ledc_valid(channel))
+		return ESP_ERR_INVALID_ARG;
+	pthread_mutex_lock(&_gn_sim_drivers_mutex);
+	_gn_sim_ledc[channel].duty = _gn_sim_ledc[channel].target = 0;
+	pthread_mutex_unlock(&_gn_sim_drivers_mutex);
+	_gn_sim_actuator_notify(GN_SIM_ACTUATOR_LEDC, channel, 0);
+	return ESP_OK;
+
+}
+
+uint32_t gn_sim_ledc_get_duty(int channel) {
+
+	if (!_gn_sim_ledc_valid((ledc_channel_t) channel))
+		return 0;
+	pthread_mutex_lock(&_gn_sim_drivers_mutex);
+	uint32_t ret = _gn_sim_ledc[channel].duty;
+	pthread_mutex_unlock(&_gn_sim_drivers_mutex);
+	return ret;
+
+}
+
+//touch pad
+
+static uint16_t _gn_sim_touch_raw[TOUCH_PAD_MAX];
+
+esp_err_t touch_pad_init(void) {
+	return ESP_OK;
+}
+
+esp_err_t touch_pad_deinit(void) {
+	return ESP_OK;
+}
+
+esp_err_t touch_pad_set_voltage(touch_high_volt_t refh, touch_low_volt_t refl,
+		touch_volt_atten_t atten) {
+	return ESP_OK;
+}
+
+esp_err_t touch_pad_config(touch_pad_t touch_num, uint16_t threshold) {
+	return touch_num < TOUCH_PAD_MAX ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t touch_pad_filter_start(uint32_t filter_period_ms) {
+	return ESP_OK;
+}
+
+esp_err_t touch_pad_clear_status(void) {
+	return ESP_OK;
+}
+
+esp_err_t touch_pad_read_raw_data(touch_pad_t touch_num, uint16_t *touch_value) {
+
+	if (touch_num >= TOUCH_PAD_MAX || !touch_value)
+		return ESP_ERR_INVALID_ARG;
+	pthread_mutex_lock(&_gn_sim_drivers_mutex);
+	*touch_value = _gn_sim_touch_raw[touch_num];
+	pthread_mutex_unlock(&_gn_sim_drivers_mutex);
+	return ESP_OK;
+
+}
+
+esp_err_t touch_pad_read(touch_pad_t touch_num, uint16_t *touch_value) {
+	return touch_pad_read_raw_data(touch_num, touch_value);
+}
+
+esp_err_t touch_pad_read_filtered(touch_pad_t touch_num, uint16_t *touch_value) {
+	return touch_pad_read_raw_data(touch_num, touch_value);
+}
+
+void gn_sim_touch_pad_set(int channel, uint16_t raw) {
+
+	if (channel < 0 || channel >= TOUCH_PAD_MAX)
+		return;
+	pthread_mutex_lock(&_gn_sim_drivers_mutex);
+	_gn_sim_touch_raw[channel] = raw;
+	pthread_mutex_unlock(&_gn_sim_drivers_mutex);
+
+}
+
+//adc
+
+static struct {
+	uint16_t raw;
+	uint16_t noise;
+} _gn_sim_adc[ADC1_CHANNEL_MAX];
+
+static unsigned int _gn_sim_adc_seed = 1;
+
+static struct {
+	bool initialized;
+	bool running;
+	uint32_t frame_conversions;
+	uint32_t pool_frames;
+	uint32_t mask;
+	uint8_t pattern[ADC1_CHANNEL_MAX];
+	uint8_t bits[ADC1_CHANNEL_MAX]; /*!< conversion width of each pattern entry */
+	uint32_t pattern_num;
+	uint32_t pattern_next;
+	uint32_t freq_hz;
+	int64_t next_frame_us; /*!< when the next frame is complete */
+} _gn_sim_adc_digi;
+
+static int64_t _gn_sim_adc_now_us() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (int64_t) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void _gn_sim_adc_sleep_us(int64_t us) {
+	struct timespec ts = { .tv_sec = us / 1000000, .tv_nsec = (us % 1000000)
+			* 1000 };
+	nanosleep(&ts, NULL);
+}
+
+//called with the drivers mutex held
+static uint16_t _gn_sim_adc_sample(int channel) {
+
+	int v = _gn_sim_adc[channel].raw;
+	int noise = _gn_sim_adc[channel].noise;
+	if (noise)
+		v += (int) (rand_r(&_gn_sim_adc_seed) % (2 * noise + 1)) - noise;
+	return v < 0 ? 0 : v > 4095 ? 4095 : v;
+
+}
+
+esp_err_t adc1_config_width(adc_bits_width_t width_bit) {
+	return width_bit < ADC_WIDTH_MAX ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t adc1_config_channel_atten(adc1_channel_t channel, adc_atten_t atten) {
+	return channel >= 0 && channel < ADC1_CHANNEL_MAX && atten < ADC_ATTEN_MAX ?
+			ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+int adc1_get_raw(adc1_channel_t channel) {
+
+	if (channel < 0 || channel >= ADC1_CHANNEL_MAX)
+		return -1;
+	pthread_mutex_lock(&_gn_sim_drivers_mutex);
+	int ret = _gn_sim_adc_sample(channel);
+	pthread_mutex_unlock(&_gn_sim_drivers_mutex);
+	return ret;
+
+}
+
+esp_err_t adc_digi_initialize(const adc_digi_init_config_t *init_config) {
+
+	if (!init_config || init_config->conv_num_each_intr == 0
+			|| init_config->max_store_buf_size < init_config->conv_num_each_intr
+			|| init_config->adc2_chan_mask)
+		return ESP_ERR_INVALID_ARG;
+
+	pthread_mutex_lock(&_gn_sim_drivers_mutex);
+	esp_err_t ret = ESP_ERR_INVALID_STATE;
+	if (!_gn_sim_adc_digi.initialized) {
+		memset(&_gn_sim_adc_digi, 0, sizeof(_gn_sim_adc_digi));
+		_gn_sim_adc_digi.initialized = true;
+		_gn_sim_adc_digi.frame_conversions = init_config->conv_num_each_intr
+				/ sizeof(adc_digi_output_data_t);
+		_gn_sim_adc_digi.pool_frames = init_config->max_store_buf_size
+				/ init_config->conv_num_each_intr;
+		_gn_sim_adc_digi.mask = init_config->adc1_chan_mask;
+		ret = ESP_OK;
+	}
+	pthread_mutex_unlock(&_gn_sim_drivers_mutex);
+	return ret;
+
+}
+
+esp_err_t adc_digi_deinitialize(void) {
+
+	pthread_mutex_lock(&_gn_sim_drivers_mutex);
+	_gn_sim_adc_digi.initialized = false;
+	_gn_sim_adc_digi.running = false;
+	pthread_mutex_unlock(&_gn_sim_drivers_mutex);
+	return ESP_OK;
+
+}
+
+esp_err_t adc_digi_controller_configure(const adc_digi_configuration_t *config) {
+
+	if (!config || config->pattern_num == 0
+			|| config->pattern_num > ADC1_CHANNEL_MAX || !config->adc_pattern
+			|| config->sample_freq_hz < 20000
+			|| config->sample_freq_hz > 2000000
+			|| config->conv_mode != ADC_CONV_SINGLE_UNIT_1
+			|| config->format != ADC_DIGI_OUTPUT_FORMAT_TYPE1)
+		return ESP_ERR_INVALID_ARG;
+
+	pthread_mutex_lock(&_gn_sim_drivers_mutex);
+	esp_err_t ret = _gn_sim_adc_digi.initialized ? ESP_OK : ESP_ERR_INVALID_STATE;
+	for (uint32_t i = 0; ret == ESP_OK && i < config->pattern_num; i++) {
+		uint8_t ch = config->adc_pattern[i].channel;
+		uint8_t bits = config->adc_pattern[i].bit_width;
+		if (ch >= ADC1_CHANNEL_MAX || !(_gn_sim_adc_digi.mask & BIT(ch))
+				|| config->adc_pattern[i].atten >= ADC_ATTEN_MAX || bits < 9
+				|| bits > SOC_ADC_DIGI_MAX_BITWIDTH)
+			ret = ESP_ERR_INVALID_ARG;
+		else {
+			_gn_sim_adc_digi.pattern[i] = ch;
+			_gn_sim_adc_digi.bits[i] = bits;
+		}
+	}
+	if (ret == ESP_OK) {
+		_gn_sim_adc_digi.pattern_num = config->pattern_num;
+		_gn_sim_adc_digi.pattern_next = 0;
+		_gn_sim_adc_digi.freq_hz = config->sample_freq_hz;
+	}
+	pthread_mutex_unlock(&_gn_sim_drivers_mutex);
+	return ret;
+
+}
+
+esp_err_t adc_digi_start(void) {
+
+	pthread_mutex_lock(&_gn_sim_drivers_mutex);
+	esp_err_t ret = ESP_ERR_INVALID_STATE;
+	if (_gn_sim_adc_digi.initialized && _gn_sim_adc_digi.pattern_num) {
+		_gn_sim_adc_digi.running = true;
+		_gn_sim_adc_digi.next_frame_us = _gn_sim_adc_now_us()
+				+ _gn_sim_adc_digi.frame_conversions * 1000000LL
+						/ _gn_sim_adc_digi.freq_hz;
+		ret = ESP_OK;
+	}
+	pthread_mutex_unlock(&_gn_sim_drivers_mutex);
+	return ret;
+
+}
+
+esp_err_t adc_digi_stop(void) {
+
+	pthread_mutex_lock(&_gn_sim_drivers_mutex);
+	_gn_sim_adc_digi.running = false;
+	pthread_mutex_unlock(&_gn_sim_drivers_mutex);
+	return ESP_OK;
+
+}
+
+/*
+ * one frame per call, as the driver returns what an interrupt stored. frames not read while the
+ * pool was full are lost and reported as ESP_ERR_INVALID_STATE with the next frame
+ */
+esp_err_t adc_digi_read_bytes(uint8_t *buf, uint32_t length_max,
+		uint32_t *out_length, uint32_t timeout_ms) {
+
+	if (!buf || !out_length)
+		return ESP_ERR_INVALID_ARG;
+	*out_length = 0;
+
+	pthread_mutex_lock(&_gn_sim_drivers_mutex);
+	bool running = _gn_sim_adc_digi.running;
+	int64_t next_frame_us = _gn_sim_adc_digi.next_frame_us;
+	pthread_mutex_unlock(&_gn_sim_drivers_mutex);
+
+	if (!running)
+		return ESP_ERR_INVALID_STATE;
+
+	int64_t wait_us = next_frame_us - _gn_sim_adc_now_us();
+	if (wait_us > (int64_t) timeout_ms * 1000) {
+		_gn_sim_adc_sleep_us((int64_t) timeout_ms * 1000);
+		return ESP_ERR_TIMEOUT;
+	}
+	if (wait_us > 0)
+		_gn_sim_adc_sleep_us(wait_us);
+
+	pthread_mutex_lock(&_gn_sim_drivers_mutex);
+
+	if (!_gn_sim_adc_digi.running) {
+		pthread_mutex_unlock(&_gn_sim_drivers_mutex);
+		return ESP_ERR_INVALID_STATE;
+	}
+
+	uint32_t conversions = _gn_sim_adc_digi.frame_conversions;
+	if (conversions > length_max / sizeof(adc_digi_output_data_t))
+		conversions = length_max / sizeof(adc_digi_output_data_t);
+
+	adc_digi_output_data_t *out = (adc_digi_output_data_t*) buf;
+	for (uint32_t i = 0; i < conversions; i++) {
+		uint8_t ch = _gn_sim_adc_digi.pattern[_gn_sim_adc_digi.pattern_next];
+		uint8_t bits = _gn_sim_adc_digi.bits[_gn_sim_adc_digi.pattern_next];
+		_gn_sim_adc_digi.pattern_next = (_gn_sim_adc_digi.pattern_next + 1)
+				% _gn_sim_adc_digi.pattern_num;
+		out[i].val = 0;
+		out[i].type1.channel = ch;
+		out[i].type1.data = _gn_sim_adc_sample(ch)
+				>> (SOC_ADC_DIGI_MAX_BITWIDTH - bits);
+	}
+	*out_length = conversions * sizeof(adc_digi_output_data_t);
+
+	int64_t period_us = _gn_sim_adc_digi.frame_conversions * 1000000LL
+			/ _gn_sim_adc_digi.freq_hz;
+	int64_t now_us = _gn_sim_adc_now_us();
+	esp_err_t ret = ESP_OK;
+	_gn_sim_adc_digi.next_frame_us += period_us;
+	if (now_us - _gn_sim_adc_digi.next_frame_us
+			> (int64_t) _gn_sim_adc_digi.pool_frames * period_us) {
+		_gn_sim_adc_digi.next_frame_us = now_us + period_us;
+		ret = ESP_ERR_INVALID_STATE;
+	}
+
+	pthread_mutex_unlock(&_gn_sim_drivers_mutex);
+	return ret;
+
+}
+
+void gn_sim_adc_set(int channel, uint16_t raw, uint16_t noise) {
+
+	if (channel < 0 || channel >= ADC1_CHANNEL_MAX)
+		return;
+	pthread_mutex_lock(&_gn_sim_drivers_mutex);
+	_gn_sim_adc[channel].raw = raw > 4095 ? 4095 : raw;
+	_gn_sim_adc[channel].noise = noise;
+	pthread_mutex_unlock(&_gn_sim_drivers_mutex);
+
+}
+
+esp_adc_cal_value_t esp_adc_cal_characterize(adc_unit_t adc_num,
+		adc_atten_t atten, adc_bits_width_t bit_width, uint32_t default_vref,
+		esp_adc_cal_characteristics_t *chars) {
+
+	if (chars) {
+		memset(chars, 0, sizeof(*chars));
+		chars->adc_num = adc_num;
+		chars->atten = atten;
+		chars->bit_width = bit_width;
+		chars->vref = default_vref;
+	}
+	return ESP_ADC_CAL_VAL_DEFAULT_VREF;
+
+}
+
+//full scale of 3.9 V at 11 dB
+uint32_t esp_adc_cal_raw_to_voltage(uint32_t adc_reading,
+		const esp_adc_cal_characteristics_t *chars) {
+	return adc_reading * 3900 / 4095;
+}
+
+//ds18x20, addresses carry the family code in the low byte and the sensor index above it.
+//a conversion latches the temperature into the scratchpad after the time of the sensor resolution,
+//the scratchpad holds the power-on value of 85 C until the first conversion completes
+
+#define GN_SIM_DS18X20_POWER_ON_TEMPERATURE 85.0
+
+static struct {
+	size_t count;
+	float temperature[GN_SIM_DS18X20_MAX_SENSORS];
+	float latched[GN_SIM_DS18X20_MAX_SENSORS];
+	uint8_t config[GN_SIM_DS18X20_MAX_SENSORS]; /*!< R1 R0 resolution bits */
+	uint8_t alarm[GN_SIM_DS18X20_MAX_SENSORS][2];
+	int64_t converted_at[GN_SIM_DS18X20_MAX_SENSORS]; /*!< 0 when no conversion is pending */
+	bool powered;
+} _gn_sim_ds18x20[GPIO_NUM_MAX];
+
+static ds18x20_addr_t _gn_sim_ds18x20_addr(size_t index) {
+	return ((ds18x20_addr_t) (index + 1) << 8) | DS18B20_FAMILY_ID;
+}
+
+//conversion time, 93.75 ms at 9 bits doubling up to 750 ms at 12 bits
+static int64_t _gn_sim_ds18x20_conversion_us(uint8_t config) {
+	return 93750 << ((config >> 5) & 0x03);
+}
+
+//called with the drivers mutex held, returns the sensor index or -1
+static int _gn_sim_ds18x20_index(gpio_num_t pin, ds18x20_addr_t addr) {
+
+	if (!_gn_sim_gpio_valid(pin) || _gn_sim_ds18x20[pin].count == 0)
+		return -1;
+
+	size_t index = addr == DS18X20_ANY ? 0 : (size_t) (addr >> 8) - 1;
+	if (index >= _gn_sim_ds18x20[pin].count)
+		return -1;
+	return index;
+
+}
+
+//called with the drivers mutex held. completes the conversion if its time has elapsed
+static void _gn_sim_ds18x20_latch(gpio_num_t pin, int index) {
+
+	int64_t at = _gn_sim_ds18x20[pin].converted_at[index];
+	if (at == 0 || _gn_sim_adc_now_us() < at)
+		return;
+
+	//the undefined low bits of the lower resolutions read as zero
+	int16_t raw = (int16_t) (_gn_sim_ds18x20[pin].temperature[index] * 16);
+	raw &= ~((1 << (3 - ((_gn_sim_ds18x20[pin].config[index] >> 5) & 0x03)))
+			- 1);
+	_gn_sim_ds18x20[pin].latched[index] = raw / 16.0;
+	_gn_sim_ds18x20[pin].converted_at[index] = 0;
+
+}
+
+static esp_err_t _gn_sim_ds18x20_read(gpio_num_t pin, ds18x20_addr_t addr,
+		float *temperature) {
+
+	int index = _gn_sim_ds18x20_index(pin, addr);
+	if (index < 0)
+		return ESP_ERR_NOT_FOUND;
+
+	_gn_sim_ds18x20_latch(pin, index);
+	*temperature = _gn_sim_ds18x20[pin].latched[index];
+	return ESP_OK;
+
+}
+
+bool onewire_power(gpio_num_t pin) {
+
+	if (!_gn_sim_gpio_valid(pin))
+		return false;
+	pthread_mutex_lock(&_gn_sim_drivers_mutex);
+	_gn_sim_ds18x20[pin].powered = true;
+	pthread_mutex_unlock(&_gn_sim_drivers_mutex);
+	return true;
+
+}
+
+void onewire_depower(gpio_num_t pin) {
+
+	if (!_gn_sim_gpio_valid(pin))
+		return;
+	pthread_mutex_lock(&_gn_sim_drivers_mutex);
+	_gn_sim_ds18x20[pin].powered = false;
+	pthread_mutex_unlock(&_gn_sim_drivers_mutex);
+
+}
+
+esp_err_t ds18x20_scan_devices(gpio_num_t pin, ds18x20_addr_t *addr_list,
+		size_t addr_count, size_t *found) {
+
+	if (!_gn_sim_gpio_valid(pin) || !addr_list || !found)
+		return ESP_ERR_INVALID_ARG;
+
+	pthread_mutex_lock(&_gn_sim_drivers_mutex);
+	*found = _gn_sim_ds18x20[pin].count;
+	for (size_t i = 0; i < *found && i < addr_count; i++)
+		addr_list[i] = _gn_sim_ds18x20_addr(i);
+	pthread_mutex_unlock(&_gn_sim_drivers_mutex);
+
+	return *found ? ESP_OK : ESP_ERR_NOT_FOUND;
+
+}
+
+//like the driver, the bus is left powered after the convert command and waiting depowers it
+esp_err_t ds18x20_measure(gpio_num_t pin, ds18x20_addr_t addr, bool wait) {
+
+	if (!_gn_sim_gpio_valid(pin))
+		return ESP_ERR_INVALID_ARG;
+
+	pthread_mutex_lock(&_gn_sim_drivers_mutex);
+	int index = _gn_sim_ds18x20_index(pin, addr);
+	int64_t now = _gn_sim_adc_now_us();
+	for (int i = 0; index >= 0 && i < _gn_sim_ds18x20[pin].count; i++) {
+		if (addr != DS18X20_ANY && i != index)
+			continue;
+		_gn_sim_ds18x20_latch(pin, i);
+		_gn_sim_ds18x20[pin].converted_at[i] = now
+				+ _gn_sim_ds18x20_conversion_us(_gn_sim_ds18x20[pin].config[i]);
+	}
+	_gn_sim_ds18x20[pin].powered = index >= 0;
+	pthread_mutex_unlock(&_gn_sim_drivers_mutex);
+
+	if (index < 0)
+		return ESP_ERR_NOT_FOUND;
+
+	//the driver always waits the 12 bits conversion time
+	if (wait) {
+		_gn_sim_adc_sleep_us(750000);
+		onewire_depower(pin);
+	}
+	return ESP_OK;
+
+}
+
+esp_err_t ds18x20_read_scratchpad(gpio_num_t pin, ds18x20_addr_t addr,
+		uint8_t *buffer) {
+
+	if (!buffer)
+		return ESP_ERR_INVALID_ARG;
+
+	pthread_mutex_lock(&_gn_sim_drivers_mutex);
+	int index = _gn_sim_ds18x20_index(pin, addr);
+	if (index >= 0) {
+		_gn_sim_ds18x20_latch(pin, index);
+		int16_t raw = (int16_t) (_gn_sim_ds18x20[pin].latched[index] * 16);
+		buffer[0] = raw & 0xff;
+		buffer[1] = (raw >> 8) & 0xff;
+		buffer[2] = _gn_sim_ds18x20[pin].alarm[index][0];
+		buffer[3] = _gn_sim_ds18x20[pin].alarm[index][1];
+		buffer[4] = _gn_sim_ds18x20[pin].config[index];
+		buffer[5] = 0xff;
+		buffer[6] = 0x0c;
+		buffer[7] = 0x10;
+		buffer[8] = 0;
+	}
+	pthread_mutex_unlock(&_gn_sim_drivers_mutex);
+
+	return index >= 0 ? ESP_OK : ESP_ERR_NOT_FOUND;
+
+}
+
+esp_err_t ds18x20_write_scratchpad(gpio_num_t pin, ds18x20_addr_t addr,
+		uint8_t *buffer) {
+
+	if (!buffer)
+		return ESP_ERR_INVALID_ARG;
+
+	pthread_mutex_lock(&_gn_sim_drivers_mutex);
+	int index = _gn_sim_ds18x20_index(pin, addr);
+	for (int i = 0; index >= 0 && i < _gn_sim_ds18x20[pin].count; i++) {
+		if (addr != DS18X20_ANY && i != index)
+			continue;
+		_gn_sim_ds18x20[pin].alarm[i][0] = buffer[0];
+		_gn_sim_ds18x20[pin].alarm[i][1] = buffer[1];
+		_gn_sim_ds18x20[pin].config[i] = (buffer[2] & 0x60) | 0x1f;
+	}
+	pthread_mutex_unlock(&_gn_sim_drivers_mutex);
+
+	return index >= 0 ? ESP_OK : ESP_ERR_NOT_FOUND;
+
+}
+
+esp_err_t ds18x20_read_temperature(gpio_num_t pin, ds18x20_addr_t addr,
+		float *temperature) {
+
+	if (!temperature)
+		return ESP_ERR_INVALID_ARG;
+	pthread_mutex_lock(&_gn_sim_drivers_mutex);
+	esp_err_t ret = _gn_sim_ds18x20_read(pin, addr, temperature);
+	pthread_mutex_unlock(&_gn_sim_drivers_mutex);
+	return ret;
+
+}
+
+esp_err_t ds18x20_measure_and_read(gpio_num_t pin, ds18x20_addr_t addr,
+		float *temperature) {
+
+	esp_err_t ret = ds18x20_measure(pin, addr, true);
+	if (ret != ESP_OK)
+		return ret;
+	return ds18x20_read_temperature(pin, addr, temperature);
+
+}
+
+esp_err_t ds18x20_read_temp_multi(gpio_num_t pin, ds18x20_addr_t *addr_list,
+		size_t addr_count, float *result_list) {
+
+	if (!addr_list || !result_list)
+		return ESP_ERR_INVALID_ARG;
+
+	esp_err_t ret = ESP_OK;
+	pthread_mutex_lock(&_gn_sim_drivers_mutex);
+	for (size_t i = 0; i < addr_count; i++) {
+		esp_err_t r = _gn_sim_ds18x20_read(pin, addr_list[i], &result_list[i]);
+		if (r != ESP_OK)
+			ret = r;
+	}
+	pthread_mutex_unlock(&_gn_sim_drivers_mutex);
+	return ret;
+
+}
+
+esp_err_t ds18x20_measure_and_read_multi(gpio_num_t pin,
+		ds18x20_addr_t *addr_list, size_t addr_count, float *result_list) {
+
+	esp_err_t ret = ds18x20_measure(pin, DS18X20_ANY, true);
+	if (ret != ESP_OK)
+		return ret;
+	return ds18x20_read_temp_multi(pin, addr_list, addr_count, result_list);
+
+}
+
+void gn_sim_ds18x20_set(int gpio, size_t index, float temperature) {
+
+	if (!_gn_sim_gpio_valid((gpio_num_t) gpio)
+			|| index >= GN_SIM_DS18X20_MAX_SENSORS)
+		return;
+
+	pthread_mutex_lock(&_gn_sim_drivers_mutex);
+	_gn_sim_ds18x20[gpio].temperature[index] = temperature;
+	//new sensors power on at 12 bits
+	for (size_t i = _gn_sim_ds18x20[gpio].count; i <= index; i++) {
+		_gn_sim_ds18x20[gpio].latched[i] = GN_SIM_DS18X20_POWER_ON_TEMPERATURE;
+		_gn_sim_ds18x20[gpio].config[i] = 0x7f;
+	}
+	if (_gn_sim_ds18x20[gpio].count <= index)
+		_gn_sim_ds18x20[gpio].count = index + 1;
+	pthread_mutex_unlock(&_gn_sim_drivers_mutex);
+
+}
+
+//i2c and bme280
+
+static float _gn_sim_bmp280_temperature = 21.0;
+static float _gn_sim_bmp280_pressure = 101325.0;
+static float _gn_sim_bmp280_humidity = 50.0;
+
+esp_err_t i2cdev_init(void) {
+	return ESP_OK;
+}
+
+esp_err_t i2cdev_done(void) {
+	return ESP_OK;
+}
+
+esp_err_t i2c_dev_create_mutex(i2c_dev_t *dev) {
+
+	if (!dev)
+		return ESP_ERR_INVALID_ARG;
+	dev->mutex = xSemaphoreCreateMutex();
+	return dev->mutex ? ESP_OK : ESP_ERR_NO_MEM;
+
+}
+
+esp_err_t i2c_dev_delete_mutex(i2c_dev_t *dev) {
+
+	if (!dev)
+		return ESP_ERR_INVALID_ARG;
+	vSemaphoreDelete(dev->mutex);
+	dev->mutex = NULL;
+	return ESP_OK;
+
+}
+
+esp_err_t i2c_dev_take_mutex(i2c_dev_t *dev) {
+
+	if (!dev || !dev->mutex)
+		return ESP_ERR_INVALID_ARG;
+	return xSemaphoreTake(dev->mutex, portMAX_DELAY) == pdTRUE ?
+			ESP_OK : ESP_ERR_TIMEOUT;
+
+}
+
+esp_err_t i2c_dev_give_mutex(i2c_dev_t *dev) {
+
+	if (!dev || !dev->mutex)
+		return ESP_ERR_INVALID_ARG;
+	xSemaphoreGive(dev->mutex);
+	return ESP_OK;
+
+}
+
+//register file of the generic i2c slaves, read and written byte by byte from the register address on
+
+#define GN_SIM_I2C_REGS 256
+
+typedef struct {
+	bool used;
+	int port;
+	uint8_t addr;
+	uint8_t regs[GN_SIM_I2C_REGS];
+	uint32_t fail; /*!< next transactions failing with a timeout */
+	uint32_t transactions;
+} gn_sim_i2c_slave_t;
+
+static gn_sim_i2c_slave_t _gn_sim_i2c_slaves[GN_SIM_I2C_MAX_SLAVES];
+
+//call with the drivers mutex held
+static gn_sim_i2c_slave_t* _gn_sim_i2c_slave(int port, uint8_t addr,
+		bool create) {
+
+	gn_sim_i2c_slave_t *free_slave = NULL;
+	for (size_t i = 0; i < GN_SIM_I2C_MAX_SLAVES; i++) {
+		gn_sim_i2c_slave_t *s = &_gn_sim_i2c_slaves[i];
+		if (s->used && s->port == port && s->addr == addr)
+			return s;
+		if (!s->used && !free_slave)
+			free_slave = s;
+	}
+	if (!create || !free_slave)
+		return NULL;
+	memset(free_slave, 0, sizeof(gn_sim_i2c_slave_t));
+	free_slave->used = true;
+	free_slave->port = port;
+	free_slave->addr = addr;
+	return free_slave;
+
+}
+
+static esp_err_t _gn_sim_i2c_transfer(const i2c_dev_t *dev, uint8_t reg,
+		uint8_t *data, size_t size, bool write) {
+
+	if (!dev || !data || size == 0 || reg + size > GN_SIM_I2C_REGS)
+		return ESP_ERR_INVALID_ARG;
+
+	esp_err_t ret = ESP_OK;
+	pthread_mutex_lock(&_gn_sim_drivers_mutex);
+	gn_sim_i2c_slave_t *s = _gn_sim_i2c_slave(dev->port, dev->addr, false);
+	if (!s) {
+		//no acknowledge from the address
+		ret = ESP_FAIL;
+	} else {
+		s->transactions++;
+		if (s->fail > 0) {
+			s->fail--;
+			ret = ESP_ERR_TIMEOUT;
+		} else if (write)
+			memcpy(&s->regs[reg], data, size);
+		else
+			memcpy(data, &s->regs[reg], size);
+	}
+	pthread_mutex_unlock(&_gn_sim_drivers_mutex);
+	return ret;
+
+}
+
+esp_err_t i2c_dev_read_reg(const i2c_dev_t *dev, uint8_t reg, void *in_data,
+		size_t in_size) {
+	return _gn_sim_i2c_transfer(dev, reg, in_data, in_size, false);
+}
+
+esp_err_t i2c_dev_write_reg(const i2c_dev_t *dev, uint8_t reg,
+		const void *out_data, size_t out_size) {
+	return _gn_sim_i2c_transfer(dev, reg, (uint8_t*) out_data, out_size, true);
+}
+
+void gn_sim_i2c_set_regs(int port, uint8_t addr, uint8_t reg,
+		const void *data, size_t size) {
+
+	pthread_mutex_lock(&_gn_sim_drivers_mutex);
+	gn_sim_i2c_slave_t *s = _gn_sim_i2c_slave(port, addr, true);
+	if (s && reg + size <= GN_SIM_I2C_REGS)
+		memcpy(&s->regs[reg], data, size);
+	pthread_mutex_unlock(&_gn_sim_drivers_mutex);
+
+}
+
+void gn_sim_i2c_get_regs(int port, uint8_t addr, uint8_t reg, void *data,
+		size_t size) {
+
+	pthread_mutex_lock(&_gn_sim_drivers_mutex);
+	gn_sim_i2c_slave_t *s = _gn_sim_i2c_slave(port, addr, false);
+	if (s && reg + size <= GN_SIM_I2C_REGS)
+		memcpy(data, &s->regs[reg], size);
+	else
+		memset(data, 0, size);
+	pthread_mutex_unlock(&_gn_sim_drivers_mutex);
+
+}
+
+void gn_sim_i2c_fail(int port, uint8_t addr, uint32_t transactions) {
+
+	pthread_mutex_lock(&_gn_sim_drivers_mutex);
+	gn_sim_i2c_slave_t *s = _gn_sim_i2c_slave(port, addr, true);
+	if (s)
+		s->fail = transactions;
+	pthread_mutex_unlock(&_gn_sim_drivers_mutex);
+
+}
+
+uint32_t gn_sim_i2c_get_transactions(int port, uint8_t addr) {
+
+	pthread_mutex_lock(&_gn_sim_drivers_mutex);
+	gn_sim_i2c_slave_t *s = _gn_sim_i2c_slave(port, addr, false);
+	uint32_t transactions = s ? s->transactions : 0;
+	pthread_mutex_unlock(&_gn_sim_drivers_mutex);
+	return transactions;
+
+}
+
+esp_err_t bmp280_init_desc(bmp280_t *dev, uint8_t addr, i2c_port_t port,
+		int sda_gpio, int scl_gpio) {
+
+	if (!dev)
+		return ESP_ERR_INVALID_ARG;
+	if (addr != BMP280_I2C_ADDRESS_0 && addr != BMP280_I2C_ADDRESS_1)
+		return ESP_ERR_INVALID_ARG;
+
+	dev->i2c_dev.port = port;
+	dev->i2c_dev.addr = addr;
+	dev->i2c_dev.cfg.sda_io_num = sda_gpio;
+	dev->i2c_dev.cfg.scl_io_num = scl_gpio;
+	dev->i2c_dev.cfg.master.clk_speed = 1000000;
+	return i2c_dev_create_mutex(&dev->i2c_dev);
+
+}
+
+esp_err_t bmp280_free_desc(bmp280_t *dev) {
+	return i2c_dev_delete_mutex(&dev->i2c_dev);
+}
+
+esp_err_t bmp280_init_default_params(bmp280_params_t *params) {
+
+	if (!params)
+		return ESP_ERR_INVALID_ARG;
+	params->mode = BMP280_MODE_NORMAL;
+	params->filter = BMP280_FILTER_OFF;
+	params->oversampling_pressure = BMP280_STANDARD;
+	params->oversampling_temperature = BMP280_STANDARD;
+	params->oversampling_humidity = BMP280_STANDARD;
+	params->standby = BMP280_STANDBY_250;
+	return ESP_OK;
+
+}
+
+esp_err_t bmp280_init(bmp280_t *dev, bmp280_params_t *params) {
+
+	if (!dev || !params)
+		return ESP_ERR_INVALID_ARG;
+	dev->id = BME280_CHIP_ID;
+	return ESP_OK;
+
+}
+
+esp_err_t bmp280_force_measurement(bmp280_t *dev) {
+	return dev ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t bmp280_is_measuring(bmp280_t *dev, bool *busy) {
+
+	if (!dev || !busy)
+		return ESP_ERR_INVALID_ARG;
+	*busy = false;
+	return ESP_OK;
+
+}
+
+esp_err_t bmp280_read_float(bmp280_t *dev, float *temperature, float *pressure,
+		float *humidity) {
+
+	if (!dev || !temperature || !pressure)
+		return ESP_ERR_INVALID_ARG;
+
+	pthread_mutex_lock(&_gn_sim_drivers_mutex);
+	*temperature = _gn_sim_bmp280_temperature;
+	*pressure = _gn_sim_bmp280_pressure;
+	if (humidity)
+		*humidity = _gn_sim_bmp280_humidity;
+	pthread_mutex_unlock(&_gn_sim_drivers_mutex);
+	return ESP_OK;
+
+}
+
+void gn_sim_bmp280_set(float temperature, float pressure, float humidity) {
+
+	pthread_mutex_lock(&_gn_sim_drivers_mutex);
+	_gn_sim_bmp280_temperature = temperature;
+	_gn_sim_bmp280_pressure = pressure;
+	_gn_sim_bmp280_humidity = humidity;
+	pthread_mutex_unlock(&_gn_sim_drivers_mutex);
+
+}
+
+//ina219, registers are big endian as on the wire
+
+#define GN_SIM_INA219_REG_CONFIG 0x00
+#define GN_SIM_INA219_REG_CALIBRATION 0x05
+
+static esp_err_t _gn_sim_ina219_write(ina219_t *dev, uint8_t reg,
+		uint16_t val) {
+
+	uint8_t buf[2] = { val >> 8, val & 0xff };
+	return i2c_dev_write_reg(&dev->i2c_dev, reg, buf, sizeof(buf));
+
+}
+
+esp_err_t ina219_init_desc(ina219_t *dev, uint8_t addr, i2c_port_t port,
+		int sda_gpio, int scl_gpio) {
+
+	if (!dev)
+		return ESP_ERR_INVALID_ARG;
+	//A0 and A1 select one of 16 addresses from 0x40
+	if ((addr & 0xf0) != INA219_ADDR_GND_GND)
+		return ESP_ERR_INVALID_ARG;
+
+	dev->i2c_dev.port = port;
+	dev->i2c_dev.addr = addr;
+	dev->i2c_dev.cfg.sda_io_num = sda_gpio;
+	dev->i2c_dev.cfg.scl_io_num = scl_gpio;
+	dev->i2c_dev.cfg.master.clk_speed = 1000000;
+	return i2c_dev_create_mutex(&dev->i2c_dev);
+
+}
+
+esp_err_t ina219_free_desc(ina219_t *dev) {
+	return i2c_dev_delete_mutex(&dev->i2c_dev);
+}
+
+esp_err_t ina219_init(ina219_t *dev) {
+
+	if (!dev)
+		return ESP_ERR_INVALID_ARG;
+
+	//power on configuration, as the driver reads it back
+	uint8_t buf[2];
+	esp_err_t ret = i2c_dev_read_reg(&dev->i2c_dev, GN_SIM_INA219_REG_CONFIG,
+			buf, sizeof(buf));
+	if (ret == ESP_OK)
+		dev->config = (buf[0] << 8) | buf[1];
+	return ret;
+
+}
+
+esp_err_t ina219_configure(ina219_t *dev, ina219_bus_voltage_range_t u_range,
+		ina219_gain_t gain, ina219_resolution_t u_res,
+		ina219_resolution_t i_res, ina219_mode_t mode) {
+
+	if (!dev)
+		return ESP_ERR_INVALID_ARG;
+
+	dev->config = (u_range << 13) | (gain << 11) | (u_res << 7) | (i_res << 3)
+			| mode;
+	return _gn_sim_ina219_write(dev, GN_SIM_INA219_REG_CONFIG, dev->config);
+
+}
+
+esp_err_t ina219_calibrate(ina219_t *dev, float i_expected_max, float r_shunt) {
+
+	if (!dev || i_expected_max <= 0 || r_shunt <= 0)
+		return ESP_ERR_INVALID_ARG;
+
+	dev->i_lsb = i_expected_max / 32768;
+	dev->p_lsb = dev->i_lsb * 20;
+	return _gn_sim_ina219_write(dev, GN_SIM_INA219_REG_CALIBRATION,
+			(uint16_t) (0.04096f / (dev->i_lsb * r_shunt)));
+
+}
@@ -0,0 +1,346 @@
+// Copyright 2021 Nicola Muratori (nicola.muratori@gmail.com)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * esp_event loops. posted data is copied and handlers are called from the loop task,
+ * bases are compared by address as in esp_event
+ */
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+
+#include "esp_log.h"
+#include "esp_event.h"
+
+#define TAG "gn_sim_event"
+
+#define _GN_SIM_EVENT_DEFAULT_QUEUE_SIZE 32
+
+typedef struct gn_sim_event_handler {
+	esp_event_base_t base;
+	int32_t id;
+	esp_event_handler_t fn;
+	void *arg;
+	struct gn_sim_event_handler *next;
+} gn_sim_event_handler_t;
+
+typedef struct {
+	esp_event_base_t base;
+	int32_t id;
+	void *data;
+} gn_sim_event_t;
+
+typedef struct {
+	QueueHandle_t queue;
+	TaskHandle_t task;
+	pthread_mutex_t mutex;
+	gn_sim_event_handler_t *handlers;
+} gn_sim_event_loop_t;
+
+static gn_sim_event_loop_t *_gn_sim_default_loop = NULL;
+
+static void _gn_sim_event_dispatch(gn_sim_event_loop_t *loop,
+		gn_sim_event_t *evt) {
+
+	//handlers can register or unregister other handlers, so they are called on a snapshot
+	gn_sim_event_handler_t snapshot[32];
+	gn_sim_event_handler_t *matching = snapshot;
+	size_t count = 0, size = sizeof(snapshot) / sizeof(snapshot[0]);
+
+	pthread_mutex_lock(&loop->mutex);
+	for (gn_sim_event_handler_t *h = loop->handlers; h; h = h->next) {
+		if ((h->base != ESP_EVENT_ANY_BASE && h->base != evt->base)
+				|| (h->id != ESP_EVENT_ANY_ID && h->id != evt->id))
+			continue;
+		if (count == size) {
+			size *= 2;
+			gn_sim_event_handler_t *grown = malloc(
+					size * sizeof(gn_sim_event_handler_t));
+			memcpy(grown, matching, count * sizeof(gn_sim_event_handler_t));
+			if (matching != snapshot)
+				free(matching);
+			matching = grown;
+		}
+		matching[count++] = *h;
+	}
+	pthread_mutex_unlock(&loop->mutex);
+
+	for (size_t i = 0; i < count; i++)
+		matching[i].fn(matching[i].arg, evt->base, evt->id, evt->data);
+
+	if (matching != snapshot)
+		free(matching);
+	free(evt->data);
+
+}
+
+static void _gn_sim_event_loop_task(void *arg) {
+
+	gn_sim_event_loop_t *loop = (gn_sim_event_loop_t*) arg;
+	gn_sim_event_t evt;
+
+	while (true) {
+		if (xQueueReceive(loop->queue, &evt, portMAX_DELAY) == pdTRUE)
+			_gn_sim_event_dispatch(loop, &evt);
+	}
+
+}
+
+esp_err_t esp_event_loop_create(const esp_event_loop_args_t *event_loop_args,
+		esp_event_loop_handle_t *event_loop) {
+
+	if (!event_loop_args || !event_loop)
+		return ESP_ERR_INVALID_ARG;
+
+	gn_sim_event_loop_t *loop = calloc(1, sizeof(gn_sim_event_loop_t));
+	if (!loop)
+		return ESP_ERR_NO_MEM;
+
+	loop->queue = xQueueCreate(event_loop_args->queue_size,
+			sizeof(gn_sim_event_t));
+	if (!loop->queue) {
+		free(loop);
+		return ESP_ERR_NO_MEM;
+	}
+	pthread_mutex_init(&loop->mutex, NULL);
+
+	//loops without a task are dispatched by the poster
+	if (event_loop_args->task_name
+			&& xTaskCreatePinnedToCore(_gn_sim_event_loop_task,
+					event_loop_args->task_name,
+					event_loop_args->task_stack_size, loop,
+					event_loop_args->task_priority, &loop->task,
+					event_loop_args->task_core_id) != pdPASS) {
+		vQueueDelete(loop->queue);
+		free(loop);
+		return ESP_FAIL;
+	}
+
+	*event_loop = loop;
+	return ESP_OK;
+
+}
+
+esp_err_t esp_event_loop_delete(esp_event_loop_handle_t event_loop) {
+
+	gn_sim_event_loop_t *loop = (gn_sim_event_loop_t*) event_loop;
+	if (!loop)
+		return ESP_ERR_INVALID_ARG;
+
+	if (loop->task)
+		vTaskDelete(loop->task);
+
+	pthread_mutex_lock(&loop->mutex);
+	while (loop->handlers) {
+		gn_sim_event_handler_t *next = loop->handlers->next;
+		free(loop->handlers);
+		loop->handlers = next;
+	}
+	pthread_mutex_unlock(&loop->mutex);
+
+	//the queue is left to the detached loop thread, that keeps waiting on it
+	return ESP_OK;
+
+}
+
+esp_err_t esp_event_loop_create_default(void) {
+
+	if (_gn_sim_default_loop)
+		return ESP_ERR_INVALID_STATE;
+
+	esp_event_loop_args_t args = { .queue_size =
+			_GN_SIM_EVENT_DEFAULT_QUEUE_SIZE, .task_name = "sys_evt",
+			.task_priority = 20, .task_stack_size = 2304, .task_core_id = 0 };
+
+	esp_event_loop_handle_t loop;
+	esp_err_t ret = esp_event_loop_create(&args, &loop);
+	if (ret == ESP_OK)
+		_gn_sim_default_loop = loop;
+	return ret;
+
+}
+
+esp_err_t esp_event_loop_delete_default(void) {
+
+	if (!_gn_sim_default_loop)
+		return ESP_ERR_INVALID_STATE;
+	esp_err_t ret = esp_event_loop_delete(_gn_sim_default_loop);
+	_gn_sim_default_loop = NULL;
+	return ret;
+
+}
+
+esp_err_t esp_event_handler_instance_register_with(
+		esp_event_loop_handle_t event_loop, esp_event_base_t event_base,
+		int32_t event_id, esp_event_handler_t event_handler,
+		void *event_handler_arg, esp_event_handler_instance_t *instance) {
+
+	gn_sim_event_loop_t *loop = (gn_sim_event_loop_t*) event_loop;
+	if (!loop || !event_handler)
+		return ESP_ERR_INVALID_ARG;
+
+	if (event_base == ESP_EVENT_ANY_BASE && event_id != ESP_EVENT_ANY_ID)
+		return ESP_ERR_INVALID_ARG;
+
+	gn_sim_event_handler_t *h = calloc(1, sizeof(gn_sim_event_handler_t));
+	if (!h)
+		return ESP_ERR_NO_MEM;
+
+	h->base = event_base;
+	h->id = event_id;
+	h->fn = event_handler;
+	h->arg = event_handler_arg;
+
+	//appended, to keep the registration order when dispatching
+	pthread_mutex_lock(&loop->mutex);
+	gn_sim_event_handler_t **last = &loop->handlers;
+	while (*last)
+		last = &(*last)->next;
+	*last = h;
+	pthread_mutex_unlock(&loop->mutex);
+
+	if (instance)
+		*instance = h;
+	return ESP_OK;
+
+}
+
+esp_err_t esp_event_handler_register_with(esp_event_loop_handle_t event_loop,
+		esp_event_base_t event_base, int32_t event_id,
+		esp_event_handler_t event_handler, void *event_handler_arg) {
+	return esp_event_handler_instance_register_with(event_loop, event_base,
+			event_id, event_handler, event_handler_arg, NULL);
+}
+
+esp_err_t esp_event_handler_register(esp_event_base_t event_base,
+		int32_t event_id, esp_event_handler_t event_handler,
+		void *event_handler_arg) {
+	return esp_event_handler_instance_register_with(_gn_sim_default_loop,
+			event_base, event_id, event_handler, event_handler_arg, NULL);
+}
+
+esp_err_t esp_event_handler_instance_register(esp_event_base_t event_base,
+		int32_t event_id, esp_event_handler_t event_handler,
+		void *event_handler_arg, esp_event_handler_instance_t *instance) {
+	return esp_event_handler_instance_register_with(_gn_sim_default_loop,
+			event_base, event_id, event_handler, event_handler_arg, instance);
+}
+
+static esp_err_t _gn_sim_event_unregister(gn_sim_event_loop_t *loop,
+		esp_event_base_t event_base, int32_t event_id,
+		esp_event_handler_t event_handler, gn_sim_event_handler_t *instance) {
+
+	if (!loop)
+		return ESP_ERR_INVALID_ARG;
+
+	pthread_mutex_lock(&loop->mutex);
+	for (gn_sim_event_handler_t **h = &loop->handlers; *h; h = &(*h)->next) {
+		if (instance ?
+				*h == instance :
+				((*h)->fn == event_handler && (*h)->base == event_base
+						&& (*h)->id == event_id)) {
+			gn_sim_event_handler_t *found = *h;
+			*h = found->next;
+			free(found);
+			break;
+		}
+	}
+	pthread_mutex_unlock(&loop->mutex);
+	return ESP_OK;
+
+}
+
+esp_err_t esp_event_handler_unregister_with(esp_event_loop_handle_t event_loop,
+		esp_event_base_t event_base, int32_t event_id,
+		esp_event_handler_t event_handler) {
+	return _gn_sim_event_unregister(event_loop, event_base, event_id,
+			event_handler, NULL);
+}
+
+esp_err_t esp_event_handler_unregister(esp_event_base_t event_base,
+		int32_t event_id, esp_event_handler_t event_handler) {
+	return _gn_sim_event_unregister(_gn_sim_default_loop, event_base, event_id,
+			event_handler, NULL);
+}
+
+esp_err_t esp_event_handler_instance_unregister_with(
+		esp_event_loop_handle_t event_loop, esp_event_base_t event_base,
+		int32_t event_id, esp_event_handler_instance_t instance) {
+	if (!instance)
+		return ESP_ERR_INVALID_ARG;
+	return _gn_sim_event_unregister(event_loop, event_base, event_id, NULL,
+			instance);
+}
+
+esp_err_t esp_event_handler_instance_unregister(esp_event_base_t event_base,
+		int32_t event_id, esp_event_handler_instance_t instance) {
+	return esp_event_handler_instance_unregister_with(_gn_sim_default_loop,
+			event_base, event_id, instance);
+}
+
+esp_err_t esp_event_post_to(esp_event_loop_handle_t event_loop,
+		esp_event_base_t event_base, int32_t event_id, void *event_data,
+		size_t event_data_size, TickType_t ticks_to_wait) {
+
+	gn_sim_event_loop_t *loop = (gn_sim_event_loop_t*) event_loop;
+	if (!loop)
+		return ESP_ERR_INVALID_ARG;
+
+	gn_sim_event_t evt = { .base = event_base, .id = event_id, .data = NULL };
+
+	if (event_data && event_data_size > 0) {
+		evt.data = malloc(event_data_size);
+		if (!evt.data)
+			return ESP_ERR_NO_MEM;
+		memcpy(evt.data, event_data, event_data_size);
+	}
+
+	if (!loop->task) {
+		_gn_sim_event_dispatch(loop, &evt);
+		return ESP_OK;
+	}
+
+	if (xQueueSend(loop->queue, &evt, ticks_to_wait) != pdTRUE) {
+		ESP_LOGD(TAG, "event queue full, %s:%d dropped", event_base,
+				(int ) event_id);
+		free(evt.data);
+		return ESP_ERR_TIMEOUT;
+	}
+
+	return ESP_OK;
+
+}
+
+esp_err_t esp_event_post(esp_event_base_t event_base, int32_t event_id,
+		void *event_data, size_t event_data_size, TickType_t ticks_to_wait) {
+	return esp_event_post_to(_gn_sim_default_loop, event_base, event_id,
+			event_data, event_data_size, ticks_to_wait);
+}
+
+esp_err_t esp_event_isr_post_to(esp_event_loop_handle_t event_loop,
+		esp_event_base_t event_base, int32_t event_id, void *event_data,
+		size_t event_data_size, BaseType_t *task_unblocked) {
+
+	if (task_unblocked)
+		*task_unblocked = pdFALSE;
+	esp_err_t ret = esp_event_post_to(event_loop, event_base, event_id,
+			event_data, event_data_size, 0);
+	return ret == ESP_ERR_TIMEOUT ? ESP_FAIL : ret;
+
+}
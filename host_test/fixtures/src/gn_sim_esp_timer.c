@@ -0,0 +1,239 @@
+// Copyright 2021 Nicola Muratori (nicola.muratori@gmail.com)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * esp_timer on a single timer task. callbacks run one at a time, as with ESP_TIMER_TASK dispatch
+ */
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "gn_sim_intl.h"
+
+#define TAG "gn_sim_timer"
+
+struct gn_sim_timer {
+	esp_timer_cb_t callback;
+	void *arg;
+	const char *name;
+	bool skip_unhandled_events;
+	uint64_t period_us;
+	int64_t alarm_us;
+	bool active;
+	struct gn_sim_timer *next;
+};
+
+static pthread_mutex_t _gn_sim_timer_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t _gn_sim_timer_cond;
+static struct gn_sim_timer *_gn_sim_timers = NULL;
+
+static pthread_once_t _gn_sim_timer_once = PTHREAD_ONCE_INIT;
+static struct timespec _gn_sim_timer_boot;
+
+static void _gn_sim_timer_task(void *arg);
+
+static void _gn_sim_timer_init(void) {
+	clock_gettime(CLOCK_MONOTONIC, &_gn_sim_timer_boot);
+	_gn_sim_cond_init(&_gn_sim_timer_cond);
+	xTaskCreate(_gn_sim_timer_task, "esp_timer", 4096, NULL, 22, NULL);
+}
+
+int64_t esp_timer_get_time(void) {
+
+	pthread_once(&_gn_sim_timer_once, _gn_sim_timer_init);
+
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (int64_t) (now.tv_sec - _gn_sim_timer_boot.tv_sec) * 1000000LL
+			+ (now.tv_nsec - _gn_sim_timer_boot.tv_nsec) / 1000L;
+
+}
+
+static struct gn_sim_timer* _gn_sim_timer_next(void) {
+
+	struct gn_sim_timer *next = NULL;
+	for (struct gn_sim_timer *t = _gn_sim_timers; t; t = t->next)
+		if (t->active && (!next || t->alarm_us < next->alarm_us))
+			next = t;
+	return next;
+
+}
+
+static void _gn_sim_timer_task(void *arg) {
+
+	pthread_mutex_lock(&_gn_sim_timer_mutex);
+
+	while (true) {
+
+		struct gn_sim_timer *next = _gn_sim_timer_next();
+		int64_t now = esp_timer_get_time();
+
+		if (!next || next->alarm_us > now) {
+			struct timespec deadline = _gn_sim_timer_boot;
+			TickType_t ticks = portMAX_DELAY;
+			if (next) {
+				deadline.tv_sec += next->alarm_us / 1000000LL;
+				deadline.tv_nsec += (next->alarm_us % 1000000LL) * 1000L;
+				if (deadline.tv_nsec >= 1000000000L) {
+					deadline.tv_sec++;
+					deadline.tv_nsec -= 1000000000L;
+				}
+				ticks = 1;
+			}
+			_gn_sim_cond_wait(&_gn_sim_timer_cond, &_gn_sim_timer_mutex,
+					ticks, &deadline);
+			continue;
+		}
+
+		if (next->period_us) {
+			next->alarm_us += next->period_us;
+			//missed periods are fired once
+			if (next->skip_unhandled_events || next->alarm_us <= now)
+				next->alarm_us = now + next->period_us;
+		} else
+			next->active = false;
+
+		esp_timer_cb_t callback = next->callback;
+		void *cb_arg = next->arg;
+
+		pthread_mutex_unlock(&_gn_sim_timer_mutex);
+		callback(cb_arg);
+		_gn_sim_heap_sample();
+		pthread_mutex_lock(&_gn_sim_timer_mutex);
+
+	}
+
+}
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t *create_args,
+		esp_timer_handle_t *out_handle) {
+
+	if (!create_args || !create_args->callback || !out_handle)
+		return ESP_ERR_INVALID_ARG;
+
+	pthread_once(&_gn_sim_timer_once, _gn_sim_timer_init);
+
+	struct gn_sim_timer *t = calloc(1, sizeof(struct gn_sim_timer));
+	if (!t)
+		return ESP_ERR_NO_MEM;
+
+	t->callback = create_args->callback;
+	t->arg = create_args->arg;
+	t->name = create_args->name;
+	t->skip_unhandled_events = create_args->skip_unhandled_events;
+
+	pthread_mutex_lock(&_gn_sim_timer_mutex);
+	t->next = _gn_sim_timers;
+	_gn_sim_timers = t;
+	pthread_mutex_unlock(&_gn_sim_timer_mutex);
+
+	*out_handle = t;
+	return ESP_OK;
+
+}
+
+static esp_err_t _gn_sim_timer_start(esp_timer_handle_t timer,
+		uint64_t timeout_us, uint64_t period_us) {
+
+	if (!timer)
+		return ESP_ERR_INVALID_ARG;
+
+	pthread_mutex_lock(&_gn_sim_timer_mutex);
+	if (timer->active) {
+		pthread_mutex_unlock(&_gn_sim_timer_mutex);
+		return ESP_ERR_INVALID_STATE;
+	}
+	timer->period_us = period_us;
+	timer->alarm_us = esp_timer_get_time() + timeout_us;
+	timer->active = true;
+	pthread_cond_signal(&_gn_sim_timer_cond);
+	pthread_mutex_unlock(&_gn_sim_timer_mutex);
+
+	return ESP_OK;
+
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us) {
+	return _gn_sim_timer_start(timer, timeout_us, 0);
+}
+
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period) {
+	if (period == 0)
+		return ESP_ERR_INVALID_ARG;
+	return _gn_sim_timer_start(timer, period, period);
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer) {
+
+	if (!timer)
+		return ESP_ERR_INVALID_ARG;
+
+	pthread_mutex_lock(&_gn_sim_timer_mutex);
+	bool was_active = timer->active;
+	timer->active = false;
+	pthread_mutex_unlock(&_gn_sim_timer_mutex);
+
+	return was_active ? ESP_OK : ESP_ERR_INVALID_STATE;
+
+}
+
+esp_err_t esp_timer_delete(esp_timer_handle_t timer) {
+
+	if (!timer)
+		return ESP_ERR_INVALID_ARG;
+
+	pthread_mutex_lock(&_gn_sim_timer_mutex);
+	if (timer->active) {
+		pthread_mutex_unlock(&_gn_sim_timer_mutex);
+		return ESP_ERR_INVALID_STATE;
+	}
+	for (struct gn_sim_timer **t = &_gn_sim_timers; *t; t = &(*t)->next) {
+		if (*t == timer) {
+			*t = timer->next;
+			break;
+		}
+	}
+	pthread_mutex_unlock(&_gn_sim_timer_mutex);
+
+	free(timer);
+	return ESP_OK;
+
+}
+
+bool esp_timer_is_active(esp_timer_handle_t timer) {
+
+	pthread_mutex_lock(&_gn_sim_timer_mutex);
+	bool ret = timer && timer->active;
+	pthread_mutex_unlock(&_gn_sim_timer_mutex);
+	return ret;
+
+}
+
+int64_t esp_timer_get_next_alarm(void) {
+
+	pthread_mutex_lock(&_gn_sim_timer_mutex);
+	struct gn_sim_timer *next = _gn_sim_timer_next();
+	int64_t ret = next ? next->alarm_us : INT64_MAX;
+	pthread_mutex_unlock(&_gn_sim_timer_mutex);
+	return ret;
+
+}
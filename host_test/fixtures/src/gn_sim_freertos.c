@@ -0,0 +1,605 @@
+// Copyright 2021 Nicola Muratori (nicola.muratori@gmail.com)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * FreeRTOS kernel objects on top of pthreads. every task is a detached thread,
+ * priorities and core affinity are recorded but not enforced
+ */
+
+//recursive mutex initializer for critical sections
+#define _GNU_SOURCE
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/event_groups.h"
+
+#include "gn_sim_intl.h"
+
+struct gn_sim_task {
+	pthread_t thread;
+	char name[16];
+	TaskFunction_t fn;
+	void *arg;
+	uint32_t stack_depth;
+	UBaseType_t priority;
+	int state;
+	//direct to task notification, used as a counting semaphore
+	pthread_mutex_t notify_mutex;
+	pthread_cond_t notify_cond;
+	uint32_t notify_value;
+};
+
+struct gn_sim_queue {
+	pthread_mutex_t mutex;
+	pthread_cond_t not_empty;
+	pthread_cond_t not_full;
+	size_t length;
+	size_t item_size;
+	size_t count;
+	size_t head;
+	uint8_t *buf;
+};
+
+struct gn_sim_event_group {
+	pthread_mutex_t mutex;
+	pthread_cond_t changed;
+	EventBits_t bits;
+};
+
+static __thread struct gn_sim_task *_gn_sim_current_task = NULL;
+
+static pthread_mutex_t _gn_sim_tasks_mutex = PTHREAD_MUTEX_INITIALIZER;
+static UBaseType_t _gn_sim_tasks_count = 0;
+
+static struct timespec _gn_sim_boot;
+static pthread_once_t _gn_sim_boot_once = PTHREAD_ONCE_INIT;
+
+static void _gn_sim_boot_init(void) {
+	clock_gettime(CLOCK_MONOTONIC, &_gn_sim_boot);
+}
+
+void _gn_sim_task_set_blocked(bool blocked) {
+	if (_gn_sim_current_task)
+		__atomic_store_n(&_gn_sim_current_task->state,
+				blocked ? eBlocked : eRunning, __ATOMIC_RELEASE);
+}
+
+void _gn_sim_deadline(struct timespec *ts, TickType_t ticks) {
+	clock_gettime(CLOCK_MONOTONIC, ts);
+	ts->tv_sec += ticks / 1000;
+	ts->tv_nsec += (long) (ticks % 1000) * 1000000L;
+	if (ts->tv_nsec >= 1000000000L) {
+		ts->tv_sec++;
+		ts->tv_nsec -= 1000000000L;
+	}
+}
+
+void _gn_sim_cond_init(pthread_cond_t *cond) {
+	pthread_condattr_t attr;
+	pthread_condattr_init(&attr);
+	pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+	pthread_cond_init(cond, &attr);
+	pthread_condattr_destroy(&attr);
+}
+
+bool _gn_sim_cond_wait(pthread_cond_t *cond, pthread_mutex_t *mutex,
+		TickType_t ticks, const struct timespec *deadline) {
+
+	if (ticks == 0)
+		return false;
+
+	_gn_sim_task_set_blocked(true);
+	int ret = 0;
+	if (ticks == portMAX_DELAY)
+		ret = pthread_cond_wait(cond, mutex);
+	else
+		ret = pthread_cond_timedwait(cond, mutex, deadline);
+	_gn_sim_task_set_blocked(false);
+
+	return ret != ETIMEDOUT;
+
+}
+
+//critical sections
+
+static pthread_mutex_t _gn_sim_critical_mutex =
+		PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;
+
+void gn_sim_enter_critical(void) {
+	pthread_mutex_lock(&_gn_sim_critical_mutex);
+}
+
+void gn_sim_exit_critical(void) {
+	pthread_mutex_unlock(&_gn_sim_critical_mutex);
+}
+
+//tasks
+
+static void* _gn_sim_task_main(void *arg) {
+
+	struct gn_sim_task *task = (struct gn_sim_task*) arg;
+	_gn_sim_current_task = task;
+	task->fn(task->arg);
+
+	//returning from a task function is an error in FreeRTOS, here it is like deleting itself
+	vTaskDelete(NULL);
+	return NULL;
+
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t pvTaskCode,
+		const char *pcName, uint32_t usStackDepth, void *pvParameters,
+		UBaseType_t uxPriority, TaskHandle_t *pvCreatedTask,
+		BaseType_t xCoreID) {
+
+	(void) xCoreID;
+
+	struct gn_sim_task *task = calloc(1, sizeof(struct gn_sim_task));
+	if (!task)
+		return pdFAIL;
+
+	strncpy(task->name, pcName ? pcName : "", sizeof(task->name) - 1);
+	task->fn = pvTaskCode;
+	task->arg = pvParameters;
+	task->stack_depth = usStackDepth;
+	task->priority = uxPriority;
+	task->state = eReady;
+	pthread_mutex_init(&task->notify_mutex, NULL);
+	_gn_sim_cond_init(&task->notify_cond);
+
+	pthread_attr_t attr;
+	pthread_attr_init(&attr);
+	pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+
+	pthread_mutex_lock(&_gn_sim_tasks_mutex);
+	_gn_sim_tasks_count++;
+	pthread_mutex_unlock(&_gn_sim_tasks_mutex);
+
+	if (pvCreatedTask)
+		*pvCreatedTask = task;
+
+	if (pthread_create(&task->thread, &attr, _gn_sim_task_main, task) != 0) {
+		pthread_attr_destroy(&attr);
+		pthread_mutex_lock(&_gn_sim_tasks_mutex);
+		_gn_sim_tasks_count--;
+		pthread_mutex_unlock(&_gn_sim_tasks_mutex);
+		if (pvCreatedTask)
+			*pvCreatedTask = NULL;
+		pthread_cond_destroy(&task->notify_cond);
+		pthread_mutex_destroy(&task->notify_mutex);
+		free(task);
+		return pdFAIL;
+	}
+
+	pthread_attr_destroy(&attr);
+	return pdPASS;
+
+}
+
+BaseType_t xTaskCreate(TaskFunction_t pvTaskCode, const char *pcName,
+		uint32_t usStackDepth, void *pvParameters, UBaseType_t uxPriority,
+		TaskHandle_t *pvCreatedTask) {
+	return xTaskCreatePinnedToCore(pvTaskCode, pcName, usStackDepth,
+			pvParameters, uxPriority, pvCreatedTask, tskNO_AFFINITY);
+}
+
+void vTaskDelete(TaskHandle_t xTaskToDelete) {
+
+	struct gn_sim_task *task =
+			xTaskToDelete ? xTaskToDelete : _gn_sim_current_task;
+
+	if (!task || __atomic_load_n(&task->state, __ATOMIC_ACQUIRE) == eDeleted)
+		return;
+
+	__atomic_store_n(&task->state, eDeleted, __ATOMIC_RELEASE);
+
+	pthread_mutex_lock(&_gn_sim_tasks_mutex);
+	_gn_sim_tasks_count--;
+	pthread_mutex_unlock(&_gn_sim_tasks_mutex);
+
+	//the handle stays valid (and deleted) as other tasks may still query it
+	if (task == _gn_sim_current_task)
+		pthread_exit(NULL);
+
+}
+
+void vTaskDelay(TickType_t xTicksToDelay) {
+
+	if (xTicksToDelay == 0) {
+		sched_yield();
+		return;
+	}
+
+	struct timespec deadline;
+	_gn_sim_deadline(&deadline, xTicksToDelay);
+
+	_gn_sim_task_set_blocked(true);
+	while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL)
+			== EINTR)
+		;
+	_gn_sim_task_set_blocked(false);
+
+}
+
+eTaskState eTaskGetState(TaskHandle_t xTask) {
+
+	if (!xTask)
+		return eInvalid;
+	if (xTask == _gn_sim_current_task)
+		return eRunning;
+	return (eTaskState) __atomic_load_n(&xTask->state, __ATOMIC_ACQUIRE);
+
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void) {
+	return _gn_sim_current_task;
+}
+
+char* pcTaskGetName(TaskHandle_t xTaskToQuery) {
+
+	static char main_name[] = "main";
+	struct gn_sim_task *task =
+			xTaskToQuery ? xTaskToQuery : _gn_sim_current_task;
+	return task ? task->name : main_name;
+
+}
+
+TickType_t xTaskGetTickCount(void) {
+
+	pthread_once(&_gn_sim_boot_once, _gn_sim_boot_init);
+
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (TickType_t) ((now.tv_sec - _gn_sim_boot.tv_sec) * 1000
+			+ (now.tv_nsec - _gn_sim_boot.tv_nsec) / 1000000L);
+
+}
+
+UBaseType_t uxTaskGetNumberOfTasks(void) {
+
+	pthread_mutex_lock(&_gn_sim_tasks_mutex);
+	UBaseType_t ret = _gn_sim_tasks_count;
+	pthread_mutex_unlock(&_gn_sim_tasks_mutex);
+	return ret;
+
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t xTask) {
+
+	//host threads have their own stacks, the requested depth is all that is known
+	struct gn_sim_task *task = xTask ? xTask : _gn_sim_current_task;
+	return task ? task->stack_depth : 0;
+
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t xTaskToNotify) {
+
+	if (!xTaskToNotify)
+		return pdFAIL;
+
+	pthread_mutex_lock(&xTaskToNotify->notify_mutex);
+	xTaskToNotify->notify_value++;
+	pthread_cond_signal(&xTaskToNotify->notify_cond);
+	pthread_mutex_unlock(&xTaskToNotify->notify_mutex);
+	return pdPASS;
+
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t xClearCountOnExit,
+		TickType_t xTicksToWait) {
+
+	struct gn_sim_task *task = _gn_sim_current_task;
+	if (!task)
+		return 0;
+
+	struct timespec deadline;
+	_gn_sim_deadline(&deadline, xTicksToWait);
+
+	pthread_mutex_lock(&task->notify_mutex);
+	while (task->notify_value == 0) {
+		if (!_gn_sim_cond_wait(&task->notify_cond, &task->notify_mutex,
+				xTicksToWait, &deadline))
+			break;
+	}
+	uint32_t ret = task->notify_value;
+	if (ret > 0)
+		task->notify_value = xClearCountOnExit ? 0 : ret - 1;
+	pthread_mutex_unlock(&task->notify_mutex);
+	return ret;
+
+}
+
+//queues and semaphores
+
+QueueHandle_t xQueueCreate(UBaseType_t uxQueueLength, UBaseType_t uxItemSize) {
+
+	if (uxQueueLength == 0)
+		return NULL;
+
+	struct gn_sim_queue *q = calloc(1, sizeof(struct gn_sim_queue));
+	if (!q)
+		return NULL;
+
+	q->length = uxQueueLength;
+	q->item_size = uxItemSize;
+	if (uxItemSize > 0) {
+		q->buf = malloc(uxQueueLength * uxItemSize);
+		if (!q->buf) {
+			free(q);
+			return NULL;
+		}
+	}
+
+	pthread_mutex_init(&q->mutex, NULL);
+	_gn_sim_cond_init(&q->not_empty);
+	_gn_sim_cond_init(&q->not_full);
+	return q;
+
+}
+
+void vQueueDelete(QueueHandle_t xQueue) {
+
+	if (!xQueue)
+		return;
+	pthread_mutex_destroy(&xQueue->mutex);
+	pthread_cond_destroy(&xQueue->not_empty);
+	pthread_cond_destroy(&xQueue->not_full);
+	free(xQueue->buf);
+	free(xQueue);
+
+}
+
+static BaseType_t _gn_sim_queue_send(QueueHandle_t q, const void *item,
+		TickType_t ticks, bool front) {
+
+	if (!q)
+		return pdFAIL;
+
+	struct timespec deadline;
+	if (ticks != portMAX_DELAY)
+		_gn_sim_deadline(&deadline, ticks);
+
+	pthread_mutex_lock(&q->mutex);
+	while (q->count == q->length) {
+		if (!_gn_sim_cond_wait(&q->not_full, &q->mutex, ticks, &deadline)) {
+			pthread_mutex_unlock(&q->mutex);
+			return errQUEUE_FULL;
+		}
+	}
+
+	if (q->item_size > 0) {
+		size_t slot;
+		if (front) {
+			q->head = (q->head + q->length - 1) % q->length;
+			slot = q->head;
+		} else
+			slot = (q->head + q->count) % q->length;
+		memcpy(q->buf + slot * q->item_size, item, q->item_size);
+	}
+	q->count++;
+
+	pthread_cond_signal(&q->not_empty);
+	pthread_mutex_unlock(&q->mutex);
+	return pdPASS;
+
+}
+
+BaseType_t xQueueSend(QueueHandle_t xQueue, const void *pvItemToQueue,
+		TickType_t xTicksToWait) {
+	return _gn_sim_queue_send(xQueue, pvItemToQueue, xTicksToWait, false);
+}
+
+BaseType_t xQueueSendToFront(QueueHandle_t xQueue, const void *pvItemToQueue,
+		TickType_t xTicksToWait) {
+	return _gn_sim_queue_send(xQueue, pvItemToQueue, xTicksToWait, true);
+}
+
+static BaseType_t _gn_sim_queue_receive(QueueHandle_t q, void *buffer,
+		TickType_t ticks, bool peek) {
+
+	if (!q)
+		return pdFAIL;
+
+	struct timespec deadline;
+	if (ticks != portMAX_DELAY)
+		_gn_sim_deadline(&deadline, ticks);
+
+	pthread_mutex_lock(&q->mutex);
+	while (q->count == 0) {
+		if (!_gn_sim_cond_wait(&q->not_empty, &q->mutex, ticks, &deadline)) {
+			pthread_mutex_unlock(&q->mutex);
+			return errQUEUE_EMPTY;
+		}
+	}
+
+	if (q->item_size > 0 && buffer)
+		memcpy(buffer, q->buf + q->head * q->item_size, q->item_size);
+
+	if (!peek) {
+		q->head = (q->head + 1) % q->length;
+		q->count--;
+		pthread_cond_signal(&q->not_full);
+	}
+
+	pthread_mutex_unlock(&q->mutex);
+	return pdPASS;
+
+}
+
+BaseType_t xQueueReceive(QueueHandle_t xQueue, void *pvBuffer,
+		TickType_t xTicksToWait) {
+	return _gn_sim_queue_receive(xQueue, pvBuffer, xTicksToWait, false);
+}
+
+BaseType_t xQueuePeek(QueueHandle_t xQueue, void *pvBuffer,
+		TickType_t xTicksToWait) {
+	return _gn_sim_queue_receive(xQueue, pvBuffer, xTicksToWait, true);
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t xQueue) {
+
+	if (!xQueue)
+		return 0;
+	pthread_mutex_lock(&xQueue->mutex);
+	UBaseType_t ret = xQueue->count;
+	pthread_mutex_unlock(&xQueue->mutex);
+	return ret;
+
+}
+
+UBaseType_t uxQueueSpacesAvailable(QueueHandle_t xQueue) {
+
+	if (!xQueue)
+		return 0;
+	pthread_mutex_lock(&xQueue->mutex);
+	UBaseType_t ret = xQueue->length - xQueue->count;
+	pthread_mutex_unlock(&xQueue->mutex);
+	return ret;
+
+}
+
+BaseType_t xQueueReset(QueueHandle_t xQueue) {
+
+	if (!xQueue)
+		return pdFAIL;
+	pthread_mutex_lock(&xQueue->mutex);
+	xQueue->count = 0;
+	xQueue->head = 0;
+	pthread_cond_broadcast(&xQueue->not_full);
+	pthread_mutex_unlock(&xQueue->mutex);
+	return pdPASS;
+
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void) {
+	return xQueueCreate(1, 0);
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void) {
+
+	SemaphoreHandle_t ret = xQueueCreate(1, 0);
+	if (ret)
+		ret->count = 1;
+	return ret;
+
+}
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t uxMaxCount,
+		UBaseType_t uxInitialCount) {
+
+	SemaphoreHandle_t ret = xQueueCreate(uxMaxCount, 0);
+	if (ret)
+		ret->count = uxInitialCount;
+	return ret;
+
+}
+
+//event groups
+
+EventGroupHandle_t xEventGroupCreate(void) {
+
+	struct gn_sim_event_group *g = calloc(1, sizeof(struct gn_sim_event_group));
+	if (!g)
+		return NULL;
+	pthread_mutex_init(&g->mutex, NULL);
+	_gn_sim_cond_init(&g->changed);
+	return g;
+
+}
+
+void vEventGroupDelete(EventGroupHandle_t xEventGroup) {
+
+	if (!xEventGroup)
+		return;
+	pthread_mutex_destroy(&xEventGroup->mutex);
+	pthread_cond_destroy(&xEventGroup->changed);
+	free(xEventGroup);
+
+}
+
+EventBits_t xEventGroupSetBits(EventGroupHandle_t xEventGroup,
+		const EventBits_t uxBitsToSet) {
+
+	pthread_mutex_lock(&xEventGroup->mutex);
+	xEventGroup->bits |= uxBitsToSet;
+	EventBits_t ret = xEventGroup->bits;
+	pthread_cond_broadcast(&xEventGroup->changed);
+	pthread_mutex_unlock(&xEventGroup->mutex);
+	return ret;
+
+}
+
+EventBits_t xEventGroupClearBits(EventGroupHandle_t xEventGroup,
+		const EventBits_t uxBitsToClear) {
+
+	pthread_mutex_lock(&xEventGroup->mutex);
+	EventBits_t ret = xEventGroup->bits;
+	xEventGroup->bits &= ~uxBitsToClear;
+	pthread_mutex_unlock(&xEventGroup->mutex);
+	return ret;
+
+}
+
+EventBits_t xEventGroupGetBits(EventGroupHandle_t xEventGroup) {
+
+	pthread_mutex_lock(&xEventGroup->mutex);
+	EventBits_t ret = xEventGroup->bits;
+	pthread_mutex_unlock(&xEventGroup->mutex);
+	return ret;
+
+}
+
+EventBits_t xEventGroupWaitBits(EventGroupHandle_t xEventGroup,
+		const EventBits_t uxBitsToWaitFor, const BaseType_t xClearOnExit,
+		const BaseType_t xWaitForAllBits, TickType_t xTicksToWait) {
+
+	struct timespec deadline;
+	if (xTicksToWait != portMAX_DELAY)
+		_gn_sim_deadline(&deadline, xTicksToWait);
+
+	pthread_mutex_lock(&xEventGroup->mutex);
+
+	while (true) {
+
+		EventBits_t bits = xEventGroup->bits;
+		bool satisfied =
+				xWaitForAllBits ?
+						(bits & uxBitsToWaitFor) == uxBitsToWaitFor :
+						(bits & uxBitsToWaitFor) != 0;
+
+		if (satisfied) {
+			if (xClearOnExit)
+				xEventGroup->bits &= ~uxBitsToWaitFor;
+			pthread_mutex_unlock(&xEventGroup->mutex);
+			return bits;
+		}
+
+		if (!_gn_sim_cond_wait(&xEventGroup->changed, &xEventGroup->mutex,
+				xTicksToWait, &deadline)) {
+			bits = xEventGroup->bits;
+			pthread_mutex_unlock(&xEventGroup->mutex);
+			return bits;
+		}
+
+	}
+
+}
@@ -0,0 +1,257 @@
+// Copyright 2021 Nicola Muratori (nicola.muratori@gmail.com)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+/*
+ * HTTP client of the host build: serves in-process the resources registered by the tests
+ */
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+
+#include "esp_log.h"
+#include "esp_http_client.h"
+
+#include "gn_sim.h"
+
+#define TAG "gn_sim_http"
+
+#define _GN_SIM_HTTP_MAX_RESOURCES 4
+#define _GN_SIM_HTTP_URL_SIZE 256
+#define _GN_SIM_HTTP_ETAG_SIZE 16
+
+typedef struct {
+	char url[_GN_SIM_HTTP_URL_SIZE];
+	const uint8_t *data;
+	size_t len;
+	char etag[_GN_SIM_HTTP_ETAG_SIZE];
+} _gn_sim_http_resource_t;
+
+struct esp_http_client {
+	char url[_GN_SIM_HTTP_URL_SIZE];
+	http_event_handle_cb event_handler;
+	void *user_data;
+	size_t range_start; /*!< from the Range header */
+	char if_range[64]; /*!< from the If-Range header */
+	char etag[_GN_SIM_HTTP_ETAG_SIZE]; /*!< of the response */
+	bool open;
+	int status;
+	const uint8_t *data;
+	size_t len;
+	size_t pos;
+	size_t drop_at; /*!< 0 if the connection is not dropped */
+};
+
+static pthread_mutex_t _gn_sim_http_mutex = PTHREAD_MUTEX_INITIALIZER;
+static _gn_sim_http_resource_t _gn_sim_http_resources[_GN_SIM_HTTP_MAX_RESOURCES];
+static size_t _gn_sim_http_served_bytes = 0;
+static size_t _gn_sim_http_drop_after = 0;
+static int _gn_sim_http_drop_connections = 0;
+static bool _gn_sim_http_ranges = true;
+
+void gn_sim_http_serve(const char *url, const uint8_t *data, size_t len) {
+
+	if (!url || strlen(url) >= _GN_SIM_HTTP_URL_SIZE)
+		return;
+
+	pthread_mutex_lock(&_gn_sim_http_mutex);
+	_gn_sim_http_resource_t *free_res = NULL;
+	_gn_sim_http_resource_t *res = NULL;
+	for (int i = 0; i < _GN_SIM_HTTP_MAX_RESOURCES; i++) {
+		if (_gn_sim_http_resources[i].data
+				&& strcmp(_gn_sim_http_resources[i].url, url) == 0)
+			res = &_gn_sim_http_resources[i];
+		else if (!_gn_sim_http_resources[i].data && !free_res)
+			free_res = &_gn_sim_http_resources[i];
+	}
+	if (!res)
+		res = free_res;
+	if (res) {
+		strcpy(res->url, url);
+		res->data = data;
+		res->len = data ? len : 0;
+		//the same content keeps its tag when served again
+		uint32_t h = 2166136261u;
+		for (size_t i = 0; i < res->len; i++)
+			h = (h ^ data[i]) * 16777619u;
+		snprintf(res->etag, sizeof(res->etag), "\"%08x\"", (unsigned) h);
+	} else {
+		ESP_LOGE(TAG, "too many resources served");
+	}
+	_gn_sim_http_served_bytes = 0;
+	pthread_mutex_unlock(&_gn_sim_http_mutex);
+
+}
+
+size_t gn_sim_http_served(void) {
+	pthread_mutex_lock(&_gn_sim_http_mutex);
+	size_t ret = _gn_sim_http_served_bytes;
+	pthread_mutex_unlock(&_gn_sim_http_mutex);
+	return ret;
+}
+
+void gn_sim_http_drop(size_t after, int connections) {
+	pthread_mutex_lock(&_gn_sim_http_mutex);
+	_gn_sim_http_drop_after = after;
+	_gn_sim_http_drop_connections = connections;
+	pthread_mutex_unlock(&_gn_sim_http_mutex);
+}
+
+void gn_sim_http_set_ranges(bool supported) {
+	pthread_mutex_lock(&_gn_sim_http_mutex);
+	_gn_sim_http_ranges = supported;
+	pthread_mutex_unlock(&_gn_sim_http_mutex);
+}
+
+esp_http_client_handle_t esp_http_client_init(
+		const esp_http_client_config_t *config) {
+
+	if (!config || !config->url
+			|| strlen(config->url) >= _GN_SIM_HTTP_URL_SIZE)
+		return NULL;
+
+	esp_http_client_handle_t client = calloc(1, sizeof(struct esp_http_client));
+	if (client) {
+		strcpy(client->url, config->url);
+		client->event_handler = config->event_handler;
+		client->user_data = config->user_data;
+	}
+	return client;
+
+}
+
+esp_err_t esp_http_client_set_header(esp_http_client_handle_t client,
+		const char *key, const char *value) {
+
+	if (!client || !key || !value)
+		return ESP_ERR_INVALID_ARG;
+
+	unsigned long start;
+	if (strcasecmp(key, "Range") == 0
+			&& sscanf(value, "bytes=%lu-", &start) == 1)
+		client->range_start = start;
+	else if (strcasecmp(key, "If-Range") == 0)
+		snprintf(client->if_range, sizeof(client->if_range), "%s", value);
+	return ESP_OK;
+
+}
+
+esp_err_t esp_http_client_open(esp_http_client_handle_t client, int write_len) {
+
+	if (!client)
+		return ESP_ERR_INVALID_ARG;
+
+	pthread_mutex_lock(&_gn_sim_http_mutex);
+	client->status = 404;
+	client->data = NULL;
+	client->len = 0;
+	client->pos = 0;
+	client->etag[0] = '\0';
+	for (int i = 0; i < _GN_SIM_HTTP_MAX_RESOURCES; i++) {
+		if (_gn_sim_http_resources[i].data
+				&& strcmp(_gn_sim_http_resources[i].url, client->url) == 0) {
+			client->status = 200;
+			client->data = _gn_sim_http_resources[i].data;
+			client->len = _gn_sim_http_resources[i].len;
+			strcpy(client->etag, _gn_sim_http_resources[i].etag);
+		}
+	}
+	//a range of another version of the resource is answered with the whole body
+	if (client->status == 200 && client->range_start && _gn_sim_http_ranges
+			&& (!client->if_range[0]
+					|| strcmp(client->if_range, client->etag) == 0)) {
+		if (client->range_start < client->len) {
+			client->status = 206;
+			client->data += client->range_start;
+			client->len -= client->range_start;
+		} else {
+			client->status = 416;
+			client->len = 0;
+		}
+	}
+	client->drop_at = 0;
+	if (client->status / 100 == 2 && _gn_sim_http_drop_connections > 0) {
+		_gn_sim_http_drop_connections--;
+		client->drop_at = _gn_sim_http_drop_after;
+	}
+	client->open = true;
+	pthread_mutex_unlock(&_gn_sim_http_mutex);
+	return ESP_OK;
+
+}
+
+int esp_http_client_fetch_headers(esp_http_client_handle_t client) {
+
+	if (!client || !client->open)
+		return ESP_FAIL;
+
+	if (client->event_handler && client->etag[0]) {
+		esp_http_client_event_t evt = { .event_id = HTTP_EVENT_ON_HEADER,
+				.client = client, .user_data = client->user_data, .header_key =
+						"ETag", .header_value = client->etag };
+		client->event_handler(&evt);
+	}
+	return (int) client->len;
+
+}
+
+int esp_http_client_get_status_code(esp_http_client_handle_t client) {
+	return client && client->open ? client->status : 0;
+}
+
+int esp_http_client_read(esp_http_client_handle_t client, char *buffer, int len) {
+
+	if (!client || !client->open || !buffer || len < 0)
+		return ESP_FAIL;
+
+	if (client->drop_at && client->pos >= client->drop_at) {
+		ESP_LOGW(TAG, "connection to %s dropped after %u bytes", client->url,
+				(unsigned) client->pos);
+		client->open = false;
+		return ESP_FAIL;
+	}
+
+	size_t n = client->len - client->pos;
+	if (n > (size_t) len)
+		n = len;
+	if (client->drop_at && n > client->drop_at - client->pos)
+		n = client->drop_at - client->pos;
+	memcpy(buffer, client->data + client->pos, n);
+	client->pos += n;
+
+	pthread_mutex_lock(&_gn_sim_http_mutex);
+	_gn_sim_http_served_bytes += n;
+	pthread_mutex_unlock(&_gn_sim_http_mutex);
+	return (int) n;
+
+}
+
+bool esp_http_client_is_complete_data_received(esp_http_client_handle_t client) {
+	return client && client->open && client->pos == client->len;
+}
+
+esp_err_t esp_http_client_close(esp_http_client_handle_t client) {
+	if (!client)
+		return ESP_ERR_INVALID_ARG;
+	client->open = false;
+	return ESP_OK;
+}
+
+esp_err_t esp_http_client_cleanup(esp_http_client_handle_t client) {
+	free(client);
+	return ESP_OK;
+}
@@ -0,0 +1,52 @@
+// Copyright 2021 Nicola Muratori (nicola.muratori@gmail.com)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GN_SIM_INTL_H_
+#define GN_SIM_INTL_H_
+
+#include <stdbool.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "freertos/FreeRTOS.h"
+
+/**
+ * @brief	marks the calling task as blocked (or running again), as seen by eTaskGetState()
+ */
+void _gn_sim_task_set_blocked(bool blocked);
+
+/**
+ * @brief	absolute CLOCK_MONOTONIC deadline, ticks from now
+ */
+void _gn_sim_deadline(struct timespec *ts, TickType_t ticks);
+
+/**
+ * @brief	initializes a condition variable waiting on CLOCK_MONOTONIC
+ */
+void _gn_sim_cond_init(pthread_cond_t *cond);
+
+/**
+ * @brief	waits on the condition until the deadline. portMAX_DELAY waits forever
+ *
+ * @return	false on timeout
+ */
+bool _gn_sim_cond_wait(pthread_cond_t *cond, pthread_mutex_t *mutex,
+		TickType_t ticks, const struct timespec *deadline);
+
+/**
+ * @brief	samples the heap usage to keep track of the peak
+ */
+void _gn_sim_heap_sample(void);
+
+#endif /* GN_SIM_INTL_H_ */
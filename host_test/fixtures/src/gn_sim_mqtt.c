@@ -0,0 +1,988 @@
+// Copyright 2021 Nicola Muratori (nicola.muratori@gmail.com)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * loopback MQTT broker and esp-mqtt client. topics are matched with the MQTT 3.1.1 rules, retained
+ * messages are replayed on subscribe and sessions opened with disable_clean_session survive a
+ * disconnection, queueing QoS 1 and 2 messages until the client is back.
+ *
+ * every client has an unbounded inbox drained by its own task, so a handler that publishes
+ * never waits on its own queue. acknowledges take at least a simulated round trip, so the caller
+ * has stored the message id before they arrive, as it happens with a real network
+ */
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "mqtt_client.h"
+
+#include "gn_sim.h"
+#include "gn_sim_intl.h"
+
+#define TAG "gn_sim_mqtt"
+
+#define _GN_SIM_MQTT_MAX_HANDLERS 8
+
+//internal commands, run by the client task
+#define _GN_SIM_MQTT_CMD_CONNECT 100
+#define _GN_SIM_MQTT_CMD_QUIT 101
+
+//minimum time for an acknowledge to come back from the broker
+#define _GN_SIM_MQTT_ACK_DELAY_US 1000
+
+ESP_EVENT_DEFINE_BASE(MQTT_EVENTS);
+
+typedef struct gn_sim_mqtt_item {
+	int kind;
+	char *topic;
+	int topic_len;
+	char *data;
+	int data_len;
+	int msg_id;
+	int qos;
+	bool retain;
+	int session_present;
+	int64_t deliver_at;
+	struct gn_sim_mqtt_item *next;
+} gn_sim_mqtt_item_t;
+
+typedef struct gn_sim_mqtt_sub {
+	char *filter;
+	int qos;
+	struct gn_sim_mqtt_sub *next;
+} gn_sim_mqtt_sub_t;
+
+typedef struct gn_sim_mqtt_session {
+	char *client_id;
+	bool persistent;
+	gn_sim_mqtt_sub_t *subs;
+	gn_sim_mqtt_item_t *pending;
+	struct esp_mqtt_client *client;
+	struct gn_sim_mqtt_session *next;
+} gn_sim_mqtt_session_t;
+
+typedef struct gn_sim_mqtt_retained {
+	char *topic;
+	char *data;
+	int data_len;
+	struct gn_sim_mqtt_retained *next;
+} gn_sim_mqtt_retained_t;
+
+typedef struct gn_sim_mqtt_observer {
+	int id;
+	char *filter;
+	gn_sim_broker_cb_t cb;
+	void *arg;
+	struct gn_sim_mqtt_observer *next;
+} gn_sim_mqtt_observer_t;
+
+struct esp_mqtt_client {
+	char *client_id;
+	bool clean_session;
+	void *user_context;
+	mqtt_event_callback_t event_handle;
+
+	struct {
+		esp_mqtt_event_id_t id;
+		esp_event_handler_t fn;
+		void *arg;
+	} handlers[_GN_SIM_MQTT_MAX_HANDLERS];
+	int handlers_count;
+
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+	gn_sim_mqtt_item_t *head, *tail;
+
+	TaskHandle_t task;
+	int msg_id;
+
+	//protected by the broker mutex
+	bool connected;
+	gn_sim_mqtt_session_t *session;
+	gn_sim_mqtt_item_t *outbox;
+	int outbox_size;
+};
+
+static pthread_mutex_t _gn_sim_broker_mutex = PTHREAD_MUTEX_INITIALIZER;
+static gn_sim_mqtt_session_t *_gn_sim_broker_sessions = NULL;
+static gn_sim_mqtt_retained_t *_gn_sim_broker_retained = NULL;
+static gn_sim_mqtt_observer_t *_gn_sim_broker_observers = NULL;
+static int _gn_sim_broker_observer_id = 0;
+static gn_sim_broker_stats_t _gn_sim_broker_stats;
+static uint32_t _gn_sim_broker_latency_us = 0;
+static bool _gn_sim_broker_deny_wildcards = false;
+static int _gn_sim_broker_anonymous_id = 0;
+
+static esp_mqtt_error_codes_t _gn_sim_mqtt_no_error;
+
+//topics
+
+bool gn_sim_broker_topic_matches(const char *filter, const char *topic) {
+
+	//wildcards at the first level do not match system topics
+	if (topic[0] == '$' && (filter[0] == '+' || filter[0] == '#'))
+		return false;
+
+	while (*filter) {
+
+		if (filter[0] == '#')
+			return true;
+
+		if (filter[0] == '+') {
+			while (*topic && *topic != '/')
+				topic++;
+			filter++;
+		} else {
+			while (*filter && *filter != '/' && *filter == *topic) {
+				filter++;
+				topic++;
+			}
+			if (*filter != '/' && *filter != '\0')
+				return false;
+			if (*topic != '/' && *topic != '\0')
+				return false;
+		}
+
+		if (*filter == '\0')
+			return *topic == '\0';
+
+		//filter is on a separator
+		if (*topic == '\0')
+			//"a/#" matches "a" too
+			return strcmp(filter, "/#") == 0;
+		if (*topic != '/')
+			return false;
+		filter++;
+		topic++;
+
+	}
+
+	return *topic == '\0';
+
+}
+
+static bool _gn_sim_mqtt_has_wildcards(const char *filter) {
+	return strchr(filter, '+') || strchr(filter, '#');
+}
+
+//items
+
+static gn_sim_mqtt_item_t* _gn_sim_mqtt_item_create(int kind,
+		const char *topic, int topic_len, const char *data, int data_len) {
+
+	gn_sim_mqtt_item_t *item = calloc(1, sizeof(gn_sim_mqtt_item_t));
+	if (!item)
+		return NULL;
+
+	item->kind = kind;
+	if (topic) {
+		item->topic = malloc(topic_len + 1);
+		memcpy(item->topic, topic, topic_len);
+		item->topic[topic_len] = '\0';
+		item->topic_len = topic_len;
+	}
+	if (data) {
+		item->data = malloc(data_len + 1);
+		memcpy(item->data, data, data_len);
+		item->data[data_len] = '\0';
+		item->data_len = data_len;
+	}
+	item->deliver_at = esp_timer_get_time() + _gn_sim_broker_latency_us;
+	return item;
+
+}
+
+static void _gn_sim_mqtt_item_free(gn_sim_mqtt_item_t *item) {
+	free(item->topic);
+	free(item->data);
+	free(item);
+}
+
+static void _gn_sim_mqtt_items_free(gn_sim_mqtt_item_t *items) {
+	while (items) {
+		gn_sim_mqtt_item_t *next = items->next;
+		_gn_sim_mqtt_item_free(items);
+		items = next;
+	}
+}
+
+static void _gn_sim_mqtt_inbox_push(esp_mqtt_client_handle_t client,
+		gn_sim_mqtt_item_t *item) {
+
+	if (!item)
+		return;
+
+	pthread_mutex_lock(&client->mutex);
+	item->next = NULL;
+	if (client->tail)
+		client->tail->next = item;
+	else
+		client->head = item;
+	client->tail = item;
+	pthread_cond_signal(&client->cond);
+	pthread_mutex_unlock(&client->mutex);
+
+}
+
+static void _gn_sim_mqtt_post(esp_mqtt_client_handle_t client, int kind,
+		int msg_id) {
+
+	gn_sim_mqtt_item_t *item = _gn_sim_mqtt_item_create(kind, NULL, 0, NULL,
+			0);
+	if (item) {
+		item->msg_id = msg_id;
+		_gn_sim_mqtt_inbox_push(client, item);
+	}
+
+}
+
+static void _gn_sim_mqtt_ack(esp_mqtt_client_handle_t client, int kind,
+		int msg_id, uint8_t rc) {
+
+	gn_sim_mqtt_item_t *item = _gn_sim_mqtt_item_create(kind, NULL, 0,
+			kind == MQTT_EVENT_SUBSCRIBED ? (const char*) &rc : NULL, 1);
+	if (item) {
+		item->msg_id = msg_id;
+		item->deliver_at += _GN_SIM_MQTT_ACK_DELAY_US;
+		_gn_sim_mqtt_inbox_push(client, item);
+	}
+
+}
+
+static int _gn_sim_mqtt_next_msg_id(esp_mqtt_client_handle_t client) {
+
+	int id = __atomic_add_fetch(&client->msg_id, 1, __ATOMIC_RELAXED);
+	return (id % 65535) + 1;
+
+}
+
+//broker, called with the broker mutex held
+
+static void _gn_sim_broker_sessions_free(gn_sim_mqtt_session_t *s) {
+
+	while (s->subs) {
+		gn_sim_mqtt_sub_t *next = s->subs->next;
+		free(s->subs->filter);
+		free(s->subs);
+		s->subs = next;
+	}
+	_gn_sim_mqtt_items_free(s->pending);
+	free(s->client_id);
+	free(s);
+
+}
+
+static void _gn_sim_broker_session_remove(gn_sim_mqtt_session_t *session) {
+
+	for (gn_sim_mqtt_session_t **s = &_gn_sim_broker_sessions; *s;
+			s = &(*s)->next) {
+		if (*s == session) {
+			*s = session->next;
+			_gn_sim_broker_sessions_free(session);
+			return;
+		}
+	}
+
+}
+
+static void _gn_sim_broker_retain(const char *topic, const char *data,
+		int len) {
+
+	gn_sim_mqtt_retained_t **r = &_gn_sim_broker_retained;
+	while (*r && strcmp((*r)->topic, topic) != 0)
+		r = &(*r)->next;
+
+	//an empty retained message clears the topic
+	if (len == 0) {
+		if (*r) {
+			gn_sim_mqtt_retained_t *cleared = *r;
+			*r = cleared->next;
+			free(cleared->topic);
+			free(cleared->data);
+			free(cleared);
+			_gn_sim_broker_stats.retained--;
+		}
+		return;
+	}
+
+	if (!*r) {
+		*r = calloc(1, sizeof(gn_sim_mqtt_retained_t));
+		(*r)->topic = strdup(topic);
+		_gn_sim_broker_stats.retained++;
+	}
+	free((*r)->data);
+	(*r)->data = malloc(len);
+	memcpy((*r)->data, data, len);
+	(*r)->data_len = len;
+
+}
+
+static void _gn_sim_broker_route(const char *topic, const char *data, int len,
+		int qos, bool retain) {
+
+	_gn_sim_broker_stats.published++;
+	_gn_sim_broker_stats.bytes += len;
+
+	if (retain)
+		_gn_sim_broker_retain(topic, data, len);
+
+	int topic_len = strlen(topic);
+
+	for (gn_sim_mqtt_session_t *s = _gn_sim_broker_sessions; s; s = s->next) {
+
+		//overlapping filters deliver the message once, at the highest granted qos
+		int granted = -1;
+		for (gn_sim_mqtt_sub_t *sub = s->subs; sub; sub = sub->next)
+			if (sub->qos > granted
+					&& gn_sim_broker_topic_matches(sub->filter, topic))
+				granted = sub->qos;
+		if (granted < 0)
+			continue;
+
+		gn_sim_mqtt_item_t *item = _gn_sim_mqtt_item_create(MQTT_EVENT_DATA,
+				topic, topic_len, data, len);
+		if (!item)
+			continue;
+		item->qos = qos < granted ? qos : granted;
+
+		if (s->client && s->client->connected) {
+			_gn_sim_broker_stats.delivered++;
+			_gn_sim_mqtt_inbox_push(s->client, item);
+		} else if (s->persistent && item->qos > 0) {
+			gn_sim_mqtt_item_t **last = &s->pending;
+			while (*last)
+				last = &(*last)->next;
+			*last = item;
+		} else
+			_gn_sim_mqtt_item_free(item);
+
+	}
+
+}
+
+//observers are called without the broker mutex, they can publish
+static void _gn_sim_broker_notify(const char *topic, const char *data, int len) {
+
+	gn_sim_mqtt_observer_t snapshot[16];
+	int count = 0;
+
+	pthread_mutex_lock(&_gn_sim_broker_mutex);
+	for (gn_sim_mqtt_observer_t *o = _gn_sim_broker_observers;
+			o && count < (int) (sizeof(snapshot) / sizeof(snapshot[0]));
+			o = o->next)
+		if (gn_sim_broker_topic_matches(o->filter, topic))
+			snapshot[count++] = *o;
+	_gn_sim_broker_stats.delivered += count;
+	pthread_mutex_unlock(&_gn_sim_broker_mutex);
+
+	for (int i = 0; i < count; i++)
+		snapshot[i].cb(topic, data, len, snapshot[i].arg);
+
+}
+
+static void _gn_sim_broker_publish(const char *topic, const char *data,
+		int len, int qos, bool retain) {
+
+	pthread_mutex_lock(&_gn_sim_broker_mutex);
+	_gn_sim_broker_route(topic, data, len, qos, retain);
+	pthread_mutex_unlock(&_gn_sim_broker_mutex);
+
+	_gn_sim_broker_notify(topic, data, len);
+
+}
+
+static bool _gn_sim_broker_disconnect(esp_mqtt_client_handle_t client) {
+
+	if (!client->connected)
+		return false;
+
+	client->connected = false;
+	_gn_sim_broker_stats.clients--;
+
+	gn_sim_mqtt_session_t *s = client->session;
+	client->session = NULL;
+	if (s) {
+		s->client = NULL;
+		if (!s->persistent)
+			_gn_sim_broker_session_remove(s);
+	}
+	return true;
+
+}
+
+static int _gn_sim_broker_connect(esp_mqtt_client_handle_t client) {
+
+	gn_sim_mqtt_session_t *s = _gn_sim_broker_sessions;
+	while (s && strcmp(s->client_id, client->client_id) != 0)
+		s = s->next;
+
+	//a client connecting with the same id takes the session over
+	if (s && s->client && s->client != client) {
+		esp_mqtt_client_handle_t old = s->client;
+		_gn_sim_broker_disconnect(old);
+		_gn_sim_mqtt_post(old, MQTT_EVENT_DISCONNECTED, 0);
+		s = _gn_sim_broker_sessions;
+		while (s && strcmp(s->client_id, client->client_id) != 0)
+			s = s->next;
+	}
+
+	if (s && client->clean_session) {
+		_gn_sim_broker_session_remove(s);
+		s = NULL;
+	}
+
+	int session_present = s != NULL;
+	if (!s) {
+		s = calloc(1, sizeof(gn_sim_mqtt_session_t));
+		s->client_id = strdup(client->client_id);
+		s->next = _gn_sim_broker_sessions;
+		_gn_sim_broker_sessions = s;
+	}
+	s->persistent = !client->clean_session;
+	s->client = client;
+
+	client->session = s;
+	client->connected = true;
+	_gn_sim_broker_stats.clients++;
+
+	return session_present;
+
+}
+
+//client task
+
+static void _gn_sim_mqtt_dispatch(esp_mqtt_client_handle_t client,
+		gn_sim_mqtt_item_t *item) {
+
+	esp_mqtt_event_t event = { .event_id = (esp_mqtt_event_id_t) item->kind,
+			.client = client, .user_context = client->user_context, .data =
+					item->data, .data_len = item->data_len, .total_data_len =
+					item->data_len, .current_data_offset = 0, .topic =
+					item->topic, .topic_len = item->topic_len, .msg_id =
+					item->msg_id, .session_present = item->session_present,
+			.error_handle = &_gn_sim_mqtt_no_error, .retain = item->retain,
+			.qos = item->qos, .dup = false };
+
+	if (client->event_handle)
+		client->event_handle(&event);
+
+	int count = __atomic_load_n(&client->handlers_count, __ATOMIC_ACQUIRE);
+	for (int i = 0; i < count; i++) {
+		if (client->handlers[i].id == MQTT_EVENT_ANY
+				|| client->handlers[i].id == (esp_mqtt_event_id_t) item->kind)
+			client->handlers[i].fn(client->handlers[i].arg, MQTT_EVENTS,
+					item->kind, &event);
+	}
+
+}
+
+static void _gn_sim_mqtt_run_connect(esp_mqtt_client_handle_t client) {
+
+	gn_sim_mqtt_item_t before = { .kind = MQTT_EVENT_BEFORE_CONNECT };
+	_gn_sim_mqtt_dispatch(client, &before);
+
+	if (_gn_sim_broker_latency_us)
+		usleep(_gn_sim_broker_latency_us);
+
+	pthread_mutex_lock(&_gn_sim_broker_mutex);
+	gn_sim_mqtt_item_t connected = { .kind = MQTT_EVENT_CONNECTED,
+			.session_present = _gn_sim_broker_connect(client) };
+	pthread_mutex_unlock(&_gn_sim_broker_mutex);
+
+	_gn_sim_mqtt_dispatch(client, &connected);
+
+	//messages queued by the session while offline, then the ones the client stored
+	pthread_mutex_lock(&_gn_sim_broker_mutex);
+	gn_sim_mqtt_item_t *pending = NULL;
+	if (client->session) {
+		pending = client->session->pending;
+		client->session->pending = NULL;
+	}
+	gn_sim_mqtt_item_t *outbox = client->outbox;
+	client->outbox = NULL;
+	client->outbox_size = 0;
+	pthread_mutex_unlock(&_gn_sim_broker_mutex);
+
+	while (pending) {
+		gn_sim_mqtt_item_t *next = pending->next;
+		pending->deliver_at = 0;
+		_gn_sim_mqtt_inbox_push(client, pending);
+		pending = next;
+	}
+
+	while (outbox) {
+		gn_sim_mqtt_item_t *next = outbox->next;
+		_gn_sim_broker_publish(outbox->topic, outbox->data, outbox->data_len,
+				outbox->qos, outbox->retain);
+		if (outbox->qos > 0)
+			_gn_sim_mqtt_ack(client, MQTT_EVENT_PUBLISHED, outbox->msg_id, 0);
+		_gn_sim_mqtt_item_free(outbox);
+		outbox = next;
+	}
+
+}
+
+static void _gn_sim_mqtt_task(void *arg) {
+
+	esp_mqtt_client_handle_t client = (esp_mqtt_client_handle_t) arg;
+
+	while (true) {
+
+		pthread_mutex_lock(&client->mutex);
+		while (!client->head)
+			_gn_sim_cond_wait(&client->cond, &client->mutex, portMAX_DELAY,
+					NULL);
+		gn_sim_mqtt_item_t *item = client->head;
+		client->head = item->next;
+		if (!client->head)
+			client->tail = NULL;
+		pthread_mutex_unlock(&client->mutex);
+
+		if (item->kind == _GN_SIM_MQTT_CMD_QUIT) {
+			_gn_sim_mqtt_item_free(item);
+			break;
+		}
+
+		if (item->kind == _GN_SIM_MQTT_CMD_CONNECT) {
+			_gn_sim_mqtt_run_connect(client);
+			_gn_sim_mqtt_item_free(item);
+			continue;
+		}
+
+		int64_t wait_us = item->deliver_at - esp_timer_get_time();
+		if (wait_us > 0) {
+			_gn_sim_task_set_blocked(true);
+			usleep(wait_us);
+			_gn_sim_task_set_blocked(false);
+		}
+
+		_gn_sim_mqtt_dispatch(client, item);
+		_gn_sim_mqtt_item_free(item);
+		_gn_sim_heap_sample();
+
+	}
+
+	//the destroying side left the client to this task
+	_gn_sim_mqtt_items_free(client->head);
+	_gn_sim_mqtt_items_free(client->outbox);
+	pthread_mutex_destroy(&client->mutex);
+	pthread_cond_destroy(&client->cond);
+	free(client->client_id);
+	free(client);
+
+}
+
+//esp-mqtt API
+
+esp_mqtt_client_handle_t esp_mqtt_client_init(
+		const esp_mqtt_client_config_t *config) {
+
+	if (!config)
+		return NULL;
+
+	esp_mqtt_client_handle_t client = calloc(1, sizeof(struct esp_mqtt_client));
+	if (!client)
+		return NULL;
+
+	if (config->client_id)
+		client->client_id = strdup(config->client_id);
+	else {
+		char id[24];
+		snprintf(id, sizeof(id), "ESP32_sim%d",
+				__atomic_add_fetch(&_gn_sim_broker_anonymous_id, 1,
+						__ATOMIC_RELAXED));
+		client->client_id = strdup(id);
+	}
+	client->clean_session = !config->disable_clean_session;
+	client->user_context = config->user_context;
+	client->event_handle = config->event_handle;
+
+	pthread_mutex_init(&client->mutex, NULL);
+	_gn_sim_cond_init(&client->cond);
+
+	return client;
+
+}
+
+esp_err_t esp_mqtt_client_register_event(esp_mqtt_client_handle_t client,
+		esp_mqtt_event_id_t event, esp_event_handler_t event_handler,
+		void *event_handler_arg) {
+
+	if (!client || !event_handler)
+		return ESP_ERR_INVALID_ARG;
+
+	pthread_mutex_lock(&client->mutex);
+	if (client->handlers_count == _GN_SIM_MQTT_MAX_HANDLERS) {
+		pthread_mutex_unlock(&client->mutex);
+		return ESP_ERR_NO_MEM;
+	}
+	int i = client->handlers_count;
+	client->handlers[i].id = event;
+	client->handlers[i].fn = event_handler;
+	client->handlers[i].arg = event_handler_arg;
+	__atomic_store_n(&client->handlers_count, i + 1, __ATOMIC_RELEASE);
+	pthread_mutex_unlock(&client->mutex);
+
+	return ESP_OK;
+
+}
+
+esp_err_t esp_mqtt_client_start(esp_mqtt_client_handle_t client) {
+
+	if (!client)
+		return ESP_ERR_INVALID_ARG;
+	if (client->task)
+		return ESP_FAIL;
+
+	if (xTaskCreate(_gn_sim_mqtt_task, "mqtt_task", 6144, client, 5,
+			&client->task) != pdPASS)
+		return ESP_FAIL;
+
+	_gn_sim_mqtt_post(client, _GN_SIM_MQTT_CMD_CONNECT, 0);
+	return ESP_OK;
+
+}
+
+esp_err_t esp_mqtt_client_reconnect(esp_mqtt_client_handle_t client) {
+
+	if (!client || !client->task)
+		return ESP_ERR_INVALID_ARG;
+
+	pthread_mutex_lock(&_gn_sim_broker_mutex);
+	bool connected = client->connected;
+	pthread_mutex_unlock(&_gn_sim_broker_mutex);
+	if (connected)
+		return ESP_FAIL;
+
+	_gn_sim_mqtt_post(client, _GN_SIM_MQTT_CMD_CONNECT, 0);
+	return ESP_OK;
+
+}
+
+esp_err_t esp_mqtt_client_disconnect(esp_mqtt_client_handle_t client) {
+
+	if (!client)
+		return ESP_ERR_INVALID_ARG;
+
+	pthread_mutex_lock(&_gn_sim_broker_mutex);
+	bool was_connected = _gn_sim_broker_disconnect(client);
+	pthread_mutex_unlock(&_gn_sim_broker_mutex);
+
+	if (was_connected)
+		_gn_sim_mqtt_post(client, MQTT_EVENT_DISCONNECTED, 0);
+	return ESP_OK;
+
+}
+
+esp_err_t esp_mqtt_client_stop(esp_mqtt_client_handle_t client) {
+
+	if (!client)
+		return ESP_ERR_INVALID_ARG;
+
+	pthread_mutex_lock(&_gn_sim_broker_mutex);
+	_gn_sim_broker_disconnect(client);
+	pthread_mutex_unlock(&_gn_sim_broker_mutex);
+
+	//as esp-mqtt, fails only if the client was never started
+	return client->task ? ESP_OK : ESP_FAIL;
+
+}
+
+esp_err_t esp_mqtt_client_destroy(esp_mqtt_client_handle_t client) {
+
+	if (!client)
+		return ESP_ERR_INVALID_ARG;
+
+	esp_mqtt_client_stop(client);
+
+	if (!client->task) {
+		pthread_mutex_destroy(&client->mutex);
+		pthread_cond_destroy(&client->cond);
+		free(client->client_id);
+		free(client);
+		return ESP_OK;
+	}
+
+	_gn_sim_mqtt_post(client, _GN_SIM_MQTT_CMD_QUIT, 0);
+	return ESP_OK;
+
+}
+
+int esp_mqtt_client_subscribe(esp_mqtt_client_handle_t client,
+		const char *topic, int qos) {
+
+	if (!client || !topic)
+		return -1;
+
+	pthread_mutex_lock(&_gn_sim_broker_mutex);
+
+	if (!client->connected || !client->session) {
+		pthread_mutex_unlock(&_gn_sim_broker_mutex);
+		return -1;
+	}
+
+	int msg_id = _gn_sim_mqtt_next_msg_id(client);
+	uint8_t rc = qos > 2 ? 2 : qos;
+
+	if (_gn_sim_broker_deny_wildcards && _gn_sim_mqtt_has_wildcards(topic)) {
+		rc = 0x80;
+		_gn_sim_broker_stats.refused++;
+	} else {
+		gn_sim_mqtt_sub_t *sub = client->session->subs;
+		while (sub && strcmp(sub->filter, topic) != 0)
+			sub = sub->next;
+		if (!sub) {
+			sub = calloc(1, sizeof(gn_sim_mqtt_sub_t));
+			sub->filter = strdup(topic);
+			sub->next = client->session->subs;
+			client->session->subs = sub;
+		}
+		sub->qos = rc;
+		_gn_sim_broker_stats.subscribed++;
+	}
+
+	_gn_sim_mqtt_ack(client, MQTT_EVENT_SUBSCRIBED, msg_id, rc);
+
+	if (rc != 0x80) {
+		for (gn_sim_mqtt_retained_t *r = _gn_sim_broker_retained; r;
+				r = r->next) {
+			if (!gn_sim_broker_topic_matches(topic, r->topic))
+				continue;
+			gn_sim_mqtt_item_t *item = _gn_sim_mqtt_item_create(
+					MQTT_EVENT_DATA, r->topic, strlen(r->topic), r->data,
+					r->data_len);
+			if (!item)
+				continue;
+			item->retain = true;
+			item->qos = rc;
+			_gn_sim_broker_stats.delivered++;
+			_gn_sim_mqtt_inbox_push(client, item);
+		}
+	}
+
+	pthread_mutex_unlock(&_gn_sim_broker_mutex);
+	return msg_id;
+
+}
+
+int esp_mqtt_client_unsubscribe(esp_mqtt_client_handle_t client,
+		const char *topic) {
+
+	if (!client || !topic)
+		return -1;
+
+	pthread_mutex_lock(&_gn_sim_broker_mutex);
+
+	if (!client->connected || !client->session) {
+		pthread_mutex_unlock(&_gn_sim_broker_mutex);
+		return -1;
+	}
+
+	for (gn_sim_mqtt_sub_t **sub = &client->session->subs; *sub;
+			sub = &(*sub)->next) {
+		if (strcmp((*sub)->filter, topic) == 0) {
+			gn_sim_mqtt_sub_t *removed = *sub;
+			*sub = removed->next;
+			free(removed->filter);
+			free(removed);
+			break;
+		}
+	}
+
+	int msg_id = _gn_sim_mqtt_next_msg_id(client);
+	pthread_mutex_unlock(&_gn_sim_broker_mutex);
+
+	_gn_sim_mqtt_ack(client, MQTT_EVENT_UNSUBSCRIBED, msg_id, 0);
+	return msg_id;
+
+}
+
+int esp_mqtt_client_enqueue(esp_mqtt_client_handle_t client, const char *topic,
+		const char *data, int len, int qos, int retain, bool store) {
+
+	if (!client || !topic)
+		return -1;
+
+	if (len <= 0)
+		len = data ? strlen(data) : 0;
+
+	int msg_id = qos > 0 ? _gn_sim_mqtt_next_msg_id(client) : 0;
+
+	pthread_mutex_lock(&_gn_sim_broker_mutex);
+
+	if (!client->connected) {
+		//kept in the outbox and sent on connection, as esp-mqtt does with stored messages
+		if (qos == 0 && !store) {
+			pthread_mutex_unlock(&_gn_sim_broker_mutex);
+			return -1;
+		}
+		gn_sim_mqtt_item_t *item = _gn_sim_mqtt_item_create(MQTT_EVENT_DATA,
+				topic, strlen(topic), data ? data : "", len);
+		if (!item) {
+			pthread_mutex_unlock(&_gn_sim_broker_mutex);
+			return -1;
+		}
+		item->msg_id = msg_id;
+		item->qos = qos;
+		item->retain = retain;
+		gn_sim_mqtt_item_t **last = &client->outbox;
+		while (*last)
+			last = &(*last)->next;
+		*last = item;
+		client->outbox_size += item->topic_len + len;
+		pthread_mutex_unlock(&_gn_sim_broker_mutex);
+		return msg_id;
+	}
+
+	_gn_sim_broker_route(topic, data ? data : "", len, qos, retain);
+	pthread_mutex_unlock(&_gn_sim_broker_mutex);
+
+	_gn_sim_broker_notify(topic, data ? data : "", len);
+
+	if (qos > 0)
+		_gn_sim_mqtt_ack(client, MQTT_EVENT_PUBLISHED, msg_id, 0);
+
+	return msg_id;
+
+}
+
+int esp_mqtt_client_publish(esp_mqtt_client_handle_t client, const char *topic,
+		const char *data, int len, int qos, int retain) {
+	return esp_mqtt_client_enqueue(client, topic, data, len, qos, retain,
+			false);
+}
+
+int esp_mqtt_client_get_outbox_size(esp_mqtt_client_handle_t client) {
+
+	if (!client)
+		return 0;
+	pthread_mutex_lock(&_gn_sim_broker_mutex);
+	int ret = client->outbox_size;
+	pthread_mutex_unlock(&_gn_sim_broker_mutex);
+	return ret;
+
+}
+
+//control interface
+
+int gn_sim_broker_subscribe(const char *filter, gn_sim_broker_cb_t cb,
+		void *arg) {
+
+	if (!filter || !cb)
+		return -1;
+
+	gn_sim_mqtt_observer_t *o = calloc(1, sizeof(gn_sim_mqtt_observer_t));
+	if (!o)
+		return -1;
+	o->filter = strdup(filter);
+	o->cb = cb;
+	o->arg = arg;
+
+	pthread_mutex_lock(&_gn_sim_broker_mutex);
+	o->id = ++_gn_sim_broker_observer_id;
+	o->next = _gn_sim_broker_observers;
+	_gn_sim_broker_observers = o;
+	pthread_mutex_unlock(&_gn_sim_broker_mutex);
+
+	return o->id;
+
+}
+
+void gn_sim_broker_unsubscribe(int subscription) {
+
+	pthread_mutex_lock(&_gn_sim_broker_mutex);
+	for (gn_sim_mqtt_observer_t **o = &_gn_sim_broker_observers; *o;
+			o = &(*o)->next) {
+		if ((*o)->id == subscription) {
+			gn_sim_mqtt_observer_t *removed = *o;
+			*o = removed->next;
+			free(removed->filter);
+			free(removed);
+			break;
+		}
+	}
+	pthread_mutex_unlock(&_gn_sim_broker_mutex);
+
+}
+
+int gn_sim_broker_publish(const char *topic, const char *data, int len,
+		int qos, bool retain) {
+
+	if (!topic || _gn_sim_mqtt_has_wildcards(topic))
+		return -1;
+	if (len <= 0)
+		len = data ? strlen(data) : 0;
+
+	_gn_sim_broker_publish(topic, data ? data : "", len, qos, retain);
+	return 0;
+
+}
+
+int gn_sim_broker_get_retained(const char *topic, char *buf, size_t size) {
+
+	int ret = -1;
+
+	pthread_mutex_lock(&_gn_sim_broker_mutex);
+	for (gn_sim_mqtt_retained_t *r = _gn_sim_broker_retained; r; r = r->next) {
+		if (strcmp(r->topic, topic) == 0) {
+			ret = r->data_len;
+			if (buf && size > 0) {
+				size_t n = (size_t) r->data_len < size - 1 ?
+						(size_t) r->data_len : size - 1;
+				memcpy(buf, r->data, n);
+				buf[n] = '\0';
+			}
+			break;
+		}
+	}
+	pthread_mutex_unlock(&_gn_sim_broker_mutex);
+
+	return ret;
+
+}
+
+void gn_sim_broker_get_stats(gn_sim_broker_stats_t *stats) {
+
+	pthread_mutex_lock(&_gn_sim_broker_mutex);
+	*stats = _gn_sim_broker_stats;
+	pthread_mutex_unlock(&_gn_sim_broker_mutex);
+
+}
+
+void gn_sim_broker_reset_stats(void) {
+
+	pthread_mutex_lock(&_gn_sim_broker_mutex);
+	uint32_t retained = _gn_sim_broker_stats.retained;
+	uint32_t clients = _gn_sim_broker_stats.clients;
+	memset(&_gn_sim_broker_stats, 0, sizeof(_gn_sim_broker_stats));
+	_gn_sim_broker_stats.retained = retained;
+	_gn_sim_broker_stats.clients = clients;
+	pthread_mutex_unlock(&_gn_sim_broker_mutex);
+
+}
+
+void gn_sim_broker_set_latency_us(uint32_t latency_us) {
+	_gn_sim_broker_latency_us = latency_us;
+}
+
+void gn_sim_broker_set_deny_wildcards(bool deny) {
+	_gn_sim_broker_deny_wildcards = deny;
+}
@@ -0,0 +1,328 @@
+// Copyright 2021 Nicola Muratori (nicola.muratori@gmail.com)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * in memory NVS. values are written through, nvs_commit() has nothing left to do
+ */
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_log.h"
+#include "nvs.h"
+#include "nvs_flash.h"
+
+#define TAG "gn_sim_nvs"
+
+#define _GN_SIM_NVS_MAX_HANDLES 32
+
+typedef enum {
+	_GN_SIM_NVS_TYPE_U8,
+	_GN_SIM_NVS_TYPE_I32,
+	_GN_SIM_NVS_TYPE_U32,
+	_GN_SIM_NVS_TYPE_I64,
+	_GN_SIM_NVS_TYPE_STR,
+	_GN_SIM_NVS_TYPE_BLOB
+} gn_sim_nvs_type_t;
+
+typedef struct gn_sim_nvs_entry {
+	char ns[NVS_NS_NAME_MAX_SIZE];
+	char key[NVS_KEY_NAME_MAX_SIZE];
+	gn_sim_nvs_type_t type;
+	void *data;
+	size_t len;
+	struct gn_sim_nvs_entry *next;
+} gn_sim_nvs_entry_t;
+
+static struct {
+	bool used;
+	char ns[NVS_NS_NAME_MAX_SIZE];
+	nvs_open_mode_t mode;
+} _gn_sim_nvs_handles[_GN_SIM_NVS_MAX_HANDLES];
+
+static pthread_mutex_t _gn_sim_nvs_mutex = PTHREAD_MUTEX_INITIALIZER;
+static gn_sim_nvs_entry_t *_gn_sim_nvs_entries = NULL;
+static bool _gn_sim_nvs_initialized = false;
+
+esp_err_t nvs_flash_init(void) {
+	_gn_sim_nvs_initialized = true;
+	return ESP_OK;
+}
+
+esp_err_t nvs_flash_deinit(void) {
+	_gn_sim_nvs_initialized = false;
+	return ESP_OK;
+}
+
+esp_err_t nvs_flash_erase(void) {
+
+	pthread_mutex_lock(&_gn_sim_nvs_mutex);
+	while (_gn_sim_nvs_entries) {
+		gn_sim_nvs_entry_t *next = _gn_sim_nvs_entries->next;
+		free(_gn_sim_nvs_entries->data);
+		free(_gn_sim_nvs_entries);
+		_gn_sim_nvs_entries = next;
+	}
+	pthread_mutex_unlock(&_gn_sim_nvs_mutex);
+	return ESP_OK;
+
+}
+
+esp_err_t nvs_open(const char *name, nvs_open_mode_t open_mode,
+		nvs_handle_t *out_handle) {
+
+	if (!_gn_sim_nvs_initialized)
+		return ESP_ERR_NVS_NOT_INITIALIZED;
+	if (!name || !out_handle)
+		return ESP_ERR_INVALID_ARG;
+	if (strlen(name) >= NVS_NS_NAME_MAX_SIZE)
+		return ESP_ERR_NVS_INVALID_NAME;
+
+	pthread_mutex_lock(&_gn_sim_nvs_mutex);
+	for (size_t i = 0; i < _GN_SIM_NVS_MAX_HANDLES; i++) {
+		if (!_gn_sim_nvs_handles[i].used) {
+			_gn_sim_nvs_handles[i].used = true;
+			_gn_sim_nvs_handles[i].mode = open_mode;
+			strcpy(_gn_sim_nvs_handles[i].ns, name);
+			*out_handle = i + 1;
+			pthread_mutex_unlock(&_gn_sim_nvs_mutex);
+			return ESP_OK;
+		}
+	}
+	pthread_mutex_unlock(&_gn_sim_nvs_mutex);
+
+	return ESP_ERR_NVS_NOT_ENOUGH_SPACE;
+
+}
+
+void nvs_close(nvs_handle_t handle) {
+
+	pthread_mutex_lock(&_gn_sim_nvs_mutex);
+	if (handle > 0 && handle <= _GN_SIM_NVS_MAX_HANDLES)
+		_gn_sim_nvs_handles[handle - 1].used = false;
+	pthread_mutex_unlock(&_gn_sim_nvs_mutex);
+
+}
+
+static const char* _gn_sim_nvs_ns(nvs_handle_t handle, bool write) {
+
+	if (handle == 0 || handle > _GN_SIM_NVS_MAX_HANDLES
+			|| !_gn_sim_nvs_handles[handle - 1].used)
+		return NULL;
+	if (write && _gn_sim_nvs_handles[handle - 1].mode != NVS_READWRITE)
+		return NULL;
+	return _gn_sim_nvs_handles[handle - 1].ns;
+
+}
+
+static gn_sim_nvs_entry_t** _gn_sim_nvs_find(const char *ns, const char *key) {
+
+	gn_sim_nvs_entry_t **e = &_gn_sim_nvs_entries;
+	while (*e && (strcmp((*e)->ns, ns) != 0 || strcmp((*e)->key, key) != 0))
+		e = &(*e)->next;
+	return e;
+
+}
+
+esp_err_t nvs_commit(nvs_handle_t handle) {
+
+	pthread_mutex_lock(&_gn_sim_nvs_mutex);
+	const char *ns = _gn_sim_nvs_ns(handle, false);
+	pthread_mutex_unlock(&_gn_sim_nvs_mutex);
+	return ns ? ESP_OK : ESP_ERR_NVS_INVALID_HANDLE;
+
+}
+
+static esp_err_t _gn_sim_nvs_set(nvs_handle_t handle, const char *key,
+		gn_sim_nvs_type_t type, const void *value, size_t len) {
+
+	if (!key || (!value && len > 0))
+		return ESP_ERR_INVALID_ARG;
+	if (strlen(key) >= NVS_KEY_NAME_MAX_SIZE)
+		return ESP_ERR_NVS_KEY_TOO_LONG;
+
+	void *data = malloc(len ? len : 1);
+	if (!data)
+		return ESP_ERR_NO_MEM;
+	memcpy(data, value, len);
+
+	pthread_mutex_lock(&_gn_sim_nvs_mutex);
+
+	const char *ns = _gn_sim_nvs_ns(handle, true);
+	if (!ns) {
+		pthread_mutex_unlock(&_gn_sim_nvs_mutex);
+		free(data);
+		return ESP_ERR_NVS_INVALID_HANDLE;
+	}
+
+	gn_sim_nvs_entry_t **found = _gn_sim_nvs_find(ns, key);
+	gn_sim_nvs_entry_t *e = *found;
+	if (!e) {
+		e = calloc(1, sizeof(gn_sim_nvs_entry_t));
+		if (!e) {
+			pthread_mutex_unlock(&_gn_sim_nvs_mutex);
+			free(data);
+			return ESP_ERR_NO_MEM;
+		}
+		strcpy(e->ns, ns);
+		strcpy(e->key, key);
+		*found = e;
+	}
+
+	free(e->data);
+	e->type = type;
+	e->data = data;
+	e->len = len;
+
+	pthread_mutex_unlock(&_gn_sim_nvs_mutex);
+	return ESP_OK;
+
+}
+
+static esp_err_t _gn_sim_nvs_get(nvs_handle_t handle, const char *key,
+		gn_sim_nvs_type_t type, void *out_value, size_t *length) {
+
+	if (!key)
+		return ESP_ERR_INVALID_ARG;
+
+	pthread_mutex_lock(&_gn_sim_nvs_mutex);
+
+	esp_err_t ret = ESP_OK;
+	const char *ns = _gn_sim_nvs_ns(handle, false);
+	if (!ns) {
+		ret = ESP_ERR_NVS_INVALID_HANDLE;
+		goto unlock;
+	}
+
+	gn_sim_nvs_entry_t *e = *_gn_sim_nvs_find(ns, key);
+	if (!e || e->type != type) {
+		ret = ESP_ERR_NVS_NOT_FOUND;
+		goto unlock;
+	}
+
+	//variable length items report their size when out_value is NULL
+	if (!out_value) {
+		*length = e->len;
+		goto unlock;
+	}
+	if (*length < e->len) {
+		ret = ESP_ERR_NVS_INVALID_LENGTH;
+		goto unlock;
+	}
+
+	memcpy(out_value, e->data, e->len);
+	*length = e->len;
+
+	unlock: pthread_mutex_unlock(&_gn_sim_nvs_mutex);
+	return ret;
+
+}
+
+esp_err_t nvs_erase_key(nvs_handle_t handle, const char *key) {
+
+	pthread_mutex_lock(&_gn_sim_nvs_mutex);
+
+	esp_err_t ret = ESP_OK;
+	const char *ns = _gn_sim_nvs_ns(handle, true);
+	if (!ns) {
+		ret = ESP_ERR_NVS_INVALID_HANDLE;
+		goto unlock;
+	}
+
+	gn_sim_nvs_entry_t **found = _gn_sim_nvs_find(ns, key);
+	gn_sim_nvs_entry_t *e = *found;
+	if (!e) {
+		ret = ESP_ERR_NVS_NOT_FOUND;
+		goto unlock;
+	}
+	*found = e->next;
+	free(e->data);
+	free(e);
+
+	unlock: pthread_mutex_unlock(&_gn_sim_nvs_mutex);
+	return ret;
+
+}
+
+esp_err_t nvs_erase_all(nvs_handle_t handle) {
+
+	pthread_mutex_lock(&_gn_sim_nvs_mutex);
+
+	const char *ns = _gn_sim_nvs_ns(handle, true);
+	if (!ns) {
+		pthread_mutex_unlock(&_gn_sim_nvs_mutex);
+		return ESP_ERR_NVS_INVALID_HANDLE;
+	}
+
+	gn_sim_nvs_entry_t **e = &_gn_sim_nvs_entries;
+	while (*e) {
+		if (strcmp((*e)->ns, ns) == 0) {
+			gn_sim_nvs_entry_t *erased = *e;
+			*e = erased->next;
+			free(erased->data);
+			free(erased);
+		} else
+			e = &(*e)->next;
+	}
+
+	pthread_mutex_unlock(&_gn_sim_nvs_mutex);
+	return ESP_OK;
+
+}
+
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char *key, const void *value,
+		size_t length) {
+	return _gn_sim_nvs_set(handle, key, _GN_SIM_NVS_TYPE_BLOB, value, length);
+}
+
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char *key, void *out_value,
+		size_t *length) {
+	if (!length)
+		return ESP_ERR_INVALID_ARG;
+	return _gn_sim_nvs_get(handle, key, _GN_SIM_NVS_TYPE_BLOB, out_value,
+			length);
+}
+
+esp_err_t nvs_set_str(nvs_handle_t handle, const char *key, const char *value) {
+	if (!value)
+		return ESP_ERR_INVALID_ARG;
+	return _gn_sim_nvs_set(handle, key, _GN_SIM_NVS_TYPE_STR, value,
+			strlen(value) + 1);
+}
+
+esp_err_t nvs_get_str(nvs_handle_t handle, const char *key, char *out_value,
+		size_t *length) {
+	if (!length)
+		return ESP_ERR_INVALID_ARG;
+	return _gn_sim_nvs_get(handle, key, _GN_SIM_NVS_TYPE_STR, out_value, length);
+}
+
+#define _GN_SIM_NVS_SCALAR(name, ctype, type)									\
+	esp_err_t nvs_set_##name(nvs_handle_t handle, const char *key, ctype value) {	\
+		return _gn_sim_nvs_set(handle, key, type, &value, sizeof(value));		\
+	}																			\
+	esp_err_t nvs_get_##name(nvs_handle_t handle, const char *key,				\
+			ctype *out_value) {													\
+		size_t len = sizeof(ctype);												\
+		if (!out_value)															\
+			return ESP_ERR_INVALID_ARG;											\
+		return _gn_sim_nvs_get(handle, key, type, out_value, &len);				\
+	}
+
+_GN_SIM_NVS_SCALAR(u8, uint8_t, _GN_SIM_NVS_TYPE_U8)
+_GN_SIM_NVS_SCALAR(i32, int32_t, _GN_SIM_NVS_TYPE_I32)
+_GN_SIM_NVS_SCALAR(u32, uint32_t, _GN_SIM_NVS_TYPE_U32)
+_GN_SIM_NVS_SCALAR(i64, int64_t, _GN_SIM_NVS_TYPE_I64)
@@ -0,0 +1,304 @@
+// Copyright 2021 Nicola Muratori (nicola.muratori@gmail.com)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+/*
+ * flash partitions and OTA updates of the host build: the running and the update partitions
+ * live in memory, outside of the simulated heap. as on flash, writes only clear bits and
+ * erases set whole sectors
+ */
+
+#include <pthread.h>
+#include <string.h>
+
+#include "esp_log.h"
+#include "esp_partition.h"
+#include "esp_ota_ops.h"
+#include "esp_https_ota.h"
+#include "mbedtls/sha256.h"
+
+#include "gn_sim.h"
+#include "gn_sim_intl.h"
+
+#define TAG "gn_sim_ota"
+
+#define _GN_SIM_OTA_PARTITION_SIZE 0x100000
+#define _GN_SIM_OTA_SECTOR_SIZE 4096
+
+static const esp_partition_t _gn_sim_ota_running = { .type = 0, .subtype = 0,
+		.address = 0x10000, .size = _GN_SIM_OTA_PARTITION_SIZE, .label =
+				"factory" };
+
+static const esp_partition_t _gn_sim_ota_update = { .type = 0, .subtype = 0x10,
+		.address = 0x110000, .size = _GN_SIM_OTA_PARTITION_SIZE, .label =
+				"ota_0" };
+
+static pthread_mutex_t _gn_sim_ota_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static uint8_t _gn_sim_ota_running_data[_GN_SIM_OTA_PARTITION_SIZE];
+static size_t _gn_sim_ota_running_len = 0;
+static uint8_t _gn_sim_ota_update_data[_GN_SIM_OTA_PARTITION_SIZE];
+
+static esp_ota_handle_t _gn_sim_ota_handle = 0; /*!< 0 if no update in progress */
+static esp_ota_handle_t _gn_sim_ota_last_handle = 0;
+static size_t _gn_sim_ota_written = 0; /*!< end of the data written */
+static size_t _gn_sim_ota_update_len = 0; /*!< 0 if no valid image */
+static bool _gn_sim_ota_boot_update = false;
+
+static uint8_t* _gn_sim_ota_data(const esp_partition_t *partition) {
+	if (partition == &_gn_sim_ota_running)
+		return _gn_sim_ota_running_data;
+	if (partition == &_gn_sim_ota_update)
+		return _gn_sim_ota_update_data;
+	return NULL;
+}
+
+void gn_sim_ota_set_running(const uint8_t *data, size_t len) {
+
+	if (len > _GN_SIM_OTA_PARTITION_SIZE)
+		len = _GN_SIM_OTA_PARTITION_SIZE;
+
+	pthread_mutex_lock(&_gn_sim_ota_mutex);
+	memset(_gn_sim_ota_running_data, 0xFF, sizeof(_gn_sim_ota_running_data));
+	memset(_gn_sim_ota_update_data, 0xFF, sizeof(_gn_sim_ota_update_data));
+	_gn_sim_ota_running_len = data ? len : 0;
+	if (data)
+		memcpy(_gn_sim_ota_running_data, data, len);
+	_gn_sim_ota_handle = 0;
+	_gn_sim_ota_written = 0;
+	_gn_sim_ota_update_len = 0;
+	_gn_sim_ota_boot_update = false;
+	pthread_mutex_unlock(&_gn_sim_ota_mutex);
+
+}
+
+const uint8_t* gn_sim_ota_get_update(size_t *len) {
+
+	pthread_mutex_lock(&_gn_sim_ota_mutex);
+	size_t l = _gn_sim_ota_update_len;
+	pthread_mutex_unlock(&_gn_sim_ota_mutex);
+
+	if (len)
+		*len = l;
+	return l ? _gn_sim_ota_update_data : NULL;
+
+}
+
+bool gn_sim_ota_boot_set(void) {
+	pthread_mutex_lock(&_gn_sim_ota_mutex);
+	bool ret = _gn_sim_ota_boot_update;
+	pthread_mutex_unlock(&_gn_sim_ota_mutex);
+	return ret;
+}
+
+//partitions
+
+esp_err_t esp_partition_read(const esp_partition_t *partition,
+		size_t src_offset, void *dst, size_t size) {
+
+	uint8_t *data = _gn_sim_ota_data(partition);
+	if (!data || !dst)
+		return ESP_ERR_INVALID_ARG;
+	if (src_offset > partition->size || size > partition->size - src_offset)
+		return ESP_ERR_INVALID_SIZE;
+
+	pthread_mutex_lock(&_gn_sim_ota_mutex);
+	memcpy(dst, data + src_offset, size);
+	pthread_mutex_unlock(&_gn_sim_ota_mutex);
+	return ESP_OK;
+
+}
+
+esp_err_t esp_partition_erase_range(const esp_partition_t *partition,
+		size_t offset, size_t size) {
+
+	uint8_t *data = _gn_sim_ota_data(partition);
+	if (!data)
+		return ESP_ERR_INVALID_ARG;
+	if (offset > partition->size || size > partition->size - offset)
+		return ESP_ERR_INVALID_SIZE;
+
+	pthread_mutex_lock(&_gn_sim_ota_mutex);
+	memset(data + offset, 0xFF, size);
+	pthread_mutex_unlock(&_gn_sim_ota_mutex);
+	return ESP_OK;
+
+}
+
+esp_err_t esp_partition_get_sha256(const esp_partition_t *partition,
+		uint8_t *sha_256) {
+
+	if (!sha_256 || !_gn_sim_ota_data(partition))
+		return ESP_ERR_INVALID_ARG;
+
+	pthread_mutex_lock(&_gn_sim_ota_mutex);
+	const uint8_t *data = _gn_sim_ota_data(partition);
+	size_t len =
+			partition == &_gn_sim_ota_running ?
+					_gn_sim_ota_running_len : _gn_sim_ota_update_len;
+	esp_err_t ret = ESP_ERR_NOT_FOUND;
+	if (len > 32) {
+		//the digest covers the image without itself, a mismatch fails the image verification
+		uint8_t sha[32];
+		mbedtls_sha256_ret(data, len - 32, sha, 0);
+		ret = memcmp(sha, data + len - 32, 32) == 0 ?
+				ESP_OK : ESP_ERR_IMAGE_INVALID;
+		if (ret == ESP_OK)
+			memcpy(sha_256, sha, 32);
+	}
+	pthread_mutex_unlock(&_gn_sim_ota_mutex);
+
+	return ret;
+
+}
+
+//ota
+
+const esp_partition_t* esp_ota_get_running_partition(void) {
+	return &_gn_sim_ota_running;
+}
+
+const esp_partition_t* esp_ota_get_next_update_partition(
+		const esp_partition_t *start_from) {
+	return &_gn_sim_ota_update;
+}
+
+const esp_app_desc_t* esp_ota_get_app_description(void) {
+
+	static const esp_app_desc_t desc = { .magic_word = 0xABCD5432, .version =
+			"host", .project_name = "grownode", .time = __TIME__, .date =
+			__DATE__, .idf_ver = "host" };
+	return &desc;
+
+}
+
+esp_err_t esp_ota_begin(const esp_partition_t *partition, size_t image_size,
+		esp_ota_handle_t *out_handle) {
+
+	if (partition != &_gn_sim_ota_update || !out_handle)
+		return ESP_ERR_INVALID_ARG;
+
+	pthread_mutex_lock(&_gn_sim_ota_mutex);
+	esp_err_t ret = ESP_OK;
+	if (_gn_sim_ota_handle) {
+		ret = ESP_ERR_INVALID_STATE;
+	} else {
+		//as in the IDF, a sequential update erases while writing
+		if (image_size != OTA_WITH_SEQUENTIAL_WRITES)
+			memset(_gn_sim_ota_update_data, 0xFF,
+					sizeof(_gn_sim_ota_update_data));
+		_gn_sim_ota_handle = ++_gn_sim_ota_last_handle;
+		_gn_sim_ota_written = 0;
+		_gn_sim_ota_update_len = 0;
+		_gn_sim_ota_boot_update = false;
+		*out_handle = _gn_sim_ota_handle;
+	}
+	pthread_mutex_unlock(&_gn_sim_ota_mutex);
+	return ret;
+
+}
+
+esp_err_t esp_ota_write_with_offset(esp_ota_handle_t handle, const void *data,
+		size_t size, uint32_t offset) {
+
+	if (!data && size)
+		return ESP_ERR_INVALID_ARG;
+
+	//the buffers of the updater are all allocated while it writes
+	_gn_sim_heap_sample();
+
+	pthread_mutex_lock(&_gn_sim_ota_mutex);
+	esp_err_t ret = ESP_OK;
+	if (!handle || handle != _gn_sim_ota_handle)
+		ret = ESP_ERR_NOT_FOUND;
+	else if (offset > _GN_SIM_OTA_PARTITION_SIZE
+			|| size > _GN_SIM_OTA_PARTITION_SIZE - offset)
+		ret = ESP_ERR_INVALID_SIZE;
+	else {
+		for (size_t i = 0; i < size; i++)
+			_gn_sim_ota_update_data[offset + i] &= ((const uint8_t*) data)[i];
+		if (offset + size > _gn_sim_ota_written)
+			_gn_sim_ota_written = offset + size;
+	}
+	pthread_mutex_unlock(&_gn_sim_ota_mutex);
+	return ret;
+
+}
+
+esp_err_t esp_ota_write(esp_ota_handle_t handle, const void *data, size_t size) {
+
+	pthread_mutex_lock(&_gn_sim_ota_mutex);
+	size_t offset = _gn_sim_ota_written;
+	//as in the IDF, erases the sectors it starts writing
+	size_t sector = (offset + _GN_SIM_OTA_SECTOR_SIZE - 1)
+			& ~(_GN_SIM_OTA_SECTOR_SIZE - 1);
+	for (; handle && handle == _gn_sim_ota_handle && sector < offset + size
+			&& sector < _GN_SIM_OTA_PARTITION_SIZE;
+			sector += _GN_SIM_OTA_SECTOR_SIZE)
+		memset(_gn_sim_ota_update_data + sector, 0xFF, _GN_SIM_OTA_SECTOR_SIZE);
+	pthread_mutex_unlock(&_gn_sim_ota_mutex);
+	return esp_ota_write_with_offset(handle, data, size, offset);
+
+}
+
+esp_err_t esp_ota_end(esp_ota_handle_t handle) {
+
+	pthread_mutex_lock(&_gn_sim_ota_mutex);
+	esp_err_t ret = ESP_OK;
+	if (!handle || handle != _gn_sim_ota_handle)
+		ret = ESP_ERR_NOT_FOUND;
+	else if (_gn_sim_ota_written == 0)
+		ret = ESP_ERR_OTA_VALIDATE_FAILED;
+	else
+		_gn_sim_ota_update_len = _gn_sim_ota_written;
+	_gn_sim_ota_handle = 0;
+	pthread_mutex_unlock(&_gn_sim_ota_mutex);
+	return ret;
+
+}
+
+esp_err_t esp_ota_abort(esp_ota_handle_t handle) {
+
+	pthread_mutex_lock(&_gn_sim_ota_mutex);
+	esp_err_t ret = ESP_OK;
+	if (!handle || handle != _gn_sim_ota_handle)
+		ret = ESP_ERR_NOT_FOUND;
+	_gn_sim_ota_handle = 0;
+	pthread_mutex_unlock(&_gn_sim_ota_mutex);
+	return ret;
+
+}
+
+esp_err_t esp_ota_set_boot_partition(const esp_partition_t *partition) {
+
+	pthread_mutex_lock(&_gn_sim_ota_mutex);
+	esp_err_t ret = ESP_OK;
+	if (partition == &_gn_sim_ota_running)
+		_gn_sim_ota_boot_update = false;
+	else if (partition != &_gn_sim_ota_update)
+		ret = ESP_ERR_INVALID_ARG;
+	else if (_gn_sim_ota_update_len == 0)
+		ret = ESP_ERR_OTA_VALIDATE_FAILED;
+	else
+		_gn_sim_ota_boot_update = true;
+	pthread_mutex_unlock(&_gn_sim_ota_mutex);
+	return ret;
+
+}
+
+esp_err_t esp_https_ota(const esp_http_client_config_t *config) {
+	ESP_LOGW(TAG, "ota from %s not supported on the host",
+			config && config->url ? config->url : "(null)");
+	return ESP_ERR_NOT_SUPPORTED;
+}
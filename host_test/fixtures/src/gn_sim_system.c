@@ -0,0 +1,404 @@
+// Copyright 2021 Nicola Muratori (nicola.muratori@gmail.com)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * logging, restart, heap accounting, sleep and the services with nothing to simulate
+ * (spiffs, sntp) of the host build
+ */
+
+#define _GNU_SOURCE
+
+#include <malloc.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "esp_log.h"
+#include "esp_system.h"
+#include "esp_heap_caps.h"
+#include "esp_sleep.h"
+#include "esp_spiffs.h"
+#include "esp_sntp.h"
+#include "nvs.h"
+
+#include "gn_sim.h"
+#include "gn_sim_intl.h"
+
+#define TAG "gn_sim"
+
+#ifndef CONFIG_LOG_DEFAULT_LEVEL
+#define CONFIG_LOG_DEFAULT_LEVEL ESP_LOG_INFO
+#endif
+
+#define _GN_SIM_LOG_MAX_TAGS 32
+
+//embedded by the IDF build from the server certificate, empty on the host
+__asm__(".pushsection .rodata\n"
+		".global _binary_ca_cert_pem_start\n"
+		"_binary_ca_cert_pem_start:\n"
+		".asciz \"\"\n"
+		".global _binary_ca_cert_pem_end\n"
+		"_binary_ca_cert_pem_end:\n"
+		".popsection\n");
+
+//log
+
+static pthread_mutex_t _gn_sim_log_mutex = PTHREAD_MUTEX_INITIALIZER;
+static bool _gn_sim_log_enabled = true;
+static esp_log_level_t _gn_sim_log_default_level = CONFIG_LOG_DEFAULT_LEVEL;
+
+static struct {
+	char tag[32];
+	esp_log_level_t level;
+} _gn_sim_log_levels[_GN_SIM_LOG_MAX_TAGS];
+static size_t _gn_sim_log_levels_count = 0;
+
+void gn_sim_log_set_output(bool enabled) {
+	pthread_mutex_lock(&_gn_sim_log_mutex);
+	_gn_sim_log_enabled = enabled;
+	pthread_mutex_unlock(&_gn_sim_log_mutex);
+}
+
+void esp_log_level_set(const char *tag, esp_log_level_t level) {
+
+	pthread_mutex_lock(&_gn_sim_log_mutex);
+
+	if (strcmp(tag, "*") == 0) {
+		_gn_sim_log_default_level = level;
+		_gn_sim_log_levels_count = 0;
+		goto unlock;
+	}
+
+	for (size_t i = 0; i < _gn_sim_log_levels_count; i++) {
+		if (strcmp(_gn_sim_log_levels[i].tag, tag) == 0) {
+			_gn_sim_log_levels[i].level = level;
+			goto unlock;
+		}
+	}
+
+	if (_gn_sim_log_levels_count < _GN_SIM_LOG_MAX_TAGS) {
+		strncpy(_gn_sim_log_levels[_gn_sim_log_levels_count].tag, tag,
+				sizeof(_gn_sim_log_levels[0].tag) - 1);
+		_gn_sim_log_levels[_gn_sim_log_levels_count++].level = level;
+	}
+
+	unlock: pthread_mutex_unlock(&_gn_sim_log_mutex);
+
+}
+
+static esp_log_level_t _gn_sim_log_level_get(const char *tag) {
+
+	for (size_t i = 0; i < _gn_sim_log_levels_count; i++)
+		if (strcmp(_gn_sim_log_levels[i].tag, tag) == 0)
+			return _gn_sim_log_levels[i].level;
+	return _gn_sim_log_default_level;
+
+}
+
+esp_log_level_t esp_log_level_get(const char *tag) {
+
+	pthread_mutex_lock(&_gn_sim_log_mutex);
+	esp_log_level_t ret = _gn_sim_log_level_get(tag);
+	pthread_mutex_unlock(&_gn_sim_log_mutex);
+	return ret;
+
+}
+
+uint32_t esp_log_timestamp(void) {
+	return xTaskGetTickCount();
+}
+
+void esp_log_write(esp_log_level_t level, const char *tag, const char *format,
+		...) {
+
+	static const char letters[] = { ' ', 'E', 'W', 'I', 'D', 'V' };
+
+	pthread_mutex_lock(&_gn_sim_log_mutex);
+
+	if (_gn_sim_log_enabled && level != ESP_LOG_NONE
+			&& level <= _gn_sim_log_level_get(tag)) {
+		va_list args;
+		va_start(args, format);
+		fprintf(stderr, "%c (%u) %s: ", letters[level], esp_log_timestamp(),
+				tag);
+		vfprintf(stderr, format, args);
+		fputc('\n', stderr);
+		va_end(args);
+	}
+
+	pthread_mutex_unlock(&_gn_sim_log_mutex);
+
+}
+
+const char* esp_err_to_name(esp_err_t code) {
+
+	switch (code) {
+	case ESP_OK:
+		return "ESP_OK";
+	case ESP_FAIL:
+		return "ESP_FAIL";
+	case ESP_ERR_NO_MEM:
+		return "ESP_ERR_NO_MEM";
+	case ESP_ERR_INVALID_ARG:
+		return "ESP_ERR_INVALID_ARG";
+	case ESP_ERR_INVALID_STATE:
+		return "ESP_ERR_INVALID_STATE";
+	case ESP_ERR_INVALID_SIZE:
+		return "ESP_ERR_INVALID_SIZE";
+	case ESP_ERR_NOT_FOUND:
+		return "ESP_ERR_NOT_FOUND";
+	case ESP_ERR_NOT_SUPPORTED:
+		return "ESP_ERR_NOT_SUPPORTED";
+	case ESP_ERR_TIMEOUT:
+		return "ESP_ERR_TIMEOUT";
+	case ESP_ERR_INVALID_RESPONSE:
+		return "ESP_ERR_INVALID_RESPONSE";
+	case ESP_ERR_INVALID_CRC:
+		return "ESP_ERR_INVALID_CRC";
+	case ESP_ERR_NVS_NOT_FOUND:
+		return "ESP_ERR_NVS_NOT_FOUND";
+	case ESP_ERR_NVS_INVALID_HANDLE:
+		return "ESP_ERR_NVS_INVALID_HANDLE";
+	case ESP_ERR_NVS_INVALID_LENGTH:
+		return "ESP_ERR_NVS_INVALID_LENGTH";
+	default:
+		return "UNKNOWN ERROR";
+	}
+
+}
+
+//system
+
+void esp_restart(void) {
+
+	ESP_LOGW(TAG, "restart requested, exiting with code %d",
+			GN_SIM_RESTART_EXIT_CODE);
+	fflush(stdout);
+	fflush(stderr);
+	exit(GN_SIM_RESTART_EXIT_CODE);
+
+}
+
+static esp_reset_reason_t _gn_sim_reset_reason = ESP_RST_POWERON;
+
+esp_reset_reason_t esp_reset_reason(void) {
+	return _gn_sim_reset_reason;
+}
+
+void gn_sim_set_reset_reason(int reason) {
+	_gn_sim_reset_reason = (esp_reset_reason_t) reason;
+}
+
+esp_err_t esp_efuse_mac_get_default(uint8_t *mac) {
+
+	static const uint8_t sim_mac[6] = { 0x24, 0x0a, 0xc4, 0x5e, 0x17, 0x00 };
+
+	if (!mac)
+		return ESP_ERR_INVALID_ARG;
+	memcpy(mac, sim_mac, sizeof(sim_mac));
+	return ESP_OK;
+
+}
+
+esp_err_t esp_read_mac(uint8_t *mac, esp_mac_type_t type) {
+
+	esp_err_t ret = esp_efuse_mac_get_default(mac);
+	if (ret == ESP_OK)
+		mac[5] += type;
+	return ret;
+
+}
+
+uint32_t esp_random(void) {
+	return ((uint32_t) random() << 1) ^ (uint32_t) random();
+}
+
+//heap
+
+static size_t _gn_sim_heap_peak = 0;
+
+size_t gn_sim_heap_used(void) {
+
+	struct mallinfo2 info = mallinfo2();
+	return info.uordblks + info.hblkhd;
+
+}
+
+void _gn_sim_heap_sample(void) {
+
+	size_t used = gn_sim_heap_used();
+	size_t peak = __atomic_load_n(&_gn_sim_heap_peak, __ATOMIC_RELAXED);
+	while (used > peak
+			&& !__atomic_compare_exchange_n(&_gn_sim_heap_peak, &peak, used,
+					false, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+		;
+
+}
+
+size_t gn_sim_heap_peak(void) {
+	_gn_sim_heap_sample();
+	return __atomic_load_n(&_gn_sim_heap_peak, __ATOMIC_RELAXED);
+}
+
+void gn_sim_heap_reset_peak(void) {
+	__atomic_store_n(&_gn_sim_heap_peak, gn_sim_heap_used(), __ATOMIC_RELAXED);
+}
+
+static size_t _gn_sim_heap_free(size_t used) {
+	return used < GN_SIM_HEAP_SIZE ? GN_SIM_HEAP_SIZE - used : 0;
+}
+
+uint32_t esp_get_free_heap_size(void) {
+	_gn_sim_heap_sample();
+	return _gn_sim_heap_free(gn_sim_heap_used());
+}
+
+uint32_t esp_get_minimum_free_heap_size(void) {
+	return _gn_sim_heap_free(gn_sim_heap_peak());
+}
+
+void* heap_caps_malloc(size_t size, uint32_t caps) {
+	return malloc(size);
+}
+
+void* heap_caps_calloc(size_t n, size_t size, uint32_t caps) {
+	return calloc(n, size);
+}
+
+void heap_caps_free(void *ptr) {
+	free(ptr);
+}
+
+size_t heap_caps_get_free_size(uint32_t caps) {
+	return esp_get_free_heap_size();
+}
+
+size_t heap_caps_get_minimum_free_size(uint32_t caps) {
+	return esp_get_minimum_free_heap_size();
+}
+
+size_t heap_caps_get_largest_free_block(uint32_t caps) {
+	return esp_get_free_heap_size();
+}
+
+void heap_caps_print_heap_info(uint32_t caps) {
+	ESP_LOGI(TAG, "heap used %zu, peak %zu, size %d", gn_sim_heap_used(),
+			gn_sim_heap_peak(), GN_SIM_HEAP_SIZE);
+}
+
+//sleep
+
+static uint64_t _gn_sim_sleep_us = 0;
+static esp_sleep_wakeup_cause_t _gn_sim_wakeup_cause =
+		ESP_SLEEP_WAKEUP_UNDEFINED;
+
+esp_err_t esp_sleep_enable_timer_wakeup(uint64_t time_in_us) {
+	_gn_sim_sleep_us = time_in_us;
+	return ESP_OK;
+}
+
+esp_err_t esp_light_sleep_start(void) {
+
+	vTaskDelay(pdMS_TO_TICKS(_gn_sim_sleep_us / 1000));
+	_gn_sim_wakeup_cause = ESP_SLEEP_WAKEUP_TIMER;
+	return ESP_OK;
+
+}
+
+void esp_deep_sleep_start(void) {
+
+	ESP_LOGW(TAG, "deep sleep for %llu us requested, exiting with code %d",
+			(unsigned long long) _gn_sim_sleep_us, GN_SIM_RESTART_EXIT_CODE);
+	fflush(stdout);
+	fflush(stderr);
+	exit(GN_SIM_RESTART_EXIT_CODE);
+
+}
+
+void esp_deep_sleep(uint64_t time_in_us) {
+	esp_sleep_enable_timer_wakeup(time_in_us);
+	esp_deep_sleep_start();
+}
+
+esp_sleep_wakeup_cause_t esp_sleep_get_wakeup_cause(void) {
+	return _gn_sim_wakeup_cause;
+}
+
+//spiffs
+
+esp_err_t esp_vfs_spiffs_register(const esp_vfs_spiffs_conf_t *conf) {
+	return conf ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t esp_vfs_spiffs_unregister(const char *partition_label) {
+	return ESP_OK;
+}
+
+esp_err_t esp_spiffs_info(const char *partition_label, size_t *total_bytes,
+		size_t *used_bytes) {
+
+	if (total_bytes)
+		*total_bytes = 0;
+	if (used_bytes)
+		*used_bytes = 0;
+	return ESP_OK;
+
+}
+
+//sntp
+
+static bool _gn_sim_sntp_enabled = false;
+static sntp_sync_time_cb_t _gn_sim_sntp_cb = NULL;
+
+void sntp_setoperatingmode(uint8_t operating_mode) {
+}
+
+void sntp_setservername(uint8_t idx, const char *server) {
+}
+
+void sntp_servermode_dhcp(int set_servers_from_dhcp) {
+}
+
+void sntp_set_time_sync_notification_cb(sntp_sync_time_cb_t callback) {
+	_gn_sim_sntp_cb = callback;
+}
+
+void sntp_init(void) {
+
+	_gn_sim_sntp_enabled = true;
+	if (_gn_sim_sntp_cb) {
+		struct timeval tv;
+		gettimeofday(&tv, NULL);
+		_gn_sim_sntp_cb(&tv);
+	}
+
+}
+
+void sntp_stop(void) {
+	_gn_sim_sntp_enabled = false;
+}
+
+bool sntp_enabled(void) {
+	return _gn_sim_sntp_enabled;
+}
+
+sntp_sync_status_t sntp_get_sync_status(void) {
+	return _gn_sim_sntp_enabled ?
+			SNTP_SYNC_STATUS_COMPLETED : SNTP_SYNC_STATUS_RESET;
+}
@@ -0,0 +1,353 @@
+// Copyright 2021 Nicola Muratori (nicola.muratori@gmail.com)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * simulated station, netif and provisioning manager. the node is always provisioned and the access point
+ * hands out a fixed address, unless a static one has been set with dhcp stopped
+ */
+
+#include <pthread.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+
+#include "esp_log.h"
+#include "esp_event.h"
+#include "esp_system.h"
+#include "esp_wifi.h"
+#include "esp_netif.h"
+#include "wifi_provisioning/manager.h"
+#include "wifi_provisioning/scheme_softap.h"
+#include "wifi_provisioning/scheme_ble.h"
+
+#define TAG "gn_sim_wifi"
+
+#define _GN_SIM_WIFI_SSID "gn_sim_ap"
+#define _GN_SIM_WIFI_CHANNEL 6
+#define _GN_SIM_WIFI_POST_TICKS pdMS_TO_TICKS(1000)
+
+ESP_EVENT_DEFINE_BASE(WIFI_EVENT);
+ESP_EVENT_DEFINE_BASE(IP_EVENT);
+ESP_EVENT_DEFINE_BASE(WIFI_PROV_EVENT);
+
+const wifi_prov_scheme_t wifi_prov_scheme_softap = { .name = "softap" };
+const wifi_prov_scheme_t wifi_prov_scheme_ble = { .name = "ble" };
+
+struct esp_netif_obj {
+	bool dhcpc_started;
+	esp_netif_ip_info_t ip_info;
+	esp_netif_dns_info_t dns[ESP_NETIF_DNS_MAX];
+};
+
+static const uint8_t _gn_sim_wifi_bssid[6] = { 0x02, 0x00, 0x5e, 0x00, 0x53,
+		0x01 };
+
+static pthread_mutex_t _gn_sim_wifi_mutex = PTHREAD_MUTEX_INITIALIZER;
+static struct esp_netif_obj _gn_sim_netif_sta = { .dhcpc_started = true };
+static struct esp_netif_obj _gn_sim_netif_ap = { .dhcpc_started = false };
+static wifi_config_t _gn_sim_wifi_config;
+static wifi_mode_t _gn_sim_wifi_mode = WIFI_MODE_NULL;
+static bool _gn_sim_wifi_initialized = false;
+static bool _gn_sim_wifi_started = false;
+static bool _gn_sim_wifi_connected = false;
+
+//netif
+
+esp_err_t esp_netif_init(void) {
+	return ESP_OK;
+}
+
+esp_netif_t* esp_netif_create_default_wifi_sta(void) {
+	return &_gn_sim_netif_sta;
+}
+
+esp_netif_t* esp_netif_create_default_wifi_ap(void) {
+	return &_gn_sim_netif_ap;
+}
+
+esp_err_t esp_netif_dhcpc_start(esp_netif_t *esp_netif) {
+
+	if (!esp_netif)
+		return ESP_ERR_INVALID_ARG;
+	pthread_mutex_lock(&_gn_sim_wifi_mutex);
+	esp_netif->dhcpc_started = true;
+	pthread_mutex_unlock(&_gn_sim_wifi_mutex);
+	return ESP_OK;
+
+}
+
+esp_err_t esp_netif_dhcpc_stop(esp_netif_t *esp_netif) {
+
+	if (!esp_netif)
+		return ESP_ERR_INVALID_ARG;
+	pthread_mutex_lock(&_gn_sim_wifi_mutex);
+	bool was_started = esp_netif->dhcpc_started;
+	esp_netif->dhcpc_started = false;
+	pthread_mutex_unlock(&_gn_sim_wifi_mutex);
+	return was_started ? ESP_OK : ESP_ERR_ESP_NETIF_DHCP_ALREADY_STOPPED;
+
+}
+
+esp_err_t esp_netif_set_ip_info(esp_netif_t *esp_netif,
+		const esp_netif_ip_info_t *ip_info) {
+
+	if (!esp_netif || !ip_info)
+		return ESP_ERR_INVALID_ARG;
+	pthread_mutex_lock(&_gn_sim_wifi_mutex);
+	esp_netif->ip_info = *ip_info;
+	pthread_mutex_unlock(&_gn_sim_wifi_mutex);
+	return ESP_OK;
+
+}
+
+esp_err_t esp_netif_get_ip_info(esp_netif_t *esp_netif,
+		esp_netif_ip_info_t *ip_info) {
+
+	if (!esp_netif || !ip_info)
+		return ESP_ERR_INVALID_ARG;
+	pthread_mutex_lock(&_gn_sim_wifi_mutex);
+	*ip_info = esp_netif->ip_info;
+	pthread_mutex_unlock(&_gn_sim_wifi_mutex);
+	return ESP_OK;
+
+}
+
+esp_err_t esp_netif_set_dns_info(esp_netif_t *esp_netif,
+		esp_netif_dns_type_t type, esp_netif_dns_info_t *dns) {
+
+	if (!esp_netif || !dns || type >= ESP_NETIF_DNS_MAX)
+		return ESP_ERR_INVALID_ARG;
+	pthread_mutex_lock(&_gn_sim_wifi_mutex);
+	esp_netif->dns[type] = *dns;
+	pthread_mutex_unlock(&_gn_sim_wifi_mutex);
+	return ESP_OK;
+
+}
+
+esp_err_t esp_netif_get_dns_info(esp_netif_t *esp_netif,
+		esp_netif_dns_type_t type, esp_netif_dns_info_t *dns) {
+
+	if (!esp_netif || !dns || type >= ESP_NETIF_DNS_MAX)
+		return ESP_ERR_INVALID_ARG;
+	pthread_mutex_lock(&_gn_sim_wifi_mutex);
+	*dns = esp_netif->dns[type];
+	pthread_mutex_unlock(&_gn_sim_wifi_mutex);
+	return ESP_OK;
+
+}
+
+esp_err_t tcpip_adapter_get_ip_info(tcpip_adapter_if_t tcpip_if,
+		tcpip_adapter_ip_info_t *ip_info) {
+	return esp_netif_get_ip_info(
+			tcpip_if == TCPIP_ADAPTER_IF_STA ?
+					&_gn_sim_netif_sta : &_gn_sim_netif_ap, ip_info);
+}
+
+//wifi
+
+esp_err_t esp_wifi_init(const wifi_init_config_t *config) {
+
+	if (!config || config->magic != WIFI_INIT_CONFIG_MAGIC)
+		return ESP_ERR_INVALID_ARG;
+	_gn_sim_wifi_initialized = true;
+	return ESP_OK;
+
+}
+
+esp_err_t esp_wifi_deinit(void) {
+	_gn_sim_wifi_initialized = false;
+	return ESP_OK;
+}
+
+esp_err_t esp_wifi_set_mode(wifi_mode_t mode) {
+	if (!_gn_sim_wifi_initialized)
+		return ESP_ERR_INVALID_STATE;
+	_gn_sim_wifi_mode = mode;
+	return ESP_OK;
+}
+
+esp_err_t esp_wifi_set_storage(wifi_storage_t storage) {
+	return ESP_OK;
+}
+
+esp_err_t esp_wifi_set_ps(wifi_ps_type_t type) {
+	return ESP_OK;
+}
+
+esp_err_t esp_wifi_get_config(wifi_interface_t interface, wifi_config_t *conf) {
+
+	if (!conf)
+		return ESP_ERR_INVALID_ARG;
+	pthread_mutex_lock(&_gn_sim_wifi_mutex);
+	*conf = _gn_sim_wifi_config;
+	pthread_mutex_unlock(&_gn_sim_wifi_mutex);
+	return ESP_OK;
+
+}
+
+esp_err_t esp_wifi_set_config(wifi_interface_t interface, wifi_config_t *conf) {
+
+	if (!conf)
+		return ESP_ERR_INVALID_ARG;
+	pthread_mutex_lock(&_gn_sim_wifi_mutex);
+	_gn_sim_wifi_config = *conf;
+	pthread_mutex_unlock(&_gn_sim_wifi_mutex);
+	return ESP_OK;
+
+}
+
+esp_err_t esp_wifi_get_mac(wifi_interface_t ifx, uint8_t mac[6]) {
+	return esp_read_mac(mac,
+			ifx == WIFI_IF_STA ? ESP_MAC_WIFI_STA : ESP_MAC_WIFI_SOFTAP);
+}
+
+esp_err_t esp_wifi_start(void) {
+
+	if (!_gn_sim_wifi_initialized)
+		return ESP_ERR_INVALID_STATE;
+	_gn_sim_wifi_started = true;
+	if (_gn_sim_wifi_mode == WIFI_MODE_STA
+			|| _gn_sim_wifi_mode == WIFI_MODE_APSTA)
+		esp_event_post(WIFI_EVENT, WIFI_EVENT_STA_START, NULL, 0,
+				_GN_SIM_WIFI_POST_TICKS);
+	return ESP_OK;
+
+}
+
+esp_err_t esp_wifi_stop(void) {
+
+	if (!_gn_sim_wifi_started)
+		return ESP_ERR_INVALID_STATE;
+	_gn_sim_wifi_started = false;
+	_gn_sim_wifi_connected = false;
+	esp_event_post(WIFI_EVENT, WIFI_EVENT_STA_STOP, NULL, 0,
+			_GN_SIM_WIFI_POST_TICKS);
+	return ESP_OK;
+
+}
+
+esp_err_t esp_wifi_connect(void) {
+
+	if (!_gn_sim_wifi_started)
+		return ESP_ERR_INVALID_STATE;
+
+	wifi_event_sta_connected_t connected = { .ssid_len = strlen(
+			_GN_SIM_WIFI_SSID), .channel = _GN_SIM_WIFI_CHANNEL, .authmode =
+			WIFI_AUTH_WPA2_PSK };
+	memcpy(connected.ssid, _GN_SIM_WIFI_SSID, connected.ssid_len);
+	memcpy(connected.bssid, _gn_sim_wifi_bssid, sizeof(connected.bssid));
+
+	ip_event_got_ip_t got_ip = { .if_index = 0, .esp_netif =
+			&_gn_sim_netif_sta, .ip_changed = false };
+
+	pthread_mutex_lock(&_gn_sim_wifi_mutex);
+	_gn_sim_wifi_connected = true;
+	if (_gn_sim_netif_sta.dhcpc_started
+			|| _gn_sim_netif_sta.ip_info.ip.addr == 0) {
+		_gn_sim_netif_sta.ip_info.ip.addr = ESP_IP4TOADDR(192, 168, 4, 2);
+		_gn_sim_netif_sta.ip_info.netmask.addr = ESP_IP4TOADDR(255, 255, 255,
+				0);
+		_gn_sim_netif_sta.ip_info.gw.addr = ESP_IP4TOADDR(192, 168, 4, 1);
+	}
+	got_ip.ip_info = _gn_sim_netif_sta.ip_info;
+	pthread_mutex_unlock(&_gn_sim_wifi_mutex);
+
+	esp_event_post(WIFI_EVENT, WIFI_EVENT_STA_CONNECTED, &connected,
+			sizeof(connected), _GN_SIM_WIFI_POST_TICKS);
+	esp_event_post(IP_EVENT, IP_EVENT_STA_GOT_IP, &got_ip, sizeof(got_ip),
+			_GN_SIM_WIFI_POST_TICKS);
+
+	return ESP_OK;
+
+}
+
+esp_err_t esp_wifi_disconnect(void) {
+
+	if (!_gn_sim_wifi_started)
+		return ESP_ERR_INVALID_STATE;
+
+	wifi_event_sta_disconnected_t disconnected = { .ssid_len = strlen(
+			_GN_SIM_WIFI_SSID), .reason = WIFI_REASON_ASSOC_LEAVE };
+	memcpy(disconnected.ssid, _GN_SIM_WIFI_SSID, disconnected.ssid_len);
+	memcpy(disconnected.bssid, _gn_sim_wifi_bssid, sizeof(disconnected.bssid));
+
+	_gn_sim_wifi_connected = false;
+	esp_event_post(WIFI_EVENT, WIFI_EVENT_STA_DISCONNECTED, &disconnected,
+			sizeof(disconnected), _GN_SIM_WIFI_POST_TICKS);
+	return ESP_OK;
+
+}
+
+esp_err_t esp_wifi_sta_get_ap_info(wifi_ap_record_t *ap_info) {
+
+	if (!ap_info)
+		return ESP_ERR_INVALID_ARG;
+	if (!_gn_sim_wifi_connected)
+		return ESP_FAIL;
+
+	memset(ap_info, 0, sizeof(wifi_ap_record_t));
+	memcpy(ap_info->bssid, _gn_sim_wifi_bssid, sizeof(ap_info->bssid));
+	strcpy((char*) ap_info->ssid, _GN_SIM_WIFI_SSID);
+	ap_info->primary = _GN_SIM_WIFI_CHANNEL;
+	ap_info->rssi = -50;
+	ap_info->authmode = WIFI_AUTH_WPA2_PSK;
+	return ESP_OK;
+
+}
+
+//provisioning
+
+esp_err_t wifi_prov_mgr_init(wifi_prov_mgr_config_t config) {
+	esp_event_post(WIFI_PROV_EVENT, WIFI_PROV_INIT, NULL, 0,
+			_GN_SIM_WIFI_POST_TICKS);
+	return ESP_OK;
+}
+
+void wifi_prov_mgr_deinit(void) {
+	esp_event_post(WIFI_PROV_EVENT, WIFI_PROV_DEINIT, NULL, 0,
+			_GN_SIM_WIFI_POST_TICKS);
+}
+
+esp_err_t wifi_prov_mgr_is_provisioned(bool *provisioned) {
+	if (!provisioned)
+		return ESP_ERR_INVALID_ARG;
+	*provisioned = true;
+	return ESP_OK;
+}
+
+esp_err_t wifi_prov_mgr_reset_provisioning(void) {
+	ESP_LOGW(TAG, "provisioning reset ignored, the simulated node stays provisioned");
+	return ESP_OK;
+}
+
+esp_err_t wifi_prov_mgr_start_provisioning(wifi_prov_security_t security,
+		const char *pop, const char *service_name, const char *service_key) {
+	return ESP_ERR_NOT_SUPPORTED;
+}
+
+void wifi_prov_mgr_wait(void) {
+}
+
+esp_err_t wifi_prov_mgr_endpoint_create(const char *ep_name) {
+	return ESP_OK;
+}
+
+esp_err_t wifi_prov_mgr_endpoint_register(const char *ep_name,
+		protocomm_req_handler_t handler, void *user_ctx) {
+	return ESP_OK;
+}
+
+esp_err_t wifi_prov_scheme_ble_set_service_uuid(uint8_t *uuid128) {
+	return ESP_OK;
+}
@@ -0,0 +1,147 @@
+// Copyright 2021 Nicola Muratori (nicola.muratori@gmail.com)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cJSON.h"
+
+#include "gn_boot_timeline.h"
+
+#define GN_BOOT_TIMELINE_MAX_PHASES 32
+
+typedef struct {
+	const char *name;
+	double start_us;
+	double end_us;
+	double total_us;
+	int count;
+	const char *parent_name;
+	int parent;
+} gn_boot_timeline_phase_t;
+
+static int _gn_boot_timeline_column(double us, double boot_us, int width) {
+
+	int col = boot_us > 0 ? (int) (us * width / boot_us) : 0;
+	return col < 0 ? 0 : col >= width ? width - 1 : col;
+
+}
+
+//prints the phases nested in parent, by start time, each followed by its own nested phases
+static void _gn_boot_timeline_print(const gn_boot_timeline_phase_t *phases,
+		int n, int parent, int depth, double boot_us, int width, char *bar,
+		FILE *out) {
+
+	for (int i = 0; i < n; i++) {
+		const gn_boot_timeline_phase_t *p = &phases[i];
+		if (p->parent != parent)
+			continue;
+		int from = _gn_boot_timeline_column(p->start_us, boot_us, width);
+		int to = _gn_boot_timeline_column(p->end_us, boot_us, width);
+		memset(bar, ' ', width);
+		//phases entered several times show the span from the first begin to the last end
+		memset(bar + from, p->count > 1 ? '=' : '#', to - from + 1);
+		bar[width] = '\0';
+		fprintf(out, "%*s%-*s %10.1f %10.1f %5d  |%s|\n", depth * 2, "",
+				16 - depth * 2, p->name, p->start_us / 1000, p->total_us / 1000,
+				p->count, bar);
+		_gn_boot_timeline_print(phases, n, i, depth + 1, boot_us, width, bar,
+				out);
+	}
+
+}
+
+int gn_boot_timeline_render(const char *report, int width, FILE *out) {
+
+	if (!report || width <= 0)
+		return -1;
+
+	cJSON *root = cJSON_Parse(report);
+	if (!root)
+		return -1;
+
+	int ret = -1;
+	gn_boot_timeline_phase_t phases[GN_BOOT_TIMELINE_MAX_PHASES];
+	int n = 0;
+
+	cJSON *us = cJSON_GetObjectItemCaseSensitive(root, "us");
+	cJSON *list = cJSON_GetObjectItemCaseSensitive(root, "phases");
+	if (!cJSON_IsNumber(us) || !cJSON_IsArray(list))
+		goto end;
+
+	double boot_us = us->valuedouble;
+
+	cJSON *item;
+	cJSON_ArrayForEach(item, list)
+	{
+		if (n == GN_BOOT_TIMELINE_MAX_PHASES)
+			break;
+		cJSON *name = cJSON_GetArrayItem(item, 0);
+		cJSON *start = cJSON_GetArrayItem(item, 1);
+		cJSON *stop = cJSON_GetArrayItem(item, 2);
+		cJSON *total = cJSON_GetArrayItem(item, 3);
+		cJSON *count = cJSON_GetArrayItem(item, 4);
+		//reports without the enclosing phase show every phase at the top level
+		cJSON *parent = cJSON_GetArrayItem(item, 5);
+		if (!cJSON_IsString(name) || !cJSON_IsNumber(start)
+				|| !cJSON_IsNumber(stop) || !cJSON_IsNumber(total)
+				|| !cJSON_IsNumber(count) || (parent && !cJSON_IsString(parent)))
+			goto end;
+		phases[n++] = (gn_boot_timeline_phase_t ) { name->valuestring,
+						start->valuedouble, stop->valuedouble,
+						total->valuedouble, count->valueint,
+						parent ? parent->valuestring : "", -1 };
+	}
+
+	//report order is the phase enumeration, the timeline follows the start time
+	for (int i = 1; i < n; i++)
+		for (int j = i; j > 0 && phases[j].start_us < phases[j - 1].start_us;
+				j--) {
+			gn_boot_timeline_phase_t t = phases[j];
+			phases[j] = phases[j - 1];
+			phases[j - 1] = t;
+		}
+
+	//the nesting is the one recorded by the node, a loop in it is broken at the top level
+	for (int i = 0; i < n; i++)
+		for (int j = 0; j < n; j++)
+			if (j != i && strcmp(phases[i].parent_name, phases[j].name) == 0)
+				phases[i].parent = j;
+	for (int i = 0; i < n; i++) {
+		int hops = 0;
+		for (int j = phases[i].parent; j >= 0 && hops <= n; j = phases[j].parent)
+			hops++;
+		if (hops > n)
+			phases[i].parent = -1;
+	}
+
+	fprintf(out, "boot completed at %.1f ms, %d phases\n", boot_us / 1000, n);
+	fprintf(out, "%-16s %10s %10s %5s  |%*s|\n", "phase", "start ms",
+			"total ms", "n", width, "");
+
+	char *bar = malloc(width + 1);
+	if (!bar)
+		goto end;
+
+	_gn_boot_timeline_print(phases, n, -1, 0, boot_us, width, bar, out);
+
+	free(bar);
+	ret = 0;
+
+	end: cJSON_Delete(root);
+	return ret;
+
+}
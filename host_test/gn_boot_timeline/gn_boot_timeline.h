@@ -0,0 +1,38 @@
+// Copyright 2021 Nicola Muratori (nicola.muratori@gmail.com)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef GN_BOOT_TIMELINE_H_
+#define GN_BOOT_TIMELINE_H_
+
+#include <stdio.h>
+
+/*
+ * renders the boot report published by the boot profiler described in gn_boot.h
+ */
+
+#define GN_BOOT_TIMELINE_DEFAULT_WIDTH 60
+
+/**
+ * @brief	prints one line per phase with start, total time, count and a bar over the boot time.
+ * 			phases nested in others are indented
+ *
+ * @param	report	the JSON report, as published on $stats/boot or in the "boot" status message
+ * @param	width	columns of the bars
+ *
+ * @return	0 on success, -1 if the report cannot be parsed
+ */
+int gn_boot_timeline_render(const char *report, int width, FILE *out);
+
+#endif /* GN_BOOT_TIMELINE_H_ */
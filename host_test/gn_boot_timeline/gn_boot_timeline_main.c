@@ -0,0 +1,101 @@
+// Copyright 2021 Nicola Muratori (nicola.muratori@gmail.com)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+
+/*
+ * prints the boot report of a node as a timeline
+ *
+ * usage: gn_boot_timeline [-w <columns>] [<report>]
+ *   the report is read from the file or from stdin, text before the JSON object
+ *   (as the topic printed by mosquitto_sub -v) is skipped
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "gn_boot_timeline.h"
+
+static char* _gn_boot_timeline_read(FILE *f) {
+
+	char *data = NULL;
+	size_t len = 0, size = 0;
+	while (!feof(f) && !ferror(f)) {
+		if (len + 1 >= size) {
+			size = size ? size * 2 : 4096;
+			char *d = realloc(data, size);
+			if (!d)
+				break;
+			data = d;
+		}
+		len += fread(data + len, 1, size - len - 1, f);
+	}
+	if (!data || ferror(f) || !feof(f)) {
+		free(data);
+		return NULL;
+	}
+	data[len] = '\0';
+	return data;
+
+}
+
+int main(int argc, char **argv) {
+
+	int width = GN_BOOT_TIMELINE_DEFAULT_WIDTH;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "w:")) != -1) {
+		switch (opt) {
+		case 'w':
+			width = atoi(optarg);
+			break;
+		default:
+			fprintf(stderr, "usage: %s [-w <columns>] [<report>]\n", argv[0]);
+			return 2;
+		}
+	}
+
+	if (argc - optind > 1 || width <= 0) {
+		fprintf(stderr, "usage: %s [-w <columns>] [<report>]\n", argv[0]);
+		return 2;
+	}
+
+	FILE *f = stdin;
+	if (optind < argc) {
+		f = fopen(argv[optind], "r");
+		if (!f) {
+			perror(argv[optind]);
+			return 1;
+		}
+	}
+
+	char *report = _gn_boot_timeline_read(f);
+	if (f != stdin)
+		fclose(f);
+	if (!report) {
+		fprintf(stderr, "read error\n");
+		return 1;
+	}
+
+	char *json = strchr(report, '{');
+	int ret = gn_boot_timeline_render(json, width, stdout);
+	if (ret != 0)
+		fprintf(stderr, "not a boot report\n");
+	free(report);
+
+	return ret == 0 ? 0 : 1;
+
+}
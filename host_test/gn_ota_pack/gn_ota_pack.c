@@ -0,0 +1,296 @@
+// Copyright 2021 Nicola Muratori (nicola.muratori@gmail.com)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "mbedtls/sha256.h"
+
+#include "gn_ota.h"
+#include "gn_ota_pack.h"
+
+#define _GN_OTA_PACK_HASH_BITS 16
+#define _GN_OTA_PACK_LZ_HASH_BITS 12
+
+typedef struct {
+	uint8_t *data;
+	size_t len;
+	size_t size;
+} _gn_ota_pack_buf_t;
+
+static int _gn_ota_pack_put(_gn_ota_pack_buf_t *buf, const void *data,
+		size_t len) {
+
+	if (buf->len + len > buf->size) {
+		size_t size = buf->size ? buf->size : 4096;
+		while (size < buf->len + len)
+			size *= 2;
+		uint8_t *data = realloc(buf->data, size);
+		if (!data)
+			return -1;
+		buf->data = data;
+		buf->size = size;
+	}
+	memcpy(buf->data + buf->len, data, len);
+	buf->len += len;
+	return 0;
+
+}
+
+static int _gn_ota_pack_u32(_gn_ota_pack_buf_t *buf, uint32_t v) {
+	uint8_t b[4] = { v, v >> 8, v >> 16, v >> 24 };
+	return _gn_ota_pack_put(buf, b, sizeof(b));
+}
+
+static uint32_t _gn_ota_pack_hash(const uint8_t *data, size_t len, int bits) {
+	uint32_t h = 2166136261u;
+	for (size_t i = 0; i < len; i++)
+		h = (h ^ data[i]) * 16777619u;
+	return h >> (32 - bits);
+}
+
+static int _gn_ota_pack_insert(_gn_ota_pack_buf_t *buf, const uint8_t *data,
+		size_t len) {
+	if (len == 0)
+		return 0;
+	uint8_t op = GN_OTA_OP_INSERT;
+	if (_gn_ota_pack_put(buf, &op, 1) || _gn_ota_pack_u32(buf, len))
+		return -1;
+	return _gn_ota_pack_put(buf, data, len);
+}
+
+/**
+ * @brief	greedy delta: source blocks are indexed by hash, matches are extended both ways
+ */
+static int _gn_ota_pack_delta(const uint8_t *target, size_t target_len,
+		const uint8_t *source, size_t source_len, _gn_ota_pack_buf_t *buf) {
+
+	const size_t step = GN_OTA_PACK_INDEX_STEP;
+	size_t slots = (size_t) 1 << _GN_OTA_PACK_HASH_BITS;
+	int64_t *index = malloc(slots * sizeof(int64_t));
+	if (!index)
+		return -1;
+	for (size_t i = 0; i < slots; i++)
+		index[i] = -1;
+	for (size_t i = 0; i + step <= source_len; i += step) {
+		uint32_t h = _gn_ota_pack_hash(source + i, step,
+				_GN_OTA_PACK_HASH_BITS);
+		if (index[h] < 0)
+			index[h] = i;
+	}
+
+	int ret = 0;
+	size_t pending = 0; /*!< start of the bytes to insert */
+	size_t i = 0;
+	while (i + step <= target_len && ret == 0) {
+
+		int64_t s = index[_gn_ota_pack_hash(target + i, step,
+				_GN_OTA_PACK_HASH_BITS)];
+		if (s < 0 || memcmp(source + s, target + i, step) != 0) {
+			i++;
+			continue;
+		}
+
+		size_t src = s, dst = i, len = step;
+		while (dst > pending && src > 0 && source[src - 1] == target[dst - 1]) {
+			src--;
+			dst--;
+			len++;
+		}
+		while (src + len < source_len && dst + len < target_len
+				&& source[src + len] == target[dst + len])
+			len++;
+
+		if (len < GN_OTA_PACK_MIN_COPY) {
+			i++;
+			continue;
+		}
+
+		uint8_t op = GN_OTA_OP_COPY;
+		ret = _gn_ota_pack_insert(buf, target + pending, dst - pending);
+		if (ret == 0)
+			ret = _gn_ota_pack_put(buf, &op, 1) || _gn_ota_pack_u32(buf, src)
+					|| _gn_ota_pack_u32(buf, len);
+		i = pending = dst + len;
+
+	}
+
+	if (ret == 0)
+		ret = _gn_ota_pack_insert(buf, target + pending, target_len - pending);
+
+	free(index);
+	return ret;
+
+}
+
+/**
+ * @brief	LZSS codes one block, returns the packed length or 0 if it does not shrink
+ */
+static size_t _gn_ota_pack_lz_block(const uint8_t *in, size_t len,
+		uint8_t *out, int32_t *head, int32_t *prev) {
+
+	for (size_t i = 0; i < ((size_t) 1 << _GN_OTA_PACK_LZ_HASH_BITS); i++)
+		head[i] = -1;
+
+	size_t o = 0, flags_pos = 0;
+	int bit = 8;
+	size_t i = 0;
+
+	while (i < len) {
+
+		if (bit == 8) {
+			if (o + 1 + 16 >= len)
+				return 0;
+			flags_pos = o++;
+			out[flags_pos] = 0;
+			bit = 0;
+		}
+
+		size_t best_len = 0, best_off = 0;
+		if (i + GN_OTA_LZ_MIN_MATCH <= len) {
+			uint32_t h = _gn_ota_pack_hash(in + i, GN_OTA_LZ_MIN_MATCH,
+					_GN_OTA_PACK_LZ_HASH_BITS);
+			int32_t c = head[h];
+			for (int chain = 0;
+					c >= 0 && chain < GN_OTA_PACK_LZ_CHAIN
+							&& i - c <= GN_OTA_LZ_WINDOW_SIZE; chain++) {
+				size_t l = 0;
+				while (l < GN_OTA_LZ_MAX_MATCH && i + l < len
+						&& in[c + l] == in[i + l])
+					l++;
+				if (l > best_len) {
+					best_len = l;
+					best_off = i - c;
+					if (l == GN_OTA_LZ_MAX_MATCH)
+						break;
+				}
+				c = prev[c];
+			}
+		}
+
+		size_t advance = 1;
+		if (best_len >= GN_OTA_LZ_MIN_MATCH) {
+			out[o++] = (best_off - 1) & 0xFF;
+			out[o++] = (((best_off - 1) >> 8) << 4)
+					| (best_len - GN_OTA_LZ_MIN_MATCH);
+			advance = best_len;
+		} else {
+			out[flags_pos] |= 1 << bit;
+			out[o++] = in[i];
+		}
+		bit++;
+
+		for (size_t k = 0; k < advance; k++, i++) {
+			if (i + GN_OTA_LZ_MIN_MATCH > len)
+				continue;
+			uint32_t h = _gn_ota_pack_hash(in + i, GN_OTA_LZ_MIN_MATCH,
+					_GN_OTA_PACK_LZ_HASH_BITS);
+			prev[i] = head[h];
+			head[h] = i;
+		}
+
+	}
+
+	return o < len ? o : 0;
+
+}
+
+static int _gn_ota_pack_compress(const uint8_t *in, size_t len,
+		_gn_ota_pack_buf_t *buf) {
+
+	uint8_t *out = malloc(GN_OTA_BLOCK_SIZE);
+	int32_t *head = malloc(sizeof(int32_t) << _GN_OTA_PACK_LZ_HASH_BITS);
+	int32_t *prev = malloc(sizeof(int32_t) * GN_OTA_BLOCK_SIZE);
+	int ret = out && head && prev ? 0 : -1;
+
+	for (size_t pos = 0; pos < len && ret == 0; pos += GN_OTA_BLOCK_SIZE) {
+		size_t plain = len - pos < GN_OTA_BLOCK_SIZE ?
+				len - pos : GN_OTA_BLOCK_SIZE;
+		size_t packed = _gn_ota_pack_lz_block(in + pos, plain, out, head, prev);
+		uint8_t h[4] = { plain, plain >> 8, packed, packed >> 8 };
+		ret = _gn_ota_pack_put(buf, h, sizeof(h));
+		if (ret == 0)
+			ret = packed ?
+					_gn_ota_pack_put(buf, out, packed) :
+					_gn_ota_pack_put(buf, in + pos, plain);
+	}
+
+	free(out);
+	free(head);
+	free(prev);
+	return ret;
+
+}
+
+int gn_ota_pack(const uint8_t *target, size_t target_len,
+		const uint8_t *source, size_t source_len, bool compress, uint8_t **out,
+		size_t *out_len) {
+
+	if (!target || target_len == 0 || target_len > UINT32_MAX || !out
+			|| !out_len)
+		return -1;
+
+	//the node reports the digest appended to its image, hashing the .bin would never match it
+	uint8_t source_sha[GN_OTA_SHA256_SIZE];
+	if (source) {
+		if (source_len <= GN_OTA_SHA256_SIZE)
+			return -1;
+		mbedtls_sha256_ret(source, source_len - GN_OTA_SHA256_SIZE, source_sha,
+				0);
+		if (memcmp(source_sha, source + source_len - GN_OTA_SHA256_SIZE,
+				GN_OTA_SHA256_SIZE) != 0)
+			return -1;
+	}
+
+	_gn_ota_pack_buf_t payload = { 0 };
+	_gn_ota_pack_buf_t container = { 0 };
+	const uint8_t *plain = target;
+	size_t plain_len = target_len;
+	int ret = 0;
+
+	if (source) {
+		ret = _gn_ota_pack_delta(target, target_len, source, source_len,
+				&payload);
+		plain = payload.data;
+		plain_len = payload.len;
+	}
+
+	uint8_t h[8] = { 'G', 'N', 'O', 'T', GN_OTA_VERSION,
+			source ? GN_OTA_IMAGE_DELTA : GN_OTA_IMAGE_FULL,
+			compress ? GN_OTA_COMPRESSION_LZSS : GN_OTA_COMPRESSION_NONE, 0 };
+	uint8_t sha[GN_OTA_SHA256_SIZE * 2] = { 0 };
+	mbedtls_sha256_ret(target, target_len, sha, 0);
+	if (source)
+		memcpy(sha + GN_OTA_SHA256_SIZE, source_sha, GN_OTA_SHA256_SIZE);
+
+	if (ret == 0)
+		ret = _gn_ota_pack_put(&container, h, sizeof(h))
+				|| _gn_ota_pack_u32(&container, target_len)
+				|| _gn_ota_pack_put(&container, sha, sizeof(sha));
+	if (ret == 0)
+		ret = compress ?
+				_gn_ota_pack_compress(plain, plain_len, &container) :
+				_gn_ota_pack_put(&container, plain, plain_len);
+
+	free(payload.data);
+	if (ret != 0) {
+		free(container.data);
+		return -1;
+	}
+	*out = container.data;
+	*out_len = container.len;
+	return 0;
+
+}
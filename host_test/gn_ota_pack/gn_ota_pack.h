@@ -0,0 +1,49 @@
+// Copyright 2021 Nicola Muratori (nicola.muratori@gmail.com)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef GN_OTA_PACK_H_
+#define GN_OTA_PACK_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/*
+ * builds the GrowNode OTA containers described in gn_ota.h
+ */
+
+//shortest copy worth an operation
+#define GN_OTA_PACK_MIN_COPY 32
+//source is indexed every GN_OTA_PACK_INDEX_STEP bytes
+#define GN_OTA_PACK_INDEX_STEP 16
+//matches tried for each position when compressing
+#define GN_OTA_PACK_LZ_CHAIN 64
+
+/**
+ * @brief	packs the image
+ *
+ * @param	source	the image running on the node, NULL for a full image. the node identifies its
+ * 					firmware by the SHA-256 appended to the image by the build, so it must be the .bin as built
+ * @param	compress	LZSS compression of the payload
+ * @param	out	malloc'ed container, to be freed by the caller
+ *
+ * @return	0 on success
+ * @return	-1 on errors or if the source does not end with its SHA-256
+ */
+int gn_ota_pack(const uint8_t *target, size_t target_len,
+		const uint8_t *source, size_t source_len, bool compress, uint8_t **out,
+		size_t *out_len);
+
+#endif /* GN_OTA_PACK_H_ */
@@ -0,0 +1,124 @@
+// Copyright 2021 Nicola Muratori (nicola.muratori@gmail.com)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+/*
+ * builds a GrowNode OTA container from the application image
+ *
+ * usage: gn_ota_pack [-z] [-s <running image>] <new image> <container>
+ *   -z  LZSS compression
+ *   -s  delta against the image running on the nodes, the .bin as built with its appended SHA-256
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "gn_ota_pack.h"
+
+static uint8_t* _gn_ota_pack_read(const char *path, size_t *len) {
+
+	FILE *f = fopen(path, "rb");
+	if (!f) {
+		perror(path);
+		return NULL;
+	}
+
+	uint8_t *data = NULL;
+	size_t size = 0;
+	*len = 0;
+	while (!feof(f) && !ferror(f)) {
+		if (*len == size) {
+			size = size ? size * 2 : 65536;
+			uint8_t *d = realloc(data, size);
+			if (!d)
+				break;
+			data = d;
+		}
+		*len += fread(data + *len, 1, size - *len, f);
+	}
+	if (ferror(f) || !feof(f)) {
+		fprintf(stderr, "%s: read error\n", path);
+		free(data);
+		data = NULL;
+	}
+	fclose(f);
+	return data;
+
+}
+
+int main(int argc, char *argv[]) {
+
+	const char *source_path = NULL;
+	int compress = 0;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "zs:")) != -1) {
+		switch (opt) {
+		case 'z':
+			compress = 1;
+			break;
+		case 's':
+			source_path = optarg;
+			break;
+		default:
+			fprintf(stderr,
+					"usage: %s [-z] [-s <running image>] <new image> <container>\n",
+					argv[0]);
+			return 2;
+		}
+	}
+	if (argc - optind != 2) {
+		fprintf(stderr,
+				"usage: %s [-z] [-s <running image>] <new image> <container>\n",
+				argv[0]);
+		return 2;
+	}
+
+	size_t target_len = 0, source_len = 0, out_len = 0;
+	uint8_t *source = NULL, *out = NULL;
+	uint8_t *target = _gn_ota_pack_read(argv[optind], &target_len);
+	if (!target)
+		return 1;
+	if (source_path && !(source = _gn_ota_pack_read(source_path, &source_len))) {
+		free(target);
+		return 1;
+	}
+
+	int ret = gn_ota_pack(target, target_len, source, source_len, compress,
+			&out, &out_len);
+	if (ret == 0) {
+		FILE *f = fopen(argv[optind + 1], "wb");
+		if (!f || fwrite(out, 1, out_len, f) != out_len) {
+			perror(argv[optind + 1]);
+			ret = 1;
+		}
+		if (f && fclose(f) != 0)
+			ret = 1;
+	} else {
+		fprintf(stderr, "cannot pack %s%s\n", argv[optind],
+				source ? ", is the running image a .bin with appended SHA-256?" : "");
+	}
+
+	if (ret == 0)
+		printf("%s: %zu bytes, %.1f%% of the image\n", argv[optind + 1],
+				out_len, 100.0 * out_len / target_len);
+
+	free(target);
+	free(source);
+	free(out);
+	return ret ? 1 : 0;
+
+}
@@ -13,10 +13,14 @@
 // limitations under the License.
 
 #include <limits.h>
+#include <stdio.h>
 #include <string.h>
+#include <time.h>
 
 #include "unity.h"
 #include "gn_leaf_context.h"
+#include "gn_string_arena.h"
+#include "cc_hashtable.h"
 
 #include "esp_log.h"
 
@@ -168,6 +172,187 @@ void test_gn_leaf_context_delete() {
 
 }
 
+void test_gn_leaf_context_order() {
+
+	context = gn_leaf_context_create(4);
+
+	gn_leaf_context_set(context, "key 1", "value 1");
+	gn_leaf_context_set(context, "key 2", "value 2");
+	gn_leaf_context_set(context, "key 3", "value 3");
+	gn_leaf_context_set(context, "key 2", "value 2 modified");
+
+	//keys are returned in insertion order, updates keep the position
+	TEST_ASSERT(strcmp("key 1", gn_leaf_context_get_key_at(context, 0)) == 0);
+	TEST_ASSERT(strcmp("key 2", gn_leaf_context_get_key_at(context, 1)) == 0);
+	TEST_ASSERT(strcmp("key 3", gn_leaf_context_get_key_at(context, 2)) == 0);
+	TEST_ASSERT(gn_leaf_context_get_key_at(context, 3) == NULL);
+
+	gn_leaf_context_delete(context, "key 2");
+	TEST_ASSERT(gn_leaf_context_size(context) == 2);
+	TEST_ASSERT(strcmp("key 1", gn_leaf_context_get_key_at(context, 0)) == 0);
+	TEST_ASSERT(strcmp("key 3", gn_leaf_context_get_key_at(context, 1)) == 0);
+	TEST_ASSERT(strcmp("value 3", gn_leaf_context_get(context, "key 3")) == 0);
+
+	gn_leaf_context_destroy(context);
+
+}
+
+void test_gn_leaf_context_grow() {
+
+	const int entries = 200;
+	static char keys[200][64];
+
+	context = gn_leaf_context_create(2);
+
+	//short keys are copied, long keys are referenced
+	for (int i = 0; i < entries; i++) {
+		snprintf(keys[i], sizeof(keys[i]),
+				i % 2 ? "k%d" : "/grownode/test/node/leaf/param%d/cmd", i);
+		TEST_ASSERT(gn_leaf_context_set(context, keys[i], keys[i]) != NULL);
+	}
+	TEST_ASSERT(gn_leaf_context_size(context) == entries);
+
+	for (int i = 0; i < entries; i++) {
+		char key[64];
+		strcpy(key, keys[i]);
+		TEST_ASSERT(gn_leaf_context_get(context, key) == keys[i]);
+		TEST_ASSERT(strcmp(gn_leaf_context_get_key_at(context, i), keys[i]) == 0);
+	}
+	TEST_ASSERT(gn_leaf_context_get(context, "k0") == NULL);
+
+	gn_leaf_context_destroy(context);
+
+}
+
+void test_gn_string_arena_add() {
+
+	gn_string_arena_handle_t arena = gn_string_arena_create(16);
+
+	TEST_ASSERT(arena != NULL);
+	TEST_ASSERT(gn_string_arena_used(arena) == 0);
+
+	const char *s1 = gn_string_arena_add(arena, "homie/node");
+	const char *s2 = gn_string_arena_add(arena, "homie/node/leaf");
+	const char *s3 = gn_string_arena_add(arena,
+			"a string longer than the chunk size");
+
+	TEST_ASSERT(s1 != NULL && s2 != NULL && s3 != NULL);
+	//previous strings are not moved when the arena grows
+	TEST_ASSERT(strcmp(s1, "homie/node") == 0);
+	TEST_ASSERT(strcmp(s2, "homie/node/leaf") == 0);
+	TEST_ASSERT(strcmp(s3, "a string longer than the chunk size") == 0);
+
+	TEST_ASSERT(gn_string_arena_used(arena) == 11 + 16 + 36);
+	TEST_ASSERT(
+			gn_string_arena_footprint(arena) > gn_string_arena_used(arena));
+
+	TEST_ASSERT(gn_string_arena_add(arena, NULL) == NULL);
+
+	gn_string_arena_destroy(arena);
+
+}
+
+void test_gn_string_arena_printf() {
+
+	gn_string_arena_handle_t arena = gn_string_arena_create(0);
+
+	const char *topic = gn_string_arena_printf(arena, "homie/%s/%s/%s/set",
+			"node", "leaf", "param");
+
+	TEST_ASSERT(topic != NULL);
+	TEST_ASSERT(strcmp(topic, "homie/node/leaf/param/set") == 0);
+	TEST_ASSERT(gn_string_arena_used(arena) == strlen(topic) + 1);
+
+	gn_string_arena_destroy(arena);
+
+}
+
+static double _elapsed_ns(struct timespec *start, struct timespec *end) {
+	return (end->tv_sec - start->tv_sec) * 1e9
+			+ (end->tv_nsec - start->tv_nsec);
+}
+
+static char* _cc_hashtable_get_key_at(CC_HashTable *table, size_t index) {
+
+	CC_HashTableIter iterator;
+	cc_hashtable_iter_init(&iterator, table);
+
+	size_t i = 0;
+	TableEntry *next_entry;
+	while (cc_hashtable_iter_next(&iterator, &next_entry) != CC_ITER_END) {
+		if (i++ == index)
+			return (char*) next_entry->key;
+	}
+	return NULL;
+
+}
+
+/*
+ * command topic dispatch and indexed access: the leaf context against the collections-c
+ * hashtable it replaced, on the number of topics of a mid sized node
+ */
+void test_gn_leaf_context_benchmark() {
+
+	const int iterations = 100000;
+	const int entries = 32;
+	static char keys[32][64];
+	volatile size_t sink = 0;
+	struct timespec start, end;
+
+	CC_HashTable *table;
+	CC_HashTableConf config;
+	cc_hashtable_conf_init(&config);
+	config.key_length = KEY_LENGTH_VARIABLE;
+	config.hash = STRING_HASH;
+	config.key_compare = CC_CMP_STRING;
+	TEST_ASSERT(cc_hashtable_new_conf(&config, &table) == CC_OK);
+
+	context = gn_leaf_context_create(entries);
+
+	for (int i = 0; i < entries; i++) {
+		snprintf(keys[i], sizeof(keys[i]), "homie/node/leaf%d/param%d/set",
+				i / 4, i % 4);
+		cc_hashtable_add(table, keys[i], keys[i]);
+		gn_leaf_context_set(context, keys[i], keys[i]);
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (int i = 0; i < iterations; i++) {
+		void *out = NULL;
+		cc_hashtable_get(table, keys[i % entries], &out);
+		sink += (size_t) out;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	double cc_get_ns = _elapsed_ns(&start, &end) / iterations;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (int i = 0; i < iterations; i++)
+		sink += (size_t) gn_leaf_context_get(context, keys[i % entries]);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	double get_ns = _elapsed_ns(&start, &end) / iterations;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (int i = 0; i < iterations; i++)
+		sink += (size_t) _cc_hashtable_get_key_at(table, i % entries);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	double cc_key_at_ns = _elapsed_ns(&start, &end) / iterations;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (int i = 0; i < iterations; i++)
+		sink += (size_t) gn_leaf_context_get_key_at(context, i % entries);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	double key_at_ns = _elapsed_ns(&start, &end) / iterations;
+
+	ESP_LOGI(TAG,
+			"benchmark leaf context %d entries: get %.1f ns (hashtable %.1f ns), get_key_at %.1f ns (hashtable %.1f ns)",
+			entries, get_ns, cc_get_ns, key_at_ns, cc_key_at_ns);
+	TEST_ASSERT(key_at_ns <= cc_key_at_ns);
+
+	cc_hashtable_destroy(table);
+	gn_leaf_context_destroy(context);
+
+}
+
 int main(int argc, char **argv) {
 	UNITY_BEGIN();
 
@@ -191,6 +376,16 @@ int main(int argc, char **argv) {
 	RUN_TEST(test_gn_leaf_context_add);
 	ESP_LOGI(TAG, " * * * * * test_gn_leaf_context_delete");
 	RUN_TEST(test_gn_leaf_context_delete);
+	ESP_LOGI(TAG, " * * * * * test_gn_leaf_context_order");
+	RUN_TEST(test_gn_leaf_context_order);
+	ESP_LOGI(TAG, " * * * * * test_gn_leaf_context_grow");
+	RUN_TEST(test_gn_leaf_context_grow);
+	ESP_LOGI(TAG, " * * * * * test_gn_leaf_context_benchmark");
+	RUN_TEST(test_gn_leaf_context_benchmark);
+	ESP_LOGI(TAG, " * * * * * test_gn_string_arena_add");
+	RUN_TEST(test_gn_string_arena_add);
+	ESP_LOGI(TAG, " * * * * * test_gn_string_arena_printf");
+	RUN_TEST(test_gn_string_arena_printf);
 
 
 	ESP_LOGI(TAG, "------ HOST TEST GROWNODE END -------");
@@ -0,0 +1,77 @@
+// Copyright 2021 Nicola Muratori (nicola.muratori@gmail.com)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * configuration of the host simulation build, mirroring the Kconfig defaults of a networked node.
+ * the MQTT backend is selected by GN_SIM_MQTT_HOMIE, defined by the build for the homie executable,
+ * the latency tracer, the runtime statistics, the heap accounting, the ADC sampling and the boot
+ * profiler by GN_SIM_LATENCY_TRACE, GN_SIM_RUNTIME_STATS, GN_SIM_MEM_ACCOUNTING, GN_SIM_ADC_SAMPLING
+ * and GN_SIM_BOOT_PROFILE, defined for the tests and not for the benchmarks
+ */
+
+#pragma once
+
+#define CONFIG_IDF_TARGET_ESP32 1
+
+#define CONFIG_LOG_DEFAULT_LEVEL 3
+
+#define CONFIG_GROWNODE_WIFI_ENABLED 1
+#define CONFIG_GROWNODE_PROV_TRANSPORT_SOFTAP 1
+#define CONFIG_GROWNODE_PROV_TRANSPORT 2
+#define CONFIG_GROWNODE_PROV_SOFTAP_PREFIX "GROWNODE_"
+//room for the test leaf the simulation adds to the board config
+#define CONFIG_GROWNODE_MQTT_BUFFER_SIZE 8192
+#define CONFIG_GROWNODE_SAMPLER_STACK_SIZE 4096
+#define CONFIG_GROWNODE_SCHEDULER_STACK_SIZE 4096
+#define CONFIG_GROWNODE_I2C_STACK_SIZE 4096
+//short delays and frequent checkpoints for the interrupted downloads of the OTA test
+#define CONFIG_GROWNODE_OTA_RETRIES 3
+#define CONFIG_GROWNODE_OTA_RETRY_DELAY_MS 10
+#define CONFIG_GROWNODE_OTA_CHECKPOINT_KB 16
+//the broker keeps the node session across the sleeps of the persistent session test
+#define CONFIG_GROWNODE_MQTT_PERSISTENT_SESSION 1
+
+#ifdef GN_SIM_MQTT_HOMIE
+#define CONFIG_GROWNODE_MQTT_HOMIE_PROTOCOL 1
+#define CONFIG_GROWNODE_MQTT_HOMIE_INCREMENTAL_ANNOUNCE 1
+#else
+#define CONFIG_GROWNODE_MQTT_LEGACY_PROTOCOL 1
+//the legacy backend routes parameter commands only through the node wildcards
+#define CONFIG_GROWNODE_MQTT_WILDCARD_SUBSCRIPTION 1
+#endif
+
+#ifdef GN_SIM_LATENCY_TRACE
+#define CONFIG_GROWNODE_LATENCY_TRACE 1
+#endif
+
+#ifdef GN_SIM_RUNTIME_STATS
+#define CONFIG_GROWNODE_RUNTIME_STATS 1
+#define CONFIG_GROWNODE_RUNTIME_STATS_INTERVAL_SEC 60
+#endif
+
+#ifdef GN_SIM_MEM_ACCOUNTING
+#define CONFIG_GROWNODE_MEM_ACCOUNTING 1
+#define CONFIG_GROWNODE_MEM_ACCOUNTING_TAGS 32
+#endif
+
+#ifdef GN_SIM_ADC_SAMPLING
+#define CONFIG_GROWNODE_ADC_SAMPLING 1
+#define CONFIG_GROWNODE_ADC_SAMPLE_FREQ_HZ 20000
+#define CONFIG_GROWNODE_ADC_WINDOW 32
+#endif
+
+#ifdef GN_SIM_BOOT_PROFILE
+#define CONFIG_GROWNODE_BOOT_PROFILE 1
+#define CONFIG_GROWNODE_BOOT_PROFILE_GPIO 13
+#endif
@@ -0,0 +1,444 @@
+// Copyright 2021 Nicola Muratori (nicola.muratori@gmail.com)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * micro benchmarks of the core calls on the host simulator: parameter access, leaf events,
+ * MQTT topic routing, storage and payload conversion. each node size runs in its own process,
+ * as a node can be started only once, and every result is a JSON object on its own line.
+ *
+ * usage: bench_grownode_sim_<protocol> [-l leaves -p params] [-n iterations] [-o file]
+ *
+ * without -l and -p the whole leaves x params matrix is run
+ */
+
+#define _GNU_SOURCE
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "esp_log.h"
+
+#include "gn_sim.h"
+
+#include "grownode.h"
+#include "grownode_intl.h"
+#include "gn_mqtt_protocol.h"
+
+static const char *TAG = "bench_grownode_sim";
+
+#define GN_SIM_BENCH_ITERATIONS 2000
+#define GN_SIM_BENCH_STARTUP_TIMEOUT_MS 60000
+//time left to the leaves and the event loop to drain queued work between benchmarks
+#define GN_SIM_BENCH_SETTLE_MS 100
+
+#ifdef CONFIG_GROWNODE_MQTT_HOMIE_PROTOCOL
+#define GN_SIM_BENCH_PROTOCOL "homie"
+//routing lookups of the protocols, not exported in headers
+gn_leaf_param_handle_intl_t _gn_homie_param_from_set_topic(
+		gn_node_handle_intl_t node, char *topic, int topic_len);
+#define _gn_sim_bench_route(node, topic, len) _gn_homie_param_from_set_topic(node, (char*) topic, len)
+void _gn_homie_mk_topic_param(char *topic,
+		const gn_leaf_param_handle_intl_t param);
+#define _gn_sim_bench_build_topic(param, buf) _gn_homie_mk_topic_param(buf, param)
+#else
+#define GN_SIM_BENCH_PROTOCOL "legacy"
+gn_leaf_param_handle_intl_t _gn_mqtt_param_from_topic(gn_node_handle_intl_t node,
+		const char *topic, int topic_len);
+#define _gn_sim_bench_route(node, topic, len) _gn_mqtt_param_from_topic(node, topic, len)
+void _gn_mqtt_build_leaf_parameter_status_topic(gn_leaf_handle_t _leaf_config,
+		char *param_name, char *buf);
+#define _gn_sim_bench_build_topic(param, buf) _gn_mqtt_build_leaf_parameter_status_topic(param->leaf, param->name, buf)
+#endif
+
+static const int _matrix_leaves[] = { 1, 8, 64 };
+static const int _matrix_params[] = { 1, 8, 32 };
+
+static int leaves = 0;
+static int params = 0;
+static int iterations = GN_SIM_BENCH_ITERATIONS;
+
+static gn_node_handle_t node;
+//the last leaf and its last parameters of each type, the slowest to look up
+static gn_leaf_handle_t leaf;
+static gn_leaf_param_handle_intl_t param_bool;
+static gn_leaf_param_handle_intl_t param_double;
+//keeps the topic benchmarks from being optimized away
+static volatile size_t topic_len;
+
+//allocations, counted only while a benchmark runs
+
+static volatile bool counting;
+static uint64_t allocs;
+static uint64_t alloc_bytes;
+
+extern void* __libc_malloc(size_t size);
+extern void* __libc_calloc(size_t n, size_t size);
+extern void* __libc_realloc(void *ptr, size_t size);
+extern void __libc_free(void *ptr);
+
+static inline void _count(size_t size) {
+	if (counting) {
+		__atomic_add_fetch(&allocs, 1, __ATOMIC_RELAXED);
+		__atomic_add_fetch(&alloc_bytes, size, __ATOMIC_RELAXED);
+	}
+}
+
+void* malloc(size_t size) {
+	_count(size);
+	return __libc_malloc(size);
+}
+
+void* calloc(size_t n, size_t size) {
+	_count(n * size);
+	return __libc_calloc(n, size);
+}
+
+void* realloc(void *ptr, size_t size) {
+	_count(size);
+	return __libc_realloc(ptr, size);
+}
+
+void free(void *ptr) {
+	__libc_free(ptr);
+}
+
+//benchmark leaf, with params alternating a boolean and a double
+
+static gn_leaf_descriptor_handle_t _bench_leaf_config(
+		gn_leaf_handle_t leaf_config);
+
+static void _bench_leaf_task(gn_leaf_handle_t leaf_config) {
+
+	gn_leaf_parameter_event_t evt;
+
+	while (true) {
+
+		if (gn_leaf_receive_event(&evt, leaf_config, GN_MAX_EVENT_WAIT_MS)
+				!= GN_RET_OK || evt.id != GN_LEAF_PARAM_CHANGE_REQUEST_EVENT)
+			continue;
+
+		//applies the change as an actuator leaf would
+		if (evt.param_name[0] == 'b') {
+			bool val;
+			if (gn_event_payload_to_bool(evt, &val) == GN_RET_OK)
+				gn_leaf_param_force_bool(leaf_config, evt.param_name, val);
+		} else {
+			double val;
+			if (gn_event_payload_to_double(evt, &val) == GN_RET_OK)
+				gn_leaf_param_force_double(leaf_config, evt.param_name, val);
+		}
+
+	}
+
+}
+
+static gn_leaf_descriptor_handle_t _bench_leaf_config(
+		gn_leaf_handle_t leaf_config) {
+
+	gn_leaf_descriptor_handle_t descriptor =
+			(gn_leaf_descriptor_handle_t) malloc(sizeof(gn_leaf_descriptor_t));
+	strncpy(descriptor->type, "bench", GN_LEAF_DESC_TYPE_SIZE);
+	descriptor->callback = _bench_leaf_task;
+	descriptor->data = NULL;
+
+	char name[GN_LEAF_PARAM_NAME_SIZE];
+	for (int i = 0; i < params; i++) {
+		bool is_bool = i % 2 == 0;
+		snprintf(name, sizeof(name), "%c%d", is_bool ? 'b' : 'd', i);
+		gn_leaf_param_handle_t param = gn_leaf_param_create(leaf_config, name,
+				is_bool ? GN_VAL_TYPE_BOOLEAN : GN_VAL_TYPE_DOUBLE,
+				is_bool ? (gn_val_t ) { .b = false } : (gn_val_t ) { .d = 0 },
+				GN_LEAF_PARAM_ACCESS_ALL, GN_LEAF_PARAM_STORAGE_VOLATILE, NULL);
+		gn_leaf_param_add_to_leaf(leaf_config, param);
+		if (is_bool)
+			param_bool = (gn_leaf_param_handle_intl_t) param;
+		else
+			param_double = (gn_leaf_param_handle_intl_t) param;
+	}
+
+	descriptor->status = GN_LEAF_STATUS_INITIALIZED;
+	return descriptor;
+
+}
+
+//measurement
+
+typedef void (*_bench_fn_t)(int i);
+
+static uint64_t _now_ns() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void _bench_run(const char *name, _bench_fn_t fn) {
+
+	//warm up lazily allocated buffers
+	for (int i = 0; i < iterations / 10 + 1; i++)
+		fn(i);
+	vTaskDelay(GN_SIM_BENCH_SETTLE_MS / portTICK_PERIOD_MS);
+
+	allocs = 0;
+	alloc_bytes = 0;
+	counting = true;
+	uint64_t start = _now_ns();
+
+	for (int i = 0; i < iterations; i++)
+		fn(i);
+
+	uint64_t elapsed = _now_ns() - start;
+	//work queued to other tasks is charged to the benchmark that caused it
+	vTaskDelay(GN_SIM_BENCH_SETTLE_MS / portTICK_PERIOD_MS);
+	counting = false;
+
+	printf("{\"bench\":\"%s\",\"protocol\":\"%s\",\"leaves\":%d,\"params\":%d,"
+			"\"iterations\":%d,\"ns_per_op\":%.1f,\"allocs_per_op\":%.2f,"
+			"\"bytes_per_op\":%.1f}\n", name, GN_SIM_BENCH_PROTOCOL, leaves,
+			params, iterations, (double) elapsed / iterations,
+			(double) allocs / iterations, (double) alloc_bytes / iterations);
+	fflush(stdout);
+
+}
+
+static void _bench_param_get_bool(int i) {
+	bool val;
+	gn_leaf_param_get_bool(leaf, param_bool->name, &val);
+}
+
+static void _bench_param_get_double(int i) {
+	double val;
+	gn_leaf_param_get_double(leaf, param_double->name, &val);
+}
+
+static void _bench_param_force_bool(int i) {
+	gn_leaf_param_force_bool(leaf, param_bool->name, i % 2 == 0);
+}
+
+static void _bench_param_force_double(int i) {
+	gn_leaf_param_force_double(leaf, param_double->name, i);
+}
+
+static void _bench_param_set_bool(int i) {
+	gn_leaf_param_set_bool(leaf, param_bool->name, i % 2 == 0);
+}
+
+static void _bench_param_set_double(int i) {
+	gn_leaf_param_set_double(leaf, param_double->name, i);
+}
+
+static void _bench_send_event_to_leaf(int i) {
+	//an event the leaf discards, to measure the queue and not the leaf
+	gn_leaf_parameter_event_t evt = { .id = GN_LEAF_PARAM_CHANGED_EVENT,
+			.data_len = 1 };
+	strcpy(evt.leaf_name, ((gn_leaf_handle_intl_t) leaf)->name);
+	strcpy(evt.param_name, param_bool->name);
+	_gn_send_event_to_leaf((gn_leaf_handle_intl_t) leaf, &evt);
+}
+
+static void _bench_leaf_parameter_update(int i) {
+	bool val = i % 2 == 0;
+	_gn_leaf_parameter_update(leaf, param_bool->name, &val, sizeof(val));
+}
+
+static void _bench_mqtt_route(int i) {
+	_gn_sim_bench_route((gn_node_handle_intl_t) node, param_bool->topic_cmd,
+			strlen(param_bool->topic_cmd));
+}
+
+//per publish cost of the status topic: built as the protocols did before storing it, or read back
+static void _bench_topic_build(int i) {
+	char buf[_GN_MQTT_MAX_TOPIC_LENGTH];
+	_gn_sim_bench_build_topic(param_bool, buf);
+	topic_len += strlen(buf);
+}
+
+static void _bench_topic_stored(int i) {
+	topic_len += strlen(param_bool->topic_sts);
+}
+
+static void _bench_storage_set(int i) {
+	gn_storage_set("bench_storage", &i, sizeof(i));
+}
+
+static void _bench_storage_get(int i) {
+	void *val = NULL;
+	if (gn_storage_get("bench_storage", &val) == GN_RET_OK)
+		free(val);
+}
+
+static void _bench_payload_bool(int i) {
+	gn_leaf_parameter_event_t evt;
+	bool val;
+	gn_bool_to_event_payload(i % 2 == 0, &evt);
+	gn_event_payload_to_bool(evt, &val);
+}
+
+static void _bench_payload_double(int i) {
+	gn_leaf_parameter_event_t evt;
+	double val;
+	gn_double_to_event_payload(i, &evt);
+	gn_event_payload_to_double(evt, &val);
+}
+
+static int _bench_node() {
+
+	//gn_init() keeps the pointer, it must outlive the node
+	static gn_config_init_param_t config_init = { //
+			.provisioning_security = true, //
+					.provisioning_password = "grownode", //
+					.wifi_retries_before_reset_provisioning = -1, //
+					.server_board_id_topic = false, //
+					.server_base_topic = "gn_sim", //
+					.server_url = "mqtt://127.0.0.1:1883", //
+					.server_keepalive_timer_sec = 60, //
+					.server_discovery = false, //
+					.server_discovery_prefix = "homeassistant", //
+					.firmware_url = "", //
+					.sntp_url = "pool.ntp.org", //
+					.wakeup_time_millisec = 5000LL, //
+					.sleep_delay_millisec = 50LL, //
+					.sleep_time_millisec = 10000LL, //
+					.sleep_mode = GN_SLEEP_MODE_NONE, //
+					.timezone = "CET-1CEST,M3.5.0,M10.5.0/3" };
+
+	esp_log_level_set("*", ESP_LOG_WARN);
+
+	gn_config_handle_t config = gn_init(&config_init);
+	if (!config)
+		return 1;
+
+	int waited_ms = 0;
+	while (gn_get_status(config) != GN_NODE_STATUS_READY_TO_START
+			&& waited_ms < GN_SIM_BENCH_STARTUP_TIMEOUT_MS) {
+		vTaskDelay(10 / portTICK_PERIOD_MS);
+		waited_ms += 10;
+	}
+
+	node = gn_node_create(config, "bench");
+	if (!node)
+		return 1;
+
+	char name[GN_LEAF_NAME_SIZE];
+	for (int i = 0; i < leaves; i++) {
+		snprintf(name, sizeof(name), "leaf%d", i);
+		leaf = gn_leaf_create(node, name, _bench_leaf_config, 4096,
+				GN_LEAF_TASK_PRIORITY);
+		if (!leaf)
+			return 1;
+	}
+
+	if (gn_node_start(node) != GN_RET_OK
+			|| gn_get_status(config) != GN_NODE_STATUS_STARTED) {
+		ESP_LOGE(TAG, "node with %d leaves and %d params not started", leaves,
+				params);
+		return 1;
+	}
+
+	_bench_run("param_get_bool", _bench_param_get_bool);
+	_bench_run("param_force_bool", _bench_param_force_bool);
+	_bench_run("param_set_bool", _bench_param_set_bool);
+	//a single param per leaf is the boolean one
+	if (param_double) {
+		_bench_run("param_get_double", _bench_param_get_double);
+		_bench_run("param_force_double", _bench_param_force_double);
+		_bench_run("param_set_double", _bench_param_set_double);
+	}
+	_bench_run("send_event_to_leaf", _bench_send_event_to_leaf);
+	_bench_run("leaf_parameter_update", _bench_leaf_parameter_update);
+	_bench_run("mqtt_route", _bench_mqtt_route);
+	_bench_run("topic_build", _bench_topic_build);
+	_bench_run("topic_stored", _bench_topic_stored);
+	_bench_run("storage_set", _bench_storage_set);
+	_bench_run("storage_get", _bench_storage_get);
+	_bench_run("payload_bool", _bench_payload_bool);
+	_bench_run("payload_double", _bench_payload_double);
+
+	return 0;
+
+}
+
+int main(int argc, char **argv) {
+
+	int opt;
+	while ((opt = getopt(argc, argv, "l:p:n:o:")) != -1) {
+		switch (opt) {
+		case 'l':
+			leaves = atoi(optarg);
+			break;
+		case 'p':
+			params = atoi(optarg);
+			break;
+		case 'n':
+			iterations = atoi(optarg);
+			break;
+		case 'o':
+			if (!freopen(optarg, "w", stdout)) {
+				ESP_LOGE(TAG, "cannot write %s", optarg);
+				return 1;
+			}
+			break;
+		default:
+			fprintf(stderr,
+					"usage: %s [-l leaves -p params] [-n iterations] [-o file]\n",
+					argv[0]);
+			return 1;
+		}
+	}
+
+	if (iterations <= 0 || leaves < 0 || leaves > GN_NODE_LEAF_MAX_SIZE
+			|| params < 0) {
+		ESP_LOGE(TAG, "invalid arguments");
+		return 1;
+	}
+
+	if (leaves > 0 && params > 0)
+		return _bench_node();
+
+	//the simulator threads start with the node, so every size gets a fresh process
+	for (int l = 0; l < sizeof(_matrix_leaves) / sizeof(_matrix_leaves[0]);
+			l++) {
+		for (int p = 0; p < sizeof(_matrix_params) / sizeof(_matrix_params[0]);
+				p++) {
+
+			leaves = _matrix_leaves[l];
+			params = _matrix_params[p];
+			ESP_LOGI(TAG, "node with %d leaves, %d params", leaves, params);
+
+			fflush(stdout);
+			pid_t pid = fork();
+			if (pid == 0)
+				_exit(_bench_node());
+
+			int status;
+			if (pid < 0 || waitpid(pid, &status, 0) != pid
+					|| !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+				ESP_LOGE(TAG, "benchmark with %d leaves, %d params failed",
+						leaves, params);
+				return 1;
+			}
+
+		}
+	}
+
+	return 0;
+
+}
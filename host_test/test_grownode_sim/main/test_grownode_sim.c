@@ -0,0 +1,2443 @@
+// Copyright 2021 Nicola Muratori (nicola.muratori@gmail.com)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * runs a real board configuration on the host simulator: the node connects to the loopback
+ * broker, commands are sent as a remote client would and the effect is read back from the
+ * simulated actuators. throughput, latency and memory are logged for each run.
+ *
+ * usage: test_grownode_sim_<protocol> <board>
+ */
+
+#include <inttypes.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include "unity.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_system.h"
+#include "driver/adc.h"
+
+#include "gn_sim.h"
+
+#include "grownode.h"
+#include "grownode_intl.h"
+#include "gn_mqtt_protocol.h"
+#include "gn_adc.h"
+#include "gn_sampler.h"
+#include "gn_i2c.h"
+#include "gn_filter.h"
+#include "gn_calibration.h"
+#include "gn_rules.h"
+#include "gn_scheduler.h"
+#include "gn_leaf_scheduler.h"
+#include "gn_display_binding.h"
+#include "gn_ota.h"
+#include "gn_ota_pack.h"
+#include "mbedtls/sha256.h"
+#include "gn_boot.h"
+#include "gn_boot_timeline.h"
+#include "gn_gpio.h"
+#include "gn_ds18b20.h"
+#include "gn_leaf_exporter.h"
+#include "gn_leaf_ina219.h"
+#include "gn_hydroboard2.h"
+#include "gn_nft2.h"
+
+static const char *TAG = "test_grownode_sim";
+
+#define GN_SIM_TEST_COMMANDS 200
+#define GN_SIM_TEST_COMMAND_TIMEOUT_MS 1000
+#define GN_SIM_TEST_STARTUP_TIMEOUT_MS 30000
+#define GN_SIM_TEST_HEAP_GROWTH_MAX (16 * 1024)
+#define GN_SIM_TEST_EXPORTER_TIMEOUT_MS 2000
+#define GN_SIM_TEST_DS18B20_PROBE_PERIOD_US 10000
+#define GN_SIM_TEST_DS18B20_LATENESS_MAX_US 200000
+#define GN_SIM_TEST_SAMPLER_PERIOD_US 100000
+#define GN_SIM_TEST_SAMPLER_RUN_MS 1050
+#define GN_SIM_TEST_SAMPLER_TOLERANCE_US 5000
+#define GN_SIM_TEST_I2C_PORT 1
+#define GN_SIM_TEST_I2C_SDA 18
+#define GN_SIM_TEST_I2C_SCL 5
+#define GN_SIM_TEST_I2C_TIMEOUT_MS 1000
+#define GN_SIM_TEST_INA219_ADDR 0x40
+#define GN_SIM_TEST_INA219_SDA 21
+#define GN_SIM_TEST_INA219_SCL 22
+#define GN_SIM_TEST_INA219_INTERVAL_MS 20
+#define GN_SIM_TEST_INA219_TIMEOUT_MS 2000
+#define GN_SIM_TEST_FILTER_TIMEOUT_MS 1000
+#define GN_SIM_TEST_OTA_URL "https://updates.local/grownode.bin"
+#define GN_SIM_TEST_OTA_IMAGE_SIZE (200 * 1024)
+#define GN_SIM_TEST_OTA_HEAP_MAX (24 * 1024)
+
+typedef struct {
+	const char *name;
+	void (*configure)(gn_node_handle_t node);
+	const char *gpio_leaf; /*!< a gpio leaf of the board, used as command target */
+	int gpio;
+	bool inverted;
+	const char *temp_leaf; /*!< the ds18b20 leaf of the board */
+	int temp_gpio;
+} gn_sim_test_board_t;
+
+static const gn_sim_test_board_t _boards[] = { //
+		{ "hydroboard2", gn_configure_hydroboard2, "lig_1", 25, true, "temps",
+				4 }, //
+				{ "nft2", gn_configure_nft2, "led", 19, true, "ds18b20", 4 } };
+
+static const gn_sim_test_board_t *board;
+
+static gn_config_handle_t config;
+static gn_node_handle_t node;
+
+static SemaphoreHandle_t gpio_changed;
+static volatile int gpio_level = -1;
+
+static volatile uint32_t published;
+
+static char cmd_topic[128];
+
+#ifdef CONFIG_GROWNODE_BOOT_PROFILE
+//edges of the boot profile pin
+static volatile uint32_t boot_gpio_edges;
+static uint32_t boot_gpio_level;
+#endif
+
+//loopback listener of the telemetry exporter
+static gn_leaf_handle_t exporter;
+static int exporter_sock = -1;
+
+//power meter on the bus of the board bme280, sampling only during its test
+static gn_leaf_handle_t ina219;
+static int ina219_sock = -1;
+
+static gn_leaf_handle_t filtered;
+static gn_filter_handle_t level_filter;
+static gn_calibration_handle_t level_calibration;
+static gn_rules_handle_t level_rules;
+static gn_leaf_handle_t scheduler;
+static gn_leaf_param_handle_t alarm_param;
+
+//a sensor like leaf with a filtered level parameter
+static void _filtered_leaf_task(gn_leaf_handle_t leaf_config) {
+
+	gn_leaf_parameter_event_t evt;
+	gn_leaf_event_subscribe(leaf_config, GN_LEAF_PARAM_CHANGED_EVENT);
+
+	while (true) {
+		if (xQueueReceive(gn_leaf_get_event_queue(leaf_config), &evt,
+				portMAX_DELAY) != pdPASS)
+			continue;
+
+		if (evt.id == GN_LEAF_PARAM_CHANGED_EVENT) {
+			gn_rules_on_change(level_rules, &evt);
+		} else if (evt.id == GN_LEAF_PARAM_CHANGE_REQUEST_EVENT) {
+			if (gn_leaf_event_mask_param(&evt, alarm_param) == 0) {
+				bool alarm;
+				gn_event_payload_to_bool(evt, &alarm);
+				gn_leaf_param_force_bool(leaf_config, "alarm", alarm);
+			} else if (!gn_filter_param_event(level_filter, &evt)
+					&& !gn_calibration_param_event(level_calibration, &evt))
+				gn_rules_param_event(level_rules, &evt);
+		}
+	}
+
+}
+
+static gn_leaf_descriptor_handle_t _filtered_leaf_config(
+		gn_leaf_handle_t leaf_config) {
+
+	gn_leaf_descriptor_handle_t descriptor = gn_mem_malloc(
+			gn_leaf_get_mem_tag(leaf_config), sizeof(gn_leaf_descriptor_t));
+	strncpy(descriptor->type, "filtered", GN_LEAF_DESC_TYPE_SIZE);
+	descriptor->callback = _filtered_leaf_task;
+	descriptor->data = NULL;
+
+	gn_leaf_param_handle_t level = gn_leaf_param_create(leaf_config, "level",
+			GN_VAL_TYPE_DOUBLE, (gn_val_t ) { .d = 0 },
+			GN_LEAF_PARAM_ACCESS_NODE, GN_LEAF_PARAM_STORAGE_VOLATILE, NULL);
+	gn_leaf_param_add_to_leaf(leaf_config, level);
+	gn_leaf_param_handle_t limit = gn_leaf_param_create(leaf_config, "limit",
+			GN_VAL_TYPE_DOUBLE, (gn_val_t ) { .d = 25 },
+			GN_LEAF_PARAM_ACCESS_ALL, GN_LEAF_PARAM_STORAGE_VOLATILE, NULL);
+	gn_leaf_param_add_to_leaf(leaf_config, limit);
+	alarm_param = gn_leaf_param_create(leaf_config, "alarm",
+			GN_VAL_TYPE_BOOLEAN, (gn_val_t ) { .b = false },
+			GN_LEAF_PARAM_ACCESS_ALL, GN_LEAF_PARAM_STORAGE_VOLATILE, NULL);
+	gn_leaf_param_add_to_leaf(leaf_config, alarm_param);
+	level_filter = gn_filter_param_create(leaf_config, "level", "median:3");
+	level_calibration = gn_calibration_create(leaf_config);
+	gn_calibration_param_add(level_calibration, "level");
+	level_rules = gn_rules_create(leaf_config, "");
+
+	descriptor->status = GN_LEAF_STATUS_INITIALIZED;
+	return descriptor;
+
+}
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+static void _actuator_cb(gn_sim_actuator_t type, int index, uint32_t value,
+		void *arg) {
+
+#ifdef CONFIG_GROWNODE_BOOT_PROFILE
+	if (type == GN_SIM_ACTUATOR_GPIO
+			&& index == CONFIG_GROWNODE_BOOT_PROFILE_GPIO
+			&& value != boot_gpio_level) {
+		boot_gpio_level = value;
+		boot_gpio_edges++;
+	}
+#endif
+
+	if (type != GN_SIM_ACTUATOR_GPIO || index != board->gpio)
+		return;
+
+	gpio_level = value;
+	xSemaphoreGive(gpio_changed);
+
+}
+
+static void _observer_cb(const char *topic, const char *data, int data_len,
+		void *arg) {
+	published++;
+}
+
+static bool _send_command(bool toggle, int64_t *latency_us) {
+
+	//drains changes not caused by this command
+	while (xSemaphoreTake(gpio_changed, 0) == pdTRUE)
+		;
+
+	int expected = toggle != board->inverted ? 1 : 0;
+#ifdef CONFIG_GROWNODE_MQTT_HOMIE_PROTOCOL
+	const char *payload = toggle ? "true" : "false";
+	int payload_len = strlen(payload);
+#else
+	//legacy commands carry the raw parameter value
+	const char *payload = toggle ? "\x01" : "\x00";
+	int payload_len = 1;
+#endif
+
+	int64_t start = esp_timer_get_time();
+	if (gn_sim_broker_publish(cmd_topic, payload, payload_len, 0, false) < 0)
+		return false;
+
+	while (xSemaphoreTake(gpio_changed,
+			GN_SIM_TEST_COMMAND_TIMEOUT_MS / portTICK_PERIOD_MS) == pdTRUE) {
+		if (gpio_level == expected) {
+			*latency_us = esp_timer_get_time() - start;
+			return true;
+		}
+	}
+
+	ESP_LOGE(TAG, "command %d on %s not executed", toggle, cmd_topic);
+	return false;
+
+}
+
+void test_gn_sim_node_start() {
+
+	//gn_init() keeps the pointer, it must outlive the node
+	static gn_config_init_param_t config_init = { //
+			.provisioning_security = true, //
+					.provisioning_password = "grownode", //
+					.wifi_retries_before_reset_provisioning = -1, //
+					.server_board_id_topic = false, //
+					.server_base_topic = "gn_sim", //
+					.server_url = "mqtt://127.0.0.1:1883", //
+					.server_keepalive_timer_sec = 60, //
+					.server_discovery = false, //
+					.server_discovery_prefix = "homeassistant", //
+					.firmware_url = "", //
+					.sntp_url = "pool.ntp.org", //
+					.wakeup_time_millisec = 5000LL, //
+					.sleep_delay_millisec = 50LL, //
+					.sleep_time_millisec = 10000LL, //
+					.sleep_mode = GN_SLEEP_MODE_NONE, //
+					.timezone = "CET-1CEST,M3.5.0,M10.5.0/3" };
+
+	int64_t start = esp_timer_get_time();
+
+	config = gn_init(&config_init);
+	TEST_ASSERT(config != NULL);
+
+	int waited_ms = 0;
+	while (gn_get_status(config) != GN_NODE_STATUS_READY_TO_START
+			&& waited_ms < GN_SIM_TEST_STARTUP_TIMEOUT_MS) {
+		vTaskDelay(10 / portTICK_PERIOD_MS);
+		waited_ms += 10;
+	}
+	TEST_ASSERT(gn_get_status(config) == GN_NODE_STATUS_READY_TO_START);
+
+	node = gn_node_create(config, board->name);
+	TEST_ASSERT(node != NULL);
+
+	board->configure(node);
+
+	//the exporter streams the board gpio to a loopback UDP listener
+	exporter_sock = socket(AF_INET, SOCK_DGRAM, 0);
+	TEST_ASSERT(exporter_sock >= 0);
+	struct sockaddr_in addr = { .sin_family = AF_INET, .sin_addr.s_addr = htonl(
+			INADDR_LOOPBACK) };
+	socklen_t addr_len = sizeof(addr);
+	TEST_ASSERT(bind(exporter_sock, (struct sockaddr* ) &addr, sizeof(addr)) == 0);
+	TEST_ASSERT(
+			getsockname(exporter_sock, (struct sockaddr* ) &addr, &addr_len) == 0);
+
+	char filter[64];
+	snprintf(filter, sizeof(filter), "%s.%s", board->gpio_leaf,
+			GN_GPIO_PARAM_TOGGLE);
+	exporter = gn_leaf_create(node, "exporter", gn_leaf_exporter_config, 4096,
+			GN_LEAF_TASK_PRIORITY);
+	TEST_ASSERT(exporter != NULL);
+	gn_leaf_param_init_string(exporter, GN_LEAF_EXPORTER_PARAM_IP, "127.0.0.1");
+	gn_leaf_param_init_double(exporter, GN_LEAF_EXPORTER_PARAM_PORT,
+			ntohs(addr.sin_port));
+	gn_leaf_param_init_string(exporter, GN_LEAF_EXPORTER_PARAM_FILTER, filter);
+	gn_leaf_param_init_double(exporter, GN_LEAF_EXPORTER_PARAM_FLUSH_INTERVAL,
+			50);
+
+	//readings of 1 mV on the shunt and 3.3 V on the bus
+	const uint8_t shunt[2] = { 0x00, 0x64 }, bus[2] = { 0x19, 0xc8 };
+	gn_sim_i2c_set_regs(0, GN_SIM_TEST_INA219_ADDR, 0x01, shunt, sizeof(shunt));
+	gn_sim_i2c_set_regs(0, GN_SIM_TEST_INA219_ADDR, 0x02, bus, sizeof(bus));
+
+	//the influxdb lines go to a listener that is never read
+	ina219_sock = socket(AF_INET, SOCK_DGRAM, 0);
+	TEST_ASSERT(ina219_sock >= 0);
+	struct sockaddr_in ina219_addr = { .sin_family = AF_INET,
+			.sin_addr.s_addr = htonl(INADDR_LOOPBACK) };
+	addr_len = sizeof(ina219_addr);
+	TEST_ASSERT(
+			bind(ina219_sock, (struct sockaddr* ) &ina219_addr, sizeof(ina219_addr)) == 0);
+	TEST_ASSERT(
+			getsockname(ina219_sock, (struct sockaddr* ) &ina219_addr, &addr_len) == 0);
+
+	ina219 = gn_leaf_create(node, "ina219", gn_leaf_ina219_config, 8192,
+			GN_LEAF_TASK_PRIORITY);
+	TEST_ASSERT(ina219 != NULL);
+	gn_leaf_param_init_bool(ina219, GN_LEAF_INA219_PARAM_ACTIVE, false);
+	gn_leaf_param_init_string(ina219, GN_LEAF_INA219_PARAM_IP, "127.0.0.1");
+	gn_leaf_param_init_double(ina219, GN_LEAF_INA219_PARAM_PORT,
+			ntohs(ina219_addr.sin_port));
+	gn_leaf_param_init_double(ina219, GN_LEAF_INA219_PARAM_SAMPLING_INTERVAL,
+			GN_SIM_TEST_INA219_INTERVAL_MS);
+	gn_leaf_param_init_double(ina219, GN_LEAF_INA219_PARAM_SDA,
+			GN_SIM_TEST_INA219_SDA);
+	gn_leaf_param_init_double(ina219, GN_LEAF_INA219_PARAM_SCL,
+			GN_SIM_TEST_INA219_SCL);
+	gn_leaf_param_init_double(ina219, GN_LEAF_INA219_PARAM_WORKING_MODE, 0);
+
+	//the hydroboard2 has its own scheduler
+	scheduler = gn_leaf_get_config_handle(node, "sched");
+	if (!scheduler)
+		scheduler = gn_leaf_create(node, "sched", gn_leaf_scheduler_config,
+				4096, GN_LEAF_TASK_PRIORITY);
+	TEST_ASSERT(scheduler != NULL);
+
+	filtered = gn_leaf_create(node, "filtered", _filtered_leaf_config, 4096,
+			GN_LEAF_TASK_PRIORITY);
+	TEST_ASSERT(filtered != NULL && level_filter != NULL);
+	TEST_ASSERT(level_calibration != NULL && level_rules != NULL);
+
+	TEST_ASSERT(gn_node_start(node) == GN_RET_OK);
+	TEST_ASSERT(gn_get_status(config) == GN_NODE_STATUS_STARTED);
+
+	gn_sim_broker_stats_t stats;
+	gn_sim_broker_get_stats(&stats);
+	TEST_ASSERT(stats.clients == 1);
+	TEST_ASSERT(stats.subscribed > 0);
+
+	ESP_LOGI(TAG,
+			"startup %s: %d leaves, %.1f ms, %"PRIu32" messages, %"PRIu32" subscriptions",
+			board->name, (int) gn_node_get_size(node),
+			(esp_timer_get_time() - start) / 1000.0, stats.published,
+			stats.subscribed);
+
+}
+
+#ifdef CONFIG_GROWNODE_BOOT_PROFILE
+//reports published by the node, observed from before it is started
+static int boot_subscription;
+static char *boot_report;
+static volatile int boot_reports;
+
+static void _boot_observer_cb(const char *topic, const char *data,
+		int data_len, void *arg) {
+	if (data_len <= 0)
+		return;
+	//payloads are not terminated
+	char *payload = strndup(data, data_len);
+	if (payload
+			&& (strstr(topic, "$stats/boot")
+					|| strstr(payload, "\"msgtype\":\"boot\""))) {
+		free(boot_report);
+		boot_report = payload;
+		boot_reports++;
+	} else
+		free(payload);
+}
+
+void test_gn_sim_boot_profile() {
+
+	TEST_ASSERT(gn_boot_is_complete());
+
+	//every phase of a started node without display, nested in gn_init or gn_node_start
+	const gn_boot_phase_t reached[] = { GN_BOOT_PHASE_INIT, GN_BOOT_PHASE_FLASH,
+			GN_BOOT_PHASE_SPIFFS, GN_BOOT_PHASE_EVENT_LOOP, GN_BOOT_PHASE_WIFI,
+			GN_BOOT_PHASE_TIME_SYNC, GN_BOOT_PHASE_LEAF_CREATE,
+			GN_BOOT_PHASE_NODE_START, GN_BOOT_PHASE_MQTT_START,
+			GN_BOOT_PHASE_LEAF_START };
+	uint32_t markers = 0;
+	for (size_t i = 0; i < sizeof(reached) / sizeof(reached[0]); i++) {
+		const gn_boot_phase_stats_t *p = gn_boot_phase_stats(reached[i]);
+		TEST_ASSERT(p->count > 0);
+		TEST_ASSERT(p->start_us > 0 && p->end_us >= p->start_us);
+		TEST_ASSERT(p->total_us >= 0 && p->total_us <= p->end_us - p->start_us);
+	}
+	for (int i = 0; i < GN_BOOT_PHASE_MAX; i++)
+		markers += 2 * gn_boot_phase_stats(i)->count;
+	TEST_ASSERT(gn_boot_phase_stats(GN_BOOT_PHASE_DISPLAY)->count == 0);
+
+	const gn_boot_phase_stats_t *init = gn_boot_phase_stats(GN_BOOT_PHASE_INIT);
+	const gn_boot_phase_stats_t *start = gn_boot_phase_stats(
+			GN_BOOT_PHASE_NODE_START);
+	TEST_ASSERT(gn_boot_phase_stats(GN_BOOT_PHASE_FLASH)->start_us >= init->start_us);
+	TEST_ASSERT(gn_boot_phase_stats(GN_BOOT_PHASE_TIME_SYNC)->end_us <= init->end_us);
+	TEST_ASSERT(gn_boot_phase_stats(GN_BOOT_PHASE_LEAF_CREATE)->start_us >= init->end_us);
+	TEST_ASSERT(start->start_us >= gn_boot_phase_stats(GN_BOOT_PHASE_LEAF_CREATE)->end_us);
+	TEST_ASSERT(gn_boot_phase_stats(GN_BOOT_PHASE_MQTT_START)->end_us
+			<= gn_boot_phase_stats(GN_BOOT_PHASE_LEAF_START)->start_us);
+	TEST_ASSERT(gn_boot_phase_stats(GN_BOOT_PHASE_LEAF_START)->end_us <= start->end_us);
+
+	//one edge per marker on the pin, back to low when the node is started
+	TEST_ASSERT_EQUAL(markers, boot_gpio_edges);
+	TEST_ASSERT(gn_sim_gpio_get_level(CONFIG_GROWNODE_BOOT_PROFILE_GPIO) == 0);
+
+	//the table is frozen, leaves created afterwards are not accounted
+	uint32_t leaf_creates =
+			gn_boot_phase_stats(GN_BOOT_PHASE_LEAF_CREATE)->count;
+	gn_boot_phase_begin(GN_BOOT_PHASE_LEAF_CREATE);
+	gn_boot_phase_end(GN_BOOT_PHASE_LEAF_CREATE);
+	TEST_ASSERT(
+			gn_boot_phase_stats(GN_BOOT_PHASE_LEAF_CREATE)->count == leaf_creates);
+
+	//the node published exactly one report while starting
+	for (int i = 0; i < 100 && boot_reports == 0; i++)
+		vTaskDelay(10 / portTICK_PERIOD_MS);
+	gn_sim_broker_unsubscribe(boot_subscription);
+	TEST_ASSERT_EQUAL(1, boot_reports);
+	TEST_ASSERT(boot_report != NULL);
+
+	//the report renders as a timeline, gn_init phases nested in it
+	char *timeline = NULL;
+	size_t timeline_len = 0;
+	FILE *out = open_memstream(&timeline, &timeline_len);
+	TEST_ASSERT(out != NULL);
+	TEST_ASSERT(gn_boot_timeline_render(boot_report, 40, out) == 0);
+	fclose(out);
+	ESP_LOGI(TAG, "boot profile %s:\n%s", board->name, timeline);
+	TEST_ASSERT(strstr(timeline, "\ninit ") != NULL);
+	TEST_ASSERT(strstr(timeline, "\n  flash ") != NULL);
+	TEST_ASSERT(strstr(timeline, "\n  spiffs ") != NULL);
+	TEST_ASSERT(strstr(timeline, "\n  mqtt_start ") != NULL);
+	TEST_ASSERT(gn_boot_timeline_render("{\"us\":1}", 40, stdout) == -1);
+	free(timeline);
+
+	//phases with the same timings are nested as recorded, not as guessed from the times
+	timeline = NULL;
+	out = open_memstream(&timeline, &timeline_len);
+	TEST_ASSERT(out != NULL);
+	TEST_ASSERT(
+			gn_boot_timeline_render("{\"us\":100,\"phases\":["
+					"[\"init\",0,50,50,1,\"\"],[\"flash\",10,10,0,1,\"init\"],"
+					"[\"spiffs\",10,10,0,1,\"init\"]]}", 40, out) == 0);
+	fclose(out);
+	TEST_ASSERT(strstr(timeline, "\n  flash ") != NULL);
+	TEST_ASSERT(strstr(timeline, "\n  spiffs ") != NULL);
+
+	free(timeline);
+	free(boot_report);
+	boot_report = NULL;
+
+}
+#endif
+
+void test_gn_sim_command_roundtrip() {
+
+#ifdef CONFIG_GROWNODE_MQTT_HOMIE_PROTOCOL
+	snprintf(cmd_topic, sizeof(cmd_topic), "homie/%s/%s/%s/set", board->name,
+			board->gpio_leaf, GN_GPIO_PARAM_TOGGLE);
+#else
+	snprintf(cmd_topic, sizeof(cmd_topic), "gn_sim/%s/%s/%s/cmd", board->name,
+			board->gpio_leaf, GN_GPIO_PARAM_TOGGLE);
+#endif
+
+	int64_t latency_us;
+	TEST_ASSERT(_send_command(true, &latency_us));
+	TEST_ASSERT(gn_sim_gpio_get_level(board->gpio) == (board->inverted ? 0 : 1));
+	TEST_ASSERT(_send_command(false, &latency_us));
+	TEST_ASSERT(gn_sim_gpio_get_level(board->gpio) == (board->inverted ? 1 : 0));
+
+}
+
+void test_gn_sim_command_throughput() {
+
+	int64_t latency_us, min_us = INT64_MAX, max_us = 0, total_us = 0;
+	int executed = 0;
+
+	int subscription = gn_sim_broker_subscribe("#", _observer_cb, NULL);
+	published = 0;
+
+	int64_t start = esp_timer_get_time();
+	for (int i = 0; i < GN_SIM_TEST_COMMANDS; i++) {
+		if (!_send_command(i % 2 == 0, &latency_us))
+			break;
+		executed++;
+		total_us += latency_us;
+		min_us = latency_us < min_us ? latency_us : min_us;
+		max_us = latency_us > max_us ? latency_us : max_us;
+	}
+	int64_t elapsed_us = esp_timer_get_time() - start;
+
+	gn_sim_broker_unsubscribe(subscription);
+
+	TEST_ASSERT(executed == GN_SIM_TEST_COMMANDS);
+	//every change is reported back by the leaf
+	TEST_ASSERT(published >= GN_SIM_TEST_COMMANDS);
+
+	ESP_LOGI(TAG,
+			"commands %s: %d in %.1f ms, %.0f cmd/s, latency min %.1f avg %.1f max %.1f us, %"PRIu32" messages out",
+			board->name, executed, elapsed_us / 1000.0,
+			executed * 1000000.0 / elapsed_us, (double) min_us,
+			(double) total_us / executed, (double) max_us, published);
+
+}
+
+#ifdef CONFIG_GROWNODE_LATENCY_TRACE
+static volatile bool latency_published;
+
+static void _latency_observer_cb(const char *topic, const char *data,
+		int data_len, void *arg) {
+	if (strstr(topic, "$stats/latency")
+			|| (data_len > 0 && strstr(data, "\"msgtype\":\"latency\"")))
+		latency_published = true;
+}
+
+void test_gn_sim_command_latency() {
+
+	int64_t latency_us;
+	int64_t max_us = 0;
+
+	gn_node_latency_reset(node);
+
+	for (int i = 0; i < GN_SIM_TEST_COMMANDS; i++) {
+		TEST_ASSERT(_send_command(i % 2 == 0, &latency_us));
+		max_us = latency_us > max_us ? latency_us : max_us;
+	}
+
+	gn_node_latency_dump(node);
+
+	cJSON *latency = gn_node_latency_to_json(node);
+	TEST_ASSERT(latency != NULL);
+	cJSON *leaf = cJSON_GetObjectItem(latency, board->gpio_leaf);
+	TEST_ASSERT(leaf != NULL);
+	int count = cJSON_GetObjectItem(leaf, "count")->valueint;
+	double p50 = cJSON_GetObjectItem(leaf, "p50_us")->valuedouble;
+	double p99 = cJSON_GetObjectItem(leaf, "p99_us")->valuedouble;
+	double max = cJSON_GetObjectItem(leaf, "max_us")->valuedouble;
+	cJSON_Delete(latency);
+
+	TEST_ASSERT(count == GN_SIM_TEST_COMMANDS);
+	TEST_ASSERT(p50 <= p99 && p99 <= max);
+	//the trace ends inside the leaf, before the test sees the actuator change
+	TEST_ASSERT(max <= max_us);
+
+	//statistics go out with the keepalive
+	latency_published = false;
+	int subscription = gn_sim_broker_subscribe("#", _latency_observer_cb,
+			NULL);
+	TEST_ASSERT(gn_mqtt_send_keepalive(node) == GN_RET_OK);
+	gn_sim_broker_unsubscribe(subscription);
+	TEST_ASSERT(latency_published);
+
+}
+#endif
+
+#ifdef CONFIG_GROWNODE_RUNTIME_STATS
+static volatile bool stats_published;
+
+static void _stats_observer_cb(const char *topic, const char *data,
+		int data_len, void *arg) {
+	if (strstr(topic, "$stats/runtime")
+			|| (data_len > 0 && strstr(data, "\"msgtype\":\"stats\"")))
+		stats_published = true;
+}
+
+void test_gn_sim_runtime_stats() {
+
+	int64_t latency_us;
+	TEST_ASSERT(_send_command(true, &latency_us));
+	TEST_ASSERT(_send_command(false, &latency_us));
+
+	cJSON *stats = gn_node_stats_to_json(node);
+	TEST_ASSERT(stats != NULL);
+	TEST_ASSERT(cJSON_GetObjectItem(stats, "heap_free")->valuedouble > 0);
+	TEST_ASSERT(cJSON_GetObjectItem(stats, "mqtt_outbox") != NULL);
+	TEST_ASSERT(cJSON_GetObjectItem(stats, "ready_ms") != NULL);
+
+	cJSON *leaves = cJSON_GetObjectItem(stats, "leaves");
+	TEST_ASSERT(leaves != NULL);
+	cJSON *leaf = cJSON_GetObjectItem(leaves, board->gpio_leaf);
+	TEST_ASSERT(leaf != NULL);
+	int queue_size = cJSON_GetObjectItem(leaf, "queue_size")->valueint;
+	int queue_peak = cJSON_GetObjectItem(leaf, "queue_peak")->valueint;
+	int dropped = cJSON_GetObjectItem(leaf, "dropped")->valueint;
+	double stack_free = cJSON_GetObjectItem(leaf, "stack_free")->valuedouble;
+	cJSON_Delete(stats);
+
+	//commands are sent one at a time, the leaf always keeps up
+	TEST_ASSERT(queue_peak >= 1 && queue_peak <= queue_size);
+	TEST_ASSERT(dropped == 0);
+	TEST_ASSERT(stack_free > 0);
+
+	//statistics go out in one message
+	stats_published = false;
+	int subscription = gn_sim_broker_subscribe("#", _stats_observer_cb, NULL);
+	TEST_ASSERT(gn_mqtt_send_stats(node) == GN_RET_OK);
+	gn_sim_broker_unsubscribe(subscription);
+	TEST_ASSERT(stats_published);
+
+}
+#endif
+
+#ifdef CONFIG_GROWNODE_MEM_ACCOUNTING
+void test_gn_sim_mem_accounting() {
+
+	int64_t latency_us;
+
+	gn_mem_stats_t params_before;
+	gn_mem_get_stats(GN_MEM_TAG_PARAMS, &params_before);
+
+	for (int i = 0; i < GN_SIM_TEST_COMMANDS; i++)
+		TEST_ASSERT(_send_command(i % 2 == 0, &latency_us));
+
+	//parameter values are updated in place
+	gn_mem_stats_t params_after;
+	gn_mem_get_stats(GN_MEM_TAG_PARAMS, &params_after);
+	TEST_ASSERT(params_after.live_bytes == params_before.live_bytes);
+
+	gn_mem_dump();
+
+	cJSON *mem = gn_mem_stats_to_json();
+	TEST_ASSERT(mem != NULL);
+	TEST_ASSERT(cJSON_GetObjectItem(mem, "core") != NULL);
+	TEST_ASSERT(cJSON_GetObjectItem(mem, "params") != NULL);
+	char leaf_tag[GN_MEM_TAG_NAME_SIZE];
+	snprintf(leaf_tag, sizeof(leaf_tag), "leaf:%s", board->gpio_leaf);
+	cJSON *leaf = cJSON_GetObjectItem(mem, leaf_tag);
+	TEST_ASSERT(leaf != NULL);
+	TEST_ASSERT(cJSON_GetObjectItem(leaf, "live")->valuedouble > 0);
+	cJSON_Delete(mem);
+
+	//allocations over budget are refused and counted
+	gn_mem_tag_t tag = gn_mem_tag_register("test");
+	gn_mem_set_budget(tag, 64);
+	void *inside = gn_mem_malloc(tag, 48);
+	void *outside = gn_mem_malloc(tag, 48);
+	TEST_ASSERT(inside != NULL);
+	TEST_ASSERT(outside == NULL);
+	gn_mem_free(inside);
+
+	gn_mem_stats_t stats;
+	gn_mem_get_stats(tag, &stats);
+	TEST_ASSERT(stats.live_bytes == 0 && stats.live_count == 0);
+	TEST_ASSERT(stats.peak_bytes == 48);
+	TEST_ASSERT(stats.allocs == 1 && stats.frees == 1 && stats.denied == 1);
+
+}
+#endif
+
+#ifdef CONFIG_GROWNODE_ADC_SAMPLING
+#define GN_SIM_TEST_ADC_NOISY_CHANNEL 6
+#define GN_SIM_TEST_ADC_STEP_CHANNEL 7
+#define GN_SIM_TEST_ADC_NARROW_CHANNEL 5
+//enough frames to fill the window
+#define GN_SIM_TEST_ADC_SETTLE_MS 400
+
+void test_gn_sim_adc_sampling() {
+
+	double raw;
+	gn_adc_stats_t before, after;
+
+	gn_sim_adc_set(GN_SIM_TEST_ADC_NOISY_CHANNEL, 2000, 200);
+	gn_sim_adc_set(GN_SIM_TEST_ADC_STEP_CHANNEL, 1000, 0);
+	gn_sim_adc_set(GN_SIM_TEST_ADC_NARROW_CHANNEL, 2000, 0);
+
+	gn_adc_channel_config_t median = { .filter = GN_ADC_FILTER_MEDIAN, .atten =
+			ADC_ATTEN_DB_11, .width = ADC_WIDTH_BIT_12 };
+	gn_adc_channel_config_t ema = { .filter = GN_ADC_FILTER_EMA, .ema_alpha =
+			0.2, .atten = ADC_ATTEN_DB_11, .width = ADC_WIDTH_BIT_12 };
+	gn_adc_channel_config_t narrow = { .filter = GN_ADC_FILTER_NONE, .atten =
+			ADC_ATTEN_DB_0, .width = ADC_WIDTH_BIT_10 };
+	gn_adc_channel_config_t bad_ema = { .filter = GN_ADC_FILTER_EMA };
+	gn_adc_channel_config_t bad_width = { .filter = GN_ADC_FILTER_NONE,
+			.width = ADC_WIDTH_MAX };
+	TEST_ASSERT(
+			gn_adc_channel_add(ADC1_CHANNEL_MAX, &median) == GN_RET_ERR_INVALID_ARG);
+	TEST_ASSERT(
+			gn_adc_channel_add(GN_SIM_TEST_ADC_STEP_CHANNEL, &bad_ema) == GN_RET_ERR_INVALID_ARG);
+	TEST_ASSERT(
+			gn_adc_channel_add(GN_SIM_TEST_ADC_NARROW_CHANNEL, &bad_width) == GN_RET_ERR_INVALID_ARG);
+	TEST_ASSERT(
+			gn_adc_channel_add(GN_SIM_TEST_ADC_NOISY_CHANNEL, &median) == GN_RET_OK);
+	TEST_ASSERT(
+			gn_adc_channel_add(GN_SIM_TEST_ADC_STEP_CHANNEL, &ema) == GN_RET_OK);
+	TEST_ASSERT(
+			gn_adc_channel_add(GN_SIM_TEST_ADC_NARROW_CHANNEL, &narrow) == GN_RET_OK);
+	TEST_ASSERT(gn_adc_read(0, &raw) == GN_RET_ERR);
+
+	vTaskDelay(GN_SIM_TEST_ADC_SETTLE_MS / portTICK_PERIOD_MS);
+
+	//the median of the frame averages is well inside the noise band
+	TEST_ASSERT(gn_adc_read(GN_SIM_TEST_ADC_NOISY_CHANNEL, &raw) == GN_RET_OK);
+	ESP_LOGI(TAG, "adc noisy channel: %.1f, noise +/-200", raw);
+	TEST_ASSERT(raw > 1980 && raw < 2020);
+
+	TEST_ASSERT(gn_adc_read(GN_SIM_TEST_ADC_STEP_CHANNEL, &raw) == GN_RET_OK);
+	TEST_ASSERT(raw > 999 && raw < 1001);
+
+	//each channel converts with its own width
+	TEST_ASSERT(gn_adc_read(GN_SIM_TEST_ADC_NARROW_CHANNEL, &raw) == GN_RET_OK);
+	TEST_ASSERT(raw == 500);
+	narrow.width = ADC_WIDTH_BIT_12;
+	TEST_ASSERT(
+			gn_adc_channel_add(GN_SIM_TEST_ADC_NARROW_CHANNEL, &narrow) == GN_RET_OK);
+	vTaskDelay(GN_SIM_TEST_ADC_SETTLE_MS / portTICK_PERIOD_MS);
+	TEST_ASSERT(gn_adc_read(GN_SIM_TEST_ADC_NARROW_CHANNEL, &raw) == GN_RET_OK);
+	TEST_ASSERT(raw == 2000);
+
+	//the moving average follows a step
+	gn_adc_get_stats(&before);
+	int64_t start = esp_timer_get_time();
+	gn_sim_adc_set(GN_SIM_TEST_ADC_STEP_CHANNEL, 3000, 0);
+	vTaskDelay(GN_SIM_TEST_ADC_SETTLE_MS / portTICK_PERIOD_MS);
+	TEST_ASSERT(gn_adc_read(GN_SIM_TEST_ADC_STEP_CHANNEL, &raw) == GN_RET_OK);
+	TEST_ASSERT(raw > 2990 && raw < 3001);
+	gn_adc_get_stats(&after);
+	int64_t elapsed_us = esp_timer_get_time() - start;
+
+	double rate = (after.conversions - before.conversions) * 1000000.0
+			/ elapsed_us;
+	ESP_LOGI(TAG,
+			"adc sampling: %.0f conversions/s over %"PRIu32" frames, %"PRIu32" overruns, %"PRIu32" invalid",
+			rate, after.frames - before.frames, after.overruns, after.invalid);
+	TEST_ASSERT(after.invalid == 0);
+	//every conversion of the sampling frequency reaches the filters
+	TEST_ASSERT(rate > CONFIG_GROWNODE_ADC_SAMPLE_FREQ_HZ * 0.5);
+	TEST_ASSERT(rate < CONFIG_GROWNODE_ADC_SAMPLE_FREQ_HZ * 1.1);
+
+}
+#endif
+
+/*
+ * receives datagrams until one contains the expected text, returns the number of lines
+ * of that datagram or -1 on timeout
+ */
+static int _exporter_receive(const char *expected, char *buf, size_t size) {
+
+	struct timeval tv = { .tv_sec = 0, .tv_usec = 100000 };
+	setsockopt(exporter_sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+	int64_t deadline = esp_timer_get_time()
+			+ GN_SIM_TEST_EXPORTER_TIMEOUT_MS * 1000LL;
+	while (esp_timer_get_time() < deadline) {
+		ssize_t len = recv(exporter_sock, buf, size - 1, 0);
+		if (len <= 0)
+			continue;
+		buf[len] = '\0';
+		if (!strstr(buf, expected))
+			continue;
+		int lines = 0;
+		for (char *c = buf; *c; c++)
+			lines += *c == '\n';
+		return lines;
+	}
+	return -1;
+
+}
+
+/*
+ * collects the datagrams containing the expected point until the given number of lines
+ * arrived, whatever the flush timing splitting them. returns the lines received
+ */
+static int _exporter_receive_lines(const char *expected, int lines,
+		int *datagrams) {
+
+	char buf[1500];
+	int received = 0;
+	*datagrams = 0;
+	while (received < lines) {
+		int n = _exporter_receive(expected, buf, sizeof(buf));
+		if (n < 0)
+			break;
+		received += n;
+		(*datagrams)++;
+	}
+	return received;
+
+}
+
+static void _exporter_drain() {
+	char buf[64];
+	while (recv(exporter_sock, buf, sizeof(buf), MSG_DONTWAIT) > 0)
+		;
+}
+
+static bool _exporter_set(const char *name, double val) {
+
+	double current = -1;
+	gn_leaf_param_set_double(exporter, name, val);
+	for (int i = 0; i < 100 && current != val; i++) {
+		vTaskDelay(10 / portTICK_PERIOD_MS);
+		gn_leaf_param_get_double(exporter, name, &current);
+	}
+	return current == val;
+
+}
+
+static bool _exporter_set_ip(char *ip) {
+
+	char current[16] = "";
+	gn_leaf_param_set_string(exporter, GN_LEAF_EXPORTER_PARAM_IP, ip);
+	for (int i = 0; i < 100 && strcmp(current, ip) != 0; i++) {
+		vTaskDelay(10 / portTICK_PERIOD_MS);
+		gn_leaf_param_get_string(exporter, GN_LEAF_EXPORTER_PARAM_IP, current,
+				sizeof(current));
+	}
+	return strcmp(current, ip) == 0;
+
+}
+
+void test_gn_sim_exporter() {
+
+	char buf[1500], expected[128];
+	int64_t latency_us;
+
+	_exporter_drain();
+
+	//influx line protocol, one timestamped line per change of the selected param
+	snprintf(expected, sizeof(expected), "grownode,node=%s,leaf=%s %s=true ",
+			board->name, board->gpio_leaf, GN_GPIO_PARAM_TOGGLE);
+	TEST_ASSERT(_send_command(true, &latency_us));
+	TEST_ASSERT(_exporter_receive(expected, buf, sizeof(buf)) == 1);
+	char *ts = strstr(buf, expected) + strlen(expected);
+	int digits = 0;
+	while (isdigit((unsigned char ) ts[digits]))
+		digits++;
+	TEST_ASSERT(digits >= 16 && ts[digits] == '\n');
+
+	//changes within the flush interval share a datagram
+	TEST_ASSERT(_exporter_set(GN_LEAF_EXPORTER_PARAM_FLUSH_INTERVAL, 500));
+	_exporter_drain();
+	TEST_ASSERT(_send_command(false, &latency_us));
+	TEST_ASSERT(_exporter_receive("=false ", buf, sizeof(buf)) == 1);
+	for (int i = 0; i < 4; i++)
+		TEST_ASSERT(_send_command(i % 2 == 0, &latency_us));
+	int datagrams;
+	int lines = _exporter_receive_lines(expected, 4, &datagrams);
+	ESP_LOGI(TAG, "exporter: %d points in %d datagrams", lines, datagrams);
+	TEST_ASSERT(lines == 4);
+	TEST_ASSERT(datagrams < 4);
+	TEST_ASSERT(_exporter_set(GN_LEAF_EXPORTER_PARAM_FLUSH_INTERVAL, 50));
+
+	//graphite plaintext
+	TEST_ASSERT(_exporter_set(GN_LEAF_EXPORTER_PARAM_FORMAT, 1));
+	snprintf(expected, sizeof(expected), "grownode.%s.%s.%s 1 ", board->name,
+			board->gpio_leaf, GN_GPIO_PARAM_TOGGLE);
+	TEST_ASSERT(_send_command(true, &latency_us));
+	TEST_ASSERT(_exporter_receive(expected, buf, sizeof(buf)) == 1);
+
+	//a sink refusing the datagrams does not hold the commands, the export resumes with a new sink
+	TEST_ASSERT(_exporter_set_ip("255.255.255.255"));
+	for (int i = 0; i < 10; i++)
+		TEST_ASSERT(_send_command(i % 2 == 0, &latency_us));
+	vTaskDelay(200 / portTICK_PERIOD_MS);
+	_exporter_drain();
+	TEST_ASSERT(_exporter_set_ip("127.0.0.1"));
+	TEST_ASSERT(_send_command(true, &latency_us));
+	TEST_ASSERT(_exporter_receive(expected, buf, sizeof(buf)) == 1);
+
+	TEST_ASSERT(_exporter_set(GN_LEAF_EXPORTER_PARAM_FORMAT, 0));
+
+	//at the next boot the sink and the filter come from NVS
+	char stored[64];
+	gn_leaf_handle_t leaf = gn_leaf_create(node, "exporter",
+			gn_leaf_exporter_config, 4096, GN_LEAF_TASK_PRIORITY);
+	TEST_ASSERT(leaf != NULL);
+	TEST_ASSERT(gn_leaf_param_get_string(leaf, GN_LEAF_EXPORTER_PARAM_IP, stored, sizeof(stored)) == GN_RET_OK);
+	TEST_ASSERT_EQUAL_STRING("127.0.0.1", stored);
+	TEST_ASSERT(gn_leaf_param_get_string(leaf, GN_LEAF_EXPORTER_PARAM_FILTER, stored, sizeof(stored)) == GN_RET_OK);
+	snprintf(expected, sizeof(expected), "%s.%s", board->gpio_leaf,
+			GN_GPIO_PARAM_TOGGLE);
+	TEST_ASSERT_EQUAL_STRING(expected, stored);
+
+}
+
+//lateness of a periodic esp_timer, grows when another callback blocks the timer task
+static volatile int64_t probe_last_us;
+static volatile int64_t probe_lateness_max_us;
+
+static void _ds18b20_probe_cb(void *arg) {
+
+	int64_t now = esp_timer_get_time();
+	int64_t lateness = now - probe_last_us
+			- GN_SIM_TEST_DS18B20_PROBE_PERIOD_US;
+	if (probe_last_us && lateness > probe_lateness_max_us)
+		probe_lateness_max_us = lateness;
+	probe_last_us = now;
+
+}
+
+static bool _ds18b20_wait_temp(gn_leaf_handle_t leaf, const char *name,
+		double expected, int timeout_ms) {
+
+	double temp = 0;
+	for (int waited_ms = 0; waited_ms < timeout_ms; waited_ms += 10) {
+		gn_leaf_param_get_double(leaf, name, &temp);
+		if (temp == expected)
+			return true;
+		vTaskDelay(10 / portTICK_PERIOD_MS);
+	}
+
+	ESP_LOGE(TAG, "%s is %.4f, expected %.4f", name, temp, expected);
+	return false;
+
+}
+
+void test_gn_sim_ds18b20() {
+
+	gn_leaf_handle_t leaf = gn_leaf_get_config_handle(node, board->temp_leaf);
+	TEST_ASSERT(leaf != NULL);
+
+	//first conversion at start, 12 bits
+	TEST_ASSERT(
+			_ds18b20_wait_temp(leaf, GN_DS18B20_PARAM_SENSOR_NAMES[0], 21.25, 2000));
+	TEST_ASSERT(
+			_ds18b20_wait_temp(leaf, GN_DS18B20_PARAM_SENSOR_NAMES[1], 18.0, 100));
+
+	esp_timer_handle_t probe;
+	esp_timer_create_args_t probe_args = { .callback = _ds18b20_probe_cb,
+			.name = "ds18b20_probe" };
+	TEST_ASSERT(esp_timer_create(&probe_args, &probe) == ESP_OK);
+	probe_last_us = 0;
+	probe_lateness_max_us = 0;
+	TEST_ASSERT(
+			esp_timer_start_periodic(probe, GN_SIM_TEST_DS18B20_PROBE_PERIOD_US) == ESP_OK);
+
+	//the next cycle converts at 9 bits, dropping the fractional part of 21.3
+	TEST_ASSERT(
+			gn_leaf_param_set_double(leaf, GN_DS18B20_PARAM_RESOLUTION, 9) == GN_RET_OK);
+	TEST_ASSERT(
+			gn_leaf_param_set_double(leaf, GN_DS18B20_PARAM_UPDATE_TIME_SEC, 3) == GN_RET_OK);
+	bool converted = _ds18b20_wait_temp(leaf, GN_DS18B20_PARAM_SENSOR_NAMES[0],
+			21.0, 6000);
+
+	esp_timer_stop(probe);
+	esp_timer_delete(probe);
+
+	ESP_LOGI(TAG, "ds18b20 %s: timer task blocked at most %.1f ms",
+			board->temp_leaf, probe_lateness_max_us / 1000.0);
+	TEST_ASSERT(converted);
+	TEST_ASSERT(
+			_ds18b20_wait_temp(leaf, GN_DS18B20_PARAM_SENSOR_NAMES[1], 18.0, 100));
+	TEST_ASSERT(probe_lateness_max_us < GN_SIM_TEST_DS18B20_LATENESS_MAX_US);
+
+}
+
+typedef struct {
+	int runs;
+	int64_t first_us;
+	int64_t sleep_us;
+} gn_sim_test_job_t;
+
+static void _sampler_job_cb(void *arg) {
+
+	gn_sim_test_job_t *job = (gn_sim_test_job_t*) arg;
+	if (job->runs++ == 0)
+		job->first_us = esp_timer_get_time();
+	if (job->sleep_us)
+		usleep(job->sleep_us);
+
+}
+
+static gn_sampler_job_handle_t _sampler_job(const char *name, int bus,
+		gn_sim_test_job_t *job) {
+
+	gn_sampler_job_handle_t handle = NULL;
+	gn_sampler_job_config_t config = { .callback = _sampler_job_cb, .arg = job,
+			.name = name, .bus = bus };
+	TEST_ASSERT(gn_sampler_job_create(&config, &handle) == GN_RET_OK);
+	return handle;
+
+}
+
+void test_gn_sim_sampler() {
+
+	//the sensor leaves of the board poll through the sampler
+	cJSON *jobs = gn_sampler_stats_to_json();
+	TEST_ASSERT(jobs != NULL);
+	int board_jobs = 0;
+	for (cJSON *job = jobs->child; job; job = job->next)
+		board_jobs++;
+	cJSON_Delete(jobs);
+	TEST_ASSERT(board_jobs >= 2);
+
+	gn_sim_test_job_t first = { 0 }, second = { 0 }, nobus = { 0 }, slow = {
+			.sleep_us = GN_SIM_TEST_SAMPLER_PERIOD_US * 3 / 2 };
+	gn_sampler_job_handle_t h_first = _sampler_job("first", GN_SAMPLER_BUS_I2C(
+			1), &first);
+	gn_sampler_job_handle_t h_second = _sampler_job("second",
+			GN_SAMPLER_BUS_I2C(1), &second);
+	gn_sampler_job_handle_t h_nobus = _sampler_job("nobus", GN_SAMPLER_BUS_NONE,
+			&nobus);
+	gn_sampler_job_handle_t h_slow = _sampler_job("slow", GN_SAMPLER_BUS_NONE,
+			&slow);
+
+	TEST_ASSERT(gn_sampler_job_start(h_first, 0) == GN_RET_ERR_INVALID_ARG);
+	TEST_ASSERT(
+			gn_sampler_job_start(h_first, GN_SIM_TEST_SAMPLER_PERIOD_US) == GN_RET_OK);
+	TEST_ASSERT(
+			gn_sampler_job_start(h_second, GN_SIM_TEST_SAMPLER_PERIOD_US) == GN_RET_OK);
+	TEST_ASSERT(
+			gn_sampler_job_start(h_nobus, GN_SIM_TEST_SAMPLER_PERIOD_US) == GN_RET_OK);
+	vTaskDelay(GN_SIM_TEST_SAMPLER_RUN_MS / portTICK_PERIOD_MS);
+
+	gn_sampler_job_stats_t stats;
+	TEST_ASSERT(gn_sampler_job_get_stats(h_first, &stats) == GN_RET_OK);
+	ESP_LOGI(TAG,
+			"sampler: %"PRIu32" runs, jitter avg %lld us max %lld us, second job %+lld us, no bus %+lld us",
+			stats.runs, stats.jitter_sum_us / (stats.runs ? stats.runs : 1),
+			stats.jitter_max_us, second.first_us - first.first_us,
+			nobus.first_us - first.first_us);
+
+	//deadlines are on the period grid
+	TEST_ASSERT(stats.runs >= 9);
+	TEST_ASSERT(stats.skipped == 0 && stats.overruns == 0);
+	TEST_ASSERT(stats.jitter_max_us < GN_SIM_TEST_SAMPLER_TOLERANCE_US);
+	TEST_ASSERT(
+			first.first_us % GN_SIM_TEST_SAMPLER_PERIOD_US < GN_SIM_TEST_SAMPLER_TOLERANCE_US);
+
+	//the second job of the bus is staggered, the one without bus runs with the first
+	int64_t stagger = ((second.first_us - first.first_us)
+			% GN_SIM_TEST_SAMPLER_PERIOD_US + GN_SIM_TEST_SAMPLER_PERIOD_US)
+			% GN_SIM_TEST_SAMPLER_PERIOD_US;
+	TEST_ASSERT(
+			stagger > GN_SAMPLER_BUS_STAGGER_MS * 1000 - GN_SIM_TEST_SAMPLER_TOLERANCE_US);
+	TEST_ASSERT(
+			stagger < GN_SAMPLER_BUS_STAGGER_MS * 1000 + GN_SIM_TEST_SAMPLER_TOLERANCE_US);
+	TEST_ASSERT(
+			llabs(nobus.first_us - first.first_us) < GN_SIM_TEST_SAMPLER_TOLERANCE_US);
+
+	TEST_ASSERT(gn_sampler_job_stop(h_first) == GN_RET_OK);
+	TEST_ASSERT(gn_sampler_job_stop(h_second) == GN_RET_OK);
+	TEST_ASSERT(gn_sampler_job_stop(h_nobus) == GN_RET_OK);
+
+	//a job longer than its period overruns and skips the deadlines it missed
+	TEST_ASSERT(
+			gn_sampler_job_start(h_slow, GN_SIM_TEST_SAMPLER_PERIOD_US) == GN_RET_OK);
+	vTaskDelay(GN_SIM_TEST_SAMPLER_RUN_MS / portTICK_PERIOD_MS);
+	TEST_ASSERT(gn_sampler_job_get_stats(h_slow, &stats) == GN_RET_OK);
+	ESP_LOGI(TAG, "sampler slow job: %"PRIu32" runs, %"PRIu32" overruns, %"PRIu32" skipped",
+			stats.runs, stats.overruns, stats.skipped);
+	TEST_ASSERT(stats.runs > 0 && stats.overruns > 0 && stats.skipped > 0);
+	TEST_ASSERT(stats.duration_max_us >= slow.sleep_us);
+
+	TEST_ASSERT(gn_sampler_job_delete(h_slow) == GN_RET_OK);
+	TEST_ASSERT(gn_sampler_job_delete(h_first) == GN_RET_OK);
+	TEST_ASSERT(gn_sampler_job_delete(h_second) == GN_RET_OK);
+	TEST_ASSERT(gn_sampler_job_delete(h_nobus) == GN_RET_OK);
+	TEST_ASSERT(gn_sampler_job_get_stats(h_slow, &stats) == GN_RET_ERR_INVALID_ARG);
+
+}
+
+static SemaphoreHandle_t i2c_done;
+static SemaphoreHandle_t i2c_held;
+static SemaphoreHandle_t i2c_release;
+static int i2c_order[GN_I2C_QUEUE_SIZE + 2];
+static volatile int i2c_completed;
+
+static void _i2c_batch_cb(const gn_i2c_op_t *ops, size_t count, void *arg) {
+
+	if (i2c_completed < sizeof(i2c_order) / sizeof(i2c_order[0]))
+		i2c_order[i2c_completed] = (intptr_t) arg;
+	i2c_completed++;
+	xSemaphoreGive(i2c_done);
+
+}
+
+//keeps the bus owned by the worker until released by the test
+static esp_err_t _i2c_hold(void *arg) {
+
+	xSemaphoreGive(i2c_held);
+	xSemaphoreTake(i2c_release, portMAX_DELAY);
+	return ESP_OK;
+
+}
+
+static void _i2c_dev_init(i2c_dev_t *dev, uint8_t addr) {
+
+	memset(dev, 0, sizeof(i2c_dev_t));
+	dev->port = GN_SIM_TEST_I2C_PORT;
+	dev->addr = addr;
+	dev->cfg.sda_io_num = GN_SIM_TEST_I2C_SDA;
+	dev->cfg.scl_io_num = GN_SIM_TEST_I2C_SCL;
+
+}
+
+static bool _i2c_wait_completed(int count) {
+
+	while (i2c_completed < count)
+		if (xSemaphoreTake(i2c_done,
+				GN_SIM_TEST_I2C_TIMEOUT_MS / portTICK_PERIOD_MS) != pdTRUE)
+			return false;
+	return true;
+
+}
+
+void test_gn_sim_i2c() {
+
+	i2c_done = xSemaphoreCreateCounting(64, 0);
+	i2c_held = xSemaphoreCreateBinary();
+	i2c_release = xSemaphoreCreateBinary();
+
+	//the bme280 leaf of the board is registered on its bus
+	cJSON *buses = gn_i2c_stats_to_json();
+	TEST_ASSERT(buses != NULL);
+	cJSON *bus0 = cJSON_GetObjectItem(buses, "0");
+	TEST_ASSERT(bus0 != NULL);
+	cJSON *devices = cJSON_GetObjectItem(bus0, "devices");
+	TEST_ASSERT(devices != NULL && devices->child != NULL);
+	int sda0 = cJSON_GetObjectItem(bus0, "sda")->valueint;
+	int scl0 = cJSON_GetObjectItem(bus0, "scl")->valueint;
+	cJSON_Delete(buses);
+
+	//a bus is identified by port and pins, pins cannot be shared by two buses
+	gn_i2c_bus_handle_t bus, same, other;
+	TEST_ASSERT(gn_i2c_bus_get(0, sda0, scl0, &other) == GN_RET_OK);
+	TEST_ASSERT(
+			gn_i2c_bus_get(0, GN_SIM_TEST_I2C_SDA, GN_SIM_TEST_I2C_SCL, &same) == GN_RET_ERR_INVALID_ARG);
+	TEST_ASSERT(
+			gn_i2c_bus_get(GN_SIM_TEST_I2C_PORT, sda0, GN_SIM_TEST_I2C_SCL, &same) == GN_RET_ERR_INVALID_ARG);
+	TEST_ASSERT(
+			gn_i2c_bus_get(GN_SIM_TEST_I2C_PORT, GN_SIM_TEST_I2C_SDA, GN_SIM_TEST_I2C_SCL, &bus) == GN_RET_OK);
+	TEST_ASSERT(
+			gn_i2c_bus_get(GN_SIM_TEST_I2C_PORT, GN_SIM_TEST_I2C_SDA, GN_SIM_TEST_I2C_SCL, &same) == GN_RET_OK);
+	TEST_ASSERT(same == bus);
+
+	//a slave with two 16 bit registers, the simulated register file is byte addressed
+	const uint8_t volts[] = { 0x0f, 0xa0, 0x5d, 0xc2 };
+	gn_sim_i2c_set_regs(GN_SIM_TEST_I2C_PORT, 0x40, 0x01, volts, 2);
+	gn_sim_i2c_set_regs(GN_SIM_TEST_I2C_PORT, 0x40, 0x03, volts + 2, 2);
+	const uint8_t lux[] = { 0x12, 0x34 };
+	gn_sim_i2c_set_regs(GN_SIM_TEST_I2C_PORT, 0x23, 0x00, lux, sizeof(lux));
+
+	i2c_dev_t dev_a, dev_b, dev_wrong;
+	gn_i2c_device_handle_t a, b;
+	_i2c_dev_init(&dev_a, 0x40);
+	_i2c_dev_init(&dev_b, 0x23);
+	_i2c_dev_init(&dev_wrong, 0x24);
+	dev_wrong.cfg.scl_io_num = scl0;
+	TEST_ASSERT(gn_i2c_device_add(bus, &dev_a, "power", &a) == GN_RET_OK);
+	TEST_ASSERT(gn_i2c_device_add(bus, &dev_b, "light", &b) == GN_RET_OK);
+	TEST_ASSERT(
+			gn_i2c_device_add(bus, &dev_wrong, "wrong", &b) == GN_RET_ERR_INVALID_ARG);
+
+	uint8_t shunt[2], bus_v[2], light[2];
+	gn_i2c_op_t hold = { .type = GN_I2C_OP_CALL, .device = a, .call =
+			&_i2c_hold };
+	gn_i2c_op_t reads[] = { { .type = GN_I2C_OP_READ_REG, .device = a, .reg =
+			0x01, .buf = shunt, .size = 2 }, { .type = GN_I2C_OP_READ_REG,
+			.device = a, .reg = 0x03, .buf = bus_v, .size = 2 } };
+	gn_i2c_op_t read_light = { .type = GN_I2C_OP_READ_REG, .device = b, .reg =
+			0x00, .buf = light, .size = 2 };
+
+	TEST_ASSERT(gn_i2c_batch_submit(bus, reads, 0, NULL, NULL) == GN_RET_ERR_INVALID_ARG);
+	TEST_ASSERT(gn_i2c_batch_submit(other, reads, 2, NULL, NULL) == GN_RET_ERR_INVALID_ARG);
+
+	//batches queued while the bus is owned run back to back in the next acquisition, in arrival order
+	gn_i2c_bus_stats_t before, after;
+	TEST_ASSERT(gn_i2c_bus_get_stats(bus, &before) == GN_RET_OK);
+	i2c_completed = 0;
+	TEST_ASSERT(gn_i2c_batch_submit(bus, &hold, 1, _i2c_batch_cb, (void*) 1) == GN_RET_OK);
+	TEST_ASSERT(xSemaphoreTake(i2c_held, GN_SIM_TEST_I2C_TIMEOUT_MS / portTICK_PERIOD_MS) == pdTRUE);
+	TEST_ASSERT(gn_i2c_batch_submit(bus, reads, 2, _i2c_batch_cb, (void*) 2) == GN_RET_OK);
+	TEST_ASSERT(gn_i2c_batch_submit(bus, &read_light, 1, _i2c_batch_cb, (void*) 3) == GN_RET_OK);
+	TEST_ASSERT(i2c_completed == 0);
+	xSemaphoreGive(i2c_release);
+	TEST_ASSERT(_i2c_wait_completed(3));
+	TEST_ASSERT(gn_i2c_bus_get_stats(bus, &after) == GN_RET_OK);
+
+	TEST_ASSERT(i2c_order[0] == 1 && i2c_order[1] == 2 && i2c_order[2] == 3);
+	TEST_ASSERT(after.acquisitions - before.acquisitions == 1);
+	TEST_ASSERT(after.batches - before.batches == 3);
+	TEST_ASSERT(memcmp(shunt, volts, 2) == 0 && memcmp(bus_v, volts + 2, 2) == 0);
+	TEST_ASSERT(memcmp(light, lux, 2) == 0);
+
+	//a full queue rejects the batch
+	i2c_completed = 0;
+	TEST_ASSERT(gn_i2c_batch_submit(bus, &hold, 1, _i2c_batch_cb, (void*) 0) == GN_RET_OK);
+	TEST_ASSERT(xSemaphoreTake(i2c_held, GN_SIM_TEST_I2C_TIMEOUT_MS / portTICK_PERIOD_MS) == pdTRUE);
+	for (int i = 0; i < GN_I2C_QUEUE_SIZE; i++)
+		TEST_ASSERT(gn_i2c_batch_submit(bus, &read_light, 1, _i2c_batch_cb, (void*) (intptr_t) (i + 1)) == GN_RET_OK);
+	TEST_ASSERT(gn_i2c_batch_submit(bus, &read_light, 1, _i2c_batch_cb, NULL) == GN_RET_ERR);
+	xSemaphoreGive(i2c_release);
+	TEST_ASSERT(_i2c_wait_completed(GN_I2C_QUEUE_SIZE + 1));
+	for (int i = 0; i <= GN_I2C_QUEUE_SIZE; i++)
+		TEST_ASSERT(i2c_order[i] == i);
+	TEST_ASSERT(gn_i2c_bus_get_stats(bus, &after) == GN_RET_OK);
+	TEST_ASSERT(after.rejected == before.rejected + 1);
+
+	//failed register transactions are retried, then counted as errors
+	gn_i2c_device_stats_t stats;
+	gn_sim_i2c_fail(GN_SIM_TEST_I2C_PORT, 0x40, GN_I2C_RETRIES);
+	TEST_ASSERT(gn_i2c_batch_run(bus, reads, 2) == GN_RET_OK);
+	TEST_ASSERT(gn_i2c_device_get_stats(a, &stats) == GN_RET_OK);
+	TEST_ASSERT(stats.retries == GN_I2C_RETRIES && stats.errors == 0);
+
+	gn_sim_i2c_fail(GN_SIM_TEST_I2C_PORT, 0x40, GN_I2C_RETRIES + 1);
+	TEST_ASSERT(gn_i2c_batch_run(bus, reads, 2) == GN_RET_ERR);
+	TEST_ASSERT(reads[0].result == ESP_ERR_TIMEOUT && reads[1].result == ESP_OK);
+	TEST_ASSERT(gn_i2c_device_get_stats(a, &stats) == GN_RET_OK);
+	TEST_ASSERT(stats.retries == 2 * GN_I2C_RETRIES && stats.errors == 1);
+
+	const uint8_t config[] = { 0x39, 0x9f };
+	uint8_t written[2];
+	gn_i2c_op_t write = { .type = GN_I2C_OP_WRITE_REG, .device = a, .reg = 0x00,
+			.buf = (void*) config, .size = 2 };
+	TEST_ASSERT(gn_i2c_batch_run(bus, &write, 1) == GN_RET_OK);
+	gn_sim_i2c_get_regs(GN_SIM_TEST_I2C_PORT, 0x40, 0x00, written, 2);
+	TEST_ASSERT(memcmp(written, config, 2) == 0);
+
+	//every attempt reaches the slave, the two calls holding the bus are counted as one transaction each
+	TEST_ASSERT(gn_i2c_device_get_stats(a, &stats) == GN_RET_OK);
+	TEST_ASSERT(stats.transactions == gn_sim_i2c_get_transactions(GN_SIM_TEST_I2C_PORT, 0x40) + 2);
+
+	buses = gn_i2c_stats_to_json();
+	char *json = cJSON_PrintUnformatted(buses);
+	ESP_LOGI(TAG, "i2c: %s", json);
+	free(json);
+	cJSON *bus1 = cJSON_GetObjectItem(buses, "1");
+	TEST_ASSERT(bus1 != NULL);
+	cJSON *power = cJSON_GetObjectItem(cJSON_GetObjectItem(bus1, "devices"), "power");
+	TEST_ASSERT(power != NULL);
+	TEST_ASSERT(cJSON_GetObjectItem(power, "errors")->valueint == 1);
+	cJSON_Delete(buses);
+
+}
+
+static double _filter_run(gn_filter_handle_t filter, const double *in,
+		size_t count, int64_t step_us, bool *changed) {
+
+	double out = 0;
+	for (size_t i = 0; i < count; i++)
+		*changed = gn_filter_update(filter, in[i], i * step_us, &out);
+	return out;
+
+}
+
+//the parameters of the leaf loaded at each boot by _stored_leaf_boot()
+static void (*stored_leaf_params)(gn_leaf_handle_t leaf_config);
+static gn_node_handle_t stored_leaf_node;
+
+static gn_leaf_descriptor_handle_t _stored_leaf_config(
+		gn_leaf_handle_t leaf_config) {
+
+	gn_leaf_descriptor_handle_t descriptor = gn_mem_malloc(
+			gn_leaf_get_mem_tag(leaf_config), sizeof(gn_leaf_descriptor_t));
+	strncpy(descriptor->type, "stored", GN_LEAF_DESC_TYPE_SIZE);
+	descriptor->callback = NULL;
+	descriptor->data = NULL;
+
+	stored_leaf_params(leaf_config);
+
+	descriptor->status = GN_LEAF_STATUS_INITIALIZED;
+	return descriptor;
+
+}
+
+//creates the leaf as at a boot, loading its persisted parameters from NVS.
+//every boot gets a node of its own, so that the running node has no duplicate
+//leaves, command topics or arena strings and the previous boot is discarded
+static gn_leaf_handle_t _stored_leaf_boot(const char *name,
+		void (*params)(gn_leaf_handle_t leaf_config)) {
+
+	if (stored_leaf_node)
+		gn_node_destroy(stored_leaf_node);
+	stored_leaf_node = gn_node_create(config, "stored");
+	TEST_ASSERT(stored_leaf_node != NULL);
+	//keepalive and stats keep reporting the running node
+	((gn_config_handle_intl_t) config)->node_handle = node;
+
+	stored_leaf_params = params;
+	return gn_leaf_create(stored_leaf_node, name, _stored_leaf_config, 4096,
+			GN_LEAF_TASK_PRIORITY);
+
+}
+
+static gn_filter_handle_t stored_filter;
+
+static void _stored_filter_params(gn_leaf_handle_t leaf_config) {
+
+	gn_leaf_param_handle_t level = gn_leaf_param_create(leaf_config, "level",
+			GN_VAL_TYPE_DOUBLE, (gn_val_t ) { .d = 0 },
+			GN_LEAF_PARAM_ACCESS_NODE, GN_LEAF_PARAM_STORAGE_VOLATILE, NULL);
+	gn_leaf_param_add_to_leaf(leaf_config, level);
+	stored_filter = gn_filter_param_create(leaf_config, "level", "median:3");
+
+}
+
+static char ina219_rate_topic[128];
+static char ina219_dropped_topic[128];
+static volatile uint32_t ina219_rate_published;
+static volatile uint32_t ina219_dropped_published;
+static volatile double ina219_rate;
+
+static void _ina219_observer_cb(const char *topic, const char *data,
+		int data_len, void *arg) {
+
+	char buf[32];
+	snprintf(buf, sizeof(buf), "%.*s", data_len, data);
+
+	if (strcmp(topic, ina219_rate_topic) == 0) {
+		ina219_rate = atof(buf);
+		ina219_rate_published++;
+	} else if (strcmp(topic, ina219_dropped_topic) == 0)
+		ina219_dropped_published++;
+
+}
+
+static bool _ina219_set_active(bool active) {
+
+	bool current = !active;
+	gn_leaf_param_set_bool(ina219, GN_LEAF_INA219_PARAM_ACTIVE, active);
+	for (int waited_ms = 0;
+			waited_ms < GN_SIM_TEST_INA219_TIMEOUT_MS && current != active;
+			waited_ms += 10) {
+		vTaskDelay(10 / portTICK_PERIOD_MS);
+		gn_leaf_param_get_bool(ina219, GN_LEAF_INA219_PARAM_ACTIVE, &current);
+	}
+	return current == active;
+
+}
+
+void test_gn_sim_ina219() {
+
+#ifdef CONFIG_GROWNODE_MQTT_HOMIE_PROTOCOL
+	snprintf(ina219_rate_topic, sizeof(ina219_rate_topic), "homie/%s/ina219/%s",
+			board->name, GN_LEAF_INA219_PARAM_SAMPLING_RATE);
+	snprintf(ina219_dropped_topic, sizeof(ina219_dropped_topic),
+			"homie/%s/ina219/%s", board->name, GN_LEAF_INA219_PARAM_DROPPED);
+#else
+	snprintf(ina219_rate_topic, sizeof(ina219_rate_topic),
+			"gn_sim/%s/ina219/%s/sts", board->name,
+			GN_LEAF_INA219_PARAM_SAMPLING_RATE);
+	snprintf(ina219_dropped_topic, sizeof(ina219_dropped_topic),
+			"gn_sim/%s/ina219/%s/sts", board->name,
+			GN_LEAF_INA219_PARAM_DROPPED);
+#endif
+
+	ina219_rate_published = 0;
+	ina219_dropped_published = 0;
+	int subscription = gn_sim_broker_subscribe("#", _ina219_observer_cb, NULL);
+
+	//nothing is published while the leaf is not sampling
+	vTaskDelay(
+			(GN_LEAF_INA219_STATS_INTERVAL_US / 1000) * 3 / portTICK_PERIOD_MS);
+	TEST_ASSERT_EQUAL(0, ina219_rate_published);
+	TEST_ASSERT_EQUAL(0, ina219_dropped_published);
+
+	//the rate comes out at the first interval after the start
+	uint32_t transactions = gn_sim_i2c_get_transactions(0,
+			GN_SIM_TEST_INA219_ADDR);
+	TEST_ASSERT(_ina219_set_active(true));
+	for (int waited_ms = 0;
+			waited_ms < GN_SIM_TEST_INA219_TIMEOUT_MS
+					&& ina219_rate_published == 0; waited_ms += 10)
+		vTaskDelay(10 / portTICK_PERIOD_MS);
+	vTaskDelay((GN_LEAF_INA219_STATS_INTERVAL_US / 1000) * 3 / portTICK_PERIOD_MS);
+
+	ESP_LOGI(TAG, "ina219 %s: rate %.0f Hz, published %"PRIu32" times",
+			board->name, ina219_rate, ina219_rate_published);
+	TEST_ASSERT(ina219_rate_published > 0);
+	TEST_ASSERT(ina219_rate > 0);
+	TEST_ASSERT(
+			gn_sim_i2c_get_transactions(0, GN_SIM_TEST_INA219_ADDR) > transactions);
+	//no sample was lost, the counter never changed
+	TEST_ASSERT_EQUAL(0, ina219_dropped_published);
+
+	//stopping publishes a zero rate once, then the statistics are quiet
+	TEST_ASSERT(_ina219_set_active(false));
+	for (int waited_ms = 0;
+			waited_ms < GN_SIM_TEST_INA219_TIMEOUT_MS && ina219_rate != 0;
+			waited_ms += 10)
+		vTaskDelay(10 / portTICK_PERIOD_MS);
+	TEST_ASSERT(ina219_rate == 0);
+
+	uint32_t published = ina219_rate_published;
+	vTaskDelay(
+			(GN_LEAF_INA219_STATS_INTERVAL_US / 1000) * 3 / portTICK_PERIOD_MS);
+	gn_sim_broker_unsubscribe(subscription);
+	TEST_ASSERT_EQUAL(published, ina219_rate_published);
+	TEST_ASSERT_EQUAL(0, ina219_dropped_published);
+
+	close(ina219_sock);
+	ina219_sock = -1;
+
+}
+
+void test_gn_sim_filter() {
+
+	bool changed;
+	double out;
+
+	//specs are checked before touching the filter
+	const char *invalid[] = { "median:4", "median:11", "avg:0", "avg:17",
+			"ema:0", "ema:1.5", "rate:-1", "kalman:0.1", "delta:x", "lowpass:3",
+			"median:3,avg:2,ema:0.5,rate:1,delta:1" };
+	for (int i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++)
+		TEST_ASSERT(gn_filter_create(GN_MEM_TAG_LEAF, invalid[i]) == NULL);
+
+	gn_filter_handle_t f = gn_filter_create(GN_MEM_TAG_LEAF, NULL);
+	TEST_ASSERT(f != NULL);
+	const double pass[] = { 1, 7, -3 };
+	TEST_ASSERT(_filter_run(f, pass, 3, 1000, &changed) == -3 && changed);
+
+	//median rejects a spike
+	TEST_ASSERT(gn_filter_configure(f, "median:3") == GN_RET_OK);
+	const double spike[] = { 10, 10, 100, 10 };
+	for (int i = 0; i < 4; i++) {
+		gn_filter_update(f, spike[i], 0, &out);
+		TEST_ASSERT(out == 10);
+	}
+
+	TEST_ASSERT(gn_filter_configure(f, "avg:4") == GN_RET_OK);
+	const double ramp[] = { 1, 2, 3, 4, 5, 6 };
+	TEST_ASSERT(_filter_run(f, ramp, 2, 1000, &changed) == 1.5);
+	gn_filter_reset(f);
+	TEST_ASSERT(_filter_run(f, ramp, 6, 1000, &changed) == 4.5);
+
+	TEST_ASSERT(gn_filter_configure(f, "ema:0.5") == GN_RET_OK);
+	const double step[] = { 0, 10, 10 };
+	TEST_ASSERT(_filter_run(f, step, 3, 1000, &changed) == 7.5);
+
+	//1 unit per second, samples every 500 msec
+	TEST_ASSERT(gn_filter_configure(f, "rate:1") == GN_RET_OK);
+	TEST_ASSERT(_filter_run(f, step, 3, 500000, &changed) == 1);
+
+	//kalman settles on the mean of a noisy signal
+	TEST_ASSERT(gn_filter_configure(f, "kalman:0.0001:1") == GN_RET_OK);
+	double noisy[200];
+	for (int i = 0; i < 200; i++)
+		noisy[i] = 20 + (i % 2 ? 1 : -1);
+	out = _filter_run(f, noisy, 200, 1000, &changed);
+	TEST_ASSERT(fabs(out - 20) < 0.2);
+
+	//jitter below the delta is held and not published
+	TEST_ASSERT(gn_filter_configure(f, "median:3,delta:0.5") == GN_RET_OK);
+	TEST_ASSERT(gn_filter_update(f, 20, 0, &out) && out == 20);
+	TEST_ASSERT(!gn_filter_update(f, 20.3, 0, &out) && out == 20);
+	TEST_ASSERT(!gn_filter_update(f, 90, 0, &out) && out == 20);
+	TEST_ASSERT(gn_filter_update(f, 20.6, 0, &out) && out == 20.6);
+
+	//a refused spec leaves the filter as it is
+	TEST_ASSERT(gn_filter_configure(f, "median:2") == GN_RET_ERR_INVALID_ARG);
+	TEST_ASSERT(!gn_filter_update(f, 20.6, 0, &out) && out == 20.6);
+
+	//failed readings are dropped, the full median window keeps working
+	TEST_ASSERT(gn_filter_configure(f, "median:3") == GN_RET_OK);
+	const double window[] = { 5, 6, 7, 8 };
+	TEST_ASSERT(_filter_run(f, window, 4, 1000, &changed) == 7);
+	TEST_ASSERT(!gn_filter_update(f, NAN, 0, &out) && out == 7);
+	TEST_ASSERT(!gn_filter_update(f, INFINITY, 0, &out) && out == 7);
+	TEST_ASSERT(!gn_filter_update(f, -INFINITY, 0, &out) && out == 7);
+	TEST_ASSERT(gn_filter_update(f, 9, 0, &out) && out == 8);
+	TEST_ASSERT(gn_filter_update(f, 10, 0, &out) && out == 9);
+	gn_filter_delete(f);
+
+	//leaf parameter, the spec comes from its own parameter
+	char spec[GN_FILTER_SPEC_SIZE];
+	double level;
+	TEST_ASSERT(gn_leaf_param_get_string(filtered, "level_filter", spec, sizeof(spec)) == GN_RET_OK);
+	TEST_ASSERT(strcmp(spec, "median:3") == 0);
+	const double levels[] = { 10, 100, 10 };
+	for (int i = 0; i < 3; i++)
+		TEST_ASSERT(gn_filter_param_update(level_filter, levels[i], &out) == GN_RET_OK);
+	TEST_ASSERT(gn_leaf_param_get_double(filtered, "level", &level) == GN_RET_OK);
+	TEST_ASSERT(level == 10 && out == 10);
+
+	TEST_ASSERT(gn_leaf_param_force_string(filtered, "level_filter", "avg:2,foo") == GN_RET_ERR_INVALID_ARG);
+
+	//changed from the network
+	char topic[128];
+#ifdef CONFIG_GROWNODE_MQTT_HOMIE_PROTOCOL
+	snprintf(topic, sizeof(topic), "homie/%s/filtered/level_filter/set",
+			board->name);
+#else
+	snprintf(topic, sizeof(topic), "gn_sim/%s/filtered/level_filter/cmd",
+			board->name);
+#endif
+	const char *ema = "ema:0.5";
+	TEST_ASSERT(gn_sim_broker_publish(topic, ema, strlen(ema), 0, false) >= 0);
+	int64_t deadline = esp_timer_get_time()
+			+ GN_SIM_TEST_FILTER_TIMEOUT_MS * 1000LL;
+	do {
+		vTaskDelay(10 / portTICK_PERIOD_MS);
+		gn_leaf_param_get_string(filtered, "level_filter", spec, sizeof(spec));
+	} while (strcmp(spec, ema) != 0 && esp_timer_get_time() < deadline);
+	TEST_ASSERT(strcmp(spec, ema) == 0);
+
+	TEST_ASSERT(gn_filter_param_update(level_filter, 0, NULL) == GN_RET_OK);
+	TEST_ASSERT(gn_filter_param_update(level_filter, 10, NULL) == GN_RET_OK);
+	TEST_ASSERT(gn_leaf_param_get_double(filtered, "level", &level) == GN_RET_OK);
+	TEST_ASSERT(level == 5);
+
+	//at the next boot the spec comes from NVS, the default is the filter own buffer
+	gn_leaf_handle_t leaf = _stored_leaf_boot("stored_filter",
+			_stored_filter_params);
+	TEST_ASSERT(leaf != NULL && stored_filter != NULL);
+	TEST_ASSERT(gn_leaf_param_force_string(leaf, "level_filter", "avg:2") == GN_RET_OK);
+	stored_filter = NULL;
+	leaf = _stored_leaf_boot("stored_filter", _stored_filter_params);
+	TEST_ASSERT(leaf != NULL && stored_filter != NULL);
+	TEST_ASSERT(gn_leaf_param_get_string(leaf, "level_filter", spec, sizeof(spec)) == GN_RET_OK);
+	TEST_ASSERT_EQUAL_STRING("avg:2", spec);
+	TEST_ASSERT(gn_filter_param_update(stored_filter, 0, NULL) == GN_RET_OK);
+	TEST_ASSERT(gn_filter_param_update(stored_filter, 10, &out) == GN_RET_OK);
+	TEST_ASSERT(out == 5);
+
+}
+
+//sends a calibration command and waits for the table to be published
+static void _calibration_command(const char *command, const char *expected) {
+
+	char topic[128];
+#ifdef CONFIG_GROWNODE_MQTT_HOMIE_PROTOCOL
+	snprintf(topic, sizeof(topic), "homie/%s/filtered/level_cal/set",
+			board->name);
+#else
+	snprintf(topic, sizeof(topic), "gn_sim/%s/filtered/level_cal/cmd",
+			board->name);
+#endif
+	TEST_ASSERT(gn_sim_broker_publish(topic, command, strlen(command), 0, false) >= 0);
+
+	char text[GN_CALIBRATION_TEXT_SIZE];
+	int64_t deadline = esp_timer_get_time()
+			+ GN_SIM_TEST_FILTER_TIMEOUT_MS * 1000LL;
+	do {
+		vTaskDelay(10 / portTICK_PERIOD_MS);
+		gn_leaf_param_get_string(filtered, "level_cal", text, sizeof(text));
+	} while (strcmp(text, expected) != 0 && esp_timer_get_time() < deadline);
+	TEST_ASSERT_EQUAL_STRING(expected, text);
+
+}
+
+void test_gn_sim_calibration() {
+
+	double value = -1;
+
+	//no table, the leaf keeps its own conversion
+	TEST_ASSERT(!gn_calibration_apply(level_calibration, "level", 100, &value));
+	TEST_ASSERT(value == -1);
+	TEST_ASSERT(!gn_calibration_apply(level_calibration, "other", 100, &value));
+
+	//capture pairs the reference with the last reading
+	_calibration_command("50", "100:50");
+	TEST_ASSERT(gn_calibration_apply(level_calibration, "level", 110, &value));
+	TEST_ASSERT(value == 60);
+
+	gn_calibration_apply(level_calibration, "level", 300, &value);
+	_calibration_command("100", "100:50,300:100");
+	gn_calibration_apply(level_calibration, "level", 200, &value);
+	_calibration_command("80", "100:50,200:80,300:100");
+
+	const double raw[] = { 100, 150, 200, 250, 300, 400, 0 };
+	const double expected[] = { 50, 65, 80, 90, 100, 120, 20 };
+	for (int i = 0; i < 7; i++) {
+		TEST_ASSERT(gn_calibration_apply(level_calibration, "level", raw[i], &value));
+		TEST_ASSERT(fabs(value - expected[i]) < 1e-4);
+	}
+
+	//malformed, duplicated or oversized tables are refused
+	const gn_calibration_point_t dup[] = { { 1, 1 }, { 1, 2 } };
+	TEST_ASSERT(gn_calibration_set_points(level_calibration, "level", dup, 2) == GN_RET_ERR_INVALID_ARG);
+	gn_calibration_point_t many[GN_CALIBRATION_MAX_POINTS + 1] = { 0 };
+	TEST_ASSERT(gn_calibration_set_points(level_calibration, "level", many, GN_CALIBRATION_MAX_POINTS + 1) == GN_RET_ERR_INVALID_ARG);
+	TEST_ASSERT(gn_calibration_set_points(level_calibration, "missing", dup, 1) == GN_RET_ERR_INVALID_ARG);
+
+	//a whole table, unordered
+	_calibration_command("2000:0,1000:100", "1000:100,2000:0");
+	TEST_ASSERT(gn_calibration_apply(level_calibration, "level", 1250, &value));
+	TEST_ASSERT(fabs(value - 75) < 1e-4);
+
+	//tables survive a restart of the leaf
+	gn_calibration_handle_t reloaded = gn_calibration_create(filtered);
+	TEST_ASSERT(reloaded != NULL);
+	gn_calibration_point_t points[GN_CALIBRATION_MAX_POINTS];
+	TEST_ASSERT(gn_calibration_get_points(reloaded, "level", points, GN_CALIBRATION_MAX_POINTS) == 2);
+	TEST_ASSERT(points[0].raw == 1000 && points[0].value == 100);
+	TEST_ASSERT(points[1].raw == 2000 && points[1].value == 0);
+	gn_calibration_delete(reloaded);
+
+	//a blob whose header does not match its content is ignored
+	char key[GN_LEAF_NAME_SIZE + sizeof(GN_CALIBRATION_STORAGE_SUFFIX)];
+	gn_leaf_get_name(filtered, key);
+	strcat(key, GN_CALIBRATION_STORAGE_SUFFIX);
+	uint8_t *blob = NULL;
+	size_t blob_len = 0;
+	TEST_ASSERT(gn_storage_get_blob(key, (void**) &blob, &blob_len) == GN_RET_NVS_PARAMETER_FOUND);
+	TEST_ASSERT(blob_len == 4 + (blob[2] | (blob[3] << 8)));
+
+	const uint8_t header_damage[][2] = { { 1, 1 }, //older version
+			{ 2, blob[2] - 1 }, //shorter than the tables
+			{ 2, blob[2] + 1 } }; //longer than the tables
+	for (int i = 0; i < 3; i++) {
+		uint8_t saved = blob[header_damage[i][0]];
+		blob[header_damage[i][0]] = header_damage[i][1];
+		TEST_ASSERT(gn_storage_set(key, blob, blob_len) == GN_RET_OK);
+		reloaded = gn_calibration_create(filtered);
+		TEST_ASSERT(reloaded != NULL);
+		TEST_ASSERT(gn_calibration_get_points(reloaded, "level", points, GN_CALIBRATION_MAX_POINTS) == 0);
+		gn_calibration_delete(reloaded);
+		blob[header_damage[i][0]] = saved;
+	}
+
+	//as is a blob shorter than its header declares
+	TEST_ASSERT(gn_storage_set(key, blob, blob_len - 8) == GN_RET_OK);
+	reloaded = gn_calibration_create(filtered);
+	TEST_ASSERT(reloaded != NULL);
+	TEST_ASSERT(gn_calibration_get_points(reloaded, "level", points, GN_CALIBRATION_MAX_POINTS) == 0);
+	gn_calibration_delete(reloaded);
+
+	TEST_ASSERT(gn_storage_set(key, blob, blob_len) == GN_RET_OK);
+	free(blob);
+
+	_calibration_command("clear", "");
+	TEST_ASSERT(!gn_calibration_apply(level_calibration, "level", 1250, &value));
+
+}
+
+static bool _alarm_wait(bool expected) {
+
+	bool alarm = !expected;
+	int64_t deadline = esp_timer_get_time()
+			+ GN_SIM_TEST_FILTER_TIMEOUT_MS * 1000LL;
+	do {
+		vTaskDelay(10 / portTICK_PERIOD_MS);
+		gn_leaf_param_get_bool(filtered, "alarm", &alarm);
+	} while (alarm != expected && esp_timer_get_time() < deadline);
+	return alarm == expected;
+
+}
+
+void test_gn_sim_rules() {
+
+	//syntax, references and bounds are checked before storing the rules
+	const char *invalid[] = { "when level > then alarm = true",
+			"level > 1 then alarm = true", "when level > 1 alarm = true",
+			"when level > 1 then alarm", "when level > 1 then 3 = alarm",
+			"when (level > 1 then alarm = true", "when level # 1 then alarm = true",
+			"when level > 1 then alarm = true alarm = false",
+			"when 1+(1+(1+(1+(1+(1+(1+(1+(1+1)))))))) > 0 then alarm = true",
+			"when a.b.c > 1 then alarm = true" };
+	for (int i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++)
+		TEST_ASSERT(gn_leaf_param_force_string(filtered, GN_RULES_PARAM, (char* ) invalid[i]) == GN_RET_ERR_INVALID_ARG);
+
+	//loaded from the network, the third rule never resolves
+	const char *text =
+			"when level > limit then alarm = true;\n"
+			"when not (level > limit) && level >= 0 then alarm = false;\n"
+			"when nothere.temp > 1 then alarm = true";
+	char topic[128];
+#ifdef CONFIG_GROWNODE_MQTT_HOMIE_PROTOCOL
+	snprintf(topic, sizeof(topic), "homie/%s/filtered/rules/set", board->name);
+#else
+	snprintf(topic, sizeof(topic), "gn_sim/%s/filtered/rules/cmd", board->name);
+#endif
+	TEST_ASSERT(gn_sim_broker_publish(topic, text, strlen(text), 0, false) >= 0);
+
+	gn_rules_stats_t stats = { 0 };
+	int64_t deadline = esp_timer_get_time()
+			+ GN_SIM_TEST_FILTER_TIMEOUT_MS * 1000LL;
+	do {
+		vTaskDelay(10 / portTICK_PERIOD_MS);
+		gn_rules_get_stats(level_rules, &stats);
+	} while (stats.rules != 3 && esp_timer_get_time() < deadline);
+	TEST_ASSERT(stats.rules == 3 && stats.refs == 4);
+	TEST_ASSERT(stats.code_bytes > 0 && stats.code_bytes <= GN_RULES_CODE_SIZE);
+	TEST_ASSERT(stats.unresolved >= 1);
+
+	char stored[GN_RULES_TEXT_SIZE];
+	gn_leaf_param_get_string(filtered, GN_RULES_PARAM, stored, sizeof(stored));
+	TEST_ASSERT_EQUAL_STRING(text, stored);
+
+	//the rules follow the level
+	TEST_ASSERT(gn_leaf_param_force_double(filtered, "level", 30) == GN_RET_OK);
+	TEST_ASSERT(_alarm_wait(true));
+	TEST_ASSERT(gn_leaf_param_force_double(filtered, "level", 10) == GN_RET_OK);
+	TEST_ASSERT(_alarm_wait(false));
+	TEST_ASSERT(gn_leaf_param_force_double(filtered, "limit", 5) == GN_RET_OK);
+	TEST_ASSERT(_alarm_wait(true));
+
+	//a change nobody reads is not evaluated, a level change runs the two rules reading it
+	gn_rules_get_stats(level_rules, &stats);
+	uint32_t evaluations = stats.evaluations;
+	uint32_t actions = stats.actions;
+	TEST_ASSERT(gn_leaf_param_force_string(filtered, "level_cal", "") == GN_RET_OK);
+	TEST_ASSERT(gn_leaf_param_force_double(filtered, "level", 1) == GN_RET_OK);
+	TEST_ASSERT(_alarm_wait(false));
+	gn_rules_get_stats(level_rules, &stats);
+	TEST_ASSERT(stats.evaluations == evaluations + 2);
+	TEST_ASSERT(stats.actions == actions + 1);
+	TEST_ASSERT(stats.fired > 0 && stats.overruns == 0);
+	TEST_ASSERT(stats.max_us <= GN_RULES_BUDGET_US * 2);
+	ESP_LOGI(TAG, "rules: %d evaluations, %d fired, %d actions, busy %d us, max %d us",
+			(int ) stats.evaluations, (int ) stats.fired, (int ) stats.actions,
+			(int ) stats.busy_us, (int ) stats.max_us);
+
+	//no action when the target already has the value
+	TEST_ASSERT(gn_leaf_param_force_double(filtered, "level", 2) == GN_RET_OK);
+	vTaskDelay(50 / portTICK_PERIOD_MS);
+	gn_rules_get_stats(level_rules, &stats);
+	TEST_ASSERT(stats.evaluations == evaluations + 4);
+	TEST_ASSERT(stats.actions == actions + 1);
+
+	TEST_ASSERT(gn_rules_load(level_rules, "") == GN_RET_OK);
+
+}
+
+static gn_rules_handle_t stored_rules;
+
+//a leaf loading its rules from NVS at creation, with no rules given by the board
+static void _stored_rules_params(gn_leaf_handle_t leaf_config) {
+
+	gn_leaf_param_handle_t level = gn_leaf_param_create(leaf_config, "level",
+			GN_VAL_TYPE_DOUBLE, (gn_val_t ) { .d = 0 },
+			GN_LEAF_PARAM_ACCESS_NODE, GN_LEAF_PARAM_STORAGE_VOLATILE, NULL);
+	gn_leaf_param_add_to_leaf(leaf_config, level);
+	gn_leaf_param_handle_t alarm = gn_leaf_param_create(leaf_config, "alarm",
+			GN_VAL_TYPE_BOOLEAN, (gn_val_t ) { .b = false },
+			GN_LEAF_PARAM_ACCESS_NODE, GN_LEAF_PARAM_STORAGE_VOLATILE, NULL);
+	gn_leaf_param_add_to_leaf(leaf_config, alarm);
+	stored_rules = gn_rules_create(leaf_config, NULL);
+
+}
+
+void test_gn_sim_rules_storage() {
+
+	const char *text = "when level > 1 then alarm = true";
+
+	gn_leaf_handle_t leaf = _stored_leaf_boot("stored_rules",
+			_stored_rules_params);
+	TEST_ASSERT(leaf != NULL && stored_rules != NULL);
+	TEST_ASSERT(gn_leaf_param_force_string(leaf, GN_RULES_PARAM, (char* ) text) == GN_RET_OK);
+
+	//at the next boot the rules come from NVS
+	stored_rules = NULL;
+	leaf = _stored_leaf_boot("stored_rules", _stored_rules_params);
+	TEST_ASSERT(leaf != NULL && stored_rules != NULL);
+
+	char stored[GN_RULES_TEXT_SIZE];
+	TEST_ASSERT(gn_leaf_param_get_string(leaf, GN_RULES_PARAM, stored, sizeof(stored)) == GN_RET_OK);
+	TEST_ASSERT_EQUAL_STRING(text, stored);
+	gn_rules_stats_t stats = { 0 };
+	gn_rules_get_stats(stored_rules, &stats);
+	TEST_ASSERT(stats.rules == 1 && stats.unresolved == 0);
+
+}
+
+static void _scheduler_count(void *arg) {
+	(*(volatile int*) arg)++;
+}
+
+static void _scheduler_block(void *arg) {
+	vTaskDelay(300 / portTICK_PERIOD_MS);
+	(*(volatile int*) arg)++;
+}
+
+static void _scheduler_timer_fired(void *arg) {
+	*(volatile int64_t*) arg = esp_timer_get_time();
+}
+
+void test_gn_sim_scheduler() {
+
+	//calendar jobs in local time, 2022-01-01 00:00 UTC is a saturday
+	const time_t saturday = 1640995200;
+	time_t next;
+	char tz[64];
+	snprintf(tz, sizeof(tz), "%s", getenv("TZ") ? getenv("TZ") : "");
+
+	setenv("TZ", "UTC0", 1);
+	tzset();
+	TEST_ASSERT(gn_scheduler_next_time("30 7 * * 1-5", saturday, &next) == GN_RET_OK);
+	TEST_ASSERT(next == saturday + 2 * 86400 + 7 * 3600 + 30 * 60);
+	TEST_ASSERT(gn_scheduler_next_time("*/15 * * * *", saturday + 7 * 60, &next) == GN_RET_OK);
+	TEST_ASSERT(next == saturday + 15 * 60);
+	//day of month or day of week
+	TEST_ASSERT(gn_scheduler_next_time("0 0 13 * 5", saturday, &next) == GN_RET_OK);
+	TEST_ASSERT(next == saturday + 6 * 86400);
+	TEST_ASSERT(gn_scheduler_next_time("0 12 29 2 *", saturday, &next) == GN_RET_OK);
+	TEST_ASSERT(next == 1709208000);
+	TEST_ASSERT(gn_scheduler_next_time("@daily", saturday, &next) == GN_RET_OK);
+	TEST_ASSERT(next == saturday + 86400);
+	TEST_ASSERT(gn_scheduler_next_time("@every 1h", saturday + 10, &next) == GN_RET_OK);
+	TEST_ASSERT(next == saturday + 3600);
+
+	setenv("TZ", "CET-1CEST,M3.5.0,M10.5.0/3", 1);
+	tzset();
+	TEST_ASSERT(gn_scheduler_next_time("30 7 * * 1-5", saturday, &next) == GN_RET_OK);
+	TEST_ASSERT(next == saturday + 2 * 86400 + 6 * 3600 + 30 * 60);
+	//2:30 does not exist on 2022-03-27
+	TEST_ASSERT(gn_scheduler_next_time("30 2 * * *", 1648258200, &next) == GN_RET_OK);
+	TEST_ASSERT(next == 1648427400);
+
+	if (tz[0])
+		setenv("TZ", tz, 1);
+	else
+		unsetenv("TZ");
+	tzset();
+
+	const char *invalid[] = { "61 * * * *", "* * * *", "* * * * * *",
+			"1-70 * * * *", "*/0 * * * *", "5-1 * * * *", "* * 0 * *", "@every",
+			"@every 0s", "@every 5x", "@often", "@after 1h 2h" };
+	for (int i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++)
+		TEST_ASSERT(!gn_scheduler_spec_validate(invalid[i]));
+
+	//a single task serves the jobs in due order
+	static volatile int every_runs = 0, after_runs = 0;
+	gn_scheduler_job_handle_t every, after;
+	gn_scheduler_job_config_t every_config = { .callback = _scheduler_count,
+			.arg = (void*) &every_runs, .name = "every" };
+	gn_scheduler_job_config_t after_config = { .callback = _scheduler_count,
+			.arg = (void*) &after_runs, .name = "after" };
+	TEST_ASSERT(gn_scheduler_job_create(&every_config, &every) == GN_RET_OK);
+	TEST_ASSERT(gn_scheduler_job_create(&after_config, &after) == GN_RET_OK);
+	TEST_ASSERT(gn_scheduler_job_start(after, "bad") == GN_RET_ERR_INVALID_ARG);
+	TEST_ASSERT(gn_scheduler_job_start(every, "@every 100ms") == GN_RET_OK);
+	TEST_ASSERT(gn_scheduler_job_start(after, "@after 250ms") == GN_RET_OK);
+
+	//a sleeping node wakes up for the earliest job
+	TEST_ASSERT(gn_scheduler_sleep_millisec(60000) <= 100);
+	TEST_ASSERT(gn_scheduler_sleep_millisec(0) <= 100);
+	//0 would not arm the wake up timer, a due job still sleeps 1 ms
+	TEST_ASSERT(gn_scheduler_sleep_millisec(0) > 0);
+
+	vTaskDelay(1000 / portTICK_PERIOD_MS);
+	TEST_ASSERT(gn_scheduler_job_stop(every) == GN_RET_OK);
+
+	gn_scheduler_job_info_t info;
+	TEST_ASSERT(gn_scheduler_job_get_info(every, &info) == GN_RET_OK);
+	ESP_LOGI(TAG, "scheduler: %d runs, late max %lld us", (int ) info.runs,
+			info.late_max_us);
+	TEST_ASSERT(every_runs == info.runs && info.runs >= 8 && info.runs <= 11);
+	TEST_ASSERT(!info.started && info.late_max_us < 50000);
+	TEST_ASSERT(gn_scheduler_job_get_info(after, &info) == GN_RET_OK);
+	TEST_ASSERT(after_runs == 1 && info.runs == 1 && !info.started);
+	TEST_ASSERT(gn_scheduler_sleep_millisec(1000) == 1000);
+
+	TEST_ASSERT(gn_scheduler_job_delete(every) == GN_RET_OK);
+	TEST_ASSERT(gn_scheduler_job_delete(after) == GN_RET_OK);
+	TEST_ASSERT(gn_scheduler_job_start(every, "@every 1s") == GN_RET_ERR_INVALID_ARG);
+
+	//a blocking job does not delay the esp_timer callbacks
+	static volatile int block_runs = 0;
+	static volatile int64_t fired_us = 0;
+	gn_scheduler_job_handle_t block;
+	gn_scheduler_job_config_t block_config = { .callback = _scheduler_block,
+			.arg = (void*) &block_runs, .name = "block" };
+	const esp_timer_create_args_t probe_args = { .callback =
+			_scheduler_timer_fired, .arg = (void*) &fired_us, .name = "probe" };
+	esp_timer_handle_t probe;
+	TEST_ASSERT(esp_timer_create(&probe_args, &probe) == ESP_OK);
+	TEST_ASSERT(gn_scheduler_job_create(&block_config, &block) == GN_RET_OK);
+	int64_t start = esp_timer_get_time();
+	TEST_ASSERT(gn_scheduler_job_start(block, "@after 10ms") == GN_RET_OK);
+	TEST_ASSERT(esp_timer_start_once(probe, 100000) == ESP_OK);
+	vTaskDelay(500 / portTICK_PERIOD_MS);
+	TEST_ASSERT(block_runs == 1);
+	TEST_ASSERT(fired_us > 0 && fired_us - start < 200000);
+	esp_timer_delete(probe);
+	TEST_ASSERT(gn_scheduler_job_delete(block) == GN_RET_OK);
+
+	//the scheduler leaf takes its jobs from the network
+	const char *invalid_jobs[] = { "@after 1s filtered.alarm",
+			"@after 1s alarm=true", "@sometimes filtered.alarm=true",
+			"0 7 * * filtered.alarm=true", "filtered.alarm=true" };
+	for (int i = 0; i < sizeof(invalid_jobs) / sizeof(invalid_jobs[0]); i++)
+		TEST_ASSERT(gn_leaf_param_force_string(scheduler, GN_LEAF_SCHEDULER_PARAM_JOBS, (char* ) invalid_jobs[i]) == GN_RET_ERR_INVALID_ARG);
+
+	TEST_ASSERT(gn_leaf_param_force_bool(filtered, "alarm", false) == GN_RET_OK);
+	const char *jobs = "@after 100ms filtered.alarm=true;\n0 7 * * * filtered.limit=30";
+	char topic[128];
+#ifdef CONFIG_GROWNODE_MQTT_HOMIE_PROTOCOL
+	snprintf(topic, sizeof(topic), "homie/%s/sched/jobs/set", board->name);
+#else
+	snprintf(topic, sizeof(topic), "gn_sim/%s/sched/jobs/cmd", board->name);
+#endif
+	TEST_ASSERT(gn_sim_broker_publish(topic, jobs, strlen(jobs), 0, false) >= 0);
+	TEST_ASSERT(_alarm_wait(true));
+
+	char stored[GN_LEAF_DATA_SIZE];
+	gn_leaf_param_get_string(scheduler, GN_LEAF_SCHEDULER_PARAM_JOBS, stored,
+			sizeof(stored));
+	TEST_ASSERT_EQUAL_STRING(jobs, stored);
+
+	const char *repeating = "@every 100ms filtered.alarm=true";
+	TEST_ASSERT(gn_leaf_param_set_string(scheduler, GN_LEAF_SCHEDULER_PARAM_JOBS, (char* ) repeating) == GN_RET_OK);
+	int64_t deadline = esp_timer_get_time()
+			+ GN_SIM_TEST_FILTER_TIMEOUT_MS * 1000LL;
+	do {
+		vTaskDelay(10 / portTICK_PERIOD_MS);
+		gn_leaf_param_get_string(scheduler, GN_LEAF_SCHEDULER_PARAM_JOBS,
+				stored, sizeof(stored));
+	} while (strcmp(stored, repeating) != 0 && esp_timer_get_time() < deadline);
+	TEST_ASSERT_EQUAL_STRING(repeating, stored);
+
+	TEST_ASSERT(gn_leaf_param_set_string(scheduler, GN_LEAF_SCHEDULER_PARAM_JOBS, "") == GN_RET_OK);
+	deadline = esp_timer_get_time() + GN_SIM_TEST_FILTER_TIMEOUT_MS * 1000LL;
+	do {
+		vTaskDelay(10 / portTICK_PERIOD_MS);
+		gn_leaf_param_get_string(scheduler, GN_LEAF_SCHEDULER_PARAM_JOBS,
+				stored, sizeof(stored));
+	} while (stored[0] && esp_timer_get_time() < deadline);
+	TEST_ASSERT(stored[0] == '\0');
+
+	//a cleared leaf runs no more jobs
+	vTaskDelay(50 / portTICK_PERIOD_MS);
+	TEST_ASSERT(gn_leaf_param_force_bool(filtered, "alarm", false) == GN_RET_OK);
+	vTaskDelay(300 / portTICK_PERIOD_MS);
+	bool alarm = true;
+	gn_leaf_param_get_bool(filtered, "alarm", &alarm);
+	TEST_ASSERT(!alarm);
+
+}
+
+//widgets of the display binding test, rendered as text and value
+typedef struct {
+	int applied;
+	char text[GN_DISPLAY_BINDING_TEXT_SIZE];
+	int32_t value;
+} _test_widget_t;
+
+static void _test_widget_apply(const gn_display_binding_update_t *update) {
+	_test_widget_t *w = (_test_widget_t*) update->widget;
+	w->applied++;
+	strncpy(w->text, update->text, sizeof(w->text) - 1);
+	w->value = update->value;
+}
+
+void test_gn_sim_display_binding() {
+
+	static _test_widget_t limit_label, limit_bar, alarm_label;
+	gn_display_binding_config_t label_config = { .kind =
+			GN_DISPLAY_BINDING_LABEL, .widget = &limit_label, .format = "%.1f" };
+	gn_display_binding_config_t bar_config = { .kind = GN_DISPLAY_BINDING_BAR,
+			.widget = &limit_bar, .min = 0, .max = 50 };
+	gn_display_binding_config_t alarm_config = { .kind =
+			GN_DISPLAY_BINDING_LABEL, .widget = &alarm_label };
+
+	TEST_ASSERT(gn_display_bind(filtered, "nothing", &label_config) == GN_RET_ERR_INVALID_ARG);
+	bar_config.max = 0;
+	TEST_ASSERT(gn_display_bind(filtered, "limit", &bar_config) == GN_RET_ERR_INVALID_ARG);
+	bar_config.max = 50;
+
+	TEST_ASSERT(gn_leaf_param_force_double(filtered, "limit", 5) == GN_RET_OK);
+	TEST_ASSERT(gn_leaf_param_force_bool(filtered, "alarm", false) == GN_RET_OK);
+	vTaskDelay(50 / portTICK_PERIOD_MS);
+
+	//new bindings are rendered at the next frame
+	TEST_ASSERT(gn_display_bind(filtered, "limit", &label_config) == GN_RET_OK);
+	TEST_ASSERT(gn_display_bind(filtered, "limit", &bar_config) == GN_RET_OK);
+	TEST_ASSERT(gn_display_bind(filtered, "alarm", &alarm_config) == GN_RET_OK);
+	TEST_ASSERT(gn_display_binding_wait(0));
+	TEST_ASSERT(gn_display_binding_flush(_test_widget_apply) == 3);
+	TEST_ASSERT_EQUAL_STRING("5.0", limit_label.text);
+	TEST_ASSERT(limit_bar.value == 10);
+	TEST_ASSERT_EQUAL_STRING("off", alarm_label.text);
+
+	//nothing changed, the GUI task sleeps until its deadline
+	TEST_ASSERT(!gn_display_binding_wait(0));
+	TEST_ASSERT(gn_display_binding_flush(_test_widget_apply) == 0);
+	TEST_ASSERT(gn_leaf_param_force_double(filtered, "level", 3) == GN_RET_OK);
+	TEST_ASSERT(!gn_display_binding_wait(100));
+
+	//changes between two frames are applied once, with the latest value
+	int64_t start = esp_timer_get_time();
+	TEST_ASSERT(gn_leaf_param_force_double(filtered, "limit", 10) == GN_RET_OK);
+	TEST_ASSERT(gn_display_binding_wait(1000));
+	int64_t wake_us = esp_timer_get_time() - start;
+	TEST_ASSERT(gn_leaf_param_force_double(filtered, "limit", 20) == GN_RET_OK);
+	TEST_ASSERT(gn_leaf_param_force_double(filtered, "limit", 80) == GN_RET_OK);
+	vTaskDelay(50 / portTICK_PERIOD_MS);
+	int label_applied = limit_label.applied, bar_applied = limit_bar.applied;
+	gn_display_binding_flush(_test_widget_apply);
+	ESP_LOGI(TAG, "display binding: woken after %lld us", wake_us);
+	TEST_ASSERT(limit_label.applied == label_applied + 1);
+	TEST_ASSERT(limit_bar.applied == bar_applied + 1);
+	TEST_ASSERT_EQUAL_STRING("80.0", limit_label.text);
+	TEST_ASSERT(limit_bar.value == 100);
+	TEST_ASSERT(alarm_label.applied == 1);
+
+	//unbound widgets are left alone
+	TEST_ASSERT(gn_display_unbind(&limit_bar) == GN_RET_OK);
+	TEST_ASSERT(gn_display_unbind(&limit_bar) == GN_RET_ERR_INVALID_ARG);
+	TEST_ASSERT(gn_leaf_param_force_double(filtered, "limit", 5) == GN_RET_OK);
+	TEST_ASSERT(gn_display_binding_wait(1000));
+	vTaskDelay(50 / portTICK_PERIOD_MS);
+	TEST_ASSERT(gn_display_binding_flush(_test_widget_apply) == 1);
+	TEST_ASSERT(limit_bar.value == 100);
+	TEST_ASSERT_EQUAL_STRING("5.0", limit_label.text);
+
+	gn_display_unbind(&limit_label);
+	gn_display_unbind(&alarm_label);
+
+}
+
+//synthetic application image: instructions drawn from a small set, as compressible as code
+//ends with the SHA-256 of the rest, as the application images built by IDF
+static uint8_t* _test_ota_image(size_t len, uint32_t seed) {
+
+	uint8_t *image = malloc(len);
+	TEST_ASSERT(image);
+	uint32_t x = seed;
+	for (size_t i = 0; i < len - GN_OTA_SHA256_SIZE; i += 4) {
+		x = x * 1103515245 + 12345;
+		uint32_t word = ((x >> 16) % 61) * 0x9E3779B1u;
+		memcpy(image + i, &word,
+				len - GN_OTA_SHA256_SIZE - i < 4 ? len - GN_OTA_SHA256_SIZE - i : 4);
+	}
+	mbedtls_sha256_ret(image, len - GN_OTA_SHA256_SIZE,
+			image + len - GN_OTA_SHA256_SIZE, 0);
+	return image;
+
+}
+
+static void _test_ota_check(const uint8_t *image, size_t len) {
+	size_t written = 0;
+	const uint8_t *update = gn_sim_ota_get_update(&written);
+	TEST_ASSERT(update);
+	TEST_ASSERT(written == len);
+	TEST_ASSERT(memcmp(update, image, len) == 0);
+	TEST_ASSERT(gn_sim_ota_boot_set());
+}
+
+void test_gn_sim_ota() {
+
+	const size_t len = GN_SIM_TEST_OTA_IMAGE_SIZE;
+	uint8_t *running = _test_ota_image(len, 1);
+
+	//the new release: code moved by an insertion, a patched table and a longer tail
+	size_t new_len = len + 3 * 1024;
+	uint8_t *image = malloc(new_len);
+	TEST_ASSERT(image);
+	memcpy(image, running, 50 * 1024);
+	uint8_t *added = _test_ota_image(1024, 2);
+	memcpy(image + 50 * 1024, added, 1024);
+	memcpy(image + 51 * 1024, running + 50 * 1024, len - 50 * 1024);
+	memset(image + 120 * 1024, 0x5A, 200);
+	memcpy(image + len + 1024, added, 1024);
+	memset(image + len + 2 * 1024, 0, 1024);
+
+	uint8_t *full = NULL, *delta = NULL, *other = NULL;
+	size_t full_len = 0, delta_len = 0, other_len = 0;
+	TEST_ASSERT(gn_ota_pack(image, new_len, NULL, 0, true, &full, &full_len) == 0);
+	TEST_ASSERT(gn_ota_pack(image, new_len, running, len, true, &delta, &delta_len) == 0);
+	//built against another release
+	TEST_ASSERT(gn_ota_pack(image, new_len, added, 1024, false, &other, &other_len) == 0);
+	//the node identifies its firmware by the appended digest, a source without it is refused
+	uint8_t *refused = NULL;
+	size_t refused_len = 0;
+	TEST_ASSERT(gn_ota_pack(image, new_len, image, new_len, false, &refused, &refused_len) == -1);
+	TEST_ASSERT(refused == NULL);
+
+	//plain image, written as is
+	gn_sim_ota_set_running(running, len);
+	gn_sim_http_serve(GN_SIM_TEST_OTA_URL, image, new_len);
+	TEST_ASSERT(gn_ota_update(GN_SIM_TEST_OTA_URL, NULL) == GN_RET_OK);
+	_test_ota_check(image, new_len);
+	size_t plain_served = gn_sim_http_served();
+	TEST_ASSERT(plain_served == new_len);
+
+	//compressed full image
+	gn_sim_ota_set_running(running, len);
+	gn_sim_http_serve(GN_SIM_TEST_OTA_URL, full, full_len);
+	TEST_ASSERT(gn_ota_update(GN_SIM_TEST_OTA_URL, NULL) == GN_RET_OK);
+	_test_ota_check(image, new_len);
+	size_t full_served = gn_sim_http_served();
+
+	//delta against the running image, with bounded RAM
+	gn_sim_ota_set_running(running, len);
+	gn_sim_http_serve(GN_SIM_TEST_OTA_URL, delta, delta_len);
+	size_t before = gn_sim_heap_used();
+	gn_sim_heap_reset_peak();
+	TEST_ASSERT(gn_ota_update(GN_SIM_TEST_OTA_URL, NULL) == GN_RET_OK);
+	size_t peak = gn_sim_heap_peak() - before;
+	_test_ota_check(image, new_len);
+	size_t delta_served = gn_sim_http_served();
+
+	ESP_LOGI(TAG, "ota: plain %d bytes, compressed %d bytes, delta %d bytes, peak heap %d bytes",
+			(int) plain_served, (int) full_served, (int) delta_served, (int) peak);
+	TEST_ASSERT(full_served < plain_served);
+	TEST_ASSERT(delta_served < plain_served / 10);
+	TEST_ASSERT(peak < GN_SIM_TEST_OTA_HEAP_MAX);
+
+	//a delta for another firmware is refused before writing
+	gn_sim_ota_set_running(running, len);
+	gn_sim_http_serve(GN_SIM_TEST_OTA_URL, other, other_len);
+	TEST_ASSERT(gn_ota_update(GN_SIM_TEST_OTA_URL, NULL) == GN_RET_ERR_INVALID_ARG);
+	TEST_ASSERT(!gn_sim_ota_get_update(NULL));
+	TEST_ASSERT(!gn_sim_ota_boot_set());
+
+	//a corrupted download does not become the boot image
+	full[full_len / 2] ^= 0x01;
+	gn_sim_http_serve(GN_SIM_TEST_OTA_URL, full, full_len);
+	TEST_ASSERT(gn_ota_update(GN_SIM_TEST_OTA_URL, NULL) != GN_RET_OK);
+	TEST_ASSERT(!gn_sim_ota_get_update(NULL));
+	TEST_ASSERT(!gn_sim_ota_boot_set());
+
+	//nothing served there
+	TEST_ASSERT(gn_ota_update("https://updates.local/none.bin", NULL) == GN_RET_ERR);
+
+	gn_sim_http_serve(GN_SIM_TEST_OTA_URL, NULL, 0);
+	gn_sim_ota_set_running(NULL, 0);
+	free(running);
+	free(image);
+	free(added);
+	free(full);
+	free(delta);
+	free(other);
+
+}
+
+void test_gn_sim_ota_resume() {
+
+	const size_t len = GN_SIM_TEST_OTA_IMAGE_SIZE;
+	uint8_t *running = _test_ota_image(len, 1);
+	uint8_t *image = _test_ota_image(len, 3);
+	uint8_t *full = NULL;
+	size_t full_len = 0;
+	TEST_ASSERT(gn_ota_pack(image, len, NULL, 0, true, &full, &full_len) == 0);
+
+	//drops during the download are resumed from the byte reached
+	gn_sim_ota_set_running(running, len);
+	gn_sim_http_serve(GN_SIM_TEST_OTA_URL, full, full_len);
+	gn_sim_http_drop(20000, CONFIG_GROWNODE_OTA_RETRIES);
+	TEST_ASSERT(gn_ota_update(GN_SIM_TEST_OTA_URL, NULL) == GN_RET_OK);
+	_test_ota_check(image, len);
+	TEST_ASSERT(gn_sim_http_served() == full_len);
+
+	//too many drops: the update fails, and the next one resumes from the last checkpoint
+	gn_sim_ota_set_running(running, len);
+	gn_sim_http_serve(GN_SIM_TEST_OTA_URL, full, full_len);
+	gn_sim_http_drop(15000, CONFIG_GROWNODE_OTA_RETRIES + 1);
+	TEST_ASSERT(gn_ota_update(GN_SIM_TEST_OTA_URL, NULL) == GN_RET_ERR);
+	TEST_ASSERT(!gn_sim_ota_boot_set());
+	size_t first = gn_sim_http_served();
+	gn_sim_http_serve(GN_SIM_TEST_OTA_URL, full, full_len);
+	TEST_ASSERT(gn_ota_update(GN_SIM_TEST_OTA_URL, NULL) == GN_RET_OK);
+	_test_ota_check(image, len);
+	size_t second = gn_sim_http_served();
+	ESP_LOGI(TAG, "ota resume: %d bytes before the failure, %d bytes after, container %d bytes",
+			(int) first, (int) second, (int) full_len);
+	//checkpoints are at block boundaries of the compressed image
+	TEST_ASSERT(first + second < full_len + GN_OTA_BLOCK_SIZE);
+	TEST_ASSERT(second < full_len - CONFIG_GROWNODE_OTA_CHECKPOINT_KB * 1024);
+
+	//uncompressed images resume from the exact byte, servers without ranges are skipped through
+	gn_sim_ota_set_running(running, len);
+	gn_sim_http_serve(GN_SIM_TEST_OTA_URL, image, len);
+	gn_sim_http_drop(50000, CONFIG_GROWNODE_OTA_RETRIES + 1);
+	TEST_ASSERT(gn_ota_update(GN_SIM_TEST_OTA_URL, NULL) == GN_RET_ERR);
+	gn_sim_http_serve(GN_SIM_TEST_OTA_URL, image, len);
+	TEST_ASSERT(gn_ota_update(GN_SIM_TEST_OTA_URL, NULL) == GN_RET_OK);
+	_test_ota_check(image, len);
+	TEST_ASSERT(gn_sim_http_served() == len - 50000 * (CONFIG_GROWNODE_OTA_RETRIES + 1));
+
+	gn_sim_ota_set_running(running, len);
+	gn_sim_http_drop(50000, CONFIG_GROWNODE_OTA_RETRIES + 1);
+	TEST_ASSERT(gn_ota_update(GN_SIM_TEST_OTA_URL, NULL) == GN_RET_ERR);
+	gn_sim_http_set_ranges(false);
+	TEST_ASSERT(gn_ota_update(GN_SIM_TEST_OTA_URL, NULL) == GN_RET_OK);
+	_test_ota_check(image, len);
+	gn_sim_http_set_ranges(true);
+
+	//a file replaced on the server is downloaded again, not appended to the checkpoint
+	uint8_t *replaced = _test_ota_image(len, 4);
+	gn_sim_ota_set_running(running, len);
+	gn_sim_http_serve(GN_SIM_TEST_OTA_URL, image, len);
+	gn_sim_http_drop(50000, CONFIG_GROWNODE_OTA_RETRIES + 1);
+	TEST_ASSERT(gn_ota_update(GN_SIM_TEST_OTA_URL, NULL) == GN_RET_ERR);
+	gn_sim_http_serve(GN_SIM_TEST_OTA_URL, replaced, len);
+	TEST_ASSERT(gn_ota_update(GN_SIM_TEST_OTA_URL, NULL) == GN_RET_OK);
+	_test_ota_check(replaced, len);
+	TEST_ASSERT(gn_sim_http_served() == len);
+	gn_sim_http_serve(GN_SIM_TEST_OTA_URL, image, len);
+	free(replaced);
+
+	//a checkpoint is only used for its url
+	gn_sim_ota_set_running(running, len);
+	gn_sim_http_drop(50000, CONFIG_GROWNODE_OTA_RETRIES + 1);
+	TEST_ASSERT(gn_ota_update(GN_SIM_TEST_OTA_URL, NULL) == GN_RET_ERR);
+	gn_sim_http_serve(GN_SIM_TEST_OTA_URL "?v=2", full, full_len);
+	TEST_ASSERT(gn_ota_update(GN_SIM_TEST_OTA_URL "?v=2", NULL) == GN_RET_OK);
+	_test_ota_check(image, len);
+	TEST_ASSERT(gn_sim_http_served() == full_len);
+
+	//a checkpoint shorter than expected, as from another firmware, is ignored
+	gn_sim_ota_set_running(running, len);
+	gn_sim_http_drop(15000, CONFIG_GROWNODE_OTA_RETRIES + 1);
+	TEST_ASSERT(gn_ota_update(GN_SIM_TEST_OTA_URL "?v=2", NULL) == GN_RET_ERR);
+	uint8_t *checkpoint = NULL;
+	size_t checkpoint_len = 0;
+	TEST_ASSERT(gn_storage_get_blob("gn_ota_checkpoint", (void**) &checkpoint, &checkpoint_len) == GN_RET_NVS_PARAMETER_FOUND);
+	TEST_ASSERT(gn_storage_set("gn_ota_checkpoint", checkpoint, checkpoint_len - 4) == GN_RET_OK);
+	free(checkpoint);
+	gn_sim_http_serve(GN_SIM_TEST_OTA_URL "?v=2", full, full_len);
+	TEST_ASSERT(gn_ota_update(GN_SIM_TEST_OTA_URL "?v=2", NULL) == GN_RET_OK);
+	_test_ota_check(image, len);
+	TEST_ASSERT(gn_sim_http_served() == full_len);
+
+	gn_sim_http_serve(GN_SIM_TEST_OTA_URL, NULL, 0);
+	gn_sim_http_serve(GN_SIM_TEST_OTA_URL "?v=2", NULL, 0);
+	gn_sim_ota_set_running(NULL, 0);
+	free(running);
+	free(image);
+	free(full);
+
+}
+
+//a persisted string parameter, the default is a literal as in the bundled leaves
+static void _stored_text_params(gn_leaf_handle_t leaf_config) {
+
+	gn_leaf_param_handle_t text = gn_leaf_param_create(leaf_config, "text",
+			GN_VAL_TYPE_STRING, (gn_val_t ) { .s = "" },
+			GN_LEAF_PARAM_ACCESS_ALL, GN_LEAF_PARAM_STORAGE_PERSISTED, NULL);
+	gn_leaf_param_add_to_leaf(leaf_config, text);
+
+}
+
+void test_gn_sim_param_storage() {
+
+	char text[64];
+
+	gn_leaf_handle_t leaf = _stored_leaf_boot("stored", _stored_text_params);
+	TEST_ASSERT(leaf != NULL);
+	TEST_ASSERT(gn_leaf_param_get_string(leaf, "text", text, sizeof(text)) == GN_RET_OK);
+	TEST_ASSERT_EQUAL_STRING("", text);
+	gn_leaf_param_force_string(leaf, "text", "stored value");
+
+	//as at the next boot: the stored value replaces the default, which is not freed
+	leaf = _stored_leaf_boot("stored", _stored_text_params);
+	TEST_ASSERT(leaf != NULL);
+	TEST_ASSERT(gn_leaf_param_get_string(leaf, "text", text, sizeof(text)) == GN_RET_OK);
+	TEST_ASSERT_EQUAL_STRING("stored value", text);
+
+	//the board initial value does not override it
+	TEST_ASSERT(gn_leaf_param_init_string(leaf, "text", "initial") == GN_RET_OK);
+	TEST_ASSERT(gn_leaf_param_get_string(leaf, "text", text, sizeof(text)) == GN_RET_OK);
+	TEST_ASSERT_EQUAL_STRING("stored value", text);
+
+}
+
+void test_gn_sim_memory() {
+
+	int64_t latency_us;
+
+	//first run warms up lazily allocated buffers
+	TEST_ASSERT(_send_command(true, &latency_us));
+	TEST_ASSERT(_send_command(false, &latency_us));
+
+	size_t before = gn_sim_heap_used();
+	gn_sim_heap_reset_peak();
+
+	int executed = 0;
+	while (executed < GN_SIM_TEST_COMMANDS
+			&& _send_command(executed % 2 == 0, &latency_us))
+		executed++;
+	TEST_ASSERT(executed == GN_SIM_TEST_COMMANDS);
+
+	size_t after = gn_sim_heap_used();
+
+	ESP_LOGI(TAG, "heap %s: used %d bytes, peak %d bytes, growth %d bytes",
+			board->name, (int) after, (int) gn_sim_heap_peak(),
+			(int) (after - before));
+
+	TEST_ASSERT(after < before + GN_SIM_TEST_HEAP_GROWTH_MAX);
+
+}
+
+//a light sleep cycle of the node, as after a power on or a deep sleep wake up
+static void _sleep_cycle(esp_reset_reason_t reason, gn_sim_broker_stats_t *stats) {
+
+	gn_sim_set_reset_reason(reason);
+	gn_sim_broker_reset_stats();
+	TEST_ASSERT(gn_node_sleep(node, GN_SLEEP_MODE_LIGHT, 0, 50) == GN_RET_OK);
+	TEST_ASSERT(gn_get_status(config) == GN_NODE_STATUS_STARTED);
+	gn_sim_broker_get_stats(stats);
+
+}
+
+void test_gn_sim_persistent_session() {
+
+	int64_t latency_us;
+	gn_sim_broker_stats_t stats;
+
+	//a power on does not trust the session: the commands are subscribed again, per leaf as the broker refuses wildcards
+	gn_sim_broker_set_deny_wildcards(true);
+	_sleep_cycle(ESP_RST_POWERON, &stats);
+	gn_sim_broker_set_deny_wildcards(false);
+#ifdef CONFIG_GROWNODE_MQTT_WILDCARD_SUBSCRIPTION
+	TEST_ASSERT(stats.refused > 0);
+	TEST_ASSERT(stats.subscribed > 0);
+#endif
+	TEST_ASSERT(_send_command(true, &latency_us));
+
+	//on wake up the session kept by the broker is used as it is, wildcards are not added to it
+	_sleep_cycle(ESP_RST_DEEPSLEEP, &stats);
+	TEST_ASSERT_EQUAL(0, stats.subscribed);
+	TEST_ASSERT_EQUAL(0, stats.refused);
+	gn_sim_broker_reset_stats();
+	TEST_ASSERT(_send_command(false, &latency_us));
+	gn_sim_broker_get_stats(&stats);
+	TEST_ASSERT_EQUAL(1, stats.delivered);
+
+	//back to the subscriptions of the other tests
+	_sleep_cycle(ESP_RST_POWERON, &stats);
+	TEST_ASSERT(_send_command(true, &latency_us));
+	TEST_ASSERT(_send_command(false, &latency_us));
+
+}
+
+int main(int argc, char **argv) {
+
+	const char *name = argc > 1 ? argv[1] : _boards[0].name;
+	for (int i = 0; i < sizeof(_boards) / sizeof(_boards[0]); i++) {
+		if (strcmp(_boards[i].name, name) == 0)
+			board = &_boards[i];
+	}
+
+	if (!board) {
+		ESP_LOGE(TAG, "unknown board %s", name);
+		return 1;
+	}
+
+	gpio_changed = xSemaphoreCreateCounting(64, 0);
+	gn_sim_set_actuator_cb(_actuator_cb, NULL);
+
+	//two probes on the bus of the board temperature leaf, seen at the first scan
+	gn_sim_ds18x20_set(board->temp_gpio, 0, 21.3);
+	gn_sim_ds18x20_set(board->temp_gpio, 1, 18.0);
+
+#ifdef CONFIG_GROWNODE_BOOT_PROFILE
+	boot_subscription = gn_sim_broker_subscribe("#", _boot_observer_cb, NULL);
+#endif
+
+	UNITY_BEGIN();
+
+	ESP_LOGI(TAG, "----- HOST SIMULATION %s START ------", board->name);
+
+	ESP_LOGI(TAG, " * * * * * test_gn_sim_node_start");
+	RUN_TEST(test_gn_sim_node_start);
+#ifdef CONFIG_GROWNODE_BOOT_PROFILE
+	ESP_LOGI(TAG, " * * * * * test_gn_sim_boot_profile");
+	RUN_TEST(test_gn_sim_boot_profile);
+#endif
+	ESP_LOGI(TAG, " * * * * * test_gn_sim_command_roundtrip");
+	RUN_TEST(test_gn_sim_command_roundtrip);
+	ESP_LOGI(TAG, " * * * * * test_gn_sim_command_throughput");
+	RUN_TEST(test_gn_sim_command_throughput);
+#ifdef CONFIG_GROWNODE_LATENCY_TRACE
+	ESP_LOGI(TAG, " * * * * * test_gn_sim_command_latency");
+	RUN_TEST(test_gn_sim_command_latency);
+#endif
+#ifdef CONFIG_GROWNODE_RUNTIME_STATS
+	ESP_LOGI(TAG, " * * * * * test_gn_sim_runtime_stats");
+	RUN_TEST(test_gn_sim_runtime_stats);
+#endif
+#ifdef CONFIG_GROWNODE_MEM_ACCOUNTING
+	ESP_LOGI(TAG, " * * * * * test_gn_sim_mem_accounting");
+	RUN_TEST(test_gn_sim_mem_accounting);
+#endif
+#ifdef CONFIG_GROWNODE_ADC_SAMPLING
+	ESP_LOGI(TAG, " * * * * * test_gn_sim_adc_sampling");
+	RUN_TEST(test_gn_sim_adc_sampling);
+#endif
+	ESP_LOGI(TAG, " * * * * * test_gn_sim_exporter");
+	RUN_TEST(test_gn_sim_exporter);
+	ESP_LOGI(TAG, " * * * * * test_gn_sim_ds18b20");
+	RUN_TEST(test_gn_sim_ds18b20);
+	ESP_LOGI(TAG, " * * * * * test_gn_sim_sampler");
+	RUN_TEST(test_gn_sim_sampler);
+	ESP_LOGI(TAG, " * * * * * test_gn_sim_i2c");
+	RUN_TEST(test_gn_sim_i2c);
+	ESP_LOGI(TAG, " * * * * * test_gn_sim_ina219");
+	RUN_TEST(test_gn_sim_ina219);
+	ESP_LOGI(TAG, " * * * * * test_gn_sim_filter");
+	RUN_TEST(test_gn_sim_filter);
+	ESP_LOGI(TAG, " * * * * * test_gn_sim_calibration");
+	RUN_TEST(test_gn_sim_calibration);
+	ESP_LOGI(TAG, " * * * * * test_gn_sim_rules");
+	RUN_TEST(test_gn_sim_rules);
+	ESP_LOGI(TAG, " * * * * * test_gn_sim_rules_storage");
+	RUN_TEST(test_gn_sim_rules_storage);
+	ESP_LOGI(TAG, " * * * * * test_gn_sim_scheduler");
+	RUN_TEST(test_gn_sim_scheduler);
+	ESP_LOGI(TAG, " * * * * * test_gn_sim_display_binding");
+	RUN_TEST(test_gn_sim_display_binding);
+	ESP_LOGI(TAG, " * * * * * test_gn_sim_ota");
+	RUN_TEST(test_gn_sim_ota);
+	ESP_LOGI(TAG, " * * * * * test_gn_sim_ota_resume");
+	RUN_TEST(test_gn_sim_ota_resume);
+	ESP_LOGI(TAG, " * * * * * test_gn_sim_param_storage");
+	RUN_TEST(test_gn_sim_param_storage);
+	ESP_LOGI(TAG, " * * * * * test_gn_sim_memory");
+	RUN_TEST(test_gn_sim_memory);
+	ESP_LOGI(TAG, " * * * * * test_gn_sim_persistent_session");
+	RUN_TEST(test_gn_sim_persistent_session);
+
+	ESP_LOGI(TAG, "------ HOST SIMULATION %s END -------", board->name);
+
+	int failures = UNITY_END();
+
+	//leaves tasks never return, the process ends here
+	return failures;
+
+}